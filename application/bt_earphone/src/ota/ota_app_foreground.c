@@ -21,6 +21,9 @@
 #include <ota_upgrade.h>
 #include <ota_backend.h>
 #include <ota_backend_bt.h>
+#ifdef CONFIG_OTA_BACKEND_DELTA
+#include <ota_backend_delta.h>
+#endif
 #include <config.h>
 #include <drivers/nvram_config.h>
 #include <user_comm/sys_comm.h>
@@ -319,6 +322,11 @@ int ota_app_init_bluetooth(void)
 		SYS_LOG_INF("failed");
 		return -ENODEV;
 	}
+
+#ifdef CONFIG_OTA_BACKEND_DELTA
+	/* attach delta backend by the notify of bt backend */
+	ota_backend_delta_init(backend_bt);
+#endif
 	
 	// bt_manager_tws_register_long_message_cb(tws_long_data_cb);
 	return 0;
@@ -357,6 +365,11 @@ int ota_app_init_slave_bluetooth(void)
 		return -ENODEV;
 	}
 
+#ifdef CONFIG_OTA_BACKEND_DELTA
+	/* attach delta backend by the notify of bt backend */
+	ota_backend_delta_init(backend_bt);
+#endif
+
 	return 0;
 }
 #endif
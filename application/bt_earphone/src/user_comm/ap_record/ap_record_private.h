@@ -31,6 +31,9 @@
 #include <stdio.h>
 #include <string.h>
 #include <stream.h>
+#ifdef CONFIG_CLONE_STREAM
+#include <clone_stream.h>
+#endif
 
 #ifdef CONFIG_DVFS
 #include <dvfs.h>
@@ -58,6 +61,11 @@ struct record_app_t {
 	u32_t sppble_stream_opened : 1;
 	io_stream_t record_upload_stream;
 	record_stream_init_param user_param;
+#ifdef CONFIG_CLONE_STREAM
+	/* view of record_upload_stream the upload data is sent from */
+	int upload_view;
+	struct thread_timer upload_timer;
+#endif
 };
 
 io_stream_t record_upload_stream_create(void *param);
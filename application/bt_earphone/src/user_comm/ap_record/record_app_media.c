@@ -29,16 +29,73 @@
 #include "media_mem.h"
 
 #define RECORD_SAMPLE_RATE_KH 16
+
+#ifdef CONFIG_CLONE_STREAM
+/* 1s of 32kbps opus, a multiple of the 40 and 80 bytes frames */
+#define RECORD_UPLOAD_BUF_SIZE		4000
+#define RECORD_UPLOAD_PERIOD_MS		20
+
+/* send the captured data in place from the view, off the capture thread */
+static void _record_upload_data(struct record_app_t *record_app)
+{
+	struct acts_ringbuf_iovec iov[2];
+	int len, i;
+
+	len = clone_stream_view_claim(record_app->record_upload_stream,
+			record_app->upload_view, iov, RECORD_UPLOAD_BUF_SIZE);
+	if (len == -EPIPE) {
+		SYS_LOG_WRN("upload lags, skip to latest\n");
+		clone_stream_view_reset(record_app->record_upload_stream, record_app->upload_view);
+		return;
+	}
+
+	if (len <= 0)
+		return;
+
+	/* frames never straddle the wrap as the buffer is a multiple of them */
+	for (i = 0; i < ARRAY_SIZE(iov); i++) {
+		if (iov[i].len > 0)
+			record_app->user_param.stream_send_cb(iov[i].base, iov[i].len, FALSE);
+	}
+
+	if (clone_stream_view_release(record_app->record_upload_stream,
+			record_app->upload_view, len) == -EPIPE)
+		SYS_LOG_ERR("%d bytes overwritten while sending\n", len);
+}
+
+static void _record_upload_timer_handler(struct thread_timer *ttimer, void *expiry_fn_arg)
+{
+	_record_upload_data(expiry_fn_arg);
+}
+#endif /* CONFIG_CLONE_STREAM */
+
 static io_stream_t _record_create_uploadstream(record_stream_init_param *user_param)
 {
 	int ret = 0;
 	io_stream_t upload_stream = NULL;
+#ifdef CONFIG_CLONE_STREAM
+	struct clone_stream_info clone_info;
+#endif
 
 	upload_stream = record_upload_stream_create(user_param);
 	if (!upload_stream) {
 		goto exit;
 	}
 
+#ifdef CONFIG_CLONE_STREAM
+	/* upload data is published to the views of a clone stream */
+	memset(&clone_info, 0, sizeof(clone_info));
+	clone_info.origin = upload_stream;
+	clone_info.clone_mode = MODE_OUT;
+	clone_info.view_buf_size = RECORD_UPLOAD_BUF_SIZE;
+
+	upload_stream = clone_stream_create(&clone_info);
+	if (!upload_stream) {
+		stream_destroy(clone_info.origin);
+		goto exit;
+	}
+#endif
+
 	ret = stream_open(upload_stream, MODE_IN_OUT);
 	if (ret) {
 		stream_destroy(upload_stream);
@@ -101,6 +158,14 @@ void record_start_record(record_stream_init_param *rec_param)
 		goto err_exit;
 	}
 
+#ifdef CONFIG_CLONE_STREAM
+	record_app->upload_view = clone_stream_view_open(upload_stream, 0, CLONE_STREAM_LAG_STOP);
+	if (record_app->upload_view < 0) {
+		SYS_LOG_ERR("view open failed\n");
+		goto err_exit;
+	}
+#endif
+
 	init_param.type = MEDIA_SRV_TYPE_CAPTURE;
 	init_param.stream_type = AUDIO_STREAM_ASR;
     init_param.efx_stream_type = AUDIO_STREAM_DEFAULT;
@@ -129,6 +194,10 @@ void record_start_record(record_stream_init_param *rec_param)
 
 	media_player_play(record_app->player);
 	memcpy (&record_app->user_param, rec_param, sizeof(record_stream_init_param));
+#ifdef CONFIG_CLONE_STREAM
+	thread_timer_init(&record_app->upload_timer, _record_upload_timer_handler, record_app);
+	thread_timer_start(&record_app->upload_timer, RECORD_UPLOAD_PERIOD_MS, RECORD_UPLOAD_PERIOD_MS);
+#endif
 	SYS_LOG_INF("sucessed %p ", record_app->player);
 	record_app->media_opened = TRUE;
 
@@ -166,6 +235,14 @@ void record_stop_record(void)
 
 	record_app->media_opened = FALSE;
 
+#ifdef CONFIG_CLONE_STREAM
+	thread_timer_stop(&record_app->upload_timer);
+	if (record_app->record_upload_stream) {
+		_record_upload_data(record_app);
+		clone_stream_view_close(record_app->record_upload_stream, record_app->upload_view);
+	}
+#endif
+
 	if (record_app->record_upload_stream)
 		stream_close(record_app->record_upload_stream);
 
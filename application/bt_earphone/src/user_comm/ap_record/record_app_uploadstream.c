@@ -69,7 +69,10 @@ int record_upload_write(io_stream_t handle, unsigned char *buf,int data_size)
 		return 0;
 	}
 	//print_hex("d1:",buf,16);
+#ifndef CONFIG_CLONE_STREAM
+	/* otherwise sent by the record app from the view of the clone stream */
 	info->stream_send_cb(buf, data_size, FALSE);
+#endif
 
 	return data_size;
 }
@@ -24,10 +24,16 @@
 #define RINGBUFFER_STREAM_IMAG_NUM 0x55
 //#define DEBUG_DATA
 
-/* cace info ,used for cache stream */
+/*
+ * cace info ,used for cache stream
+ *
+ * the capture path is the only writer and the usb isr (or the clean
+ * timer while upload is stopped) the only reader, so the cache is a
+ * spsc ring buffer and needs no lock.
+ */
 typedef struct
 {
-	struct acts_ringbuf *cache_buff;
+	struct acts_ringbuf_spsc *cache_buff;
 } usb_audio_info_t;
 
 #ifdef DEBUG_DATA
@@ -36,6 +42,13 @@ io_stream_t debug_file_stream = NULL;
 
 io_stream_t usb_audio_upload_stream = NULL;
 
+/*
+ * only one upload stream exists at a time, its cache is a static object
+ * so that head and tail keep the cache line alignment of the struct,
+ * which mem_malloc does not guarantee.
+ */
+static struct acts_ringbuf_spsc usb_audio_cache_buff;
+
 int usb_audio_stream_open(io_stream_t handle, stream_mode mode)
 {
 	usb_audio_info_t *info = (usb_audio_info_t *)handle->data;
@@ -55,7 +68,7 @@ static int usb_audio_stream_get_length(io_stream_t handle)
 	if (!info)
 		return -EACCES;
 
-	return acts_ringbuf_length(info->cache_buff);
+	return acts_ringbuf_spsc_length(info->cache_buff);
 }
 
 static int usb_audio_stream_get_space(io_stream_t handle)
@@ -65,7 +78,7 @@ static int usb_audio_stream_get_space(io_stream_t handle)
 	if (!info)
 		return -EACCES;
 
-	return acts_ringbuf_space(info->cache_buff);
+	return acts_ringbuf_spsc_space(info->cache_buff);
 }
 
 int usb_audio_stream_write(io_stream_t handle, unsigned char *buf,int len)
@@ -76,7 +89,7 @@ int usb_audio_stream_write(io_stream_t handle, unsigned char *buf,int len)
 	if(!info)
 		return -EACCES;
 
- 	ret = acts_ringbuf_put(info->cache_buff, buf, len);
+ 	ret = acts_ringbuf_spsc_put(info->cache_buff, buf, len);
 
 	if (ret != len) {
 		SYS_LOG_WRN("want write %d bytes ,but only write %d bytes \n",len,ret);
@@ -97,7 +110,7 @@ int usb_audio_stream_read(io_stream_t handle, unsigned char *buf,int len)
 	if(!info)
 		return -EACCES;
 
- 	ret = acts_ringbuf_get(info->cache_buff, buf, len);
+ 	ret = acts_ringbuf_spsc_get(info->cache_buff, buf, len);
 #ifdef CONFIG_UP_LOAD_ENERGY_DETECT
     g_energy_level = audio_track_energy_value((short*)buf, ret, CONFIG_USB_AUDIO_RESOLUTION);
 #endif
@@ -116,7 +129,7 @@ int usb_audio_stream_tell(io_stream_t handle)
 	if(!info)
 		return -EACCES;
 
-	return acts_ringbuf_space(info->cache_buff);
+	return acts_ringbuf_spsc_space(info->cache_buff);
 }
 
 int usb_audio_stream_close(io_stream_t handle)
@@ -146,7 +159,9 @@ int usb_audio_stream_flush(io_stream_t handle)
 	if (!info)
 		return -EACCES;
 
-	acts_ringbuf_drop_all(info->cache_buff);
+	/* called by the reader side only */
+	acts_ringbuf_spsc_get(info->cache_buff, NULL,
+			acts_ringbuf_spsc_length(info->cache_buff));
 
 	return res;
 }
@@ -164,10 +179,7 @@ int usb_audio_stream_destroy(io_stream_t handle)
 
 	usb_audio_upload_stream = NULL;
 
-	if (info->cache_buff) {
-		mem_free(info->cache_buff);
-		info->cache_buff = NULL;
-	}
+	info->cache_buff = NULL;
 
 	mem_free(info);
 	handle->data = NULL;
@@ -188,11 +200,7 @@ int usb_audio_stream_init(io_stream_t handle, void *param)
 		return -ENOMEM;
 	}
 
-	info->cache_buff = mem_malloc(sizeof(struct acts_ringbuf));
-	if (!info->cache_buff) {
-		res = -ENOMEM;
-		goto err_exit;
-	}
+	info->cache_buff = &usb_audio_cache_buff;
 #ifdef DEBUG_DATA
 	debug_file_stream = file_stream_create("SD:data.pcm");
 	if(!debug_file_stream) {
@@ -209,7 +217,7 @@ int usb_audio_stream_init(io_stream_t handle, void *param)
 	}
 #endif
 
-	acts_ringbuf_init(info->cache_buff,
+	acts_ringbuf_spsc_init(info->cache_buff,
 				media_mem_get_cache_pool(OUTPUT_CAPTURE, AUDIO_STREAM_USOUND),
 				media_mem_get_cache_pool_size(OUTPUT_CAPTURE, AUDIO_STREAM_USOUND));
 
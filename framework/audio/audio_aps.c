@@ -37,6 +37,17 @@
 
 static aps_monitor_info_t aps_monitor;
 
+#ifdef CONFIG_AUDIO_APS_PI_CONTROLLER
+/* ppm of the integer-N aps levels at 44.1k, see audio_aps_level_e */
+static const int16_t aps_pi_level_ppm[] = {
+	-2265, -1723, -862, -356, -23, 388, 721, 2175, 0,
+};
+
+/* ppm of the fractional-N aps levels, level 16 is 0 ppm */
+#define APS_PI_F_LEVEL_NUM	32
+static int16_t aps_pi_level_f_ppm[APS_PI_F_LEVEL_NUM];
+#endif
+
 aps_monitor_info_t *audio_aps_monitor_get_instance(void)
 {
 	return &aps_monitor;
@@ -149,6 +160,55 @@ static uint8_t _monitor_aout_rate_fine(aps_monitor_info_t *handle, int32_t pcm_t
 }
 #endif
 
+#ifdef CONFIG_AUDIO_APS_PI_CONTROLLER
+static void _monitor_aps_pi_init(aps_monitor_info_t *handle)
+{
+	const int16_t *level_ppm = aps_pi_level_ppm;
+	uint8_t zero_level = APS_LEVEL_0PPM;
+	int i;
+
+	if (handle->audiopll_mode == 2) {
+		for (i = 0; i < APS_PI_F_LEVEL_NUM; i++)
+			aps_pi_level_f_ppm[i] = (i - 16) * CONFIG_AUDIO_APS_PI_F_STEP_PPM;
+
+		level_ppm = aps_pi_level_f_ppm;
+		zero_level = APS_PI_LEVEL_NONE;
+	}
+
+	aps_pi_init(&handle->aps_pi, CONFIG_AUDIO_APS_PI_TAU_MS, level_ppm,
+			handle->aps_min_level, handle->aps_max_level, zero_level, handle->current_level);
+}
+
+static void _monitor_aps_pi(aps_monitor_info_t *handle, int32_t pcm_time)
+{
+	uint32_t target_us;
+	uint8_t level;
+
+	/* no water mark, no aps adjustment */
+	if (handle->aps_increase_water_mark == UINT32_MAX)
+		return;
+
+	/* same target as the fine and the water mark adjustments */
+	if (handle->need_aps_fine) {
+		target_us = handle->aps_increase_water_mark;
+	} else {
+		target_us = handle->aps_increase_water_mark -
+				(handle->aps_increase_water_mark - handle->aps_reduce_water_mark) / 2;
+	}
+
+	level = aps_pi_update(&handle->aps_pi, pcm_time - (int32_t)target_us, k_uptime_get_32());
+	if (level != APS_PI_LEVEL_NONE) {
+		uint8_t aps_mode = (handle->audiopll_mode == 2)? (APS_LEVEL_AUDIOPLL_F): (APS_LEVEL_AUDIOPLL);
+
+		SYS_LOG_DBG("pi adjust %d: %d, %d\n", level, pcm_time, handle->aps_pi.out_q8 >> 8);
+		handle->current_level = level;
+		handle->last_level = level;
+		handle->dest_level = level;
+		hal_aout_channel_set_aps(handle->audio_track->audio_handle, level, aps_mode);
+	}
+}
+#endif
+
 void audio_aps_monitor_normal(aps_monitor_info_t *handle, int stream_length_us, uint8_t aps_max_level, uint8_t aps_min_level, uint8_t aps_level)
 {
 	void *audio_handle = handle->audio_track->audio_handle;
@@ -160,6 +220,11 @@ void audio_aps_monitor_normal(aps_monitor_info_t *handle, int stream_length_us,
 		return;
 	}
 
+#ifdef CONFIG_AUDIO_APS_PI_CONTROLLER
+	_monitor_aps_pi(handle, stream_length_us);
+	return;
+#endif
+
 #ifdef CONFIG_AUDIO_APS_ADJUST_FINE
 	if(handle->need_aps_fine == 1) {
 		uint8_t ret = 0xFF;
@@ -544,6 +609,9 @@ void audio_aps_monitor_init(uint32_t format_and_audiopll_mode, void *tws_observe
 	handle->last_level = handle->current_level;
 	handle->dest_level = handle->current_level;
 
+#ifdef CONFIG_AUDIO_APS_PI_CONTROLLER
+	_monitor_aps_pi_init(handle);
+#endif
 }
 
 void audio_aps_notify_decode_err(uint16_t err_cnt)
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2016 Actions Semi Co., Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief audio aps drift controller.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "audio_aps_pi.h"
+
+/* longer gaps between samples are taken as this */
+#define APS_PI_MAX_DT_MS	1000
+
+static inline int32_t _aps_pi_level_q8(struct aps_pi_ctrl *ctrl, uint8_t level)
+{
+	return (int32_t)ctrl->level_ppm[level] << 8;
+}
+
+static inline int32_t _aps_pi_clamp(int32_t val, int32_t min, int32_t max)
+{
+	if (val < min)
+		return min;
+	if (val > max)
+		return max;
+	return val;
+}
+
+static inline int32_t _aps_pi_abs(int32_t val)
+{
+	return (val < 0) ? -val : val;
+}
+
+void aps_pi_init(struct aps_pi_ctrl *ctrl, int32_t tau_ms, const int16_t *level_ppm,
+		uint8_t min_level, uint8_t max_level, uint8_t zero_level, uint8_t level)
+{
+	memset(ctrl, 0, sizeof(*ctrl));
+	ctrl->level_ppm = level_ppm;
+	ctrl->min_level = min_level;
+	ctrl->max_level = max_level;
+	ctrl->zero_level = zero_level;
+	ctrl->level = level;
+	ctrl->tau_ms = (tau_ms > 0) ? tau_ms : 1;
+
+	ctrl->out_min_q8 = _aps_pi_level_q8(ctrl, min_level);
+	ctrl->out_max_q8 = _aps_pi_level_q8(ctrl, min_level);
+	for (int i = min_level; i <= max_level; i++) {
+		int32_t ppm_q8 = _aps_pi_level_q8(ctrl, i);
+
+		if (ppm_q8 < ctrl->out_min_q8)
+			ctrl->out_min_q8 = ppm_q8;
+		if (ppm_q8 > ctrl->out_max_q8)
+			ctrl->out_max_q8 = ppm_q8;
+	}
+}
+
+/*
+ * Pick the level nearest to the output, but only leave the current level
+ * once the output is nearer to the new one by half of their gap, so noise
+ * around the midpoint does not toggle the level.
+ */
+static uint8_t _aps_pi_select_level(struct aps_pi_ctrl *ctrl)
+{
+	int32_t cur_dist = _aps_pi_abs(_aps_pi_level_q8(ctrl, ctrl->level) - ctrl->out_q8);
+	int32_t best_dist = cur_dist;
+	uint8_t best = ctrl->level;
+	int32_t dist, gap;
+
+	for (int i = ctrl->min_level; i <= ctrl->max_level + 1; i++) {
+		uint8_t level = (i <= ctrl->max_level) ? i : ctrl->zero_level;
+
+		if (level == APS_PI_LEVEL_NONE)
+			continue;
+
+		dist = _aps_pi_abs(_aps_pi_level_q8(ctrl, level) - ctrl->out_q8);
+		if (dist < best_dist) {
+			best_dist = dist;
+			best = level;
+		}
+	}
+
+	if (best == ctrl->level)
+		return APS_PI_LEVEL_NONE;
+
+	gap = _aps_pi_abs(_aps_pi_level_q8(ctrl, best) - _aps_pi_level_q8(ctrl, ctrl->level));
+	if (cur_dist - best_dist <= gap / 2)
+		return APS_PI_LEVEL_NONE;
+
+	ctrl->level = best;
+	ctrl->level_changes++;
+	return best;
+}
+
+uint8_t aps_pi_update(struct aps_pi_ctrl *ctrl, int32_t err_us, uint32_t now_ms)
+{
+	int64_t tau = ctrl->tau_ms;
+	int32_t dt_ms, p_q8;
+
+	if (!ctrl->started) {
+		/* bumpless start from the current level */
+		ctrl->started = 1;
+		ctrl->err_q4 = err_us * 16;
+		ctrl->integ_q8 = _aps_pi_clamp(_aps_pi_level_q8(ctrl, ctrl->level),
+				ctrl->out_min_q8, ctrl->out_max_q8);
+		ctrl->out_q8 = ctrl->integ_q8;
+		ctrl->last_ms = now_ms;
+		return APS_PI_LEVEL_NONE;
+	}
+
+	dt_ms = (int32_t)(now_ms - ctrl->last_ms);
+	if (dt_ms <= 0)
+		return APS_PI_LEVEL_NONE;
+
+	ctrl->last_ms = now_ms;
+	if (dt_ms > APS_PI_MAX_DT_MS)
+		dt_ms = APS_PI_MAX_DT_MS;
+
+	/* low pass over tau / 4 against the jitter of packet arrival */
+	ctrl->err_q4 += (int32_t)(((int64_t)err_us * 16 - ctrl->err_q4) * dt_ms /
+			(tau / 4 + dt_ms));
+
+	/*
+	 * 1 ppm of drift moves the buffer by 1 us per second, so with the error
+	 * in us and time in ms: Kp = 1000 / tau ppm/us, Ki = Kp * Kp / 4, which
+	 * places both closed loop poles at -1 / (2 * tau).
+	 */
+	p_q8 = (int32_t)((int64_t)ctrl->err_q4 * 16000 / tau);
+	ctrl->integ_q8 += (int32_t)((int64_t)ctrl->err_q4 * dt_ms * 16000 / (4 * tau * tau));
+
+	/* anti windup: no integration beyond what the levels can output */
+	ctrl->integ_q8 = _aps_pi_clamp(ctrl->integ_q8, ctrl->out_min_q8, ctrl->out_max_q8);
+	ctrl->out_q8 = _aps_pi_clamp(p_q8 + ctrl->integ_q8, ctrl->out_min_q8, ctrl->out_max_q8);
+
+	return _aps_pi_select_level(ctrl);
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2016 Actions Semi Co., Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief audio aps drift controller.
+ *
+ * A PI loop on the filtered error of the pcm buffer length estimates the
+ * source/sink clock drift in ppm, which is then mapped to the nearest aps
+ * level with hysteresis. The gains are derived from one time constant tau,
+ * so that the loop is critically damped and settles within about 12 tau.
+*/
+
+#ifndef __AUDIO_APS_PI_H__
+#define __AUDIO_APS_PI_H__
+
+#include <stdint.h>
+
+#define APS_PI_LEVEL_NONE	(0xFF)
+
+struct aps_pi_ctrl {
+	/* ppm of each aps level, indexed by level */
+	const int16_t *level_ppm;
+	uint8_t min_level;
+	uint8_t max_level;
+	/* 0 ppm level out of min_level..max_level, or APS_PI_LEVEL_NONE */
+	uint8_t zero_level;
+	uint8_t level;
+
+	int32_t tau_ms;
+	/* filtered error in 1/16 us */
+	int32_t err_q4;
+	/* integral term and output in 1/256 ppm */
+	int32_t integ_q8;
+	int32_t out_q8;
+	/* ppm range of the usable levels in 1/256 ppm */
+	int32_t out_min_q8;
+	int32_t out_max_q8;
+	uint32_t last_ms;
+	uint8_t started;
+
+	uint32_t level_changes;
+};
+
+/**
+ * @brief init aps drift controller
+ *
+ * @param ctrl controller
+ * @param tau_ms time constant of the loop
+ * @param level_ppm ppm of each aps level, indexed by level
+ * @param min_level min aps level to use
+ * @param max_level max aps level to use
+ * @param zero_level extra 0 ppm level, or APS_PI_LEVEL_NONE
+ * @param level current aps level
+ */
+void aps_pi_init(struct aps_pi_ctrl *ctrl, int32_t tau_ms, const int16_t *level_ppm,
+		uint8_t min_level, uint8_t max_level, uint8_t zero_level, uint8_t level);
+
+/**
+ * @brief feed one buffer length sample
+ *
+ * @param ctrl controller
+ * @param err_us buffer length minus target length in us
+ * @param now_ms time of the sample
+ *
+ * @return the new aps level, or APS_PI_LEVEL_NONE if unchanged
+ */
+uint8_t aps_pi_update(struct aps_pi_ctrl *ctrl, int32_t err_us, uint32_t now_ms);
+
+#endif /* __AUDIO_APS_PI_H__ */
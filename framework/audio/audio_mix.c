@@ -0,0 +1,311 @@
+/*
+ * Copyright (c) 2016 Actions Semi Co., Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief audio pcm mix kernels.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include "audio_mix.h"
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include <arch/arm/aarch32/cortex_m/cmsis.h>
+#define AUDIO_MIX_SIMD 1
+#endif
+
+static inline int16_t _mix_sat16(int32_t val)
+{
+	if (val > INT16_MAX)
+		return INT16_MAX;
+	if (val < INT16_MIN)
+		return INT16_MIN;
+	return (int16_t)val;
+}
+
+static inline int32_t _mix_sat32(int64_t val)
+{
+	if (val > INT32_MAX)
+		return INT32_MAX;
+	if (val < INT32_MIN)
+		return INT32_MIN;
+	return (int32_t)val;
+}
+
+static inline int16_t _mix_s16(int16_t src, int16_t mix, int16_t main_gain, int16_t mix_gain)
+{
+	return _mix_sat16(((int32_t)src * main_gain + (int32_t)mix * mix_gain) >> 15);
+}
+
+static inline int32_t _mix_s32(int32_t src, int16_t mix, int16_t main_gain, int16_t mix_gain)
+{
+	return _mix_sat32(((int64_t)src * main_gain +
+			(int64_t)mix * mix_gain * 65536) >> 15);
+}
+
+static void _mix_s16_mono(void *dest, const void *src, int16_t *mix[2],
+		int samples, int16_t main_gain, int16_t mix_gain)
+{
+	int16_t *pdst = dest;
+	const int16_t *psrc = src;
+	const int16_t *pmix = mix[0];
+
+#ifdef AUDIO_MIX_SIMD
+	uint32_t gain = (uint16_t)main_gain | ((uint32_t)(uint16_t)mix_gain << 16);
+
+	for (; samples >= 2; samples -= 2) {
+		uint32_t s = __UNALIGNED_UINT32_READ(psrc);
+		uint32_t m = __UNALIGNED_UINT32_READ(pmix);
+		int32_t lo = __SSAT((int32_t)__SMUAD(__PKHBT(s, m, 16), gain) >> 15, 16);
+		int32_t hi = __SSAT((int32_t)__SMUAD(__PKHTB(m, s, 16), gain) >> 15, 16);
+
+		__UNALIGNED_UINT32_WRITE(pdst, __PKHBT(lo, hi, 16));
+		pdst += 2;
+		psrc += 2;
+		pmix += 2;
+	}
+#endif
+
+	while (samples-- > 0)
+		*pdst++ = _mix_s16(*psrc++, *pmix++, main_gain, mix_gain);
+}
+
+static void _mix_s16_stereo(void *dest, const void *src, int16_t *mix[2],
+		int samples, int16_t main_gain, int16_t mix_gain)
+{
+	int16_t *pdst = dest;
+	const int16_t *psrc = src;
+	int i;
+
+#ifdef AUDIO_MIX_SIMD
+	uint32_t gain = (uint16_t)main_gain | ((uint32_t)(uint16_t)mix_gain << 16);
+
+	for (i = 0; i < samples; i++) {
+		uint32_t s = __UNALIGNED_UINT32_READ(psrc);
+		int32_t l = __SSAT((int32_t)__SMUAD(__PKHBT(s, (uint16_t)mix[0][i], 16), gain) >> 15, 16);
+		int32_t r = __SSAT((int32_t)__SMUAD(__PKHTB((uint32_t)mix[1][i] << 16, s, 16), gain) >> 15, 16);
+
+		__UNALIGNED_UINT32_WRITE(pdst, __PKHBT(l, r, 16));
+		pdst += 2;
+		psrc += 2;
+	}
+#else
+	for (i = 0; i < samples; i++) {
+		*pdst++ = _mix_s16(*psrc++, mix[0][i], main_gain, mix_gain);
+		*pdst++ = _mix_s16(*psrc++, mix[1][i], main_gain, mix_gain);
+	}
+#endif
+}
+
+static void _mix_s16_mono_unity(void *dest, const void *src, int16_t *mix[2],
+		int samples, int16_t main_gain, int16_t mix_gain)
+{
+	int16_t *pdst = dest;
+	const int16_t *psrc = src;
+	const int16_t *pmix = mix[0];
+
+#ifdef AUDIO_MIX_SIMD
+	for (; samples >= 2; samples -= 2) {
+		__UNALIGNED_UINT32_WRITE(pdst, __QADD16(__UNALIGNED_UINT32_READ(psrc),
+				__UNALIGNED_UINT32_READ(pmix)));
+		pdst += 2;
+		psrc += 2;
+		pmix += 2;
+	}
+#endif
+
+	while (samples-- > 0)
+		*pdst++ = _mix_sat16((int32_t)*psrc++ + *pmix++);
+}
+
+static void _mix_s16_stereo_unity(void *dest, const void *src, int16_t *mix[2],
+		int samples, int16_t main_gain, int16_t mix_gain)
+{
+	int16_t *pdst = dest;
+	const int16_t *psrc = src;
+	int i;
+
+#ifdef AUDIO_MIX_SIMD
+	for (i = 0; i < samples; i++) {
+		uint32_t m = __PKHBT((uint16_t)mix[0][i], (uint32_t)mix[1][i], 16);
+
+		__UNALIGNED_UINT32_WRITE(pdst, __QADD16(__UNALIGNED_UINT32_READ(psrc), m));
+		pdst += 2;
+		psrc += 2;
+	}
+#else
+	for (i = 0; i < samples; i++) {
+		*pdst++ = _mix_sat16((int32_t)*psrc++ + mix[0][i]);
+		*pdst++ = _mix_sat16((int32_t)*psrc++ + mix[1][i]);
+	}
+#endif
+}
+
+static void _mix_s32_mono(void *dest, const void *src, int16_t *mix[2],
+		int samples, int16_t main_gain, int16_t mix_gain)
+{
+	int32_t *pdst = dest;
+	const int32_t *psrc = src;
+	const int16_t *pmix = mix[0];
+
+	while (samples-- > 0)
+		*pdst++ = _mix_s32(*psrc++, *pmix++, main_gain, mix_gain);
+}
+
+static void _mix_s32_stereo(void *dest, const void *src, int16_t *mix[2],
+		int samples, int16_t main_gain, int16_t mix_gain)
+{
+	int32_t *pdst = dest;
+	const int32_t *psrc = src;
+	int i;
+
+	for (i = 0; i < samples; i++) {
+		*pdst++ = _mix_s32(*psrc++, mix[0][i], main_gain, mix_gain);
+		*pdst++ = _mix_s32(*psrc++, mix[1][i], main_gain, mix_gain);
+	}
+}
+
+static inline int32_t _mix_s32_add(int32_t src, int16_t mix)
+{
+#ifdef AUDIO_MIX_SIMD
+	return __QADD(src, (int32_t)((uint32_t)(uint16_t)mix << 16));
+#else
+	return _mix_sat32((int64_t)src + (int64_t)mix * 65536);
+#endif
+}
+
+static void _mix_s32_mono_unity(void *dest, const void *src, int16_t *mix[2],
+		int samples, int16_t main_gain, int16_t mix_gain)
+{
+	int32_t *pdst = dest;
+	const int32_t *psrc = src;
+	const int16_t *pmix = mix[0];
+
+	while (samples-- > 0)
+		*pdst++ = _mix_s32_add(*psrc++, *pmix++);
+}
+
+static void _mix_s32_stereo_unity(void *dest, const void *src, int16_t *mix[2],
+		int samples, int16_t main_gain, int16_t mix_gain)
+{
+	int32_t *pdst = dest;
+	const int32_t *psrc = src;
+	int i;
+
+	for (i = 0; i < samples; i++) {
+		*pdst++ = _mix_s32_add(*psrc++, mix[0][i]);
+		*pdst++ = _mix_s32_add(*psrc++, mix[1][i]);
+	}
+}
+
+/*
+ * half gain kernels keep the rounding of the old halving mix, which is
+ * src / 2 + mix / 2 rounded toward zero, and can not saturate.
+ */
+#ifdef AUDIO_MIX_SIMD
+/* x / 2 of both half words, rounded toward zero */
+static inline uint32_t _mix_half16x2(uint32_t x)
+{
+	return __SHADD16(x, (x >> 15) & 0x00010001);
+}
+#endif
+
+static void _mix_s16_mono_half(void *dest, const void *src, int16_t *mix[2],
+		int samples, int16_t main_gain, int16_t mix_gain)
+{
+	int16_t *pdst = dest;
+	const int16_t *psrc = src;
+	const int16_t *pmix = mix[0];
+
+#ifdef AUDIO_MIX_SIMD
+	for (; samples >= 2; samples -= 2) {
+		__UNALIGNED_UINT32_WRITE(pdst, __SADD16(_mix_half16x2(__UNALIGNED_UINT32_READ(psrc)),
+				_mix_half16x2(__UNALIGNED_UINT32_READ(pmix))));
+		pdst += 2;
+		psrc += 2;
+		pmix += 2;
+	}
+#endif
+
+	while (samples-- > 0)
+		*pdst++ = *psrc++ / 2 + *pmix++ / 2;
+}
+
+static void _mix_s16_stereo_half(void *dest, const void *src, int16_t *mix[2],
+		int samples, int16_t main_gain, int16_t mix_gain)
+{
+	int16_t *pdst = dest;
+	const int16_t *psrc = src;
+	int i;
+
+#ifdef AUDIO_MIX_SIMD
+	for (i = 0; i < samples; i++) {
+		uint32_t m = __PKHBT((uint16_t)mix[0][i], (uint32_t)mix[1][i], 16);
+
+		__UNALIGNED_UINT32_WRITE(pdst, __SADD16(_mix_half16x2(__UNALIGNED_UINT32_READ(psrc)),
+				_mix_half16x2(m)));
+		pdst += 2;
+		psrc += 2;
+	}
+#else
+	for (i = 0; i < samples; i++) {
+		*pdst++ = *psrc++ / 2 + mix[0][i] / 2;
+		*pdst++ = *psrc++ / 2 + mix[1][i] / 2;
+	}
+#endif
+}
+
+static void _mix_s32_mono_half(void *dest, const void *src, int16_t *mix[2],
+		int samples, int16_t main_gain, int16_t mix_gain)
+{
+	int32_t *pdst = dest;
+	const int32_t *psrc = src;
+	const int16_t *pmix = mix[0];
+
+	while (samples-- > 0)
+		*pdst++ = *psrc++ / 2 + (int32_t)(*pmix++ / 2) * 65536;
+}
+
+static void _mix_s32_stereo_half(void *dest, const void *src, int16_t *mix[2],
+		int samples, int16_t main_gain, int16_t mix_gain)
+{
+	int32_t *pdst = dest;
+	const int32_t *psrc = src;
+	int i;
+
+	for (i = 0; i < samples; i++) {
+		*pdst++ = *psrc++ / 2 + (int32_t)(mix[0][i] / 2) * 65536;
+		*pdst++ = *psrc++ / 2 + (int32_t)(mix[1][i] / 2) * 65536;
+	}
+}
+
+audio_mix_func_t audio_mix_get_func(uint8_t sample_bits, uint8_t channels,
+		int16_t main_gain, int16_t mix_gain)
+{
+	/* [bits][channels][gain, unity, half] */
+	static const audio_mix_func_t mix_funcs[2][2][3] = {
+		{
+			{ _mix_s16_mono, _mix_s16_mono_unity, _mix_s16_mono_half, },
+			{ _mix_s16_stereo, _mix_s16_stereo_unity, _mix_s16_stereo_half, },
+		},
+		{
+			{ _mix_s32_mono, _mix_s32_mono_unity, _mix_s32_mono_half, },
+			{ _mix_s32_stereo, _mix_s32_stereo_unity, _mix_s32_stereo_half, },
+		},
+	};
+	int kind = 0;
+
+	if ((sample_bits != 16 && sample_bits != 32) || channels < 1 || channels > 2)
+		return NULL;
+
+	if (main_gain == AUDIO_MIX_GAIN_UNITY && mix_gain == AUDIO_MIX_GAIN_UNITY)
+		kind = 1;
+	else if (main_gain == AUDIO_MIX_GAIN_HALF && mix_gain == AUDIO_MIX_GAIN_HALF)
+		kind = 2;
+
+	return mix_funcs[sample_bits == 32][channels - 1][kind];
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2016 Actions Semi Co., Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief audio pcm mix kernels.
+*/
+
+#ifndef __AUDIO_MIX_H__
+#define __AUDIO_MIX_H__
+
+#include <stdint.h>
+
+/* Q15 gain of 0 dB, if both gains are unity the pcm is mixed by saturating add */
+#define AUDIO_MIX_GAIN_UNITY	(0x7FFF)
+
+/*
+ * Q15 gain of -6 dB, the level of the old halving mix. If both gains are
+ * half, the pcm is mixed as src / 2 + mix / 2 rounded toward zero, bit
+ * exact with the old mix.
+ */
+#define AUDIO_MIX_GAIN_HALF	(0x4000)
+
+/**
+ * @brief pcm mix kernel
+ *
+ * Mix the 16-bit planar mix data into the interleaved main pcm:
+ * dest = sat((src * main_gain + mix * mix_gain) >> 15). For 32-bit main
+ * pcm, the 16-bit mix data is aligned to the high half word first.
+ * Unity and half gains are mixed as described above.
+ * dest may be equal to src.
+ *
+ * @param dest interleaved output pcm
+ * @param src interleaved main pcm
+ * @param mix planar mix pcm, mix[1] is used by stereo kernels only
+ * @param samples samples per channel
+ * @param main_gain Q15 gain of main pcm
+ * @param mix_gain Q15 gain of mix pcm
+ */
+typedef void (*audio_mix_func_t)(void *dest, const void *src, int16_t *mix[2],
+		int samples, int16_t main_gain, int16_t mix_gain);
+
+/**
+ * @brief get pcm mix kernel
+ *
+ * The kernel is chosen once by format and gains, SIMD kernels are
+ * returned if the cpu supports DSP extension.
+ *
+ * @param sample_bits 16 or 32 bits main pcm
+ * @param channels channels of main pcm, 1 or 2
+ * @param main_gain Q15 gain of main pcm
+ * @param mix_gain Q15 gain of mix pcm
+ *
+ * @return mix kernel, or NULL if format not supported
+ */
+audio_mix_func_t audio_mix_get_func(uint8_t sample_bits, uint8_t channels,
+		int16_t main_gain, int16_t mix_gain);
+
+#endif /* __AUDIO_MIX_H__ */
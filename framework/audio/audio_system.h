@@ -12,6 +12,10 @@
 #ifndef __AUDIO_SYSTEM_H__
 #define __AUDIO_SYSTEM_H__
 #include <stream.h>
+#include "audio_mix.h"
+#ifdef CONFIG_AUDIO_APS_PI_CONTROLLER
+#include "audio_aps_pi.h"
+#endif
 
 /**
  * @defgroup audio_system_apis Auido System APIs
@@ -135,6 +139,13 @@ struct audio_track_t {
 
 	/* mix */
 	void *mix_handle;
+	audio_mix_func_t mix_func;
+	int16_t mix_main_gain;
+	int16_t mix_gain;
+	/* separate bytes: set by the mix stream writer, cleared by the track thread */
+	volatile uint8_t mix_observed;
+	volatile uint8_t mix_data_ready;
+	uint32_t mix_underrun_cnt;
 
     uint32_t samples_filled;
     uint32_t sdm_sample_rate;
@@ -305,6 +316,9 @@ typedef struct {
 	u8_t interval_count;   
 	uint32_t aps_fine_adjust_time;
 	uint32_t aps_water_adjust_last;
+#ifdef CONFIG_AUDIO_APS_PI_CONTROLLER
+	struct aps_pi_ctrl aps_pi;
+#endif
 
 	struct audio_track_t *audio_track;
 	void *tws_observer;
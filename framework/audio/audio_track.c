@@ -122,10 +122,114 @@ extern int media_mix_process(void *handle, void *inout_buf[2], void *mix_buf,
 #endif /* CONFIG_MEDIA_EFFECT */
 
 #ifdef CONFIG_MEDIA_EFFECT
+static const int16_t mix_silence_buf[64];
+
+static void _audio_track_mix_silence(struct audio_track_t *handle, s16_t *src_buff,
+		uint16_t samples, s16_t *dest_buff)
+{
+	int16_t *mix_buff[2] = { (int16_t *)mix_silence_buf, (int16_t *)mix_silence_buf, };
+
+	/* keep main track level unchanged while tip tone data is not ready */
+	while (samples > 0 && handle->mix_func) {
+		uint16_t mix_samples = MIN(samples, ARRAY_SIZE(mix_silence_buf));
+
+		handle->mix_func(dest_buff, src_buff, mix_buff, mix_samples,
+				handle->mix_main_gain, handle->mix_gain);
+		dest_buff = (s16_t *)((uint8_t *)dest_buff + mix_samples * handle->frame_size);
+		src_buff = (s16_t *)((uint8_t *)src_buff + mix_samples * handle->frame_size);
+		samples -= mix_samples;
+	}
+}
+
+static void _audio_track_mix_observer_notify(void *observer, int readoff, int writeoff, int total_size,
+										unsigned char *buf, int num, stream_notify_type type)
+{
+	struct audio_track_t *handle = (struct audio_track_t *)observer;
+
+	if (type == STREAM_NOTIFY_WRITE) {
+		handle->mix_data_ready = 1;
+	}
+}
+
+static void _audio_track_mix_buff(struct audio_track_t *handle, s16_t **src_buff,
+		s16_t **dest_buff, s16_t *mix_buff[2], uint16_t mix_samples)
+{
+	if (handle->mix_handle && *dest_buff == *src_buff) {
+#ifdef CONFIG_AUDIO_MIX
+		media_mix_process(handle->mix_handle, (void **)dest_buff, mix_buff[0], mix_samples);
+		*dest_buff += handle->channels * mix_samples;
+		*src_buff += handle->channels * mix_samples;
+#endif //CONFIG_AUDIO_MIX
+	} else if (handle->mix_func) {
+		handle->mix_func(*dest_buff, *src_buff, mix_buff, mix_samples,
+				handle->mix_main_gain, handle->mix_gain);
+		*dest_buff = (s16_t *)((uint8_t *)*dest_buff + mix_samples * handle->frame_size);
+		*src_buff = (s16_t *)((uint8_t *)*src_buff + mix_samples * handle->frame_size);
+	}
+}
+
+/*
+ * Mono tip tones of ring buffer streams are processed in place, saving
+ * the copy of stream_read_pcm: without resample they are mixed straight
+ * from the ring buffer, with resample the resampler reads its input frame
+ * from the ring buffer when the frame does not wrap.
+ *
+ * return samples mixed or read by the resampler, 0 if stream empty,
+ * -EPERM to fall back to stream_read_pcm.
+ */
+static int _audio_track_mix_claimed(struct audio_track_t *handle, s16_t **src_buff,
+		s16_t **dest_buff, uint16_t samples)
+{
+	struct acts_ringbuf_iovec iov[2];
+	s16_t *mix_buff[2];
+	int len, i;
+
+	if (handle->mix_channels != 1)
+		return -EPERM;
+
+	if (handle->res_handle) {
+#ifdef CONFIG_RESAMPLE
+		len = ringbuff_stream_read_claim(handle->mix_stream, iov, handle->res_in_samples * 2);
+		if (len <= 0)
+			return len;
+
+		/* short and wrapped frames are padded by the copy path */
+		if (iov[0].len < handle->res_in_samples * 2)
+			return -EPERM;
+
+		mix_buff[0] = mix_buff[1] = iov[0].base;
+		handle->res_out_samples = media_resample_process(handle->res_handle, 1,
+				(void **)handle->res_out_buf, (void **)mix_buff, handle->res_in_samples);
+		handle->res_remain_samples = handle->res_out_samples;
+
+		ringbuff_stream_read_finish(handle->mix_stream, len);
+		return handle->res_in_samples;
+#else
+		return -EPERM;
+#endif //CONFIG_RESAMPLE
+	}
+
+	len = ringbuff_stream_read_claim(handle->mix_stream, iov, samples * 2);
+	if (len <= 0)
+		return len;
+
+	/* a sample split by the wrap is joined by the copy path */
+	if (iov[0].len & 1)
+		return -EPERM;
+
+	len &= ~1;
+	for (i = 0; i < 2 && iov[i].len >= 2; i++) {
+		mix_buff[0] = mix_buff[1] = iov[i].base;
+		_audio_track_mix_buff(handle, src_buff, dest_buff, mix_buff, iov[i].len / 2);
+	}
+
+	ringbuff_stream_read_finish(handle->mix_stream, len);
+	return len / 2;
+}
+
 static int _audio_track_data_mix(struct audio_track_t *handle, s16_t *src_buff, uint16_t samples, s16_t *dest_buff)
 {
 	int ret = 0;
-    int max_retry_cnt = 5;
 	uint16_t mix_num = 0;
 	asin_pcm_t mix_pcm = {
 		.channels = handle->mix_channels,
@@ -144,40 +248,7 @@ static int _audio_track_data_mix(struct audio_track_t *handle, s16_t *src_buff,
 		};
 
 		/* 1) consume remain samples */
-		if (handle->mix_handle && dest_buff == src_buff) {
-#ifdef CONFIG_AUDIO_MIX
-			media_mix_process(handle->mix_handle, (void **)&dest_buff, mix_buff[0], mix_samples);
-			dest_buff += handle->channels * mix_samples;
-			src_buff += handle->channels * mix_samples;
-#endif //CONFIG_AUDIO_MIX
-		} else {
-            if(handle->audio_format == AUDIO_FORMAT_PCM_32_BIT) {
-                int32_t *pdst = (int32_t*)dest_buff;
-                int32_t *psrc = (int32_t*)src_buff;
-            
-                if (handle->channels > 1) {
-    				for (int i = 0; i < mix_samples; i++) {
-    					*pdst++ = (*psrc++) / 2 + (((int32_t)mix_buff[0][i] / 2) << 16);
-    					*pdst++ = (*psrc++) / 2 + (((int32_t)mix_buff[1][i] / 2) << 16);
-    				}
-    			} else {
-    				for (int i = 0; i < mix_samples; i++) {
-    					*pdst++ = (*psrc++) / 2 + (((int32_t)mix_buff[0][i] / 2) << 16);
-    				}
-                }
-            }else{
-                if (handle->channels > 1) {
-    				for (int i = 0; i < mix_samples; i++) {
-    					*dest_buff++ = (*src_buff++) / 2 + mix_buff[0][i] / 2;
-    					*dest_buff++ = (*src_buff++) / 2 + mix_buff[1][i] / 2;
-    				}
-    			} else {
-    				for (int i = 0; i < mix_samples; i++) {
-    					*dest_buff++ = (*src_buff++) / 2 + mix_buff[0][i] / 2;
-    				}
-    			}
-            }
-		}
+		_audio_track_mix_buff(handle, &src_buff, &dest_buff, mix_buff, mix_samples);
 
 		handle->res_remain_samples -= mix_samples;
 		samples -= mix_samples;
@@ -186,25 +257,41 @@ static int _audio_track_data_mix(struct audio_track_t *handle, s16_t *src_buff,
 			break;
 
 		/* 2) read mix stream and do resample as required */
-		mix_pcm.samples = 0;
-		ret = stream_read_pcm(&mix_pcm, handle->mix_stream, handle->res_in_samples, INT32_MAX);
-        //printk("mix read: %d, need: %d, have: %d\n", ret, handle->res_in_samples, stream_get_length(handle->mix_stream));
-		if (ret <= 0)
-		{
-            if(stream_check_finished(handle->mix_stream))
-                break;
-
-            max_retry_cnt--;
-            if(max_retry_cnt <= 0)
-            {
-                SYS_LOG_ERR("wait tip tone timeout\n");
-    			break;
-            }
-
-            os_sleep(2);
-            continue;
+		ret = 0;
+		if (!handle->mix_observed || handle->mix_data_ready) {
+			handle->mix_data_ready = 0;
+			ret = _audio_track_mix_claimed(handle, &src_buff, &dest_buff, samples);
+			if (ret > 0) {
+				handle->mix_data_ready = 1;
+				if (!handle->res_handle) {
+					samples -= ret;
+					mix_num += ret;
+					if (samples <= 0)
+						break;
+				}
+				continue;
+			}
+
+			if (ret < 0) {
+				mix_pcm.samples = 0;
+				ret = stream_read_pcm(&mix_pcm, handle->mix_stream, handle->res_in_samples, INT32_MAX);
+			}
 		}
 
+		if (ret <= 0) {
+			if (stream_check_finished(handle->mix_stream))
+				break;
+
+			/* never wait in output path, mix silence until writer notifies */
+			handle->mix_underrun_cnt++;
+			_audio_track_mix_silence(handle, src_buff, samples, dest_buff);
+			mix_num += samples;
+			break;
+		}
+
+		/* partial read may leave more data in stream */
+		handle->mix_data_ready = 1;
+
 		if (handle->res_handle) {
 #ifdef CONFIG_RESAMPLE
 			uint8_t res_channels = MIN(handle->mix_channels, handle->channels);
@@ -554,6 +641,8 @@ struct audio_track_t *audio_track_create(uint8_t stream_type, int sample_rate,
 	audio_track->sample_rate = sample_rate;
 	audio_track->compensate_samples = 0;
     audio_track->fade_mode = FADE_MODE_NONE;
+	audio_track->mix_main_gain = CONFIG_AUDIO_TRACK_MIX_MAIN_GAIN;
+	audio_track->mix_gain = CONFIG_AUDIO_TRACK_MIX_GAIN;
 
 	audio_track->channel_type = audio_policy_get_out_channel_type(stream_type);
 	audio_track->channel_id = audio_policy_get_out_channel_id(stream_type);
@@ -1103,6 +1192,13 @@ uint32_t audio_track_get_latency(struct audio_track_t *handle)
 #endif
 }
 
+uint32_t audio_track_get_mix_underrun_cnt(struct audio_track_t *handle)
+{
+	assert(handle);
+
+	return handle->mix_underrun_cnt;
+}
+
 uint32_t audio_track_get_play_sample_cnt(struct audio_track_t *handle)
 {
     return hal_aout_channel_get_sample_cnt(handle->audio_handle) / handle->channels;
@@ -1229,6 +1325,28 @@ int audio_track_set_mix_stream(struct audio_track_t *handle, io_stream_t mix_str
 			handle->mix_handle = media_mix_open(handle->sample_rate, handle->channels, 1);
 		}
 #endif //CONFIG_AUDIO_MIX
+
+		handle->mix_func = audio_mix_get_func(
+				(handle->audio_format == AUDIO_FORMAT_PCM_16_BIT) ? 16 : 32,
+				handle->channels, handle->mix_main_gain, handle->mix_gain);
+	}
+
+	if (handle->mix_stream && handle->mix_observed) {
+		stream_clear_observer(handle->mix_stream, handle);
+	}
+
+	handle->mix_observed = 0;
+	handle->mix_data_ready = 0;
+	if (mix_stream) {
+		handle->mix_underrun_cnt = 0;
+		/* without observer slot, fall back to polling the mix stream */
+		if (!stream_set_observer(mix_stream, handle,
+				_audio_track_mix_observer_notify, STREAM_NOTIFY_WRITE)) {
+			handle->mix_observed = 1;
+		}
+		handle->mix_data_ready = 1;
+	} else if (handle->mix_stream) {
+		SYS_LOG_INF("mix underrun %u\n", handle->mix_underrun_cnt);
 	}
 
 	handle->mix_stream = mix_stream;
@@ -1236,6 +1354,8 @@ int audio_track_set_mix_stream(struct audio_track_t *handle, io_stream_t mix_str
 	handle->mix_channels = channels;
 
 	if (!handle->mix_stream) {
+		handle->mix_func = NULL;
+
 #ifdef CONFIG_RESAMPLE
 		if (handle->res_handle) {
 			media_resample_close(handle->res_handle);
@@ -1262,6 +1382,31 @@ exit:
 #endif /* CONFIG_MEDIA_EFFECT */
 }
 
+int audio_track_set_mix_gain(struct audio_track_t *handle, int16_t main_gain, int16_t mix_gain)
+{
+#ifdef CONFIG_MEDIA_EFFECT
+	assert(handle);
+
+	if (main_gain < 0 || mix_gain < 0)
+		return -EINVAL;
+
+	audio_system_mutex_lock();
+
+	handle->mix_main_gain = main_gain;
+	handle->mix_gain = mix_gain;
+	if (handle->mix_stream) {
+		handle->mix_func = audio_mix_get_func(
+				(handle->audio_format == AUDIO_FORMAT_PCM_16_BIT) ? 16 : 32,
+				handle->channels, main_gain, mix_gain);
+	}
+
+	audio_system_mutex_unlock();
+	return 0;
+#else
+	return -ENOSYS;
+#endif /* CONFIG_MEDIA_EFFECT */
+}
+
 io_stream_t audio_track_get_mix_stream(struct audio_track_t *handle)
 {
 	assert(handle);
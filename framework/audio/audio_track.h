@@ -124,6 +124,7 @@ int audio_track_compensate_samples(struct audio_track_t *handle, int samples_cnt
 int audio_track_set_mix_stream(struct audio_track_t *handle, io_stream_t mix_stream,
 		uint8_t sample_rate, uint8_t channels, uint8_t stream_type);
 io_stream_t audio_track_get_mix_stream(struct audio_track_t *handle);
+int audio_track_set_mix_gain(struct audio_track_t *handle, int16_t main_gain, int16_t mix_gain);
 int audio_track_set_mute(struct audio_track_t *handle, bool mute);
 int audio_track_set_fade_out(struct audio_track_t *handle, int fade_time);
 int audio_track_set_fade_in(struct audio_track_t *handle, int fade_time);
@@ -227,6 +228,18 @@ int audio_track_is_muted(struct audio_track_t *handle);
  */
 uint32_t audio_track_get_latency(struct audio_track_t *handle);
 
+/**
+ * @brief get audio track mix underrun count
+ *
+ * This routine get how many times the mix stream had no data when the
+ * track needed it, silence is mixed in those periods.
+ *
+ * @param handle handle of Track
+ *
+ * @return mix underrun count since the mix stream was set
+ */
+uint32_t audio_track_get_mix_underrun_cnt(struct audio_track_t *handle);
+
 /**
  * @brief get DAC output sample count
  *
@@ -6,9 +6,24 @@
 
 /**
  * @file adaptive latency interface
+ * Hardware independent, all system services are reached by lcyapt->ops
  */
 
-#include "audiolcy_inner.h"
+#define SYS_LOG_NO_NEWLINE
+
+#ifdef  SYS_LOG_DOMAIN
+#undef  SYS_LOG_DOMAIN
+#endif
+#define SYS_LOG_DOMAIN "audio latency"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <mem_manager.h>
+#include <media_type.h>
+#include <btservice_api.h>
+#include <audio_system.h>
+#include "audiolcy_adaptive.h"
 
 
 #define LCYAPT_PKTINFO_NUM      (24)
@@ -90,6 +105,7 @@ typedef struct {
 
 typedef struct {
     audiolcy_common_t *lcycommon;   // shared info of audiolcy
+    const audiolcyapt_ops_t *ops;   // system services
 
     lcyapt_source_t source_info;    // source info for analysis
     lcyapt_result_t result_info;    // result info after analysis
@@ -349,7 +365,7 @@ void audiolcyapt_factor_statistics(audiolcy_adaptive_t *lcyapt, u16_t cur_factor
     u16_t ts_region_factor_delta, ts_region_factor_delta_square_avg, i;
     u32_t cur_timestamp, ts_region_factor_delta_square_weighting_total;
        
-    cur_timestamp = os_uptime_get_32();
+    cur_timestamp = lcyapt->ops->uptime_ms();
     if (p_out->factor_stat_flag == 0)
     {
         p_out->factor_stat_flag = 1;
@@ -432,7 +448,7 @@ static void audiolcyapt_info_analyse(audiolcy_adaptive_t *lcyapt, u8_t clear, u8
         temp_value = (temp_value  > 2) ? 2 : temp_value;
     }
 
-    cur_time_s = os_uptime_get_32() / 1000;
+    cur_time_s = lcyapt->ops->uptime_ms() / 1000;
     if (!force && cur_time_s < lcyapt->recommend_timer + temp_value) {
         return ;
     }
@@ -492,7 +508,7 @@ void audiolcyapt_info_collect(void *handle, audiolcy_pktinfo_t *pktinfo)
     if (p_in->last_pkt_time > 0)
     {
         p_in->frame_cnt[p_in->windex] = (lcyapt->lcycommon->media_format == SBC_TYPE) ? pktinfo->frame_cnt : 8;
-        p_in->time_span[p_in->windex] = k_cyc_to_us_floor32(pktinfo->sysclk_cyc - p_in->last_pkt_time);
+        p_in->time_span[p_in->windex] = lcyapt->ops->cyc_to_us(pktinfo->sysclk_cyc - p_in->last_pkt_time);
         temp_index = p_in->windex;
         p_in->windex = (p_in->windex + 1) % LCYAPT_PKTINFO_NUM;
         p_in->count++;
@@ -549,7 +565,7 @@ static u8_t audiolcyapt_latency_set(audiolcy_adaptive_t *lcyapt, u16_t ms, u8_t
         // staccato up adjust, clear all the down adjust timer
         audiolcyapt_down_timer_check(lcyapt, 0, 0);
 
-        cur_time = os_uptime_get_32();
+        cur_time = lcyapt->ops->uptime_ms();
 
         if ((lcyapt->scc_timer == 0) \
          || (cur_time > lcyapt->scc_timer + lcyapt->lcycommon->cfg->ALLM_scc_ignore_period_ms))
@@ -653,7 +669,7 @@ static u32_t audiolcyapt_staccato_timer_handle(audiolcy_adaptive_t *lcyapt)
         return 0;
     }
 
-    cur_time = os_uptime_get_32();
+    cur_time = lcyapt->ops->uptime_ms();
     if (cur_time > lcyapt->scc_timer + lcyapt->lcycommon->cfg->ALLM_scc_clear_period_s * 1000) {
     #if 1
         if (lcyapt->scc_imcrement > 0) {
@@ -681,7 +697,7 @@ static u32_t audiolcyapt_staccato_timer_handle(audiolcy_adaptive_t *lcyapt)
 static s32_t audiolcyapt_down_timer_update(audiolcy_adaptive_t *lcyapt, u16_t lcy)
 {
     u8_t  i = 0;
-    u32_t time_s = os_uptime_get_32() / 1000;
+    u32_t time_s = lcyapt->ops->uptime_ms() / 1000;
 
     for (i = 0; i < DOWN_TIMER_NUM; i++) {
         if (i > 0) {
@@ -817,7 +833,7 @@ static u32_t audiolcyapt_down_timer_handle(audiolcy_adaptive_t *lcyapt)
         return 1;
     }
 
-    cur_time = (u32_t)os_uptime_get_32() / 1000;  // unit second
+    cur_time = lcyapt->ops->uptime_ms() / 1000;  // unit second
 
     // timer[0] goes off, clear timer[0] and re-sort other timer(s)
     if (lcyapt->down_timer[0] + lcyapt->lcycommon->cfg->ALLM_down_timer_period_s <= cur_time) {
@@ -857,7 +873,7 @@ u32_t audiolcyapt_latency_adjust_slave(void *handle, u16_t lcy_ms, u8_t mode)
     }
 
     // set the new threshold
-    audiolcy_ctrl_latency_change(lcy_ms);
+    lcyapt->ops->latency_change(lcy_ms);
 
     printk("lcyapt adjust slave -> %d ms\n", lcy_ms);
 
@@ -871,7 +887,7 @@ u32_t audiolcyapt_latency_adjust(void *handle, u8_t adjust_en, u8_t sync_en)
     audiolcy_adaptive_t *lcyapt = (audiolcy_adaptive_t *)handle;
     audiolcy_common_t *lcycommon = lcyapt->lcycommon;
 
-    u16_t aps_curlcy = audio_aps_get_latency() / 1000; //us -> ms
+    u16_t aps_curlcy = lcyapt->ops->get_latency_us() / 1000; //us -> ms
     u16_t old_ms, new_ms = lcyapt->pending_lcy;
     u8_t  lcy_updated = 0, timer_update = 0, syncmode = 0;
 
@@ -894,7 +910,7 @@ u32_t audiolcyapt_latency_adjust(void *handle, u8_t adjust_en, u8_t sync_en)
     }
 
     old_ms = aps_curlcy;
-    if (audiolcy_get_latency_mode() != LCYMODE_ADAPTIVE) {
+    if (lcyapt->ops->get_latency_mode() != LCYMODE_ADAPTIVE) {
         old_ms = audiolcyapt_latency_get(lcyapt);
     }
 
@@ -913,13 +929,13 @@ u32_t audiolcyapt_latency_adjust(void *handle, u8_t adjust_en, u8_t sync_en)
     lcy_updated  = 1;  // global variable updated, sync to slave
     syncmode = LCYSYNC_UPDATE;
     // don't adjust in NLM or LLM
-    if (audiolcy_get_latency_mode() != LCYMODE_ADAPTIVE) {
+    if (lcyapt->ops->get_latency_mode() != LCYMODE_ADAPTIVE) {
         syncmode = LCYSYNC_SAVE;
         goto adjust_end;
     }
 
     // set the new threshold
-    audiolcy_ctrl_latency_change(new_ms);
+    lcyapt->ops->latency_change(new_ms);
 
     // enable quick aps, single device or master device
     // not supported yet
@@ -964,7 +980,7 @@ adjust_end:
 
     // TWS devices, send latency sync pkt to slave device
     if (lcy_updated > 0 && sync_en && lcycommon->twsrole == BTSRV_TWS_MASTER) {
-        audiolcy_ctrl_latency_twssync(syncmode, new_ms);
+        lcyapt->ops->latency_twssync(syncmode, new_ms);
     }
 
     return 0;
@@ -988,7 +1004,7 @@ void audiolcyapt_latency_calcation(audiolcy_adaptive_t *lcyapt, u8_t log_en, u8_
     us += p_out->pkt_time_ave / 2;
 
     // 2. fixed cost
-    audiolcy_ctrl_get_fixedcost(&samples);
+    lcyapt->ops->get_fixedcost(&samples);
 
     // 3. pattern factor recommend
     cur_result_factor = p_out->result_factor;
@@ -1002,7 +1018,7 @@ void audiolcyapt_latency_calcation(audiolcy_adaptive_t *lcyapt, u8_t log_en, u8_
 
     // convert to time in ms
     rem_lcy_ms = (us + 700) / 1000; //+700: rounding
-    sr_hz = audio_aps_get_samplerate_hz(lcyapt->lcycommon->sample_rate_khz == 48);
+    sr_hz = lcyapt->ops->get_samplerate_hz(lcyapt->lcycommon->sample_rate_khz == 48);
     rem_lcy_ms += (samples * 1000 / sr_hz);
 
     // recommemd a bigger lcy to avoid staccato in the beginning
@@ -1016,7 +1032,7 @@ void audiolcyapt_latency_calcation(audiolcy_adaptive_t *lcyapt, u8_t log_en, u8_
         }
     }
 
-    if (audiolcy_get_latency_mode() == LCYMODE_ADAPTIVE) {
+    if (lcyapt->ops->get_latency_mode() == LCYMODE_ADAPTIVE) {
         allm_lcy_ms = lcyapt->current_lcy;
     } else {
         // current is in NLM or LLM
@@ -1028,7 +1044,7 @@ void audiolcyapt_latency_calcation(audiolcy_adaptive_t *lcyapt, u8_t log_en, u8_
     }
 
     if (log_en) {
-        temp_value = audio_aps_get_latency() / 1000;  // current latency, us -> ms
+        temp_value = lcyapt->ops->get_latency_us() / 1000;  // current latency, us -> ms
         printk("lcyapt calc(%d): %d->%d, %dHz, %dtimer, %d_%d_%d, %d_%d\n", temp_value, allm_lcy_ms, rem_lcy_ms, \
             sr_hz, lcyapt->down_timer_num, p_out->result_factor, p_out->cbig_max, p_out->pkt_time_ave, \
             samples, p_out->factor_delta_square_weighting);
@@ -1104,7 +1120,7 @@ static u8_t audiolcyapt_lcy_check(audiolcy_adaptive_t *lcyapt)
             lcyapt->quick_count = 0;
             lcyapt->quick_max = 0;
 
-            if (audiolcy_get_latency_mode() == LCYMODE_ADAPTIVE) {
+            if (lcyapt->ops->get_latency_mode() == LCYMODE_ADAPTIVE) {
                 stop_check = 0;
                 if (lcyapt->source_info.count > 0) {
                     stop_check = 1;
@@ -1215,12 +1231,12 @@ void audiolcy_adaptive_twsrole_change(void *handle, u8_t old_role, u8_t new_role
     }
 }
 
-void *audiolcy_adatpive_init(audiolcy_common_t *lcycommon)
+void *audiolcy_adatpive_init(audiolcy_common_t *lcycommon, const audiolcyapt_ops_t *ops)
 {
     audiolcy_adaptive_t *lcyapt;
 
     // ALLM is available only when SBC music or AAC music
-    if ((lcycommon == NULL) || (lcycommon->cfg->BM_Use_ALLM == 0) \
+    if ((lcycommon == NULL) || (ops == NULL) || (lcycommon->cfg->BM_Use_ALLM == 0) \
      || (lcycommon->stream_type  != AUDIO_STREAM_MUSIC) \
      || (lcycommon->media_format != SBC_TYPE && lcycommon->media_format != AAC_TYPE))
     {
@@ -1234,9 +1250,10 @@ void *audiolcy_adatpive_init(audiolcy_common_t *lcycommon)
 
     memset(lcyapt, 0, sizeof(audiolcy_adaptive_t));
     lcyapt->lcycommon = lcycommon;
+    lcyapt->ops = ops;
 
     // get cfg latency of LLM (current might be NLM)
-    lcyapt->cfg_minimum = audio_policy_get_increase_threshold(1, lcycommon->media_format) / 1000; //us -> ms
+    lcyapt->cfg_minimum = ops->get_llm_threshold_us(lcycommon->media_format) / 1000; //us -> ms
     lcyapt->cfg_maximum = lcycommon->cfg->BM_ALLM_Upper;
     lcyapt->cfg_factor  = lcycommon->cfg->BM_ALLM_Factor;
 
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file adaptive latency core interface
+ * The analysis and decision core of ALLM, it reaches time, latency state
+ * and latency control only by audiolcyapt_ops_t, so it can also run off device
+ */
+
+#ifndef AUDIOLCY_ADAPTIVE_H
+#define AUDIOLCY_ADAPTIVE_H
+
+#include <audiolcy_common.h>
+
+typedef enum {
+    LCYSYNC_UPDATE = 1,  // update new target latency
+    LCYSYNC_SAVE,        // don't change current target latency and save it if needed
+    LCYSYNC_REPEAT,      // send twssync pkt once more, not used
+
+    LCYSYNC_MAX,         // followers are reserved for other usage
+
+} lcysync_mode_e;
+
+typedef struct {
+    audiolcy_cfg_t *cfg;
+
+    u8_t  media_format;
+    u8_t  stream_type;
+    u8_t  sample_rate_khz;
+    u8_t  twsrole;          // 0xFF: unknown yet
+
+} audiolcy_common_t;
+
+typedef struct {
+    u32_t (*uptime_ms)(void);
+    u32_t (*cyc_to_us)(u32_t cycles);           // convert pktinfo sysclk_cyc span to us
+    u32_t (*get_llm_threshold_us)(u8_t format); // latency threshold of LLM, the minimum of ALLM
+    u8_t  (*get_latency_mode)(void);            // lcymode_e
+    u32_t (*get_latency_us)(void);              // latency the aps is following now
+    u32_t (*get_samplerate_hz)(u8_t is_48khz);  // output sample rate of current aps level
+    void  (*get_fixedcost)(u32_t *samples);     // fixed cost part of latency in samples
+    u32_t (*latency_change)(u16_t lcy_ms);      // apply a new latency to the playback
+    void  (*latency_twssync)(u8_t mode, u16_t lcy_ms);  // sync a new latency to the slave
+
+} audiolcyapt_ops_t;
+
+void audiolcyapt_global_set_invalid(void);
+void audiolcyapt_info_collect(void *handle, audiolcy_pktinfo_t *pktinfo);
+u32_t audiolcyapt_latency_adjust(void *handle, u8_t adjust_en, u8_t sync_en);
+u32_t audiolcyapt_latency_adjust_slave(void *handle, u16_t lcy_ms, u8_t mode);
+u16_t audiolcyapt_latency_get(void *handle);
+
+void audiolcy_adaptive_start_play(void *handle);
+void audiolcy_adaptive_twsrole_change(void *handle, u8_t old_role, u8_t new_role);
+void audiolcy_adaptive_main(void *handle);
+void *audiolcy_adatpive_init(audiolcy_common_t *lcycommon, const audiolcyapt_ops_t *ops);
+void audiolcy_adaptive_deinit(void *handle);
+
+#endif  // AUDIOLCY_ADAPTIVE_H
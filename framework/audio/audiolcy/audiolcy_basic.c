@@ -337,6 +337,34 @@ send_pkt:
     tws_send_pkt_user_type((void *)&sync_pkt, sizeof(audiolcy_lcysync_t));
 }
 
+static u32_t audiolcyapt_sys_uptime_ms(void)
+{
+    return os_uptime_get_32();
+}
+
+static u32_t audiolcyapt_sys_cyc_to_us(u32_t cycles)
+{
+    return k_cyc_to_us_floor32(cycles);
+}
+
+static u32_t audiolcyapt_sys_llm_threshold_us(u8_t format)
+{
+    return audio_policy_get_increase_threshold(LCYMODE_LOW, format);
+}
+
+// system services for ALLM on device
+static const audiolcyapt_ops_t audiolcyapt_sys_ops = {
+    .uptime_ms = audiolcyapt_sys_uptime_ms,
+    .cyc_to_us = audiolcyapt_sys_cyc_to_us,
+    .get_llm_threshold_us = audiolcyapt_sys_llm_threshold_us,
+    .get_latency_mode = audiolcy_get_latency_mode,
+    .get_latency_us = audio_aps_get_latency,
+    .get_samplerate_hz = audio_aps_get_samplerate_hz,
+    .get_fixedcost = audiolcy_ctrl_get_fixedcost,
+    .latency_change = audiolcy_ctrl_latency_change,
+    .latency_twssync = audiolcy_ctrl_latency_twssync,
+};
+
 /*!
  * \brief: initialize latency ctrl when playback opened for music or call
  * \note : do it earlier than anyone use latency mode or threshold
@@ -387,7 +415,7 @@ void audiolcy_ctrl_init(audiolcy_init_param_t *param)
 
         // ALLM init
         if (lcycommon->cfg->BM_Use_ALLM) {
-            lcyctrl->lcyapt = audiolcy_adatpive_init(lcycommon);
+            lcyctrl->lcyapt = audiolcy_adatpive_init(lcycommon, &audiolcyapt_sys_ops);
         }
     } else if (lcycommon->stream_type == AUDIO_STREAM_VOICE) {
         // lock to NLM on calling
@@ -27,20 +27,12 @@
 #include <audio_system.h>
 #include <audio_policy.h>
 #include <audiolcy_common.h>
+#include "audiolcy_adaptive.h"
 
 #define PROPERTY_LATENCY_MODE        "LCY_MODE"
 
 #define ALLM_INSTEAD_OF_LLM   (1)  // use ALLM instead of LLM if BM_Use_ALLM enabled
 
-typedef enum {
-    LCYSYNC_UPDATE = 1,  // update new target latency
-    LCYSYNC_SAVE,        // don't change current target latency and save it if needed
-    LCYSYNC_REPEAT,      // send twssync pkt once more, not used
-
-    LCYSYNC_MAX,         // followers are reserved for other usage
-
-} lcysync_mode_e;
-
 typedef struct {
     audiolcy_cfg_t cfg;
     u8_t  cur_lcy_mode;
@@ -61,17 +53,6 @@ typedef struct {
 
 } audiolcy_lcysync_t;
 
-typedef struct {
-    audiolcy_cfg_t *cfg;
-
-    u8_t  media_format;
-    u8_t  stream_type;
-    u8_t  sample_rate_khz;
-    u8_t  twsrole;          // 0xFF: unknown yet
-
-} audiolcy_common_t;
-
-
 typedef struct {
     audiolcy_common_t lcycommon;
     void *media_handle;     // media_player_t
@@ -111,19 +92,6 @@ u32_t audiolcy_ctrl_latency_change(u16_t lcy_ms);
 void audiolcy_ctrl_drop_insert_data(u32_t new_lcy_ms);
 void audiolcy_ctrl_latency_twssync(u8_t mode, u16_t lcy_ms);
 
-// ALLM interface
-void audiolcyapt_global_set_invalid(void);
-void audiolcyapt_info_collect(void *handle, audiolcy_pktinfo_t *pktinfo);
-u32_t audiolcyapt_latency_adjust(void *handle, u8_t adjust_en, u8_t sync_en);
-u32_t audiolcyapt_latency_adjust_slave(void *handle, u16_t lcy_ms, u8_t mode);
-u16_t audiolcyapt_latency_get(void *handle);
-
-void audiolcy_adaptive_start_play(void *handle);
-void audiolcy_adaptive_twsrole_change(void *handle, u8_t old_role, u8_t new_role);
-void audiolcy_adaptive_main(void *handle);
-void *audiolcy_adatpive_init(audiolcy_common_t *lcycommon);
-void audiolcy_adaptive_deinit(void *handle);
-
 // Music PLC interface
 void *audiolcy_musicplc_init(audiolcy_common_t *lcycommon, void *dsp_handle);
 void audiolcy_musicplc_deinit(void *handle);
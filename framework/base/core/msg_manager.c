@@ -15,28 +15,44 @@
 #include <mem_manager.h>
 #include <msg_manager.h>
 #include <sys_wakelock.h>
+#ifdef CONFIG_MEDIA_SERVICE
+#include <media_service.h>
+#endif
 #include <stdio.h>
 #include <string.h>
+#include <errno.h>
 
 extern int os_get_pending_msg_cnt(void);
 /*global data mailbox for all app thread*/
 OS_MUTEX_DEFINE(msg_manager_mutex);
 
-static sys_slist_t	global_receiver_list;
+#define MAX_LISTENER_NUM	CONFIG_MSG_MANAGER_MAX_LISTENER
+
+/* listener of handle n is stored in global_listener_table[n - 1] */
+static struct msg_listener *global_listener_table[MAX_LISTENER_NUM];
 
 static bool lock_flag;
 
+struct msg_policy {
+	uint8_t type;
+	uint8_t cmd;
+	uint8_t flags;
+};
+
+/* slot is free if type is MSG_NULL */
+static struct msg_policy msg_policy_table[CONFIG_MSG_MANAGER_POLICY_NUM];
+
 static struct msg_listener *msg_manager_find_by_name(char *name)
 {
-	int key;
-	sys_snode_t *node, *tmp;
+	int key, i;
 	struct msg_listener *listener = NULL;
 
 	key = os_irq_lock();
 
-	SYS_SLIST_FOR_EACH_NODE_SAFE(&global_receiver_list, node, tmp) {
-		listener = LISTENER_INFO(node);
-		if (!strcmp(listener->name, name)) {
+	for (i = 0; i < MAX_LISTENER_NUM; i++) {
+		listener = global_listener_table[i];
+		/* receiver names are mostly the same string constants */
+		if (listener && (listener->name == name || !strcmp(listener->name, name))) {
 			goto exit;
 		}
 	}
@@ -49,15 +65,14 @@ exit:
 
 static struct msg_listener *msg_manager_find_by_tid(os_tid_t tid)
 {
-	int key;
-	sys_snode_t *node, *tmp;
+	int key, i;
 	struct msg_listener *listener = NULL;
 
 	key = os_irq_lock();
 
-	SYS_SLIST_FOR_EACH_NODE_SAFE(&global_receiver_list, node, tmp) {
-		listener = LISTENER_INFO(node);
-		if (listener->tid == tid) {
+	for (i = 0; i < MAX_LISTENER_NUM; i++) {
+		listener = global_listener_table[i];
+		if (listener && listener->tid == tid) {
 			goto exit;
 		}
 	}
@@ -89,25 +104,38 @@ char *msg_manager_get_name_by_tid(int tid)
 
 bool msg_manager_add_listener(char *name, os_tid_t tid)
 {
-
 	struct msg_listener *listener = NULL;
-
-	int key = os_irq_lock();
+	bool result = false;
+	int key, i;
 
 	listener = mem_malloc(sizeof(struct msg_listener));
 	if (!listener) {
-		goto exit;
+		return false;
 	}
 
+	memset(listener, 0, sizeof(struct msg_listener));
 	listener->name = name;
-
 	listener->tid = tid;
 
-	sys_slist_append(&global_receiver_list, (sys_snode_t *)listener);
+	key = os_irq_lock();
+
+	for (i = 0; i < MAX_LISTENER_NUM; i++) {
+		if (!global_listener_table[i]) {
+			listener->handle = i + 1;
+			global_listener_table[i] = listener;
+			result = true;
+			break;
+		}
+	}
 
-exit:
 	os_irq_unlock(key);
-	return true;
+
+	if (!result) {
+		SYS_LOG_ERR("too many listeners %s\n", name);
+		mem_free(listener);
+	}
+
+	return result;
 }
 
 bool msg_manager_remove_listener(char *name)
@@ -118,13 +146,16 @@ bool msg_manager_remove_listener(char *name)
 	int key = os_irq_lock();
 
 	if (listener != NULL) {
-		sys_slist_find_and_remove(&global_receiver_list, (sys_snode_t *)listener);
-		mem_free(listener);
+		global_listener_table[listener->handle - 1] = NULL;
 		result = true;
-		goto exit;
 	}
-exit:
+
 	os_irq_unlock(key);
+
+	if (result) {
+		mem_free(listener);
+	}
+
 	return result;
 }
 
@@ -138,14 +169,240 @@ os_tid_t  msg_manager_listener_tid(char *name)
 
 	return NULL;
 }
+
+int msg_manager_get_handle(char *name)
+{
+	struct msg_listener *listener = msg_manager_find_by_name(name);
+
+	if (listener != NULL) {
+		return listener->handle;
+	}
+
+	return 0;
+}
+
+/* the listener may be removed after unlock, only use the returned tid */
+static os_tid_t msg_manager_handle_tid(int handle, struct msg_listener **plistener)
+{
+	struct msg_listener *listener;
+	os_tid_t tid = NULL;
+	int key;
+
+	if (handle <= 0 || handle > MAX_LISTENER_NUM) {
+		return NULL;
+	}
+
+	key = os_irq_lock();
+	listener = global_listener_table[handle - 1];
+	if (listener) {
+		tid = listener->tid;
+	}
+	os_irq_unlock(key);
+
+	*plistener = listener;
+	return tid;
+}
+
+int msg_manager_set_msg_policy(uint8_t type, uint8_t cmd, uint8_t flags)
+{
+	struct msg_policy *policy = NULL;
+	int key, i, ret = 0;
+
+	if (type == MSG_NULL) {
+		return -EINVAL;
+	}
+
+	key = os_irq_lock();
+
+	for (i = 0; i < CONFIG_MSG_MANAGER_POLICY_NUM; i++) {
+		if (msg_policy_table[i].type == type && msg_policy_table[i].cmd == cmd) {
+			policy = &msg_policy_table[i];
+			break;
+		}
+
+		if (!policy && msg_policy_table[i].type == MSG_NULL) {
+			policy = &msg_policy_table[i];
+		}
+	}
+
+	if (!policy) {
+		ret = -ENOMEM;
+	} else if (flags) {
+		policy->type = type;
+		policy->cmd = cmd;
+		policy->flags = flags;
+	} else if (policy->type == type) {
+		policy->type = MSG_NULL;
+	}
+
+	os_irq_unlock(key);
+
+	if (ret) {
+		SYS_LOG_ERR("too many msg policies %d %d\n", type, cmd);
+	}
+
+	return ret;
+}
+
+static uint8_t msg_manager_get_msg_policy(struct app_msg *msg)
+{
+	uint8_t flags = 0;
+	int key, i;
+
+	key = os_irq_lock();
+
+	for (i = 0; i < CONFIG_MSG_MANAGER_POLICY_NUM; i++) {
+		if (msg_policy_table[i].type == msg->type && msg_policy_table[i].cmd == msg->cmd) {
+			flags = msg_policy_table[i].flags;
+			break;
+		}
+	}
+
+	os_irq_unlock(key);
+
+	return flags;
+}
+
 /*init manager*/
 bool msg_manager_init(void)
 {
 	os_msg_init();
 	lock_flag = false;
+
+	/* only the newest volume is shown, cmd tells if it is limited */
+	msg_manager_set_msg_policy(MSG_VOLUME_CHANGED_EVENT, 0, MSG_POLICY_COALESCE);
+	msg_manager_set_msg_policy(MSG_VOLUME_CHANGED_EVENT, 1, MSG_POLICY_COALESCE);
+
+#ifdef CONFIG_MEDIA_SERVICE
+	/*
+	 * player control must not queue behind ui messages. All the player
+	 * messages which may be sent without waiting for the reply are urgent,
+	 * so the media service still gets them in the order they were sent.
+	 */
+	msg_manager_set_msg_policy(MSG_MEDIA_SRV_PRE_ENABLE, 0, MSG_POLICY_URGENT);
+	msg_manager_set_msg_policy(MSG_MEDIA_SRV_PRE_PLAY, 0, MSG_POLICY_URGENT);
+	msg_manager_set_msg_policy(MSG_MEDIA_SRV_PLAY, 0, MSG_POLICY_URGENT);
+	msg_manager_set_msg_policy(MSG_MEDIA_SRV_STOP, 0, MSG_POLICY_URGENT);
+	msg_manager_set_msg_policy(MSG_MEDIA_SRV_PAUSE, 0, MSG_POLICY_URGENT);
+	msg_manager_set_msg_policy(MSG_MEDIA_SRV_RESUME, 0, MSG_POLICY_URGENT);
+	msg_manager_set_msg_policy(MSG_MEDIA_SRV_SET_PARAMETER, 0, MSG_POLICY_URGENT);
+	msg_manager_set_msg_policy(MSG_MEDIA_SRV_SET_GLOBAL_PARAMETER, 0, MSG_POLICY_URGENT);
+#endif
 	return true;
 }
 
+static void msg_manager_update_stat(int handle, os_tid_t tid, bool result, uint32_t start_cycle)
+{
+#ifdef CONFIG_MSG_MANAGER_STAT
+	struct msg_listener *listener;
+	uint32_t cost_us = k_cyc_to_us_floor32(k_cycle_get_32() - start_cycle);
+	int depth = result ? os_get_target_pending_msg_cnt(tid) : 0;
+	int key;
+
+	key = os_irq_lock();
+
+	listener = global_listener_table[handle - 1];
+	if (listener && listener->tid == tid) {
+		if (result) {
+			listener->stat.send_cnt++;
+		} else {
+			listener->stat.fail_cnt++;
+		}
+
+		listener->stat.latency_total_us += cost_us;
+		if (cost_us > listener->stat.latency_max_us) {
+			listener->stat.latency_max_us = cost_us;
+		}
+
+		if (depth > listener->stat.depth_max) {
+			listener->stat.depth_max = depth;
+		}
+	}
+
+	os_irq_unlock(key);
+#endif
+}
+
+static bool msg_manager_send_to(int handle, os_tid_t tid, struct app_msg *msg)
+{
+	uint8_t policy = msg_manager_get_msg_policy(msg);
+	uint32_t flags = (policy & MSG_POLICY_URGENT) ? OS_MSG_URGENT : 0;
+	uint16_t key = 0;
+	bool result;
+#ifdef CONFIG_MSG_MANAGER_STAT
+	uint32_t start_cycle = k_cycle_get_32();
+#else
+	uint32_t start_cycle = 0;
+#endif
+
+	/* a message somebody waits for can not be replaced */
+	if ((policy & MSG_POLICY_COALESCE) && !msg->callback && !msg->sync_sem) {
+		key = ((uint16_t)msg->type << 8) | msg->cmd;
+	}
+
+	if (!os_send_async_msg_ext(tid, msg, sizeof(struct app_msg), flags, key)) {
+		result = true;
+	} else {
+		SYS_LOG_ERR("send fail, type:%d, cmd:%d\n", msg->type,msg->cmd);
+#ifdef CONFIG_MESSAGE_DEBUG
+		msg_manager_dump_busy_msg();
+#endif
+		result = false;
+	}
+
+	if (handle > 0) {
+		msg_manager_update_stat(handle, tid, result, start_cycle);
+	}
+
+	return result;
+}
+
+bool msg_manager_send_async_msg_by_handle(int handle, struct app_msg *msg)
+{
+	struct msg_listener *listener;
+	os_tid_t tid;
+	bool result;
+
+	if (lock_flag) {
+		SYS_LOG_WRN("msg mng is lock %d \n", handle);
+	}
+
+	tid = msg_manager_handle_tid(handle, &listener);
+	if (tid == NULL) {
+		SYS_LOG_ERR("handle %d not ready\n", handle);
+		return false;
+	}
+
+	result = msg_manager_send_to(handle, tid, msg);
+
+	return result;
+}
+
+int msg_manager_send_async_msg_batch(const int *handles, int num, struct app_msg *msg)
+{
+	struct msg_listener *listener;
+	os_tid_t tid;
+	int i, sent = 0;
+
+	if (lock_flag) {
+		SYS_LOG_WRN("msg mng is lock\n");
+	}
+
+	for (i = 0; i < num; i++) {
+		tid = msg_manager_handle_tid(handles[i], &listener);
+		if (tid == NULL) {
+			SYS_LOG_ERR("handle %d not ready\n", handles[i]);
+			continue;
+		}
+
+		if (msg_manager_send_to(handles[i], tid, msg)) {
+			sent++;
+		}
+	}
+
+	return sent;
+}
+
 /*@brief Provide send async mesg interface
  *Note:
  *
@@ -155,45 +412,78 @@ bool msg_manager_init(void)
 
 bool msg_manager_send_async_msg(char *receiver, struct app_msg *msg)
 {
-	int prio;
+	int handle;
 	bool result = false;
-	os_tid_t target_thread_tid = OS_ANY;
+
 #ifdef CONFIG_SYS_WAKELOCK
 	//sys_wake_lock(WAKELOCK_MESSAGE);
 #endif
-	if (lock_flag) {
-		SYS_LOG_WRN("msg mng is lock %s \n",receiver);
-	}
-
-	prio = os_thread_priority_get(os_current_get());
-	os_thread_priority_set(os_current_get(), -1);
-
-	if (strcmp(receiver, ALL_RECEIVER_NAME)) {
-		target_thread_tid = msg_manager_listener_tid(receiver);
-		if (target_thread_tid == NULL) {
-			SYS_LOG_ERR("app %s not ready\n", receiver);
-			result = false;
-			goto exit;
+	if (!strcmp(receiver, ALL_RECEIVER_NAME)) {
+		if (lock_flag) {
+			SYS_LOG_WRN("msg mng is lock %s \n",receiver);
 		}
+
+		result = msg_manager_send_to(0, OS_ANY, msg);
+		goto exit;
 	}
 
-	if (!os_send_async_msg(target_thread_tid, msg, sizeof(struct app_msg))) {
-		result = true;
-	} else {
-		SYS_LOG_ERR("send fail, type:%d, cmd:%d\n", msg->type,msg->cmd);
-#ifdef CONFIG_MESSAGE_DEBUG
-		msg_manager_dump_busy_msg();
-#endif
+	handle = msg_manager_get_handle(receiver);
+	if (!handle) {
+		SYS_LOG_ERR("app %s not ready\n", receiver);
 		result = false;
+		goto exit;
 	}
+
+	result = msg_manager_send_async_msg_by_handle(handle, msg);
 exit:
 #ifdef CONFIG_SYS_WAKELOCK
 	//sys_wake_unlock(WAKELOCK_MESSAGE);
 #endif
-	os_thread_priority_set(os_current_get(), prio);
 	return result;
 }
 
+int msg_manager_get_listener_stat(int handle, struct msg_listener_stat *stat)
+{
+	struct msg_listener *listener;
+	int key, ret = -ENOENT;
+
+	if (handle <= 0 || handle > MAX_LISTENER_NUM) {
+		return -EINVAL;
+	}
+
+	key = os_irq_lock();
+	listener = global_listener_table[handle - 1];
+	if (listener) {
+		memcpy(stat, &listener->stat, sizeof(struct msg_listener_stat));
+		ret = 0;
+	}
+	os_irq_unlock(key);
+
+	return ret;
+}
+
+void msg_manager_dump_listener(void)
+{
+	struct msg_listener_stat stat;
+	struct msg_listener *listener;
+	int i;
+
+	os_printk("handle name            send   fail depth max_us avg_us pending\n");
+
+	for (i = 0; i < MAX_LISTENER_NUM; i++) {
+		listener = global_listener_table[i];
+		if (!listener || msg_manager_get_listener_stat(i + 1, &stat)) {
+			continue;
+		}
+
+		os_printk("%6d %-12s %8u %6u %5u %6u %6u %7d\n", i + 1, listener->name,
+			stat.send_cnt, stat.fail_cnt, stat.depth_max, stat.latency_max_us,
+			(stat.send_cnt + stat.fail_cnt) ?
+				stat.latency_total_us / (stat.send_cnt + stat.fail_cnt) : 0,
+			os_get_target_pending_msg_cnt(listener->tid));
+	}
+}
+
 #if 0
 bool msg_manager_send_sync_msg(char *receiver, struct app_msg *msg)
 {
@@ -297,6 +587,17 @@ static void _msg_manager_dump_cb(os_tid_t sender, os_tid_t receiver,
 
 void msg_manager_dump_busy_msg(void)
 {
+	int i;
+
+	for (i = 0; i < CONFIG_MSG_MANAGER_POLICY_NUM; i++) {
+		if (msg_policy_table[i].type != MSG_NULL) {
+			os_printk("policy type %d cmd %d:%s%s\n", msg_policy_table[i].type,
+				msg_policy_table[i].cmd,
+				(msg_policy_table[i].flags & MSG_POLICY_COALESCE) ? " coalesce" : "",
+				(msg_policy_table[i].flags & MSG_POLICY_URGENT) ? " urgent" : "");
+		}
+	}
+
 	msg_pool_dump(_msg_manager_dump_cb);
 }
 
@@ -121,6 +121,76 @@ void *mem_malloc_debug(unsigned int num_bytes, void *caller);
 
 int mem_manager_init(void);
 
+/** version of mem stat snapshot layout */
+#define MEM_STAT_VERSION	(1)
+
+/**
+ * @brief mem stat snapshot head
+ *
+ * A snapshot is the head followed by class_num struct mem_slab_class_stat
+ * and caller_num struct mem_slab_caller_stat, all in cpu byte order.
+ */
+struct mem_stat_head {
+	uint8_t version;
+	uint8_t class_num;
+	uint8_t caller_num;
+	uint8_t reserved;
+	/** uptime in ms when the snapshot is taken */
+	uint32_t uptime;
+	/** allocations not recorded because caller table is full */
+	uint32_t caller_miss;
+	/** allocations larger than the biggest block size */
+	uint32_t oversize_cnt;
+};
+
+/** per size class statistics */
+struct mem_slab_class_stat {
+	uint16_t block_size;
+	uint16_t block_num;
+	uint16_t used;
+	uint16_t max_used;
+	uint16_t max_size;
+	/** times this class is refilled by dividing a block of bigger class */
+	uint16_t promote_cnt;
+	uint32_t alloc_cnt;
+	uint32_t free_cnt;
+	/** allocations failed since this class and all bigger ones are full */
+	uint32_t fail_cnt;
+	/** allocations served by this class since the best fit class is full */
+	uint32_t spill_cnt;
+	/** total requested bytes of alloc_cnt, to estimate inner fragmentation */
+	uint32_t req_bytes;
+};
+
+/** per caller allocation statistics */
+struct mem_slab_caller_stat {
+	void *caller;
+	uint32_t alloc_cnt;
+	uint32_t alloc_bytes;
+	uint32_t fail_cnt;
+};
+
+/**
+ * @brief get mem stat snapshot.
+ *
+ * This routine copies the allocator statistics into a compact binary
+ * snapshot, which can be saved or sent to the host for offline analysis.
+ *
+ * @param buf buffer to store the snapshot
+ * @param size size of buffer
+ *
+ * @return length of snapshot if successful, -ENOMEM if buffer too small,
+ * -ENOTSUP if the allocator does not support statistics.
+ */
+int mem_manager_get_stat(void *buf, int size);
+
+/**
+ * @brief dump mem stat report.
+ *
+ * @return N/A
+ */
+void mem_manager_dump_stat(void);
+
 /**
  * @} end defgroup mem_manager_apis
  */
@@ -97,15 +97,27 @@ typedef enum
 } msg_type;
 
 
+/** per listener message statistics */
+struct msg_listener_stat
+{
+	uint32_t send_cnt;
+	uint32_t fail_cnt;
+	/* max pending messages of the listener seen after a send */
+	uint16_t depth_max;
+	/* time spent in posting a message */
+	uint32_t latency_max_us;
+	uint32_t latency_total_us;
+};
+
 struct msg_listener
 {
-	sys_snode_t node;
 	char * name;
 	os_tid_t tid;
+	/* small integer id of listener, > 0 */
+	int handle;
+	struct msg_listener_stat stat;
 };
 
-#define LISTENER_INFO(_node) CONTAINER_OF(_node, struct msg_listener, node)
-
 
 
 /**
@@ -174,6 +186,89 @@ bool msg_manager_init(void);
  */
 bool msg_manager_send_async_msg(char * receiver , struct app_msg *msg);
 
+/**
+ * @brief get handle of message listener
+ *
+ * This routine resolves a receiver name to the integer handle assigned
+ * in msg_manager_add_listener(), so that hot paths can send messages
+ * without looking up the receiver name every time. The handle stays
+ * valid until the listener is removed.
+ *
+ * @param name name of message receiver
+ *
+ * @return 0 The listener is not in the message linsener list
+ * @return handle handle of the message linsener
+ */
+int msg_manager_get_handle(char *name);
+
+/**
+ * @brief Send a Asynchronous message by listener handle
+ *
+ * @param handle handle of message receiver
+ * @param msg message to send
+ *
+ * @return true send success
+ * @return false send failed
+ */
+bool msg_manager_send_async_msg_by_handle(int handle, struct app_msg *msg);
+
+/**
+ * @brief Send the same Asynchronous message to several receivers
+ *
+ * @param handles handles of message receivers
+ * @param num number of handles
+ * @param msg message to send
+ *
+ * @return number of receivers the message was sent to
+ */
+int msg_manager_send_async_msg_batch(const int *handles, int num, struct app_msg *msg);
+
+/** pending message with the same type and cmd is replaced by the newer one */
+#define MSG_POLICY_COALESCE	BIT(0)
+/** message is received ahead of normal messages, for audio critical control */
+#define MSG_POLICY_URGENT	BIT(1)
+
+/**
+ * @brief set delivery policy of a message
+ *
+ * This routine sets how messages of type and cmd are queued to all
+ * receivers. With MSG_POLICY_COALESCE a message not received yet is
+ * replaced by the newer one of the same type and cmd, which then takes
+ * no extra message memory, so only use it for status updates where
+ * the newest value is all that matters. Messages with callback or
+ * sync_sem are never replaced. With MSG_POLICY_URGENT the message goes
+ * to the high priority lane of the receiver and may use the messages
+ * reserved by CONFIG_OS_MSG_URGENT_RESERVE.
+ *
+ * @param type message type
+ * @param cmd message cmd
+ * @param flags MSG_POLICY_XXX flags, 0 to remove the policy
+ *
+ * @return 0 success
+ * @return -ENOMEM too many policies
+ */
+int msg_manager_set_msg_policy(uint8_t type, uint8_t cmd, uint8_t flags);
+
+/**
+ * @brief get message statistics of listener
+ *
+ * Counters are only updated if CONFIG_MSG_MANAGER_STAT is enabled.
+ *
+ * @param handle handle of message listener
+ * @param stat store the statistics
+ *
+ * @return 0 success
+ * @return -ENOENT listener not found
+ */
+int msg_manager_get_listener_stat(int handle, struct msg_listener_stat *stat);
+
+/**
+ * @brief dump message statistics of all listeners
+ *
+ * @return N/A
+ */
+void msg_manager_dump_listener(void);
+
 /**
  * @brief receive message
  *
@@ -220,7 +315,8 @@ int msg_manager_get_pending_msg_cnt(void);
 /**
  * @brief dump busy message info
  *
- * This routine dump busy message info
+ * This routine dump message policies, the drop and coalesce counters of
+ * the message queues, and busy message info
  *
  * @return N/A
  */
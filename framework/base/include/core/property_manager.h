@@ -261,6 +261,15 @@ int property_flush(const char *key);
 
 int property_flush_req(const char *key);
 
+/**
+ * @brief dump property cache statistics
+ *
+ * @details print hit/miss/eviction counters and cached items if property
+ * cache enabled
+ */
+
+void property_dump(void);
+
 /**
  * @brief init property manager
  *
@@ -73,6 +73,14 @@ struct acts_ringbuf {
 	uint32_t tail_offset;
 };
 
+/** contiguous segment of a ring buffer, which wraps at most once */
+struct acts_ringbuf_iovec {
+	/* cpu address of the segment */
+	void *base;
+	/* segment length in elements */
+	uint32_t len;
+};
+
 /**
  * @brief Statically define and initialize a high performance ring buffer.
  *
@@ -243,13 +251,33 @@ uint32_t acts_ringbuf_get(struct acts_ringbuf *buf, void *data, uint32_t size);
  * @param[in] size Requested size in elements.
  *
  * @return Number of valid elements in the provided buffer which can be smaller
- *	   than requested if there is not enough free space or buffer wraps.
+ *	   than requested if there is not enough data or buffer wraps.
  */
 uint32_t acts_ringbuf_get_claim(struct acts_ringbuf *buf, void **data, uint32_t size);
 
+/**
+ * @brief Get addresses of valid data in a ring buffer across the wrap.
+ *
+ * Same as @ref acts_ringbuf_get_claim, but returns up to two segments, so
+ * the data can be processed in place even if it wraps. iov[1].len is 0 if
+ * the claimed data is contiguous.
+ *
+ * @param[in]  buf Address of ring buffer.
+ * @param[out] iov Segments within ring buffer.
+ * @param[in]  size Requested size in elements.
+ *
+ * @return Total number of valid elements in the segments, which can be
+ *	   smaller than requested if there is not enough data.
+ */
+uint32_t acts_ringbuf_get_claim_iov(struct acts_ringbuf *buf,
+		struct acts_ringbuf_iovec iov[2], uint32_t size);
+
 /**
  * @brief Indicate number of elements read from claimed buffer.
  *
+ * Both @ref acts_ringbuf_get_claim and @ref acts_ringbuf_get_claim_iov
+ * are finished by this routine.
+ *
  * @param  buf Address of ring buffer.
  * @param  size Number of elements that can be freed.
  *
@@ -288,9 +316,29 @@ uint32_t acts_ringbuf_put(struct acts_ringbuf *buf, const void *data, uint32_t s
  */
 uint32_t acts_ringbuf_put_claim(struct acts_ringbuf *buf, void **data, uint32_t size);
 
+/**
+ * @brief Allocate buffers for writing data to a ring buffer across the wrap.
+ *
+ * Same as @ref acts_ringbuf_put_claim, but returns up to two segments, so
+ * the producer can fill the whole free space in place. iov[1].len is 0 if
+ * the allocated space is contiguous.
+ *
+ * @param[in]  buf Address of ring buffer.
+ * @param[out] iov Segments within ring buffer.
+ * @param[in]  size Requested allocation size in elements.
+ *
+ * @return Total size of the segments, which can be smaller than requested
+ *	   if there is not enough free space.
+ */
+uint32_t acts_ringbuf_put_claim_iov(struct acts_ringbuf *buf,
+		struct acts_ringbuf_iovec iov[2], uint32_t size);
+
 /**
  * @brief Indicate number of elements written to allocated buffers.
  *
+ * Both @ref acts_ringbuf_put_claim and @ref acts_ringbuf_put_claim_iov
+ * are finished by this routine.
+ *
  * @warning
  * Use cases involving multiple writers to the ring buffer must prevent
  * concurrent write operations, either by preventing all writers from
@@ -554,6 +602,179 @@ void acts_ringbuf_defrag(struct acts_ringbuf *buf);
  */
 void acts_ringbuf_dump(struct acts_ringbuf *buf, const char *name, const char *line_prefix);
 
+#ifndef ACTS_RINGBUF_CACHE_LINE_SIZE
+# define ACTS_RINGBUF_CACHE_LINE_SIZE (32)
+#endif
+
+/**
+ * Single-producer/single-consumer ring buffer.
+ *
+ * The producer only writes the tail side and the consumer only writes the
+ * head side. Indexes are published with release semantics after the data
+ * access and loaded with acquire semantics before it, so one producer and
+ * one consumer (thread or ISR) can access the ring concurrently without
+ * irq lock or mutex. Head and tail are kept in separate cache lines.
+ *
+ * This ring buffer can only be accessed on cpu side.
+ */
+struct acts_ringbuf_spsc {
+	/* Size of buffer in elements, constant after init */
+	uint32_t size;
+	/* cpu address of buffer, constant after init */
+	uint32_t cpu_ptr;
+
+	/* Consumer side: index and offset of the head element */
+	uint32_t head __aligned(ACTS_RINGBUF_CACHE_LINE_SIZE);
+	uint32_t head_offset;
+
+	/* Producer side: index and offset of the tail element */
+	uint32_t tail __aligned(ACTS_RINGBUF_CACHE_LINE_SIZE);
+	uint32_t tail_offset;
+} __aligned(ACTS_RINGBUF_CACHE_LINE_SIZE);
+
+/**
+ * @brief Statically define and initialize a SPSC ring buffer.
+ *
+ * The ring buffer can be accessed outside the module where it is defined
+ * using:
+ *
+ * @code extern struct acts_ringbuf_spsc <name>; @endcode
+ *
+ * @param name Name of the ring buffer.
+ * @param buf Ring buffer data area.
+ * @param size_e Ring buffer size in elements.
+ */
+#define ACTS_RINGBUF_DEFINE_SPSC(name, buf, size_e)	\
+	struct acts_ringbuf_spsc name = {	\
+		.size = size_e,	\
+		.cpu_ptr = (uint32_t)buf,	\
+		.head = 0,	\
+		.head_offset = 0,	\
+		.tail = 0,	\
+		.tail_offset = 0,	\
+	}
+
+/**
+ * @brief Initialize a SPSC ring buffer.
+ *
+ * Must not race with producer or consumer.
+ *
+ * @param buf Address of ring buffer.
+ * @param data Ring buffer data area.
+ * @param size Ring buffer size in elements.
+ *
+ * @return 0 if succeed.
+ */
+int acts_ringbuf_spsc_init(struct acts_ringbuf_spsc *buf, void *data, uint32_t size);
+
+/**
+ * @brief Write a SPSC ring buffer, producer side.
+ *
+ * @param buf Address of ring buffer.
+ * @param data Address of data.
+ * @param size Size of data in elements.
+ *
+ * @return number of elements written, either 0 or @a size.
+ */
+uint32_t acts_ringbuf_spsc_put(struct acts_ringbuf_spsc *buf, const void *data, uint32_t size);
+
+/**
+ * @brief Allocate buffers in a SPSC ring buffer, producer side.
+ *
+ * @param[in]  buf Address of ring buffer.
+ * @param[out] iov Segments within ring buffer, iov[1].len is 0 if not wrapped.
+ * @param[in]  size Requested allocation size in elements.
+ *
+ * @return Total size of the segments.
+ */
+uint32_t acts_ringbuf_spsc_put_claim_iov(struct acts_ringbuf_spsc *buf,
+		struct acts_ringbuf_iovec iov[2], uint32_t size);
+
+/**
+ * @brief Publish elements written to allocated buffers, producer side.
+ *
+ * @param buf Address of ring buffer.
+ * @param size Number of valid elements in the allocated buffers.
+ *
+ * @retval 0 Successful operation.
+ * @retval -EINVAL Provided @a size exceeds free space in the ring buffer.
+ */
+int acts_ringbuf_spsc_put_finish(struct acts_ringbuf_spsc *buf, uint32_t size);
+
+/**
+ * @brief Read a SPSC ring buffer, consumer side.
+ *
+ * @param buf Address of ring buffer.
+ * @param data Address of data, or NULL to drop the data.
+ * @param size Size of data in elements.
+ *
+ * @return number of elements read, either 0 or @a size.
+ */
+uint32_t acts_ringbuf_spsc_get(struct acts_ringbuf_spsc *buf, void *data, uint32_t size);
+
+/**
+ * @brief Get addresses of valid data in a SPSC ring buffer, consumer side.
+ *
+ * @param[in]  buf Address of ring buffer.
+ * @param[out] iov Segments within ring buffer, iov[1].len is 0 if not wrapped.
+ * @param[in]  size Requested size in elements.
+ *
+ * @return Total number of valid elements in the segments.
+ */
+uint32_t acts_ringbuf_spsc_get_claim_iov(struct acts_ringbuf_spsc *buf,
+		struct acts_ringbuf_iovec iov[2], uint32_t size);
+
+/**
+ * @brief Release elements read from claimed buffers, consumer side.
+ *
+ * @param buf Address of ring buffer.
+ * @param size Number of elements that can be freed.
+ *
+ * @retval 0 Successful operation.
+ * @retval -EINVAL Provided @a size exceeds valid elements in the ring buffer.
+ */
+int acts_ringbuf_spsc_get_finish(struct acts_ringbuf_spsc *buf, uint32_t size);
+
+/**
+ * @brief Determine data length in a SPSC ring buffer.
+ *
+ * On the consumer side the result may be smaller than the real length,
+ * on the producer side it may be larger, both of which are safe.
+ *
+ * @param buf Address of ring buffer.
+ *
+ * @return Ring buffer data length in elements.
+ */
+static inline uint32_t acts_ringbuf_spsc_length(struct acts_ringbuf_spsc *buf)
+{
+	return __atomic_load_n(&buf->tail, __ATOMIC_ACQUIRE) -
+		__atomic_load_n(&buf->head, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * @brief Determine free space in a SPSC ring buffer.
+ *
+ * @param buf Address of ring buffer.
+ *
+ * @return Ring buffer free space in elements.
+ */
+static inline uint32_t acts_ringbuf_spsc_space(struct acts_ringbuf_spsc *buf)
+{
+	return buf->size - acts_ringbuf_spsc_length(buf);
+}
+
+/**
+ * @brief Determine if a SPSC ring buffer is empty.
+ *
+ * @param buf Address of ring buffer.
+ *
+ * @return 1 if the ring buffer is empty, or 0 if not.
+ */
+static inline int acts_ringbuf_spsc_is_empty(struct acts_ringbuf_spsc *buf)
+{
+	return acts_ringbuf_spsc_length(buf) == 0;
+}
+
 #ifdef __cplusplus
 }
 #endif
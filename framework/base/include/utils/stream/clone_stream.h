@@ -12,6 +12,7 @@
 #define __CLONE_STREAM_H__
 
 #include <stream.h>
+#include <acts_ringbuf.h>
 
 /**
  * @defgroup clone_stream_apis Clone Stream APIs
@@ -29,10 +30,128 @@ struct clone_stream_info {
 	int clone_mode;
 	/* stream array that will be cloned to */
 	io_stream_t clones[1];
+
+	/* size of buffer shared by the views, 0 if no view is used */
+	int view_buf_size;
+};
+
+/** policy of a view which lags behind the producer too much */
+enum clone_stream_lag_policy {
+	/** skip the oldest unread data of the view */
+	CLONE_STREAM_LAG_DROP = 0,
+	/** stop the view, claims fail until clone_stream_view_reset */
+	CLONE_STREAM_LAG_STOP,
+};
+
+/** statistics of clone stream view */
+struct clone_stream_view_stat {
+	/* bytes not read yet */
+	uint32_t lag;
+	/* max bytes not read yet */
+	uint32_t max_lag;
+	/* bytes skipped by CLONE_STREAM_LAG_DROP */
+	uint32_t dropped;
+	/* times stopped by CLONE_STREAM_LAG_STOP */
+	uint32_t stopped;
 };
 
 io_stream_t clone_stream_create(struct clone_stream_info *info);
 
+/**
+ * @brief open a view of the clone stream data
+ *
+ * The data read from or written to the origin stream is copied once into
+ * the buffer shared by all views, each view reads it in place at its own
+ * pace. The producer never blocks on views: when a view lags more than
+ * max_lag bytes (or the shared buffer size), the policy applies. Register
+ * a stream observer on the clone stream to be notified of new data.
+ *
+ * Contract with the producer: it applies the lag policy and advances the
+ * read offsets of the lagging views first, then copies the data into the
+ * shared buffer outside the lock, and publishes the new write offset last.
+ * So a claim never returns data being copied, but claimed data of a view
+ * which lags too much may be overwritten while it is read. This is not
+ * reported at once, only clone_stream_view_release returns -EPIPE, and the
+ * data read since the claim must then be discarded. A consumer which cannot
+ * discard data already passed on (sent or written) must keep its lag well
+ * below the shared buffer size.
+ *
+ * @param handle handle of clone stream
+ * @param max_lag max bytes the view may lag, 0 means the shared buffer size
+ * @param policy lag policy, enum clone_stream_lag_policy
+ *
+ * @return view id if success
+ * @return <0  open failed
+ */
+int clone_stream_view_open(io_stream_t handle, uint32_t max_lag, uint8_t policy);
+
+/**
+ * @brief close a view of the clone stream
+ *
+ * @param handle handle of clone stream
+ * @param view view id
+ *
+ * @return 0 if success
+ * @return <0  close failed
+ */
+int clone_stream_view_close(io_stream_t handle, int view);
+
+/**
+ * @brief claim the unread data of a view for in place reading
+ *
+ * The returned segments are read only and shared with other views.
+ *
+ * @param handle handle of clone stream
+ * @param view view id
+ * @param iov segments of data, iov[1].len is 0 if not wrapped
+ * @param len max bytes to claim
+ *
+ * @return bytes claimed
+ * @return -EPIPE the view is stopped by CLONE_STREAM_LAG_STOP
+ * @return <0  other errors
+ */
+int clone_stream_view_claim(io_stream_t handle, int view,
+		struct acts_ringbuf_iovec iov[2], int len);
+
+/**
+ * @brief release the data claimed by clone_stream_view_claim
+ *
+ * @param handle handle of clone stream
+ * @param view view id
+ * @param len bytes consumed, not greater than the claimed bytes
+ *
+ * @return 0 if success
+ * @return -EPIPE the claimed data has been overwritten by the producer
+ *         since the view lagged too much, or the view has been stopped
+ *         meanwhile; the data read since the claim must be discarded
+ * @return <0  other errors
+ */
+int clone_stream_view_release(io_stream_t handle, int view, int len);
+
+/**
+ * @brief restart a view from the latest data
+ *
+ * @param handle handle of clone stream
+ * @param view view id
+ *
+ * @return 0 if success
+ * @return <0  reset failed
+ */
+int clone_stream_view_reset(io_stream_t handle, int view);
+
+/**
+ * @brief get statistics of a view
+ *
+ * @param handle handle of clone stream
+ * @param view view id
+ * @param stat statistics of the view
+ *
+ * @return 0 if success
+ * @return <0  failed
+ */
+int clone_stream_view_get_stat(io_stream_t handle, int view,
+		struct clone_stream_view_stat *stat);
+
 /**
  * @} end defgroup clone_stream_apis
  */
@@ -47,6 +47,64 @@ io_stream_t ringbuff_stream_create(struct acts_ringbuf *param);
  */
 io_stream_t ringbuff_stream_create_ext(void *ring_buff, uint32_t ring_buff_size);
 
+/**
+ * @brief claim data of ring buffer stream for in place reading
+ *
+ * This routine returns up to two segments of valid data inside the ring
+ * buffer, so the consumer can process data without copying it out. The
+ * data is released by ringbuff_stream_read_finish. Not allowed on streams
+ * which have attached streams.
+ *
+ * @param handle handle of ring buffer stream
+ * @param iov segments of valid data, iov[1].len is 0 if not wrapped
+ * @param len bytes user want to read
+ *
+ * @return >=0 bytes claimed, may be less than len
+ * @return <0 claim failed
+ */
+int ringbuff_stream_read_claim(io_stream_t handle, struct acts_ringbuf_iovec iov[2], int len);
+
+/**
+ * @brief release data claimed by ringbuff_stream_read_claim
+ *
+ * @param handle handle of ring buffer stream
+ * @param len bytes consumed
+ *
+ * @return 0 release success
+ * @return <0 release failed
+ */
+int ringbuff_stream_read_finish(io_stream_t handle, int len);
+
+/**
+ * @brief claim free space of ring buffer stream for in place writing
+ *
+ * This routine returns up to two segments of free space inside the ring
+ * buffer, so the producer can generate data in place. The data is published
+ * by ringbuff_stream_write_finish. Not allowed on streams which have
+ * attached streams.
+ *
+ * @param handle handle of ring buffer stream
+ * @param iov segments of free space, iov[1].len is 0 if not wrapped
+ * @param len bytes user want to write
+ *
+ * @return >=0 bytes claimed, may be less than len
+ * @return <0 claim failed
+ */
+int ringbuff_stream_write_claim(io_stream_t handle, struct acts_ringbuf_iovec iov[2], int len);
+
+/**
+ * @brief publish data written into space claimed by ringbuff_stream_write_claim
+ *
+ * Stream observers are notified the same way as stream_write.
+ *
+ * @param handle handle of ring buffer stream
+ * @param len bytes written
+ *
+ * @return 0 publish success
+ * @return <0 publish failed
+ */
+int ringbuff_stream_write_finish(io_stream_t handle, int len);
+
 /**
  * @} end defgroup buffer_stream_apis
  */
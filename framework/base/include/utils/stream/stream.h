@@ -156,6 +156,24 @@ int stream_open(io_stream_t handle, stream_mode mode);
  */
 int stream_read(io_stream_t handle, void *buf, int num);
 
+/**
+ * @brief wait for readable data of stream
+ *
+ * This routine blocks until at least len bytes can be read from the stream,
+ * the write side finished, or the timeout expired. The caller is only woken
+ * when the readable length reaches len, not on every write. Only supported
+ * by stream opened with MODE_READ_BLOCK or MODE_WRITE_BLOCK.
+ *
+ * @param handle handle of stream
+ * @param len bytes the caller wants to read
+ * @param timeout wait time in milliseconds, or OS_FOREVER
+ *
+ * @return >=0 readable data length, < len only if write finished.
+ * @return -ETIMEDOUT timeout expired
+ * @return <0  other errors
+ */
+int stream_wait_length(io_stream_t handle, int len, int timeout);
+
 /**
  * @brief write to stream
  *
@@ -360,7 +378,14 @@ struct __stream {
 	/** total size*/
 	uint32_t total_size;
 
+	/** sem of blocked reader, given when read_wait_len is reached */
 	os_sem *sync_sem;
+	/** sem of blocked writer, given when write_wait_space is reached */
+	os_sem *space_sem;
+	/** readable length the blocked reader waits for, 0 if no reader waits */
+	uint32_t read_wait_len;
+	/** free space the blocked writer waits for, 0 if no writer waits */
+	uint32_t write_wait_space;
 
 	void *observer[2];
 	uint8_t  observer_type[2];
@@ -409,6 +434,19 @@ int stream_set_cache_size(io_stream_t handle, int size);
  */
 int stream_set_observer(io_stream_t handle, void *observer, stream_observer_notify notify, uint8_t type);
 
+/**
+ * @brief remove stream observer
+ *
+ * This routine provides remove stream observer added by stream_set_observer.
+ *
+ * @param handle handle of stream
+ * @param observer handle of observer
+ *
+ * @return 0 remove success
+ * @return !=0  observer not found
+ */
+int stream_clear_observer(io_stream_t handle, void *observer);
+
 /**
  * INTERNAL_HIDDEN @endcond
  */
@@ -44,12 +44,27 @@ struct slab_info
 #endif
 };
 
+#ifdef CONFIG_MEM_SLAB_STAT
+struct slabs_stat
+{
+	struct mem_slab_class_stat classes[CONFIG_SLAB_TOTAL_NUM];
+#if CONFIG_MEM_SLAB_STAT_CALLERS > 0
+	struct mem_slab_caller_stat callers[CONFIG_MEM_SLAB_STAT_CALLERS];
+#endif
+	uint32_t caller_miss;
+	uint32_t oversize_cnt;
+};
+#endif
+
 struct slabs_info
 {
 	uint16_t slab_num;
 	uint16_t slab_flag;
 	uint8_t * max_used;
 	uint16_t * max_size;
+#ifdef CONFIG_MEM_SLAB_STAT
+	struct slabs_stat * stat;
+#endif
 	struct slab_info slabs[CONFIG_SLAB_TOTAL_NUM];
 };
 
@@ -57,8 +72,10 @@ struct slabs_info
 
 void mem_slabs_init(struct slabs_info * slabs);
 void mem_slabs_free(struct slabs_info * slabs, void *ptr);
-void *mem_slabs_malloc(struct slabs_info * slabs, unsigned int num_bytes);
+void *mem_slabs_malloc(struct slabs_info * slabs, unsigned int num_bytes, void *caller);
 void mem_slabs_dump(struct slabs_info * slabs,int index);
+int mem_slabs_get_stat(struct slabs_info * slabs, void *buf, int size);
+void mem_slabs_dump_stat(struct slabs_info * slabs);
 #endif
 
 #ifdef CONFIG_APP_USED_MEM_PAGE
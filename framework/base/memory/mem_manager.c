@@ -10,6 +10,7 @@
  * @brief mem manager.
 */
 
+#include <errno.h>
 #include <mem_manager.h>
 #include "mem_inner.h"
 
@@ -19,9 +20,11 @@ void * app_mem_malloc(unsigned int num_bytes)
 	return malloc(num_bytes);
 #elif defined(CONFIG_APP_USED_MEM_SLAB)
 #ifdef CONFIG_APP_USED_SYSTEM_SLAB
-	return mem_slabs_malloc((struct slabs_info *)&sys_slab, num_bytes);
+	return mem_slabs_malloc((struct slabs_info *)&sys_slab, num_bytes,
+			__builtin_return_address(0));
 #else
-	return mem_slabs_malloc((struct slabs_info *)&app_slab, num_bytes);
+	return mem_slabs_malloc((struct slabs_info *)&app_slab, num_bytes,
+			__builtin_return_address(0));
 #endif
 #elif defined(CONFIG_APP_USED_MEM_PAGE)
 	return mem_page_malloc(num_bytes, __builtin_return_address(0));
@@ -36,9 +39,11 @@ void * app_mem_malloc_ext(unsigned int num_bytes, int malloc_tag)
 	return malloc(num_bytes);
 #elif defined(CONFIG_APP_USED_MEM_SLAB)
 #ifdef CONFIG_APP_USED_SYSTEM_SLAB
-	return mem_slabs_malloc((struct slabs_info *)&sys_slab, num_bytes);
+	return mem_slabs_malloc((struct slabs_info *)&sys_slab, num_bytes,
+			(void *)malloc_tag);
 #else
-	return mem_slabs_malloc((struct slabs_info *)&app_slab, num_bytes);
+	return mem_slabs_malloc((struct slabs_info *)&app_slab, num_bytes,
+			(void *)malloc_tag);
 #endif
 #elif defined(CONFIG_APP_USED_MEM_PAGE)
 	return mem_page_malloc(num_bytes, (void *)malloc_tag);
@@ -72,7 +77,7 @@ void *mem_malloc_debug(unsigned int num_bytes, void *caller)
 #ifdef CONFIG_SIMULATOR
 	return malloc(num_bytes);
 #elif defined(CONFIG_APP_USED_MEM_SLAB)
-	return mem_slabs_malloc((struct slabs_info *)&sys_slab, num_bytes);
+	return mem_slabs_malloc((struct slabs_info *)&sys_slab, num_bytes, caller);
 #elif defined(CONFIG_APP_USED_MEM_PAGE)
 	return mem_page_malloc(num_bytes,caller);
 #elif defined(CONFIG_APP_USED_MEM_POOL)
@@ -125,6 +130,24 @@ void mem_manager_dump_ext(int dump_detail, const char* match_value)
 #endif
 }
 
+int mem_manager_get_stat(void *buf, int size)
+{
+#if defined(CONFIG_APP_USED_MEM_SLAB) && defined(CONFIG_MEM_SLAB_STAT)
+	return mem_slabs_get_stat((struct slabs_info *)&sys_slab, buf, size);
+#else
+	return -ENOTSUP;
+#endif
+}
+
+void mem_manager_dump_stat(void)
+{
+#if defined(CONFIG_APP_USED_MEM_SLAB) && defined(CONFIG_MEM_SLAB_STAT)
+	mem_slabs_dump_stat((struct slabs_info *)&sys_slab);
+#else
+	/* nothing to do */
+#endif
+}
+
 int mem_manager_init(void)
 {
 #ifdef CONFIG_APP_USED_MEM_SLAB
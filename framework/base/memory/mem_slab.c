@@ -17,11 +17,16 @@
 #include <toolchain.h>
 #include <linker/sections.h>
 #include <string.h>
+#include <errno.h>
 
 struct k_mem_slab mem_slab[CONFIG_SLAB_TOTAL_NUM];
 uint8_t system_max_used[CONFIG_SLAB_TOTAL_NUM];
 uint16_t system_max_size[CONFIG_SLAB_TOTAL_NUM];
 
+#ifdef CONFIG_MEM_SLAB_STAT
+static struct slabs_stat system_slab_stat;
+#endif
+
 #ifdef CONFIG_USED_DYNAMIC_SLAB
 sys_slist_t dynamic_slab_list[CONFIG_SLAB_TOTAL_NUM];
 #endif
@@ -81,6 +86,9 @@ const struct  slabs_info sys_slab =
 	.max_used = system_max_used,
 	.max_size = system_max_size,
 	.slab_flag = SYSTEM_MEM_SLAB,
+#ifdef CONFIG_MEM_SLAB_STAT
+	.stat = &system_slab_stat,
+#endif
 	.slabs = {
 			 {
 				.slab = &mem_slab[0],
@@ -189,6 +197,71 @@ static int find_slab_by_addr(struct slabs_info * slabs, void * addr)
 	}
 	return target_slab_index;
 }
+
+#ifdef CONFIG_MEM_SLAB_STAT
+static void slab_stat_caller(struct slabs_info *slabs, void *caller,
+				unsigned int num_bytes, bool failed)
+{
+#if CONFIG_MEM_SLAB_STAT_CALLERS > 0
+	struct mem_slab_caller_stat *entry;
+	uint32_t hash = ((uint32_t)caller >> 1) % CONFIG_MEM_SLAB_STAT_CALLERS;
+	int i;
+
+	/* open addressing, callers are never removed from the table */
+	for (i = 0; i < CONFIG_MEM_SLAB_STAT_CALLERS; i++) {
+		entry = &slabs->stat->callers[hash];
+		if ((entry->alloc_cnt == 0 && entry->fail_cnt == 0)
+			|| entry->caller == caller) {
+			entry->caller = caller;
+			if (failed) {
+				entry->fail_cnt++;
+			} else {
+				entry->alloc_cnt++;
+				entry->alloc_bytes += num_bytes;
+			}
+			return;
+		}
+
+		if (++hash == CONFIG_MEM_SLAB_STAT_CALLERS)
+			hash = 0;
+	}
+#endif
+	slabs->stat->caller_miss++;
+}
+
+static void slab_stat_alloc(struct slabs_info *slabs, int slab_index,
+				unsigned int num_bytes, void *caller, void *block_ptr)
+{
+	struct mem_slab_class_stat *class_stat;
+
+	slab_stat_caller(slabs, caller, num_bytes, block_ptr == NULL);
+
+	if (slab_index >= slabs->slab_num) {
+		slabs->stat->oversize_cnt++;
+		return;
+	}
+
+	class_stat = &slabs->stat->classes[slab_index];
+	if (block_ptr == NULL) {
+		class_stat->fail_cnt++;
+		return;
+	}
+
+	class_stat->alloc_cnt++;
+	class_stat->req_bytes += num_bytes;
+
+	/* block sizes are in ascending order */
+	if (slab_index > 0 && slabs->slabs[slab_index - 1].block_size >= num_bytes)
+		class_stat->spill_cnt++;
+}
+
+static void slab_stat_free(struct slabs_info *slabs, int slab_index)
+{
+	if (slab_index >= 0 && slab_index < slabs->slab_num)
+		slabs->stat->classes[slab_index].free_cnt++;
+}
+#endif
+
 static void dump_mem_hex(struct slabs_info *slabs, int slab_index);
 static void* malloc_from_stable_slab(struct slabs_info * slabs,int slab_index)
 {
@@ -333,6 +406,11 @@ found_end:
 		}
 	}
 
+#ifdef CONFIG_MEM_SLAB_STAT
+	if (!free_to_parent)
+		slab_stat_free(slabs, slab_index);
+#endif
+
 	/*mem_free to slab 0 , remove busy flag for slab0*/
 	if(base_addr == ptr
 		&& ((uint32_t)slab->base_addr & SLAB0_BUSY) == SLAB0_BUSY)
@@ -425,6 +503,10 @@ begin_new_daynamic_slab:
 		}
 		goto begin_new_daynamic_slab;
 	}
+
+#ifdef CONFIG_MEM_SLAB_STAT
+	slabs->stat->classes[son_slab_index].promote_cnt++;
+#endif
 	return  true;
 
 err_end:
@@ -553,7 +635,7 @@ static void dump_mem_hex(struct slabs_info *slabs, int slab_index)
 
 }
 
-void * mem_slabs_malloc(struct slabs_info * slabs, unsigned int num_bytes)
+void * mem_slabs_malloc(struct slabs_info * slabs, unsigned int num_bytes, void *caller)
 {
 	void * block_ptr = NULL;
 	unsigned int key = irq_lock();
@@ -598,6 +680,9 @@ END:
 //		dump_stack();
 		SYS_LOG_ERR("Memory allocation failed , num_bytes %d ", num_bytes);
 	}
+#ifdef CONFIG_MEM_SLAB_STAT
+	slab_stat_alloc(slabs, slab_index, num_bytes, caller, block_ptr);
+#endif
 	irq_unlock(key);
 	return block_ptr;
 }
@@ -629,6 +714,9 @@ void mem_slabs_free(struct slabs_info * slabs, void *ptr)
 			SYS_LOG_ERR("Memory Free ERR ptr %p ", ptr);
 			goto exit;
 		}
+#ifdef CONFIG_MEM_SLAB_STAT
+		slab_stat_free(slabs, find_slab_by_addr(slabs, ptr));
+#endif
 
 #ifdef DEBUG
 		SYS_LOG_INF("Memory Free ptr %p ",ptr);
@@ -716,6 +804,108 @@ void mem_slabs_dump(struct slabs_info * slabs, int index)
 	}
 }
 
+#ifdef CONFIG_MEM_SLAB_STAT
+int mem_slabs_get_stat(struct slabs_info * slabs, void *buf, int size)
+{
+	struct mem_stat_head *head = buf;
+	struct mem_slab_class_stat *classes;
+	struct mem_slab_caller_stat *callers;
+	unsigned int key;
+	int caller_num = 0;
+	int len, i;
+
+	key = irq_lock();
+
+#if CONFIG_MEM_SLAB_STAT_CALLERS > 0
+	for (i = 0; i < CONFIG_MEM_SLAB_STAT_CALLERS; i++) {
+		if (slabs->stat->callers[i].alloc_cnt || slabs->stat->callers[i].fail_cnt)
+			caller_num++;
+	}
+#endif
+
+	len = sizeof(*head) + slabs->slab_num * sizeof(*classes)
+			+ caller_num * sizeof(*callers);
+	if (size < len) {
+		irq_unlock(key);
+		return -ENOMEM;
+	}
+
+	head->version = MEM_STAT_VERSION;
+	head->class_num = slabs->slab_num;
+	head->caller_num = caller_num;
+	head->reserved = 0;
+	head->uptime = k_uptime_get_32();
+	head->caller_miss = slabs->stat->caller_miss;
+	head->oversize_cnt = slabs->stat->oversize_cnt;
+
+	classes = (struct mem_slab_class_stat *)(head + 1);
+	for (i = 0; i < slabs->slab_num; i++) {
+		classes[i] = slabs->stat->classes[i];
+		classes[i].block_size = slabs->slabs[i].block_size;
+		classes[i].block_num = slabs->slabs[i].block_num;
+		classes[i].used = k_mem_slab_num_used_get(slabs->slabs[i].slab);
+		classes[i].max_used = slabs->max_used[i];
+		classes[i].max_size = slabs->max_size[i];
+	}
+
+	callers = (struct mem_slab_caller_stat *)(classes + slabs->slab_num);
+#if CONFIG_MEM_SLAB_STAT_CALLERS > 0
+	for (i = 0; i < CONFIG_MEM_SLAB_STAT_CALLERS; i++) {
+		if (slabs->stat->callers[i].alloc_cnt || slabs->stat->callers[i].fail_cnt)
+			*callers++ = slabs->stat->callers[i];
+	}
+#endif
+
+	irq_unlock(key);
+	return len;
+}
+
+void mem_slabs_dump_stat(struct slabs_info * slabs)
+{
+	struct mem_slab_class_stat *class_stat;
+	int peak_size = 0;
+	int total_size = 0;
+	int waste;
+
+	printk("slab stat: oversize %u, caller miss %u\n",
+			slabs->stat->oversize_cnt, slabs->stat->caller_miss);
+
+	for (int i = 0 ; i < slabs->slab_num; i++) {
+		class_stat = &slabs->stat->classes[i];
+
+		/* inner fragmentation: bytes of blocks not used by requests */
+		waste = 0;
+		if (class_stat->alloc_cnt) {
+			waste = 100 - (int)((uint64_t)class_stat->req_bytes * 100 /
+				((uint64_t)class_stat->alloc_cnt * slabs->slabs[i].block_size));
+		}
+
+		printk(" slab %d: size %4d num %3d max %3d alloc %6u free %6u"
+			" fail %4u spill %4u promote %3u waste %2d%%\n",
+			i, slabs->slabs[i].block_size, slabs->slabs[i].block_num,
+			slabs->max_used[i], class_stat->alloc_cnt, class_stat->free_cnt,
+			class_stat->fail_cnt, class_stat->spill_cnt,
+			class_stat->promote_cnt, waste);
+
+		peak_size += slabs->slabs[i].block_size * slabs->max_used[i];
+		total_size += slabs->slabs[i].block_size * slabs->slabs[i].block_num;
+	}
+
+	printk("slab peak %d bytes of %d bytes\n", peak_size, total_size);
+
+#if CONFIG_MEM_SLAB_STAT_CALLERS > 0
+	for (int i = 0; i < CONFIG_MEM_SLAB_STAT_CALLERS; i++) {
+		struct mem_slab_caller_stat *entry = &slabs->stat->callers[i];
+
+		if (entry->alloc_cnt || entry->fail_cnt) {
+			printk(" caller %p: alloc %6u bytes %8u fail %4u\n",
+				entry->caller, entry->alloc_cnt,
+				entry->alloc_bytes, entry->fail_cnt);
+		}
+	}
+#endif
+}
+#endif
 
 int mem_slab_init(void)
 {
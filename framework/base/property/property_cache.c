@@ -24,105 +24,294 @@
 #endif
 
 #define MAX_NVRAM_ITEM_CACHE_NUM  CONFIG_PROPERTY_CACHE_NUM
+#define PROPERTY_CACHE_NAME_SIZE  CONFIG_PROPERTY_CACHE_NAME_SIZE
+#define PROPERTY_CACHE_DATA_SIZE  CONFIG_PROPERTY_CACHE_DATA_SIZE
+
+/* hash buckets, power of 2 and at least the item num */
+#define PROPERTY_CACHE_HASH_SIZE  (1 << (32 - __builtin_clz(MAX_NVRAM_ITEM_CACHE_NUM - 1)))
+#define PROPERTY_CACHE_MAP_WORDS  ((MAX_NVRAM_ITEM_CACHE_NUM + 31) / 32)
+#define PROPERTY_CACHE_INVALID    0xff
+
+BUILD_ASSERT(MAX_NVRAM_ITEM_CACHE_NUM > 1 && MAX_NVRAM_ITEM_CACHE_NUM < PROPERTY_CACHE_INVALID,
+	     "invalid property cache num");
 
 struct cahce_item_data {
-	char *name;
-	char *data;
-	uint32_t data_len:16;
-	uint32_t used_flag:2;
-	uint32_t flush_req:1;
+	uint32_t hash;
+	uint32_t lru_stamp;
+	uint16_t data_len;
+	uint8_t used_flag;
+	/* next item in the same hash bucket */
+	uint8_t hash_next;
+	char name[PROPERTY_CACHE_NAME_SIZE];
+	char data[PROPERTY_CACHE_DATA_SIZE] __aligned(4);
 };
 
 OS_MUTEX_DEFINE(nvram_cache_mutex);
 
 static struct cahce_item_data globle_property_cache[MAX_NVRAM_ITEM_CACHE_NUM];
+static uint8_t property_cache_bucket[PROPERTY_CACHE_HASH_SIZE];
+/* item is modified and not written to nvram yet */
+static uint32_t property_cache_dirty_map[PROPERTY_CACHE_MAP_WORDS];
+/* item is requested to be flushed by property_cache_flush_req() */
+static uint32_t property_cache_flush_map[PROPERTY_CACHE_MAP_WORDS];
+static uint32_t property_cache_lru_clock;
 static uint8_t global_cache_need_flush;
+/* set while the cache itself writes nvram, under nvram_cache_mutex */
+static uint8_t property_cache_self_write;
 
-static struct cahce_item_data *find_property_cache(const char *name)
+static struct property_cache_stat property_cache_stat;
+
+static inline void cache_map_set(uint32_t *map, int idx)
 {
-	int i;
-	struct cahce_item_data *item = NULL;
+	map[idx / 32] |= (1u << (idx % 32));
+}
 
-	for (i = 0; i < MAX_NVRAM_ITEM_CACHE_NUM; i++) {
-		item = &globle_property_cache[i];
-		if (item->used_flag && !memcmp(item->name, name, strlen(name))) {
-			SYS_LOG_DBG(" %d %s", i, item->name);
+static inline void cache_map_clear(uint32_t *map, int idx)
+{
+	map[idx / 32] &= ~(1u << (idx % 32));
+}
+
+static inline bool cache_map_test(const uint32_t *map, int idx)
+{
+	return (map[idx / 32] & (1u << (idx % 32))) != 0;
+}
+
+/* FNV-1a */
+static uint32_t property_name_hash(const char *name)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*name) {
+		hash ^= (uint8_t)*name++;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static inline int property_cache_index(struct cahce_item_data *item)
+{
+	return item - globle_property_cache;
+}
+
+static void property_cache_touch(struct cahce_item_data *item)
+{
+	item->lru_stamp = ++property_cache_lru_clock;
+}
+
+static struct cahce_item_data *find_property_cache(const char *name, uint32_t hash)
+{
+	struct cahce_item_data *item;
+	uint8_t idx;
+
+	idx = property_cache_bucket[hash & (PROPERTY_CACHE_HASH_SIZE - 1)];
+
+	while (idx != PROPERTY_CACHE_INVALID) {
+		item = &globle_property_cache[idx];
+		if (item->hash == hash && !strcmp(item->name, name)) {
+			SYS_LOG_DBG(" %d %s", idx, item->name);
 			return item;
 		}
+		idx = item->hash_next;
 	}
+
 	return NULL;
 }
 
-static struct cahce_item_data *get_property_cache(const char *name, int len)
+static void property_cache_unlink(struct cahce_item_data *item)
 {
+	uint8_t *pidx;
+	int idx = property_cache_index(item);
+
+	pidx = &property_cache_bucket[item->hash & (PROPERTY_CACHE_HASH_SIZE - 1)];
+
+	while (*pidx != PROPERTY_CACHE_INVALID) {
+		if (*pidx == idx) {
+			*pidx = item->hash_next;
+			break;
+		}
+		pidx = &globle_property_cache[*pidx].hash_next;
+	}
+
+	item->used_flag = 0;
+	item->hash_next = PROPERTY_CACHE_INVALID;
+	cache_map_clear(property_cache_dirty_map, idx);
+	cache_map_clear(property_cache_flush_map, idx);
+}
+
+#ifdef CONFIG_NVRAM_CONFIG
+static int property_cache_nvram_set(const char *name, const void *data, int len)
+{
+	int ret;
+
+	property_cache_self_write = 1;
+	ret = nvram_config_set(name, data, len);
+	property_cache_self_write = 0;
+
+	return ret;
+}
+
+/* config written to nvram without the cache, drop the stale cached copy */
+static void property_cache_nvram_set_cb(const char *name)
+{
+	struct cahce_item_data *item;
+	int i;
+
+	os_mutex_lock(&nvram_cache_mutex, OS_FOREVER);
+
+	if (property_cache_self_write)
+		goto exit;
+
+	if (name) {
+		item = find_property_cache(name, property_name_hash(name));
+		if (item)
+			property_cache_unlink(item);
+	} else {
+		for (i = 0; i < MAX_NVRAM_ITEM_CACHE_NUM; i++) {
+			if (globle_property_cache[i].used_flag)
+				property_cache_unlink(&globle_property_cache[i]);
+		}
+	}
+
+exit:
+	os_mutex_unlock(&nvram_cache_mutex);
+}
+#endif
+
+static int property_cache_write_back(struct cahce_item_data *item)
+{
+	int ret = 0;
+	int idx = property_cache_index(item);
+
+	if (!cache_map_test(property_cache_dirty_map, idx))
+		return 0;
+
+#ifdef CONFIG_NVRAM_CONFIG
+	ret = property_cache_nvram_set(item->name, item->data, item->data_len);
+#endif
+	if (!ret) {
+		cache_map_clear(property_cache_dirty_map, idx);
+		property_cache_stat.write_backs++;
+	}
+
+	return ret;
+}
+
+/*
+ * get a free item, or evict the least recently used one, clean items first.
+ * a dirty item is only evicted if allow_dirty, and written to nvram before.
+ */
+static struct cahce_item_data *get_property_cache(bool allow_dirty)
+{
+	struct cahce_item_data *item, *victim = NULL, *dirty_victim = NULL;
 	int i;
-	struct cahce_item_data *item = NULL;
 
 	for (i = 0; i < MAX_NVRAM_ITEM_CACHE_NUM; i++) {
 		item = &globle_property_cache[i];
-		if (!item->used_flag) {
-			item->name = mem_malloc(strlen(name) + 1);
-			if (!item->name) {
-				item = NULL;
-				goto exit;
-			}
-			memset(item->name, 0, strlen(name) + 1);
-			item->data = mem_malloc(len);
-			if (!item->data) {
-				mem_free(item->name);
-				item = NULL;
-				goto exit;
-			}
-			memset(item->data, 0, len);
-exit:
+		if (!item->used_flag)
 			return item;
+
+		if (cache_map_test(property_cache_dirty_map, i)) {
+			if (!dirty_victim || (int32_t)(item->lru_stamp - dirty_victim->lru_stamp) < 0)
+				dirty_victim = item;
+		} else {
+			if (!victim || (int32_t)(item->lru_stamp - victim->lru_stamp) < 0)
+				victim = item;
 		}
 	}
-	return NULL;
+
+	if (!victim && allow_dirty && dirty_victim) {
+		if (!property_cache_write_back(dirty_victim))
+			victim = dirty_victim;
+	}
+
+	if (victim) {
+		SYS_LOG_DBG("evict %s", victim->name);
+		property_cache_unlink(victim);
+		property_cache_stat.evictions++;
+	}
+
+	return victim;
 }
 
-static int put_property_cache(struct cahce_item_data *item)
+static void put_property_cache(struct cahce_item_data *item, const char *name, uint32_t hash)
 {
-	if (item) {
-		if (item->data) {
-			mem_free(item->data);
-		}
-		if (item->name) {
-			mem_free(item->name);
-		}
-		item->data = NULL;
-		item->name = NULL;
-		item->used_flag = 0;
-		item->data_len = 0;
-		item->flush_req = 0;
-	}
-	return 0;
+	int bucket = hash & (PROPERTY_CACHE_HASH_SIZE - 1);
+
+	strcpy(item->name, name);
+	item->hash = hash;
+	item->used_flag = 1;
+	item->hash_next = property_cache_bucket[bucket];
+	property_cache_bucket[bucket] = property_cache_index(item);
+	property_cache_touch(item);
+}
+
+static bool property_cache_cacheable(const char *name, int len)
+{
+	return (strlen(name) < PROPERTY_CACHE_NAME_SIZE && len <= PROPERTY_CACHE_DATA_SIZE);
 }
 
 int property_cache_get(const char *name, void *data, int len)
 {
 	int read_len = 0;
+	uint32_t hash;
 	struct cahce_item_data *item = NULL;
+	char fill_buf[PROPERTY_CACHE_DATA_SIZE] __aligned(4);
+
+	hash = property_name_hash(name);
 
 	os_mutex_lock(&nvram_cache_mutex, OS_FOREVER);
 
-	item = find_property_cache(name);
+	item = find_property_cache(name, hash);
 
 	/**read from nvram cache */
 	if (item) {
+		property_cache_stat.hits++;
+		property_cache_touch(item);
+
+		/* deleted config, as nvram_config_get() reports it */
+		if (!item->data_len) {
+			read_len = -ENOENT;
+			goto exit;
+		}
+
 		if (item->data_len > len) {
 			read_len = len;
 		} else {
 			read_len = item->data_len;
 		}
 		memcpy(data, item->data, read_len);
-	} else {
+		goto exit;
+	}
+
+	property_cache_stat.misses++;
+
 #ifdef CONFIG_NVRAM_CONFIG
-		/** read from nvram*/
+	/** read from nvram, keep it in cache if a clean item is available */
+	if (!property_cache_cacheable(name, 0) || len > PROPERTY_CACHE_DATA_SIZE) {
 		read_len = nvram_config_get(name, data, len);
-#endif
+		goto exit;
+	}
+
+	read_len = nvram_config_get(name, fill_buf, PROPERTY_CACHE_DATA_SIZE);
+	if (read_len < 0)
+		goto exit;
+
+	/* data may be truncated if it fills the buffer, do not cache it */
+	if (read_len < PROPERTY_CACHE_DATA_SIZE) {
+		item = get_property_cache(false);
+		if (item) {
+			memcpy(item->data, fill_buf, read_len);
+			item->data_len = read_len;
+			put_property_cache(item, name, hash);
+		}
 	}
 
+	read_len = MIN(read_len, len);
+	memcpy(data, fill_buf, read_len);
+#endif
+
+exit:
 	os_mutex_unlock(&nvram_cache_mutex);
 
 	return read_len;
@@ -131,48 +320,40 @@ int property_cache_get(const char *name, void *data, int len)
 int property_cache_set(const char *name, const void *data, int len)
 {
 	int ret = 0;
+	uint32_t hash;
 	struct cahce_item_data *item = NULL;
 
+	hash = property_name_hash(name);
+
 	os_mutex_lock(&nvram_cache_mutex, OS_FOREVER);
 
-	item = find_property_cache(name);
-	/**write to old nvram cache */
-	if (item) {
-		if (item->data_len == len) {
-			memcpy(item->data, data, len);
-			ret = 0;
-		} else {
-			void *old_data = item->data;
+	item = find_property_cache(name, hash);
 
-			item->data = mem_malloc(len);
-			memcpy(item->data, data, len);
-			item->data_len = len;
-			ret = 0;
-			mem_free(old_data);
-		}
-		goto exit;
+	if (!property_cache_cacheable(name, len)) {
+		/* too large for cache item, drop the cached copy */
+		if (item)
+			property_cache_unlink(item);
+		goto direct_write;
 	}
 
-	/**write to new nvram cache */
-	item = get_property_cache(name, len);
-	if (item) {
-		/** new item */
-		memcpy(item->name, name, strlen(name));
-		memcpy(item->data, data, len);
-		item->data_len = len;
-		item->used_flag = 1;
-		ret = 0;
-		goto exit;
-	}
+	/**write to old nvram cache */
+	if (!item) {
+		/**write to new nvram cache */
+		item = get_property_cache(true);
+		if (!item)
+			goto direct_write;
 
-	int i;
-	for (i = 0; i < MAX_NVRAM_ITEM_CACHE_NUM; i++) {
-		item = &globle_property_cache[i];
-		if (item->used_flag) {
-			LOG_INF(" %d %s", i, item->name);
-		}
+		put_property_cache(item, name, hash);
+	} else {
+		property_cache_touch(item);
 	}
 
+	memcpy(item->data, data, len);
+	item->data_len = len;
+	cache_map_set(property_cache_dirty_map, property_cache_index(item));
+	goto exit;
+
+direct_write:
 	/** direct write to nvram*/
 	SYS_LOG_INF("direct write to nvram\n");
 
@@ -181,54 +362,129 @@ int property_cache_set(const char *name, const void *data, int len)
 	#ifdef CONFIG_DVFS_DYNAMIC_LEVEL
 	dvfs_set_level(DVFS_LEVEL_HIGH_PERFORMANCE, "property");
 	#endif
-	
-	ret = nvram_config_set(name, data, len);
-	
+
+	ret = property_cache_nvram_set(name, data, len);
+
 	#ifdef CONFIG_DVFS_DYNAMIC_LEVEL
 	dvfs_unset_level(DVFS_LEVEL_HIGH_PERFORMANCE, "property");
 	#endif
-	
-#endif
-
 
+#endif
 
 exit:
 	os_mutex_unlock(&nvram_cache_mutex);
 	return ret;
 }
 
-int property_cache_flush(const char *name)
+/*
+ * write back dirty items selected by map (all dirty items if map is NULL) in
+ * one batch. Inside the batch nvram_config_set() only journals the items, so
+ * they stay dirty until the batch is committed and the selected map is only
+ * cleared then. Returns the number of items written or a negative errno.
+ */
+static int property_cache_flush_dirty(uint32_t *map)
 {
-	int i;
-	struct cahce_item_data *item = NULL;
+	uint32_t written[PROPERTY_CACHE_MAP_WORDS];
+	struct cahce_item_data *item;
+	uint32_t bits;
+	int i, w, num = 0, ret = 0, err;
 
-#ifdef CONFIG_DVFS_DYNAMIC_LEVEL
-	dvfs_set_level(DVFS_LEVEL_HIGH_PERFORMANCE, "property");
+#ifdef CONFIG_NVRAM_CONFIG
+	/*
+	 * begin the batch before taking the cache lock, nvram_config_set() of
+	 * another batch owner takes the cache lock in its set callback
+	 */
+	nvram_config_batch_begin();
 #endif
 
 	os_mutex_lock(&nvram_cache_mutex, OS_FOREVER);
 
-	for (i = 0; i < MAX_NVRAM_ITEM_CACHE_NUM; i++) {
-		item = &globle_property_cache[i];
-		if (item->used_flag &&
-	     ((!name) || memcmp(item->name, name, strlen(name)) == 0)) {
+	memset(written, 0, sizeof(written));
+
+	for (w = 0; w < PROPERTY_CACHE_MAP_WORDS; w++) {
+		bits = property_cache_dirty_map[w];
+		if (map)
+			bits &= map[w];
+
+		while (bits) {
+			i = w * 32 + __builtin_ctz(bits);
+			bits &= bits - 1;
+
+			item = &globle_property_cache[i];
 #ifdef CONFIG_NVRAM_CONFIG
-			if (!nvram_config_set(item->name, item->data, item->data_len)) {
-				put_property_cache(item);
-				item->flush_req = false;
-			}
+			err = property_cache_nvram_set(item->name, item->data, item->data_len);
+#else
+			err = 0;
 #endif
+			if (err) {
+				if (!ret)
+					ret = err;
+				continue;
+			}
 
+			LOG_INF(" %d %s", i, item->name);
+			cache_map_set(written, i);
+			num++;
 		}
 	}
 
+#ifdef CONFIG_NVRAM_CONFIG
+	err = nvram_config_batch_commit();
+	if (err) {
+		/* nothing persistent, keep the items dirty */
+		SYS_LOG_ERR("commit %d items err %d", num, err);
+		os_mutex_unlock(&nvram_cache_mutex);
+		return err;
+	}
+#endif
+
+	for (w = 0; w < PROPERTY_CACHE_MAP_WORDS; w++)
+		property_cache_dirty_map[w] &= ~written[w];
+
+	property_cache_stat.write_backs += num;
+	if (num)
+		property_cache_stat.flushes++;
+
+	if (map && !ret)
+		memset(map, 0, sizeof(uint32_t) * PROPERTY_CACHE_MAP_WORDS);
+
 	os_mutex_unlock(&nvram_cache_mutex);
-	SYS_LOG_INF("ok\n");
+
+	return ret ? ret : num;
+}
+
+int property_cache_flush(const char *name)
+{
+	uint32_t map[PROPERTY_CACHE_MAP_WORDS];
+	struct cahce_item_data *item;
+	int ret = 0;
+
+#ifdef CONFIG_DVFS_DYNAMIC_LEVEL
+	dvfs_set_level(DVFS_LEVEL_HIGH_PERFORMANCE, "property");
+#endif
+
+	if (!name) {
+		ret = property_cache_flush_dirty(NULL);
+	} else {
+		memset(map, 0, sizeof(map));
+
+		os_mutex_lock(&nvram_cache_mutex, OS_FOREVER);
+		item = find_property_cache(name, property_name_hash(name));
+		if (item)
+			cache_map_set(map, property_cache_index(item));
+		os_mutex_unlock(&nvram_cache_mutex);
+
+		/* the item may be gone meanwhile, then it is not dirty */
+		if (item)
+			ret = property_cache_flush_dirty(map);
+	}
+
+	SYS_LOG_INF("ret %d\n", ret);
 #ifdef CONFIG_DVFS_DYNAMIC_LEVEL
 	dvfs_unset_level(DVFS_LEVEL_HIGH_PERFORMANCE, "property");
 #endif
 
-	return 0;
+	return (ret < 0) ? ret : 0;
 }
 
 int property_cache_flush_req(const char *name)
@@ -239,11 +495,16 @@ int property_cache_flush_req(const char *name)
 
 	os_mutex_lock(&nvram_cache_mutex, OS_FOREVER);
 
-	for (i = 0; i < MAX_NVRAM_ITEM_CACHE_NUM; i++) {
-		item = &globle_property_cache[i];
-		if (item->used_flag &&
-	     ((!name) || memcmp(item->name, name, strlen(name)) == 0)) {
-			item->flush_req = true;
+	if (!name) {
+		for (i = 0; i < PROPERTY_CACHE_MAP_WORDS; i++) {
+			property_cache_flush_map[i] |= property_cache_dirty_map[i];
+			if (property_cache_dirty_map[i])
+				real_req = 1;
+		}
+	} else {
+		item = find_property_cache(name, property_name_hash(name));
+		if (item && cache_map_test(property_cache_dirty_map, property_cache_index(item))) {
+			cache_map_set(property_cache_flush_map, property_cache_index(item));
 			real_req = 1;
 		}
 	}
@@ -258,57 +519,103 @@ int property_cache_flush_req(const char *name)
 
 int property_cache_flush_req_deal(void)
 {
-	int i;
-	struct cahce_item_data *item = NULL;
 	int real_deal = 0;
 	uint32_t start_time, cost_time;
 
-	if (global_cache_need_flush)
-	{
+	if (!global_cache_need_flush)
+		return 0;
+
 #ifdef CONFIG_DVFS_DYNAMIC_LEVEL
-		dvfs_set_level(DVFS_LEVEL_HIGH_PERFORMANCE, "property");
+	dvfs_set_level(DVFS_LEVEL_HIGH_PERFORMANCE, "property");
 #endif
-	}
 
-	os_mutex_lock(&nvram_cache_mutex, OS_FOREVER);
+	start_time = k_cycle_get_32();
+	/* clears the flush map once written */
+	real_deal = property_cache_flush_dirty(property_cache_flush_map);
+	cost_time = k_cyc_to_us_floor32(k_cycle_get_32() - start_time);
 
-	for (i = 0; i < MAX_NVRAM_ITEM_CACHE_NUM; i++) {
-		item = &globle_property_cache[i];
-		if (item->used_flag && item->flush_req) {
-#ifdef CONFIG_NVRAM_CONFIG
-			start_time = k_cycle_get_32();
-			if (!nvram_config_set(item->name, item->data, item->data_len)) {
-				cost_time = k_cyc_to_us_floor32(k_cycle_get_32() - start_time);
-				LOG_INF(" %d %s  run %d us", i, item->name, cost_time);
-				put_property_cache(item);
-			}
-#endif
-			item->flush_req = false;
-			real_deal = 1;
-		}
+	if (real_deal > 0){
+		SYS_LOG_INF("flush %d ok, run %d us\n", real_deal, cost_time);
 	}
-	os_mutex_unlock(&nvram_cache_mutex);
 
-	if (real_deal){
-		SYS_LOG_INF("flush ok\n");
-	}
-	
-	if (global_cache_need_flush)
-	{
 #ifdef CONFIG_DVFS_DYNAMIC_LEVEL
-		dvfs_unset_level(DVFS_LEVEL_HIGH_PERFORMANCE, "property");
+	dvfs_unset_level(DVFS_LEVEL_HIGH_PERFORMANCE, "property");
 #endif
-		global_cache_need_flush = 0;
+
+	/* on error keep the request, it is dealt again later */
+	if (real_deal < 0)
+		return real_deal;
+
+	global_cache_need_flush = 0;
+
+	return 0;
+}
+
+int property_cache_get_stat(struct property_cache_stat *stat)
+{
+	int i;
+
+	os_mutex_lock(&nvram_cache_mutex, OS_FOREVER);
+
+	memcpy(stat, &property_cache_stat, sizeof(*stat));
+
+	stat->used = 0;
+	stat->dirty = 0;
+	for (i = 0; i < MAX_NVRAM_ITEM_CACHE_NUM; i++) {
+		if (globle_property_cache[i].used_flag)
+			stat->used++;
+		if (cache_map_test(property_cache_dirty_map, i))
+			stat->dirty++;
 	}
 
-	
+	os_mutex_unlock(&nvram_cache_mutex);
+
 	return 0;
 }
 
+void property_cache_dump(void)
+{
+	struct property_cache_stat stat;
+	int i;
+
+	property_cache_get_stat(&stat);
+
+	printk("property cache: %d/%d used, %d dirty\n", stat.used,
+		MAX_NVRAM_ITEM_CACHE_NUM, stat.dirty);
+	printk("hits %u misses %u evictions %u write_backs %u flushes %u\n",
+		stat.hits, stat.misses, stat.evictions, stat.write_backs, stat.flushes);
+
+	os_mutex_lock(&nvram_cache_mutex, OS_FOREVER);
+	for (i = 0; i < MAX_NVRAM_ITEM_CACHE_NUM; i++) {
+		if (globle_property_cache[i].used_flag) {
+			printk("[%2d] %s len %d%s\n", i, globle_property_cache[i].name,
+				globle_property_cache[i].data_len,
+				cache_map_test(property_cache_dirty_map, i) ? " dirty" : "");
+		}
+	}
+	os_mutex_unlock(&nvram_cache_mutex);
+}
+
 int property_cache_init(void)
 {
+	int i;
+
 	memset(globle_property_cache, 0, sizeof(globle_property_cache));
+	memset(property_cache_bucket, PROPERTY_CACHE_INVALID, sizeof(property_cache_bucket));
+	memset(property_cache_dirty_map, 0, sizeof(property_cache_dirty_map));
+	memset(property_cache_flush_map, 0, sizeof(property_cache_flush_map));
+	memset(&property_cache_stat, 0, sizeof(property_cache_stat));
+
+	for (i = 0; i < MAX_NVRAM_ITEM_CACHE_NUM; i++)
+		globle_property_cache[i].hash_next = PROPERTY_CACHE_INVALID;
+
+	property_cache_lru_clock = 0;
 	global_cache_need_flush = 0;
-	
+	property_cache_self_write = 0;
+
+#ifdef CONFIG_NVRAM_CONFIG
+	nvram_config_set_callback(property_cache_nvram_set_cb);
+#endif
+
 	return 0;
 }
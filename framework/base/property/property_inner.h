@@ -17,6 +17,18 @@
 
 #ifdef CONFIG_PROPERTY_CACHE
 
+struct property_cache_stat {
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t evictions;
+	/* dirty items written to nvram */
+	uint32_t write_backs;
+	/* flush batches */
+	uint32_t flushes;
+	uint16_t used;
+	uint16_t dirty;
+};
+
 int property_cache_get(const char *name, void *data, int len);
 
 int property_cache_set(const char *name, const void *data, int len);
@@ -29,6 +41,10 @@ int property_cache_flush_req_deal(void);
 
 int property_cache_init(void);
 
+int property_cache_get_stat(struct property_cache_stat *stat);
+
+void property_cache_dump(void);
+
 #endif
 
 #endif
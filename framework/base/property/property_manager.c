@@ -191,9 +191,10 @@ int property_set_int_array(const char *key, int *value, int value_len)
 int property_flush(const char *key)
 {
 #ifdef CONFIG_PROPERTY_CACHE
-	property_cache_flush(key);
-#endif
+	return property_cache_flush(key);
+#else
 	return 0;
+#endif
 }
 
 int property_flush_req(const char *key)
@@ -207,11 +208,18 @@ int property_flush_req(const char *key)
 int property_flush_req_deal(void)
 {
 #ifdef CONFIG_PROPERTY_CACHE
-	property_cache_flush_req_deal();
-#endif
+	return property_cache_flush_req_deal();
+#else
 	return 0;
+#endif
 }
 
+void property_dump(void)
+{
+#ifdef CONFIG_PROPERTY_CACHE
+	property_cache_dump();
+#endif
+}
 
 int property_manager_init(void)
 {
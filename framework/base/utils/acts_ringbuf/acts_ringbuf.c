@@ -82,24 +82,44 @@ void acts_ringbuf_free(struct acts_ringbuf *buf)
 	}
 }
 
+static uint32_t ringbuf_span(uint32_t cpu_ptr, uint32_t buf_size, uint32_t offset,
+		struct acts_ringbuf_iovec iov[2], uint32_t size)
+{
+	uint32_t len = buf_size - offset;
+
+	iov[0].base = (void *)(cpu_ptr + ACTS_RINGBUF_SIZE8(offset));
+	if (len >= size) {
+		iov[0].len = size;
+		iov[1].base = NULL;
+		iov[1].len = 0;
+	} else {
+		iov[0].len = len;
+		iov[1].base = (void *)(cpu_ptr);
+		iov[1].len = size - len;
+	}
+
+	return size;
+}
+
+static inline uint32_t acts_ringbuf_span(struct acts_ringbuf *buf, uint32_t offset,
+		struct acts_ringbuf_iovec iov[2], uint32_t size)
+{
+	return ringbuf_span(buf->cpu_ptr, buf->size, offset, iov, size);
+}
+
 uint32_t acts_ringbuf_peek(struct acts_ringbuf *buf, void *data, uint32_t size)
 {
-	uint32_t offset, len;
+	struct acts_ringbuf_iovec iov[2];
 
-	len = acts_ringbuf_length(buf);
-	if (size > len)
+	if (size > acts_ringbuf_length(buf))
 		return 0;
 
-	offset = buf->head_offset;
-
-	len = buf->size - offset;
 	if (data) {
-		if (len >= size) {
-			memcpy(data, (void *)(buf->cpu_ptr + ACTS_RINGBUF_SIZE8(offset)), ACTS_RINGBUF_SIZE8(size));
-		} else {
-			memcpy(data, (void *)(buf->cpu_ptr + ACTS_RINGBUF_SIZE8(offset)), ACTS_RINGBUF_SIZE8(len));
-			memcpy((uint8_t *)data + ACTS_RINGBUF_SIZE8(len), (void *)(buf->cpu_ptr), ACTS_RINGBUF_SIZE8(size - len));
-		}
+		acts_ringbuf_span(buf, buf->head_offset, iov, size);
+		memcpy(data, iov[0].base, ACTS_RINGBUF_SIZE8(iov[0].len));
+		if (iov[1].len)
+			memcpy((uint8_t *)data + ACTS_RINGBUF_SIZE8(iov[0].len), iov[1].base,
+					ACTS_RINGBUF_SIZE8(iov[1].len));
 	}
 
 	return size;
@@ -117,19 +137,28 @@ uint32_t acts_ringbuf_get(struct acts_ringbuf *buf, void *data, uint32_t size)
 
 uint32_t acts_ringbuf_get_claim(struct acts_ringbuf *buf, void **data, uint32_t size)
 {
-	uint32_t offset = buf->head_offset;
-	uint32_t max_size = min(buf->size - offset, acts_ringbuf_length(buf));
+	struct acts_ringbuf_iovec iov[2];
+
+	acts_ringbuf_get_claim_iov(buf, iov, size);
 
-	*data = (void *)(buf->cpu_ptr + ACTS_RINGBUF_SIZE8(offset));
-	return (size <= max_size) ? size : max_size;
+	*data = iov[0].base;
+	return iov[0].len;
 }
 
-int acts_ringbuf_get_finish(struct acts_ringbuf *buf, uint32_t size)
+uint32_t acts_ringbuf_get_claim_iov(struct acts_ringbuf *buf,
+		struct acts_ringbuf_iovec iov[2], uint32_t size)
 {
-	uint32_t offset = buf->head_offset;
-	uint32_t max_size = min(buf->size - offset, acts_ringbuf_length(buf));
+	uint32_t length = acts_ringbuf_length(buf);
+
+	if (size > length)
+		size = length;
+
+	return acts_ringbuf_span(buf, buf->head_offset, iov, size);
+}
 
-	if (size > max_size)
+int acts_ringbuf_get_finish(struct acts_ringbuf *buf, uint32_t size)
+{
+	if (size > acts_ringbuf_length(buf))
 		return -EINVAL;
 
 	buf->head += size;
@@ -141,22 +170,17 @@ int acts_ringbuf_get_finish(struct acts_ringbuf *buf, uint32_t size)
 
 uint32_t acts_ringbuf_put(struct acts_ringbuf *buf, const void *data, uint32_t size)
 {
-	uint32_t offset, len;
+	struct acts_ringbuf_iovec iov[2];
 
-	len = acts_ringbuf_space(buf);
-	if (size > len)
+	if (size > acts_ringbuf_space(buf))
 		return 0;
 
-	offset = buf->tail_offset;
-
-	len = buf->size - offset;
 	if (data) {
-		if (len >= size) {
-			memcpy((void *)(buf->cpu_ptr + ACTS_RINGBUF_SIZE8(offset)), data, ACTS_RINGBUF_SIZE8(size));
-		} else {
-			memcpy((void *)(buf->cpu_ptr + ACTS_RINGBUF_SIZE8(offset)), data, ACTS_RINGBUF_SIZE8(len));
-			memcpy((void *)(buf->cpu_ptr), (uint8_t *)data + ACTS_RINGBUF_SIZE8(len), ACTS_RINGBUF_SIZE8(size - len));
-		}
+		acts_ringbuf_span(buf, buf->tail_offset, iov, size);
+		memcpy(iov[0].base, data, ACTS_RINGBUF_SIZE8(iov[0].len));
+		if (iov[1].len)
+			memcpy(iov[1].base, (uint8_t *)data + ACTS_RINGBUF_SIZE8(iov[0].len),
+					ACTS_RINGBUF_SIZE8(iov[1].len));
 	}
 
 	buf->tail += size;
@@ -168,19 +192,28 @@ uint32_t acts_ringbuf_put(struct acts_ringbuf *buf, const void *data, uint32_t s
 
 uint32_t acts_ringbuf_put_claim(struct acts_ringbuf *buf, void **data, uint32_t size)
 {
-	uint32_t offset = buf->tail_offset;
-	uint32_t max_size = min(buf->size - offset, acts_ringbuf_space(buf));
+	struct acts_ringbuf_iovec iov[2];
+
+	acts_ringbuf_put_claim_iov(buf, iov, size);
 
-	*data = (void *)(buf->cpu_ptr + ACTS_RINGBUF_SIZE8(offset));
-	return (size <= max_size) ? size : max_size;
+	*data = iov[0].base;
+	return iov[0].len;
 }
 
-int acts_ringbuf_put_finish(struct acts_ringbuf *buf, uint32_t size)
+uint32_t acts_ringbuf_put_claim_iov(struct acts_ringbuf *buf,
+		struct acts_ringbuf_iovec iov[2], uint32_t size)
 {
-	uint32_t offset = buf->tail_offset;
-	uint32_t max_size = min(buf->size - offset, acts_ringbuf_space(buf));
+	uint32_t space = acts_ringbuf_space(buf);
+
+	if (size > space)
+		size = space;
+
+	return acts_ringbuf_span(buf, buf->tail_offset, iov, size);
+}
 
-	if (size > max_size)
+int acts_ringbuf_put_finish(struct acts_ringbuf *buf, uint32_t size)
+{
+	if (size > acts_ringbuf_space(buf))
 		return -EINVAL;
 
 	buf->tail += size;
@@ -437,6 +470,113 @@ out_exit:
 	buf->head_offset = 0;
 }
 
+int acts_ringbuf_spsc_init(struct acts_ringbuf_spsc *buf, void *data, uint32_t size)
+{
+	buf->size = size;
+	buf->cpu_ptr = (uint32_t)data;
+	buf->head = 0;
+	buf->head_offset = 0;
+	buf->tail = 0;
+	buf->tail_offset = 0;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	return 0;
+}
+
+uint32_t acts_ringbuf_spsc_put_claim_iov(struct acts_ringbuf_spsc *buf,
+		struct acts_ringbuf_iovec iov[2], uint32_t size)
+{
+	/* acquire: consumer has finished reading the space before we reuse it */
+	uint32_t space = buf->size - (buf->tail - __atomic_load_n(&buf->head, __ATOMIC_ACQUIRE));
+
+	if (size > space)
+		size = space;
+
+	return ringbuf_span(buf->cpu_ptr, buf->size, buf->tail_offset, iov, size);
+}
+
+int acts_ringbuf_spsc_put_finish(struct acts_ringbuf_spsc *buf, uint32_t size)
+{
+	uint32_t offset;
+
+	if (size > buf->size - (buf->tail - __atomic_load_n(&buf->head, __ATOMIC_ACQUIRE)))
+		return -EINVAL;
+
+	offset = buf->tail_offset + size;
+	if (offset >= buf->size)
+		offset -= buf->size;
+	buf->tail_offset = offset;
+
+	/* release: data is visible before the new tail */
+	__atomic_store_n(&buf->tail, buf->tail + size, __ATOMIC_RELEASE);
+	return 0;
+}
+
+uint32_t acts_ringbuf_spsc_put(struct acts_ringbuf_spsc *buf, const void *data, uint32_t size)
+{
+	struct acts_ringbuf_iovec iov[2];
+
+	if (acts_ringbuf_spsc_put_claim_iov(buf, iov, size) != size)
+		return 0;
+
+	if (data) {
+		memcpy(iov[0].base, data, ACTS_RINGBUF_SIZE8(iov[0].len));
+		if (iov[1].len)
+			memcpy(iov[1].base, (uint8_t *)data + ACTS_RINGBUF_SIZE8(iov[0].len),
+					ACTS_RINGBUF_SIZE8(iov[1].len));
+	}
+
+	acts_ringbuf_spsc_put_finish(buf, size);
+	return size;
+}
+
+uint32_t acts_ringbuf_spsc_get_claim_iov(struct acts_ringbuf_spsc *buf,
+		struct acts_ringbuf_iovec iov[2], uint32_t size)
+{
+	/* acquire: producer data is visible once the tail is seen */
+	uint32_t length = __atomic_load_n(&buf->tail, __ATOMIC_ACQUIRE) - buf->head;
+
+	if (size > length)
+		size = length;
+
+	return ringbuf_span(buf->cpu_ptr, buf->size, buf->head_offset, iov, size);
+}
+
+int acts_ringbuf_spsc_get_finish(struct acts_ringbuf_spsc *buf, uint32_t size)
+{
+	uint32_t offset;
+
+	if (size > __atomic_load_n(&buf->tail, __ATOMIC_ACQUIRE) - buf->head)
+		return -EINVAL;
+
+	offset = buf->head_offset + size;
+	if (offset >= buf->size)
+		offset -= buf->size;
+	buf->head_offset = offset;
+
+	/* release: data reads complete before the space is handed back */
+	__atomic_store_n(&buf->head, buf->head + size, __ATOMIC_RELEASE);
+	return 0;
+}
+
+uint32_t acts_ringbuf_spsc_get(struct acts_ringbuf_spsc *buf, void *data, uint32_t size)
+{
+	struct acts_ringbuf_iovec iov[2];
+
+	if (acts_ringbuf_spsc_get_claim_iov(buf, iov, size) != size)
+		return 0;
+
+	if (data) {
+		memcpy(data, iov[0].base, ACTS_RINGBUF_SIZE8(iov[0].len));
+		if (iov[1].len)
+			memcpy((uint8_t *)data + ACTS_RINGBUF_SIZE8(iov[0].len), iov[1].base,
+					ACTS_RINGBUF_SIZE8(iov[1].len));
+	}
+
+	acts_ringbuf_spsc_get_finish(buf, size);
+	return size;
+}
+
 void acts_ringbuf_dump(struct acts_ringbuf *buf, const char *name, const char *line_prefix)
 {
 	os_printk("%s%s: %p\n", line_prefix, name, buf);
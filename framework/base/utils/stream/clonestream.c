@@ -14,6 +14,44 @@
 #include <assert.h>
 #include <errno.h>
 #include <sys/util.h>
+#include <string.h>
+
+enum {
+	VIEW_FREE = 0,
+	VIEW_ACTIVE,
+	VIEW_STOPPED,
+};
+
+struct clone_stream_view {
+	/* read offset, in total bytes published */
+	uint32_t rofs;
+	/* read offset and length of the claimed data */
+	uint32_t claim_ofs;
+	uint32_t claimed;
+	uint32_t max_lag;
+	uint32_t max_lag_seen;
+	uint32_t dropped;
+	uint32_t stopped;
+	uint8_t policy;
+	uint8_t state;
+	/* claimed data overwritten by the producer */
+	uint8_t overwritten;
+};
+
+struct clone_stream_ctx {
+	/* must be the first member, handle->data is also used as the info */
+	struct clone_stream_info info;
+
+	/* buffer shared by the views */
+	uint8_t *view_buf;
+	uint32_t view_buf_size;
+	/* write index in view_buf */
+	uint32_t view_widx;
+	/* write offset, in total bytes published */
+	uint32_t view_wofs;
+	uint8_t view_num;
+	struct clone_stream_view views[CONFIG_CLONE_STREAM_VIEW_NUM];
+};
 
 static bool validate_stream_state(io_stream_t handle, uint8_t state)
 {
@@ -23,6 +61,7 @@ static bool validate_stream_state(io_stream_t handle, uint8_t state)
 static int clone_stream_init(io_stream_t handle, void *param)
 {
 	struct clone_stream_info *info = param;
+	struct clone_stream_ctx *ctx;
 	int i;
 
 	if (!validate_stream_state(info->origin, STATE_INIT)) {
@@ -45,16 +84,106 @@ static int clone_stream_init(io_stream_t handle, void *param)
 		}
 	}
 
-	handle->data = mem_malloc(sizeof(*info));
-	if (!handle->data) {
+	ctx = mem_malloc(sizeof(*ctx));
+	if (!ctx) {
 		SYS_LOG_ERR("malloc data\n", i);
 		return -ENOMEM;
 	}
 
-	memcpy(handle->data, info, sizeof(*info));
+	memset(ctx, 0, sizeof(*ctx));
+	memcpy(&ctx->info, info, sizeof(*info));
+
+	if (info->view_buf_size > 0) {
+		ctx->view_buf = mem_malloc(info->view_buf_size);
+		if (!ctx->view_buf) {
+			SYS_LOG_ERR("malloc view buf %d\n", info->view_buf_size);
+			mem_free(ctx);
+			return -ENOMEM;
+		}
+
+		ctx->view_buf_size = info->view_buf_size;
+	}
+
+	handle->data = ctx;
 	return 0;
 }
 
+/*
+ * Copy the data once into the shared buffer for all views. Views lagging
+ * too much are dropped or stopped first, so the producer never waits and
+ * never overwrites data a running view has not claimed yet. The copy runs
+ * outside the lock, a claim in progress is only marked overwritten and
+ * reported by the release (see clone_stream_view_open). Only one producer
+ * is supported.
+ */
+static void clone_stream_view_publish(struct clone_stream_ctx *ctx,
+		const unsigned char *buf, uint32_t len)
+{
+	uint32_t size = ctx->view_buf_size;
+	uint32_t wofs, widx, n;
+	unsigned int key;
+	int i;
+
+	if (ctx->view_num == 0)
+		return;
+
+	key = os_irq_lock();
+
+	wofs = ctx->view_wofs + len;
+
+	for (i = 0; i < ARRAY_SIZE(ctx->views); i++) {
+		struct clone_stream_view *view = &ctx->views[i];
+		uint32_t lag;
+
+		if (view->state != VIEW_ACTIVE)
+			continue;
+
+		lag = wofs - view->rofs;
+		if (lag > view->max_lag) {
+			if (view->policy == CLONE_STREAM_LAG_STOP) {
+				view->state = VIEW_STOPPED;
+				view->stopped++;
+				continue;
+			}
+
+			n = lag - view->max_lag;
+			view->rofs += n;
+			view->dropped += n;
+			lag = view->max_lag;
+
+			if (view->claimed && (int32_t)(wofs - size - view->claim_ofs) > 0)
+				view->overwritten = 1;
+		}
+
+		if (lag > view->max_lag_seen)
+			view->max_lag_seen = lag;
+	}
+
+	os_irq_unlock(key);
+
+	/* only the last size bytes are kept */
+	widx = ctx->view_widx;
+	if (len > size) {
+		widx = (widx + len - size) % size;
+		buf += len - size;
+		n = size;
+	} else {
+		n = len;
+	}
+
+	if (widx + n > size) {
+		memcpy(ctx->view_buf + widx, buf, size - widx);
+		memcpy(ctx->view_buf, buf + size - widx, widx + n - size);
+	} else {
+		memcpy(ctx->view_buf + widx, buf, n);
+	}
+
+	key = os_irq_lock();
+	ctx->view_widx = (widx + n) % size;
+	ctx->view_wofs = wofs;
+	os_irq_unlock(key);
+}
+
 static int clone_stream_open(io_stream_t handle, stream_mode mode)
 {
 	struct clone_stream_info *info = handle->data;
@@ -87,6 +216,8 @@ static int clone_stream_read(io_stream_t handle, unsigned char *buf,int num)
 
 			info->clones[i]->ops->write(info->clones[i], buf, len);
 		}
+
+		clone_stream_view_publish(handle->data, buf, len);
 	}
 
 	return len;
@@ -109,6 +240,8 @@ static int clone_stream_write(io_stream_t handle, unsigned char *buf,int num)
 
 			info->clones[i]->ops->write(info->clones[i], buf, len);
 		}
+
+		clone_stream_view_publish(handle->data, buf, len);
 	}
 
 	return len;
@@ -173,11 +306,13 @@ static int clone_stream_close(io_stream_t handle)
 
 static int clone_stream_destroy(io_stream_t handle)
 {
-	struct clone_stream_info *info = handle->data;
+	struct clone_stream_ctx *ctx = handle->data;
 	int res;
 
-	res = stream_destroy(info->origin);
-	mem_free(info);
+	res = stream_destroy(ctx->info.origin);
+	if (ctx->view_buf)
+		mem_free(ctx->view_buf);
+	mem_free(ctx);
 	return res;
 }
 
@@ -199,4 +334,188 @@ io_stream_t clone_stream_create(struct clone_stream_info *info)
 {
 	return stream_create(&clone_stream_ops, info);
 
-}
\ No newline at end of file
+}
+
+static struct clone_stream_view *clone_stream_get_view(io_stream_t handle, int view)
+{
+	struct clone_stream_ctx *ctx;
+
+	if (!handle || handle->ops != &clone_stream_ops)
+		return NULL;
+
+	ctx = handle->data;
+	if (view < 0 || view >= ARRAY_SIZE(ctx->views) ||
+		ctx->views[view].state == VIEW_FREE)
+		return NULL;
+
+	return &ctx->views[view];
+}
+
+int clone_stream_view_open(io_stream_t handle, uint32_t max_lag, uint8_t policy)
+{
+	struct clone_stream_ctx *ctx;
+	unsigned int key;
+	int i;
+
+	if (!handle || handle->ops != &clone_stream_ops)
+		return -EINVAL;
+
+	ctx = handle->data;
+	if (!ctx->view_buf)
+		return -ENOSYS;
+
+	if (max_lag == 0 || max_lag > ctx->view_buf_size)
+		max_lag = ctx->view_buf_size;
+
+	key = os_irq_lock();
+
+	for (i = 0; i < ARRAY_SIZE(ctx->views); i++) {
+		struct clone_stream_view *view = &ctx->views[i];
+
+		if (view->state != VIEW_FREE)
+			continue;
+
+		memset(view, 0, sizeof(*view));
+		view->rofs = ctx->view_wofs;
+		view->max_lag = max_lag;
+		view->policy = policy;
+		view->state = VIEW_ACTIVE;
+		ctx->view_num++;
+
+		os_irq_unlock(key);
+		return i;
+	}
+
+	os_irq_unlock(key);
+	return -EBUSY;
+}
+
+int clone_stream_view_close(io_stream_t handle, int view)
+{
+	struct clone_stream_view *v = clone_stream_get_view(handle, view);
+	struct clone_stream_ctx *ctx;
+	unsigned int key;
+
+	if (!v)
+		return -EINVAL;
+
+	ctx = handle->data;
+
+	key = os_irq_lock();
+	v->state = VIEW_FREE;
+	ctx->view_num--;
+	os_irq_unlock(key);
+
+	return 0;
+}
+
+int clone_stream_view_claim(io_stream_t handle, int view,
+		struct acts_ringbuf_iovec iov[2], int len)
+{
+	struct clone_stream_view *v = clone_stream_get_view(handle, view);
+	struct clone_stream_ctx *ctx;
+	uint32_t size, avail, ridx;
+	unsigned int key;
+
+	if (!v || len < 0)
+		return -EINVAL;
+
+	ctx = handle->data;
+	size = ctx->view_buf_size;
+
+	key = os_irq_lock();
+
+	if (v->state == VIEW_STOPPED) {
+		os_irq_unlock(key);
+		return -EPIPE;
+	}
+
+	avail = ctx->view_wofs - v->rofs;
+	if (len > avail)
+		len = avail;
+
+	ridx = (ctx->view_widx + size - avail) % size;
+
+	v->claim_ofs = v->rofs;
+	v->claimed = len;
+	v->overwritten = 0;
+
+	os_irq_unlock(key);
+
+	iov[0].base = ctx->view_buf + ridx;
+	iov[0].len = MIN(len, size - ridx);
+	iov[1].base = ctx->view_buf;
+	iov[1].len = len - iov[0].len;
+
+	return len;
+}
+
+int clone_stream_view_release(io_stream_t handle, int view, int len)
+{
+	struct clone_stream_view *v = clone_stream_get_view(handle, view);
+	unsigned int key;
+	int res = 0;
+
+	if (!v || len < 0)
+		return -EINVAL;
+
+	key = os_irq_lock();
+
+	if (len > v->claimed) {
+		res = -EINVAL;
+	} else if (v->state == VIEW_STOPPED || v->overwritten) {
+		res = -EPIPE;
+	} else if ((int32_t)(v->claim_ofs + len - v->rofs) > 0) {
+		/* part of the claimed data may have been dropped already */
+		v->rofs = v->claim_ofs + len;
+	}
+
+	v->claimed = 0;
+	v->overwritten = 0;
+
+	os_irq_unlock(key);
+	return res;
+}
+
+int clone_stream_view_reset(io_stream_t handle, int view)
+{
+	struct clone_stream_view *v = clone_stream_get_view(handle, view);
+	struct clone_stream_ctx *ctx;
+	unsigned int key;
+
+	if (!v)
+		return -EINVAL;
+
+	ctx = handle->data;
+
+	key = os_irq_lock();
+	v->rofs = ctx->view_wofs;
+	v->claimed = 0;
+	v->overwritten = 0;
+	v->state = VIEW_ACTIVE;
+	os_irq_unlock(key);
+
+	return 0;
+}
+
+int clone_stream_view_get_stat(io_stream_t handle, int view,
+		struct clone_stream_view_stat *stat)
+{
+	struct clone_stream_view *v = clone_stream_get_view(handle, view);
+	struct clone_stream_ctx *ctx;
+	unsigned int key;
+
+	if (!v)
+		return -EINVAL;
+
+	ctx = handle->data;
+
+	key = os_irq_lock();
+	stat->lag = (v->state == VIEW_ACTIVE) ? ctx->view_wofs - v->rofs : 0;
+	stat->max_lag = v->max_lag_seen;
+	stat->dropped = v->dropped;
+	stat->stopped = v->stopped;
+	os_irq_unlock(key);
+
+	return 0;
+}
@@ -37,13 +37,22 @@ static int ringbuff_stream_open(io_stream_t handle,stream_mode mode)
 
 static int ringbuff_stream_read(io_stream_t handle, unsigned char *buf, int len)
 {
+	struct acts_ringbuf_iovec iov[2];
 	int ret = 0;
 	ringbuff_info_t *info = (ringbuff_info_t *)handle->data;
 
 	if (!info)
 		return -EACCES;
 
-	ret = acts_ringbuf_get(info->buf, buf, len);
+	if (len <= acts_ringbuf_length(info->buf)) {
+		ret = acts_ringbuf_get_claim_iov(info->buf, iov, len);
+		if (buf) {
+			memcpy(buf, iov[0].base, iov[0].len);
+			if (iov[1].len)
+				memcpy(buf + iov[0].len, iov[1].base, iov[1].len);
+		}
+		acts_ringbuf_get_finish(info->buf, ret);
+	}
 
 	if (ret != len) {
 		//SYS_LOG_WRN("want read %d bytes ,but only read  %d bytes \n",len,ret);
@@ -57,6 +66,7 @@ static int ringbuff_stream_read(io_stream_t handle, unsigned char *buf, int len)
 
 static int ringbuff_stream_write(io_stream_t handle, unsigned char *buf, int len)
 {
+	struct acts_ringbuf_iovec iov[2];
 	int ret = 0;
 	ringbuff_info_t *info = (ringbuff_info_t *)handle->data;
 
@@ -64,10 +74,14 @@ static int ringbuff_stream_write(io_stream_t handle, unsigned char *buf, int len
 		return -EACCES;
 
 	/**fill none when buf is NULL, allow user modify write offset only*/
-	if (!buf) {
-		ret = acts_ringbuf_fill_none(info->buf, len);
-	} else {
-		ret = acts_ringbuf_put(info->buf, buf, len);
+	if (len <= acts_ringbuf_space(info->buf)) {
+		ret = acts_ringbuf_put_claim_iov(info->buf, iov, len);
+		if (buf) {
+			memcpy(iov[0].base, buf, iov[0].len);
+			if (iov[1].len)
+				memcpy(iov[1].base, buf + iov[0].len, iov[1].len);
+		}
+		acts_ringbuf_put_finish(info->buf, ret);
 	}
 
 	if (ret != len) {
@@ -79,6 +93,106 @@ static int ringbuff_stream_write(io_stream_t handle, unsigned char *buf, int len
 	return ret;
 }
 
+static void ringbuff_stream_notify(io_stream_t handle,
+		struct acts_ringbuf_iovec iov[2], stream_notify_type type)
+{
+	int i, j;
+
+	for (i = 0; i < ARRAY_SIZE(handle->observer_notify); i++) {
+		if (!handle->observer_notify[i] || !(handle->observer_type[i] & type))
+			continue;
+
+		for (j = 0; j < 2 && iov[j].len > 0; j++) {
+			handle->observer_notify[i](handle->observer[i], handle->rofs,
+				handle->wofs, handle->total_size, iov[j].base, iov[j].len, type);
+		}
+	}
+}
+
+static ringbuff_info_t *ringbuff_stream_claim_info(io_stream_t handle, uint8_t mode)
+{
+	if (!handle || handle->type != RINGBUFFER_STREAM_IMAG_NUM ||
+		handle->state != STATE_OPEN || !(handle->mode & mode))
+		return NULL;
+
+	/* attached streams are fed by stream_read/stream_write copies */
+	if (handle->attach_stream[0])
+		return NULL;
+
+	return (ringbuff_info_t *)handle->data;
+}
+
+int ringbuff_stream_read_claim(io_stream_t handle, struct acts_ringbuf_iovec iov[2], int len)
+{
+	ringbuff_info_t *info = ringbuff_stream_claim_info(handle, MODE_IN);
+
+	if (!info)
+		return -EPERM;
+
+	return acts_ringbuf_get_claim_iov(info->buf, iov, len);
+}
+
+int ringbuff_stream_read_finish(io_stream_t handle, int len)
+{
+	struct acts_ringbuf_iovec iov[2];
+	ringbuff_info_t *info = ringbuff_stream_claim_info(handle, MODE_IN);
+
+	if (!info)
+		return -EPERM;
+
+	if (len > acts_ringbuf_length(info->buf))
+		return -EINVAL;
+
+	/* observers see the data before it can be overwritten */
+	acts_ringbuf_get_claim_iov(info->buf, iov, len);
+	ringbuff_stream_notify(handle, iov, STREAM_NOTIFY_READ);
+
+	acts_ringbuf_get_finish(info->buf, len);
+
+	handle->rofs = info->buf->head;
+	handle->wofs = info->buf->tail;
+
+	stream_wakeup_writer(handle);
+
+	return 0;
+}
+
+int ringbuff_stream_write_claim(io_stream_t handle, struct acts_ringbuf_iovec iov[2], int len)
+{
+	ringbuff_info_t *info = ringbuff_stream_claim_info(handle, MODE_OUT);
+
+	if (!info)
+		return -EPERM;
+
+	return acts_ringbuf_put_claim_iov(info->buf, iov, len);
+}
+
+int ringbuff_stream_write_finish(io_stream_t handle, int len)
+{
+	struct acts_ringbuf_iovec iov[2];
+	ringbuff_info_t *info = ringbuff_stream_claim_info(handle, MODE_OUT);
+
+	if (!info)
+		return -EPERM;
+
+	if (len > acts_ringbuf_space(info->buf))
+		return -EINVAL;
+
+	/* observers process the data in place before it is published */
+	acts_ringbuf_put_claim_iov(info->buf, iov, len);
+	ringbuff_stream_notify(handle, iov, STREAM_NOTIFY_PRE_WRITE);
+
+	acts_ringbuf_put_finish(info->buf, len);
+
+	handle->rofs = info->buf->head;
+	handle->wofs = info->buf->tail;
+
+	stream_wakeup_reader(handle);
+
+	ringbuff_stream_notify(handle, iov, STREAM_NOTIFY_WRITE);
+	return 0;
+}
+
 static int ringbuff_stream_get_length(io_stream_t handle)
 {
 	ringbuff_info_t *info = (ringbuff_info_t *)handle->data;
@@ -16,6 +16,9 @@
 #include <stdio.h>
 #include "stream_internal.h"
 
+/* timeout of MODE_BLOCK_TIMEOUT */
+#define STREAM_BLOCK_TIMEOUT_MS 1000
+
 static bool _stream_check_handle_state(io_stream_t handle, uint8_t need_state)
 {
 	if (handle == NULL) {
@@ -32,6 +35,122 @@ static bool _stream_check_handle_state(io_stream_t handle, uint8_t need_state)
 	return true;
 }
 
+static int _stream_block_wait_time(uint32_t start_time, int timeout)
+{
+	int wait_time = timeout;
+
+	if (timeout != OS_FOREVER) {
+		wait_time = timeout - (int)(os_uptime_get_32() - start_time);
+		if (wait_time <= 0)
+			return 0;
+	}
+
+#if CONFIG_STREAM_BLOCK_RECHECK_MS > 0
+	if (wait_time == OS_FOREVER || wait_time > CONFIG_STREAM_BLOCK_RECHECK_MS)
+		wait_time = CONFIG_STREAM_BLOCK_RECHECK_MS;
+#endif
+
+	return wait_time;
+}
+
+/*
+ * The waiter resets its sem and publishes the size it waits for before
+ * checking the stream, the other side checks the size after updating the
+ * stream and gives the sem only when it is reached, so no wakeup is lost
+ * and the waiter is not woken for every read or write.
+ */
+static int _stream_wait_length(io_stream_t handle, int len, int timeout)
+{
+	uint32_t start_time = os_uptime_get_32();
+	int wait_time;
+	int length;
+
+	for (;;) {
+		os_sem_reset(handle->sync_sem);
+		handle->read_wait_len = (len > 0) ? len : 1;
+
+		length = stream_get_length(handle);
+		if (length < 0 || length >= len || handle->write_finished)
+			break;
+
+		wait_time = _stream_block_wait_time(start_time, timeout);
+		if (wait_time == 0) {
+			length = -ETIMEDOUT;
+			break;
+		}
+
+		os_sem_take(handle->sync_sem, wait_time);
+		if (!_stream_check_handle_state(handle, STATE_OPEN)) {
+			length = -ENOSYS;
+			break;
+		}
+	}
+
+	handle->read_wait_len = 0;
+	return length;
+}
+
+static int _stream_wait_space(io_stream_t handle, int space, int timeout)
+{
+	uint32_t start_time = os_uptime_get_32();
+	int wait_time;
+	int free_space;
+
+	for (;;) {
+		os_sem_reset(handle->space_sem);
+		handle->write_wait_space = (space > 0) ? space : 1;
+
+		free_space = stream_get_space(handle);
+		if (free_space < 0 || free_space >= space)
+			break;
+
+		wait_time = _stream_block_wait_time(start_time, timeout);
+		if (wait_time == 0) {
+			free_space = -ETIMEDOUT;
+			break;
+		}
+
+		os_sem_take(handle->space_sem, wait_time);
+		if (!_stream_check_handle_state(handle, STATE_OPEN)) {
+			free_space = -ENOSYS;
+			break;
+		}
+	}
+
+	handle->write_wait_space = 0;
+	return free_space;
+}
+
+void stream_wakeup_reader(io_stream_t handle)
+{
+	uint32_t wait_len = handle->read_wait_len;
+
+	if (wait_len == 0)
+		return;
+
+	if (handle->write_finished || stream_get_length(handle) >= (int)wait_len) {
+		handle->read_wait_len = 0;
+		os_sem_give(handle->sync_sem);
+	}
+}
+
+void stream_wakeup_writer(io_stream_t handle)
+{
+	uint32_t wait_space = handle->write_wait_space;
+
+	/* the space of origin stream is limited by the attached stream */
+	if (handle->attached_stream)
+		stream_wakeup_writer(handle->attached_stream);
+
+	if (wait_space == 0)
+		return;
+
+	if (stream_get_space(handle) >= (int)wait_space) {
+		handle->write_wait_space = 0;
+		os_sem_give(handle->space_sem);
+	}
+}
+
 io_stream_t stream_create(const stream_ops_t  *ops, void *init_param)
 {
 	int ret = 0;
@@ -87,11 +206,17 @@ int stream_open(io_stream_t handle, stream_mode mode)
 	}
 
 	if((mode & (MODE_READ_BLOCK | MODE_WRITE_BLOCK))){
-		handle->sync_sem = mem_malloc(sizeof(os_sem));
 		if (!handle->sync_sem) {
-			return -ENOMEM;
+			handle->sync_sem = mem_malloc(sizeof(os_sem) * 2);
+			if (!handle->sync_sem) {
+				return -ENOMEM;
+			}
+			handle->space_sem = handle->sync_sem + 1;
 		}
 		os_sem_init(handle->sync_sem, 0, 1);
+		os_sem_init(handle->space_sem, 0, 1);
+		handle->read_wait_len = 0;
+		handle->write_wait_space = 0;
 		handle->write_finished = 0;
 	}
 
@@ -105,7 +230,6 @@ int stream_read(io_stream_t handle, void *buf, int num)
 {
 	int i;
 	int brw;
-	int try_cnt = 0;
 
 	if (!_stream_check_handle_state(handle,STATE_OPEN)) {
 		return -ENOSYS;
@@ -116,21 +240,14 @@ int stream_read(io_stream_t handle, void *buf, int num)
 	}
 
 	if ((handle->mode & MODE_READ_BLOCK)) {
-		while (stream_get_length(handle) < num) {
-			if((handle->mode & MODE_BLOCK_TIMEOUT)){
-				if (try_cnt ++ > 20) {
-					SYS_LOG_INF("time out 1s");
-					handle->write_finished = 1;
-					return 0;
-				}
-			}
-			os_sem_take(handle->sync_sem, 50);
-			if(!_stream_check_handle_state(handle,STATE_OPEN)) {
-				return -ENOSYS;
-			}
-			if (handle->write_finished) {
-				break;
-			}
+		brw = _stream_wait_length(handle, num, (handle->mode & MODE_BLOCK_TIMEOUT) ?
+				STREAM_BLOCK_TIMEOUT_MS : OS_FOREVER);
+		if (brw == -ETIMEDOUT) {
+			SYS_LOG_INF("time out 1s");
+			handle->write_finished = 1;
+			return 0;
+		} else if (brw == -ENOSYS) {
+			return -ENOSYS;
 		}
 	}
 
@@ -141,9 +258,7 @@ int stream_read(io_stream_t handle, void *buf, int num)
 		return brw;
 	}
 
-	if (handle->sync_sem) {
-		os_sem_give(handle->sync_sem);
-	}
+	stream_wakeup_writer(handle);
 
 	if (!os_is_in_isr()) {
 		os_mutex_lock(&handle->attach_lock, OS_FOREVER);
@@ -164,6 +279,8 @@ int stream_read(io_stream_t handle, void *buf, int num)
 			}
 			return brw;
 		}
+
+		stream_wakeup_reader(handle->attach_stream[i]);
 	}
 
 	if (!os_is_in_isr()) {
@@ -180,6 +297,19 @@ int stream_read(io_stream_t handle, void *buf, int num)
 	return brw;
 }
 
+int stream_wait_length(io_stream_t handle, int len, int timeout)
+{
+	if (!_stream_check_handle_state(handle,STATE_OPEN)) {
+		return -ENOSYS;
+	}
+
+	if (!handle->sync_sem) {
+		return -EPERM;
+	}
+
+	return _stream_wait_length(handle, len, timeout);
+}
+
 int stream_seek(io_stream_t handle, int offset, seek_dir origin)
 {
 	int i;
@@ -213,10 +343,11 @@ int stream_seek(io_stream_t handle, int offset, seek_dir origin)
 		return -1;
 	}
 
-	if ((handle->mode & MODE_IN_OUT) == MODE_IN_OUT) {
-		while (target_off > handle->wofs) {
-			os_sem_take(handle->sync_sem, 50);
-			if(!_stream_check_handle_state(handle,STATE_OPEN)) {
+	if ((handle->mode & MODE_IN_OUT) == MODE_IN_OUT && handle->sync_sem) {
+		while (target_off > handle->wofs && !handle->write_finished) {
+			/* wait for the next write */
+			brw = _stream_wait_length(handle, stream_get_length(handle) + 1, 50);
+			if (brw == -ENOSYS) {
 				return -ENOSYS;
 			}
 		}
@@ -263,7 +394,6 @@ int stream_write(io_stream_t handle, const void *buf, int num)
 {
 	int brw;
 	int i;
-	int try_cnt = 0;
 
 	if (!_stream_check_handle_state(handle,STATE_OPEN)) {
 		return -ENOSYS;
@@ -274,18 +404,14 @@ int stream_write(io_stream_t handle, const void *buf, int num)
 	}
 
 	if ((handle->mode & MODE_WRITE_BLOCK)) {
-		while (stream_get_space(handle) < num) {
-			if ((handle->mode & MODE_BLOCK_TIMEOUT)) {
-				if (try_cnt ++ > 20) {
-					SYS_LOG_INF("time out 1s");
-					handle->write_finished = 1;
-					return 0;
-				}
-			}
-			os_sem_take(handle->sync_sem, 50);
-			if(!_stream_check_handle_state(handle,STATE_OPEN)) {
-				return -ENOSYS;
-			}
+		brw = _stream_wait_space(handle, num, (handle->mode & MODE_BLOCK_TIMEOUT) ?
+				STREAM_BLOCK_TIMEOUT_MS : OS_FOREVER);
+		if (brw == -ETIMEDOUT) {
+			SYS_LOG_INF("time out 1s");
+			handle->write_finished = 1;
+			return 0;
+		} else if (brw == -ENOSYS) {
+			return -ENOSYS;
 		}
 	}
 
@@ -306,9 +432,7 @@ int stream_write(io_stream_t handle, const void *buf, int num)
 		handle->write_finished = 1;
 	}
 
-	if (handle->sync_sem)
-		os_sem_give(handle->sync_sem);
-
+	stream_wakeup_reader(handle);
 
 	if (!os_is_in_isr()) {
 		os_mutex_lock(&handle->attach_lock, OS_FOREVER);
@@ -330,6 +454,8 @@ int stream_write(io_stream_t handle, const void *buf, int num)
 			}
 			return brw;
 		}
+
+		stream_wakeup_reader(handle->attach_stream[i]);
 	}
 
 	if (!os_is_in_isr()) {
@@ -384,11 +510,14 @@ int stream_close(io_stream_t handle)
 		SYS_LOG_ERR("close failed [%d]\n", res);
 	}
 
+	handle->state = STATE_CLOSE;
+
+	/* blocked reader and writer see the state and return */
 	if (handle->sync_sem) {
 		handle->write_finished = 1;
 		os_sem_give(handle->sync_sem);
+		os_sem_give(handle->space_sem);
 	}
-	handle->state = STATE_CLOSE;
 	return res;
 }
 
@@ -512,6 +641,27 @@ int stream_set_observer(io_stream_t handle, void * observer, stream_observer_not
 	return -EBUSY;
 }
 
+int stream_clear_observer(io_stream_t handle, void *observer)
+{
+	int i;
+	int ret = -ESRCH;
+
+	if (!handle) {
+		return -EINVAL;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(handle->observer); i++) {
+		if (handle->observer_notify[i] && handle->observer[i] == observer) {
+			handle->observer_notify[i] = NULL;
+			handle->observer_type[i] = 0;
+			handle->observer[i] = NULL;
+			ret = 0;
+		}
+	}
+
+	return ret;
+}
+
 int stream_attach(io_stream_t origin, io_stream_t attach_stream, int attach_type)
 {
 	int brw = -ENOSYS;
@@ -24,4 +24,10 @@
 
 #include <stream.h>
 
+/* wake the blocked reader if the length it waits for is readable */
+void stream_wakeup_reader(io_stream_t handle);
+
+/* wake the blocked writer if the space it waits for is free */
+void stream_wakeup_writer(io_stream_t handle);
+
 #endif /* __IOSTREAM_INTERNAL_H__ */
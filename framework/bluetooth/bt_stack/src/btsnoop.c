@@ -12,30 +12,21 @@ LOG_MODULE_DECLARE(os, LOG_LEVEL_INF);
 
 #include <zephyr.h>
 #include <sys/printk.h>
+#include <sys/atomic.h>
 #include <stdlib.h>
 #include <string.h>
 
-#define BTSNOOP_WRITE_SDCARD		0
-
-#if BTSNOOP_WRITE_SDCARD
+#ifdef CONFIG_BT_SNOOP_FILE
 #include <stream.h>
 #include <file_stream.h>
 #include <fs_manager.h>
-#include "media_mem.h"
-#include "audio_system.h"
 
-#define BTSNOOP_FILE_NAME			"SD:/sp.log"
 #define SNOOP_WRITE_STACKSIZE		(1024*2)
 
 static io_stream_t file_stream;
-static uint16_t write_pos;
-static uint16_t read_pos;
-static uint16_t snoop_buff_len;
-static uint8_t wait_write_sd;
-
 static struct k_work_q snoop_write_q;
-static struct k_delayed_work snoop_delaywork;
-static uint8_t snoop_write_stack[SNOOP_WRITE_STACKSIZE] __aligned(4);
+static struct k_work snoop_write_work;
+static K_KERNEL_STACK_DEFINE(snoop_write_stack, SNOOP_WRITE_STACKSIZE);
 #endif
 
 enum {
@@ -51,82 +42,234 @@ enum {
 					(((x) & 0xff) << 24)))
 
 #define SNOOP_SHELL_MODULE		"snoop"
-#if BTSNOOP_WRITE_SDCARD
-static uint8_t *snoop_buf;
-#else
-#define SNOOP_MAX_SIZE			100 //(1024*100)
-static uint8_t snoop_buf[SNOOP_MAX_SIZE];
-#endif
 #define SNOOP_HEAD				"btsnoop\0\0\0\0\1\0\0\x3\xea"
-#define SNOOP_CAP_PACKET_LEN	0	/* 0: Capture whole packet, other: Capture len */
+#define SNOOP_HEAD_LEN			16
+#define SNOOP_TIME_BASE			0x00E03AB44A676000	/* January 1st 2000 AD */
+
+/*
+ * Capture ring, written by any context without lock.
+ *
+ * Producers reserve a record by advancing snoop_wr with atomic_cas, fill
+ * it and then publish its state with a release store. A record never
+ * wraps, the tail of the ring is filled with a pad record instead. The
+ * single exporter (serialized by snoop_lock) consumes committed records
+ * in order, zeroes them and advances snoop_rd, so a record which is
+ * reserved but not yet filled always reads as SNOOP_REC_FREE.
+ */
+#define SNOOP_RING_SIZE			CONFIG_BT_SNOOP_BUF_SIZE
+#define SNOOP_RING_MASK			(SNOOP_RING_SIZE - 1)
+
+BUILD_ASSERT((SNOOP_RING_SIZE & SNOOP_RING_MASK) == 0, "BT_SNOOP_BUF_SIZE must be power of 2");
+BUILD_ASSERT(CONFIG_BT_SNOOP_CAP_LEN == 0 || CONFIG_BT_SNOOP_CAP_LEN >= 4,
+	"BT_SNOOP_CAP_LEN too small");
+
+enum {
+	SNOOP_REC_FREE = 0,
+	SNOOP_REC_COMMITTED,
+	SNOOP_REC_PAD,
+};
+
+struct snoop_rec_hdr {
+	/* record size in ring including header, multiple of 4 */
+	uint16_t size;
+	uint8_t state;
+	/* btsnoop packet flags */
+	uint8_t flags;
+	/* original packet length including packet type */
+	uint16_t orig_len;
+	/* captured length including packet type */
+	uint16_t incl_len;
+	uint32_t timestamp;
+	uint32_t drops;
+};
+
+#define SNOOP_REC_MAX_DATA		(SNOOP_RING_SIZE / 4 - sizeof(struct snoop_rec_hdr))
+
+static uint8_t snoop_ring[SNOOP_RING_SIZE] __aligned(4);
+static atomic_t snoop_wr;
+static atomic_t snoop_rd;
+
+static atomic_t snoop_records;
+static atomic_t snoop_drops;
+static atomic_t snoop_truncated;
+static uint32_t snoop_exported;
 
 static K_MUTEX_DEFINE(snoop_lock);
 static uint8_t snoop_init_flag;
-static uint32_t cap_len;
+
+typedef int (*snoop_export_fn)(void *ctx, const void *data, uint32_t length);
 
 extern void printf(const char *fmt, ...);
-static void btsnoop_write(const void *data, uint32_t length);
 
-#if BTSNOOP_WRITE_SDCARD
-static void snoop_write_delaywork(os_work *work)
+static struct snoop_rec_hdr *snoop_reserve(uint32_t rec_size)
 {
-	int wd_ret;
-	uint16_t data_len, wd_len;
+	struct snoop_rec_hdr *pad_hdr;
+	atomic_val_t pos, next;
+	uint32_t off, pad;
+
+	do {
+		pos = atomic_get(&snoop_wr);
+		off = (uint32_t)pos & SNOOP_RING_MASK;
+		pad = (off + rec_size > SNOOP_RING_SIZE) ? (SNOOP_RING_SIZE - off) : 0;
+		next = pos + pad + rec_size;
+
+		if ((uint32_t)next - (uint32_t)atomic_get(&snoop_rd) > SNOOP_RING_SIZE) {
+			return NULL;
+		}
+	} while (!atomic_cas(&snoop_wr, pos, next));
 
-try_again:
-	if (!file_stream) {
-		return;
+	if (pad) {
+		/* pad may be shorter than header, only the first word is used */
+		pad_hdr = (struct snoop_rec_hdr *)&snoop_ring[off];
+		pad_hdr->size = pad;
+		__atomic_store_n(&pad_hdr->state, SNOOP_REC_PAD, __ATOMIC_RELEASE);
 	}
 
-	k_mutex_lock(&snoop_lock, K_FOREVER);
-	data_len = cap_len;
-	k_mutex_unlock(&snoop_lock);
+	return (struct snoop_rec_hdr *)&snoop_ring[((uint32_t)pos + pad) & SNOOP_RING_MASK];
+}
+
+static struct snoop_rec_hdr *snoop_peek(void)
+{
+	struct snoop_rec_hdr *hdr;
+	uint32_t rd = atomic_get(&snoop_rd);
+
+	if (rd == (uint32_t)atomic_get(&snoop_wr)) {
+		return NULL;
+	}
+
+	hdr = (struct snoop_rec_hdr *)&snoop_ring[rd & SNOOP_RING_MASK];
+	if (__atomic_load_n(&hdr->state, __ATOMIC_ACQUIRE) == SNOOP_REC_FREE) {
+		/* reserved by a producer which is still filling it */
+		return NULL;
+	}
+
+	return hdr;
+}
+
+static void snoop_release(struct snoop_rec_hdr *hdr)
+{
+	uint32_t size = hdr->size;
+
+	memset(hdr, 0, size);
+	atomic_add(&snoop_rd, size);
+}
 
-	if ((read_pos + data_len) > snoop_buff_len) {
-		wd_len = snoop_buff_len - read_pos;
-		wd_ret = stream_write(file_stream, &snoop_buf[read_pos], wd_len);
-		if (wd_ret != wd_len) {
-			LOG_ERR("Write err %d, %d\n", wd_ret, wd_len);
-			return;
+static void snoop_ring_reset(void)
+{
+	memset(snoop_ring, 0, sizeof(snoop_ring));
+	atomic_set(&snoop_wr, 0);
+	atomic_set(&snoop_rd, 0);
+	atomic_set(&snoop_records, 0);
+	atomic_set(&snoop_drops, 0);
+	atomic_set(&snoop_truncated, 0);
+	snoop_exported = 0;
+}
+
+/* Drain the capture ring as btsnoop records, snoop_lock must be held. */
+static int snoop_export_records(snoop_export_fn export_fn, void *ctx)
+{
+	struct snoop_rec_hdr *hdr;
+	uint32_t rec[6];
+	uint64_t time;
+	int total = 0;
+	int ret;
+
+	while ((hdr = snoop_peek()) != NULL) {
+		if (hdr->state == SNOOP_REC_PAD) {
+			snoop_release(hdr);
+			continue;
 		}
 
-		wd_len = data_len - wd_len;
-		wd_ret = stream_write(file_stream, &snoop_buf[0], wd_len);
-		if (wd_ret != wd_len) {
-			LOG_ERR("Write err %d, %d\n", wd_ret, wd_len);
-			return;
+		time = (uint64_t)hdr->timestamp * 1000 + SNOOP_TIME_BASE;
+
+		rec[0] = reverse_32((uint32_t)hdr->orig_len);
+		rec[1] = reverse_32((uint32_t)hdr->incl_len);
+		rec[2] = reverse_32((uint32_t)hdr->flags);
+		rec[3] = reverse_32(hdr->drops);
+		rec[4] = reverse_32((uint32_t)(time >> 32));
+		rec[5] = reverse_32((uint32_t)(time & 0xFFFFFFFF));
+
+		ret = export_fn(ctx, rec, sizeof(rec));
+		if (ret == sizeof(rec)) {
+			ret = export_fn(ctx, hdr + 1, hdr->incl_len);
 		}
 
-		read_pos = wd_len;
-	} else {
-		wd_ret = stream_write(file_stream, &snoop_buf[read_pos], data_len);
-		if (wd_ret != data_len) {
-			LOG_ERR("Write err %d, %d\n", wd_ret, data_len);
-			return;
+		if (ret < 0) {
+			return ret;
 		}
 
-		read_pos += data_len;
+		total += sizeof(rec) + hdr->incl_len;
+		snoop_exported++;
+		snoop_release(hdr);
+	}
+
+	return total;
+}
+
+/**
+ * @brief Export captured packets in btsnoop format
+ *
+ * Captured records are removed from the ring once exported.
+ *
+ * @param export_fn output function, returns bytes written or negative error
+ * @param ctx context of export_fn
+ * @param with_head also export the btsnoop file header first
+ *
+ * @return bytes exported, or negative error from export_fn
+ */
+int btsnoop_export(snoop_export_fn export_fn, void *ctx, bool with_head)
+{
+	int ret = 0;
+
+	if (snoop_init_flag == 0) {
+		return -ENODEV;
 	}
 
 	k_mutex_lock(&snoop_lock, K_FOREVER);
-	cap_len -= data_len;
-	data_len = cap_len;
+
+	if (with_head) {
+		ret = export_fn(ctx, SNOOP_HEAD, SNOOP_HEAD_LEN);
+	}
+
+	if (ret >= 0) {
+		ret = snoop_export_records(export_fn, ctx);
+		if (ret >= 0 && with_head) {
+			ret += SNOOP_HEAD_LEN;
+		}
+	}
+
 	k_mutex_unlock(&snoop_lock);
+	return ret;
+}
 
-	if (data_len) {
-		goto try_again;
-	} else {
-		wait_write_sd = 0;
+#ifdef CONFIG_BT_SNOOP_FILE
+static int snoop_file_export(void *ctx, const void *data, uint32_t length)
+{
+	return stream_write((io_stream_t)ctx, data, length);
+}
+
+static void snoop_write_work_handler(struct k_work *work)
+{
+	int ret;
+
+	k_mutex_lock(&snoop_lock, K_FOREVER);
+	if (file_stream) {
+		ret = snoop_export_records(snoop_file_export, file_stream);
+		if (ret < 0) {
+			LOG_ERR("Write err %d\n", ret);
+		}
 	}
+	k_mutex_unlock(&snoop_lock);
 }
 
 static void btsnoop_init_sdcard_write(void)
 {
+	static uint8_t work_q_started;
 	int ret;
 
-	fs_unlink(BTSNOOP_FILE_NAME);
+	fs_unlink(CONFIG_BT_SNOOP_FILE_NAME);
 
-	file_stream = file_stream_create((void *)BTSNOOP_FILE_NAME);
+	file_stream = file_stream_create((void *)CONFIG_BT_SNOOP_FILE_NAME);
 	if (!file_stream) {
 		LOG_ERR("Failed to create file!\n");
 		return;
@@ -140,76 +283,43 @@ static void btsnoop_init_sdcard_write(void)
 		return;
 	}
 
-	snoop_buf = media_mem_get_cache_pool(INPUT_PLAYBACK, AUDIO_STREAM_MUSIC);
-	snoop_buff_len = media_mem_get_cache_pool_size(INPUT_PLAYBACK, AUDIO_STREAM_MUSIC);
-	LOG_INF("Buff %p, len %d\n", snoop_buf, snoop_buff_len);
-
-	write_pos = 0;
-	read_pos = 0;
-	cap_len = 0;
+	stream_write(file_stream, SNOOP_HEAD, SNOOP_HEAD_LEN);
 
-	k_work_q_start(&snoop_write_q, (k_thread_stack_t)snoop_write_stack, SNOOP_WRITE_STACKSIZE, 3);
-	k_delayed_work_init(&snoop_delaywork, snoop_write_delaywork);
+	if (!work_q_started) {
+		k_work_queue_start(&snoop_write_q, snoop_write_stack,
+				K_KERNEL_STACK_SIZEOF(snoop_write_stack), 3, NULL);
+		k_work_init(&snoop_write_work, snoop_write_work_handler);
+		work_q_started = 1;
+	}
 }
 
 static void snoop_file_close(void)
 {
+	k_mutex_lock(&snoop_lock, K_FOREVER);
 	if (file_stream) {
-		k_mutex_lock(&snoop_lock, K_FOREVER);
+		snoop_export_records(snoop_file_export, file_stream);
 		stream_close(file_stream);
 		stream_destroy(file_stream);
 		file_stream = NULL;
-		k_mutex_unlock(&snoop_lock);
 	}
+	k_mutex_unlock(&snoop_lock);
 
 	LOG_INF("Close finish!\n");
 }
 #endif
 
-static void btsnoop_write(const void *data, uint32_t length)
-{
-#if BTSNOOP_WRITE_SDCARD
-	uint16_t wd_len, len;
-
-	if (!file_stream) {
-		return;
-	}
-
-	if ((write_pos + length) > snoop_buff_len) {
-		wd_len = snoop_buff_len - write_pos;
-		memcpy(&snoop_buf[write_pos], data, wd_len);
-		len = length - wd_len;
-		memcpy(&snoop_buf[0], &((uint8_t *)data)[wd_len], len);
-		write_pos = len;
-		cap_len += length;
-	} else {
-		memcpy(&snoop_buf[write_pos], data, length);
-		write_pos += length;
-		cap_len += length;
-	}
-
-	if (0 == wait_write_sd) {
-		k_delayed_work_submit_to_queue(&snoop_write_q, &snoop_delaywork, 0);
-		wait_write_sd = 1;
-	}
-#else
-	memcpy(&snoop_buf[cap_len], data, length);
-	cap_len += length;
-#endif
-}
-
 int btsnoop_init(void)
 {
 	k_mutex_lock(&snoop_lock, K_FOREVER);
-	memset(snoop_buf, 0, sizeof(snoop_buf));
-	snoop_init_flag = 1;
-	cap_len = 0;
 
-#if BTSNOOP_WRITE_SDCARD
+	snoop_init_flag = 0;
+	snoop_ring_reset();
+
+#ifdef CONFIG_BT_SNOOP_FILE
 	btsnoop_init_sdcard_write();
 #endif
 
-	btsnoop_write(SNOOP_HEAD, 16);
+	snoop_init_flag = 1;
 	k_mutex_unlock(&snoop_lock);
 	LOG_INF("Btsnoop init success!");
 
@@ -218,11 +328,10 @@ int btsnoop_init(void)
 
 int btsnoop_write_packet(uint8_t type, const uint8_t *packet, bool is_received)
 {
+	struct snoop_rec_hdr *hdr;
 	uint32_t length_he = 0;
-	uint32_t length;
+	uint32_t incl_len;
 	uint32_t flags;
-	uint32_t drops = 0;
-	u64_t time;
 
 	if (snoop_init_flag == 0) {
 		return 0;
@@ -245,50 +354,72 @@ int btsnoop_write_packet(uint8_t type, const uint8_t *packet, bool is_received)
 		length_he = packet[1] + 3;
 		flags = 3;
 		break;
+	default:
+		return 0;
 	}
 
-	if (SNOOP_CAP_PACKET_LEN) {
-		length_he = (length_he > SNOOP_CAP_PACKET_LEN) ? SNOOP_CAP_PACKET_LEN : length_he;
+	incl_len = length_he;
+	if (CONFIG_BT_SNOOP_CAP_LEN && incl_len > CONFIG_BT_SNOOP_CAP_LEN) {
+		incl_len = CONFIG_BT_SNOOP_CAP_LEN;
 	}
 
-	time = k_uptime_get_32();
-	time *= 1000;
-	time += 0x00E03AB44A676000;		/* January 1st 2000 AD */
-	uint32_t time_hi = time >> 32;
-	uint32_t time_lo = time & 0xFFFFFFFF;
-
-	length = reverse_32(length_he);
-	flags = reverse_32(flags);
-	drops = reverse_32(drops);
-	time_hi = reverse_32(time_hi);
-	time_lo = reverse_32(time_lo);
+	if (incl_len > SNOOP_REC_MAX_DATA) {
+		incl_len = SNOOP_REC_MAX_DATA;
+	}
 
-	/* This function is called from different contexts. */
-	k_mutex_lock(&snoop_lock, K_FOREVER);
+	if (incl_len < length_he) {
+		atomic_inc(&snoop_truncated);
+	}
 
-#if BTSNOOP_WRITE_SDCARD
-	if ((length_he + 24 + cap_len) < snoop_buff_len) {
-#else
-	if ((length_he + 24 + cap_len) < SNOOP_MAX_SIZE) {
-#endif
-		btsnoop_write(&length, 4);
-		btsnoop_write(&length, 4);
-		btsnoop_write(&flags, 4);
-		btsnoop_write(&drops, 4);
-		btsnoop_write(&time_hi, 4);
-		btsnoop_write(&time_lo, 4);
-		btsnoop_write(&type, 1);
-		btsnoop_write(packet, length_he - 1);
-	} else {
-		LOG_INF("Full!");
+	/* This function is called from different contexts without lock. */
+	hdr = snoop_reserve(ROUND_UP(sizeof(*hdr) + incl_len, 4));
+	if (!hdr) {
+		atomic_inc(&snoop_drops);
+		return 0;
 	}
 
-	k_mutex_unlock(&snoop_lock);
+	hdr->size = ROUND_UP(sizeof(*hdr) + incl_len, 4);
+	hdr->flags = flags;
+	hdr->orig_len = length_he;
+	hdr->incl_len = incl_len;
+	hdr->timestamp = k_uptime_get_32();
+	hdr->drops = atomic_get(&snoop_drops);
+
+	((uint8_t *)(hdr + 1))[0] = type;
+	memcpy((uint8_t *)(hdr + 1) + 1, packet, incl_len - 1);
+
+	__atomic_store_n(&hdr->state, SNOOP_REC_COMMITTED, __ATOMIC_RELEASE);
+	atomic_inc(&snoop_records);
+
+#ifdef CONFIG_BT_SNOOP_FILE
+	if (file_stream) {
+		k_work_submit_to_queue(&snoop_write_q, &snoop_write_work);
+	}
+#endif
 
 	return length_he;
 }
 
-#if BTSNOOP_WRITE_SDCARD
+static int snoop_hex_export(void *ctx, const void *data, uint32_t length)
+{
+	uint32_t *col = ctx;
+	uint32_t i;
+
+	for (i = 0; i < length; i++) {
+		printf("%02x ", ((const uint8_t *)data)[i]);
+		if ((++(*col) % 16) == 0) {
+			printf("\n");
+		}
+
+		if ((*col % 0xFF) == 0) {
+			k_sleep(K_MSEC(1));
+		}
+	}
+
+	return length;
+}
+
+#ifdef CONFIG_BT_SNOOP_FILE
 static void dump_file(void)
 {
 	uint8_t buff[16], i;
@@ -301,6 +432,8 @@ static void dump_file(void)
 	}
 
 	k_mutex_lock(&snoop_lock, K_FOREVER);
+	snoop_export_records(snoop_file_export, file_stream);
+
 	file_len = stream_tell(file_stream);
 	stream_seek(file_stream, 0, SEEK_DIR_BEG);
 	rd_len = 0;
@@ -332,35 +465,24 @@ static void dump_file(void)
 #else
 static void dump_buffer(void)
 {
-	uint32_t i;
+	uint32_t col = 0;
+	int len;
 
 	if (snoop_init_flag == 0) {
 		LOG_INF("Btsnoop not initialize!");
 		return;
 	}
 
-	k_mutex_lock(&snoop_lock, K_FOREVER);
-
-	printf("\nDump snoop data start len: %d\n\n", cap_len);
-	for (i = 0; i < cap_len; ) {
-		printf("%02x ", snoop_buf[i++]);
-		if ((i%16) == 0) {
-			printf("\n");
-		}
-
-		if ((i%0xFF) == 0) {
-			k_sleep(K_MSEC(1));
-		}
-	}
-
-	printf("\n\nDump snoop data end\n");
-	k_mutex_unlock(&snoop_lock);
+	/* each dump is a complete btsnoop file of the records since last dump */
+	printf("\nDump snoop data start\n\n");
+	len = btsnoop_export(snoop_hex_export, &col, true);
+	printf("\n\nDump snoop data end len: %d\n", len);
 }
 #endif
 
 void hci_snoop_dump(void)
 {
-#if BTSNOOP_WRITE_SDCARD
+#ifdef CONFIG_BT_SNOOP_FILE
 	dump_file();
 #else
 	dump_buffer();
@@ -369,7 +491,7 @@ void hci_snoop_dump(void)
 
 void hci_snoop_reinit(void)
 {
-#if BTSNOOP_WRITE_SDCARD
+#ifdef CONFIG_BT_SNOOP_FILE
 	snoop_file_close();
 #endif
 	btsnoop_init();
@@ -377,26 +499,30 @@ void hci_snoop_reinit(void)
 
 void hci_snoop_info(void)
 {
-#if BTSNOOP_WRITE_SDCARD
-	if (!file_stream) {
-		LOG_INF("Btsnoop not initialize!");
-		return;
-	}
+	uint32_t used;
 
-	LOG_INF("SD card capture data: %d, %d\n", stream_tell(file_stream), cap_len);
-#else
 	if (snoop_init_flag == 0) {
 		LOG_INF("Btsnoop not initialize!");
 		return;
 	}
 
-	LOG_INF("Capture data: %d, remain buff: %d\n", cap_len, (SNOOP_MAX_SIZE - cap_len));
+	used = (uint32_t)atomic_get(&snoop_wr) - (uint32_t)atomic_get(&snoop_rd);
+
+	LOG_INF("Capture records: %d, exported: %d, drops: %d, truncated: %d\n",
+		(uint32_t)atomic_get(&snoop_records), snoop_exported,
+		(uint32_t)atomic_get(&snoop_drops), (uint32_t)atomic_get(&snoop_truncated));
+	LOG_INF("Ring used: %d, remain buff: %d\n", used, SNOOP_RING_SIZE - used);
+
+#ifdef CONFIG_BT_SNOOP_FILE
+	if (file_stream) {
+		LOG_INF("SD card capture data: %d\n", stream_tell(file_stream));
+	}
 #endif
 }
 
 void hci_snoop_close(void)
 {
-#if BTSNOOP_WRITE_SDCARD
+#ifdef CONFIG_BT_SNOOP_FILE
 	snoop_file_close();
 #endif
 }
@@ -39,6 +39,32 @@ typedef enum
 	LVGL_RES_PRELOAD_STATUS_CANCELED,
 }lvgl_res_preload_status_e;
 
+/** Possible resources preload priorities*/
+typedef enum
+{
+	/**< speculative preload of the next likely scene, limited by preload budget*/
+	LVGL_RES_PRELOAD_PRIORITY_LOW = 0,
+	/**< default priority*/
+	LVGL_RES_PRELOAD_PRIORITY_NORMAL,
+	/**< scene demanded by UI, queued at the head*/
+	LVGL_RES_PRELOAD_PRIORITY_HIGH,
+}lvgl_res_preload_priority_e;
+
+/** Preload statistics of a scene, picture loads of the scene are counted*/
+typedef struct
+{
+	/**< scene id*/
+	uint32_t scene_id;
+	/**< pictures already preloaded*/
+	uint32_t hit;
+	/**< pictures not preloaded*/
+	uint32_t miss;
+	/**< pictures still pending in preload, UI waited or loaded them itself*/
+	uint32_t stall;
+	/**< pictures skipped by preload budget*/
+	uint32_t dropped;
+}lvgl_res_preload_stat_t;
+
 /** Data structure of scene data, inited by 'lvgl_res_load_scene()' */
 typedef struct
 {
@@ -75,6 +101,8 @@ typedef struct
 	uint16_t width;
 	/**< group height */
 	uint16_t height;
+	/**< id of the scene it belongs to*/
+	uint32_t scene_id;
 	/**< internal pointer to group data*/
 	resource_group_t* group_data;
 	/**< internal pointer to resource global info*/
@@ -94,6 +122,8 @@ typedef struct
 	uint16_t height;
 	/**< frame number of picture region*/
 	uint32_t frames;
+	/**< id of the scene it belongs to*/
+	uint32_t scene_id;
 	/**< internal pointer to pic region data*/
 	resource_picregion_t* picreg_data;
 	/**< internal pointer to resource global info*/
@@ -426,6 +456,64 @@ int lvgl_res_load_picregion(uint32_t group_id, uint32_t subgroup_id, uint32_t pi
 int lvgl_res_preload_scene_compact(uint32_t scene_id, const uint32_t* resource_id, uint32_t resource_num, void (*callback)(int32_t, void *), void* user_data, 
 											const char* style_path, const char* picture_path, const char* text_path);
 
+/**
+* @brief pictures preload initiating funcion with priority
+*
+* This routine add all or ceratin picture resources in a scene to preload list, ahead of preloads with lower priority.
+* Pictures of low priority are preloaded in the order of resource_id, those beyond CONFIG_LVGL_RES_PRELOAD_BUDGET are skipped.
+* If the scene is already in preload list, it is moved ahead instead, and the callback replaces the previous one
+* which is notified with LVGL_RES_PRELOAD_STATUS_CANCELED.
+*
+* @param scene_id hashed scene identifier of the scene to operate on. All picture resources would be added to preload list if resource_id is NULL.
+* @param resource_id list of id to add to preload list. if a group id is specified, all pictures in the group are added to preload list.
+* @param resource_num number of ids in id list
+* @param callback callback function to notify status change
+* @param user_data param passes to callback function
+* @param sty_file file path of .sty file
+* @param pic_file file path of .res file 
+* @param str_file file path of .str file
+* @param priority preload priority, see lvgl_res_preload_priority_e
+*
+* @return 0 if invoked succsess.
+* @return -1 if invoked failed.
+*/
+int lvgl_res_preload_scene_compact_priority(uint32_t scene_id, const uint32_t* resource_id, uint32_t resource_num, void (*callback)(int32_t, void *), void* user_data, 
+											const char* style_path, const char* picture_path, const char* text_path, uint32_t priority);
+
+/**
+* @brief scene preload promoting funcion
+*
+* This routine move pending preloads of the scene to the head of preload list. 
+* It's also done when pictures of the scene are loaded.
+*
+* @param scene_id hashed scene identifier of the scene to operate on
+*
+* @return 0 if invoked succsess.
+* @return -1 if scene is not in preload list.
+*/
+int lvgl_res_preload_promote_scene(uint32_t scene_id);
+
+/**
+* @brief preload statistics getting funcion
+*
+* This routine get hit/miss/stall counters of the scene.
+*
+* @param scene_id hashed scene identifier of the scene to operate on
+* @param stat pointer to the statistics to fill
+*
+* @return 0 if invoked succsess.
+* @return -1 if there's no statistics of the scene.
+*/
+int lvgl_res_preload_get_stat(uint32_t scene_id, lvgl_res_preload_stat_t* stat);
+
+/**
+* @brief preload statistics dumping funcion
+*
+* This routine print preload counters of all scenes recorded.
+*
+*/
+void lvgl_res_preload_dump_stat(void);
+
 /**
 * @brief pictures preload initiating funcion
 *
@@ -486,7 +574,8 @@ int lvgl_res_preload_cancel(void);
 /**
 * @brief resource preload canceling funcion
 *
-* This routine cancel preloading of specific scene, and release memory already used
+* This routine cancel preloading of specific scene, and release memory already used.
+* It waits for the picture of the scene being preloaded, so the scene can be unloaded safely after return.
 *
 * @param scene_id hashed scene identifier of the scene to operate on
 *
@@ -192,11 +192,20 @@ typedef struct
 	uint8_t reserve[8];
 } resource_group_t;
 
+//how the last load of a bitmap was satisfied
+typedef enum
+{
+	RES_BITMAP_LOAD_FILE = 0,	//read from res file
+	RES_BITMAP_LOAD_CACHED,		//found in bitmap cache
+	RES_BITMAP_LOAD_WAITED,		//waited for another thread loading it
+}res_bitmap_load_e;
+
 typedef struct
 {
 	sty_picture_t* sty_data;	
 	uint8_t* buffer;
 	uint32_t regular_info;
+	uint32_t load_result;
 } resource_bitmap_t;
 
 typedef struct
@@ -225,6 +234,7 @@ typedef struct _compact_buffer_s
 typedef struct _preload_param
 {
 	uint32_t preload_type;
+	uint32_t priority;
 	resource_bitmap_t* bitmap;
 	uint32_t scene_id;
 	void (*callback)(int32_t , void*);
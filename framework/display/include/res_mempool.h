@@ -102,6 +102,13 @@ int res_fs_seek(void* handle, off_t where, int whence);
 off_t res_fs_tell(void* handle);
 ssize_t res_fs_read(void* handle, void* buffer, size_t len);
 
+/**
+ * @brief hint that len bytes at current position will be read soon
+ *
+ * @retval bytes read ahead in background, 0 if not supported
+ */
+int res_fs_read_ahead(void* handle, size_t len);
+
 
 #ifdef __cplusplus
 }
@@ -127,6 +127,15 @@ typedef struct surface {
 
 #if CONFIG_SURFACE_MAX_BUFFER_COUNT > 1
 	uint8_t swap_pending;
+
+	/* non-overlapping areas to copy from front to back buffer on swap */
+	uint8_t dirty_cnt;
+	ui_region_t dirty_rects[CONFIG_SURFACE_DIRTY_AREA_NUM];
+
+	/* swap copy statistics */
+	uint16_t swap_jobs;        /* copy jobs of the last swap */
+	uint32_t swap_bytes;       /* bytes copied by the last swap */
+	uint32_t swap_max_bytes;   /* maximum bytes copied by one swap */
 #endif
 
 	/* Take care of the last draw of the frame, since surface_end_draw()
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2020 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "lz4_stream.h"
+
+#define LZ4S_MIN_MATCH		4
+#define LZ4S_LEN_MASK		0xf
+
+enum {
+	LZ4S_TOKEN = 0,
+	LZ4S_LIT_LEN,
+	LZ4S_LIT,
+	LZ4S_OFFSET_LO,
+	LZ4S_OFFSET_HI,
+	LZ4S_MATCH_LEN,
+};
+
+void lz4_stream_init(lz4_stream_t *stream, void *dst, int dst_capacity)
+{
+	stream->dst_start = (uint8_t *)dst;
+	stream->dst = (uint8_t *)dst;
+	stream->dst_end = (uint8_t *)dst + dst_capacity;
+	stream->len = 0;
+	stream->offset = 0;
+	stream->token = 0;
+	stream->state = LZ4S_TOKEN;
+}
+
+static int lz4_stream_copy_match(lz4_stream_t *stream)
+{
+	uint8_t *dst = stream->dst;
+	const uint8_t *match = dst - stream->offset;
+	uint32_t len = stream->len + LZ4S_MIN_MATCH;
+
+	if (len > (uint32_t)(stream->dst_end - dst))
+		return -1;
+
+	if (stream->offset >= len) {
+		memcpy(dst, match, len);
+	} else {
+		/* overlapped match repeats the last offset bytes */
+		while (len-- > 0)
+			*dst++ = *match++;
+	}
+
+	stream->dst += stream->len + LZ4S_MIN_MATCH;
+	stream->state = LZ4S_TOKEN;
+
+	return 0;
+}
+
+int lz4_stream_decode(lz4_stream_t *stream, const void *src, int src_size)
+{
+	const uint8_t *ip = (const uint8_t *)src;
+	const uint8_t *ip_end = ip + src_size;
+	uint32_t n;
+	uint8_t c;
+
+	while (ip < ip_end) {
+		switch (stream->state) {
+		case LZ4S_TOKEN:
+			stream->token = *ip++;
+			stream->len = stream->token >> 4;
+			if (stream->len == LZ4S_LEN_MASK)
+				stream->state = LZ4S_LIT_LEN;
+			else
+				stream->state = stream->len ? LZ4S_LIT : LZ4S_OFFSET_LO;
+			break;
+
+		case LZ4S_LIT_LEN:
+			c = *ip++;
+			stream->len += c;
+			if (c != 255)
+				stream->state = LZ4S_LIT;
+			break;
+
+		case LZ4S_LIT:
+			if (stream->len > (uint32_t)(stream->dst_end - stream->dst))
+				return -1;
+
+			n = ip_end - ip;
+			if (n > stream->len)
+				n = stream->len;
+
+			memcpy(stream->dst, ip, n);
+			stream->dst += n;
+			ip += n;
+			stream->len -= n;
+			if (stream->len == 0)
+				stream->state = LZ4S_OFFSET_LO;
+			break;
+
+		case LZ4S_OFFSET_LO:
+			stream->offset = *ip++;
+			stream->state = LZ4S_OFFSET_HI;
+			break;
+
+		case LZ4S_OFFSET_HI:
+			stream->offset |= (uint16_t)(*ip++) << 8;
+			if (stream->offset == 0 ||
+			    stream->offset > (uint32_t)(stream->dst - stream->dst_start))
+				return -1;
+
+			stream->len = stream->token & LZ4S_LEN_MASK;
+			if (stream->len == LZ4S_LEN_MASK) {
+				stream->state = LZ4S_MATCH_LEN;
+			} else if (lz4_stream_copy_match(stream)) {
+				return -1;
+			}
+			break;
+
+		case LZ4S_MATCH_LEN:
+			c = *ip++;
+			stream->len += c;
+			if (c != 255 && lz4_stream_copy_match(stream))
+				return -1;
+			break;
+
+		default:
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+int lz4_stream_finish(lz4_stream_t *stream)
+{
+	/* a block always ends with the literals of the last sequence */
+	if (stream->state != LZ4S_OFFSET_LO)
+		return -1;
+
+	return (int)(stream->dst - stream->dst_start);
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2020 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Incremental decoder of one LZ4 block
+ *
+ * The compressed block is fed in chunks of any size, the output is written
+ * straight into the destination buffer which also serves as the match
+ * history, so no buffer of the whole compressed block is needed.
+ */
+
+#ifndef LZ4_STREAM_HEADER
+#define LZ4_STREAM_HEADER
+
+#include <stdint.h>
+
+typedef struct lz4_stream {
+	uint8_t *dst_start;
+	uint8_t *dst;
+	uint8_t *dst_end;
+	uint32_t len;		/* literal or match length being parsed */
+	uint16_t offset;
+	uint8_t token;
+	uint8_t state;
+} lz4_stream_t;
+
+/**
+ * @brief start decoding a block into dst
+ */
+void lz4_stream_init(lz4_stream_t *stream, void *dst, int dst_capacity);
+
+/**
+ * @brief decode the next chunk of the compressed block
+ *
+ * @retval 0 on success, negative if the block is malformed
+ */
+int lz4_stream_decode(lz4_stream_t *stream, const void *src, int src_size);
+
+/**
+ * @brief finish decoding
+ *
+ * @retval decoded size, negative if the block is incomplete or malformed
+ */
+int lz4_stream_finish(lz4_stream_t *stream);
+
+#endif /* LZ4_STREAM_HEADER */
@@ -13,7 +13,7 @@
 #define CONFIG_LVGL_INPUT_POINTER_MSGQ_COUNT 8
 
 static lv_indev_data_t pointer_scan_rbuf_data[CONFIG_LVGL_INPUT_POINTER_MSGQ_COUNT];
-static ACTS_RINGBUF_DEFINE(pointer_scan_rbuf, pointer_scan_rbuf_data, sizeof(pointer_scan_rbuf_data));
+static ACTS_RINGBUF_DEFINE_SPSC(pointer_scan_rbuf, pointer_scan_rbuf_data, sizeof(pointer_scan_rbuf_data));
 
 static int _lvgl_pointer_put(const input_dev_data_t *data, void *_indev)
 {
@@ -28,7 +28,7 @@ static int _lvgl_pointer_put(const input_dev_data_t *data, void *_indev)
 		return 0;
 	}
 
-	if (acts_ringbuf_put(&pointer_scan_rbuf, &indev_data, sizeof(indev_data)) != sizeof(indev_data)) {
+	if (acts_ringbuf_spsc_put(&pointer_scan_rbuf, &indev_data, sizeof(indev_data)) != sizeof(indev_data)) {
 		SYS_LOG_WRN("Could put input data into queue");
 		return -ENOBUFS;
 	}
@@ -46,12 +46,12 @@ static void _lvgl_pointer_read(lv_indev_drv_t *drv, lv_indev_data_t *data)
 
 	lv_indev_data_t curr;
 
-	if (acts_ringbuf_get(&pointer_scan_rbuf, &curr, sizeof(curr)) == sizeof(curr)) {
+	if (acts_ringbuf_spsc_get(&pointer_scan_rbuf, &curr, sizeof(curr)) == sizeof(curr)) {
 		prev = curr;
 	}
 
 	*data = prev;
-	data->continue_reading = (acts_ringbuf_is_empty(&pointer_scan_rbuf) == 0);
+	data->continue_reading = (acts_ringbuf_spsc_is_empty(&pointer_scan_rbuf) == 0);
 }
 
 static void _lvgl_indev_enable(bool en, void *indev)
@@ -13,6 +13,18 @@
 
 #define MAX_RESOURCE_SETS		5
 
+#ifndef CONFIG_LVGL_RES_PRELOAD_BUDGET
+#define RES_PRELOAD_BUDGET		0
+#else
+#define RES_PRELOAD_BUDGET		CONFIG_LVGL_RES_PRELOAD_BUDGET
+#endif
+
+#ifndef CONFIG_LVGL_RES_PRELOAD_STAT_NUM
+#define RES_PRELOAD_STAT_NUM	8
+#else
+#define RES_PRELOAD_STAT_NUM	CONFIG_LVGL_RES_PRELOAD_STAT_NUM
+#endif
+
 typedef enum
 {
 	PRELOAD_TYPE_IMMEDIATE,
@@ -34,6 +46,15 @@ typedef struct _preload_default_t
 	struct _preload_default_t* next;
 }preload_default_t;
 
+typedef struct
+{
+	lvgl_res_preload_stat_t stat;
+	uint32_t queued;		//items of the scene in preload list
+	uint32_t priority;		//priority of items in preload list
+	uint32_t spec_size;		//bytes preloaded under preload budget
+	uint32_t trimmed;		//pictures in preload list are trimmed by budget
+}preload_scene_t;
+
 
 static os_sem load_sem;
 static os_sem preload_sem;
@@ -42,6 +63,16 @@ static uint32_t preload_running = 1;
 static preload_param_t* param_list = NULL;
 static preload_param_t* sync_param_list = NULL;
 
+//scene of the item being preloaded, cancel waits for it
+static os_condvar preload_condvar;
+static os_tid_t preload_tid;
+static uint32_t preload_item_busy = 0;
+static uint32_t preload_item_scene = 0;
+
+static preload_scene_t preload_scenes[RES_PRELOAD_STAT_NUM];
+static uint32_t preload_scene_next = 0;
+static uint32_t preload_spec_size = 0;
+
 static lvgl_res_scene_t current_scene;
 static lvgl_res_group_t current_group;
 static lvgl_res_group_t current_subgrp;
@@ -60,6 +91,8 @@ static char __aligned(ARCH_STACK_PTR_ALIGN) __in_section_unique(ram.noinit.stack
 res_preload_stack[CONFIG_LVGL_RES_PRELOAD_STACKSIZE];
 
 static void _res_preload_thread(void *parama1, void *parama2, void *parama3);
+static void _preload_scene_demand(uint32_t scene_id, resource_bitmap_t* bitmap);
+static void _preload_scene_release(uint32_t scene_id);
 
 
 void lvgl_res_cache_clear(uint32_t force_clear)
@@ -77,12 +110,15 @@ int lvgl_res_loader_init(uint32_t screen_w, uint32_t screen_h)
 	os_sem_init(&load_sem, 0, 1);
 	os_sem_init(&preload_sem, 0, 1);
 	os_mutex_init(&preload_mutex);
+	os_condvar_init(&preload_condvar);
+	memset(preload_scenes, 0, sizeof(preload_scenes));
 
 	int tid = os_thread_create(res_preload_stack, RES_PRELOAD_STACKSIZE,
 		_res_preload_thread,
 		NULL, NULL, NULL,
 		CONFIG_LVGL_RES_PRELOAD_PRIORITY, 0, 0);
 
+	preload_tid = (os_tid_t)tid;
 	os_thread_name_set((os_tid_t)tid, "res_preload");
 #endif
 	memset(&current_scene, 0, sizeof(lvgl_res_scene_t));
@@ -329,6 +365,7 @@ int lvgl_res_load_group_from_scene(lvgl_res_scene_t* scene, uint32_t id, lvgl_re
 	group->y = res_group->sty_data->y;
 	group->width = res_group->sty_data->width;
 	group->height = res_group->sty_data->height;
+	group->scene_id = scene->id;
 	group->res_info = scene->res_info;
 
 	return 0;
@@ -356,6 +393,7 @@ int lvgl_res_load_group_from_group(lvgl_res_group_t* group, uint32_t id, lvgl_re
 	subgroup->y = res_group->sty_data->y;
 	subgroup->width = res_group->sty_data->width;
 	subgroup->height = res_group->sty_data->height;
+	subgroup->scene_id = group->scene_id;
 	subgroup->res_info = group->res_info;
 
 	return 0;
@@ -435,6 +473,7 @@ int lvgl_res_load_pictures_from_scene(lvgl_res_scene_t* scene, const uint32_t* i
 			pt[i].x = bitmap->sty_data->x;
 			pt[i].y = bitmap->sty_data->y;
 		}
+		_preload_scene_demand(scene->id, bitmap);
 		res_manager_free_resource_structure(bitmap);
 	}
 	os_strace_end_call_u32(SYS_TRACE_ID_RES_PICS_LOAD, (uint32_t)scene->scene_data);
@@ -539,6 +578,7 @@ int lvgl_res_load_pictures_from_group(lvgl_res_group_t* group, const uint32_t* i
 			pt[i].y = bitmap->sty_data->y;
 		}
 
+		_preload_scene_demand(group->scene_id, bitmap);
 		res_manager_free_resource_structure(bitmap);
 		bitmap = NULL;
 	}
@@ -608,6 +648,7 @@ void lvgl_res_unload_scene_compact(uint32_t scene_id)
 {
 	os_strace_string(SYS_TRACE_ID_RES_UNLOAD, "scene_compact");
 
+	_preload_scene_release(scene_id);
 	res_manager_unload_scene(scene_id, NULL);
 
 	os_strace_end_call_u32(SYS_TRACE_ID_RES_UNLOAD, scene_id);
@@ -717,6 +758,7 @@ int lvgl_res_load_picregion_from_group(lvgl_res_group_t* group, const uint32_t i
 	res_picreg->width = picreg->sty_data->width;
 	res_picreg->height = picreg->sty_data->height;
 	res_picreg->frames = picreg->sty_data->frames;
+	res_picreg->scene_id = group->scene_id;
 	res_picreg->picreg_data = picreg;
 	res_picreg->res_info = group->res_info;
 	return 0;
@@ -744,6 +786,7 @@ int lvgl_res_load_picregion_from_scene(lvgl_res_scene_t* scene, const uint32_t i
 	res_picreg->width = picreg->sty_data->width;
 	res_picreg->height = picreg->sty_data->height;
 	res_picreg->frames = (uint32_t)picreg->sty_data->frames;
+	res_picreg->scene_id = scene->id;
 	res_picreg->picreg_data = picreg;
 	res_picreg->res_info = scene->res_info;
 
@@ -789,6 +832,7 @@ int lvgl_res_load_pictures_from_picregion(lvgl_res_picregion_t* picreg, uint32_t
 			return -1;
 		}
 
+		_preload_scene_demand(picreg->scene_id, bitmap);
 		res_manager_free_resource_structure(bitmap);
 	}
 
@@ -1027,32 +1071,350 @@ static void _add_item_to_list(preload_param_t** sublist, preload_param_t* param)
 	}
 }
 
+static preload_scene_t* _get_preload_scene(uint32_t scene_id, uint32_t create)
+{
+	preload_scene_t* scene;
+	uint32_t i;
+
+	if(scene_id == 0)
+	{
+		return NULL;
+	}
+
+	for(i=0;i<RES_PRELOAD_STAT_NUM;i++)
+	{
+		if(preload_scenes[i].stat.scene_id == scene_id)
+		{
+			return &preload_scenes[i];
+		}
+	}
+
+	if(!create)
+	{
+		return NULL;
+	}
+
+	//replace the oldest record of scene not preloading
+	for(i=0;i<RES_PRELOAD_STAT_NUM;i++)
+	{
+		scene = &preload_scenes[(preload_scene_next + i) % RES_PRELOAD_STAT_NUM];
+		if(scene->queued == 0 && scene->spec_size == 0)
+		{
+			preload_scene_next = (preload_scene_next + i + 1) % RES_PRELOAD_STAT_NUM;
+			memset(scene, 0, sizeof(preload_scene_t));
+			scene->stat.scene_id = scene_id;
+			scene->priority = LVGL_RES_PRELOAD_PRIORITY_NORMAL;
+			return scene;
+		}
+	}
+
+	SYS_LOG_WRN("no preload record for scene 0x%x\n", scene_id);
+	return NULL;
+}
+
+static void _release_preload_budget(preload_scene_t* scene)
+{
+	preload_spec_size -= scene->spec_size;
+	scene->spec_size = 0;
+}
+
+static uint32_t _get_preload_size(resource_bitmap_t* bitmap)
+{
+	uint32_t buf_block_struct_size = res_manager_get_bitmap_buf_block_unit_size();
+
+	//same as the compact buffer size counted for the scene
+	if(bitmap->regular_info != 0)
+	{
+		return 0;
+	}
+
+	if(bitmap->sty_data->width == screen_width && bitmap->sty_data->height == screen_height && bitmap->sty_data->bytes_per_pixel == 2)
+	{
+		return buf_block_struct_size;
+	}
+
+	return bitmap->sty_data->width*bitmap->sty_data->height*bitmap->sty_data->bytes_per_pixel + buf_block_struct_size;
+}
+
 static void _add_item_to_preload_list(preload_param_t* param)
 {
 	preload_param_t* item;
+	preload_param_t* tail;
+	preload_scene_t* scene;
+	uint32_t count = 1;
+
+	//param may be a sublist of the same scene and priority
+	tail = param;
+	while(tail->next != NULL)
+	{
+		tail = tail->next;
+		count++;
+	}
+
 	os_mutex_lock(&preload_mutex, OS_FOREVER);
+	scene = _get_preload_scene(param->scene_id, 1);
+	if(scene != NULL)
+	{
+		scene->queued += count;
+		scene->priority = param->priority;
+		if(param->priority > LVGL_RES_PRELOAD_PRIORITY_LOW)
+		{
+			scene->trimmed = 0;
+		}
+	}
+
+	//keep list in priority order, fifo for the same priority
 	if(param_list == NULL)
 	{
 		param_list = param;
 		os_sem_give(&preload_sem);
 	}
+	else if(param_list->priority < param->priority)
+	{
+		tail->next = param_list;
+		param_list = param;
+	}
 	else
 	{
 		item = param_list;
-		while(1)
+		while(item->next != NULL && item->next->priority >= param->priority)
 		{
-			if(item->next == NULL)
+			item = item->next;
+		}
+		tail->next = item->next;
+		item->next = param;
+	}
+
+	os_mutex_unlock(&preload_mutex);
+
+}
+
+static int _promote_preload_scene(preload_scene_t* scene)
+{
+	preload_param_t* item;
+	preload_param_t* prev = NULL;
+	preload_param_t* next;
+	preload_param_t* head = NULL;
+	preload_param_t* tail = NULL;
+
+	//move items of the scene to list head in their order
+	item = param_list;
+	while(item != NULL)
+	{
+		next = item->next;
+		if(item->scene_id == scene->stat.scene_id)
+		{
+			if(prev == NULL)
 			{
-				item->next = param;
-				break;
+				param_list = next;
 			}
-			item = item->next;
+			else
+			{
+				prev->next = next;
+			}
+
+			item->priority = LVGL_RES_PRELOAD_PRIORITY_HIGH;
+			item->next = NULL;
+			if(head == NULL)
+			{
+				head = item;
+			}
+			else
+			{
+				tail->next = item;
+			}
+			tail = item;
+		}
+		else
+		{
+			prev = item;
+		}
+		item = next;
+	}
+
+	if(head == NULL)
+	{
+		return -1;
+	}
+
+	tail->next = param_list;
+	param_list = head;
+	scene->priority = LVGL_RES_PRELOAD_PRIORITY_HIGH;
+	return 0;
+}
+
+static void _preload_scene_demand(uint32_t scene_id, resource_bitmap_t* bitmap)
+{
+	preload_scene_t* scene;
+
+	if(scene_id == 0)
+	{
+		return;
+	}
+
+	os_mutex_lock(&preload_mutex, OS_FOREVER);
+	scene = _get_preload_scene(scene_id, 1);
+	if(scene != NULL)
+	{
+		if(bitmap->load_result == RES_BITMAP_LOAD_CACHED)
+		{
+			scene->stat.hit++;
+		}
+		else if(bitmap->load_result == RES_BITMAP_LOAD_WAITED || scene->queued > 0)
+		{
+			scene->stat.stall++;
+		}
+		else
+		{
+			scene->stat.miss++;
+		}
+
+		//scene is shown, preload the rest of it first
+		if(scene->queued > 0 && scene->priority != LVGL_RES_PRELOAD_PRIORITY_HIGH)
+		{
+			_promote_preload_scene(scene);
+		}
+		_release_preload_budget(scene);
+	}
+	os_mutex_unlock(&preload_mutex);
+}
+
+static void _preload_scene_release(uint32_t scene_id)
+{
+	preload_scene_t* scene;
+
+	os_mutex_lock(&preload_mutex, OS_FOREVER);
+	scene = _get_preload_scene(scene_id, 0);
+	if(scene != NULL)
+	{
+		_release_preload_budget(scene);
+	}
+	os_mutex_unlock(&preload_mutex);
+}
+
+static void _set_preload_priority(preload_param_t* sublist, uint32_t scene_id, uint32_t priority)
+{
+	preload_param_t* item = sublist;
+
+	while(item != NULL)
+	{
+		item->scene_id = scene_id;
+		item->priority = priority;
+		item = item->next;
+	}
+}
+
+static uint32_t _apply_preload_budget(preload_param_t* sublist, uint32_t scene_id)
+{
+	preload_param_t* item;
+	preload_param_t* prev;
+	preload_scene_t* scene;
+	uint32_t budget = 0;
+	uint32_t total_size = 0;
+	uint32_t size;
+	uint32_t dropped = 0;
+
+	os_mutex_lock(&preload_mutex, OS_FOREVER);
+	scene = _get_preload_scene(scene_id, 1);
+	if(scene != NULL && RES_PRELOAD_BUDGET > preload_spec_size)
+	{
+		budget = RES_PRELOAD_BUDGET - preload_spec_size;
+	}
+
+	//pictures are in priority order, skip all after the first one out of budget
+	prev = sublist;
+	item = sublist->next;
+	while(item != NULL)
+	{
+		if(item->preload_type == PRELOAD_TYPE_NORMAL_COMPACT)
+		{
+			size = _get_preload_size(item->bitmap);
+			if(dropped > 0 || total_size + size > budget)
+			{
+				prev->next = item->next;
+				res_manager_free_resource_structure(item->bitmap);
+				res_array_free(item);
+				item = prev->next;
+				dropped++;
+				continue;
+			}
+			total_size += size;
+		}
+		prev = item;
+		item = item->next;
+	}
+
+	preload_spec_size += total_size;
+	if(scene != NULL)
+	{
+		scene->spec_size += total_size;
+		scene->trimmed = (dropped > 0);
+		scene->stat.dropped += dropped;
+	}
+	os_mutex_unlock(&preload_mutex);
+
+	if(dropped > 0)
+	{
+		SYS_LOG_INF("scene 0x%x preload %d pictures dropped by budget\n", scene_id, dropped);
+	}
+	return total_size;
+}
+
+static int _merge_preload_scene(uint32_t scene_id, void (*callback)(int32_t, void *), void* user_data, uint32_t priority, uint32_t* reserved_size)
+{
+	preload_param_t* item;
+	preload_scene_t* scene;
+	void (*old_callback)(int32_t, void *) = NULL;
+	void* old_data = NULL;
+	uint32_t trimmed;
+	int found = 0;
+
+	os_mutex_lock(&preload_mutex, OS_FOREVER);
+	scene = _get_preload_scene(scene_id, 0);
+	if(scene == NULL || scene->queued == 0)
+	{
+		os_mutex_unlock(&preload_mutex);
+		return -1;
+	}
+
+	//pictures dropped by budget are needed now, queued ones are kept and the request goes on
+	trimmed = (scene->trimmed && priority > LVGL_RES_PRELOAD_PRIORITY_LOW);
+
+	item = param_list;
+	while(item != NULL)
+	{
+		if(item->scene_id == scene_id && 
+			(item->preload_type == PRELOAD_TYPE_BEGIN_CALLBACK || item->preload_type == PRELOAD_TYPE_END_CALLBACK))
+		{
+			old_callback = item->callback;
+			old_data = item->param;
+			item->callback = trimmed ? NULL : callback;
+			item->param = trimmed ? NULL : user_data;
+			found = (item->preload_type == PRELOAD_TYPE_END_CALLBACK);
 		}
+		item = item->next;
 	}
 
+	if(!found)
+	{
+		//not a scene preload, or its end callback is running
+		os_mutex_unlock(&preload_mutex);
+		return -1;
+	}
 
+	if(priority > LVGL_RES_PRELOAD_PRIORITY_LOW)
+	{
+		*reserved_size = scene->spec_size;
+		_promote_preload_scene(scene);
+		_release_preload_budget(scene);
+	}
 	os_mutex_unlock(&preload_mutex);
 
+	if(old_callback && (trimmed || old_callback != callback || old_data != user_data))
+	{
+		old_callback(LVGL_RES_PRELOAD_STATUS_CANCELED, old_data);
+	}
+	return trimmed ? 1 : 0;
 }
 
 static void _add_item_to_loading_list(preload_param_t* param)
@@ -1080,75 +1442,89 @@ static void _add_item_to_loading_list(preload_param_t* param)
 void _clear_preload_list(uint32_t scene_id)
 {
 	preload_param_t* item;
-	preload_param_t* found;
-	os_mutex_lock(&preload_mutex, OS_FOREVER);
+	preload_param_t* next;
+	preload_param_t* prev = NULL;
+	preload_param_t* canceled = NULL;
+	preload_param_t* canceled_tail = NULL;
+	uint32_t i;
 
-	if(param_list == NULL)
-	{
-		os_mutex_unlock(&preload_mutex);
-		return;
-	}
+	os_mutex_lock(&preload_mutex, OS_FOREVER);
 
+	//detach items of the scene, release them out of lock
 	item = param_list;
-	if(scene_id == 0)
+	while(item != NULL)
 	{
-		while(item != NULL)
+		next = item->next;
+		if(scene_id == 0 || item->scene_id == scene_id)
 		{
-			param_list = item->next;
-			if(item->preload_type == PRELOAD_TYPE_END_CALLBACK)
+			if(prev == NULL)
 			{
-				if(item->scene_id > 0)
-				{
-					res_manager_unload_scene(item->scene_id, NULL);
-				}			
-				if (item->callback)
-					item->callback(LVGL_RES_PRELOAD_STATUS_CANCELED, item->param);
+				param_list = next;
 			}
 			else
 			{
-				res_manager_free_resource_structure(item->bitmap);
+				prev->next = next;
+			}
+
+			item->next = NULL;
+			if(canceled == NULL)
+			{
+				canceled = item;
+			}
+			else
+			{
+				canceled_tail->next = item;
 			}
-			res_array_free(item);
-	//		_debug_sram_usage(0);
-			item = param_list;
+			canceled_tail = item;
+		}
+		else
+		{
+			prev = item;
 		}
+		item = next;
 	}
-	else
+
+	for(i=0;i<RES_PRELOAD_STAT_NUM;i++)
 	{
-		while(item != NULL)
+		if(scene_id == 0 || preload_scenes[i].stat.scene_id == scene_id)
 		{
-			if(item->scene_id == scene_id)
-			{
-				if(item->preload_type == PRELOAD_TYPE_END_CALLBACK)
-				{
-					if(item->scene_id > 0)
-					{
-						res_manager_unload_scene(item->scene_id, NULL);
-					}
-					if (item->callback)
-						item->callback(LVGL_RES_PRELOAD_STATUS_CANCELED, item->param);
-				}
-				else
-				{
-					res_manager_free_resource_structure(item->bitmap);
-				}				
+			preload_scenes[i].queued = 0;
+			_release_preload_budget(&preload_scenes[i]);
+		}
+	}
 
-				if(param_list == item)
-				{
-					param_list = item->next;
-				}
-				found = item;
-				item = found->next;
-				res_array_free(found);
-			}
-			else
+	//the picture being preloaded may go to scene buffer, wait for it before unloading scene
+	if(os_current_get() != preload_tid)
+	{
+		while(preload_item_busy && (scene_id == 0 || preload_item_scene == scene_id))
+		{
+			os_condvar_wait(&preload_condvar, &preload_mutex, OS_FOREVER);
+		}
+	}
+
+	os_mutex_unlock(&preload_mutex);
+
+	item = canceled;
+	while(item != NULL)
+	{
+		next = item->next;
+		if(item->preload_type == PRELOAD_TYPE_END_CALLBACK)
+		{
+			if(item->scene_id > 0)
 			{
-				item = item->next;
+				res_manager_unload_scene(item->scene_id, NULL);
 			}
+			if (item->callback)
+				item->callback(LVGL_RES_PRELOAD_STATUS_CANCELED, item->param);
 		}
+		else if(item->preload_type != PRELOAD_TYPE_BEGIN_CALLBACK)
+		{
+			res_manager_free_resource_structure(item->bitmap);
+		}
+		res_array_free(item);
+//		_debug_sram_usage(0);
+		item = next;
 	}
-	
-	os_mutex_unlock(&preload_mutex);
 }
 
 void _pause_preload(void)
@@ -1193,12 +1569,13 @@ int lvgl_res_preload_pictures_from_scene(uint32_t scene_id, lvgl_res_scene_t* sc
 		if(scene_id > 0)
 		{
 			param->preload_type = PRELOAD_TYPE_NORMAL_COMPACT;
-			param->scene_id = scene_id;
 		}
 		else
 		{
 			param->preload_type = PRELOAD_TYPE_NORMAL;
 		}
+		param->scene_id = scene_id;
+		param->priority = LVGL_RES_PRELOAD_PRIORITY_NORMAL;
 		param->bitmap = bitmap;
 		param->next = NULL;
 		param->res_info = scene->res_info;
@@ -1242,12 +1619,13 @@ int lvgl_res_preload_pictures_from_group(uint32_t scene_id, lvgl_res_group_t* gr
 		if(scene_id > 0)
 		{
 			param->preload_type = PRELOAD_TYPE_NORMAL_COMPACT;
-			param->scene_id = scene_id;
 		}
 		else
 		{
 			param->preload_type = PRELOAD_TYPE_NORMAL;
 		}
+		param->scene_id = scene_id;
+		param->priority = LVGL_RES_PRELOAD_PRIORITY_NORMAL;
 		param->bitmap = bitmap;
 		param->next = NULL;
 		param->res_info = group->res_info;
@@ -1293,12 +1671,13 @@ int lvgl_res_preload_pictures_from_picregion(uint32_t scene_id, lvgl_res_picregi
 		if(scene_id > 0)
 		{
 			param->preload_type = PRELOAD_TYPE_NORMAL_COMPACT;
-			param->scene_id = scene_id;
 		}
 		else
 		{
 			param->preload_type = PRELOAD_TYPE_NORMAL;
 		}
+		param->scene_id = scene_id;
+		param->priority = LVGL_RES_PRELOAD_PRIORITY_NORMAL;
 		param->bitmap = bitmap;
 		param->next = NULL;
 		param->res_info = picreg->res_info;
@@ -1311,9 +1690,18 @@ int lvgl_res_preload_pictures_from_picregion(uint32_t scene_id, lvgl_res_picregi
 
 }
 
+static void _finish_preload_item(void)
+{
+	os_mutex_lock(&preload_mutex, OS_FOREVER);
+	preload_item_busy = 0;
+	os_condvar_broadcast(&preload_condvar);
+	os_mutex_unlock(&preload_mutex);
+}
+
 static void _res_preload_thread(void *parama1, void *parama2, void *parama3)
 {
 	preload_param_t* param_item;
+	preload_scene_t* scene;
 	int32_t ret = 0;
 
 	while(preload_running)
@@ -1334,11 +1722,19 @@ static void _res_preload_thread(void *parama1, void *parama2, void *parama3)
 
 		param_item = param_list;
 		param_list = param_item->next;
+		scene = _get_preload_scene(param_item->scene_id, 0);
+		if(scene != NULL && scene->queued > 0)
+		{
+			scene->queued--;
+		}
+		preload_item_busy = 1;
+		preload_item_scene = param_item->scene_id;
 		os_mutex_unlock(&preload_mutex);
 
 		if(preload_running == 2)
 		{
 //			k_sleep(K_MSEC(50));
+			_finish_preload_item();
 			continue;
 		}
 
@@ -1372,10 +1768,12 @@ static void _res_preload_thread(void *parama1, void *parama2, void *parama3)
 			SYS_LOG_ERR("unknown preload type: %d\n", param_item->preload_type);
 //			ret = res_manager_load_bitmap(param_item->res_info, param_item->bitmap);
 
+			_finish_preload_item();
 			continue;
 		}
 
 		res_array_free(param_item);
+		_finish_preload_item();
 //		_debug_sram_usage(0);
 //		k_sleep(K_MSEC(5));
 	}
@@ -1408,6 +1806,66 @@ int lvgl_res_preload_cancel_scene(uint32_t scene_id)
 	return 0;
 }
 
+int lvgl_res_preload_promote_scene(uint32_t scene_id)
+{
+	preload_scene_t* scene;
+	int ret = -1;
+
+	os_mutex_lock(&preload_mutex, OS_FOREVER);
+	scene = _get_preload_scene(scene_id, 0);
+	if(scene != NULL && scene->queued > 0)
+	{
+		ret = _promote_preload_scene(scene);
+		_release_preload_budget(scene);
+	}
+	os_mutex_unlock(&preload_mutex);
+
+	return ret;
+}
+
+int lvgl_res_preload_get_stat(uint32_t scene_id, lvgl_res_preload_stat_t* stat)
+{
+	preload_scene_t* scene;
+
+	if(stat == NULL)
+	{
+		return -1;
+	}
+
+	os_mutex_lock(&preload_mutex, OS_FOREVER);
+	scene = _get_preload_scene(scene_id, 0);
+	if(scene == NULL)
+	{
+		os_mutex_unlock(&preload_mutex);
+		return -1;
+	}
+	*stat = scene->stat;
+	os_mutex_unlock(&preload_mutex);
+
+	return 0;
+}
+
+void lvgl_res_preload_dump_stat(void)
+{
+	preload_scene_t* scene;
+	uint32_t i;
+
+	os_mutex_lock(&preload_mutex, OS_FOREVER);
+	printf("preload budget used %d/%d\n", preload_spec_size, RES_PRELOAD_BUDGET);
+	for(i=0;i<RES_PRELOAD_STAT_NUM;i++)
+	{
+		scene = &preload_scenes[i];
+		if(scene->stat.scene_id == 0)
+		{
+			continue;
+		}
+		printf("scene 0x%x: hit %d, miss %d, stall %d, dropped %d, queued %d, prio %d, size %d\n", 
+			scene->stat.scene_id, scene->stat.hit, scene->stat.miss, scene->stat.stall, scene->stat.dropped, 
+			scene->queued, scene->priority, scene->spec_size);
+	}
+	os_mutex_unlock(&preload_mutex);
+}
+
 int _res_preload_pictures_from_picregion(uint32_t scene_id, lvgl_res_picregion_t* picreg, uint32_t start, uint32_t end, preload_param_t** sublist)
 {
 	int32_t i;
@@ -1450,12 +1908,13 @@ int _res_preload_pictures_from_picregion(uint32_t scene_id, lvgl_res_picregion_t
 		if(scene_id > 0)
 		{
 			param->preload_type = PRELOAD_TYPE_NORMAL_COMPACT;
-			param->scene_id = scene_id;
 		}
 		else
 		{
 			param->preload_type = PRELOAD_TYPE_NORMAL;
 		}
+		param->scene_id = scene_id;
+		param->priority = LVGL_RES_PRELOAD_PRIORITY_NORMAL;
 		param->bitmap = bitmap;
 		param->next = NULL;
 		param->res_info = picreg->res_info;
@@ -1598,7 +2057,7 @@ int _res_preload_group_compact(resource_info_t* info, uint32_t scene_id, uint32_
 }
 
 int _res_preload_scene_compact(uint32_t scene_id, const uint32_t* resource_id, uint32_t resource_num, void (*callback)(int32_t, void *), void* user_data,
-											const char* style_path, const char* picture_path, const char* text_path, bool async_preload)
+											const char* style_path, const char* picture_path, const char* text_path, bool async_preload, uint32_t priority)
 {
 	resource_info_t* info;
 	preload_param_t* param;
@@ -1613,7 +2072,30 @@ int _res_preload_scene_compact(uint32_t scene_id, const uint32_t* resource_id, u
 	uint32_t offset = 0;
 	uint32_t total_size = 0;
 	uint32_t buf_block_struct_size = res_manager_get_bitmap_buf_block_unit_size();
+	uint32_t reserved_size = 0;
 	int picreg_count = 0;
+	int merged = -1;
+
+	if(async_preload)
+	{
+		merged = _merge_preload_scene(scene_id, callback, user_data, priority, &reserved_size);
+	}
+
+	if(merged == 0)
+	{
+		SYS_LOG_INF("scene 0x%x already in preload list\n", scene_id);
+		return 0;
+	}
+	else if(merged > 0)
+	{
+		//follow the queued part moved to list head
+		priority = LVGL_RES_PRELOAD_PRIORITY_HIGH;
+	}
+
+	if(priority > LVGL_RES_PRELOAD_PRIORITY_LOW)
+	{
+		_preload_scene_release(scene_id);
+	}
 
 	info = _res_file_open(style_path, picture_path, text_path, 0);
 	if(info == NULL)
@@ -1739,6 +2221,13 @@ int _res_preload_scene_compact(uint32_t scene_id, const uint32_t* resource_id, u
 
 		_add_item_to_list(&sublist, param);
 
+		_set_preload_priority(sublist, scene_id, priority);
+		if(async_preload && priority == LVGL_RES_PRELOAD_PRIORITY_LOW && RES_PRELOAD_BUDGET > 0)
+		{
+			total_size = _apply_preload_budget(sublist, scene_id);
+		}
+		total_size = total_size > reserved_size ? total_size - reserved_size : 0;
+
 		if(total_size > 0)
 		{
 			res_manager_init_compact_buffer(scene_id, total_size);	
@@ -1859,6 +2348,13 @@ int _res_preload_scene_compact(uint32_t scene_id, const uint32_t* resource_id, u
 	param->next = NULL;
 	_add_item_to_list(&sublist, param);
 
+	_set_preload_priority(sublist, scene_id, priority);
+	if(async_preload && priority == LVGL_RES_PRELOAD_PRIORITY_LOW && RES_PRELOAD_BUDGET > 0)
+	{
+		total_size = _apply_preload_budget(sublist, scene_id);
+	}
+	total_size = total_size > reserved_size ? total_size - reserved_size : 0;
+
 	if(total_size > 0)
 	{
 		res_manager_init_compact_buffer(scene_id, total_size);
@@ -1879,9 +2375,16 @@ int _res_preload_scene_compact(uint32_t scene_id, const uint32_t* resource_id, u
 
 int lvgl_res_preload_scene_compact(uint32_t scene_id, const uint32_t* resource_id, uint32_t resource_num, void (*callback)(int32_t, void *), void* user_data,
 											const char* style_path, const char* picture_path, const char* text_path)
+{
+	return lvgl_res_preload_scene_compact_priority(scene_id, resource_id, resource_num, callback, user_data, 
+											style_path, picture_path, text_path, LVGL_RES_PRELOAD_PRIORITY_NORMAL);
+}
+
+int lvgl_res_preload_scene_compact_priority(uint32_t scene_id, const uint32_t* resource_id, uint32_t resource_num, void (*callback)(int32_t, void *), void* user_data,
+											const char* style_path, const char* picture_path, const char* text_path, uint32_t priority)
 {
 	int ret;
-	ret = _res_preload_scene_compact(scene_id, resource_id, resource_num, callback, user_data, style_path, picture_path, text_path, 1);
+	ret = _res_preload_scene_compact(scene_id, resource_id, resource_num, callback, user_data, style_path, picture_path, text_path, 1, priority);
 	if(ret < 0)
 	{
 		SYS_LOG_ERR("preload failed 0x%x\n", scene_id);
@@ -1896,7 +2399,7 @@ int lvgl_res_preload_scene_compact_serial(uint32_t scene_id, const uint32_t* res
 {
 	int ret;
 	preload_param_t* param_item;
-	ret = _res_preload_scene_compact(scene_id, resource_id, resource_num, callback, user_data, style_path, picture_path, text_path, 0);
+	ret = _res_preload_scene_compact(scene_id, resource_id, resource_num, callback, user_data, style_path, picture_path, text_path, 0, LVGL_RES_PRELOAD_PRIORITY_NORMAL);
 	if(ret < 0)
 	{
 		SYS_LOG_ERR("preload failed 0x%x\n", scene_id);
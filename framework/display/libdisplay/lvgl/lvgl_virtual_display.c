@@ -213,14 +213,18 @@ static void surface_draw_handler(uint32_t event, void *data, void *user_data)
 		SYS_LOG_DBG("inv area (%d %d %d %d), old area (%d %d %d %d)\n", disp->inv_areas[0].x1, disp->inv_areas[0].y1, disp->inv_areas[0].x2, disp->inv_areas[0].y2,
 					cover_check->area->x1, cover_check->area->y1, cover_check->area->x2, cover_check->area->y2);
 
-		if (disp->inv_p == 1 &&
-			  disp->inv_areas[0].x1 <= cover_check->area->x1 &&
-			  disp->inv_areas[0].y1 <= cover_check->area->y1 &&
-			  disp->inv_areas[0].x2 >= cover_check->area->x2 &&
-			  disp->inv_areas[0].y2 >= cover_check->area->y2) {
-			  cover_check->covered = true;
-		} else {
-			  cover_check->covered = false;
+		cover_check->covered = false;
+
+		/* the area is redrawn if it is inside any invalidated area */
+		for (int i = 0; i < disp->inv_p; i++) {
+			if (!disp->inv_area_joined[i] &&
+				  disp->inv_areas[i].x1 <= cover_check->area->x1 &&
+				  disp->inv_areas[i].y1 <= cover_check->area->y1 &&
+				  disp->inv_areas[i].x2 >= cover_check->area->x2 &&
+				  disp->inv_areas[i].y2 >= cover_check->area->y2) {
+				cover_check->covered = true;
+				break;
+			}
 		}
 
 	}
@@ -6,10 +6,8 @@
 #include <memory/mem_cache.h>
 #include "res_manager_api.h"
 #include "res_mempool.h"
-#ifndef CONFIG_SIMULATOR
-#include "lz4.h"
-
-#else
+#include "lz4_stream.h"
+#ifdef CONFIG_SIMULATOR
 #include <fs/fs.h>
 
 #define FS_O_READ		0x01
@@ -38,6 +36,16 @@
 #define COMPACT_BUFFER_MAX_PAD_SIZE		4*1024
 #define COMPACT_BUFFER_MARGIN_SIZE		64
 
+#ifndef CONFIG_RES_MANAGER_LOAD_CHUNK_SIZE
+#define BITMAP_LOAD_CHUNK_SIZE			1024
+#else
+#define BITMAP_LOAD_CHUNK_SIZE			CONFIG_RES_MANAGER_LOAD_CHUNK_SIZE
+#endif
+
+//bitmap buffer state, other threads wait for a loading bitmap
+#define BITMAP_STATE_READY				0
+#define BITMAP_STATE_LOADING			1
+
 #define PACK __attribute__ ((packed))
 
 //以下宏定义资源图片的类型
@@ -107,6 +115,7 @@ typedef struct _buf_block_s
 	uint32_t format;
 	uint8_t* addr;
 	uint32_t regular_info;
+	uint32_t state;
 	struct _buf_block_s* next;
 }buf_block_t;
 
@@ -136,6 +145,9 @@ static int ui_mem_total = 0;
 
 os_mutex bitmap_cache_mutex;
 os_mutex bitmap_read_mutex;
+//signaled when a bitmap finished loading
+static os_condvar bitmap_load_condvar;
+static uint32_t bitmap_loading_num;
 
 //#define MAX_RES_VERSIONS 1
 //static const char* part_path[6] = {"/NAND:A/","/NAND:B","/NAND:C/","/NAND:D", "/NAND:E/","/NAND:F"};
@@ -627,6 +639,7 @@ uint8_t* _get_resource_bitmap_buffer_compact(uint32_t source, resource_bitmap_t*
 	}
 	item->next = bitmap_buffer.head;
 	item->regular_info = bitmap->regular_info;
+	item->state = BITMAP_STATE_LOADING;
 	bitmap_buffer.head = item;
 
 //	SYS_LOG_INF("\n\n cache bitmap %d return 0x%x\n", id, item->addr);
@@ -734,6 +747,7 @@ uint8_t* _get_resource_bitmap_buffer(uint32_t source, resource_bitmap_t* bitmap,
 		item->next = bitmap_buffer.head;
 		bitmap_buffer.head = item;
 		item->regular_info = bitmap->regular_info;
+		item->state = BITMAP_STATE_LOADING;
 #if RES_MEM_DEBUG
 		if(res_mem_check()<0)
 		{
@@ -753,14 +767,27 @@ uint8_t* _try_resource_bitmap_buffer(uint32_t source, resource_bitmap_t* bitmap,
 {
 	buf_block_t* item;
 
-	item = bitmap_buffer.head;
-	while(item != NULL)
+	bitmap->load_result = RES_BITMAP_LOAD_CACHED;
+	while(1)
 	{
-		if((item->source == source)&&(item->id == bitmap->sty_data->id))
+		item = bitmap_buffer.head;
+		while(item != NULL)
+		{
+			if((item->source == source)&&(item->id == bitmap->sty_data->id))
+			{
+				break;
+			}
+			item = item->next;
+		}
+
+		if(item == NULL || item->state != BITMAP_STATE_LOADING)
 		{
 			break;
 		}
-		item = item->next;
+
+		//being loaded by another thread, search again since it may be freed after loaded
+		bitmap->load_result = RES_BITMAP_LOAD_WAITED;
+		os_condvar_wait(&bitmap_load_condvar, &bitmap_cache_mutex, OS_FOREVER);
 	}
 
 	if(item != NULL)
@@ -1127,6 +1154,7 @@ void res_manager_init(void)
 
 		os_mutex_init(&bitmap_cache_mutex);
 		os_mutex_init(&bitmap_read_mutex);
+		os_condvar_init(&bitmap_load_condvar);
 		res_manager_inited = 1;
 	}
 }
@@ -1138,7 +1166,13 @@ void res_manager_set_screen_size(uint32_t screen_w, uint32_t screen_h)
 
 void res_manager_clear_cache(uint32_t force_clear)
 {
+	os_mutex_lock(&bitmap_cache_mutex, OS_FOREVER);
+	while(bitmap_loading_num > 0)
+	{
+		os_condvar_wait(&bitmap_load_condvar, &bitmap_cache_mutex, OS_FOREVER);
+	}
 	_resource_buffer_deinit(force_clear);
+	os_mutex_unlock(&bitmap_cache_mutex);
 }
 
 int32_t res_manager_set_str_file(resource_info_t* info, const char* text_path)
@@ -1683,6 +1717,38 @@ int32_t res_manager_clear_regular_pictures(const uint8_t* sty_path, uint32_t sce
 	return 0;
 }
 
+static uint32_t _scene_bitmap_loading(uint32_t scene_id)
+{
+	compact_buffer_t* buffer;
+	buf_block_t* item;
+
+	if(bitmap_loading_num == 0)
+	{
+		return 0;
+	}
+
+	item = bitmap_buffer.head;
+	while(item != NULL)
+	{
+		if(item->state == BITMAP_STATE_LOADING)
+		{
+			buffer = bitmap_buffer.compact_buffer_list;
+			while(buffer != NULL)
+			{
+				if(buffer->scene_id == scene_id && (uint8_t*)item >= buffer->addr
+					&& (uint8_t*)item < buffer->addr + buffer->offset)
+				{
+					return 1;
+				}
+				buffer = buffer->next;
+			}
+		}
+		item = item->next;
+	}
+
+	return 0;
+}
+
 void _unload_scene_bitmaps(uint32_t scene_id)
 {
 	compact_buffer_t* buffer = NULL;
@@ -1699,6 +1765,12 @@ void _unload_scene_bitmaps(uint32_t scene_id)
 	}
 
 	os_mutex_lock(&bitmap_cache_mutex, OS_FOREVER);
+	//scene buffers are still written by loading threads
+	while(_scene_bitmap_loading(scene_id))
+	{
+		os_condvar_wait(&bitmap_load_condvar, &bitmap_cache_mutex, OS_FOREVER);
+	}
+
 	buffer = bitmap_buffer.compact_buffer_list;
 	while(buffer != NULL)
 	{
@@ -1864,12 +1936,112 @@ int _search_res_id_in_files(resource_info_t* info, resource_bitmap_t* bitmap, ui
 	return mid;
 }
 
+//file is shared by loading threads, seek and read together
+//ahead bytes after the data are read in background if the fs supports it
+static int32_t _read_bitmap_data(void* pic_fp, uint32_t pos, void* buf, int32_t len, int32_t ahead)
+{
+	int32_t ret;
+
+	os_mutex_lock(&bitmap_read_mutex, OS_FOREVER);
+	res_fs_seek(pic_fp, pos, FS_SEEK_SET);
+	ret = res_fs_read(pic_fp, buf, len);
+	if(ret == len && ahead > 0)
+	{
+		res_fs_read_ahead(pic_fp, ahead);
+	}
+	os_mutex_unlock(&bitmap_read_mutex);
+
+	return ret;
+}
+
+//decompress from small chunks straight into bitmap buffer,
+//the next chunk is read ahead while the current one is decoded
+static int32_t _read_compressed_bitmap(void* pic_fp, uint32_t pos, int32_t compress_size, uint8_t* buf, int32_t bmp_size)
+{
+	lz4_stream_t stream;
+	uint8_t* chunk_buf;
+	int32_t offset = 0;
+	int32_t len;
+	int32_t ahead;
+	int32_t ret;
+
+	//res mem bookkeeping is not thread safe, other loaders alloc under the cache lock too
+	os_mutex_lock(&bitmap_cache_mutex, OS_FOREVER);
+	chunk_buf = (uint8_t*)res_mem_alloc(RES_MEM_POOL_BMP, BITMAP_LOAD_CHUNK_SIZE);
+	os_mutex_unlock(&bitmap_cache_mutex);
+	if(chunk_buf == NULL)
+	{
+		SYS_LOG_ERR("error: no buffer to load compressed bitmap");
+		return -1;
+	}
+
+	lz4_stream_init(&stream, buf, bmp_size);
+	while(offset < compress_size)
+	{
+		len = compress_size - offset;
+		if(len > BITMAP_LOAD_CHUNK_SIZE)
+		{
+			len = BITMAP_LOAD_CHUNK_SIZE;
+		}
+
+		ahead = compress_size - offset - len;
+		if(ahead > BITMAP_LOAD_CHUNK_SIZE)
+		{
+			ahead = BITMAP_LOAD_CHUNK_SIZE;
+		}
+
+		ret = _read_bitmap_data(pic_fp, pos + offset, chunk_buf, len, ahead);
+		if(ret < len)
+		{
+			SYS_LOG_ERR("bitmap read error %d\n", ret);
+			break;
+		}
+
+		if(lz4_stream_decode(&stream, chunk_buf, len) < 0)
+		{
+			break;
+		}
+		offset += len;
+	}
+
+	os_mutex_lock(&bitmap_cache_mutex, OS_FOREVER);
+	res_mem_free(RES_MEM_POOL_BMP, chunk_buf);
+	os_mutex_unlock(&bitmap_cache_mutex);
+
+	if(offset < compress_size)
+	{
+		return -1;
+	}
+
+	return lz4_stream_finish(&stream);
+}
+
+static void _bitmap_load_done(uint8_t* addr)
+{
+	buf_block_t* item;
+
+	os_mutex_lock(&bitmap_cache_mutex, OS_FOREVER);
+	item = bitmap_buffer.head;
+	while(item != NULL)
+	{
+		if(item->addr == addr)
+		{
+			item->state = BITMAP_STATE_READY;
+			break;
+		}
+		item = item->next;
+	}
+
+	bitmap_loading_num--;
+	os_condvar_broadcast(&bitmap_load_condvar);
+	os_mutex_unlock(&bitmap_cache_mutex);
+}
+
 int32_t _load_bitmap(resource_info_t* info, resource_bitmap_t* bitmap, uint32_t force_ref)
 {
 	int32_t ret;
 	int32_t bmp_size;
 	int32_t compress_size = 0;
-	uint8_t *compress_buf = NULL;
 #ifdef CONFIG_RES_MANAGER_USE_SDFS
 	struct sd_file** pic_fp;
 #else
@@ -1903,6 +2075,7 @@ int32_t _load_bitmap(resource_info_t* info, resource_bitmap_t* bitmap, uint32_t
 		return 0;
 	}
 	
+	bitmap->load_result = RES_BITMAP_LOAD_FILE;
 	bmp_size = bitmap->sty_data->width * bitmap->sty_data->height * bitmap->sty_data->bytes_per_pixel;
 //	SYS_LOG_ERR("styid 0x%x, id %d, wh %d, %d ,bmp_size %d\n", bitmap->sty_data->sty_id, bitmap->sty_data->id, bitmap->sty_data->width, bitmap->sty_data->height, bmp_size);
 	bitmap->buffer = _get_resource_bitmap_buffer((uint32_t)info, bitmap, bmp_size, force_ref);
@@ -1913,6 +2086,10 @@ int32_t _load_bitmap(resource_info_t* info, resource_bitmap_t* bitmap, uint32_t
 		os_strace_end_call_u32(SYS_TRACE_ID_RES_BMP_LOAD_0, (uint32_t)bitmap->sty_data->id);
 		return -1;
 	}
+
+	//buffer is marked loading, other threads wait for it instead of the whole load
+	bitmap_loading_num++;
+	os_mutex_unlock(&bitmap_cache_mutex);
 	os_strace_end_call_u32(SYS_TRACE_ID_RES_BMP_LOAD_0, (uint32_t)bitmap->sty_data->id);	
 	os_strace_u32(SYS_TRACE_ID_RES_BMP_LOAD_1, (uint32_t)bitmap->sty_data->id);
 
@@ -1927,45 +2104,24 @@ int32_t _load_bitmap(resource_info_t* info, resource_bitmap_t* bitmap, uint32_t
 	}
 	
 //	SYS_LOG_INF("\n pres_entry length %d, type %d, offset 0x%x \n", pres_entry->length, pres_entry->type, pres_entry->offset);
-	res_fs_seek(pic_fp, bmp_pos, FS_SEEK_SET);
-
 	compress_size = bitmap->sty_data->compress_size;
 	if (compress_size > 0)
 	{
-		compress_buf = (uint8_t*)res_mem_alloc(RES_MEM_POOL_BMP, compress_size);
-		if(compress_buf == NULL)
-		{
-			SYS_LOG_ERR("error: no buffer to load compressed bitmap");
-			os_mutex_unlock(&bitmap_cache_mutex);
-			os_strace_end_call_u32(SYS_TRACE_ID_RES_BMP_LOAD_1, (uint32_t)bitmap->sty_data->id);
-			return -1;
-		}
-		
-		ret = res_fs_read(pic_fp, compress_buf, compress_size);
-		if(ret < compress_size)
-		{
-			SYS_LOG_ERR("bitmap read error %d\n", ret);
-		}
-
 		os_strace_end_call_u32(SYS_TRACE_ID_RES_BMP_LOAD_1, (uint32_t)bitmap->sty_data->id);	
 		os_strace_u32(SYS_TRACE_ID_RES_BMP_LOAD_2, (uint32_t)bitmap->sty_data->id);
-		if(ret == compress_size)
-		{
-			ret = LZ4_decompress_safe(compress_buf, bitmap->buffer, compress_size, bmp_size);
-		}
-		res_mem_free(RES_MEM_POOL_BMP, compress_buf);
+		ret = _read_compressed_bitmap(pic_fp, bmp_pos, compress_size, bitmap->buffer, bmp_size);
 		os_strace_end_call_u32(SYS_TRACE_ID_RES_BMP_LOAD_2, (uint32_t)bitmap->sty_data->id);
 	}
 	else
 	{
-		ret = res_fs_read(pic_fp, bitmap->buffer, bmp_size);
+		ret = _read_bitmap_data(pic_fp, bmp_pos, bitmap->buffer, bmp_size, 0);
 		os_strace_end_call_u32(SYS_TRACE_ID_RES_BMP_LOAD_1, (uint32_t)bitmap->sty_data->id);	
 	}
 	
 	if(ret < bmp_size)
 	{
-		SYS_LOG_ERR("bitmap load error %d, compress_buf %p, compress_size %d, styid 0x%x, id %d, w %d, h %d, bmp_size %d, buffer %p, bmp_pos 0x%x\n", 
-			ret, compress_buf, compress_size, bitmap->sty_data->sty_id, bitmap->sty_data->id, bitmap->sty_data->width, bitmap->sty_data->height, 
+		SYS_LOG_ERR("bitmap load error %d, compress_size %d, styid 0x%x, id %d, w %d, h %d, bmp_size %d, buffer %p, bmp_pos 0x%x\n", 
+			ret, compress_size, bitmap->sty_data->sty_id, bitmap->sty_data->id, bitmap->sty_data->width, bitmap->sty_data->height, 
 			bmp_size, bitmap->buffer, bmp_pos);
 	}
 
@@ -1986,7 +2142,7 @@ int32_t _load_bitmap(resource_info_t* info, resource_bitmap_t* bitmap, uint32_t
 	}
 #endif		
 
-	os_mutex_unlock(&bitmap_cache_mutex);
+	_bitmap_load_done(bitmap->buffer);
 	return 0;
 }
 
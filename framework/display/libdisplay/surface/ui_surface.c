@@ -20,6 +20,9 @@
 
 #define OPT_SWAP_COPY_W_2PX 1
 
+/* estimated overhead of one swap copy job, in pixels */
+#define SWAP_COPY_JOB_COST 1024
+
 #ifdef CONFIG_DMA2D_HAL
 typedef struct surface_dma2d_context {
 	hal_dma2d_handle_t hdma2d;
@@ -33,6 +36,7 @@ typedef struct surface_dma2d_context {
 #endif
 
 #if CONFIG_SURFACE_MAX_BUFFER_COUNT > 1
+static void _surface_add_dirty_rect(surface_t *surface, const ui_region_t *area);
 static void _surface_swapbuf(surface_t *surface);
 static void _surface_swapbuf_wait_finish(surface_t *surface);
 
@@ -155,6 +159,10 @@ int surface_set_min_buffer_count(surface_t *surface, uint8_t min_count)
 
 		/* invalidate the new dirty area */
 		ui_region_set(&surface->dirty_area, 0, 0, surface->width - 1, surface->height - 1);
+#if CONFIG_SURFACE_MAX_BUFFER_COUNT > 1
+		ui_region_copy(&surface->dirty_rects[0], &surface->dirty_area);
+		surface->dirty_cnt = 1;
+#endif
 
 		SYS_LOG_DBG("buf count %d", surface->buf_count);
 	}
@@ -270,21 +278,32 @@ void surface_begin_frame(surface_t *surface)
 #if CONFIG_SURFACE_MAX_BUFFER_COUNT > 0
 #if CONFIG_SURFACE_MAX_BUFFER_COUNT > 1
 	if (surface->buf_count == 2) {
-		surface_cover_check_data_t cover_check_data = {
-			.area = &surface->dirty_area,
-			.covered = ui_region_is_empty(&surface->dirty_area),
-		};
-
-		if (!cover_check_data.covered && surface->callback[SURFACE_CB_DRAW]) {
-			surface->callback[SURFACE_CB_DRAW](SURFACE_EVT_DRAW_COVER_CHECK,
-					&cover_check_data, surface->user_data[SURFACE_CB_DRAW]);
+		uint8_t dirty_cnt = 0;
+
+		/* only copy the dirty areas not covered by the drawing of this frame */
+		for (int i = 0; i < surface->dirty_cnt; i++) {
+			surface_cover_check_data_t cover_check_data = {
+				.area = &surface->dirty_rects[i],
+				.covered = false,
+			};
+
+			if (surface->callback[SURFACE_CB_DRAW]) {
+				surface->callback[SURFACE_CB_DRAW](SURFACE_EVT_DRAW_COVER_CHECK,
+						&cover_check_data, surface->user_data[SURFACE_CB_DRAW]);
+			}
+
+			SYS_LOG_DBG("dirty (%d %d %d %d), covered %d",
+				surface->dirty_rects[i].x1, surface->dirty_rects[i].y1,
+				surface->dirty_rects[i].x2, surface->dirty_rects[i].y2, cover_check_data.covered);
+
+			if (!cover_check_data.covered) {
+				ui_region_copy(&surface->dirty_rects[dirty_cnt++], &surface->dirty_rects[i]);
+			}
 		}
 
-		SYS_LOG_DBG("dirty (%d %d %d %d), covered %d",
-			surface->dirty_area.x1, surface->dirty_area.y1,
-			surface->dirty_area.x2, surface->dirty_area.y2, cover_check_data.covered);
+		surface->dirty_cnt = dirty_cnt;
 
-		if (!cover_check_data.covered) {
+		if (dirty_cnt > 0) {
 			/* wait backbuf available */
 			while (atomic_get(&surface->post_pending_cnt) >= surface->buf_count) {
 				SYS_LOG_DBG("%p wait post", surface);
@@ -297,6 +316,8 @@ void surface_begin_frame(surface_t *surface)
 			_surface_swapbuf(surface);
 		}
 	}
+
+	surface->dirty_cnt = 0;
 #endif /* CONFIG_SURFACE_MAX_BUFFER_COUNT > 1 */
 
 	ui_region_set(&surface->dirty_area, surface->width, surface->height, 0, 0);
@@ -351,6 +372,11 @@ void surface_end_draw(surface_t *surface, const ui_region_t *area, const void *b
 	/* post based on frame */
 #if CONFIG_SURFACE_MAX_BUFFER_COUNT > 0
 	ui_region_merge(&surface->dirty_area, &surface->dirty_area, area);
+#if CONFIG_SURFACE_MAX_BUFFER_COUNT > 1
+	if (surface->buf_count > 1) {
+		_surface_add_dirty_rect(surface, area);
+	}
+#endif
 
 	_surface_invoke_draw_ready(surface);
 
@@ -448,6 +474,114 @@ static void _surface_dma2d_init(void)
 }
 #endif /* CONFIG_DMA2D_HAL */
 
+static inline int32_t _surface_copy_cost(const ui_region_t *region)
+{
+	return SWAP_COPY_JOB_COST + ui_region_get_size(region);
+}
+
+static inline void _surface_remove_dirty_rect(surface_t *surface, int idx)
+{
+	surface->dirty_cnt--;
+	ui_region_copy(&surface->dirty_rects[idx], &surface->dirty_rects[surface->dirty_cnt]);
+}
+
+/*
+ * Add an area to the dirty rects which are kept non-overlapping.
+ *
+ * The area is merged with a dirty rect when one copy job of their bounding
+ * box costs less than the separate jobs, otherwise the parts not covered by
+ * the dirty rects are added. If the rects run out, the area is merged with
+ * the rect of least cost increase.
+ */
+static void _surface_add_dirty_rect(surface_t *surface, const ui_region_t *area)
+{
+	ui_region_t *rects = surface->dirty_rects;
+	ui_region_t pieces[CONFIG_SURFACE_DIRTY_AREA_NUM + 3];
+	ui_region_t new_area;
+	ui_region_t merged;
+	int num_pieces;
+	int32_t cost = INT32_MAX;
+	int i, j, k;
+
+	if (ui_region_is_empty(area))
+		return;
+
+	ui_region_copy(&new_area, area);
+
+restart:
+	for (i = 0; i < surface->dirty_cnt; i++) {
+		if (ui_region_is_in(&new_area, &rects[i]))
+			return;
+
+		if (ui_region_is_in(&rects[i], &new_area)) {
+			_surface_remove_dirty_rect(surface, i--);
+			continue;
+		}
+
+		cost = _surface_copy_cost(&rects[i]);
+		if (ui_region_is_on(&rects[i], &new_area)) {
+			num_pieces = ui_region_subtract(pieces, &new_area, &rects[i]);
+			for (k = 0; k < num_pieces; k++)
+				cost += _surface_copy_cost(&pieces[k]);
+		} else {
+			cost += _surface_copy_cost(&new_area);
+		}
+
+		ui_region_merge(&merged, &rects[i], &new_area);
+		if (_surface_copy_cost(&merged) <= cost) {
+			ui_region_copy(&new_area, &merged);
+			_surface_remove_dirty_rect(surface, i);
+			goto restart;
+		}
+	}
+
+	/* split the area into the parts not overlapping with the dirty rects */
+	ui_region_copy(&pieces[0], &new_area);
+	num_pieces = 1;
+
+	for (i = 0; i < surface->dirty_cnt && num_pieces > 0; i++) {
+		for (j = num_pieces - 1; j >= 0; j--) {
+			ui_region_t parts[4];
+			int num_parts;
+
+			if (!ui_region_is_on(&pieces[j], &rects[i]))
+				continue;
+
+			num_parts = ui_region_subtract(parts, &pieces[j], &rects[i]);
+			if (num_pieces - 1 + num_parts > (int)ARRAY_SIZE(pieces))
+				goto merge_nearest;
+
+			ui_region_copy(&pieces[j], &pieces[--num_pieces]);
+			for (k = 0; k < num_parts; k++)
+				ui_region_copy(&pieces[num_pieces++], &parts[k]);
+		}
+	}
+
+	if (surface->dirty_cnt + num_pieces <= CONFIG_SURFACE_DIRTY_AREA_NUM) {
+		for (k = 0; k < num_pieces; k++)
+			ui_region_copy(&rects[surface->dirty_cnt++], &pieces[k]);
+		return;
+	}
+
+merge_nearest:
+	j = 0;
+	cost = INT32_MAX;
+	for (i = 0; i < surface->dirty_cnt; i++) {
+		int32_t increase;
+
+		ui_region_merge(&merged, &rects[i], &new_area);
+		increase = _surface_copy_cost(&merged) - _surface_copy_cost(&rects[i]);
+		if (increase < cost) {
+			cost = increase;
+			j = i;
+		}
+	}
+
+	ui_region_merge(&new_area, &new_area, &rects[j]);
+	_surface_remove_dirty_rect(surface, j);
+	goto restart;
+}
+
 static void _surface_swapbuf_copy(graphic_buffer_t *backbuf, graphic_buffer_t *frontbuf, const ui_region_t *region)
 {
 	uint8_t *backptr = (uint8_t *)graphic_buffer_get_bufptr(backbuf, region->x1, region->y1);
@@ -563,8 +697,20 @@ static void _surface_swapbuf(surface_t *surface)
 	os_strace_u32(SYS_TRACE_ID_VIEW_SWAPBUF, view->entry->id);
 #endif
 
-	_surface_swapbuf_copy(backbuf, frontbuf, &surface->dirty_area);
-	SYS_LOG_DBG("%p swap %p->%p", surface, frontbuf, backbuf);
+	/* the dma2d copy jobs are queued, and waited in _surface_swapbuf_wait_finish() */
+	surface->swap_bytes = 0;
+	for (int i = 0; i < surface->dirty_cnt; i++) {
+		_surface_swapbuf_copy(backbuf, frontbuf, &surface->dirty_rects[i]);
+		surface->swap_bytes += ui_region_get_size(&surface->dirty_rects[i]);
+	}
+
+	surface->swap_bytes *= graphic_buffer_get_bits_per_pixel(backbuf) / 8;
+	surface->swap_jobs = surface->dirty_cnt;
+	if (surface->swap_bytes > surface->swap_max_bytes)
+		surface->swap_max_bytes = surface->swap_bytes;
+
+	SYS_LOG_DBG("%p swap %p->%p, %u bytes in %u jobs", surface, frontbuf, backbuf,
+			surface->swap_bytes, surface->swap_jobs);
 
 #ifdef CONFIG_TRACING
 	os_strace_end_call_u32(SYS_TRACE_ID_VIEW_SWAPBUF, view->entry->id);
@@ -901,5 +901,19 @@ ssize_t res_fs_read(void* handle, void* buffer, size_t len)
 	return ret;
 }
 
+int res_fs_read_ahead(void* handle, size_t len)
+{
+#ifdef CONFIG_RES_MANAGER_USE_SDFS
+	struct sd_file** sdh = (struct sd_file**)handle;
+	if(*sdh == NULL)
+	{
+		return 0;
+	}
+	return sd_fread_hint(*sdh, len);
+#else
+	return 0;
+#endif
+}
+
 
 
@@ -1139,6 +1139,7 @@ uint8_t* _try_resource_bitmap_buffer(uint32_t source, resource_bitmap_t* bitmap,
 	{
 		//found loaded bitmap
 		bitmap->regular_info = item->regular_info;
+		bitmap->load_result = RES_BITMAP_LOAD_CACHED;
 		if(force_ref == 1)
 		{
 			item->ref ++;
@@ -1544,6 +1545,7 @@ int32_t _load_bitmap(resource_info_t* info, resource_bitmap_t* bitmap, uint32_t
 		return 0;
 	}
 	
+	bitmap->load_result = RES_BITMAP_LOAD_FILE;
 	bmp_size = bitmap->sty_data->width * bitmap->sty_data->height * bitmap->sty_data->bytes_per_pixel;
 //	SYS_LOG_ERR("styid 0x%x, id %d, wh %d, %d ,bmp_size %d\n", bitmap->sty_data->sty_id, bitmap->sty_data->id, bitmap->sty_data->width, bitmap->sty_data->height, bmp_size);
 	bitmap->buffer = _get_resource_bitmap_buffer((uint32_t)info, bitmap, bmp_size, force_ref);
@@ -167,7 +167,7 @@ int ui_region_subtract(ui_region_t * result, const ui_region_t * region, const u
 	int cnt = 0;
 
 	if (region->x1 >= exclude->x1 && region->y1 >= exclude->y1 &&
-		region->x2 <= exclude->x1 && region->y2 <= exclude->y1) {
+		region->x2 <= exclude->x2 && region->y2 <= exclude->y2) {
 		return 0;
 	}
 
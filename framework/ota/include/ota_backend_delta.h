@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief OTA delta backend interface
+ *
+ * The delta backend wraps a transport backend (bluetooth, sdcard, usbhid).
+ * If the image on the transport is a delta image, the full ota image is
+ * rebuilt block by block from the current firmware files plus the diff,
+ * so the upgrade core still reads a normal ota image. Other images are
+ * passed through.
+ *
+ * Delta image layout (little endian):
+ *
+ *   struct ota_delta_head
+ *   struct ota_delta_src        src_num entries
+ *   struct ota_delta_block      block_num entries
+ *   block data                  one op stream for each block
+ *
+ * Each block of the new image is decoded alone, so any offset can be read
+ * after a breakpoint without the blocks before it.
+ *
+ * Block op stream, values are LEB128 varints:
+ *   OTA_DELTA_OP_LIT  len, data[len]
+ *   OTA_DELTA_OP_COPY len, src, zigzag(src_offs - last_src_end)
+ *   OTA_DELTA_OP_ADD  len, src, zigzag(src_offs - last_src_end),
+ *                     then (zero_run, lit_run, diff[lit_run]) pairs until
+ *                     len bytes are covered, new = old + diff
+ *   OTA_DELTA_OP_LZ4  len, clen, data[clen], a literal run as one LZ4 block
+ *
+ * Version 1 images have no LZ4 ops, they are made for devices without
+ * CONFIG_OTA_BACKEND_DELTA_LZ4.
+ */
+
+#ifndef __OTA_BACKEND_DELTA_H__
+#define __OTA_BACKEND_DELTA_H__
+
+#include <ota_backend.h>
+
+#define OTA_DELTA_MAGIC			0x544c4444	/* "DDLT" */
+#define OTA_DELTA_VERSION		2
+#define OTA_DELTA_VERSION_NO_LZ4	1
+
+#define OTA_DELTA_MAX_SRC		4
+
+#define OTA_DELTA_OP_LIT		1
+#define OTA_DELTA_OP_COPY		2
+#define OTA_DELTA_OP_ADD		3
+#define OTA_DELTA_OP_LZ4		4
+
+struct ota_delta_head {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t head_size;
+	uint32_t new_size;	/* size of the rebuilt ota image */
+	uint32_t new_crc;
+	uint32_t delta_size;	/* size of the delta image */
+	uint32_t block_size;
+	uint32_t block_num;
+	uint8_t src_num;
+	uint8_t reserved[35];
+} __attribute__((packed));
+
+/* old file used as source, read from its current partition */
+struct ota_delta_src {
+	uint8_t file_id;
+	uint8_t reserved[3];
+	uint32_t size;
+	uint32_t crc;
+	uint32_t reserved2;
+} __attribute__((packed));
+
+struct ota_delta_block {
+	uint32_t data_end;	/* end offset of block data in the delta image */
+	uint32_t crc;		/* crc32 of the rebuilt block */
+} __attribute__((packed));
+
+/**
+ * @brief ota backend delta init.
+ *
+ * This routine wraps the transport backend. The notify callback of the
+ * transport backend is redirected, so the ota app attaches the delta
+ * backend instead. Calling it again for the same transport backend
+ * returns the same delta backend.
+ *
+ * @param backend transport backend
+ *
+ *return delta backend if init success.
+ *return NULL if init fail.
+ */
+
+struct ota_backend *ota_backend_delta_init(struct ota_backend *backend);
+
+/**
+ * @brief ota backend delta exit.
+ *
+ * This routine frees the delta backend, the transport backend is kept.
+ *
+ * @param backend pointer to delta backend
+ */
+
+void ota_backend_delta_exit(struct ota_backend *backend);
+
+#endif /* __OTA_BACKEND_DELTA_H__ */
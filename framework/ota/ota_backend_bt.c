@@ -26,6 +26,7 @@
 #define TLV_TYPE_OTA_TYPE					0x0A
 
 #define OTA_SUPPORT_FEATURE_UNIT_DATA_CRC	(1 << 0)
+#define OTA_SUPPORT_FEATURE_WINDOW		(1 << 1)
 #define OTA_ERROR_CODE_SUCCESS		100000
 #define OTA_ERROR_CODE_OTA_TYPE_FAIL	100010
 
@@ -84,6 +85,10 @@ struct svc_prot_context {
 	int negotiation_done;
 	ota_backend_type_cb_t ota_type_cb;
 	int ota_type; // 0: app ota 1: factory ota 2: PC config ota
+#ifdef CONFIG_OTA_BT_WINDOW
+	/* data units are received by window thread */
+	uint8_t windowed;
+#endif
 };
 
 struct svc_prot_head {
@@ -120,6 +125,83 @@ struct ota_backend_bt {
 /* for sppble_stream callback */
 static struct ota_backend_bt *g_backend_bt;
 
+#ifdef CONFIG_OTA_BT_WINDOW
+/* max bad units re-requested for each region */
+#define OTA_BT_WINDOW_REPAIR_MAX	4
+#define OTA_BT_WINDOW_XFER_NUM		(CONFIG_OTA_BT_WINDOW_NUM * (1 + OTA_BT_WINDOW_REPAIR_MAX))
+
+enum ota_bt_region_state {
+	REGION_STATE_FREE,
+	REGION_STATE_BUSY,
+	REGION_STATE_DONE,
+	REGION_STATE_ERROR,
+};
+
+/* prefetch region, one buffer of the window */
+struct ota_bt_region {
+	uint8_t *buf;
+	uint32_t offset;
+	int len;
+	int done_len;		/* may be less than len at the end of image */
+	uint8_t state;
+	uint8_t pending;	/* outstanding transfers of this region */
+	uint8_t repairs;
+	uint8_t failed;
+};
+
+/* one require image data request on air */
+struct ota_bt_xfer {
+	struct ota_bt_region *region;
+	uint32_t offset;
+	uint8_t *buf;
+	int len;
+	uint8_t sent;
+	uint8_t repair;
+};
+
+struct ota_bt_hole {
+	uint16_t pos;
+	uint16_t len;
+};
+
+struct ota_bt_window {
+	struct svc_prot_context *ctx;
+	struct ota_bt_region regions[CONFIG_OTA_BT_WINDOW_NUM];
+	uint8_t region_head;
+	uint8_t region_num;
+
+	struct ota_bt_xfer xfers[OTA_BT_WINDOW_XFER_NUM];
+	uint8_t xfer_head;
+	uint8_t xfer_num;
+
+	/* bad crc units of the current transfer */
+	struct ota_bt_hole holes[OTA_BT_WINDOW_REPAIR_MAX];
+	uint8_t hole_num;
+
+	uint8_t thread_started;
+	os_mutex lock;
+	os_sem work_sem;
+	os_sem done_sem;
+};
+
+static struct ota_bt_window ota_bt_win;
+static char ota_bt_window_stack[CONFIG_OTA_BT_WINDOW_STACK_SIZE] __aligned(Z_THREAD_MIN_STACK_ALIGN);
+
+static int ota_bt_window_add_hole(struct svc_prot_context *ctx, int pos, int len)
+{
+	struct ota_bt_window *win = &ota_bt_win;
+
+	if (!ctx->windowed || win->hole_num >= OTA_BT_WINDOW_REPAIR_MAX)
+		return -EIO;
+
+	win->holes[win->hole_num].pos = pos;
+	win->holes[win->hole_num].len = len;
+	win->hole_num++;
+
+	return 0;
+}
+#endif
+
 static int svc_prot_get_rx_data(struct svc_prot_context *ctx, uint8_t *buf, int size)
 {
 	int read_size;
@@ -397,6 +479,9 @@ int ota_cmd_h2d_request_upgrade(struct svc_prot_context *ctx, uint16_t param_siz
 	if (ctx->host_features) {
 #ifdef CONFIG_OTA_BT_SUPPORT_UNIT_CRC
 		device_features |= OTA_SUPPORT_FEATURE_UNIT_DATA_CRC;
+#endif
+#ifdef CONFIG_OTA_BT_WINDOW
+		device_features |= OTA_SUPPORT_FEATURE_WINDOW;
 #endif
 		send_buf = TLV_PACK_U8(send_buf, TLV_TYPE_OTA_SUPPORT_FEATURES, device_features);
 		SYS_LOG_INF("device support features: 0x%x", 0);
@@ -479,24 +564,11 @@ int ota_cmd_h2d_negotiation_result(struct svc_prot_context *ctx, uint16_t param_
 	return 0;
 }
 
-int ota_cmd_require_image_data(struct svc_prot_context *ctx, uint32_t offset, int len, uint8_t *buf)
+static int ota_cmd_send_require_image_data(struct svc_prot_context *ctx, uint32_t offset, int len)
 {
 	uint8_t read_mask, *send_buf;
 	int err, send_len;
 
-	SYS_LOG_DBG("offset 0x%x, len %d, buf %p, \n", offset, len, buf);
-
-	if (!ctx->negotiation_done) {
-		SYS_LOG_ERR("negotiation not done");
-		return -EIO;
-
-	}
-
-	ctx->read_buf = buf;
-	ctx->read_len = len;
-	ctx->read_done_len = 0;
-	ctx->last_psn = 0xff;
-
 	read_mask = 0x0;
 
 	send_buf = ctx->send_buf + sizeof(struct svc_prot_head);
@@ -512,6 +584,30 @@ int ota_cmd_require_image_data(struct svc_prot_context *ctx, uint32_t offset, in
 		return err;
 	}
 
+	return 0;
+}
+
+int ota_cmd_require_image_data(struct svc_prot_context *ctx, uint32_t offset, int len, uint8_t *buf)
+{
+	int err;
+
+	SYS_LOG_DBG("offset 0x%x, len %d, buf %p, \n", offset, len, buf);
+
+	if (!ctx->negotiation_done) {
+		SYS_LOG_ERR("negotiation not done");
+		return -EIO;
+
+	}
+
+	ctx->read_buf = buf;
+	ctx->read_len = len;
+	ctx->read_done_len = 0;
+	ctx->last_psn = 0xff;
+
+	err = ota_cmd_send_require_image_data(ctx, offset, len);
+	if (err)
+		return err;
+
 	ctx->state = PROT_STATE_IDLE;
 
 	return 0;
@@ -555,6 +651,16 @@ int ota_cmd_h2d_send_image_data(struct svc_prot_context *ctx, uint16_t param_len
 		param_len -= sizeof(uint32_t);
 	}
 
+#ifdef CONFIG_OTA_BT_WINDOW
+	/* empty unit means the request is beyond the end of image */
+	if (ctx->windowed && param_len == 0) {
+		ctx->read_len = ctx->read_done_len;
+		ctx->last_psn = psn;
+		ctx->state = PROT_STATE_IDLE;
+		return 0;
+	}
+#endif
+
 	seg_len = ctx->read_len - ctx->read_done_len;
 	if (seg_len > param_len) {
 		seg_len = param_len;
@@ -572,7 +678,14 @@ int ota_cmd_h2d_send_image_data(struct svc_prot_context *ctx, uint16_t param_len
 		if (crc != crc_orig) {
 			SYS_LOG_ERR("psn%d: crc check error, orig 0x%x != 0x%x",
 				psn, crc_orig, crc);
+#ifdef CONFIG_OTA_BT_WINDOW
+			/* keep receiving, the bad unit is re-requested later */
+			err = ota_bt_window_add_hole(ctx, ctx->read_done_len, seg_len);
+			if (err)
+				return err;
+#else
 			return -EIO;
+#endif
 		}
 	}
 
@@ -715,6 +828,366 @@ int wait_negotiation_done(struct svc_prot_context *ctx)
 	return err;
 }
 
+#ifdef CONFIG_OTA_BT_WINDOW
+static struct ota_bt_region *ota_bt_window_region(struct ota_bt_window *win, int index)
+{
+	return &win->regions[(win->region_head + index) % CONFIG_OTA_BT_WINDOW_NUM];
+}
+
+/* called with window lock held */
+static struct ota_bt_xfer *ota_bt_window_queue(struct ota_bt_window *win,
+		struct ota_bt_region *region, uint32_t offset, uint8_t *buf, int len)
+{
+	struct ota_bt_xfer *xfer;
+
+	if (win->xfer_num >= OTA_BT_WINDOW_XFER_NUM)
+		return NULL;
+
+	xfer = &win->xfers[(win->xfer_head + win->xfer_num) % OTA_BT_WINDOW_XFER_NUM];
+	xfer->region = region;
+	xfer->offset = offset;
+	xfer->buf = buf;
+	xfer->len = len;
+	xfer->sent = 0;
+	xfer->repair = 0;
+
+	win->xfer_num++;
+	region->pending++;
+
+	os_sem_give(&win->work_sem);
+
+	return xfer;
+}
+
+/* called with window lock held */
+static struct ota_bt_region *ota_bt_window_request(struct ota_bt_window *win,
+						   uint32_t offset, int len)
+{
+	struct ota_bt_region *region;
+
+	if (win->region_num >= CONFIG_OTA_BT_WINDOW_NUM ||
+	    win->xfer_num >= OTA_BT_WINDOW_XFER_NUM)
+		return NULL;
+
+	region = ota_bt_window_region(win, win->region_num);
+	region->offset = offset;
+	region->len = len;
+	region->done_len = 0;
+	region->state = REGION_STATE_BUSY;
+	region->pending = 0;
+	region->repairs = 0;
+	region->failed = 0;
+
+	win->region_num++;
+	ota_bt_window_queue(win, region, offset, region->buf, len);
+
+	return region;
+}
+
+/* called with window lock held, request the regions following the last one */
+static void ota_bt_window_prefetch(struct ota_bt_window *win)
+{
+	struct ota_bt_region *last;
+
+	while (win->region_num > 0 && win->region_num < CONFIG_OTA_BT_WINDOW_NUM) {
+		last = ota_bt_window_region(win, win->region_num - 1);
+
+		/* short region means the end of image */
+		if (last->state != REGION_STATE_BUSY && last->done_len < last->len)
+			break;
+
+		if (!ota_bt_window_request(win, last->offset + last->len, last->len))
+			break;
+	}
+}
+
+/* called with window lock held */
+static void ota_bt_window_region_put(struct ota_bt_window *win, struct ota_bt_region *region)
+{
+	if (--region->pending > 0)
+		return;
+
+	region->state = region->failed ? REGION_STATE_ERROR : REGION_STATE_DONE;
+	os_sem_give(&win->done_sem);
+}
+
+/* called with window lock held */
+static struct ota_bt_xfer *ota_bt_window_pop(struct ota_bt_window *win)
+{
+	struct ota_bt_xfer *xfer = &win->xfers[win->xfer_head];
+
+	win->xfer_head = (win->xfer_head + 1) % OTA_BT_WINDOW_XFER_NUM;
+	win->xfer_num--;
+
+	return xfer;
+}
+
+static int ota_bt_window_recv(struct ota_bt_window *win, struct ota_bt_xfer *xfer)
+{
+	struct svc_prot_context *ctx = win->ctx;
+	uint32_t processed_cmd;
+	int err = 0;
+
+	ctx->read_buf = xfer->buf;
+	ctx->read_len = xfer->len;
+	ctx->read_done_len = 0;
+	ctx->last_psn = 0xff;
+	ctx->windowed = 1;
+	win->hole_num = 0;
+
+	while (ctx->read_done_len < ctx->read_len) {
+		processed_cmd = 0;
+		err = process_command(ctx, &processed_cmd);
+		if (err)
+			break;
+
+		/* host renegotiated, the outstanding requests are lost */
+		if (processed_cmd != OTA_CMD_H2D_SEND_IMAGE_DATA &&
+		    processed_cmd != OTA_CMD_H2D_SEND_IMAGE_DATA_WITH_CRC) {
+			SYS_LOG_ERR("unexpected cmd %d in window", processed_cmd);
+			err = -EIO;
+			break;
+		}
+	}
+
+	ctx->windowed = 0;
+
+	return err ? err : ctx->read_done_len;
+}
+
+static void ota_bt_window_process(struct ota_bt_window *win)
+{
+	struct svc_prot_context *ctx = win->ctx;
+	struct ota_bt_region *region;
+	struct ota_bt_xfer *xfer, *repair;
+	uint32_t offset;
+	uint8_t *buf;
+	int i, num, len;
+
+	while (1) {
+		os_mutex_lock(&win->lock, OS_FOREVER);
+		num = win->xfer_num;
+		os_mutex_unlock(&win->lock);
+
+		if (num == 0)
+			break;
+
+		/* keep all queued requests on air, host answers them in order */
+		len = 0;
+		for (i = 0; i < num; i++) {
+			xfer = &win->xfers[(win->xfer_head + i) % OTA_BT_WINDOW_XFER_NUM];
+			if (xfer->sent)
+				continue;
+
+			len = ota_cmd_send_require_image_data(ctx, xfer->offset, xfer->len);
+			if (len)
+				break;
+
+			xfer->sent = 1;
+		}
+
+		if (!len)
+			len = ota_bt_window_recv(win, &win->xfers[win->xfer_head]);
+
+		if (len < 0) {
+			SYS_LOG_ERR("window recv err %d", len);
+
+			/* stream is out of sync, drop all outstanding requests */
+			svc_drop_all_rx_data(ctx, 500);
+			ctx->state = PROT_STATE_IDLE;
+
+			os_mutex_lock(&win->lock, OS_FOREVER);
+			while (win->xfer_num > 0) {
+				xfer = ota_bt_window_pop(win);
+				xfer->region->failed = 1;
+				ota_bt_window_region_put(win, xfer->region);
+			}
+			os_mutex_unlock(&win->lock);
+			break;
+		}
+
+		os_mutex_lock(&win->lock, OS_FOREVER);
+
+		xfer = ota_bt_window_pop(win);
+		region = xfer->region;
+		offset = xfer->offset;
+		buf = xfer->buf;
+
+		if (!xfer->repair)
+			region->done_len = len;
+		else if (len < xfer->len)
+			region->failed = 1;
+
+		/* re-request the bad units only */
+		for (i = 0; i < win->hole_num; i++) {
+			SYS_LOG_INF("re-request offset 0x%x, len %d",
+				offset + win->holes[i].pos, win->holes[i].len);
+
+			repair = NULL;
+			if (region->repairs < OTA_BT_WINDOW_REPAIR_MAX)
+				repair = ota_bt_window_queue(win, region, offset + win->holes[i].pos,
+							     buf + win->holes[i].pos, win->holes[i].len);
+			if (!repair) {
+				region->failed = 1;
+				break;
+			}
+
+			repair->repair = 1;
+			region->repairs++;
+		}
+
+		ota_bt_window_region_put(win, region);
+
+		os_mutex_unlock(&win->lock);
+	}
+}
+
+static void ota_bt_window_thread(void *p1, void *p2, void *p3)
+{
+	struct ota_bt_window *win = p1;
+
+	while (1) {
+		os_sem_take(&win->work_sem, OS_FOREVER);
+		ota_bt_window_process(win);
+	}
+}
+
+/* wait all outstanding requests and drop the prefetched regions */
+static void ota_bt_window_flush(struct ota_bt_window *win)
+{
+	if (!win->thread_started)
+		return;
+
+	while (1) {
+		os_mutex_lock(&win->lock, OS_FOREVER);
+		if (win->xfer_num == 0) {
+			win->region_head = 0;
+			win->region_num = 0;
+			os_mutex_unlock(&win->lock);
+			break;
+		}
+		os_mutex_unlock(&win->lock);
+
+		os_sem_take(&win->done_sem, OS_FOREVER);
+	}
+}
+
+static void ota_bt_window_close(struct ota_bt_window *win)
+{
+	int i;
+
+	ota_bt_window_flush(win);
+
+	for (i = 0; i < CONFIG_OTA_BT_WINDOW_NUM; i++) {
+		if (win->regions[i].buf) {
+			mem_free(win->regions[i].buf);
+			win->regions[i].buf = NULL;
+		}
+	}
+}
+
+static int ota_bt_window_open(struct ota_bt_window *win, struct svc_prot_context *ctx)
+{
+	int i, tid;
+
+	if (!win->thread_started) {
+		os_mutex_init(&win->lock);
+		os_sem_init(&win->work_sem, 0, 1);
+		os_sem_init(&win->done_sem, 0, 1);
+
+		tid = os_thread_create(ota_bt_window_stack, sizeof(ota_bt_window_stack),
+				       ota_bt_window_thread, win, NULL, NULL,
+				       CONFIG_OTA_BT_WINDOW_PRIORITY, 0, 0);
+		if (!tid) {
+			SYS_LOG_ERR("create thread failed");
+			return -ENOMEM;
+		}
+
+		os_thread_name_set((os_tid_t)tid, "ota_bt_win");
+		win->thread_started = 1;
+	}
+
+	win->ctx = ctx;
+
+	for (i = 0; i < CONFIG_OTA_BT_WINDOW_NUM; i++) {
+		if (win->regions[i].buf)
+			continue;
+
+		win->regions[i].buf = mem_malloc(CONFIG_OTA_BT_WINDOW_REGION_MAX_SIZE);
+		if (!win->regions[i].buf) {
+			SYS_LOG_ERR("malloc failed");
+			ota_bt_window_close(win);
+			return -ENOMEM;
+		}
+	}
+
+	return 0;
+}
+
+static int ota_bt_window_read(struct svc_prot_context *ctx, int offset, uint8_t *buf, int size)
+{
+	struct ota_bt_window *win = &ota_bt_win;
+	struct ota_bt_region *region;
+	uint8_t state;
+	int err;
+
+	if (size > CONFIG_OTA_BT_WINDOW_REGION_MAX_SIZE)
+		return -EINVAL;
+
+	err = ota_bt_window_open(win, ctx);
+	if (err)
+		return err;
+
+	os_mutex_lock(&win->lock, OS_FOREVER);
+
+	region = ota_bt_window_region(win, 0);
+	if (win->region_num > 0 && (region->offset != offset || region->len != size)) {
+		os_mutex_unlock(&win->lock);
+
+		SYS_LOG_INF("window miss, offset 0x%x, size %d", offset, size);
+		ota_bt_window_flush(win);
+
+		os_mutex_lock(&win->lock, OS_FOREVER);
+	}
+
+	if (win->region_num == 0)
+		ota_bt_window_request(win, offset, size);
+
+	ota_bt_window_prefetch(win);
+
+	os_mutex_unlock(&win->lock);
+
+	region = ota_bt_window_region(win, 0);
+	while (1) {
+		os_mutex_lock(&win->lock, OS_FOREVER);
+		state = region->state;
+		os_mutex_unlock(&win->lock);
+
+		if (state != REGION_STATE_BUSY)
+			break;
+
+		os_sem_take(&win->done_sem, OS_FOREVER);
+	}
+
+	if (state == REGION_STATE_DONE && region->done_len == size) {
+		memcpy(buf, region->buf, size);
+	} else {
+		err = -EIO;
+	}
+
+	/* free the region and keep the window full while data is programmed */
+	os_mutex_lock(&win->lock, OS_FOREVER);
+	region->state = REGION_STATE_FREE;
+	win->region_head = (win->region_head + 1) % CONFIG_OTA_BT_WINDOW_NUM;
+	win->region_num--;
+	if (!err)
+		ota_bt_window_prefetch(win);
+	os_mutex_unlock(&win->lock);
+
+	return err;
+}
+#endif
+
 int ota_backend_bt_ioctl(struct ota_backend *backend, int cmd, unsigned int param)
 {
 	struct ota_backend_bt *backend_bt = CONTAINER_OF(backend,
@@ -726,6 +1199,10 @@ int ota_backend_bt_ioctl(struct ota_backend *backend, int cmd, unsigned int para
 
 	switch (cmd) {
 	case OTA_BACKEND_IOCTL_REPORT_IMAGE_VALID:
+#ifdef CONFIG_OTA_BT_WINDOW
+		/* no prefetch request on air before validate */
+		ota_bt_window_flush(&ota_bt_win);
+#endif
 		err = ota_cmd_d2h_report_image_valid(svc_ctx, param);
 		if (err) {
 			SYS_LOG_INF("send cmd 0x%x error", cmd);
@@ -753,6 +1230,21 @@ int ota_backend_bt_read(struct ota_backend *backend, int offset, uint8_t *buf, i
 
 	SYS_LOG_INF("offset 0x%x, size %d, buf %p", offset, size, buf);
 
+#ifdef CONFIG_OTA_BT_WINDOW
+	if (svc_ctx->host_features & OTA_SUPPORT_FEATURE_WINDOW) {
+		err = ota_bt_window_read(svc_ctx, offset, buf, size);
+		if (!err)
+			return 0;
+
+		/* read this region in sequence */
+		ota_bt_window_flush(&ota_bt_win);
+		if (err != -EINVAL) {
+			SYS_LOG_WRN("window read err %d, disable window", err);
+			svc_ctx->host_features &= ~OTA_SUPPORT_FEATURE_WINDOW;
+		}
+	}
+#endif
+
 try_again:
 	err = ota_cmd_require_image_data(svc_ctx, offset, size, buf);
 	if (err) {
@@ -887,6 +1379,10 @@ int ota_backend_bt_close(struct ota_backend *backend)
 		svc_ctx->state = PROT_STATE_IDLE;
 	}
 
+#ifdef CONFIG_OTA_BT_WINDOW
+	ota_bt_window_close(&ota_bt_win);
+#endif
+
 	return 0;
 }
 
@@ -0,0 +1,742 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief OTA delta backend interface
+ */
+
+#include <kernel.h>
+#include <string.h>
+#include <soc.h>
+#include <partition/partition.h>
+#include <mem_manager.h>
+#include <ota_backend.h>
+#include <ota_backend_delta.h>
+#include <crc.h>
+#ifdef CONFIG_OTA_BACKEND_DELTA_LZ4
+#include <lz4_stream.h>
+#endif
+
+/* block table entries cached */
+#define OTA_DELTA_INDEX_CACHE_NUM	32
+
+struct ota_backend_delta {
+	struct ota_backend backend;
+	struct ota_backend *inner;
+	ota_backend_notify_cb_t inner_cb;
+	struct ota_backend_delta *next;
+
+	int is_delta;
+	struct ota_delta_head head;
+	struct ota_delta_src srcs[OTA_DELTA_MAX_SRC];
+	uint32_t index_offs;
+
+	/* delta image is read in fixed size chunks */
+	uint8_t *chunk_buf;
+	uint32_t chunk_offs;
+	int chunk_len;
+
+	struct ota_delta_block index[OTA_DELTA_INDEX_CACHE_NUM];
+	int index_first;
+	int index_num;
+
+	uint8_t *block_buf;
+	int block_id;
+
+	/* mapping of old file */
+	int map_src;
+	const uint8_t *map_addr;
+
+	/* crc32 of the rebuilt image up to crc_offs */
+	uint32_t crc;
+	uint32_t crc_offs;
+};
+
+/* op stream reader of one block */
+struct ota_delta_reader {
+	struct ota_backend_delta *delta;
+	uint32_t offs;
+	uint32_t end;
+};
+
+static struct ota_backend_delta *delta_backend_list;
+
+/* map offs of the delta image in the read chunk, returns the bytes mapped */
+static int ota_delta_map_chunk(struct ota_backend_delta *delta, uint32_t offs,
+			       const uint8_t **data)
+{
+	int err;
+
+	if (offs < delta->chunk_offs || offs >= delta->chunk_offs + delta->chunk_len) {
+		if (offs >= delta->head.delta_size)
+			return -EIO;
+
+		delta->chunk_offs = offs - offs % CONFIG_OTA_BACKEND_DELTA_READ_SIZE;
+		delta->chunk_len = delta->head.delta_size - delta->chunk_offs;
+		if (delta->chunk_len > CONFIG_OTA_BACKEND_DELTA_READ_SIZE)
+			delta->chunk_len = CONFIG_OTA_BACKEND_DELTA_READ_SIZE;
+
+		err = ota_backend_read(delta->inner, delta->chunk_offs,
+				       delta->chunk_buf, delta->chunk_len);
+		if (err) {
+			SYS_LOG_ERR("read offs 0x%x failed, err %d", delta->chunk_offs, err);
+			delta->chunk_len = 0;
+			return err;
+		}
+	}
+
+	*data = delta->chunk_buf + (offs - delta->chunk_offs);
+
+	return delta->chunk_offs + delta->chunk_len - offs;
+}
+
+static int ota_delta_fetch(struct ota_backend_delta *delta, uint32_t offs,
+			   uint8_t *buf, int size)
+{
+	const uint8_t *data = NULL;
+	int len;
+
+	while (size > 0) {
+		len = ota_delta_map_chunk(delta, offs, &data);
+		if (len < 0)
+			return len;
+
+		if (len > size)
+			len = size;
+
+		memcpy(buf, data, len);
+		buf += len;
+		offs += len;
+		size -= len;
+	}
+
+	return 0;
+}
+
+static const uint8_t *ota_delta_map_src(struct ota_backend_delta *delta, int src)
+{
+	const struct partition_entry *part;
+
+	if (delta->map_src == src)
+		return delta->map_addr;
+
+	if (delta->map_addr) {
+		soc_memctrl_clear_temp_mapping((void *)delta->map_addr);
+		delta->map_addr = NULL;
+		delta->map_src = -1;
+	}
+
+	part = partition_get_part(delta->srcs[src].file_id);
+	if (!part)
+		return NULL;
+
+	delta->map_addr = soc_memctrl_create_temp_mapping(part->file_offset,
+		part->flag & PARTITION_FLAG_ENABLE_CRC ? 1 : 0,
+		part->flag & PARTITION_FLAG_ENABLE_ENCRYPTION ? 1 : 0);
+	if (delta->map_addr)
+		delta->map_src = src;
+
+	return delta->map_addr;
+}
+
+static void ota_delta_unmap_src(struct ota_backend_delta *delta)
+{
+	if (delta->map_addr) {
+		soc_memctrl_clear_temp_mapping((void *)delta->map_addr);
+		delta->map_addr = NULL;
+	}
+
+	delta->map_src = -1;
+}
+
+static int ota_delta_get(struct ota_delta_reader *rd, uint8_t *buf, int size)
+{
+	int err;
+
+	if (rd->offs + size > rd->end)
+		return -EIO;
+
+	err = ota_delta_fetch(rd->delta, rd->offs, buf, size);
+	if (err)
+		return err;
+
+	rd->offs += size;
+
+	return 0;
+}
+
+static int ota_delta_get_varint(struct ota_delta_reader *rd, uint32_t *value)
+{
+	uint8_t c;
+	int err, shift = 0;
+
+	*value = 0;
+	do {
+		if (shift > 28)
+			return -EIO;
+
+		err = ota_delta_get(rd, &c, 1);
+		if (err)
+			return err;
+
+		*value |= (uint32_t)(c & 0x7f) << shift;
+		shift += 7;
+	} while (c & 0x80);
+
+	return 0;
+}
+
+/* get the source of COPY and ADD ops */
+static const uint8_t *ota_delta_get_src(struct ota_delta_reader *rd, uint32_t *src_end, int len)
+{
+	struct ota_backend_delta *delta = rd->delta;
+	const uint8_t *addr;
+	uint32_t src, offs;
+
+	if (ota_delta_get_varint(rd, &src) || ota_delta_get_varint(rd, &offs))
+		return NULL;
+
+	if (src >= delta->head.src_num)
+		return NULL;
+
+	/* zigzag offset to the end of last source data */
+	offs = src_end[src] + ((offs >> 1) ^ -(offs & 1));
+	if (offs > delta->srcs[src].size || len > delta->srcs[src].size - offs)
+		return NULL;
+
+	addr = ota_delta_map_src(delta, src);
+	if (!addr)
+		return NULL;
+
+	src_end[src] = offs + len;
+
+	return addr + offs;
+}
+
+static int ota_delta_decode_add(struct ota_delta_reader *rd, uint8_t *dst,
+				const uint8_t *old, int len)
+{
+	uint32_t zero_run, lit_run;
+	int i, err;
+
+	while (len > 0) {
+		if (ota_delta_get_varint(rd, &zero_run) || ota_delta_get_varint(rd, &lit_run))
+			return -EIO;
+
+		if (zero_run + lit_run > len)
+			return -EIO;
+
+		memcpy(dst, old, zero_run);
+		dst += zero_run;
+		old += zero_run;
+
+		err = ota_delta_get(rd, dst, lit_run);
+		if (err)
+			return err;
+
+		for (i = 0; i < lit_run; i++)
+			dst[i] += old[i];
+
+		dst += lit_run;
+		old += lit_run;
+		len -= zero_run + lit_run;
+	}
+
+	return 0;
+}
+
+#ifdef CONFIG_OTA_BACKEND_DELTA_LZ4
+/* the LZ4 block is decoded from the read chunks, straight into dst */
+static int ota_delta_decode_lz4(struct ota_delta_reader *rd, uint8_t *dst, int len)
+{
+	lz4_stream_t lz4;
+	const uint8_t *data;
+	uint32_t clen;
+	int n;
+
+	if (ota_delta_get_varint(rd, &clen) || clen > rd->end - rd->offs)
+		return -EIO;
+
+	lz4_stream_init(&lz4, dst, len);
+
+	while (clen > 0) {
+		n = ota_delta_map_chunk(rd->delta, rd->offs, &data);
+		if (n < 0)
+			return n;
+
+		if (n > clen)
+			n = clen;
+
+		if (lz4_stream_decode(&lz4, data, n))
+			return -EIO;
+
+		rd->offs += n;
+		clen -= n;
+	}
+
+	return (lz4_stream_finish(&lz4) == len) ? 0 : -EIO;
+}
+#endif
+
+static int ota_delta_decode(struct ota_backend_delta *delta, uint32_t offs, uint32_t end,
+			    uint8_t *dst, int size)
+{
+	struct ota_delta_reader rd;
+	uint32_t src_end[OTA_DELTA_MAX_SRC];
+	const uint8_t *old;
+	uint32_t len;
+	uint8_t op;
+	int err;
+
+	rd.delta = delta;
+	rd.offs = offs;
+	rd.end = end;
+	memset(src_end, 0, sizeof(src_end));
+
+	while (size > 0) {
+		if (ota_delta_get(&rd, &op, 1) || ota_delta_get_varint(&rd, &len))
+			return -EIO;
+
+		if (len > size)
+			return -EIO;
+
+		switch (op) {
+		case OTA_DELTA_OP_LIT:
+			err = ota_delta_get(&rd, dst, len);
+			break;
+		case OTA_DELTA_OP_COPY:
+			old = ota_delta_get_src(&rd, src_end, len);
+			if (old)
+				memcpy(dst, old, len);
+			err = old ? 0 : -EIO;
+			break;
+		case OTA_DELTA_OP_ADD:
+			old = ota_delta_get_src(&rd, src_end, len);
+			err = old ? ota_delta_decode_add(&rd, dst, old, len) : -EIO;
+			break;
+#ifdef CONFIG_OTA_BACKEND_DELTA_LZ4
+		case OTA_DELTA_OP_LZ4:
+			err = ota_delta_decode_lz4(&rd, dst, len);
+			break;
+#endif
+		default:
+			err = -EIO;
+			break;
+		}
+
+		if (err) {
+			SYS_LOG_ERR("bad op %d at 0x%x", op, rd.offs);
+			return err;
+		}
+
+		dst += len;
+		size -= len;
+	}
+
+	return (rd.offs == end) ? 0 : -EIO;
+}
+
+static int ota_delta_get_block(struct ota_backend_delta *delta, int block_id,
+			       uint32_t *start, struct ota_delta_block *block)
+{
+	int first, num, err;
+
+	first = (block_id > 0) ? block_id - 1 : 0;
+	if (delta->index_num == 0 || first < delta->index_first ||
+	    block_id >= delta->index_first + delta->index_num) {
+		num = delta->head.block_num - first;
+		if (num > OTA_DELTA_INDEX_CACHE_NUM)
+			num = OTA_DELTA_INDEX_CACHE_NUM;
+
+		err = ota_delta_fetch(delta, delta->index_offs + first * sizeof(struct ota_delta_block),
+				      (uint8_t *)delta->index, num * sizeof(struct ota_delta_block));
+		if (err) {
+			delta->index_num = 0;
+			return err;
+		}
+
+		delta->index_first = first;
+		delta->index_num = num;
+	}
+
+	if (block_id > 0) {
+		*start = delta->index[block_id - 1 - delta->index_first].data_end;
+	} else {
+		*start = delta->index_offs + delta->head.block_num * sizeof(struct ota_delta_block);
+	}
+
+	*block = delta->index[block_id - delta->index_first];
+
+	return 0;
+}
+
+static int ota_delta_load_block(struct ota_backend_delta *delta, int block_id)
+{
+	struct ota_delta_block block;
+	uint32_t start;
+	int err, size;
+
+	if (delta->block_id == block_id)
+		return 0;
+
+	delta->block_id = -1;
+
+	err = ota_delta_get_block(delta, block_id, &start, &block);
+	if (err)
+		return err;
+
+	size = delta->head.new_size - block_id * delta->head.block_size;
+	if (size > delta->head.block_size)
+		size = delta->head.block_size;
+
+	if (block.data_end < start || block.data_end > delta->head.delta_size) {
+		SYS_LOG_ERR("block %d: bad data 0x%x-0x%x", block_id, start, block.data_end);
+		return -EIO;
+	}
+
+	err = ota_delta_decode(delta, start, block.data_end, delta->block_buf, size);
+	if (err) {
+		SYS_LOG_ERR("block %d: decode failed", block_id);
+		return err;
+	}
+
+	if (utils_crc32(0, delta->block_buf, size) != block.crc) {
+		SYS_LOG_ERR("block %d: crc error", block_id);
+		return -EIO;
+	}
+
+	delta->block_id = block_id;
+
+	return 0;
+}
+
+/*
+ * Blocks are checked by their own crc, the crc of the whole image also
+ * covers the head and block table. It is summed while the image is read in
+ * order, the blocks which were skipped, such as before a breakpoint, are
+ * decoded again here.
+ */
+static int ota_delta_check_new_crc(struct ota_backend_delta *delta)
+{
+	int err, pos, len;
+
+	while (delta->crc_offs < delta->head.new_size) {
+		err = ota_delta_load_block(delta, delta->crc_offs / delta->head.block_size);
+		if (err)
+			return err;
+
+		pos = delta->crc_offs % delta->head.block_size;
+		len = delta->head.block_size - pos;
+		if (len > delta->head.new_size - delta->crc_offs)
+			len = delta->head.new_size - delta->crc_offs;
+
+		delta->crc = utils_crc32(delta->crc, delta->block_buf + pos, len);
+		delta->crc_offs += len;
+	}
+
+	if (delta->crc != delta->head.new_crc) {
+		SYS_LOG_ERR("image crc 0x%x, expected 0x%x", delta->crc, delta->head.new_crc);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+int ota_backend_delta_read(struct ota_backend *backend, int offset, uint8_t *buf, int size)
+{
+	struct ota_backend_delta *delta = CONTAINER_OF(backend,
+		struct ota_backend_delta, backend);
+	int err, pos, len;
+
+	if (!delta->is_delta)
+		return ota_backend_read(delta->inner, offset, buf, size);
+
+	SYS_LOG_DBG("offset 0x%x, size %d, buf %p", offset, size, buf);
+
+	if (offset < 0 || size < 0 || offset + size > delta->head.new_size) {
+		SYS_LOG_ERR("offs 0x%x size 0x%x is too big, max size 0x%x",
+			offset, size, delta->head.new_size);
+		return -EINVAL;
+	}
+
+	while (size > 0) {
+		err = ota_delta_load_block(delta, offset / delta->head.block_size);
+		if (err)
+			return err;
+
+		pos = offset % delta->head.block_size;
+		len = delta->head.block_size - pos;
+		if (len > size)
+			len = size;
+
+		memcpy(buf, delta->block_buf + pos, len);
+
+		if (offset == delta->crc_offs) {
+			delta->crc = utils_crc32(delta->crc, buf, len);
+			delta->crc_offs += len;
+		}
+
+		buf += len;
+		offset += len;
+		size -= len;
+	}
+
+	/* fail the read of the image end, before the upgrade core reports success */
+	if (offset == delta->head.new_size)
+		return ota_delta_check_new_crc(delta);
+
+	return 0;
+}
+
+static void ota_delta_free_buf(struct ota_backend_delta *delta)
+{
+	ota_delta_unmap_src(delta);
+
+	if (delta->chunk_buf) {
+		mem_free(delta->chunk_buf);
+		delta->chunk_buf = NULL;
+	}
+
+	if (delta->block_buf) {
+		mem_free(delta->block_buf);
+		delta->block_buf = NULL;
+	}
+
+	delta->is_delta = 0;
+}
+
+/* old files must be intact, the upgrade core writes their mirror partitions */
+static int ota_delta_check_src(struct ota_backend_delta *delta)
+{
+	const struct partition_entry *part;
+	struct ota_delta_src *src;
+	const uint8_t *addr;
+	int i;
+
+	for (i = 0; i < delta->head.src_num; i++) {
+		src = &delta->srcs[i];
+
+		part = partition_get_part(src->file_id);
+		if (!part || !partition_get_mirror_part(src->file_id) ||
+		    src->size > part->size) {
+			SYS_LOG_ERR("file_id %d cannot be delta source", src->file_id);
+			return -EINVAL;
+		}
+
+		addr = ota_delta_map_src(delta, i);
+		if (!addr || utils_crc32(0, addr, src->size) != src->crc) {
+			SYS_LOG_ERR("file_id %d is not the delta source", src->file_id);
+			return -EINVAL;
+		}
+	}
+
+	return 0;
+}
+
+static bool ota_delta_version_supported(uint16_t version)
+{
+#ifdef CONFIG_OTA_BACKEND_DELTA_LZ4
+	if (version == OTA_DELTA_VERSION)
+		return true;
+#endif
+
+	return version == OTA_DELTA_VERSION_NO_LZ4;
+}
+
+static int ota_delta_open_image(struct ota_backend_delta *delta)
+{
+	struct ota_delta_head *head = &delta->head;
+	int err;
+
+	err = ota_backend_read(delta->inner, 0, (uint8_t *)head, sizeof(struct ota_delta_head));
+	if (err) {
+		SYS_LOG_ERR("read head failed, err %d", err);
+		return err;
+	}
+
+	if (head->magic != OTA_DELTA_MAGIC) {
+		SYS_LOG_INF("full image");
+		return 0;
+	}
+
+	SYS_LOG_INF("delta image: new size 0x%x, delta size 0x%x, block size 0x%x, src %d",
+		head->new_size, head->delta_size, head->block_size, head->src_num);
+
+	if (!ota_delta_version_supported(head->version) || head->src_num > OTA_DELTA_MAX_SRC ||
+	    head->block_size == 0 || head->block_size > CONFIG_OTA_BACKEND_DELTA_BLOCK_MAX_SIZE ||
+	    head->block_num != (head->new_size + head->block_size - 1) / head->block_size) {
+		SYS_LOG_ERR("invalid delta head");
+		return -EINVAL;
+	}
+
+	err = ota_backend_read(delta->inner, head->head_size, (uint8_t *)delta->srcs,
+			       head->src_num * sizeof(struct ota_delta_src));
+	if (err)
+		return err;
+
+	delta->index_offs = head->head_size + head->src_num * sizeof(struct ota_delta_src);
+	delta->index_num = 0;
+	delta->block_id = -1;
+	delta->chunk_len = 0;
+	delta->map_src = -1;
+	delta->crc = 0;
+	delta->crc_offs = 0;
+
+	delta->chunk_buf = mem_malloc(CONFIG_OTA_BACKEND_DELTA_READ_SIZE);
+	delta->block_buf = mem_malloc(head->block_size);
+	if (!delta->chunk_buf || !delta->block_buf) {
+		SYS_LOG_ERR("malloc failed");
+		return -ENOMEM;
+	}
+
+	err = ota_delta_check_src(delta);
+	if (err)
+		return err;
+
+	delta->is_delta = 1;
+
+	return 0;
+}
+
+int ota_backend_delta_open(struct ota_backend *backend)
+{
+	struct ota_backend_delta *delta = CONTAINER_OF(backend,
+		struct ota_backend_delta, backend);
+	int err;
+
+	err = ota_backend_open(delta->inner);
+	if (err)
+		return err;
+
+	ota_delta_free_buf(delta);
+
+	err = ota_delta_open_image(delta);
+	if (err) {
+		ota_delta_free_buf(delta);
+		ota_backend_close(delta->inner);
+	}
+
+	return err;
+}
+
+int ota_backend_delta_close(struct ota_backend *backend)
+{
+	struct ota_backend_delta *delta = CONTAINER_OF(backend,
+		struct ota_backend_delta, backend);
+
+	ota_delta_free_buf(delta);
+
+	return ota_backend_close(delta->inner);
+}
+
+int ota_backend_delta_ioctl(struct ota_backend *backend, int cmd, unsigned int param)
+{
+	struct ota_backend_delta *delta = CONTAINER_OF(backend,
+		struct ota_backend_delta, backend);
+	int err;
+
+	if (delta->is_delta && cmd == OTA_BACKEND_IOCTL_REPORT_IMAGE_VALID && param) {
+		err = ota_delta_check_new_crc(delta);
+		if (err) {
+			ota_backend_ioctl(delta->inner, cmd, 0);
+			return err;
+		}
+	}
+
+	return ota_backend_ioctl(delta->inner, cmd, param);
+}
+
+static void ota_backend_delta_api_exit(struct ota_backend *backend)
+{
+	struct ota_backend_delta *delta = CONTAINER_OF(backend,
+		struct ota_backend_delta, backend);
+	struct ota_backend *inner = delta->inner;
+
+	ota_backend_delta_exit(backend);
+	ota_backend_exit(inner);
+}
+
+/* forward the notify of transport backend with delta backend */
+static void ota_backend_delta_notify(struct ota_backend *backend, int cmd, int state)
+{
+	struct ota_backend_delta *delta;
+
+	for (delta = delta_backend_list; delta; delta = delta->next) {
+		if (delta->inner == backend) {
+			if (delta->backend.cb)
+				delta->backend.cb(&delta->backend, cmd, state);
+			return;
+		}
+	}
+}
+
+static struct ota_backend_api ota_backend_api_delta = {
+	.exit = ota_backend_delta_api_exit,
+	.open = ota_backend_delta_open,
+	.close = ota_backend_delta_close,
+	.read = ota_backend_delta_read,
+	.ioctl = ota_backend_delta_ioctl,
+};
+
+struct ota_backend *ota_backend_delta_init(struct ota_backend *backend)
+{
+	struct ota_backend_delta *delta;
+
+	if (!backend)
+		return NULL;
+
+	for (delta = delta_backend_list; delta; delta = delta->next) {
+		if (delta->inner == backend)
+			break;
+	}
+
+	if (!delta) {
+		delta = mem_malloc(sizeof(struct ota_backend_delta));
+		if (!delta) {
+			SYS_LOG_ERR("malloc failed");
+			return NULL;
+		}
+
+		memset(delta, 0x0, sizeof(struct ota_backend_delta));
+		delta->inner = backend;
+		delta->map_src = -1;
+		delta->next = delta_backend_list;
+		delta_backend_list = delta;
+	}
+
+	/* transport backend may be inited again with a new notify callback */
+	if (backend->cb != ota_backend_delta_notify) {
+		delta->inner_cb = backend->cb;
+		backend->cb = ota_backend_delta_notify;
+	}
+
+	ota_backend_init(&delta->backend, backend->type, &ota_backend_api_delta,
+			 delta->inner_cb);
+
+	return &delta->backend;
+}
+
+void ota_backend_delta_exit(struct ota_backend *backend)
+{
+	struct ota_backend_delta *delta = CONTAINER_OF(backend,
+		struct ota_backend_delta, backend);
+	struct ota_backend_delta **prev;
+
+	for (prev = &delta_backend_list; *prev; prev = &(*prev)->next) {
+		if (*prev == delta) {
+			*prev = delta->next;
+			break;
+		}
+	}
+
+	ota_delta_free_buf(delta);
+
+	if (delta->inner->cb == ota_backend_delta_notify)
+		delta->inner->cb = delta->inner_cb;
+
+	mem_free(delta);
+}
@@ -15,6 +15,9 @@
 #include <mem_manager.h>
 #include <ota_storage.h>
 #include <os_common_api.h>
+#ifdef CONFIG_SDFS_INDEX
+#include <sdfs.h>
+#endif
 
 #define CONFIG_XSPI_NOR_ACTS_DEV_NAME "spi_flash"
 #define OTA_STORAGE_EXT_DEVICE_NAME "spinand"
@@ -148,13 +151,25 @@ static int ota_storage_write_default(struct ota_storage *storage, int offs,
 int ota_storage_write(struct ota_storage *storage, int offs,
 		      uint8_t *buf, int size)
 {
+	int err;
+
 	if (storage == NULL)
 		return -EINVAL;
 
 	if (IS_STORAGE_TYPE_SD_NAND(storage))
-		return ota_storage_write_sd_nand(storage, offs, buf, size);
+		err = ota_storage_write_sd_nand(storage, offs, buf, size);
 	else
-		return ota_storage_write_default(storage, offs, buf, size);
+		err = ota_storage_write_default(storage, offs, buf, size);
+
+#ifdef CONFIG_SDFS_INDEX
+	/*
+	 * sdfs images may be rewritten, drop the index after the write since
+	 * a lookup during the write may have rebuilt it from the old image
+	 */
+	sdfs_index_invalidate();
+#endif
+
+	return err;
 }
 
 static int ota_storage_read_sd_nand(struct ota_storage *storage, int offs,
@@ -411,18 +426,27 @@ int ota_storage_erase_spinor(struct ota_storage *storage, int offs, int size)
 
 int ota_storage_erase(struct ota_storage *storage, int offs, int size)
 {
+	int err;
+
 	SYS_LOG_INF("offs 0x%x, size %d", offs, size);
 	if (storage == NULL)
 		return -EINVAL;
 
 	if (IS_STORAGE_TYPE_SD_NAND(storage)) {
 		//SYS_LOG_INF("sd: ignore erase");
-		return ota_storage_erase_sd_nand(storage, offs, size);
+		err = ota_storage_erase_sd_nand(storage, offs, size);
 	} else if (storage->storage_type == OTA_STORAGE_SPINOR){
-		return ota_storage_erase_spinor(storage, offs, size);
+		err = ota_storage_erase_spinor(storage, offs, size);
+	} else {
+		err = flash_erase(storage->dev, offs, size);
 	}
 
-	return flash_erase(storage->dev, offs, size);
+#ifdef CONFIG_SDFS_INDEX
+	/* same as ota_storage_write() */
+	sdfs_index_invalidate();
+#endif
+
+	return err;
 }
 
 struct ota_storage *ota_storage_find(int storage_id)
@@ -22,6 +22,7 @@
 #include <stdlib.h>
 #include <limits.h>
 #include <property_manager.h>
+#include <msg_manager.h>
 #include <sys_wakelock.h>
 
 extern void mem_manager_dump_ext(int dump_detail, const char* match_value);
@@ -54,6 +55,23 @@ static int shell_set_config(const struct shell *shell,
 	return 0;
 }
 
+static int shell_dump_property(const struct shell *shell,
+					size_t argc, char **argv)
+{
+#ifdef CONFIG_PROPERTY
+	property_dump();
+#endif
+	return 0;
+}
+
+static int shell_dump_msg_stat(const struct shell *shell,
+					size_t argc, char **argv)
+{
+	msg_manager_dump_listener();
+	msg_manager_dump_busy_msg();
+	return 0;
+}
+
 static int shell_dump_meminfo(const struct shell *shell,
 					size_t argc, char **argv)
 {
@@ -70,6 +88,13 @@ static int shell_dump_meminfo(const struct shell *shell,
 	return 0;
 }
 
+static int shell_dump_memstat(const struct shell *shell,
+					size_t argc, char **argv)
+{
+	mem_manager_dump_stat();
+	return 0;
+}
+
 #ifdef CONFIG_SYS_WAKELOCK
 static int shell_wake_lock(const struct shell *shell, size_t argc, char **argv)
 {
@@ -90,7 +115,10 @@ static int shell_wake_lock(const struct shell *shell, size_t argc, char **argv)
 
 SHELL_STATIC_SUBCMD_SET_CREATE(sub_system,
 	SHELL_CMD(dumpmem, NULL, "dump mem info.", shell_dump_meminfo),
+	SHELL_CMD(memstat, NULL, "dump mem allocator statistics.", shell_dump_memstat),
 	SHELL_CMD(set_config, NULL, "set system config ", shell_set_config),
+	SHELL_CMD(property, NULL, "dump property cache info.", shell_dump_property),
+	SHELL_CMD(msgstat, NULL, "dump message listener statistics.", shell_dump_msg_stat),
 #ifdef CONFIG_SYS_WAKELOCK
 	SHELL_CMD(wlock, NULL, "wlock lock[unlock] ", shell_wake_lock),
 #endif
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief closed loop simulation of the aps level control on packet traces
+ *
+ * The real audio_aps.c runs on bt packet arrival traces of gen_trace.
+ * Every 4 ms the sink plays 4 ms of audio at the rate of the current aps
+ * level, each arriving packet adds 20 ms, and audio_aps_monitor() gets the
+ * buffered time. Each trace is run for sbc with water marks 20 ms around
+ * the target, and for the nav format with integer-N and fractional-N
+ * audiopll. The buffer starts 30 ms above the target of 100 ms.
+ *
+ * Reported after 2 min of warm up: bias and sd of the buffer from the
+ * target, aps level changes per minute, sd of the sink ppm, the latency
+ * which would still not run dry (mean - min buffer), and when the 5 s
+ * average of the error stays within 3 ms. Built with the PI controller,
+ * the bias must stay within 2 ms, or 15 ms with the few levels of the
+ * integer-N audiopll, the level changes below 60 per minute, and the
+ * clean trace must settle.
+ *
+ * Usage: aps_sim <trace>...
+ */
+
+#include <math.h>
+#include <os_common_api.h>
+#include <audio_hal.h>
+#include <audio_system.h>
+#include <media_type.h>
+
+#define TICK_US			4000
+#define PACKET_US		20000
+#define TIME_UNIT_US		100
+#define TARGET_US		100000
+#define START_OFFSET_US		30000
+#define WARM_UP_MS		120000
+#define MAX_PACKETS		20000
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) \
+	do { \
+		if (!(cond)) { \
+			printf("FAIL %s:%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__); \
+			failures++; \
+		} \
+	} while (0)
+
+uint32_t sim_now_ms;
+
+static uint32_t inc_mark, red_mark;
+static int cur_level, level_changes;
+static bool fractional;
+
+/* ppm of the integer-N aps levels at 44.1k, as in audio_aps.c */
+static const int level_ppm_int[] = { -2265, -1723, -862, -356, -23, 388, 721, 2175, 0 };
+
+int audio_policy_get_a2dp_lantency_time(void)
+{
+	return 0;
+}
+
+uint32_t audiolcy_get_latency_threshold(uint8_t format)
+{
+	return inc_mark;
+}
+
+uint32_t audiolcy_get_latency_threshold_min(uint8_t format)
+{
+	return red_mark;
+}
+
+uint8_t audiolcy_is_low_latency_mode(void)
+{
+	return 0;
+}
+
+int hal_aout_channel_set_aps(void *aout_channel_handle, unsigned int aps_level, unsigned int aps_mode)
+{
+	if ((int)aps_level != cur_level) {
+		level_changes++;
+		cur_level = aps_level;
+	}
+
+	return 0;
+}
+
+static double level_ppm(int level)
+{
+	return fractional ? (level - 16) * 100.0 : level_ppm_int[level];
+}
+
+static uint32_t gaps[MAX_PACKETS];
+static int packet_num;
+static bool clean_trace;
+
+static int load_trace(const char *path)
+{
+	char line[128];
+	unsigned int jitter_us;
+	FILE *fp = fopen(path, "r");
+
+	if (!fp)
+		return -ENOENT;
+
+	packet_num = 0;
+	clean_trace = false;
+
+	while (fgets(line, sizeof(line), fp) && packet_num < MAX_PACKETS) {
+		if (line[0] == '#') {
+			if (strstr(line, "jitter") && sscanf(strstr(line, "jitter"), "jitter %u", &jitter_us) == 1)
+				clean_trace = !jitter_us;
+			continue;
+		}
+
+		gaps[packet_num++] = strtoul(line, NULL, 10) * TIME_UNIT_US;
+	}
+
+	fclose(fp);
+	return packet_num ? 0 : -EINVAL;
+}
+
+enum {
+	FORMAT_SBC,
+	FORMAT_NAV_INT,
+	FORMAT_NAV_FRAC,
+	NUM_FORMATS,
+};
+
+static const char *format_names[NUM_FORMATS] = { "sbc", "nav int-N", "nav frac-N" };
+
+static void run(const char *trace, int format)
+{
+	struct audio_track_t track;
+	uint32_t mode = 0;
+	uint64_t now_us = 0, arrive_us = 0, end_us = 0;
+	double buffer, error, avg = 0, settle_ms = -1, ppm;
+	double sum = 0, sum2 = 0, ppm_sum = 0, ppm_sum2 = 0, min_buffer = 1e12, n = 0;
+	double mean, sd, ppm_sd, minutes;
+	int packet = 0, warm_changes = -1, i;
+
+	for (i = 0; i < packet_num; i++)
+		end_us += gaps[i];
+
+	memset(&track, 0, sizeof(track));
+	fractional = false;
+
+	if (format == FORMAT_SBC) {
+		/* the water marks of sbc lie around the target */
+		inc_mark = TARGET_US + 20000;
+		red_mark = TARGET_US - 20000;
+		mode = SBC_TYPE;
+	} else {
+		inc_mark = TARGET_US;
+		red_mark = TARGET_US - 20000;
+		mode = NAV_TYPE;
+		if (format == FORMAT_NAV_FRAC) {
+			mode |= 2 << APS_AUDIOPLL_MODE_SHIFT;
+			fractional = true;
+		} else {
+			mode |= 1 << APS_AUDIOPLL_MODE_SHIFT;
+		}
+	}
+
+	level_changes = 0;
+	audio_aps_monitor_init(mode, NULL, &track);
+	cur_level = audio_aps_monitor_get_instance()->current_level;
+
+	buffer = TARGET_US + START_OFFSET_US;
+	arrive_us = gaps[0];
+
+	for (now_us = 0; now_us < end_us; now_us += TICK_US) {
+		while (packet < packet_num && arrive_us <= now_us) {
+			buffer += PACKET_US;
+			if (++packet < packet_num)
+				arrive_us += gaps[packet];
+		}
+
+		ppm = level_ppm(cur_level);
+		buffer -= TICK_US * (1 + ppm * 1e-6);
+
+		sim_now_ms = now_us / 1000;
+		audio_aps_monitor((int)buffer);
+
+		/* settled once the 5 s average of the error stays within 3 ms */
+		error = buffer - TARGET_US;
+		avg += (error - avg) * TICK_US / 5e6;
+		if (fabs(avg) > 3000)
+			settle_ms = -1;
+		else if (settle_ms < 0)
+			settle_ms = sim_now_ms;
+
+		if (sim_now_ms < WARM_UP_MS)
+			continue;
+
+		if (warm_changes < 0)
+			warm_changes = level_changes;
+
+		sum += error;
+		sum2 += error * error;
+		ppm_sum += ppm;
+		ppm_sum2 += ppm * ppm;
+		if (buffer < min_buffer)
+			min_buffer = buffer;
+		n++;
+	}
+
+	mean = sum / n;
+	sd = sqrt(sum2 / n - mean * mean);
+	ppm_sd = sqrt(ppm_sum2 / n - (ppm_sum / n) * (ppm_sum / n));
+	minutes = (sim_now_ms - WARM_UP_MS) / 60000.0;
+
+	printf("%-16s %-10s bias %6.1f ms sd %5.1f ms, changes/min %6.1f, ppm sd %4.0f, "
+	       "safe latency %5.1f ms, settled ", trace, format_names[format], mean / 1000,
+	       sd / 1000, (level_changes - warm_changes) / minutes, ppm_sd,
+	       (mean + TARGET_US - min_buffer) / 1000);
+	if (settle_ms < 0)
+		printf("no\n");
+	else
+		printf("at %.0f s\n", settle_ms / 1000);
+
+#ifdef CONFIG_AUDIO_APS_PI_CONTROLLER
+	/* the integer-N levels near 0 ppm lie 400 ppm apart, the level toggles slowly */
+	CHECK(fabs(mean) < (format == FORMAT_NAV_INT ? 15000 : 2000), "%s %s: bias %.1f ms",
+	      trace, format_names[format], mean / 1000);
+	CHECK((level_changes - warm_changes) / minutes < 60, "%s %s: %.1f level changes/min",
+	      trace, format_names[format], (level_changes - warm_changes) / minutes);
+	CHECK(!clean_trace || settle_ms >= 0, "%s %s: not settled", trace, format_names[format]);
+#endif
+}
+
+int main(int argc, char *argv[])
+{
+	const char *name;
+	int i, format;
+
+#ifdef CONFIG_AUDIO_APS_PI_CONTROLLER
+	printf("pi controller, tau %d ms\n", CONFIG_AUDIO_APS_PI_TAU_MS);
+#else
+	printf("water mark control\n");
+#endif
+
+	for (i = 1; i < argc; i++) {
+		if (load_trace(argv[i])) {
+			CHECK(0, "trace %s", argv[i]);
+			continue;
+		}
+
+		name = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+		for (format = 0; format < NUM_FORMATS; format++)
+			run(name, format);
+	}
+
+	if (failures) {
+		printf("audio_aps: %d failures\n", failures);
+		return 1;
+	}
+
+	printf("audio_aps: OK\n");
+	return 0;
+}
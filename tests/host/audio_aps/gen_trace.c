@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief generate bt packet arrival traces for aps_sim
+ *
+ * Writes the trace of one link to stdout. The phone sends a packet of
+ * 20 ms audio every 20 ms of its own clock, which runs off the clock of
+ * the sink by the drift of the link. Packets are delayed by radio jitter,
+ * and at times held back for 100-200 ms by retransmissions, after which
+ * the held packets arrive in a burst. Arrivals are never reordered.
+ *
+ * Arrival times are rounded to 100 us, the gaps are taken between the
+ * rounded times so that the drift is kept over the whole trace.
+ *
+ * Trace format, one packet per line:
+ *   # comment
+ *   <gap>    arrival time after the previous packet, in 100 us
+ *
+ * Usage: gen_trace m300|m80|p80|p300|clean
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARRAY_SIZE(a)		(sizeof(a) / sizeof((a)[0]))
+#define PACKET_US		20000
+#define TIME_UNIT_US		100
+
+struct link_profile {
+	const char *name;
+	unsigned int seed;
+	int drift_ppm;
+	/* mean of the half normal delay of each packet */
+	unsigned int jitter_us;
+	/* chance of a hold per packet, in 1/10000 */
+	unsigned int hold_chance;
+	unsigned int seconds;
+};
+
+static const struct link_profile links[] = {
+	{ "m300",	1, -300, 3000, 15, 360 },
+	{ "m80",	2, -80, 3000, 15, 360 },
+	{ "p80",	3, 80, 3000, 15, 360 },
+	{ "p300",	4, 300, 3000, 15, 360 },
+	{ "clean",	5, 80, 0, 0, 360 },
+};
+
+static unsigned int rand_state;
+
+static unsigned int trace_rand(unsigned int range)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+	return ((rand_state >> 8) & 0xffffff) % range;
+}
+
+/* half normal delay of the given mean, from the sum of 4 uniforms */
+static unsigned int trace_jitter(unsigned int mean_us)
+{
+	int sum = 0, i;
+
+	if (!mean_us)
+		return 0;
+
+	for (i = 0; i < 4; i++)
+		sum += trace_rand(1001);
+	sum -= 2000;
+
+	/* sd of the sum is 577, mean of the half normal is 0.8 sd */
+	return (unsigned int)abs(sum) * mean_us / 462;
+}
+
+int main(int argc, char *argv[])
+{
+	const struct link_profile *link = NULL;
+	long long send_us = 0, arrive_us, last_us = 0, hold_us = 0, last_unit = 0;
+	unsigned int packets, i;
+
+	for (i = 0; argc > 1 && i < ARRAY_SIZE(links); i++) {
+		if (!strcmp(argv[1], links[i].name))
+			link = &links[i];
+	}
+
+	if (!link) {
+		fprintf(stderr, "usage: gen_trace m300|m80|p80|p300|clean\n");
+		return 1;
+	}
+
+	rand_state = link->seed;
+	packets = link->seconds * 1000000ull / PACKET_US;
+
+	printf("# %s: drift %d ppm, jitter %u us, hold chance %u/10000, %u s\n",
+	       link->name, link->drift_ppm, link->jitter_us, link->hold_chance, link->seconds);
+
+	for (i = 0; i < packets; i++) {
+		/* send time on the clock of the sink */
+		send_us = (long long)i * PACKET_US * 1000000 / (1000000 + link->drift_ppm);
+		arrive_us = send_us + trace_jitter(link->jitter_us);
+
+		if (hold_us > arrive_us)
+			arrive_us = hold_us;
+		else if (trace_rand(10000) < link->hold_chance)
+			hold_us = arrive_us = send_us + 100000 + trace_rand(100001);
+
+		if (arrive_us < last_us)
+			arrive_us = last_us;
+
+		printf("%lld\n", (arrive_us + TIME_UNIT_US / 2) / TIME_UNIT_US - last_unit);
+		last_unit = (arrive_us + TIME_UNIT_US / 2) / TIME_UNIT_US;
+		last_us = arrive_us;
+	}
+
+	return 0;
+}
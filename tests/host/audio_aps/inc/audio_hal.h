@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the audio hal, the aps level is set by the simulation */
+
+#ifndef __HOST_AUDIO_HAL_H__
+#define __HOST_AUDIO_HAL_H__
+
+#include <os_common_api.h>
+
+enum {
+	APS_LEVEL_AUDIOPLL = 0,
+	APS_LEVEL_ASRC,
+	APS_LEVEL_AUDIOPLL_F,
+};
+
+typedef enum {
+	APS_LEVEL_1 = 0,
+	APS_LEVEL_2,
+	APS_LEVEL_3,
+	APS_LEVEL_4,
+	APS_LEVEL_5,
+	APS_LEVEL_6,
+	APS_LEVEL_7,
+	APS_LEVEL_8,
+	APS_LEVEL_0PPM,
+} audio_aps_level_e;
+
+int hal_aout_channel_set_aps(void *aout_channel_handle, unsigned int aps_level, unsigned int aps_mode);
+
+#endif
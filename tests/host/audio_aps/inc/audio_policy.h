@@ -0,0 +1,14 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the audio policy */
+
+#ifndef __HOST_AUDIO_POLICY_H__
+#define __HOST_AUDIO_POLICY_H__
+
+int audio_policy_get_a2dp_lantency_time(void);
+
+#endif
@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the audio track */
+
+#ifndef __HOST_AUDIO_TRACK_H__
+#define __HOST_AUDIO_TRACK_H__
+
+#include <audio_system.h>
+#include <audio_policy.h>
+
+static inline int audio_track_set_waitto_start(struct audio_track_t *handle, bool wait)
+{
+	return 0;
+}
+
+static inline io_stream_t audio_track_get_stream(struct audio_track_t *handle)
+{
+	return NULL;
+}
+
+#endif
@@ -0,0 +1,18 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the latency thresholds, set by the simulation */
+
+#ifndef __HOST_AUDIOLCY_COMMON_H__
+#define __HOST_AUDIOLCY_COMMON_H__
+
+#include <os_common_api.h>
+
+uint32_t audiolcy_get_latency_threshold(uint8_t format);
+uint32_t audiolcy_get_latency_threshold_min(uint8_t format);
+uint8_t audiolcy_is_low_latency_mode(void);
+
+#endif
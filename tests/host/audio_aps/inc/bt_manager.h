@@ -0,0 +1,21 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the bt manager, restart requests are dropped */
+
+#ifndef __HOST_BT_MANAGER_H__
+#define __HOST_BT_MANAGER_H__
+
+#include <os_common_api.h>
+
+#define BT_REQ_RESTART_PLAY	0
+
+static inline int bt_manager_event_notify(int event_id, void *event_data, int event_data_size)
+{
+	return 0;
+}
+
+#endif
@@ -0,0 +1,14 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the memory manager */
+
+#ifndef __HOST_MEM_MANAGER_H__
+#define __HOST_MEM_MANAGER_H__
+
+#include <os_common_api.h>
+
+#endif
@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2016 Actions Semi Co., Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Bit exactness test and benchmark of the pcm mix kernels
+ *
+ * The portable and the SIMD kernels are compared with reference loops:
+ * the halving mix loop _audio_track_data_mix() used before the kernels
+ * for half gains, and the Q15 formula of audio_mix.h for other gains.
+ * The benchmark compares the portable kernels with the old loop.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "audio_mix.h"
+
+#define MAX_SAMPLES		1024
+#define BENCH_LOOPS		20000
+
+#define ARRAY_SIZE(a)		((int)(sizeof(a) / sizeof((a)[0])))
+
+audio_mix_func_t audio_mix_simd_get_func(uint8_t sample_bits, uint8_t channels,
+		int16_t main_gain, int16_t mix_gain);
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) \
+	do { \
+		if (!(cond)) { \
+			printf("FAIL %s:%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__); \
+			failures++; \
+		} \
+	} while (0)
+
+/* the mix loop of _audio_track_data_mix() before the kernels */
+static void old_mix(int bits, int channels, void *dest, const void *src,
+		int16_t *mix_buff[2], int mix_samples)
+{
+	if (bits == 32) {
+		int32_t *pdst = (int32_t *)dest;
+		const int32_t *psrc = (const int32_t *)src;
+
+		if (channels > 1) {
+			for (int i = 0; i < mix_samples; i++) {
+				*pdst++ = (*psrc++) / 2 + (((int32_t)mix_buff[0][i] / 2) << 16);
+				*pdst++ = (*psrc++) / 2 + (((int32_t)mix_buff[1][i] / 2) << 16);
+			}
+		} else {
+			for (int i = 0; i < mix_samples; i++) {
+				*pdst++ = (*psrc++) / 2 + (((int32_t)mix_buff[0][i] / 2) << 16);
+			}
+		}
+	} else {
+		int16_t *dest_buff = dest;
+		const int16_t *src_buff = src;
+
+		if (channels > 1) {
+			for (int i = 0; i < mix_samples; i++) {
+				*dest_buff++ = (*src_buff++) / 2 + mix_buff[0][i] / 2;
+				*dest_buff++ = (*src_buff++) / 2 + mix_buff[1][i] / 2;
+			}
+		} else {
+			for (int i = 0; i < mix_samples; i++) {
+				*dest_buff++ = (*src_buff++) / 2 + mix_buff[0][i] / 2;
+			}
+		}
+	}
+}
+
+static int64_t sat(int64_t val, int bits)
+{
+	int64_t max = ((int64_t)1 << (bits - 1)) - 1;
+
+	return val > max ? max : (val < -max - 1 ? -max - 1 : val);
+}
+
+/* reference of the kernels, as documented in audio_mix.h */
+static void ref_mix(int bits, int channels, void *dest, const void *src,
+		int16_t *mix[2], int samples, int16_t main_gain, int16_t mix_gain)
+{
+	int64_t s, m;
+	int i, ch;
+
+	if (main_gain == AUDIO_MIX_GAIN_HALF && mix_gain == AUDIO_MIX_GAIN_HALF) {
+		old_mix(bits, channels, dest, src, mix, samples);
+		return;
+	}
+
+	for (i = 0; i < samples; i++) {
+		for (ch = 0; ch < channels; ch++) {
+			m = (bits == 32) ? (int64_t)mix[ch][i] * 65536 : mix[ch][i];
+			s = (bits == 32) ? ((const int32_t *)src)[i * channels + ch] :
+				((const int16_t *)src)[i * channels + ch];
+
+			if (main_gain == AUDIO_MIX_GAIN_UNITY && mix_gain == AUDIO_MIX_GAIN_UNITY)
+				s = sat(s + m, bits);
+			else
+				s = sat((s * main_gain + m * mix_gain) >> 15, bits);
+
+			if (bits == 32)
+				((int32_t *)dest)[i * channels + ch] = s;
+			else
+				((int16_t *)dest)[i * channels + ch] = s;
+		}
+	}
+}
+
+static int32_t src_buf[2 * MAX_SAMPLES + 1];
+static int32_t ref_buf[2 * MAX_SAMPLES + 1];
+static int32_t out_buf[2 * MAX_SAMPLES + 1];
+static int32_t inplace_buf[2 * MAX_SAMPLES + 1];
+static int16_t mix_buf[2][MAX_SAMPLES + 2];
+
+static int16_t rand_sample(void)
+{
+	/* full scale values often, to hit saturation */
+	switch (rand() % 16) {
+	case 0:
+		return INT16_MIN;
+	case 1:
+		return INT16_MAX;
+	case 2:
+		return -1;
+	default:
+		return rand();
+	}
+}
+
+static void test_bit_exact(void)
+{
+	static const int16_t gains[] = {
+		0, 1, AUDIO_MIX_GAIN_HALF, AUDIO_MIX_GAIN_UNITY, 12345, 32000,
+	};
+	audio_mix_func_t func[2];
+	int16_t *mix[2], main_gain, mix_gain;
+	int n, i, bits, channels, samples, offset, size;
+	void *src, *inplace;
+
+	srand(3);
+
+	for (n = 0; n < 20000; n++) {
+		bits = (rand() & 1) ? 32 : 16;
+		channels = 1 + (rand() & 1);
+		samples = rand() % MAX_SAMPLES;
+		/* odd 16 bit offsets check the unaligned accesses */
+		offset = rand() % 3;
+		main_gain = gains[rand() % ARRAY_SIZE(gains)];
+		mix_gain = (rand() % 4) ? main_gain : gains[rand() % ARRAY_SIZE(gains)];
+
+		for (i = 0; i < ARRAY_SIZE(src_buf); i++)
+			src_buf[i] = ((uint32_t)rand_sample() << 16) | (uint16_t)rand_sample();
+		for (i = 0; i < MAX_SAMPLES + 2; i++) {
+			mix_buf[0][i] = rand_sample();
+			mix_buf[1][i] = rand_sample();
+		}
+
+		mix[0] = mix_buf[0] + offset;
+		mix[1] = mix_buf[1] + offset;
+		src = (int16_t *)src_buf + ((bits == 16) ? offset : 0);
+		inplace = (int16_t *)inplace_buf + ((bits == 16) ? offset : 0);
+		size = samples * channels * bits / 8;
+
+		func[0] = audio_mix_get_func(bits, channels, main_gain, mix_gain);
+		func[1] = audio_mix_simd_get_func(bits, channels, main_gain, mix_gain);
+
+		ref_mix(bits, channels, ref_buf, src, mix, samples, main_gain, mix_gain);
+
+		for (i = 0; i < 2; i++) {
+			func[i](out_buf, src, mix, samples, main_gain, mix_gain);
+			CHECK(!memcmp(out_buf, ref_buf, size), "%s s%d ch%d gains %d/%d",
+			      i ? "simd" : "portable", bits, channels, main_gain, mix_gain);
+
+			/* dest == src */
+			memcpy(inplace_buf, src_buf, sizeof(src_buf));
+			func[i](inplace, inplace, mix, samples, main_gain, mix_gain);
+			CHECK(!memcmp(inplace, ref_buf, size), "%s in place s%d ch%d gains %d/%d",
+			      i ? "simd" : "portable", bits, channels, main_gain, mix_gain);
+		}
+
+		if (failures)
+			return;
+	}
+
+	CHECK(!audio_mix_get_func(24, 2, 0, 0), "s24 accepted");
+	CHECK(!audio_mix_get_func(16, 3, 0, 0), "3 channels accepted");
+}
+
+static double bench_msps(int bits, int old, int16_t main_gain, int16_t mix_gain)
+{
+	audio_mix_func_t func = audio_mix_get_func(bits, 2, main_gain, mix_gain);
+	int16_t *mix[2] = { mix_buf[0], mix_buf[1] };
+	clock_t start = clock();
+	int n;
+
+	for (n = 0; n < BENCH_LOOPS; n++) {
+		if (old)
+			old_mix(bits, 2, src_buf, src_buf, mix, MAX_SAMPLES);
+		else
+			func(src_buf, src_buf, mix, MAX_SAMPLES, main_gain, mix_gain);
+		/* keep the loop from being folded */
+		__asm__ volatile("" : : "r"(src_buf) : "memory");
+	}
+
+	return (double)BENCH_LOOPS * MAX_SAMPLES /
+		((double)(clock() - start) / CLOCKS_PER_SEC) / 1e6;
+}
+
+static void bench_mix(void)
+{
+	int bits;
+
+	for (bits = 16; bits <= 32; bits += 16) {
+		printf("s%d stereo Msamples/s: old loop %.0f, half %.0f, unity %.0f, gain %.0f\n",
+		       bits, bench_msps(bits, 1, 0, 0),
+		       bench_msps(bits, 0, AUDIO_MIX_GAIN_HALF, AUDIO_MIX_GAIN_HALF),
+		       bench_msps(bits, 0, AUDIO_MIX_GAIN_UNITY, AUDIO_MIX_GAIN_UNITY),
+		       bench_msps(bits, 0, 23197, 23197));
+	}
+}
+
+int main(void)
+{
+	test_bit_exact();
+	bench_mix();
+
+	if (failures) {
+		printf("audio_mix: %d failures\n", failures);
+		return 1;
+	}
+
+	printf("audio_mix: OK\n");
+	return 0;
+}
@@ -0,0 +1,69 @@
+/*
+ * host emulation of the Cortex-M DSP intrinsics used by the mix kernels,
+ * following the ARMv7-M architecture reference manual
+ */
+
+#ifndef __HOST_CMSIS_H__
+#define __HOST_CMSIS_H__
+
+#include <stdint.h>
+#include <string.h>
+
+static inline uint32_t __UNALIGNED_UINT32_READ(const void *ptr)
+{
+	uint32_t val;
+
+	memcpy(&val, ptr, 4);
+	return val;
+}
+
+static inline void __UNALIGNED_UINT32_WRITE(void *ptr, uint32_t val)
+{
+	memcpy(ptr, &val, 4);
+}
+
+#define __PKHBT(a, b, sh) \
+	((((uint32_t)(a)) & 0xFFFFu) | (((uint32_t)(b) << (sh)) & 0xFFFF0000u))
+#define __PKHTB(a, b, sh) \
+	((((uint32_t)(a)) & 0xFFFF0000u) | (((uint32_t)(b) >> (sh)) & 0xFFFFu))
+
+static inline int32_t __SSAT(int32_t val, int bits)
+{
+	int32_t max = (1 << (bits - 1)) - 1, min = -(1 << (bits - 1));
+
+	return val > max ? max : (val < min ? min : val);
+}
+
+static inline uint32_t __SMUAD(uint32_t x, uint32_t y)
+{
+	return (uint32_t)((int32_t)(int16_t)x * (int16_t)y +
+			(int32_t)(int16_t)(x >> 16) * (int16_t)(y >> 16));
+}
+
+static inline uint32_t __QADD16(uint32_t a, uint32_t b)
+{
+	return (uint16_t)__SSAT((int16_t)a + (int16_t)b, 16) |
+		((uint32_t)(uint16_t)__SSAT((int16_t)(a >> 16) + (int16_t)(b >> 16), 16) << 16);
+}
+
+static inline uint32_t __SADD16(uint32_t a, uint32_t b)
+{
+	return (uint16_t)((int16_t)a + (int16_t)b) |
+		((uint32_t)(uint16_t)((int16_t)(a >> 16) + (int16_t)(b >> 16)) << 16);
+}
+
+/* halving add, the sum is shifted right arithmetically */
+static inline uint32_t __SHADD16(uint32_t a, uint32_t b)
+{
+	return (uint16_t)(((int16_t)a + (int16_t)b) >> 1) |
+		((uint32_t)(uint16_t)(((int16_t)(a >> 16) + (int16_t)(b >> 16)) >> 1) << 16);
+}
+
+static inline int32_t __QADD(int32_t a, int32_t b)
+{
+	int64_t val = (int64_t)a + b;
+
+	return val > INT32_MAX ? INT32_MAX : (val < INT32_MIN ? INT32_MIN : val);
+}
+
+#endif
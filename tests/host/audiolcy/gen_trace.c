@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief generate a2dp packet arrival traces for lcy_replay
+ *
+ * Writes the trace of one link to stdout. The phone sends a packet as soon
+ * as its audio is due, 7 frames of 128 samples for sbc and 1024 samples
+ * for aac at 44.1k. Each packet is delayed by 3 ms plus half normal radio
+ * jitter. Now and then the link holds the packets back, all packets sent
+ * during a hold arrive in a burst at its end. A bad RF link has more
+ * jitter, retransmission holds of 30-120 ms at 1% of the packets and long
+ * holds of up to 170 ms. A recovering link is bad until it clears, and
+ * good after. Arrivals are never reordered.
+ *
+ * Arrival times are rounded to 100 us, the gaps are taken between the
+ * rounded times so that no time is lost over the whole trace.
+ *
+ * Trace format, one packet per line:
+ *   # format <sbc|aac> frames <frame count> len <packet length>
+ *   # comment
+ *   <gap>    arrival time after the previous packet, in 100 us
+ *
+ * Usage: gen_trace sbc-good|sbc-bad|sbc-recover|aac-good|aac-bad
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARRAY_SIZE(a)		(sizeof(a) / sizeof((a)[0]))
+#define SAMPLE_RATE		44100
+#define TIME_UNIT_US		100
+#define START_US		200000
+#define AIR_DELAY_US		3000
+#define GOOD_JITTER_US		1200
+#define GOOD_HOLD_CHANCE	5
+#define GOOD_HOLD_MAX_US	30000
+
+struct link_profile {
+	const char *name;
+	const char *format;
+	unsigned int frames;
+	unsigned int samples;
+	unsigned int pkt_len;
+	unsigned int seed;
+	/* mean of the half normal delay of each packet */
+	unsigned int jitter_us;
+	/* retransmission holds of 30-120 ms, chance per packet in 1/10000 */
+	unsigned int retrans_chance;
+	/* long holds of 20 ms up to 20 ms + hold_max_us */
+	unsigned int hold_chance;
+	unsigned int hold_max_us;
+	unsigned int seconds;
+	/* time from which on the link is good, 0: never */
+	unsigned int clear_s;
+};
+
+static const struct link_profile links[] = {
+	{ "sbc-good",	"sbc", 7, 7 * 128, 595, 1, 1200, 0, 5, 30000, 600, 0 },
+	{ "sbc-bad",	"sbc", 7, 7 * 128, 595, 2, 3200, 100, 20, 150000, 600, 0 },
+	{ "sbc-recover", "sbc", 7, 7 * 128, 595, 5, 3200, 100, 20, 150000, 900, 180 },
+	{ "aac-good",	"aac", 1, 1024, 600, 3, 1200, 0, 5, 30000, 600, 0 },
+	{ "aac-bad",	"aac", 1, 1024, 600, 4, 3200, 100, 20, 150000, 600, 0 },
+};
+
+static unsigned int rand_state;
+
+static unsigned int trace_rand(unsigned int range)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+	return ((rand_state >> 8) & 0xffffff) % range;
+}
+
+/* half normal delay of the given mean, from the sum of 4 uniforms */
+static unsigned int trace_jitter(unsigned int mean_us)
+{
+	int sum = 0, i;
+
+	for (i = 0; i < 4; i++)
+		sum += trace_rand(1001);
+	sum -= 2000;
+
+	/* sd of the sum is 577, mean of the half normal is 0.8 sd */
+	return (unsigned int)abs(sum) * mean_us / 462;
+}
+
+int main(int argc, char *argv[])
+{
+	const struct link_profile *link = NULL;
+	unsigned int jitter_us, retrans_chance, hold_chance, hold_max_us;
+	long long send_us, arrive_us, last_us = 0, hold_us = 0, last_unit = 0;
+	unsigned int i;
+
+	for (i = 0; argc > 1 && i < ARRAY_SIZE(links); i++) {
+		if (!strcmp(argv[1], links[i].name))
+			link = &links[i];
+	}
+
+	if (!link) {
+		fprintf(stderr, "usage: gen_trace sbc-good|sbc-bad|sbc-recover|aac-good|aac-bad\n");
+		return 1;
+	}
+
+	rand_state = link->seed;
+
+	printf("# format %s frames %u len %u\n", link->format, link->frames, link->pkt_len);
+	printf("# %s: jitter %u us, retransmission %u/10000, hold %u/10000 up to %u ms, %u s\n",
+	       link->name, link->jitter_us, link->retrans_chance, link->hold_chance,
+	       (20000 + link->hold_max_us) / 1000, link->seconds);
+	if (link->clear_s)
+		printf("# clear at %u s\n", link->clear_s);
+
+	for (i = 0; ; i++) {
+		send_us = START_US + (long long)i * link->samples * 1000000 / SAMPLE_RATE;
+		if (send_us >= link->seconds * 1000000ll)
+			break;
+
+		if (link->clear_s && send_us >= link->clear_s * 1000000ll) {
+			jitter_us = GOOD_JITTER_US;
+			retrans_chance = 0;
+			hold_chance = GOOD_HOLD_CHANCE;
+			hold_max_us = GOOD_HOLD_MAX_US;
+		} else {
+			jitter_us = link->jitter_us;
+			retrans_chance = link->retrans_chance;
+			hold_chance = link->hold_chance;
+			hold_max_us = link->hold_max_us;
+		}
+
+		arrive_us = send_us + AIR_DELAY_US + trace_jitter(jitter_us);
+
+		if (hold_us > send_us) {
+			/* queued up behind a hold */
+			arrive_us += hold_us - send_us;
+		} else if (trace_rand(10000) < retrans_chance) {
+			hold_us = send_us + 30000 + trace_rand(90001);
+			arrive_us += hold_us - send_us;
+		} else if (trace_rand(10000) < hold_chance) {
+			hold_us = send_us + 20000 + trace_rand(hold_max_us + 1);
+			arrive_us += hold_us - send_us;
+		}
+
+		if (arrive_us < last_us)
+			arrive_us = last_us;
+
+		printf("%lld\n", (arrive_us + TIME_UNIT_US / 2) / TIME_UNIT_US - last_unit);
+		last_unit = (arrive_us + TIME_UNIT_US / 2) / TIME_UNIT_US;
+		last_us = arrive_us;
+	}
+
+	return 0;
+}
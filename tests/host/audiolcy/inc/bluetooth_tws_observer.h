@@ -0,0 +1,14 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the bluetooth tws observer */
+
+#ifndef __HOST_BLUETOOTH_TWS_OBSERVER_H__
+#define __HOST_BLUETOOTH_TWS_OBSERVER_H__
+
+#include <btservice_api.h>
+
+#endif
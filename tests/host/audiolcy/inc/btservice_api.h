@@ -0,0 +1,19 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the bt service api, only the tws roles */
+
+#ifndef __HOST_BTSERVICE_API_H__
+#define __HOST_BTSERVICE_API_H__
+
+enum {
+	BTSRV_TWS_NONE,
+	BTSRV_TWS_PENDING,
+	BTSRV_TWS_MASTER,
+	BTSRV_TWS_SLAVE,
+};
+
+#endif
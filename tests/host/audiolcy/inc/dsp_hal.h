@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the dsp hal, the replay captures the mplc config */
+
+#ifndef __HOST_DSP_HAL_H__
+#define __HOST_DSP_HAL_H__
+
+#include <os_common_api.h>
+
+#define DSP_FUNCTION_DECODER		0
+#define DSP_CONFIG_DECODER_MPLC		0
+
+/* as in dsp_hal_defs.h */
+struct decoder_dspfunc_mplc_params {
+	uint16_t mode:2;            // 0:disable, 1:empty frame plc, 2:history frame plc
+	uint16_t thres_pause:6;     // mplc pause, due to too many empty frames(continuous)
+	uint16_t thres_pemframe:8;  // mplc pause, due to too many empty frames in a period
+	uint16_t thres_period;      // mplc empty frame statistics period
+	uint16_t thres_resume;      // mplc resume, enough normal frames(continuous)
+	uint16_t reserved;
+	uint16_t samples_th1;       // rawdata is empty, do interpolation when pcmdata is lower
+	uint16_t samples_th2;       // bigger than th1, keep doing interlolation thres after mplc started
+} __attribute__((packed));
+
+int dsp_session_config_func(void *session, unsigned int func, unsigned int conf, size_t size,
+			    const void *params);
+
+#endif
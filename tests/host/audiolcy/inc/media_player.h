@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the media player */
+
+#ifndef __HOST_MEDIA_PLAYER_H__
+#define __HOST_MEDIA_PLAYER_H__
+
+#include <media_type.h>
+#include <mem_manager.h>
+
+#endif
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the OS API used by audio latency, uptime is the time of the replay */
+
+#ifndef __HOST_OS_COMMON_API_H__
+#define __HOST_OS_COMMON_API_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+
+typedef uint8_t u8_t;
+typedef uint16_t u16_t;
+typedef uint32_t u32_t;
+typedef int16_t s16_t;
+typedef int32_t s32_t;
+
+#define ARG_UNUSED(x)		(void)(x)
+#define ARRAY_SIZE(a)		(sizeof(a) / sizeof((a)[0]))
+#define BIT(n)			(1u << (n))
+
+#ifdef HOST_LOG
+#define printk(...)		printf(__VA_ARGS__)
+#define SYS_LOG_INF(fmt, ...)	printf("I " fmt "\n", ##__VA_ARGS__)
+#define SYS_LOG_ERR(fmt, ...)	printf("E " fmt "\n", ##__VA_ARGS__)
+#else
+#define printk(...)		do { } while (0)
+#define SYS_LOG_INF(...)	do { } while (0)
+#define SYS_LOG_ERR(...)	do { } while (0)
+#endif
+#define SYS_LOG_DBG(...)	do { } while (0)
+#define SYS_LOG_WRN(...)	do { } while (0)
+
+extern uint32_t sim_now_ms;
+
+static inline uint32_t k_uptime_get_32(void)
+{
+	return sim_now_ms;
+}
+
+typedef struct { int dummy; } os_mutex;
+typedef struct { int dummy; } os_sem;
+typedef struct { int dummy; } os_work;
+typedef struct { int dummy; } os_delayed_work;
+
+#endif
@@ -0,0 +1,12 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the property manager */
+
+#ifndef __HOST_PROPERTY_MANAGER_H__
+#define __HOST_PROPERTY_MANAGER_H__
+
+#endif
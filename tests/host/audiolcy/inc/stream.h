@@ -0,0 +1,16 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the stream interface */
+
+#ifndef __HOST_STREAM_H__
+#define __HOST_STREAM_H__
+
+#include <os_common_api.h>
+
+typedef struct __stream *io_stream_t;
+
+#endif
@@ -0,0 +1,411 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief replay of a2dp packet arrival traces through the audio latency core
+ *
+ * The real audiolcy_adaptive.c (ALLM) and audiolcy_interpolation.c (mPLC)
+ * run on the packet arrival traces of gen_trace. ALLM gets the system
+ * services by audiolcyapt_ops_t, the mPLC thresholds are captured from its
+ * dsp_session_config_func() call.
+ *
+ * The player is modelled in steps of 1 ms: arriving packets add their
+ * samples to the buffer, playback starts once the buffer holds the target
+ * latency, and aps follows the target at 2000 ppm. A frame of 128 samples
+ * is played when due; with the rawdata empty below th1 (th2 once mPLC is
+ * running) mPLC inserts the frame instead, and pauses after thres_pause
+ * inserted frames in a row until thres_resume normal frames were played.
+ * An empty buffer is an underrun, the player restarts and refills to the
+ * target latency. audiolcy_adaptive_main() runs every 10 ms.
+ *
+ * Each trace is replayed with the ALLM factor 3 and 0. Reported are the
+ * average target latency after the first 10 s and in the last 2 min, the
+ * average and minimum buffer, the latency changes, the mPLC insertions and
+ * pauses, and the underruns; -v also prints the latency timeline. On a
+ * good link ALLM must stay within 30 ms of the LLM latency without
+ * underruns, on a bad link it must raise the latency by more than 40 ms
+ * and underrun at most once, and in the last 2 min of a link which is
+ * good after 3 min the latency must be back within 40 ms of it.
+ *
+ * Usage: lcy_replay [-v] <trace>...
+ */
+
+#include <math.h>
+#include <os_common_api.h>
+#include <audio_system.h>
+#include <media_type.h>
+#include <dsp_hal.h>
+#include "audiolcy/audiolcy_inner.h"
+
+#define SAMPLE_RATE_KHZ		44.1
+#define FRAME_SAMPLES		128
+#define TIME_UNIT_US		100
+#define APS_PPM			2000
+#define APS_DEAD_ZONE_US	2000
+#define MAIN_PERIOD_MS		10
+#define STATS_START_MS		10000
+#define END_PERIOD_MS		120000
+#define MAX_PACKETS		40000
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) \
+	do { \
+		if (!(cond)) { \
+			printf("FAIL %s:%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__); \
+			failures++; \
+		} \
+	} while (0)
+
+uint32_t sim_now_ms;
+
+static bool verbose;
+static uint32_t now_us;
+static uint32_t target_us;
+static int latency_changes;
+static u16_t max_pkt_len;
+static struct decoder_dspfunc_mplc_params mplc;
+
+static uint32_t arrivals[MAX_PACKETS];
+static int packet_num;
+static u8_t trace_format;
+static unsigned int trace_frames, trace_pkt_len;
+
+/* used by audiolcy_interpolation.c */
+u8_t audiolcy_is_low_latency_mode(void)
+{
+	return 1;
+}
+
+int dsp_session_config_func(void *session, unsigned int func, unsigned int conf, size_t size,
+			    const void *params)
+{
+	memcpy(&mplc, params, sizeof(mplc));
+	return 0;
+}
+
+static u32_t replay_uptime_ms(void)
+{
+	return now_us / 1000;
+}
+
+/* sysclk_cyc of the packets is given in us */
+static u32_t replay_cyc_to_us(u32_t cycles)
+{
+	return cycles;
+}
+
+static u32_t replay_llm_threshold_us(u8_t format)
+{
+	return (format == SBC_TYPE) ? 60000 : 80000;
+}
+
+static u8_t replay_latency_mode(void)
+{
+	return LCYMODE_ADAPTIVE;
+}
+
+static u32_t replay_latency_us(void)
+{
+	return target_us;
+}
+
+static u32_t replay_samplerate_hz(u8_t is_48khz)
+{
+	return is_48khz ? 48000 : 44100;
+}
+
+/* as audiolcy_ctrl_get_fixedcost() for music */
+static void replay_fixedcost(u32_t *samples)
+{
+	u32_t fixed_cost_us;
+
+	if (max_pkt_len > 679)
+		fixed_cost_us = 5600;
+	else if (max_pkt_len > 367)
+		fixed_cost_us = 3200;
+	else
+		fixed_cost_us = 1800;
+
+	*samples = fixed_cost_us * 44 / 1000;
+}
+
+static u32_t replay_latency_change(u16_t lcy_ms)
+{
+	if (target_us != lcy_ms * 1000u) {
+		latency_changes++;
+		if (verbose)
+			printf("%8.3f s: latency %u -> %u ms\n", now_us / 1e6, target_us / 1000, lcy_ms);
+	}
+
+	target_us = lcy_ms * 1000;
+	return lcy_ms;
+}
+
+static void replay_latency_twssync(u8_t mode, u16_t lcy_ms)
+{
+}
+
+static const audiolcyapt_ops_t replay_ops = {
+	.uptime_ms = replay_uptime_ms,
+	.cyc_to_us = replay_cyc_to_us,
+	.get_llm_threshold_us = replay_llm_threshold_us,
+	.get_latency_mode = replay_latency_mode,
+	.get_latency_us = replay_latency_us,
+	.get_samplerate_hz = replay_samplerate_hz,
+	.get_fixedcost = replay_fixedcost,
+	.latency_change = replay_latency_change,
+	.latency_twssync = replay_latency_twssync,
+};
+
+static int load_trace(const char *path)
+{
+	char line[128], format[8];
+	uint32_t time_us = 0;
+	FILE *fp = fopen(path, "r");
+
+	if (!fp)
+		return -ENOENT;
+
+	packet_num = 0;
+	trace_format = 0;
+
+	while (fgets(line, sizeof(line), fp) && packet_num < MAX_PACKETS) {
+		if (line[0] == '#') {
+			if (sscanf(line, "# format %7s frames %u len %u", format, &trace_frames,
+				   &trace_pkt_len) == 3)
+				trace_format = strcmp(format, "sbc") ? AAC_TYPE : SBC_TYPE;
+			continue;
+		}
+
+		time_us += strtoul(line, NULL, 10) * TIME_UNIT_US;
+		arrivals[packet_num++] = time_us;
+	}
+
+	fclose(fp);
+	return (packet_num && trace_format) ? 0 : -EINVAL;
+}
+
+struct replay_result {
+	double avg_latency_ms;
+	/* in the last 2 min of the trace */
+	double end_latency_ms;
+	double avg_buffer_ms;
+	double min_buffer_ms;
+	int plc_frames;
+	int plc_pauses;
+	int underruns;
+};
+
+static void replay(const char *trace, int factor, struct replay_result *result)
+{
+	audiolcy_cfg_t cfg = {
+		.BM_Use_ALLM = 1,
+		.BM_ALLM_Factor = factor,
+		.BM_ALLM_Upper = 150,
+		.BM_PLC_Mode = 1,
+		.ALLM_recommend_period_s = 10,
+		.ALLM_scc_ignore_period_ms = 3000,
+		.ALLM_scc_ignore_count = 3,
+		.ALLM_scc_clear_step = 10,
+		.ALLM_scc_clear_period_s = 120,
+		.ALLM_down_timer_period_s = 120,
+	};
+	audiolcy_common_t common = {
+		.cfg = &cfg,
+		.media_format = trace_format,
+		.stream_type = AUDIO_STREAM_MUSIC,
+		.sample_rate_khz = 44,
+	};
+	u32_t frame_samples = (trace_format == SBC_TYPE) ? trace_frames * FRAME_SAMPLES : 1024;
+	void *lcyapt, *lcymplc;
+	double buffer = 0, frame_pos = 0, error_us, ppm;
+	double latency_sum = 0, buffer_sum = 0, n = 0, end_sum = 0, end_n = 0;
+	bool playing = false, plc_running = false, plc_paused = false;
+	int empty_run = 0, normal_run = 0, packet = 0;
+	uint32_t next_main_ms = 0, threshold;
+	uint32_t end_start_us = arrivals[packet_num - 1] - END_PERIOD_MS * 1000;
+
+	memset(result, 0, sizeof(*result));
+	result->min_buffer_ms = 1e9;
+	latency_changes = 0;
+	max_pkt_len = 0;
+	now_us = 0;
+
+	/* no adaptive latency of the previous replay */
+	audiolcyapt_global_set_invalid();
+
+	lcyapt = audiolcy_adatpive_init(&common, &replay_ops);
+	lcymplc = audiolcy_musicplc_init(&common, (void *)1);
+	common.twsrole = BTSRV_TWS_NONE;
+	target_us = audiolcyapt_latency_get(lcyapt) * 1000;
+
+	if (verbose)
+		printf("%s factor %d: mplc th1 %u th2 %u pause %u resume %u, start latency %u ms\n",
+		       trace, factor, mplc.samples_th1, mplc.samples_th2, mplc.thres_pause,
+		       mplc.thres_resume, target_us / 1000);
+
+	for (now_us = 0; packet < packet_num; now_us += 1000) {
+		sim_now_ms = now_us / 1000;
+
+		while (packet < packet_num && arrivals[packet] <= now_us) {
+			audiolcy_pktinfo_t pktinfo = {
+				.seq_no = packet,
+				.pkt_len = trace_pkt_len,
+				.frame_cnt = trace_frames,
+				.sysclk_cyc = arrivals[packet],
+			};
+
+			if (max_pkt_len < trace_pkt_len)
+				max_pkt_len = trace_pkt_len;
+
+			buffer += frame_samples;
+			audiolcyapt_info_collect(lcyapt, &pktinfo);
+			packet++;
+		}
+
+		if (!playing) {
+			if (buffer >= target_us * SAMPLE_RATE_KHZ / 1000) {
+				playing = true;
+				audiolcy_adaptive_start_play(lcyapt);
+			}
+		} else {
+			/* aps follows the target latency */
+			error_us = buffer / SAMPLE_RATE_KHZ * 1000 - target_us;
+			if (error_us > APS_DEAD_ZONE_US)
+				ppm = APS_PPM;
+			else if (error_us < -APS_DEAD_ZONE_US)
+				ppm = -APS_PPM;
+			else
+				ppm = 0;
+
+			frame_pos += SAMPLE_RATE_KHZ * (1 + ppm * 1e-6);
+
+			while (frame_pos >= FRAME_SAMPLES) {
+				frame_pos -= FRAME_SAMPLES;
+				threshold = plc_running ? mplc.samples_th2 : mplc.samples_th1;
+
+				if (lcymplc && !plc_paused && buffer < threshold + FRAME_SAMPLES) {
+					/* rawdata empty, mplc inserts a frame */
+					result->plc_frames++;
+					plc_running = true;
+					normal_run = 0;
+					if (++empty_run >= mplc.thres_pause) {
+						plc_paused = true;
+						result->plc_pauses++;
+					}
+					continue;
+				}
+
+				if (buffer < FRAME_SAMPLES) {
+					/* underrun, the player restarts and refills to the target */
+					result->underruns++;
+					playing = false;
+					frame_pos = 0;
+					if (verbose)
+						printf("%8.3f s: underrun\n", now_us / 1e6);
+					break;
+				}
+
+				buffer -= FRAME_SAMPLES;
+				plc_running = false;
+				empty_run = 0;
+				if (++normal_run >= mplc.thres_resume)
+					plc_paused = false;
+			}
+		}
+
+		if (sim_now_ms >= next_main_ms) {
+			next_main_ms += MAIN_PERIOD_MS;
+			audiolcy_adaptive_main(lcyapt);
+		}
+
+		if (playing && sim_now_ms >= STATS_START_MS) {
+			latency_sum += target_us / 1000.0;
+			buffer_sum += buffer / SAMPLE_RATE_KHZ;
+			if (buffer / SAMPLE_RATE_KHZ < result->min_buffer_ms)
+				result->min_buffer_ms = buffer / SAMPLE_RATE_KHZ;
+			n++;
+		}
+
+		if (now_us >= end_start_us) {
+			end_sum += target_us / 1000.0;
+			end_n++;
+		}
+	}
+
+	result->avg_latency_ms = latency_sum / n;
+	result->end_latency_ms = end_sum / end_n;
+	result->avg_buffer_ms = buffer_sum / n;
+
+	printf("%-15s factor %d: latency %5.1f ms end %5.1f ms, buffer %5.1f ms min %5.1f ms, "
+	       "changes %2d, plc frames %4d (%5.1f ms) pauses %d, underruns %d\n", trace, factor,
+	       result->avg_latency_ms, result->end_latency_ms, result->avg_buffer_ms,
+	       result->min_buffer_ms, latency_changes,
+	       result->plc_frames, result->plc_frames * FRAME_SAMPLES / SAMPLE_RATE_KHZ,
+	       result->plc_pauses, result->underruns);
+
+	audiolcy_musicplc_deinit(lcymplc);
+	audiolcy_adaptive_deinit(lcyapt);
+}
+
+int main(int argc, char *argv[])
+{
+	struct replay_result result, result_factor0;
+	const char *name;
+	double llm_ms;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-v")) {
+			verbose = true;
+			continue;
+		}
+
+		if (load_trace(argv[i])) {
+			CHECK(0, "trace %s", argv[i]);
+			continue;
+		}
+
+		name = strrchr(argv[i], '/') ? strrchr(argv[i], '/') + 1 : argv[i];
+		llm_ms = replay_llm_threshold_us(trace_format) / 1000.0;
+
+		replay(name, 0, &result_factor0);
+		replay(name, 3, &result);
+
+		if (strstr(name, "good")) {
+			CHECK(result.underruns == 0, "%s: %d underruns", name, result.underruns);
+			CHECK(result.avg_latency_ms < llm_ms + 30, "%s: latency %.1f ms", name,
+			      result.avg_latency_ms);
+			CHECK(result.plc_frames < 10, "%s: %d plc frames", name, result.plc_frames);
+		} else if (strstr(name, "recover")) {
+			/* the down timers bring the latency back once the link is good */
+			CHECK(result.end_latency_ms < llm_ms + 40, "%s: end latency %.1f ms", name,
+			      result.end_latency_ms);
+			CHECK(result.underruns <= 1, "%s: %d underruns", name, result.underruns);
+		} else {
+			CHECK(result.underruns <= 1, "%s: %d underruns", name, result.underruns);
+			CHECK(result.avg_latency_ms > llm_ms + 40, "%s: latency %.1f ms", name,
+			      result.avg_latency_ms);
+		}
+
+		/* a lower factor never costs latency */
+		CHECK(result_factor0.avg_latency_ms <= result.avg_latency_ms,
+		      "%s: factor 0 latency %.1f ms above factor 3", name,
+		      result_factor0.avg_latency_ms);
+		CHECK(result.avg_latency_ms >= llm_ms, "%s: latency %.1f ms below llm", name,
+		      result.avg_latency_ms);
+	}
+
+	if (failures) {
+		printf("audiolcy: %d failures\n", failures);
+		return 1;
+	}
+
+	printf("audiolcy: OK\n");
+	return 0;
+}
@@ -0,0 +1,724 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief replay test of the btsnoop capture ring
+ *
+ * btsnoop.c is built into the test for a ring of CONFIG_BT_SNOOP_BUF_SIZE
+ * and a capture length of CONFIG_BT_SNOOP_CAP_LEN, the defaults are those
+ * of Kconfig. The kernel uptime is the time of the packet being written.
+ *
+ * First the ring is filled so that records wrap at every remainder of its
+ * tail, down to a pad shorter than the record header, then until packets
+ * are dropped, and packets of each type longer than the capture length
+ * are truncated. Each btsnoop file exported must hold the records written
+ * with their drop count.
+ *
+ * Then every btsnoop capture given is replayed through 4 producer threads,
+ * one for the received acl and sco packets, one for the sent ones, one
+ * for the events and one for the commands, while an exporter thread drains
+ * the ring into a btsnoop file in memory. The exported file must hold the
+ * header once, then the records of each producer in order, and exactly the
+ * packets which btsnoop_write_packet() did not drop, each truncated to its
+ * capture length and with the drops counted before it. Nothing may be left
+ * in the ring and the counters must match what the producers saw.
+ *
+ * Usage: btsnoop_test <btsnoop capture, H4>...
+ */
+
+#ifndef CONFIG_BT_SNOOP_BUF_SIZE
+#define CONFIG_BT_SNOOP_BUF_SIZE	4096
+#endif
+#ifndef CONFIG_BT_SNOOP_CAP_LEN
+#define CONFIG_BT_SNOOP_CAP_LEN		0
+#endif
+
+/* btsnoop.c declares its own printf */
+#define printf btsnoop_printf
+#include "../../../framework/bluetooth/bt_stack/src/btsnoop.c"
+#undef printf
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+
+#define ARRAY_SIZE(a)	(sizeof(a) / sizeof((a)[0]))
+#define PRODUCERS	4
+#define MAX_PACKETS	200000
+#define SINGLE_PACKETS	4096
+#define REPLAY_SPEEDUP	50
+
+struct packet {
+	/* H4 packet, starting with the packet type */
+	const uint8_t *data;
+	uint16_t orig_len;
+	uint16_t incl_len;
+	uint8_t flags;
+	uint8_t captured;
+	uint32_t ms;
+	/* drops seen by the producer before the packet */
+	uint32_t drops;
+};
+
+struct producer {
+	pthread_t thread;
+	struct packet **pkts;
+	unsigned int count;
+	unsigned int head;
+	uint32_t drops;
+	uint32_t last_drops;
+};
+
+struct export_buf {
+	uint8_t *data;
+	uint32_t size;
+	uint32_t len;
+};
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) \
+	do { \
+		if (!(cond)) { \
+			if (failures++ < 20) \
+				printf("FAIL %s:%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__); \
+		} \
+	} while (0)
+
+static __thread uint32_t replay_ms;
+
+uint32_t k_uptime_get_32(void)
+{
+	return replay_ms;
+}
+
+void btsnoop_printf(const char *fmt, ...)
+{
+	va_list ap;
+
+	va_start(ap, fmt);
+	vprintf(fmt, ap);
+	va_end(ap);
+}
+
+static uint64_t now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+static uint32_t get_be32(const uint8_t *p)
+{
+	return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+/* length of a H4 packet as btsnoop_write_packet() takes it */
+static uint32_t packet_length(const uint8_t *data, uint32_t len)
+{
+	switch (data[0]) {
+	case kCommandPacket:
+		return len >= 4 ? data[3] + 4 : 0;
+	case kAclPacket:
+		return len >= 5 ? ((data[4] << 8) | data[3]) + 5 : 0;
+	case kScoPacket:
+		return len >= 4 ? data[3] + 4 : 0;
+	case kEventPacket:
+		return len >= 3 ? data[2] + 3 : 0;
+	default:
+		return 0;
+	}
+}
+
+static uint32_t capture_length(uint32_t orig_len)
+{
+	uint32_t incl_len = orig_len;
+
+	if (CONFIG_BT_SNOOP_CAP_LEN && incl_len > CONFIG_BT_SNOOP_CAP_LEN)
+		incl_len = CONFIG_BT_SNOOP_CAP_LEN;
+	if (incl_len > SNOOP_REC_MAX_DATA)
+		incl_len = SNOOP_REC_MAX_DATA;
+
+	return incl_len;
+}
+
+static int producer_of(uint8_t type, uint32_t flags)
+{
+	if (type == kCommandPacket)
+		return 3;
+	if (type == kEventPacket)
+		return 2;
+
+	return (flags & 1) ? 0 : 1;
+}
+
+static void packet_init(struct packet *pkt, const uint8_t *data, uint32_t len, uint32_t ms,
+			bool is_received)
+{
+	pkt->data = data;
+	pkt->orig_len = len;
+	pkt->incl_len = capture_length(len);
+	pkt->ms = ms;
+	pkt->captured = 0;
+	pkt->drops = 0;
+
+	if (data[0] == kCommandPacket)
+		pkt->flags = 2;
+	else if (data[0] == kEventPacket)
+		pkt->flags = 3;
+	else
+		pkt->flags = is_received;
+}
+
+/* write the packet as the HCI driver does, the type is passed apart */
+static int packet_write(struct producer *prod, struct packet *pkt)
+{
+	int ret;
+
+	replay_ms = pkt->ms;
+	pkt->drops = prod->drops;
+
+	ret = btsnoop_write_packet(pkt->data[0], pkt->data + 1, pkt->flags & 1);
+	if (ret) {
+		CHECK(ret == pkt->orig_len, "write returned %d for %u bytes", ret, pkt->orig_len);
+		pkt->captured = 1;
+	} else {
+		prod->drops++;
+	}
+
+	return ret;
+}
+
+static int mem_export(void *ctx, const void *data, uint32_t length)
+{
+	struct export_buf *out = ctx;
+
+	if (out->len + length > out->size)
+		return -ENOSPC;
+
+	memcpy(out->data + out->len, data, length);
+	out->len += length;
+	return length;
+}
+
+static void export_reset(struct export_buf *out)
+{
+	out->len = 0;
+}
+
+/*
+ * Check the exported btsnoop file against the packets of the producers.
+ * With exact drops each record must carry the drops counted before it was
+ * written, else at least the drops of its own producer.
+ */
+static void check_export(struct export_buf *out, bool with_head, struct producer *prods,
+			 bool exact_drops)
+{
+	uint32_t pos = 0, orig_len, incl_len, flags, drops;
+	uint32_t total_drops = atomic_get(&snoop_drops);
+	struct producer *prod;
+	struct packet *pkt;
+	uint64_t time;
+	int i;
+
+	if (with_head) {
+		CHECK(out->len >= SNOOP_HEAD_LEN && !memcmp(out->data, SNOOP_HEAD, SNOOP_HEAD_LEN),
+		      "no btsnoop header");
+		pos = SNOOP_HEAD_LEN;
+	}
+
+	while (pos < out->len) {
+		if (out->len - pos < 24) {
+			CHECK(0, "record header cut at %u of %u", pos, out->len);
+			return;
+		}
+
+		orig_len = get_be32(out->data + pos);
+		incl_len = get_be32(out->data + pos + 4);
+		flags = get_be32(out->data + pos + 8);
+		drops = get_be32(out->data + pos + 12);
+		time = ((uint64_t)get_be32(out->data + pos + 16) << 32) |
+			get_be32(out->data + pos + 20);
+		pos += 24;
+
+		if (out->len - pos < incl_len || incl_len == 0) {
+			CHECK(0, "record data of %u bytes cut at %u of %u", incl_len, pos, out->len);
+			return;
+		}
+
+		prod = &prods[producer_of(out->data[pos], flags)];
+		while (prod->head < prod->count && !prod->pkts[prod->head]->captured)
+			prod->head++;
+
+		if (prod->head >= prod->count) {
+			CHECK(0, "record of type %u flags %u not written", out->data[pos], flags);
+			return;
+		}
+
+		pkt = prod->pkts[prod->head++];
+
+		CHECK(orig_len == pkt->orig_len && incl_len == pkt->incl_len,
+		      "record %u/%u bytes, packet %u/%u", incl_len, orig_len,
+		      pkt->incl_len, pkt->orig_len);
+		CHECK(flags == pkt->flags, "record flags %u, packet %u", flags, pkt->flags);
+		CHECK(time == (uint64_t)pkt->ms * 1000 + SNOOP_TIME_BASE,
+		      "record time %llu, packet at %u ms", (unsigned long long)time, pkt->ms);
+		CHECK(incl_len == pkt->incl_len && !memcmp(out->data + pos, pkt->data, incl_len),
+		      "record data differs from packet");
+
+		if (exact_drops) {
+			CHECK(drops == pkt->drops, "record drops %u, expected %u", drops, pkt->drops);
+		} else {
+			CHECK(drops >= pkt->drops && drops >= prod->last_drops && drops <= total_drops,
+			      "record drops %u, own %u, previous %u, total %u",
+			      drops, pkt->drops, prod->last_drops, total_drops);
+		}
+
+		prod->last_drops = drops;
+		pos += incl_len;
+	}
+
+	for (i = 0; i < PRODUCERS; i++) {
+		while (prods[i].head < prods[i].count && !prods[i].pkts[prods[i].head]->captured)
+			prods[i].head++;
+		CHECK(prods[i].head == prods[i].count, "producer %d: %u of %u packets exported",
+		      i, prods[i].head, prods[i].count);
+	}
+}
+
+/* nothing is left in the ring and all of it is zero again */
+static void check_ring_empty(void)
+{
+	uint32_t i;
+
+	CHECK(atomic_get(&snoop_rd) == atomic_get(&snoop_wr), "ring rd %d, wr %d",
+	      atomic_get(&snoop_rd), atomic_get(&snoop_wr));
+
+	for (i = 0; i < SNOOP_RING_SIZE && !snoop_ring[i]; i++)
+		;
+	CHECK(i == SNOOP_RING_SIZE, "ring byte %u not cleared", i);
+}
+
+/*
+ * Single producer tests, packets are acl packets received whose record
+ * fills the given size in the ring.
+ */
+static uint8_t acl_data[SINGLE_PACKETS][1 + 4 + 1021];
+static struct packet acl_pkts[SINGLE_PACKETS];
+static struct packet *acl_list[SINGLE_PACKETS];
+
+static struct packet *acl_packet(unsigned int n, uint32_t rec_size)
+{
+	uint32_t len = rec_size - sizeof(struct snoop_rec_hdr);
+	uint8_t *data = acl_data[n];
+	uint32_t i;
+
+	data[0] = kAclPacket;
+	data[1] = n;
+	data[2] = n >> 8;
+	data[3] = (len - 5);
+	data[4] = (len - 5) >> 8;
+	for (i = 5; i < len; i++)
+		data[i] = n * 7 + i;
+
+	packet_init(&acl_pkts[n], data, len, n, true);
+	acl_list[n] = &acl_pkts[n];
+	return &acl_pkts[n];
+}
+
+static void single_reset(struct producer *prods, struct export_buf *out)
+{
+	memset(prods, 0, sizeof(*prods) * PRODUCERS);
+	prods[0].pkts = acl_list;
+	export_reset(out);
+	btsnoop_init();
+}
+
+static void test_wrap_pad(struct export_buf *out)
+{
+	/* tail left before the wrapping record, 4 is shorter than a header */
+	static const uint32_t tails[] = { 4, 8, 12, 16, 20, 44, 60 };
+	uint32_t max_rec = ROUND_UP(sizeof(struct snoop_rec_hdr) + capture_length(1 + 4 + 1021), 4);
+	uint32_t rec, room, wr = 0, pads = 0, pad_bytes = 0;
+	struct producer prods[PRODUCERS];
+	unsigned int n = 0, t;
+
+	single_reset(prods, out);
+
+	for (t = 0; t < ARRAY_SIZE(tails); t++) {
+		/* records up to the tail, never leaving less than a record */
+		while ((room = SNOOP_RING_SIZE - (wr & SNOOP_RING_MASK)) != tails[t]) {
+			rec = room - tails[t];
+			if (rec > max_rec)
+				rec = (rec - max_rec < 24) ? rec - 24 : max_rec;
+
+			if (wr + rec - atomic_get(&snoop_rd) > SNOOP_RING_SIZE)
+				btsnoop_export(mem_export, out, false);
+			packet_write(&prods[0], acl_packet(n++, rec));
+			wr += rec;
+		}
+
+		/* the next record does not fit and wraps behind a pad */
+		rec = tails[t] < 24 ? 24 : tails[t] + 4;
+		if (wr + tails[t] + rec - atomic_get(&snoop_rd) > SNOOP_RING_SIZE)
+			btsnoop_export(mem_export, out, false);
+		packet_write(&prods[0], acl_packet(n++, rec));
+		wr += tails[t] + rec;
+		pads++;
+		pad_bytes += tails[t];
+
+		CHECK((uint32_t)atomic_get(&snoop_wr) == wr, "tail %u: wr %d, expected %u",
+		      tails[t], atomic_get(&snoop_wr), wr);
+	}
+
+	/* a record which ends right at the end of the ring needs no pad */
+	while ((room = SNOOP_RING_SIZE - (wr & SNOOP_RING_MASK)) != 40) {
+		rec = room - 40;
+		if (rec > max_rec)
+			rec = (rec - max_rec < 24) ? rec - 24 : max_rec;
+		btsnoop_export(mem_export, out, false);
+		packet_write(&prods[0], acl_packet(n++, rec));
+		wr += rec;
+	}
+	packet_write(&prods[0], acl_packet(n++, 40));
+	wr += 40;
+	CHECK((uint32_t)atomic_get(&snoop_wr) == wr, "exact fit: wr %d, expected %u",
+	      atomic_get(&snoop_wr), wr);
+
+	btsnoop_export(mem_export, out, false);
+	prods[0].count = n;
+
+	printf("wrap: %u records in %u bytes, %u pads of %u bytes\n", n, wr, pads, pad_bytes);
+
+	CHECK(atomic_get(&snoop_drops) == 0, "%d drops", atomic_get(&snoop_drops));
+	CHECK(atomic_get(&snoop_records) == n && snoop_exported == n,
+	      "%u written, %d captured, %u exported", n, atomic_get(&snoop_records), snoop_exported);
+	check_export(out, false, prods, true);
+	check_ring_empty();
+}
+
+static void test_drops(struct export_buf *out)
+{
+	uint32_t max_rec = ROUND_UP(sizeof(struct snoop_rec_hdr) + capture_length(1 + 4 + 1021), 4);
+	struct producer prods[PRODUCERS];
+	unsigned int n = 0, kept, i;
+	uint32_t len;
+
+	single_reset(prods, out);
+
+	/* fill the ring until a packet is dropped, then drop 3 more */
+	while (packet_write(&prods[0], acl_packet(n++, max_rec)))
+		;
+	kept = n - 1;
+	for (i = 0; i < 3; i++)
+		CHECK(!packet_write(&prods[0], acl_packet(n++, max_rec)), "packet %u fits", n - 1);
+
+	CHECK(kept == SNOOP_RING_SIZE / max_rec, "%u records of %u bytes kept", kept, max_rec);
+	CHECK(atomic_get(&snoop_drops) == 4, "%d drops", atomic_get(&snoop_drops));
+
+	len = btsnoop_export(mem_export, out, true);
+	CHECK(len == out->len, "export returned %u, wrote %u", len, out->len);
+
+	/* the next packet fits again and carries the drops */
+	acl_packet(n, 64);
+	CHECK(packet_write(&prods[0], &acl_pkts[n]) && acl_pkts[n].drops == 4,
+	      "packet after the drops: captured %u, drops %u",
+	      acl_pkts[n].captured, acl_pkts[n].drops);
+	n++;
+	btsnoop_export(mem_export, out, false);
+	prods[0].count = n;
+
+	printf("drops: %u records kept, %d dropped\n", kept, atomic_get(&snoop_drops));
+
+	CHECK(atomic_get(&snoop_records) == kept + 1 && snoop_exported == kept + 1,
+	      "%d captured, %u exported", atomic_get(&snoop_records), snoop_exported);
+	check_export(out, true, prods, true);
+	check_ring_empty();
+}
+
+static void test_truncate(struct export_buf *out)
+{
+	/* longest packet of each type, H4 header with its length field */
+	static const uint8_t heads[][5] = {
+		{ kCommandPacket, 0x13, 0x0c, 248 },
+		{ kAclPacket, 0x80, 0x20, 1021 & 0xff, 1021 >> 8 },
+		{ kScoPacket, 0x01, 0x01, 255 },
+		{ kEventPacket, 0x0e, 255 },
+	};
+	static uint8_t data[ARRAY_SIZE(heads)][1 + 4 + 1021];
+	static struct packet pkts[ARRAY_SIZE(heads)];
+	static struct packet *lists[PRODUCERS][1];
+	struct producer prods[PRODUCERS], *prod;
+	uint32_t len, truncated = 0, i, j;
+
+	memset(prods, 0, sizeof(prods));
+	export_reset(out);
+	btsnoop_init();
+
+	for (i = 0; i < ARRAY_SIZE(heads); i++) {
+		memcpy(data[i], heads[i], sizeof(heads[i]));
+		len = packet_length(data[i], sizeof(data[i]));
+		for (j = 5; j < len; j++)
+			data[i][j] = i * 31 + j;
+
+		/* the sco packet is sent, so that each goes to its own producer */
+		packet_init(&pkts[i], data[i], len, i, data[i][0] != kScoPacket);
+		if (pkts[i].incl_len < len)
+			truncated++;
+
+		prod = &prods[producer_of(data[i][0], pkts[i].flags)];
+		prod->pkts = lists[prod - prods];
+		prod->pkts[prod->count++] = &pkts[i];
+		packet_write(prod, &pkts[i]);
+	}
+
+	btsnoop_export(mem_export, out, true);
+
+	printf("truncate: capture length %u, record data up to %u, %d of %u packets truncated\n",
+	       CONFIG_BT_SNOOP_CAP_LEN, (uint32_t)SNOOP_REC_MAX_DATA,
+	       atomic_get(&snoop_truncated), (uint32_t)ARRAY_SIZE(heads));
+
+	CHECK(atomic_get(&snoop_truncated) == truncated, "%d truncated, expected %u",
+	      atomic_get(&snoop_truncated), truncated);
+	CHECK(truncated > 0, "no packet truncated");
+	check_export(out, true, prods, true);
+	check_ring_empty();
+}
+
+/* concurrent replay */
+static struct packet cap_pkts[MAX_PACKETS];
+static struct packet *cap_lists[PRODUCERS][MAX_PACKETS];
+static struct producer cap_prods[PRODUCERS];
+static volatile int replay_done;
+/* replay time divided by, 0 to write the packets without pause */
+static unsigned int replay_speedup;
+static uint64_t replay_start_us;
+
+static void *producer_thread(void *arg)
+{
+	struct producer *prod = arg;
+	uint64_t due_us, now;
+	unsigned int i;
+
+	for (i = 0; i < prod->count; i++) {
+		if (replay_speedup) {
+			due_us = replay_start_us + prod->pkts[i]->ms * 1000ull / replay_speedup;
+			now = now_us();
+			if (due_us > now)
+				usleep(due_us - now);
+		}
+
+		packet_write(prod, prod->pkts[i]);
+	}
+
+	return NULL;
+}
+
+static void *exporter_thread(void *arg)
+{
+	struct export_buf *out = arg;
+	bool with_head = true;
+	int ret;
+
+	while (!__atomic_load_n(&replay_done, __ATOMIC_ACQUIRE)) {
+		ret = btsnoop_export(mem_export, out, with_head);
+		CHECK(ret >= 0, "export failed %d", ret);
+		with_head = false;
+
+		/* paced, the ring is drained each ms as by the snoop work queue */
+		if (replay_speedup)
+			usleep(1000);
+		else
+			sched_yield();
+	}
+
+	/* whatever the producers wrote before they ended */
+	ret = btsnoop_export(mem_export, out, with_head);
+	CHECK(ret >= 0, "export failed %d", ret);
+
+	return NULL;
+}
+
+static uint8_t *load_file(const char *path, uint32_t *size)
+{
+	uint8_t *data;
+	FILE *fp;
+	long len;
+
+	fp = fopen(path, "rb");
+	if (!fp)
+		return NULL;
+
+	fseek(fp, 0, SEEK_END);
+	len = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	data = malloc(len > 0 ? len : 1);
+	if (data && fread(data, 1, len, fp) != (size_t)len) {
+		free(data);
+		data = NULL;
+	}
+
+	fclose(fp);
+	*size = len;
+	return data;
+}
+
+/* parse the capture into the packets of the producers, returns the count */
+static unsigned int parse_capture(const uint8_t *cap, uint32_t size)
+{
+	uint32_t pos = SNOOP_HEAD_LEN, orig_len, incl_len, flags;
+	uint64_t time, first = 0;
+	unsigned int n = 0, skipped = 0;
+	struct producer *prod;
+	struct packet *pkt;
+
+	memset(cap_prods, 0, sizeof(cap_prods));
+
+	while (pos + 24 <= size && n < MAX_PACKETS) {
+		orig_len = get_be32(cap + pos);
+		incl_len = get_be32(cap + pos + 4);
+		flags = get_be32(cap + pos + 8);
+		time = ((uint64_t)get_be32(cap + pos + 16) << 32) | get_be32(cap + pos + 20);
+		pos += 24;
+
+		if (incl_len > size - pos)
+			break;
+
+		/* only whole H4 packets can be written again */
+		if (incl_len != orig_len || incl_len == 0 ||
+		    packet_length(cap + pos, incl_len) != incl_len) {
+			skipped++;
+			pos += incl_len;
+			continue;
+		}
+
+		if (!n)
+			first = time;
+
+		pkt = &cap_pkts[n++];
+		packet_init(pkt, cap + pos, incl_len, (uint32_t)((time - first) / 1000), flags & 1);
+
+		prod = &cap_prods[producer_of(cap[pos], flags)];
+		prod->pkts = cap_lists[prod - cap_prods];
+		prod->pkts[prod->count++] = pkt;
+
+		pos += incl_len;
+	}
+
+	if (skipped)
+		printf("%u records of the capture skipped\n", skipped);
+
+	return n;
+}
+
+static void replay(const char *path, const uint8_t *cap, uint32_t size,
+		   struct export_buf *out, unsigned int speedup)
+{
+	uint32_t truncated = 0, drops = 0, captured = 0;
+	uint64_t elapsed_us;
+	pthread_t exporter;
+	unsigned int n, i;
+
+	n = parse_capture(cap, size);
+	CHECK(n > 0, "%s: no packets", path);
+
+	export_reset(out);
+	btsnoop_init();
+	replay_done = 0;
+	replay_speedup = speedup;
+
+	replay_start_us = now_us();
+	pthread_create(&exporter, NULL, exporter_thread, out);
+	for (i = 0; i < PRODUCERS; i++)
+		pthread_create(&cap_prods[i].thread, NULL, producer_thread, &cap_prods[i]);
+	for (i = 0; i < PRODUCERS; i++)
+		pthread_join(cap_prods[i].thread, NULL);
+	__atomic_store_n(&replay_done, 1, __ATOMIC_RELEASE);
+	pthread_join(exporter, NULL);
+	elapsed_us = now_us() - replay_start_us;
+
+	for (i = 0; i < n; i++) {
+		if (cap_pkts[i].incl_len < cap_pkts[i].orig_len)
+			truncated++;
+		captured += cap_pkts[i].captured;
+	}
+	for (i = 0; i < PRODUCERS; i++)
+		drops += cap_prods[i].drops;
+
+	if (speedup)
+		printf("%s at %ux: ", path, speedup);
+	else
+		printf("%s without pause: ", path);
+	printf("%u packets, %u captured, %u dropped, %u truncated, %u ring wraps, "
+	       "%u bytes exported in %llu ms\n",
+	       n, captured, drops, truncated,
+	       (uint32_t)atomic_get(&snoop_wr) / SNOOP_RING_SIZE, out->len,
+	       (unsigned long long)(elapsed_us / 1000));
+
+	CHECK(captured + drops == n, "%u captured and %u dropped of %u", captured, drops, n);
+	CHECK(atomic_get(&snoop_records) == captured && snoop_exported == captured,
+	      "%d recorded, %u exported, %u captured",
+	      atomic_get(&snoop_records), snoop_exported, captured);
+	CHECK(atomic_get(&snoop_drops) == drops, "%d drops counted, producers saw %u",
+	      atomic_get(&snoop_drops), drops);
+	CHECK(atomic_get(&snoop_truncated) == truncated, "%d truncated, expected %u",
+	      atomic_get(&snoop_truncated), truncated);
+
+	check_export(out, true, cap_prods, false);
+	check_ring_empty();
+}
+
+int main(int argc, char *argv[])
+{
+	struct export_buf out;
+	uint8_t pkt[4] = { 0x03, 0x0c, 0x00 };
+	uint32_t size;
+	uint8_t *cap;
+	int i;
+
+	out.size = 64 * 1024 * 1024;
+	out.data = malloc(out.size);
+	out.len = 0;
+
+	printf("ring %u bytes, capture length %u\n", SNOOP_RING_SIZE, CONFIG_BT_SNOOP_CAP_LEN);
+
+	/* nothing is captured before init */
+	CHECK(btsnoop_write_packet(kCommandPacket, pkt, false) == 0, "written before init");
+	CHECK(btsnoop_export(mem_export, &out, true) == -ENODEV, "exported before init");
+	CHECK(atomic_get(&snoop_drops) == 0, "drop counted before init");
+
+	test_wrap_pad(&out);
+	test_drops(&out);
+	test_truncate(&out);
+
+	for (i = 1; i < argc; i++) {
+		cap = load_file(argv[i], &size);
+		if (!cap || size < SNOOP_HEAD_LEN || memcmp(cap, SNOOP_HEAD, SNOOP_HEAD_LEN)) {
+			CHECK(0, "%s: not a H4 btsnoop capture", argv[i]);
+			free(cap);
+			continue;
+		}
+
+		replay(argv[i], cap, size, &out, REPLAY_SPEEDUP);
+		replay(argv[i], cap, size, &out, 0);
+		free(cap);
+	}
+
+	free(out.data);
+
+	if (failures) {
+		printf("btsnoop: %d failures\n", failures);
+		return 1;
+	}
+
+	printf("btsnoop: OK\n");
+	return 0;
+}
@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief generate btsnoop captures of an earphone session for btsnoop_test
+ *
+ * Writes a btsnoop file (H4, datalink 1002) of one session to stdout, as
+ * the HCI of the earphone sees it. The phone connects, the controller is
+ * set up by commands with their complete or status events, and the
+ * profile signalling runs over small acl packets which are answered by
+ * number of completed packets events.
+ *
+ * a2dp: 15 s of sbc media, a 612 byte acl every 20.3 ms, then 15 s of
+ *       aac media in 1200 byte l2cap frames split into a 1021 byte 3-DH5
+ *       start and a continuation fragment, with avrcp volume changes.
+ * call: hfp at commands, then an msbc sco link with a 60 byte packet each
+ *       way every 7.5 ms for 20 s, then the call is hung up.
+ *
+ * Payloads are pseudo random, times have radio jitter of a few 100 us.
+ *
+ * Usage: gen_capture a2dp|call
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define SNOOP_HEAD		"btsnoop\0\0\0\0\1\0\0\x3\xea"
+#define SNOOP_HEAD_LEN		16
+/* 2023-01-01 in us since 0 AD */
+#define START_TIME		(0x00E03AB44A676000ULL + 725846400ULL * 1000000)
+
+#define ACL_HANDLE		0x0080
+#define SCO_HANDLE		0x0101
+#define PB_START		0x2000
+#define PB_CONT			0x1000
+
+static unsigned int rand_state;
+static uint64_t now_us;
+
+static unsigned int cap_rand(unsigned int range)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+	return ((rand_state >> 8) & 0xffffff) % range;
+}
+
+static void put_be32(uint32_t val)
+{
+	putchar(val >> 24);
+	putchar(val >> 16);
+	putchar(val >> 8);
+	putchar(val);
+}
+
+/* one btsnoop record, data starts with the H4 packet type */
+static void put_record(uint32_t flags, const uint8_t *data, uint32_t len)
+{
+	uint64_t time = START_TIME + now_us;
+
+	put_be32(len);
+	put_be32(len);
+	put_be32(flags);
+	put_be32(0);
+	put_be32(time >> 32);
+	put_be32(time);
+	fwrite(data, 1, len, stdout);
+}
+
+static void fill(uint8_t *data, uint32_t len)
+{
+	while (len--)
+		*data++ = cap_rand(256);
+}
+
+static void advance(unsigned int min_us, unsigned int jitter_us)
+{
+	now_us += min_us + cap_rand(jitter_us + 1);
+}
+
+static void command(uint16_t opcode, uint8_t plen)
+{
+	uint8_t pkt[4 + 255];
+
+	pkt[0] = 1;
+	pkt[1] = opcode;
+	pkt[2] = opcode >> 8;
+	pkt[3] = plen;
+	fill(&pkt[4], plen);
+	put_record(2, pkt, 4 + plen);
+}
+
+static void event(uint8_t code, uint8_t plen)
+{
+	uint8_t pkt[3 + 255];
+
+	pkt[0] = 4;
+	pkt[1] = code;
+	pkt[2] = plen;
+	fill(&pkt[3], plen);
+	put_record(3, pkt, 3 + plen);
+}
+
+static void acl(uint16_t handle, uint16_t len, int rx)
+{
+	uint8_t pkt[5 + 1021];
+
+	pkt[0] = 2;
+	pkt[1] = handle;
+	pkt[2] = handle >> 8;
+	pkt[3] = len;
+	pkt[4] = len >> 8;
+	fill(&pkt[5], len);
+	put_record(rx, pkt, 5 + len);
+}
+
+static void sco(uint16_t handle, uint8_t len, int rx)
+{
+	uint8_t pkt[4 + 255];
+
+	pkt[0] = 3;
+	pkt[1] = handle;
+	pkt[2] = handle >> 8;
+	pkt[3] = len;
+	fill(&pkt[4], len);
+	put_record(rx, pkt, 4 + len);
+}
+
+/* command answered by command complete, or command status */
+static void command_complete(uint16_t opcode, uint8_t plen, uint8_t ret_len)
+{
+	command(opcode, plen);
+	advance(300, 400);
+	event(ret_len ? 0x0e : 0x0f, ret_len ? 3 + ret_len : 4);
+	advance(200, 200);
+}
+
+/* acl sent by the host and its number of completed packets event */
+static void acl_out(uint16_t len)
+{
+	acl(ACL_HANDLE | PB_START, len, 0);
+	advance(1000, 3000);
+	event(0x13, 5);
+}
+
+/* signalling request of the phone and the answer of the earphone */
+static void signalling(unsigned int count)
+{
+	while (count--) {
+		acl(ACL_HANDLE | PB_START, 8 + cap_rand(40), 1);
+		advance(500, 1500);
+		acl_out(8 + cap_rand(40));
+		advance(2000, 10000);
+	}
+}
+
+static void setup(void)
+{
+	command_complete(0x0c03, 0, 1);		/* reset */
+	command_complete(0x1001, 0, 9);		/* read local version */
+	command_complete(0x1009, 0, 7);		/* read bd addr */
+	command_complete(0x0c13, 248, 1);	/* write local name */
+	command_complete(0x0c24, 3, 1);		/* write class of device */
+	command_complete(0x0c52, 241, 1);	/* write extended inquiry response */
+	command_complete(0x0c1a, 1, 1);		/* write scan enable */
+	advance(800000, 400000);
+
+	event(0x04, 10);			/* connection request */
+	advance(300, 300);
+	command_complete(0x0409, 7, 0);		/* accept connection request */
+	advance(20000, 10000);
+	event(0x03, 11);			/* connection complete */
+	advance(500, 500);
+	command_complete(0x041b, 2, 0);		/* read remote features */
+	event(0x0b, 11);
+	advance(2000, 2000);
+	event(0x17, 6);				/* link key request */
+	command_complete(0x040b, 22, 7);	/* link key reply */
+	event(0x08, 4);				/* encryption change */
+	advance(5000, 5000);
+}
+
+static void a2dp(void)
+{
+	unsigned int i;
+
+	/* avdtp discover, capabilities, configuration, open, start */
+	signalling(6);
+
+	for (i = 0; i < 1500; i++) {
+		now_us = (now_us / 1000) * 1000;
+		advance(20000, 600);
+
+		if (i < 740) {
+			acl(ACL_HANDLE | PB_START, 612, 1);
+		} else {
+			acl(ACL_HANDLE | PB_START, 1021, 1);
+			advance(1875, 0);
+			acl(ACL_HANDLE | PB_CONT, 1200 + 4 - 1021, 1);
+		}
+
+		if ((i % 100) == 50) {
+			/* avrcp volume change and its response */
+			advance(3000, 3000);
+			acl_out(18);
+			advance(8000, 20000);
+			acl(ACL_HANDLE | PB_START, 18, 1);
+		}
+	}
+
+	/* avdtp suspend, close */
+	signalling(2);
+}
+
+static void call(void)
+{
+	uint64_t start;
+	unsigned int i;
+
+	/* rfcomm and hfp service level connection */
+	signalling(12);
+
+	command_complete(0x0428, 17, 0);	/* setup synchronous connection */
+	advance(30000, 10000);
+	event(0x2c, 17);			/* synchronous connection complete */
+
+	start = now_us;
+	for (i = 0; i < 20000000 / 7500; i++) {
+		now_us = start + i * 7500ULL;
+		advance(0, 400);
+		sco(SCO_HANDLE, 60, 1);
+		advance(300, 300);
+		sco(SCO_HANDLE, 60, 0);
+
+		if ((i % 400) == 200) {
+			/* call status indications */
+			advance(500, 1000);
+			acl(ACL_HANDLE | PB_START, 30, 1);
+			advance(300, 300);
+			acl_out(14);
+		}
+	}
+
+	command_complete(0x0406, 3, 0);		/* disconnect sco */
+	advance(20000, 10000);
+	event(0x05, 4);
+	signalling(3);
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2 || (strcmp(argv[1], "a2dp") && strcmp(argv[1], "call"))) {
+		fprintf(stderr, "usage: gen_capture a2dp|call\n");
+		return 1;
+	}
+
+	rand_state = argv[1][0];
+	now_us = 0;
+
+	fwrite(SNOOP_HEAD, 1, SNOOP_HEAD_LEN, stdout);
+
+	setup();
+	if (!strcmp(argv[1], "a2dp"))
+		a2dp();
+	else
+		call();
+
+	command_complete(0x0406, 3, 0);		/* disconnect */
+	advance(30000, 20000);
+	event(0x05, 4);
+
+	return 0;
+}
@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * host stub of the logging API, silent unless built with -DHOST_LOG.
+ * stdio.h is not included here, btsnoop.c declares printf itself.
+ */
+
+#ifndef __HOST_LOGGING_LOG_H__
+#define __HOST_LOGGING_LOG_H__
+
+#define LOG_MODULE_DECLARE(...)
+
+#ifdef HOST_LOG
+#define LOG_INF(fmt, ...)	printf("I: " fmt "\n", ##__VA_ARGS__)
+#define LOG_ERR(fmt, ...)	printf("E: " fmt "\n", ##__VA_ARGS__)
+#else
+#define LOG_INF(...)
+#define LOG_ERR(...)
+#endif
+
+#endif /* __HOST_LOGGING_LOG_H__ */
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * host stub of the atomic API on the compiler builtins, atomic_t is 32 bit
+ * as on the target so that the ring positions wrap the same way
+ */
+
+#ifndef __HOST_SYS_ATOMIC_H__
+#define __HOST_SYS_ATOMIC_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef int32_t atomic_t;
+typedef atomic_t atomic_val_t;
+
+static inline atomic_val_t atomic_get(const atomic_t *target)
+{
+	return __atomic_load_n(target, __ATOMIC_SEQ_CST);
+}
+
+static inline atomic_val_t atomic_set(atomic_t *target, atomic_val_t value)
+{
+	return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+}
+
+static inline atomic_val_t atomic_add(atomic_t *target, atomic_val_t value)
+{
+	return __atomic_fetch_add(target, value, __ATOMIC_SEQ_CST);
+}
+
+static inline atomic_val_t atomic_inc(atomic_t *target)
+{
+	return atomic_add(target, 1);
+}
+
+static inline bool atomic_cas(atomic_t *target, atomic_val_t old_value, atomic_val_t new_value)
+{
+	return __atomic_compare_exchange_n(target, &old_value, new_value, false,
+					   __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+#endif /* __HOST_SYS_ATOMIC_H__ */
@@ -0,0 +1,12 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of printk, btsnoop prints through printf only */
+
+#ifndef __HOST_SYS_PRINTK_H__
+#define __HOST_SYS_PRINTK_H__
+
+#endif /* __HOST_SYS_PRINTK_H__ */
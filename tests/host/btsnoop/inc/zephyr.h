@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * host stub of the kernel API used by btsnoop, the mutex is a pthread
+ * mutex and the uptime is the time of the packet being replayed
+ */
+
+#ifndef __HOST_ZEPHYR_H__
+#define __HOST_ZEPHYR_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <errno.h>
+#include <pthread.h>
+
+#define __aligned(x)		__attribute__((__aligned__(x)))
+#define BUILD_ASSERT(cond, msg)	_Static_assert(cond, msg)
+#define ROUND_UP(x, align)	((((unsigned long)(x) + ((unsigned long)(align) - 1)) / \
+				 (unsigned long)(align)) * (unsigned long)(align))
+
+#define K_FOREVER		(-1)
+#define K_MSEC(ms)		(ms)
+
+struct k_mutex {
+	pthread_mutex_t mutex;
+};
+
+#define K_MUTEX_DEFINE(name)	struct k_mutex name = { PTHREAD_MUTEX_INITIALIZER }
+
+static inline int k_mutex_lock(struct k_mutex *mutex, int timeout)
+{
+	return pthread_mutex_lock(&mutex->mutex);
+}
+
+static inline int k_mutex_unlock(struct k_mutex *mutex)
+{
+	return pthread_mutex_unlock(&mutex->mutex);
+}
+
+static inline void k_sleep(int ms)
+{
+}
+
+/* provided by the test */
+uint32_t k_uptime_get_32(void);
+
+#endif /* __HOST_ZEPHYR_H__ */
@@ -0,0 +1,669 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief test, stress test and fan-out benchmark of the clone stream views
+ *
+ * The real stream and clone stream sources write to a sink origin stream.
+ * The single threaded cases check what the views claim against the bytes
+ * written: wrap of the shared buffer, the drop and stop lag policies, the
+ * statistics, -EPIPE on release of overwritten data, and the legacy
+ * clones[] copy which must still get every byte.
+ *
+ * The stress run writes a word sequence from a producer thread while four
+ * consumer threads claim, copy out and release it, one of them sleeping on
+ * each claim so that it lags. Data of a successful release must be a run
+ * of the sequence, and each drop policy view must account for every byte
+ * written as either released or dropped.
+ *
+ * The benchmark reports the producer cost per KB of the views against a
+ * copy into a ring stream per consumer through clones[], for 1 to 4
+ * consumers and 512 and 2048 bytes writes.
+ *
+ * Usage: clone_stream_test [benchmark MB per run, default 4]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <os_common_api.h>
+#include <stream.h>
+#include <clone_stream.h>
+
+#define VIEW_BUF_SIZE		1024
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) \
+	do { \
+		if (!(cond)) { \
+			if (failures++ < 20) \
+				printf("FAIL %s:%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__); \
+		} \
+	} while (0)
+
+/* OS and memory stubs */
+static pthread_mutex_t irq_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+unsigned int os_irq_lock(void)
+{
+	pthread_mutex_lock(&irq_mutex);
+	return 0;
+}
+
+void os_irq_unlock(unsigned int key)
+{
+	pthread_mutex_unlock(&irq_mutex);
+}
+
+void os_sem_init(os_sem *sem, int count, int limit)
+{
+	pthread_mutex_init(&sem->mutex, NULL);
+	pthread_cond_init(&sem->cond, NULL);
+	sem->count = count;
+	sem->limit = limit;
+}
+
+int os_sem_take(os_sem *sem, int timeout)
+{
+	struct timespec ts;
+	int res = 0;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	if (timeout > 0) {
+		ts.tv_sec += timeout / 1000;
+		ts.tv_nsec += (timeout % 1000) * 1000000L;
+		if (ts.tv_nsec >= 1000000000L) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000L;
+		}
+	}
+
+	pthread_mutex_lock(&sem->mutex);
+	while (sem->count == 0 && !res) {
+		if (timeout == OS_FOREVER)
+			pthread_cond_wait(&sem->cond, &sem->mutex);
+		else if (timeout == OS_NO_WAIT || pthread_cond_timedwait(&sem->cond, &sem->mutex, &ts))
+			res = -EAGAIN;
+	}
+	if (!res)
+		sem->count--;
+	pthread_mutex_unlock(&sem->mutex);
+
+	return res;
+}
+
+void os_sem_give(os_sem *sem)
+{
+	pthread_mutex_lock(&sem->mutex);
+	if (sem->count < sem->limit)
+		sem->count++;
+	pthread_cond_signal(&sem->cond);
+	pthread_mutex_unlock(&sem->mutex);
+}
+
+void os_sem_reset(os_sem *sem)
+{
+	pthread_mutex_lock(&sem->mutex);
+	sem->count = 0;
+	pthread_mutex_unlock(&sem->mutex);
+}
+
+uint32_t os_uptime_get_32(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void *mem_malloc(int size)
+{
+	return calloc(1, size);
+}
+
+void mem_free(void *ptr)
+{
+	free(ptr);
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* origin stream, the data only goes to the clones and views */
+static int sink_open(io_stream_t handle, stream_mode mode)
+{
+	return 0;
+}
+
+static int sink_write(io_stream_t handle, unsigned char *buf, int num)
+{
+	return num;
+}
+
+static int sink_close(io_stream_t handle)
+{
+	return 0;
+}
+
+static const stream_ops_t sink_ops = {
+	.open = sink_open,
+	.read = NULL,
+	.write = sink_write,
+	.close = sink_close,
+};
+
+/* consumer of the legacy clones[] path, never blocks the producer */
+#define RING_SIZE	(64 * 1024)
+
+struct ring {
+	uint8_t buf[RING_SIZE];
+	volatile uint32_t wofs;
+	volatile uint32_t rofs;
+	uint32_t dropped;
+};
+
+static int ring_init(io_stream_t handle, void *param)
+{
+	handle->data = param;
+	return 0;
+}
+
+static int ring_write(io_stream_t handle, unsigned char *buf, int num)
+{
+	struct ring *ring = handle->data;
+	uint32_t space = RING_SIZE - (ring->wofs - __atomic_load_n(&ring->rofs, __ATOMIC_ACQUIRE));
+	uint32_t idx = ring->wofs % RING_SIZE, n;
+
+	if (!buf || num <= 0)
+		return 0;
+
+	if (num > space) {
+		ring->dropped += num;
+		return num;
+	}
+
+	n = MIN(num, RING_SIZE - idx);
+	memcpy(ring->buf + idx, buf, n);
+	memcpy(ring->buf, buf + n, num - n);
+	__atomic_store_n(&ring->wofs, ring->wofs + num, __ATOMIC_RELEASE);
+	return num;
+}
+
+static const stream_ops_t ring_ops = {
+	.init = ring_init,
+	.open = sink_open,
+	.write = ring_write,
+	.close = sink_close,
+};
+
+static io_stream_t create_clone_stream(int view_buf_size, io_stream_t clone)
+{
+	struct clone_stream_info info;
+	io_stream_t handle;
+
+	memset(&info, 0, sizeof(info));
+	info.origin = stream_create(&sink_ops, NULL);
+	info.clone_mode = MODE_OUT;
+	info.clones[0] = clone;
+	info.view_buf_size = view_buf_size;
+
+	handle = clone_stream_create(&info);
+	if (handle)
+		stream_open(handle, MODE_OUT);
+	return handle;
+}
+
+static void destroy_clone_stream(io_stream_t handle)
+{
+	stream_close(handle);
+	stream_destroy(handle);
+}
+
+/* byte of the test data at an offset of the stream */
+static uint8_t seq_byte(uint32_t ofs)
+{
+	return (uint8_t)(ofs ^ (ofs >> 8) ^ 0x5a);
+}
+
+static uint32_t written;
+
+static void write_seq(io_stream_t handle, int len)
+{
+	uint8_t buf[2048];
+	int i, n;
+
+	while (len > 0) {
+		n = MIN(len, (int)sizeof(buf));
+		for (i = 0; i < n; i++)
+			buf[i] = seq_byte(written + i);
+		CHECK(stream_write(handle, buf, n) == n, "write %d", n);
+		written += n;
+		len -= n;
+	}
+}
+
+/* claimed bytes must be the sequence from ofs */
+static int check_seq(struct acts_ringbuf_iovec iov[2], int len, uint32_t ofs)
+{
+	int i, bad = 0;
+
+	CHECK(iov[0].len + iov[1].len == len, "iov %u + %u of %d", iov[0].len, iov[1].len, len);
+	for (i = 0; i < iov[0].len; i++)
+		bad += ((uint8_t *)iov[0].base)[i] != seq_byte(ofs + i);
+	for (i = 0; i < iov[1].len; i++)
+		bad += ((uint8_t *)iov[1].base)[i] != seq_byte(ofs + iov[0].len + i);
+	return bad;
+}
+
+static void test_claim_release(void)
+{
+	struct ring *ring = calloc(1, sizeof(*ring));
+	io_stream_t clone = stream_create(&ring_ops, ring);
+	struct acts_ringbuf_iovec iov[2];
+	io_stream_t handle;
+	int view, len, i, bad = 0;
+
+	stream_open(clone, MODE_OUT);
+	handle = create_clone_stream(VIEW_BUF_SIZE, clone);
+	written = 0;
+
+	view = clone_stream_view_open(handle, 0, CLONE_STREAM_LAG_DROP);
+	CHECK(view >= 0, "view open %d", view);
+
+	write_seq(handle, 300);
+	len = clone_stream_view_claim(handle, view, iov, 100);
+	CHECK(len == 100 && !check_seq(iov, len, 0), "claim %d", len);
+	CHECK(clone_stream_view_release(handle, view, 100) == 0, "release");
+
+	/* release less than claimed, the rest is claimed again */
+	len = clone_stream_view_claim(handle, view, iov, VIEW_BUF_SIZE);
+	CHECK(len == 200 && !check_seq(iov, len, 100), "claim %d", len);
+	CHECK(clone_stream_view_release(handle, view, 201) == -EINVAL, "release more than claimed");
+	len = clone_stream_view_claim(handle, view, iov, VIEW_BUF_SIZE);
+	CHECK(len == 200, "claim %d", len);
+	CHECK(clone_stream_view_release(handle, view, 150) == 0, "release");
+
+	/* wrap of the shared buffer */
+	write_seq(handle, 900);
+	len = clone_stream_view_claim(handle, view, iov, VIEW_BUF_SIZE);
+	CHECK(len == 950 && iov[1].len == 176 && !check_seq(iov, len, 250),
+	      "claim %d, second segment %u", len, iov[1].len);
+	CHECK(clone_stream_view_release(handle, view, len) == 0, "release");
+	len = clone_stream_view_claim(handle, view, iov, VIEW_BUF_SIZE);
+	CHECK(len == 0, "claim %d of nothing", len);
+	clone_stream_view_release(handle, view, 0);
+
+	/* the clones[] copy is unchanged */
+	for (i = 0; i < written; i++)
+		bad += ring->buf[i] != seq_byte(i);
+	CHECK(ring->wofs == written && !bad, "clone got %u bytes, %d bad", ring->wofs, bad);
+
+	destroy_clone_stream(handle);
+	stream_close(clone);
+	stream_destroy(clone);
+	free(ring);
+}
+
+static void test_drop(void)
+{
+	struct clone_stream_view_stat stat;
+	struct acts_ringbuf_iovec iov[2];
+	io_stream_t handle = create_clone_stream(VIEW_BUF_SIZE, NULL);
+	int view, len, i;
+
+	written = 0;
+	view = clone_stream_view_open(handle, 512, CLONE_STREAM_LAG_DROP);
+
+	for (i = 0; i < 8; i++)
+		write_seq(handle, 100);
+
+	clone_stream_view_get_stat(handle, view, &stat);
+	CHECK(stat.lag == 512 && stat.max_lag == 512 && stat.dropped == 288 && stat.stopped == 0,
+	      "lag %u max %u dropped %u stopped %u", stat.lag, stat.max_lag, stat.dropped, stat.stopped);
+
+	/* the oldest are dropped, the latest max_lag bytes are kept */
+	len = clone_stream_view_claim(handle, view, iov, VIEW_BUF_SIZE);
+	CHECK(len == 512 && !check_seq(iov, len, 288), "claim %d", len);
+	CHECK(clone_stream_view_release(handle, view, len) == 0, "release");
+
+	destroy_clone_stream(handle);
+}
+
+static void test_stop(void)
+{
+	struct clone_stream_view_stat stat;
+	struct acts_ringbuf_iovec iov[2];
+	io_stream_t handle = create_clone_stream(VIEW_BUF_SIZE, NULL);
+	int view, len;
+
+	written = 0;
+	view = clone_stream_view_open(handle, 256, CLONE_STREAM_LAG_STOP);
+
+	write_seq(handle, 200);
+	write_seq(handle, 100);
+
+	len = clone_stream_view_claim(handle, view, iov, VIEW_BUF_SIZE);
+	CHECK(len == -EPIPE, "claim %d of a stopped view", len);
+	clone_stream_view_get_stat(handle, view, &stat);
+	CHECK(stat.lag == 0 && stat.max_lag == 200 && stat.dropped == 0 && stat.stopped == 1,
+	      "lag %u max %u dropped %u stopped %u", stat.lag, stat.max_lag, stat.dropped, stat.stopped);
+
+	/* no silent gap: nothing is read until the reset, then the latest */
+	write_seq(handle, 50);
+	CHECK(clone_stream_view_claim(handle, view, iov, VIEW_BUF_SIZE) == -EPIPE, "still stopped");
+	CHECK(clone_stream_view_reset(handle, view) == 0, "reset");
+	write_seq(handle, 50);
+	len = clone_stream_view_claim(handle, view, iov, VIEW_BUF_SIZE);
+	CHECK(len == 50 && !check_seq(iov, len, 350), "claim %d", len);
+	CHECK(clone_stream_view_release(handle, view, len) == 0, "release");
+
+	/* stopped while the claimed data is read */
+	write_seq(handle, 100);
+	len = clone_stream_view_claim(handle, view, iov, VIEW_BUF_SIZE);
+	write_seq(handle, 200);
+	CHECK(clone_stream_view_release(handle, view, len) == -EPIPE, "release of a stopped view");
+
+	destroy_clone_stream(handle);
+}
+
+static void test_overwrite(void)
+{
+	struct acts_ringbuf_iovec iov[2];
+	io_stream_t handle = create_clone_stream(VIEW_BUF_SIZE, NULL);
+	int view, len;
+
+	written = 0;
+	view = clone_stream_view_open(handle, 0, CLONE_STREAM_LAG_DROP);
+
+	/* the whole buffer may be written while the claim is read */
+	write_seq(handle, 512);
+	len = clone_stream_view_claim(handle, view, iov, VIEW_BUF_SIZE);
+	write_seq(handle, 512);
+	CHECK(!check_seq(iov, len, 0), "claimed data changed");
+	CHECK(clone_stream_view_release(handle, view, len) == 0, "release");
+
+	/* but not more, the overwrite is reported by the release */
+	len = clone_stream_view_claim(handle, view, iov, 256);
+	CHECK(len == 256, "claim %d", len);
+	write_seq(handle, 600);
+	CHECK(check_seq(iov, len, 512) > 0, "claimed data not overwritten");
+	CHECK(clone_stream_view_release(handle, view, len) == -EPIPE, "release of overwritten data");
+
+	/* the view goes on with the latest data */
+	len = clone_stream_view_claim(handle, view, iov, VIEW_BUF_SIZE);
+	CHECK(len == VIEW_BUF_SIZE && !check_seq(iov, len, written - VIEW_BUF_SIZE), "claim %d", len);
+	CHECK(clone_stream_view_release(handle, view, len) == 0, "release");
+
+	destroy_clone_stream(handle);
+}
+
+static void test_open_close(void)
+{
+	struct acts_ringbuf_iovec iov[2];
+	io_stream_t handle = create_clone_stream(VIEW_BUF_SIZE, NULL);
+	io_stream_t no_views = create_clone_stream(0, NULL);
+	io_stream_t sink = stream_create(&sink_ops, NULL);
+	int views[CONFIG_CLONE_STREAM_VIEW_NUM];
+	int i;
+
+	for (i = 0; i < CONFIG_CLONE_STREAM_VIEW_NUM; i++) {
+		views[i] = clone_stream_view_open(handle, 0, CLONE_STREAM_LAG_DROP);
+		CHECK(views[i] >= 0, "view %d open %d", i, views[i]);
+	}
+
+	CHECK(clone_stream_view_open(handle, 0, CLONE_STREAM_LAG_DROP) == -EBUSY, "too many views");
+	CHECK(clone_stream_view_close(handle, views[1]) == 0, "close");
+	CHECK(clone_stream_view_claim(handle, views[1], iov, 1) == -EINVAL, "claim of a closed view");
+	CHECK(clone_stream_view_close(handle, views[1]) == -EINVAL, "close twice");
+	CHECK(clone_stream_view_open(handle, 0, CLONE_STREAM_LAG_DROP) == views[1], "reopen");
+
+	CHECK(clone_stream_view_open(no_views, 0, CLONE_STREAM_LAG_DROP) == -ENOSYS, "no view buffer");
+	CHECK(clone_stream_view_open(sink, 0, CLONE_STREAM_LAG_DROP) == -EINVAL, "not a clone stream");
+
+	destroy_clone_stream(handle);
+	destroy_clone_stream(no_views);
+	stream_destroy(sink);
+}
+
+/* stress test and benchmark */
+#define NUM_CONSUMERS	4
+#define SLOW_US		300
+
+static io_stream_t bench_stream;
+static int bench_views[NUM_CONSUMERS];
+static int bench_consumers;
+static struct ring *bench_rings;
+static volatile int bench_done;
+
+static struct {
+	uint64_t released;
+	uint64_t discarded;
+	uint32_t claims;
+	uint32_t epipe;
+	uint32_t errors;
+} consumer_stats[NUM_CONSUMERS];
+
+/* copy out as a consumer passing the data on would, then check the words */
+static void *view_consumer(void *arg)
+{
+	long c = (long)arg;
+	struct acts_ringbuf_iovec iov[2];
+	uint32_t words[2048 / 4];
+	int len, i, errors;
+
+	for (;;) {
+		len = clone_stream_view_claim(bench_stream, bench_views[c], iov, sizeof(words));
+		if (len == -EPIPE) {
+			clone_stream_view_reset(bench_stream, bench_views[c]);
+			continue;
+		}
+
+		if (len <= 0) {
+			clone_stream_view_release(bench_stream, bench_views[c], 0);
+			if (bench_done)
+				break;
+			usleep(100);
+			continue;
+		}
+
+		memcpy(words, iov[0].base, iov[0].len);
+		memcpy((uint8_t *)words + iov[0].len, iov[1].base, iov[1].len);
+		if (c == 0)
+			usleep(SLOW_US);
+
+		for (i = 1, errors = 0; i < len / 4; i++)
+			errors += words[i] != words[i - 1] + 1;
+
+		consumer_stats[c].claims++;
+		if (clone_stream_view_release(bench_stream, bench_views[c], len) == -EPIPE) {
+			consumer_stats[c].epipe++;
+			consumer_stats[c].discarded += len;
+		} else {
+			consumer_stats[c].released += len;
+			consumer_stats[c].errors += errors;
+		}
+	}
+
+	return NULL;
+}
+
+static void *ring_consumer(void *arg)
+{
+	long c = (long)arg;
+	struct ring *ring = &bench_rings[c];
+	uint8_t buf[2048];
+	uint32_t len, idx, n;
+
+	for (;;) {
+		len = MIN(__atomic_load_n(&ring->wofs, __ATOMIC_ACQUIRE) - ring->rofs, sizeof(buf));
+		if (!len) {
+			if (bench_done)
+				break;
+			usleep(100);
+			continue;
+		}
+
+		idx = ring->rofs % RING_SIZE;
+		n = MIN(len, RING_SIZE - idx);
+		memcpy(buf, ring->buf + idx, n);
+		memcpy(buf + n, ring->buf, len - n);
+		__atomic_store_n(&ring->rofs, ring->rofs + len, __ATOMIC_RELEASE);
+		consumer_stats[c].released += len;
+	}
+
+	return NULL;
+}
+
+/* returns the producer time per KB in ns */
+static double run_fan_out(int consumers, bool copy, int chunk, uint32_t total, bool stress)
+{
+	pthread_t threads[NUM_CONSUMERS];
+	io_stream_t clones[NUM_CONSUMERS];
+	uint32_t words[2048 / 4], word = 0;
+	uint64_t ns = 0, t;
+	long i, k;
+
+	memset(consumer_stats, 0, sizeof(consumer_stats));
+	bench_consumers = consumers;
+	bench_done = 0;
+	bench_stream = create_clone_stream(copy ? 0 : RING_SIZE, NULL);
+
+	for (i = 0; i < consumers; i++) {
+		if (copy) {
+			memset(&bench_rings[i], 0, sizeof(bench_rings[i]));
+			clones[i] = stream_create(&ring_ops, &bench_rings[i]);
+			stream_open(clones[i], MODE_OUT);
+			pthread_create(&threads[i], NULL, ring_consumer, (void *)i);
+		} else {
+			/* the last stress consumer stops rather than drops */
+			bench_views[i] = clone_stream_view_open(bench_stream, 0,
+					(stress && i == NUM_CONSUMERS - 1) ?
+					CLONE_STREAM_LAG_STOP : CLONE_STREAM_LAG_DROP);
+			pthread_create(&threads[i], NULL, view_consumer, (void *)i);
+		}
+	}
+
+	for (k = 0; k < total / chunk; k++) {
+		for (i = 0; i < chunk / 4; i++)
+			words[i] = word++;
+
+		t = now_ns();
+		stream_write(bench_stream, (unsigned char *)words, chunk);
+		/* what clone_stream_write does for each of clones[] */
+		if (copy) {
+			for (i = 0; i < consumers; i++)
+				clones[i]->ops->write(clones[i], (unsigned char *)words, chunk);
+		}
+		ns += now_ns() - t;
+
+		if ((k & 63) == 63)
+			usleep(50);
+	}
+
+	bench_done = 1;
+	for (i = 0; i < consumers; i++) {
+		pthread_join(threads[i], NULL);
+		if (copy) {
+			stream_close(clones[i]);
+			stream_destroy(clones[i]);
+		}
+	}
+
+	if (stress) {
+		struct clone_stream_view_stat stat;
+
+		for (i = 0; i < consumers; i++) {
+			clone_stream_view_get_stat(bench_stream, bench_views[i], &stat);
+			printf("  consumer %ld %s: %6.1f KB released, %6.1f KB dropped, %5u claims, "
+			       "%3u overwritten, max lag %5u, stopped %u\n",
+			       i, i == NUM_CONSUMERS - 1 ? "stop" : "drop",
+			       consumer_stats[i].released / 1024.0, stat.dropped / 1024.0,
+			       consumer_stats[i].claims, consumer_stats[i].epipe, stat.max_lag, stat.stopped);
+
+			CHECK(consumer_stats[i].errors == 0, "consumer %ld: %u words out of sequence",
+			      i, consumer_stats[i].errors);
+			CHECK(stat.lag == 0, "consumer %ld: lag %u at the end", i, stat.lag);
+			if (i != NUM_CONSUMERS - 1) {
+				CHECK(consumer_stats[i].released + stat.dropped == total,
+				      "consumer %ld: %llu released + %u dropped of %u", i,
+				      (unsigned long long)consumer_stats[i].released, stat.dropped, total);
+			}
+		}
+
+		CHECK(consumer_stats[0].epipe > 0, "the lagging consumer had no overwritten claim");
+	}
+
+	destroy_clone_stream(bench_stream);
+
+	return (double)ns / (total / 1024);
+}
+
+/* the consumers preempt the producer, the best of some runs is reported */
+static double best_fan_out(int consumers, bool copy, int chunk, uint32_t total)
+{
+	double ns, best = 0;
+	int i;
+
+	for (i = 0; i < 5; i++) {
+		ns = run_fan_out(consumers, copy, chunk, total, false);
+		if (i == 0 || ns < best)
+			best = ns;
+	}
+
+	return best;
+}
+
+int main(int argc, char *argv[])
+{
+	uint32_t total = (argc > 1 ? atoi(argv[1]) : 4) << 20;
+	static const int chunks[] = { 512, 2048 };
+	int i, n;
+
+	test_claim_release();
+	test_drop();
+	test_stop();
+	test_overwrite();
+	test_open_close();
+
+	bench_rings = calloc(NUM_CONSUMERS, sizeof(*bench_rings));
+
+	printf("stress, %d consumers, consumer 0 sleeps %d us per claim:\n", NUM_CONSUMERS, SLOW_US);
+	run_fan_out(NUM_CONSUMERS, false, 512, 8 << 20, true);
+
+	printf("producer cost in ns/KB, best of 5 runs of %u KB\n", total >> 10);
+	printf("  consumers       ");
+	for (n = 1; n <= NUM_CONSUMERS; n++)
+		printf("%6d", n);
+	printf("\n");
+	for (i = 0; i < ARRAY_SIZE(chunks); i++) {
+		printf("  %4d B copy     ", chunks[i]);
+		for (n = 1; n <= NUM_CONSUMERS; n++)
+			printf("%6.0f", best_fan_out(n, true, chunks[i], total));
+		printf("\n  %4d B views    ", chunks[i]);
+		for (n = 1; n <= NUM_CONSUMERS; n++)
+			printf("%6.0f", best_fan_out(n, false, chunks[i], total));
+		printf("\n");
+	}
+
+	free(bench_rings);
+
+	if (failures) {
+		printf("clone_stream: %d failures\n", failures);
+		return 1;
+	}
+
+	printf("clone_stream: OK\n");
+	return 0;
+}
@@ -0,0 +1,9 @@
+/* host stub, mapped to libc in the test */
+
+#ifndef __HOST_MEM_MANAGER_H__
+#define __HOST_MEM_MANAGER_H__
+
+void *mem_malloc(int size);
+void mem_free(void *ptr);
+
+#endif
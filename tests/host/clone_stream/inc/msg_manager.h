@@ -0,0 +1,6 @@
+/* host stub, the streams need none of the message manager */
+
+#ifndef __HOST_MSG_MANAGER_H__
+#define __HOST_MSG_MANAGER_H__
+
+#endif
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * host stub of the OS API used by the streams, the irq lock is one global
+ * mutex as the producer and the view consumers run in threads
+ */
+
+#ifndef __HOST_OS_COMMON_API_H__
+#define __HOST_OS_COMMON_API_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/util.h>
+
+#define OS_FOREVER	(-1)
+#define OS_NO_WAIT	0
+
+typedef struct {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	int count;
+	int limit;
+} os_sem;
+
+typedef pthread_mutex_t os_mutex;
+
+void os_sem_init(os_sem *sem, int count, int limit);
+int os_sem_take(os_sem *sem, int timeout);
+void os_sem_give(os_sem *sem);
+void os_sem_reset(os_sem *sem);
+uint32_t os_uptime_get_32(void);
+unsigned int os_irq_lock(void);
+void os_irq_unlock(unsigned int key);
+
+#define os_mutex_init(mutex)		pthread_mutex_init(mutex, NULL)
+#define os_mutex_lock(mutex, timeout)	pthread_mutex_lock(mutex)
+#define os_mutex_unlock(mutex)		pthread_mutex_unlock(mutex)
+#define os_is_in_isr()			0
+#define os_printk			printf
+
+#ifdef HOST_LOG
+#define SYS_LOG_ERR(fmt, ...)	printf("E %s: " fmt, __func__, ##__VA_ARGS__)
+#define SYS_LOG_WRN(fmt, ...)	printf("W %s: " fmt, __func__, ##__VA_ARGS__)
+#else
+#define SYS_LOG_ERR(...)	do { } while (0)
+#define SYS_LOG_WRN(...)	do { } while (0)
+#endif
+#define SYS_LOG_INF(...)	do { } while (0)
+#define SYS_LOG_DBG(...)	do { } while (0)
+
+#endif
@@ -0,0 +1,456 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief test and benchmark of the message ring of the dsp mailbox
+ *
+ * The driver source is built into the test with a model of the dsp end
+ * of the mailbox: the dsp acks a message 2-10 us after the irq, or a slow
+ * ack after 50-850 us for a given share of the messages. The system work
+ * queue is a thread running the delayed work of the ring with 1 ms ticks.
+ *
+ * A sender posts a message every 100 us with the old direct busy wait,
+ * with the sync wrapper over the ring and async. Every message must
+ * complete without error in the order sent. Reported are the time the
+ * sender is blocked, the time to completion and the busy wait of the
+ * driver per message, which must be less over the ring than direct for
+ * sync and async messages alike. Then a burst into a slow dsp must fill the ring and
+ * get -ENOSPC for the rest, and kicks sent while one waits for its ack
+ * must be merged into it.
+ *
+ * Usage: dsp_mailbox_test [messages per run, default 2000]
+ */
+
+#include <stdlib.h>
+#include <time.h>
+
+#include "../../../zephyr/drivers/dsp/dsp_mailbox.c"
+
+#define MAX_MSGS	20000
+#define SEND_GAP_US	100
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) \
+	do { \
+		if (!(cond)) { \
+			if (failures++ < 20) \
+				printf("FAIL %s:%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__); \
+		} \
+	} while (0)
+
+static uint64_t now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+/* kernel stubs */
+struct k_work_q k_sys_work_q;
+
+static __thread k_tid_t current_thread;
+static struct k_thread app_thread;
+static pthread_mutex_t irq_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+k_tid_t k_current_get(void)
+{
+	return current_thread;
+}
+
+unsigned int irq_lock(void)
+{
+	pthread_mutex_lock(&irq_mutex);
+	return 0;
+}
+
+void irq_unlock(unsigned int key)
+{
+	pthread_mutex_unlock(&irq_mutex);
+}
+
+void k_sem_init(struct k_sem *sem, int initial_count, int limit)
+{
+	pthread_mutex_init(&sem->mutex, NULL);
+	pthread_cond_init(&sem->cond, NULL);
+	sem->count = initial_count;
+	sem->limit = limit;
+}
+
+void k_sem_give(struct k_sem *sem)
+{
+	pthread_mutex_lock(&sem->mutex);
+	if (sem->count < sem->limit)
+		sem->count++;
+	pthread_cond_signal(&sem->cond);
+	pthread_mutex_unlock(&sem->mutex);
+}
+
+int k_sem_take(struct k_sem *sem, k_timeout_t timeout)
+{
+	pthread_mutex_lock(&sem->mutex);
+	while (!sem->count) {
+		if (!timeout.ticks) {
+			pthread_mutex_unlock(&sem->mutex);
+			return -EBUSY;
+		}
+		pthread_cond_wait(&sem->cond, &sem->mutex);
+	}
+	sem->count--;
+	pthread_mutex_unlock(&sem->mutex);
+
+	return 0;
+}
+
+/* dsp end of the mailbox */
+struct dsp_acts_config_entity dsp_cfg_entity;
+
+static pthread_mutex_t dsp_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int dsp_triggered;
+static uint64_t dsp_ack_at;
+static uint32_t dsp_rx_log[MAX_MSGS + 1000];
+static int dsp_rx_num;
+static unsigned int dsp_seed = 1;
+static int dsp_slow_pct;
+static uint64_t busy_wait_us;
+
+static void dsp_model_poll(void)
+{
+	struct dsp_protocol_mailbox *mailbox = &dsp_cfg_entity.dsp_mailbox;
+
+	pthread_mutex_lock(&dsp_mutex);
+	if (dsp_triggered && (MSG_STATUS(mailbox->msg) & MSG_FLAG_BUSY) && now_us() >= dsp_ack_at) {
+		if (dsp_rx_num < ARRAY_SIZE(dsp_rx_log))
+			dsp_rx_log[dsp_rx_num] = mailbox->param1;
+		dsp_rx_num++;
+		mailbox->msg = MAILBOX_MSG(MSG_ID(mailbox->msg), MSG_FLAG_ACK | MSG_FLAG_DONE);
+	}
+	pthread_mutex_unlock(&dsp_mutex);
+}
+
+void mcu_trigger_irq_to_dsp(void)
+{
+	int r = rand_r(&dsp_seed) % 100;
+	uint32_t delay = (r < 100 - dsp_slow_pct) ? 2 + r % 8 : 50 + rand_r(&dsp_seed) % 800;
+
+	pthread_mutex_lock(&dsp_mutex);
+	dsp_triggered = 1;
+	dsp_ack_at = now_us() + delay;
+	pthread_mutex_unlock(&dsp_mutex);
+}
+
+void mcu_untrigger_irq_to_dsp(void)
+{
+	dsp_triggered = 0;
+}
+
+void k_busy_wait(uint32_t usec_to_wait)
+{
+	uint64_t end = now_us() + usec_to_wait;
+
+	__atomic_add_fetch(&busy_wait_us, usec_to_wait, __ATOMIC_RELAXED);
+	while (now_us() < end)
+		;
+	dsp_model_poll();
+}
+
+uint32_t k_cycle_get_32(void)
+{
+	dsp_model_poll();
+	return (uint32_t)now_us();
+}
+
+/* system work queue thread, 1 ms ticks, the ring work is its only work */
+static pthread_mutex_t work_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_cond = PTHREAD_COND_INITIALIZER;
+static struct k_delayed_work *work_item;
+
+void k_delayed_work_init(struct k_delayed_work *work, k_work_handler_t handler)
+{
+	work->work.handler = handler;
+	work->pending = 0;
+	work_item = work;
+}
+
+int k_delayed_work_submit(struct k_delayed_work *work, k_timeout_t delay)
+{
+	pthread_mutex_lock(&work_mutex);
+	work->due_us = now_us() + delay.ticks * 1000;
+	work->pending = 1;
+	pthread_cond_signal(&work_cond);
+	pthread_mutex_unlock(&work_mutex);
+	return 0;
+}
+
+static void *work_q_thread(void *arg)
+{
+	current_thread = &k_sys_work_q.thread;
+
+	for (;;) {
+		pthread_mutex_lock(&work_mutex);
+		while (!work_item || !work_item->pending || now_us() < work_item->due_us) {
+			if (work_item && work_item->pending) {
+				pthread_mutex_unlock(&work_mutex);
+				sched_yield();
+				pthread_mutex_lock(&work_mutex);
+			} else {
+				pthread_cond_wait(&work_cond, &work_mutex);
+			}
+		}
+		work_item->pending = 0;
+		pthread_mutex_unlock(&work_mutex);
+
+		work_item->work.handler(&work_item->work);
+	}
+
+	return NULL;
+}
+
+/* receive side of the mailbox, not run by the test */
+int dsp_acts_handle_image_pagemiss(struct device *dev, uint32_t epc)
+{
+	return 0;
+}
+
+int dsp_acts_handle_image_pageflush(struct device *dev, uint32_t epc)
+{
+	return 0;
+}
+
+static struct dsp_acts_data dsp_data;
+static const struct dsp_acts_config dsp_cfg = {
+	.dsp_mailbox = &dsp_cfg_entity.dsp_mailbox,
+	.cpu_mailbox = &dsp_cfg_entity.cpu_mailbox,
+	.dsp_userinfo = &dsp_cfg_entity.dsp_userinfo,
+};
+static struct device dsp_dev = { "dsp", &dsp_cfg, NULL, &dsp_data };
+
+static uint64_t t_queue[MAX_MSGS], t_done[MAX_MSGS];
+static uint32_t block_us[MAX_MSGS], done_us[MAX_MSGS];
+static int done_order[MAX_MSGS];
+static volatile int done_num;
+static int done_errors;
+
+static void done_callback(struct dsp_message *message, int res, void *user_data)
+{
+	int i = message->param1;
+
+	t_done[i] = now_us();
+	done_errors += res != 0;
+	done_order[done_num++] = i;
+}
+
+static void reset(int slow_pct)
+{
+	dsp_cfg_entity.dsp_mailbox.msg = MAILBOX_MSG(DSP_MSG_NULL, MSG_FLAG_ACK);
+	dsp_cfg_entity.dsp_userinfo.task_state = DSP_TASK_SUSPENDED;
+	dsp_acts_msg_ring_init(&dsp_dev);
+	dsp_data.pm_status = DSP_STATUS_POWERON;
+	dsp_slow_pct = slow_pct;
+	dsp_rx_num = 0;
+	done_num = 0;
+	done_errors = 0;
+	busy_wait_us = 0;
+}
+
+static void wait_ring_idle(void)
+{
+	while (dsp_data.msg_ring.count)
+		sched_yield();
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+static void report_percentiles(const char *name, uint32_t *values, int num)
+{
+	qsort(values, num, sizeof(*values), compare_u32);
+	printf("  %-18s p50 %4u us  p90 %4u us  p99 %4u us  max %4u us\n", name,
+	       values[num / 2], values[num * 9 / 10], values[num * 99 / 100], values[num - 1]);
+}
+
+enum {
+	SEND_DIRECT,
+	SEND_SYNC,
+	SEND_ASYNC,
+};
+
+static const char *send_names[] = { "old direct", "sync over ring", "async" };
+
+/* the sender posts a message every SEND_GAP_US, returns the busy wait per message */
+static uint64_t run_sender(int mode, int num, int slow_pct)
+{
+	struct dsp_message msg;
+	uint64_t start;
+	int i, res, full = 0, order_errors = 0;
+
+	reset(slow_pct);
+	/* the old path was run by any thread, the work queue thread takes it now */
+	current_thread = (mode == SEND_DIRECT) ? &k_sys_work_q.thread : &app_thread;
+
+	for (i = 0; i < num; i++) {
+		memset(&msg, 0, sizeof(msg));
+		msg.id = DSP_MSG_KICK + 1;
+		msg.owner = 1;
+		msg.param1 = i;
+
+		start = now_us();
+		t_queue[i] = start;
+
+		if (mode == SEND_ASYNC) {
+			while ((res = dsp_acts_send_message_async(&dsp_dev, &msg, done_callback, NULL)) == -ENOSPC) {
+				full++;
+				sched_yield();
+			}
+			CHECK(res >= 0, "message %d: %d", i, res);
+		} else {
+			res = dsp_acts_send_message(&dsp_dev, &msg);
+			t_done[i] = now_us();
+			done_errors += res != 0;
+			done_order[done_num++] = i;
+		}
+
+		block_us[i] = now_us() - start;
+		while (now_us() - start < SEND_GAP_US)
+			sched_yield();
+	}
+
+	while (done_num < num)
+		sched_yield();
+	current_thread = &app_thread;
+
+	for (i = 0; i < num; i++) {
+		done_us[i] = t_done[i] - t_queue[i];
+		order_errors += done_order[i] != i || dsp_rx_log[i] != i;
+	}
+
+	printf("%-15s %d messages: driver busy wait %3llu us per message, ring full %d\n",
+	       send_names[mode], num, (unsigned long long)busy_wait_us / num, full);
+	report_percentiles("sender blocked", block_us, num);
+	report_percentiles("queue to complete", done_us, num);
+
+	CHECK(!done_errors, "%s: %d messages failed", send_names[mode], done_errors);
+	CHECK(!order_errors && dsp_rx_num == num, "%s: %d out of order, %d of %d received",
+	      send_names[mode], order_errors, dsp_rx_num, num);
+
+	return busy_wait_us / num;
+}
+
+/* a burst into a slow dsp fills the ring, the rest is refused */
+static void test_burst(void)
+{
+	struct dsp_message msg;
+	int i, res, queued = 0, nospc = 0;
+
+	reset(100);
+	for (i = 0; i < 20; i++) {
+		memset(&msg, 0, sizeof(msg));
+		msg.id = DSP_MSG_KICK + 1;
+		msg.param1 = i;
+
+		res = dsp_acts_send_message_async(&dsp_dev, &msg, done_callback, NULL);
+		if (res >= 0)
+			queued++;
+		else if (res == -ENOSPC)
+			nospc++;
+	}
+
+	/* the work queue can not wait for the ring it drains */
+	current_thread = &k_sys_work_q.thread;
+	res = dsp_acts_send_message(&dsp_dev, &msg);
+	current_thread = &app_thread;
+	CHECK(res == -EBUSY, "direct send with busy ring: %d", res);
+
+	wait_ring_idle();
+
+	printf("burst of 20 into a slow dsp: queued %d, -ENOSPC %d, completed %d\n",
+	       queued, nospc, done_num);
+
+	CHECK(queued == CONFIG_DSP_MSG_RING_SIZE && nospc == 20 - queued,
+	      "queued %d, -ENOSPC %d", queued, nospc);
+	CHECK(done_num == queued && !done_errors, "%d completed, %d failed", done_num, done_errors);
+}
+
+/* kicks sent while one waits for its ack are merged into the next one */
+static void test_kick_coalesce(void)
+{
+	struct dsp_message msg;
+	int i, accepted = 0;
+
+	reset(100);
+	for (i = 0; i < 1000; i++) {
+		memset(&msg, 0, sizeof(msg));
+		msg.id = DSP_MSG_KICK;
+		msg.owner = 7;
+		msg.param1 = DSP_EVENT_NEW_CMD;
+
+		accepted += dsp_acts_send_message_async(&dsp_dev, &msg, NULL, NULL) >= 0;
+		k_busy_wait(5);
+	}
+
+	wait_ring_idle();
+
+	printf("1000 kicks into a slow dsp: accepted %d, posted %d, coalesced %u, full %u\n",
+	       accepted, dsp_rx_num, dsp_data.msg_ring.coalesce_cnt, dsp_data.msg_ring.full_cnt);
+
+	CHECK(accepted == 1000, "%d kicks accepted", accepted);
+	CHECK(dsp_rx_num + dsp_data.msg_ring.coalesce_cnt == 1000,
+	      "%d posted and %u coalesced", dsp_rx_num, dsp_data.msg_ring.coalesce_cnt);
+	CHECK(dsp_rx_num < 100, "%d kicks posted", dsp_rx_num);
+
+	/* a running dsp finds the new commands itself */
+	reset(0);
+	dsp_cfg_entity.dsp_userinfo.task_state = DSP_TASK_RUNNING;
+	for (i = 0; i < 10; i++)
+		dsp_acts_send_message_async(&dsp_dev, &msg, NULL, NULL);
+	wait_ring_idle();
+	CHECK(dsp_rx_num == 0, "%d kicks posted to a running dsp", dsp_rx_num);
+}
+
+int main(int argc, char *argv[])
+{
+	pthread_t work_q;
+	uint64_t direct_wait, sync_wait, async_wait;
+	int num = argc > 1 ? atoi(argv[1]) : 2000;
+	int slow_pct;
+
+	if (num <= 0 || num > MAX_MSGS)
+		num = MAX_MSGS;
+
+	current_thread = &app_thread;
+	reset(0);
+	pthread_create(&work_q, NULL, work_q_thread, NULL);
+
+	for (slow_pct = 0; slow_pct <= 15; slow_pct += 15) {
+		printf("dsp acks after 2-10 us, %d%% after 50-850 us\n", slow_pct);
+		direct_wait = run_sender(SEND_DIRECT, num, slow_pct);
+		sync_wait = run_sender(SEND_SYNC, num, slow_pct);
+		async_wait = run_sender(SEND_ASYNC, num, slow_pct);
+	}
+
+	/* the sends over the ring do not spin for the slow acks */
+	CHECK(sync_wait < direct_wait / 2, "busy wait per message: sync %llu us, direct %llu us",
+	      (unsigned long long)sync_wait, (unsigned long long)direct_wait);
+	CHECK(async_wait < direct_wait / 2, "busy wait per message: async %llu us, direct %llu us",
+	      (unsigned long long)async_wait, (unsigned long long)direct_wait);
+
+	test_burst();
+	test_kick_coalesce();
+
+	if (failures) {
+		printf("dsp_mailbox: %d failures\n", failures);
+		return 1;
+	}
+
+	printf("dsp_mailbox: OK\n");
+	return 0;
+}
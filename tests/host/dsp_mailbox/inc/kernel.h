@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the kernel interfaces used by the dsp mailbox */
+
+#ifndef __HOST_KERNEL_H__
+#define __HOST_KERNEL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+
+#define BIT(n)			(1UL << (n))
+#define ARRAY_SIZE(a)		(sizeof(a) / sizeof((a)[0]))
+#define __unused		__attribute__((unused))
+#define CONTAINER_OF(ptr, type, field) \
+	((type *)(((char *)(ptr)) - offsetof(type, field)))
+
+#ifdef HOST_LOG
+#define printk(...)		printf(__VA_ARGS__)
+#else
+#define printk(...)		do { } while (0)
+#endif
+
+typedef struct {
+	int ticks;
+} k_timeout_t;
+
+#define K_NO_WAIT		((k_timeout_t){ 0 })
+#define K_FOREVER		((k_timeout_t){ -1 })
+#define K_TICKS(n)		((k_timeout_t){ n })
+
+struct k_thread {
+	int dummy;
+};
+
+typedef struct k_thread *k_tid_t;
+
+k_tid_t k_current_get(void);
+
+static inline bool k_is_in_isr(void)
+{
+	return false;
+}
+
+/* a single delayed work, run by the work queue thread of the test */
+struct k_work;
+
+typedef void (*k_work_handler_t)(struct k_work *work);
+
+struct k_work {
+	k_work_handler_t handler;
+};
+
+struct k_delayed_work {
+	struct k_work work;
+	int pending;
+	uint64_t due_us;
+};
+
+struct k_work_q {
+	struct k_thread thread;
+};
+
+extern struct k_work_q k_sys_work_q;
+
+#define K_WORK_DEFINE(name, work_handler) \
+	struct k_work name = { work_handler }
+
+void k_delayed_work_init(struct k_delayed_work *work, k_work_handler_t handler);
+int k_delayed_work_submit(struct k_delayed_work *work, k_timeout_t delay);
+
+static inline int k_work_submit(struct k_work *work)
+{
+	return 0;
+}
+
+struct k_sem {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	int count;
+	int limit;
+};
+
+void k_sem_init(struct k_sem *sem, int initial_count, int limit);
+int k_sem_take(struct k_sem *sem, k_timeout_t timeout);
+void k_sem_give(struct k_sem *sem);
+
+unsigned int irq_lock(void);
+void irq_unlock(unsigned int key);
+
+/* the cycle counter counts microseconds */
+void k_busy_wait(uint32_t usec_to_wait);
+uint32_t k_cycle_get_32(void);
+
+static inline uint32_t k_cyc_to_us_floor32(uint32_t cycles)
+{
+	return cycles;
+}
+
+#endif
@@ -0,0 +1,22 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the dsp soc interface, the irq goes to the dsp model */
+
+#ifndef __HOST_SOC_DSP_H__
+#define __HOST_SOC_DSP_H__
+
+#define DATA_ADDR	0
+
+void mcu_trigger_irq_to_dsp(void);
+void mcu_untrigger_irq_to_dsp(void);
+
+static inline unsigned int mcu_to_dsp_address(unsigned int addr, int type)
+{
+	return addr;
+}
+
+#endif
@@ -0,0 +1,12 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub, nothing of it is used by the dsp mailbox */
+
+#ifndef __HOST_ZEPHYR_TYPES_H__
+#define __HOST_ZEPHYR_TYPES_H__
+
+#endif
@@ -0,0 +1,34 @@
+# Common rules of the host tests
+#
+# The Makefile of each test sets TEST (program name) and SRCS, optionally
+# CPPFLAGS, LDLIBS and RUN (command of the check target), then includes
+# this file. Programs are built in build/ of the test, extra programs can
+# be added to PROGS with their own rules. Repo sources are referred to
+# through $(TOP), stub headers of kernel and driver interfaces live in
+# inc/ of the test.
+
+TOP := $(abspath $(dir $(lastword $(MAKEFILE_LIST)))/../..)
+OUT := build
+
+CC ?= cc
+CFLAGS ?= -O2 -g -Wall -Wno-unused-function -Wno-unused-variable \
+	-Wno-unused-but-set-variable -Wno-pointer-to-int-cast \
+	-Wno-int-to-pointer-cast -Wno-pointer-sign -Wno-format
+CPPFLAGS += -I inc
+DEPS += $(wildcard inc/*.h inc/*/*.h *.h)
+PROGS += $(OUT)/$(TEST)
+RUN ?= $(OUT)/$(TEST) $(ARGS)
+
+all: $(PROGS)
+
+$(OUT)/$(TEST): $(SRCS) $(DEPS)
+	@mkdir -p $(OUT)
+	$(CC) $(CFLAGS) $(CPPFLAGS) -o $@ $(SRCS) $(LDLIBS)
+
+check: all
+	$(RUN)
+
+clean:
+	rm -rf $(OUT)
+
+.PHONY: all check clean
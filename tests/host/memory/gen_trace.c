@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2019 Actions Semi Co., Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief generate allocation traces for mem_trace
+ *
+ * Writes a trace of one use case to stdout. Each use case is a mix of
+ * allocation profiles: boot time objects which live until the end,
+ * service objects which come and go with the use case, and short lived
+ * messages and buffers. Sizes, lifetimes and callers of the profiles are
+ * kept in the tables below, so traces can be tuned and regenerated.
+ *
+ * Trace format, one event per line:
+ *   # comment
+ *   m <id> <size> <caller>    allocate size bytes, caller in hex
+ *   f <id>                    free the allocation with id
+ *
+ * Usage: gen_trace idle|music|call
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LIVE		512
+#define ARRAY_SIZE(a)		(sizeof(a) / sizeof((a)[0]))
+
+struct alloc_profile {
+	const char *name;
+	unsigned int caller;
+	unsigned short min_size;
+	unsigned short max_size;
+	/* lifetime in events, 0 lives until the end */
+	unsigned short min_life;
+	unsigned short max_life;
+	/* relative weight of allocations */
+	unsigned short weight;
+};
+
+struct use_case {
+	const char *name;
+	unsigned int seed;
+	unsigned int events;
+	const struct alloc_profile *boot;
+	int boot_num;
+	const struct alloc_profile *run;
+	int run_num;
+};
+
+/* allocated once at boot by services and drivers */
+static const struct alloc_profile boot_profiles[] = {
+	{ "service ctx",	0x10012a41, 48, 120, 0, 0, 12 },
+	{ "listener",		0x10013305, 20, 32, 0, 0, 10 },
+	{ "timer",		0x10016c11, 12, 16, 0, 0, 8 },
+	{ "property",		0x10015a27, 24, 60, 0, 0, 6 },
+	{ "bt stack",		0x10031f09, 200, 480, 0, 0, 4 },
+	{ "ui view",		0x10042b73, 100, 250, 0, 0, 3 },
+};
+
+static const struct alloc_profile idle_profiles[] = {
+	{ "app msg",		0x10013a91, 8, 16, 1, 12, 40 },
+	{ "event",		0x10013c55, 12, 28, 2, 30, 20 },
+	{ "bt hci evt",		0x10032e17, 20, 64, 1, 8, 15 },
+	{ "ui string",		0x10043081, 10, 40, 5, 80, 10 },
+	{ "property cache",	0x10015b3d, 30, 60, 20, 200, 3 },
+	{ "bt acl",		0x10033415, 60, 260, 2, 20, 4 },
+};
+
+static const struct alloc_profile music_profiles[] = {
+	{ "app msg",		0x10013a91, 8, 16, 1, 12, 40 },
+	{ "event",		0x10013c55, 12, 28, 2, 30, 15 },
+	{ "bt acl",		0x10033415, 60, 700, 2, 12, 20 },
+	{ "media cmd",		0x10052281, 16, 48, 1, 10, 10 },
+	{ "stream ctx",		0x10053ad9, 80, 200, 200, 2000, 2 },
+	{ "decoder frame",	0x10055e13, 300, 1000, 2, 10, 6 },
+	{ "tws sync",		0x10057145, 24, 100, 1, 6, 8 },
+};
+
+static const struct alloc_profile call_profiles[] = {
+	{ "app msg",		0x10013a91, 8, 16, 1, 12, 40 },
+	{ "event",		0x10013c55, 12, 28, 2, 30, 15 },
+	{ "bt sco",		0x10034b27, 60, 120, 1, 6, 25 },
+	{ "media cmd",		0x10052281, 16, 48, 1, 10, 8 },
+	{ "stream ctx",		0x10053ad9, 80, 200, 200, 2000, 2 },
+	{ "aec frame",		0x10058a61, 256, 512, 2, 8, 8 },
+	{ "upload buffer",	0x1005b0f3, 1024, 1500, 10, 60, 1 },
+};
+
+static const struct use_case use_cases[] = {
+	{ "idle", 1, 6000, boot_profiles, ARRAY_SIZE(boot_profiles),
+		idle_profiles, ARRAY_SIZE(idle_profiles) },
+	{ "music", 2, 6000, boot_profiles, ARRAY_SIZE(boot_profiles),
+		music_profiles, ARRAY_SIZE(music_profiles) },
+	{ "call", 3, 6000, boot_profiles, ARRAY_SIZE(boot_profiles),
+		call_profiles, ARRAY_SIZE(call_profiles) },
+};
+
+static struct {
+	unsigned int id;
+	unsigned int free_at;
+} live[MAX_LIVE];
+static int live_num;
+static unsigned int next_id;
+
+/* own generator, so traces are the same on every host */
+static unsigned int rand_state;
+
+static unsigned int trace_rand(unsigned int range)
+{
+	rand_state = rand_state * 1103515245 + 12345;
+	return ((rand_state >> 8) & 0xffffff) % range;
+}
+
+static void trace_alloc(const struct alloc_profile *prof, unsigned int now)
+{
+	unsigned int size = prof->min_size + trace_rand(prof->max_size - prof->min_size + 1);
+	unsigned int life = 0;
+
+	if (live_num == MAX_LIVE)
+		return;
+
+	if (prof->max_life)
+		life = prof->min_life + trace_rand(prof->max_life - prof->min_life + 1);
+
+	printf("m %u %u %08x\n", next_id, size, prof->caller);
+
+	live[live_num].id = next_id++;
+	live[live_num].free_at = life ? now + life : 0;
+	live_num++;
+}
+
+static void trace_free_due(unsigned int now)
+{
+	int i;
+
+	for (i = 0; i < live_num; ) {
+		if (live[i].free_at && live[i].free_at <= now) {
+			printf("f %u\n", live[i].id);
+			live[i] = live[--live_num];
+		} else {
+			i++;
+		}
+	}
+}
+
+static const struct alloc_profile *pick_profile(const struct alloc_profile *profs, int num)
+{
+	unsigned int total = 0, pick;
+	int i;
+
+	for (i = 0; i < num; i++)
+		total += profs[i].weight;
+
+	pick = trace_rand(total);
+	for (i = 0; i < num; i++) {
+		if (pick < profs[i].weight)
+			break;
+		pick -= profs[i].weight;
+	}
+
+	return &profs[i];
+}
+
+int main(int argc, char *argv[])
+{
+	const struct use_case *uc = NULL;
+	unsigned int now;
+	int i, n;
+
+	for (i = 0; argc > 1 && i < ARRAY_SIZE(use_cases); i++) {
+		if (!strcmp(argv[1], use_cases[i].name))
+			uc = &use_cases[i];
+	}
+
+	if (!uc) {
+		fprintf(stderr, "usage: gen_trace idle|music|call\n");
+		return 1;
+	}
+
+	rand_state = uc->seed;
+
+	printf("# %s use case, generated by gen_trace\n", uc->name);
+
+	for (i = 0; i < uc->boot_num; i++) {
+		for (n = 0; n < uc->boot[i].weight; n++)
+			trace_alloc(&uc->boot[i], 0);
+	}
+
+	for (now = 1; now <= uc->events; now++) {
+		trace_free_due(now);
+		trace_alloc(pick_profile(uc->run, uc->run_num), now);
+	}
+
+	return 0;
+}
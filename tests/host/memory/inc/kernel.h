@@ -0,0 +1,133 @@
+/*
+ * host stub of the kernel API used by the mem slab and page buddy
+ * allocators, the replay is single threaded
+ */
+
+#ifndef __HOST_KERNEL_H__
+#define __HOST_KERNEL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <errno.h>
+
+typedef uint8_t u8_t;
+typedef uint16_t u16_t;
+typedef uint32_t u32_t;
+typedef int32_t s32_t;
+
+#define __aligned(x)		__attribute__((aligned(x)))
+/* page buddy pages are found by address, keep the pool page aligned */
+#define __in_section_unique(s)	__aligned(2048)
+#define CONTAINER_OF(ptr, type, field) \
+	((type *)(((char *)(ptr)) - offsetof(type, field)))
+
+#ifdef HOST_LOG
+#define printk			printf
+#else
+static inline int printk(const char *fmt, ...)
+{
+	return 0;
+}
+#endif
+
+#define K_NO_WAIT		0
+
+typedef struct {
+	void *next;
+} sys_snode_t;
+
+typedef struct {
+	sys_snode_t *head;
+	sys_snode_t *tail;
+} sys_slist_t;
+
+typedef void *k_tid_t;
+
+struct k_mem_slab {
+	uint32_t num_blocks;
+	size_t block_size;
+	char *buffer;
+	char *free_list;
+	uint32_t num_used;
+};
+
+static inline int k_mem_slab_init(struct k_mem_slab *slab, void *buffer,
+		size_t block_size, uint32_t num_blocks)
+{
+	int i;
+
+	slab->num_blocks = num_blocks;
+	slab->block_size = block_size;
+	slab->buffer = buffer;
+	slab->free_list = NULL;
+	slab->num_used = 0;
+
+	for (i = num_blocks - 1; i >= 0; i--) {
+		char *block = (char *)buffer + i * block_size;
+
+		*(char **)block = slab->free_list;
+		slab->free_list = block;
+	}
+
+	return 0;
+}
+
+static inline int k_mem_slab_alloc(struct k_mem_slab *slab, void **mem, int timeout)
+{
+	if (!slab->free_list)
+		return -ENOMEM;
+
+	*mem = slab->free_list;
+	slab->free_list = *(char **)slab->free_list;
+	slab->num_used++;
+	return 0;
+}
+
+static inline void k_mem_slab_free(struct k_mem_slab *slab, void **mem)
+{
+	*(char **)*mem = slab->free_list;
+	slab->free_list = *mem;
+	slab->num_used--;
+}
+
+static inline uint32_t k_mem_slab_num_used_get(struct k_mem_slab *slab)
+{
+	return slab->num_used;
+}
+
+static inline uint32_t k_mem_slab_num_free_get(struct k_mem_slab *slab)
+{
+	return slab->num_blocks - slab->num_used;
+}
+
+static inline unsigned int irq_lock(void)
+{
+	return 0;
+}
+
+static inline void irq_unlock(unsigned int key)
+{
+}
+
+static inline uint32_t k_uptime_get_32(void)
+{
+	return 0;
+}
+
+static inline k_tid_t k_current_get(void)
+{
+	return NULL;
+}
+
+static inline int k_thread_priority_get(k_tid_t thread)
+{
+	return 0;
+}
+
+/* a failed buddy allocation panics on target, the replay counts it */
+extern int host_panic_cnt;
+#define k_panic()		(host_panic_cnt++)
+
+#endif
@@ -0,0 +1,25 @@
+/* host stub of the OS API used by the allocators */
+
+#ifndef __HOST_OS_COMMON_API_H__
+#define __HOST_OS_COMMON_API_H__
+
+#include <kernel.h>
+#include <mem_manager.h>
+/* the SDK header provides the allocator internals to the memory sources */
+#include <mem_inner.h>
+
+#ifdef HOST_LOG
+#define SYS_LOG_ERR(...)	printf(__VA_ARGS__)
+#define SYS_LOG_INF(...)	printf(__VA_ARGS__)
+#else
+#define SYS_LOG_ERR(...)	do { } while (0)
+#define SYS_LOG_INF(...)	do { } while (0)
+#endif
+#define SYS_LOG_DBG(...)	do { } while (0)
+
+static inline bool os_is_in_isr(void)
+{
+	return false;
+}
+
+#endif
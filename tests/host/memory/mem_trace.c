@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) 2019 Actions Semi Co., Inc.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief replay allocation traces against the slab and page buddy allocators
+ *
+ * Every allocation of the trace is made from the system slab with the
+ * Kconfig default classes and from the page buddy, as the app allocator
+ * would do with APP_USED_MEM_SLAB or APP_USED_MEM_PAGE. The slab
+ * statistics snapshot is checked against the counts of the replay, and
+ * both allocators must be empty after the remaining blocks are freed.
+ *
+ * The report shows per class peak usage and failures of the slab, and
+ * the blocks each class needs so that the trace never fails, from which
+ * SLAB_TOTAL_SIZE can be sized. See gen_trace.c for the trace format.
+ *
+ * Usage: mem_trace <trace>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <os_common_api.h>
+#include <mem_buddy.h>
+#include <page_inner.h>
+
+int host_panic_cnt;
+
+extern const struct slabs_info sys_slab;
+extern struct mem_info sys_meminfo;
+void slabs_mem_init(struct slabs_info *slabs);
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) \
+	do { \
+		if (!(cond)) { \
+			printf("FAIL %s:%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__); \
+			failures++; \
+		} \
+	} while (0)
+
+struct trace_alloc {
+	void *slab_ptr;
+	void *page_ptr;
+	unsigned int size;
+	/* best fit slab class, slab_num if larger than all classes */
+	unsigned char fit;
+	unsigned char live;
+};
+
+static struct trace_alloc *allocs;
+static unsigned int alloc_max;
+
+static struct {
+	unsigned int alloc;
+	unsigned int free;
+	unsigned int slab_fail;
+	unsigned int page_fail;
+	unsigned int live_bytes;
+	unsigned int peak_bytes;
+	unsigned int fit_live[CONFIG_SLAB_TOTAL_NUM + 1];
+	unsigned int fit_peak[CONFIG_SLAB_TOTAL_NUM + 1];
+	unsigned int page_peak;
+	unsigned int buddy_peak;
+} replay;
+
+/* the buddy panics on failures on target, print its dump there */
+void mem_buddy_dump_info(u32_t dump_detail, const char *match_str)
+{
+}
+
+static struct slabs_info *slabs(void)
+{
+	return (struct slabs_info *)&sys_slab;
+}
+
+static int slab_fit(unsigned int size)
+{
+	int i;
+
+	for (i = 0; i < slabs()->slab_num; i++) {
+		if (slabs()->slabs[i].block_size >= size)
+			break;
+	}
+
+	return i;
+}
+
+static struct trace_alloc *trace_get(unsigned int id)
+{
+	if (id >= alloc_max) {
+		unsigned int num = (id + 1) * 2;
+
+		allocs = realloc(allocs, num * sizeof(*allocs));
+		memset(allocs + alloc_max, 0, (num - alloc_max) * sizeof(*allocs));
+		alloc_max = num;
+	}
+
+	return &allocs[id];
+}
+
+static void replay_alloc(unsigned int id, unsigned int size, void *caller)
+{
+	struct trace_alloc *a = trace_get(id);
+	unsigned int pages;
+
+	CHECK(!a->live, "id %u allocated twice", id);
+
+	a->size = size;
+	a->fit = slab_fit(size);
+	a->live = 1;
+
+	a->slab_ptr = mem_slabs_malloc(slabs(), size, caller);
+	if (!a->slab_ptr)
+		replay.slab_fail++;
+
+	a->page_ptr = mem_page_malloc(size, caller);
+	if (!a->page_ptr)
+		replay.page_fail++;
+
+	replay.alloc++;
+	replay.live_bytes += size;
+	if (replay.live_bytes > replay.peak_bytes)
+		replay.peak_bytes = replay.live_bytes;
+
+	if (++replay.fit_live[a->fit] > replay.fit_peak[a->fit])
+		replay.fit_peak[a->fit] = replay.fit_live[a->fit];
+
+	pages = POOL0_NUM - freepage_num[0];
+	if (pages > replay.page_peak)
+		replay.page_peak = pages;
+	if (sys_meminfo.alloc_size > replay.buddy_peak)
+		replay.buddy_peak = sys_meminfo.alloc_size;
+}
+
+static void replay_free(unsigned int id)
+{
+	struct trace_alloc *a = trace_get(id);
+
+	if (!a->live) {
+		CHECK(0, "id %u freed but not allocated", id);
+		return;
+	}
+
+	if (a->slab_ptr)
+		mem_slabs_free(slabs(), a->slab_ptr);
+	if (a->page_ptr)
+		mem_page_free(a->page_ptr, NULL);
+
+	a->live = 0;
+	replay.free++;
+	replay.live_bytes -= a->size;
+	replay.fit_live[a->fit]--;
+}
+
+static int replay_trace(const char *path)
+{
+	char line[128];
+	unsigned int id, size;
+	void *caller;
+	FILE *fp;
+
+	fp = fopen(path, "r");
+	if (!fp) {
+		printf("FAIL: can not open %s\n", path);
+		return -1;
+	}
+
+	while (fgets(line, sizeof(line), fp)) {
+		if (sscanf(line, "m %u %u %p", &id, &size, &caller) == 3)
+			replay_alloc(id, size, caller);
+		else if (sscanf(line, "f %u", &id) == 1)
+			replay_free(id);
+		else if (line[0] != '#' && line[0] != '\n')
+			CHECK(0, "bad line: %s", line);
+	}
+
+	fclose(fp);
+	return 0;
+}
+
+static uint32_t stat_buf[1024];
+
+/* snapshot counters must match what the replay did */
+static void check_stat(void)
+{
+	struct mem_stat_head *head = (struct mem_stat_head *)stat_buf;
+	struct mem_slab_class_stat *classes;
+	struct mem_slab_caller_stat *callers;
+	unsigned int alloc = 0, free = 0, fail, caller_alloc = 0, caller_fail = 0;
+	int len, i;
+
+	len = mem_slabs_get_stat(slabs(), stat_buf, sizeof(stat_buf));
+	CHECK(len > 0, "get stat %d", len);
+	if (len <= 0)
+		return;
+
+	CHECK(mem_slabs_get_stat(slabs(), stat_buf, len - 1) == -ENOMEM, "short buffer");
+	mem_slabs_get_stat(slabs(), stat_buf, sizeof(stat_buf));
+
+	classes = (struct mem_slab_class_stat *)(head + 1);
+	callers = (struct mem_slab_caller_stat *)(classes + head->class_num);
+	fail = head->oversize_cnt;
+
+	for (i = 0; i < head->class_num; i++) {
+		alloc += classes[i].alloc_cnt;
+		free += classes[i].free_cnt;
+		fail += classes[i].fail_cnt;
+		CHECK(classes[i].alloc_cnt - classes[i].free_cnt == classes[i].used,
+		      "class %d used %u", i, classes[i].used);
+	}
+
+	for (i = 0; i < head->caller_num; i++) {
+		caller_alloc += callers[i].alloc_cnt;
+		caller_fail += callers[i].fail_cnt;
+	}
+
+	CHECK(alloc == replay.alloc - replay.slab_fail, "alloc %u", alloc);
+	CHECK(free == replay.alloc - replay.slab_fail, "free %u", free);
+	CHECK(fail == replay.slab_fail, "fail %u of %u", fail, replay.slab_fail);
+	CHECK(caller_alloc + caller_fail + head->caller_miss == replay.alloc,
+	      "caller %u + %u + miss %u", caller_alloc, caller_fail, head->caller_miss);
+}
+
+/*
+ * need is the peak of live allocations whose best fit is the class, the
+ * blocks the class needs so that no allocation spills or fails.
+ */
+static void report(const char *path)
+{
+	struct mem_stat_head *head = (struct mem_stat_head *)stat_buf;
+	struct mem_slab_class_stat *classes = (struct mem_slab_class_stat *)(head + 1);
+	unsigned int total = 0, peak = 0, need = 0;
+	int i;
+
+	printf("%s: %u allocs, peak %u bytes\n", path, replay.alloc, replay.peak_bytes);
+	printf(" class size  num  max  fail spill  need\n");
+
+	for (i = 0; i < head->class_num; i++) {
+		printf(" %5d %4u %4u %4u %5u %5u %5u\n", i, classes[i].block_size,
+		       classes[i].block_num, classes[i].max_used, classes[i].fail_cnt,
+		       classes[i].spill_cnt, replay.fit_peak[i]);
+		total += classes[i].block_size * classes[i].block_num;
+		peak += classes[i].block_size * classes[i].max_used;
+		need += classes[i].block_size * replay.fit_peak[i];
+	}
+
+	printf(" slab: %u bytes, peak %u, %u fails, %u oversize;"
+	       " SLAB_TOTAL_SIZE without fails %u\n", total, peak, replay.slab_fail,
+	       head->oversize_cnt, need);
+	printf(" page buddy: peak %u of %u pages, %u bytes, %u fails\n",
+	       replay.page_peak, (unsigned int)POOL0_NUM, replay.buddy_peak, replay.page_fail);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int id;
+
+	if (argc != 2) {
+		printf("usage: mem_trace <trace>\n");
+		return 1;
+	}
+
+	slabs_mem_init(slabs());
+	mem_page_init();
+
+	if (replay_trace(argv[1]))
+		return 1;
+
+	/* free what the trace leaves allocated, both allocators must be empty */
+	for (id = 0; id < alloc_max; id++) {
+		if (allocs[id].live)
+			replay_free(id);
+	}
+
+	for (int i = 0; i < slabs()->slab_num; i++)
+		CHECK(!k_mem_slab_num_used_get(slabs()->slabs[i].slab), "slab %d not empty", i);
+	CHECK(sys_meminfo.alloc_size == 0, "buddy %u bytes left", sys_meminfo.alloc_size);
+	CHECK(freepage_num[0] == POOL0_NUM, "%u pages free", freepage_num[0]);
+	CHECK(host_panic_cnt == replay.page_fail, "%d buddy panics", host_panic_cnt);
+
+	check_stat();
+	report(argv[1]);
+
+	if (failures) {
+		printf("mem_trace: %d failures\n", failures);
+		return 1;
+	}
+
+	printf("mem_trace: OK\n");
+	return 0;
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the OS API, the part of the real header the wrapper needs */
+
+#ifndef __HOST_OS_COMMON_API_H__
+#define __HOST_OS_COMMON_API_H__
+
+#include <zephyr.h>
+
+#define OS_FOREVER		(-1)
+#define OS_NO_WAIT		(0)
+#define OS_ANY			K_ANY
+
+typedef struct k_mutex		os_mutex;
+typedef struct k_sem		os_sem;
+typedef struct k_condvar	os_condvar;
+typedef struct k_delayed_work	os_delayed_work;
+typedef struct k_work_q		os_work_q;
+typedef struct k_msgq		os_msgq;
+typedef struct k_fifo		os_fifo;
+typedef struct k_thread		os_thread;
+typedef k_thread_stack_t	os_thread_stack_t;
+typedef k_tid_t			os_tid_t;
+
+#define os_sem_init(sem, initial_count, limit)	k_sem_init(sem, initial_count, limit)
+#define os_sem_give(sem)			k_sem_give(sem)
+#define os_sem_reset(sem)			k_sem_reset(sem)
+#define os_sched_lock()				k_sched_lock()
+#define os_sched_unlock()			k_sched_unlock()
+#define os_current_get()			k_current_get()
+
+int os_sem_take(os_sem *sem, s32_t timeout);
+int os_mutex_lock(os_mutex *mutex, s32_t timeout);
+int os_condvar_wait(os_condvar *condvar, os_mutex *mutex, s32_t timeout);
+s32_t os_sleep(int timeout);
+int os_delayed_work_submit_to_queue(os_work_q *work_q, os_delayed_work *work, s32_t delay);
+int os_delayed_work_submit(os_delayed_work *work, s32_t delay);
+void *os_fifo_get(os_fifo *fifo, int32_t timeout);
+int os_msgq_put(os_msgq *msgq, const void *data, int32_t timeout);
+int os_msgq_get(os_msgq *msgq, void *data, int32_t timeout);
+bool os_is_in_isr(void);
+void os_printk(const char *fmt, ...);
+
+int os_thread_create(char *stack, size_t stack_size,
+		void (*entry)(void *, void *, void*),
+		void *p1, void *p2, void *p3,
+		int prio, u32_t options, int delay);
+int os_thread_prepare_terminal(int tid);
+int os_thread_wait_terminal(int tid);
+
+#define MSG_MEM_SIZE (4 * 4)
+
+int msg_pool_get_free_msg_num(void);
+void msg_pool_dump(void(*dump_fn)(os_tid_t sender, os_tid_t receiver,
+		const char *content, int max_size));
+int os_send_async_msg(void *receiver, void *msg, int msg_size);
+
+#define OS_MSG_URGENT	BIT(0)
+
+int os_send_async_msg_ext(void *receiver, void *msg, int msg_size,
+		uint32_t flags, uint16_t key);
+int os_receive_msg(void *msg, int msg_size,int timeout);
+int os_get_pending_msg_cnt(void);
+int os_get_target_pending_msg_cnt(os_tid_t receiver);
+void os_msg_clean(void);
+void os_msg_init(void);
+
+#ifdef HOST_LOG
+#define SYS_LOG_ERR(fmt, ...)	printf("E %s: " fmt "\n", __func__, ##__VA_ARGS__)
+#define SYS_LOG_WRN(fmt, ...)	printf("W %s: " fmt "\n", __func__, ##__VA_ARGS__)
+#else
+#define SYS_LOG_ERR(...)	do { } while (0)
+#define SYS_LOG_WRN(...)	do { } while (0)
+#endif
+#define SYS_LOG_INF(...)	do { } while (0)
+#define SYS_LOG_DBG(...)	do { } while (0)
+
+#endif
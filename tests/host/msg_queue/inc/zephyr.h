@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * host stub of the kernel API used by the OS wrapper, threads are pthreads
+ * and the irq lock is one global mutex
+ */
+
+#ifndef __HOST_ZEPHYR_H__
+#define __HOST_ZEPHYR_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+
+typedef uint8_t u8_t;
+typedef uint16_t u16_t;
+typedef uint32_t u32_t;
+typedef int32_t s32_t;
+
+#define BIT(n)			(1UL << (n))
+#define IS_ENABLED(config)	0
+#define __ASSERT(cond, ...)	do { } while (0)
+#define SYS_TIMEOUT_MS(ms)	(ms)
+#define K_ANY			NULL
+
+#define printk			printf
+#define vprintk			vprintf
+#define log_printk		vprintf
+
+struct k_thread {
+	struct k_thread *next_thread;
+	pthread_t pthread;
+	void (*entry)(void *, void *, void *);
+	void *p1, *p2, *p3;
+	int prio;
+};
+
+typedef struct k_thread *k_tid_t;
+typedef char k_thread_stack_t;
+
+struct k_sem {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	unsigned int count;
+	unsigned int limit;
+};
+
+struct k_mutex {
+	pthread_mutex_t mutex;
+};
+
+struct k_condvar { int unused; };
+struct k_msgq { int unused; };
+struct k_fifo { int unused; };
+struct k_work_q { int unused; };
+struct k_delayed_work { int unused; };
+
+struct z_kernel {
+	struct k_thread *threads;
+};
+
+extern struct z_kernel _kernel;
+
+k_tid_t k_thread_create(struct k_thread *thread, k_thread_stack_t *stack, size_t stack_size,
+		void (*entry)(void *, void *, void *), void *p1, void *p2, void *p3,
+		int prio, uint32_t options, int delay);
+int k_thread_join(struct k_thread *thread, int timeout);
+k_tid_t k_current_get(void);
+
+void k_sem_init(struct k_sem *sem, unsigned int count, unsigned int limit);
+int k_sem_take(struct k_sem *sem, int timeout);
+void k_sem_give(struct k_sem *sem);
+void k_sem_reset(struct k_sem *sem);
+
+unsigned int irq_lock(void);
+void irq_unlock(unsigned int key);
+
+static inline bool k_is_in_isr(void) { return false; }
+static inline void k_sched_lock(void) { }
+static inline void k_sched_unlock(void) { }
+static inline int k_thread_priority_get(k_tid_t thread) { return thread->prio; }
+static inline const char *k_thread_name_get(k_tid_t thread) { return "host"; }
+
+static inline int32_t k_sleep(int ms)
+{
+	usleep(ms * 1000);
+	return 0;
+}
+
+static inline int k_mutex_lock(struct k_mutex *mutex, int timeout)
+{
+	return pthread_mutex_lock(&mutex->mutex);
+}
+
+/* not used by the message functions */
+static inline int k_condvar_wait(struct k_condvar *condvar, struct k_mutex *mutex, int timeout) { return -ENOSYS; }
+static inline int k_delayed_work_submit(struct k_delayed_work *work, int delay) { return -ENOSYS; }
+static inline int k_delayed_work_submit_to_queue(struct k_work_q *work_q, struct k_delayed_work *work, int delay) { return -ENOSYS; }
+static inline void *k_fifo_get(struct k_fifo *fifo, int timeout) { return NULL; }
+static inline int k_msgq_put(struct k_msgq *msgq, const void *data, int timeout) { return -ENOSYS; }
+static inline int k_msgq_get(struct k_msgq *msgq, void *data, int timeout) { return -ENOSYS; }
+
+#endif
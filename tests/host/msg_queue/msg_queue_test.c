@@ -0,0 +1,567 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief test, stress test and benchmark of the per receiver message queues
+ *
+ * The real OS wrapper runs on pthread stubs of the kernel with a pool of 40
+ * messages and 16 queues. The single threaded cases switch the current
+ * thread between fake threads and check:
+ * - messages sent to a thread before its first receive are delivered in
+ *   order, urgent ones first, and no queue is taken for them;
+ * - sends to many threads which never receive leave the queues to the
+ *   receivers;
+ * - more threads than queues can receive, as the queue of an idle thread
+ *   with nothing pending is taken over;
+ * - the urgent reserve and the coalescing, also of unclaimed messages;
+ * - a terminated thread gets its queue and pending messages freed;
+ * - os_msg_clean returns every message to the pool.
+ *
+ * The stress runs exchange messages between threads polling their queue,
+ * first as many threads as queues then more, and check that every message
+ * arrives in order per sender. A last run has receivers blocked on their
+ * queue while two threads send to them and to OS_ANY.
+ *
+ * Usage: msg_queue_test [messages per thread, default 20000]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sched.h>
+#include <os_common_api.h>
+
+#define POOL_SIZE	40
+#define QUEUE_NUM	16
+#define MAX_THREADS	32
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) \
+	do { \
+		if (!(cond)) { \
+			if (failures++ < 20) \
+				printf("FAIL %s:%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__); \
+		} \
+	} while (0)
+
+/* kernel stubs */
+struct z_kernel _kernel;
+
+static struct k_thread main_thread;
+static __thread struct k_thread *current_thread;
+static pthread_mutex_t irq_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+unsigned int irq_lock(void)
+{
+	pthread_mutex_lock(&irq_mutex);
+	return 0;
+}
+
+void irq_unlock(unsigned int key)
+{
+	pthread_mutex_unlock(&irq_mutex);
+}
+
+k_tid_t k_current_get(void)
+{
+	return current_thread ? current_thread : &main_thread;
+}
+
+static void *thread_entry(void *arg)
+{
+	struct k_thread *thread = arg;
+
+	current_thread = thread;
+	thread->entry(thread->p1, thread->p2, thread->p3);
+	return NULL;
+}
+
+k_tid_t k_thread_create(struct k_thread *thread, k_thread_stack_t *stack, size_t stack_size,
+		void (*entry)(void *, void *, void *), void *p1, void *p2, void *p3,
+		int prio, uint32_t options, int delay)
+{
+	thread->entry = entry;
+	thread->p1 = p1;
+	thread->p2 = p2;
+	thread->p3 = p3;
+	thread->prio = prio;
+	pthread_create(&thread->pthread, NULL, thread_entry, thread);
+	return thread;
+}
+
+int k_thread_join(struct k_thread *thread, int timeout)
+{
+	return pthread_join(thread->pthread, NULL);
+}
+
+void k_sem_init(struct k_sem *sem, unsigned int count, unsigned int limit)
+{
+	pthread_mutex_init(&sem->mutex, NULL);
+	pthread_cond_init(&sem->cond, NULL);
+	sem->count = count;
+	sem->limit = limit;
+}
+
+int k_sem_take(struct k_sem *sem, int timeout)
+{
+	struct timespec ts;
+	int res = 0;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	if (timeout > 0) {
+		ts.tv_sec += timeout / 1000;
+		ts.tv_nsec += (timeout % 1000) * 1000000L;
+		if (ts.tv_nsec >= 1000000000L) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000L;
+		}
+	}
+
+	pthread_mutex_lock(&sem->mutex);
+	while (sem->count == 0 && !res) {
+		if (timeout == OS_FOREVER)
+			pthread_cond_wait(&sem->cond, &sem->mutex);
+		else if (timeout == OS_NO_WAIT || pthread_cond_timedwait(&sem->cond, &sem->mutex, &ts))
+			res = -EAGAIN;
+	}
+	if (!res)
+		sem->count--;
+	pthread_mutex_unlock(&sem->mutex);
+
+	return res;
+}
+
+void k_sem_give(struct k_sem *sem)
+{
+	pthread_mutex_lock(&sem->mutex);
+	if (sem->count < sem->limit)
+		sem->count++;
+	pthread_cond_signal(&sem->cond);
+	pthread_mutex_unlock(&sem->mutex);
+}
+
+void k_sem_reset(struct k_sem *sem)
+{
+	pthread_mutex_lock(&sem->mutex);
+	sem->count = 0;
+	pthread_mutex_unlock(&sem->mutex);
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* message of the tests, MSG_MEM_SIZE bytes */
+struct test_msg {
+	uint32_t from;
+	uint32_t value;
+	uint64_t time;
+};
+
+/* threads of the single threaded cases, only their address is used */
+static struct k_thread fake[64];
+
+static void set_current(struct k_thread *thread)
+{
+	current_thread = thread;
+}
+
+static int send_value(struct k_thread *to, uint32_t value, uint32_t flags, uint16_t key)
+{
+	struct test_msg msg = { .value = value };
+
+	return os_send_async_msg_ext(to, &msg, sizeof(msg), flags, key);
+}
+
+/* receive the values pending for thread, -1 ends expect */
+static void expect_values(struct k_thread *thread, const int *expect)
+{
+	struct test_msg msg;
+	int i, res;
+
+	set_current(thread);
+	for (i = 0; expect[i] >= 0; i++) {
+		res = os_receive_msg(&msg, sizeof(msg), OS_NO_WAIT);
+		CHECK(res == 0 && msg.value == expect[i], "message %d: res %d value %u, expected %d",
+		      i, res, msg.value, expect[i]);
+	}
+
+	res = os_receive_msg(&msg, sizeof(msg), OS_NO_WAIT);
+	CHECK(res == -ETIMEDOUT, "res %d after the expected messages", res);
+	set_current(NULL);
+}
+
+static void test_send_before_receive(void)
+{
+	static const int expect[] = { 100, 0, 1, 2, -1 };
+	int i;
+
+	for (i = 0; i < 3; i++)
+		CHECK(send_value(&fake[0], i, 0, 0) == 0, "send %d", i);
+	CHECK(send_value(&fake[0], 100, OS_MSG_URGENT, 0) == 0, "urgent send");
+
+	CHECK(os_get_target_pending_msg_cnt(&fake[0]) == 4, "%d pending",
+	      os_get_target_pending_msg_cnt(&fake[0]));
+	CHECK(msg_pool_get_free_msg_num() == POOL_SIZE - 4, "%d free", msg_pool_get_free_msg_num());
+
+	expect_values(&fake[0], expect);
+	CHECK(msg_pool_get_free_msg_num() == POOL_SIZE, "%d free", msg_pool_get_free_msg_num());
+}
+
+/* threads which never receive must not take the queues */
+static void test_send_to_many(void)
+{
+	static const int expect[] = { 7, -1 };
+	struct test_msg msg;
+	int i, sent = 0;
+
+	for (i = 0; i < 32; i++)
+		sent += send_value(&fake[32 + i], i, 0, 0) == 0;
+	CHECK(sent == 32, "%d of 32 sent", sent);
+
+	for (i = 0; i < QUEUE_NUM; i++) {
+		set_current(&fake[i]);
+		CHECK(os_receive_msg(&msg, sizeof(msg), OS_NO_WAIT) == -ETIMEDOUT, "receiver %d", i);
+	}
+	set_current(NULL);
+
+	/* the receivers have a queue now */
+	CHECK(send_value(&fake[3], 7, 0, 0) == 0, "send");
+	expect_values(&fake[3], expect);
+
+	os_msg_clean();
+	CHECK(msg_pool_get_free_msg_num() == POOL_SIZE, "%d free after clean", msg_pool_get_free_msg_num());
+	CHECK(os_get_target_pending_msg_cnt(&fake[40]) == 0, "unclaimed not cleaned");
+}
+
+/* more receivers than queues, in turn and with pending messages */
+static void test_queue_reuse(void)
+{
+	static const int expect_one[] = { 1, -1 };
+	struct test_msg msg;
+	int i, res;
+
+	for (i = 0; i < 48; i++) {
+		set_current(&fake[i]);
+		res = os_receive_msg(&msg, sizeof(msg), OS_NO_WAIT);
+		CHECK(res == -ETIMEDOUT, "receiver %d: res %d", i, res);
+	}
+	set_current(NULL);
+
+	/* a queue with a pending message is kept */
+	for (i = 0; i < QUEUE_NUM; i++) {
+		set_current(&fake[i]);
+		os_receive_msg(&msg, sizeof(msg), OS_NO_WAIT);
+		set_current(NULL);
+		CHECK(send_value(&fake[i], 1, 0, 0) == 0, "send to %d", i);
+	}
+
+	set_current(&fake[QUEUE_NUM]);
+	res = os_receive_msg(&msg, sizeof(msg), OS_NO_WAIT);
+	CHECK(res == -ENOMEM, "res %d with all queues pending", res);
+
+	/* and reused once empty, the messages sent meanwhile are claimed */
+	set_current(NULL);
+	CHECK(send_value(&fake[QUEUE_NUM], 1, 0, 0) == 0, "send");
+	expect_values(&fake[0], expect_one);
+	expect_values(&fake[QUEUE_NUM], expect_one);
+
+	for (i = 1; i < QUEUE_NUM; i++)
+		expect_values(&fake[i], expect_one);
+
+	CHECK(msg_pool_get_free_msg_num() == POOL_SIZE, "%d free", msg_pool_get_free_msg_num());
+}
+
+static void test_urgent_and_coalesce(void)
+{
+	static const int expect_a[] = { 200, 0, 1, 15, 6, -1 };
+	static const int expect_b[] = { 9, -1 };
+	int i, sent = 0, urgent = 0;
+
+	/* coalescing keys of the unclaimed messages are per receiver */
+	send_value(&fake[50], 0, 0, 0);
+	send_value(&fake[50], 5, 0, 0x0c00);
+	send_value(&fake[51], 9, 0, 0x0c00);
+	send_value(&fake[50], 1, 0, 0);
+	send_value(&fake[50], 15, 0, 0x0c01);
+	send_value(&fake[50], 6, 0, 0x0c00);
+	send_value(&fake[50], 200, OS_MSG_URGENT, 0);
+	CHECK(os_get_target_pending_msg_cnt(&fake[50]) == 5, "%d pending",
+	      os_get_target_pending_msg_cnt(&fake[50]));
+
+	expect_values(&fake[50], expect_a);
+	expect_values(&fake[51], expect_b);
+
+	/* a flood of normal messages leaves the reserve to urgent ones */
+	for (i = 0; i < 100; i++)
+		sent += send_value(&fake[52 + (i & 1)], i, 0, 0) == 0;
+	for (i = 0; i < 5; i++)
+		urgent += send_value(&fake[52], 300 + i, OS_MSG_URGENT, 0) == 0;
+
+	CHECK(sent == POOL_SIZE - 2 && urgent == 2, "%d normal and %d urgent sent", sent, urgent);
+
+	os_msg_clean();
+	CHECK(msg_pool_get_free_msg_num() == POOL_SIZE, "%d free after clean", msg_pool_get_free_msg_num());
+}
+
+/* thread which receives one message and exits */
+static char thread_stacks[MAX_THREADS][sizeof(struct k_thread) + 256] __attribute__((aligned(8)));
+
+static void receive_one_entry(void *p1, void *p2, void *p3)
+{
+	struct test_msg msg;
+
+	CHECK(os_receive_msg(&msg, sizeof(msg), 1000) == 0 && msg.value == 1, "first message");
+}
+
+static void test_thread_exit(void)
+{
+	struct test_msg msg;
+	int tid, i, res;
+
+	tid = os_thread_create(thread_stacks[0], sizeof(thread_stacks[0]), receive_one_entry,
+			NULL, NULL, NULL, 5, 0, 0);
+	os_thread_prepare_terminal(tid);
+
+	for (i = 1; i <= 3; i++)
+		send_value((struct k_thread *)(uintptr_t)tid, i, 0, 0);
+
+	CHECK(os_thread_wait_terminal(tid) == 0, "terminal");
+	CHECK(msg_pool_get_free_msg_num() == POOL_SIZE, "%d free, messages of the exited thread left",
+	      msg_pool_get_free_msg_num());
+
+	/* and its queue is free, all other threads can have a queue */
+	for (i = 0; i < QUEUE_NUM; i++) {
+		send_value(&fake[i], 1, 0, 0);
+		set_current(&fake[i]);
+		res = os_receive_msg(&msg, sizeof(msg), OS_NO_WAIT);
+		res |= os_receive_msg(&msg, sizeof(msg), OS_NO_WAIT) != -ETIMEDOUT;
+		set_current(NULL);
+		CHECK(res == 0, "receiver %d", i);
+	}
+}
+
+/* threads exchanging messages */
+static int msgs_per_thread;
+static int stress_threads;
+static volatile long received;
+static volatile int stress_abort;
+static long send_retries, order_errors, nomem_retries;
+static double latency_sum, latency_max;
+static pthread_mutex_t stat_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void exchange_entry(void *p1, void *p2, void *p3)
+{
+	uint32_t id = (uintptr_t)p1;
+	uint32_t last[MAX_THREADS] = { 0 };
+	uint32_t seed = id * 7919 + 1;
+	struct test_msg msg;
+	double latency;
+	int sent = 0, to, res;
+	long retries = 0, errors = 0, nomem = 0;
+	uint64_t nomem_since = 0;
+
+	for (;;) {
+		/* service loop: drain the queue, then send one */
+		while ((res = os_receive_msg(&msg, sizeof(msg), OS_NO_WAIT)) == 0) {
+			latency = (now_ns() - msg.time) / 1000.0;
+			errors += msg.value <= last[msg.from];
+			last[msg.from] = msg.value;
+
+			pthread_mutex_lock(&stat_mutex);
+			latency_sum += latency;
+			if (latency > latency_max)
+				latency_max = latency;
+			received++;
+			pthread_mutex_unlock(&stat_mutex);
+		}
+
+		/* all queues hold pending messages, give up after a second */
+		if (res == -ENOMEM) {
+			nomem++;
+			if (!nomem_since)
+				nomem_since = now_ns();
+			else if (now_ns() - nomem_since > 1000000000ull)
+				stress_abort = 1;
+			if (stress_abort)
+				break;
+			sched_yield();
+			continue;
+		}
+		nomem_since = 0;
+
+		if (stress_abort) {
+			break;
+		} else if (sent < msgs_per_thread) {
+			seed = seed * 1103515245 + 12345;
+			to = (seed >> 8) % (stress_threads - 1);
+			if (to >= id)
+				to++;
+
+			msg.from = id;
+			msg.value = sent + 1;
+			msg.time = now_ns();
+			if (os_send_async_msg(thread_stacks[to], &msg, sizeof(msg)) == 0) {
+				sent++;
+			} else {
+				retries++;
+				sched_yield();
+			}
+		} else if (__atomic_load_n(&received, __ATOMIC_RELAXED) >= (long)stress_threads * msgs_per_thread) {
+			break;
+		} else {
+			sched_yield();
+		}
+	}
+
+	pthread_mutex_lock(&stat_mutex);
+	send_retries += retries;
+	order_errors += errors;
+	nomem_retries += nomem;
+	pthread_mutex_unlock(&stat_mutex);
+}
+
+static void run_exchange(int threads)
+{
+	int tids[MAX_THREADS];
+	uint64_t t;
+	int i;
+
+	stress_threads = threads;
+	received = 0;
+	stress_abort = 0;
+	send_retries = order_errors = nomem_retries = 0;
+	latency_sum = latency_max = 0;
+
+	t = now_ns();
+	for (i = 0; i < threads; i++) {
+		tids[i] = os_thread_create(thread_stacks[i], sizeof(thread_stacks[i]), exchange_entry,
+				(void *)(uintptr_t)i, NULL, NULL, 5, 0, 0);
+	}
+
+	/* more threads than terminal slots, their queues are left idle */
+	for (i = 0; i < threads; i++)
+		k_thread_join((struct k_thread *)(uintptr_t)tids[i], OS_FOREVER);
+	t = now_ns() - t;
+
+	printf("%2d threads, %2d queues: %7.0f msg/s, latency avg %5.0f us max %6.0f us, "
+	       "send retries %ld, no queue retries %ld\n", threads, QUEUE_NUM,
+	       received / (t / 1e9), received ? latency_sum / received : 0, latency_max, send_retries, nomem_retries);
+
+	CHECK(received == (long)threads * msgs_per_thread, "%ld of %d received",
+	      received, threads * msgs_per_thread);
+	CHECK(order_errors == 0, "%ld out of order", order_errors);
+	CHECK(msg_pool_get_free_msg_num() == POOL_SIZE, "%d free", msg_pool_get_free_msg_num());
+}
+
+/* receivers blocked on their queue, OS_ANY messages have a negative value */
+#define BLOCK_RECEIVERS	4
+#define BLOCK_SENDERS	2
+
+static long block_received[BLOCK_RECEIVERS], any_received, block_errors;
+static int block_tids[BLOCK_RECEIVERS];
+
+static void block_receiver_entry(void *p1, void *p2, void *p3)
+{
+	uint32_t id = (uintptr_t)p1;
+	struct test_msg msg;
+
+	while (os_receive_msg(&msg, sizeof(msg), 200) == 0) {
+		if (msg.from == (uint32_t)-1) {
+			__atomic_add_fetch(&any_received, 1, __ATOMIC_RELAXED);
+		} else {
+			block_errors += msg.from != id;
+			block_received[id]++;
+		}
+	}
+}
+
+static void block_sender_entry(void *p1, void *p2, void *p3)
+{
+	struct test_msg msg;
+	int i, to;
+
+	uint64_t t;
+
+	for (i = 0; i < msgs_per_thread; i++) {
+		to = i % BLOCK_RECEIVERS;
+		msg.from = (i % 100 == 0) ? (uint32_t)-1 : to;
+		msg.value = i;
+		/* the receivers take a message at least every 200 ms */
+		for (t = now_ns(); os_send_async_msg(msg.from == (uint32_t)-1 ? OS_ANY :
+				(void *)(uintptr_t)block_tids[to], &msg, sizeof(msg)); usleep(10)) {
+			if (now_ns() - t > 1000000000ull)
+				return;
+		}
+	}
+}
+
+static void run_blocking(void)
+{
+	int tids[BLOCK_SENDERS];
+	long total;
+	int i;
+
+	for (i = 0; i < BLOCK_RECEIVERS; i++) {
+		block_tids[i] = os_thread_create(thread_stacks[i], sizeof(thread_stacks[i]),
+				block_receiver_entry, (void *)(uintptr_t)i, NULL, NULL, 5, 0, 0);
+	}
+
+	usleep(10000);
+	for (i = 0; i < BLOCK_SENDERS; i++) {
+		tids[i] = os_thread_create(thread_stacks[BLOCK_RECEIVERS + i],
+				sizeof(thread_stacks[0]), block_sender_entry, NULL, NULL, NULL, 5, 0, 0);
+	}
+
+	for (i = 0; i < BLOCK_SENDERS; i++)
+		k_thread_join((struct k_thread *)(uintptr_t)tids[i], OS_FOREVER);
+	for (i = 0; i < BLOCK_RECEIVERS; i++)
+		k_thread_join((struct k_thread *)(uintptr_t)block_tids[i], OS_FOREVER);
+
+	for (i = 0, total = any_received; i < BLOCK_RECEIVERS; i++)
+		total += block_received[i];
+
+	printf("%d blocking receivers, %d senders: %ld of %d delivered, %ld to OS_ANY\n",
+	       BLOCK_RECEIVERS, BLOCK_SENDERS, total, BLOCK_SENDERS * msgs_per_thread, any_received);
+
+	CHECK(total == BLOCK_SENDERS * msgs_per_thread && !block_errors,
+	      "%ld delivered, %ld to the wrong receiver", total, block_errors);
+	CHECK(msg_pool_get_free_msg_num() == POOL_SIZE, "%d free", msg_pool_get_free_msg_num());
+}
+
+int main(int argc, char *argv[])
+{
+	msgs_per_thread = argc > 1 ? atoi(argv[1]) : 20000;
+
+	os_msg_init();
+
+	test_send_before_receive();
+	test_send_to_many();
+	test_queue_reuse();
+	test_urgent_and_coalesce();
+	test_thread_exit();
+	os_msg_clean();
+
+	run_exchange(QUEUE_NUM);
+	run_exchange(24);
+	run_blocking();
+
+	if (failures) {
+		printf("msg_queue: %d failures\n", failures);
+		return 1;
+	}
+
+	printf("msg_queue: OK\n");
+	return 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * RAM flash stand-in of the nvram storage driver
+ *
+ * Programming can only clear bits like NOR flash, erasing sets a whole
+ * sector to 0xff. Power failure is injected by counting byte programs
+ * and sector erases.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <kernel.h>
+#include "flash_sim.h"
+
+struct flash_sim_stat flash_sim_stat;
+
+static uint8_t flash_mem[FLASH_SIM_SIZE];
+static struct device flash_dev = { .name = "flash_sim" };
+static long fail_ops = -1;
+static jmp_buf *fail_env;
+static int write_errors;
+
+void flash_sim_reset(void)
+{
+	memset(flash_mem, 0xff, sizeof(flash_mem));
+	memset(&flash_sim_stat, 0, sizeof(flash_sim_stat));
+	fail_ops = -1;
+	write_errors = 0;
+}
+
+void flash_sim_power_fail_after(long ops, jmp_buf *env)
+{
+	fail_ops = ops;
+	fail_env = env;
+}
+
+void flash_sim_power_fail_cancel(void)
+{
+	fail_ops = -1;
+}
+
+void flash_sim_write_error(int cnt)
+{
+	write_errors = cnt;
+}
+
+static int flash_sim_op(void)
+{
+	if (fail_ops < 0)
+		return 0;
+
+	if (fail_ops-- == 0) {
+		fail_ops = -1;
+		return 1;
+	}
+
+	return 0;
+}
+
+struct device *nvram_storage_init(void)
+{
+	return &flash_dev;
+}
+
+int nvram_storage_read(struct device *dev, uint32_t addr, void *buf, int32_t size)
+{
+	if (addr + size > FLASH_SIM_SIZE)
+		return -EINVAL;
+
+	flash_sim_stat.read_cnt++;
+	flash_sim_stat.read_bytes += size;
+	memcpy(buf, &flash_mem[addr], size);
+
+	return 0;
+}
+
+int nvram_storage_write(struct device *dev, uint32_t addr, const void *buf, int32_t size)
+{
+	const uint8_t *p = buf;
+	int i;
+
+	if (addr + size > FLASH_SIM_SIZE)
+		return -EINVAL;
+
+	if (write_errors > 0) {
+		write_errors--;
+		return -EIO;
+	}
+
+	flash_sim_stat.write_cnt++;
+	for (i = 0; i < size; i++) {
+		if (flash_sim_op()) {
+			/* torn byte, only some bits are programmed */
+			flash_mem[addr + i] &= p[i] | 0x0f;
+			longjmp(*fail_env, 1);
+		}
+		flash_mem[addr + i] &= p[i];
+	}
+
+	return 0;
+}
+
+int nvram_storage_erase(struct device *dev, uint32_t addr, int32_t size)
+{
+	uint32_t offs;
+
+	if (addr + size > FLASH_SIM_SIZE || (addr % FLASH_SIM_SECTOR_SIZE))
+		return -EINVAL;
+
+	flash_sim_stat.erase_cnt++;
+	for (offs = addr; offs < addr + size; offs += FLASH_SIM_SECTOR_SIZE) {
+		if (flash_sim_op()) {
+			/* half erased sector */
+			memset(&flash_mem[offs], 0xff, FLASH_SIM_SECTOR_SIZE / 2);
+			longjmp(*fail_env, 1);
+		}
+		memset(&flash_mem[offs], 0xff, FLASH_SIM_SECTOR_SIZE);
+	}
+
+	return 0;
+}
@@ -0,0 +1,37 @@
+/*
+ * RAM flash stand-in of the nvram storage driver
+ */
+
+#ifndef __FLASH_SIM_H__
+#define __FLASH_SIM_H__
+
+#include <stdint.h>
+#include <setjmp.h>
+
+#define FLASH_SIM_SIZE		0x10000
+#define FLASH_SIM_SECTOR_SIZE	0x1000
+
+struct flash_sim_stat {
+	/* nvram_storage_read() calls and bytes */
+	uint32_t read_cnt;
+	uint32_t read_bytes;
+	uint32_t write_cnt;
+	uint32_t erase_cnt;
+};
+
+extern struct flash_sim_stat flash_sim_stat;
+
+/* erase all flash */
+void flash_sim_reset(void);
+
+/**
+ * cut power after ops more byte programs or sector erases, then longjmp
+ * to env; the interrupted byte or sector is left partly programmed
+ */
+void flash_sim_power_fail_after(long ops, jmp_buf *env);
+void flash_sim_power_fail_cancel(void);
+
+/* make next write fail with -EIO */
+void flash_sim_write_error(int cnt);
+
+#endif /* __FLASH_SIM_H__ */
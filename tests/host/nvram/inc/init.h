@@ -0,0 +1 @@
+#define SYS_INIT(fn, level, prio)
@@ -0,0 +1,111 @@
+/*
+ * Host stub of the kernel interfaces used by the nvram driver
+ */
+
+#ifndef __HOST_KERNEL_H__
+#define __HOST_KERNEL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <errno.h>
+
+#define __packed		__attribute__((packed))
+#define __aligned(x)		__attribute__((aligned(x)))
+#define __act_s2_notsave
+#define ARG_UNUSED(x)		(void)(x)
+#define ARRAY_SIZE(a)		(sizeof(a) / sizeof((a)[0]))
+#define MIN(a, b)		((a) < (b) ? (a) : (b))
+#define ROUND_UP(x, a)		((((unsigned long)(x) + ((unsigned long)(a) - 1)) / \
+				  (unsigned long)(a)) * (unsigned long)(a))
+#define BUILD_ASSERT(e, m)	_Static_assert(e, m)
+#define BITS_PER_LONG		32
+#define printk			printf
+
+static inline unsigned int find_lsb_set(uint32_t op)
+{
+	return __builtin_ffs(op);
+}
+
+#define K_FOREVER		(-1)
+#define K_NO_WAIT		0
+
+struct device {
+	const char *name;
+};
+
+/* threads are simulated by the test switching the current id */
+typedef void *k_tid_t;
+extern k_tid_t host_current_tid;
+
+static inline k_tid_t k_current_get(void)
+{
+	return host_current_tid;
+}
+
+#define k_thread_name_set(t, n)
+#define k_busy_wait(us)
+
+/* single threaded host, a semaphore only counts */
+struct k_sem {
+	int count;
+	int limit;
+};
+
+#define K_SEM_DEFINE(name, init, lim) \
+	struct k_sem name = { .count = (init), .limit = (lim) }
+
+static inline int k_sem_take(struct k_sem *sem, int timeout)
+{
+	if (sem->count <= 0) {
+		printf("BUG! k_sem_take would block\n");
+		return -EBUSY;
+	}
+	sem->count--;
+	return 0;
+}
+
+static inline void k_sem_give(struct k_sem *sem)
+{
+	if (sem->count < sem->limit)
+		sem->count++;
+}
+
+/* work items are run by the test with host_work_run() */
+struct k_work;
+typedef void (*k_work_handler_t)(struct k_work *work);
+
+struct k_work {
+	k_work_handler_t handler;
+	int pending;
+};
+
+struct k_work_q {
+	int thread;
+};
+
+#define K_THREAD_STACK_DEFINE(name, size)	char name[size]
+#define K_THREAD_STACK_SIZEOF(name)		sizeof(name)
+
+static inline void k_work_init(struct k_work *work, k_work_handler_t handler)
+{
+	work->handler = handler;
+	work->pending = 0;
+}
+
+static inline void k_work_queue_start(struct k_work_q *q, void *stack,
+				      size_t size, int prio, void *cfg)
+{
+}
+
+extern struct k_work *host_pending_work;
+
+static inline int k_work_submit_to_queue(struct k_work_q *q, struct k_work *work)
+{
+	work->pending = 1;
+	host_pending_work = work;
+	return 0;
+}
+
+#endif /* __HOST_KERNEL_H__ */
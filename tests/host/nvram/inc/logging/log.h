@@ -0,0 +1,14 @@
+#include <stdio.h>
+
+#define LOG_MODULE_REGISTER(name)
+#define LOG_DBG(...)
+#define LOG_INF(...)
+
+/* errors are expected in the power fail test, build with -DHOST_LOG to see them */
+#ifdef HOST_LOG
+#define LOG_WRN(fmt, ...)	printf("W: " fmt "\n", ##__VA_ARGS__)
+#define LOG_ERR(fmt, ...)	printf("E: " fmt "\n", ##__VA_ARGS__)
+#else
+#define LOG_WRN(...)
+#define LOG_ERR(...)
+#endif
@@ -0,0 +1,11 @@
+#include <stdint.h>
+
+#define PARTITION_FILE_ID_NVRAM_FACTORY		1
+#define PARTITION_FILE_ID_NVRAM_USER		2
+
+struct partition_entry {
+	uint32_t offset;
+	uint32_t size;
+};
+
+const struct partition_entry *partition_get_part(uint8_t file_id);
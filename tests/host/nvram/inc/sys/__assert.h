@@ -0,0 +1,2 @@
+#include <assert.h>
+#define __ASSERT(test, fmt, ...)	assert(test)
@@ -0,0 +1,623 @@
+/*
+ * Copyright (c) 2017 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Host test of the nvram config driver
+ *
+ * The driver source is built into the test together with a RAM flash
+ * stand-in, so that the static region state can be checked directly.
+ * Every result is checked against a reference model of the configs.
+ */
+
+#include "../../../zephyr/drivers/nvram/nvram_config.c"
+
+#include <stdlib.h>
+#include "flash_sim.h"
+
+#define NUM_KEYS		32
+#define MAX_DATA_LEN		32
+
+k_tid_t host_current_tid = (k_tid_t)1;
+struct k_work *host_pending_work;
+
+static const struct partition_entry factory_part = { 0x0000, 0x2000 };
+static const struct partition_entry user_part = { 0x2000, 0x8000 };
+
+/* reference model: data length of each key, -1 if not set */
+static int ref_len[NUM_KEYS];
+static uint8_t ref_data[NUM_KEYS][MAX_DATA_LEN];
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) \
+	do { \
+		if (!(cond)) { \
+			printf("FAIL %s:%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__); \
+			failures++; \
+		} \
+	} while (0)
+
+const struct partition_entry *partition_get_part(uint8_t file_id)
+{
+	if (file_id == PARTITION_FILE_ID_NVRAM_FACTORY)
+		return &factory_part;
+	if (file_id == PARTITION_FILE_ID_NVRAM_USER)
+		return &user_part;
+
+	return NULL;
+}
+
+void print_buffer(const struct shell *shell, const char *addr, int width,
+		  int count, int linelen, unsigned long disp_addr)
+{
+}
+
+static void key_name(char *name, int key)
+{
+	/* mix of short and long names like the property names */
+	if (key % 3 == 0)
+		sprintf(name, "KEY%d", key);
+	else if (key % 3 == 1)
+		sprintf(name, "BT_MGR_KEY_%d_INFO", key);
+	else
+		sprintf(name, "AUDIO_POLICY_CONFIG_OF_KEY_%d_WITH_LONG_NAME", key);
+}
+
+/* power on: drop RAM state and rescan all regions from flash */
+static void nvram_reboot(void)
+{
+	/* power may be cut with the lock held */
+	nvram_lock.count = 1;
+#ifdef CONFIG_NVRAM_WRITE_JOURNAL
+	nvram_journal_len = 0;
+	nvram_batch_depth = 0;
+	nvram_batch_owner = NULL;
+	nvram_batch_lock.count = 1;
+#endif
+#ifdef CONFIG_NVRAM_DEFERRED_COMPACT
+	nvram_compact_write_offset = 0;
+	nvram_compact_init(NULL);
+#endif
+	host_pending_work = NULL;
+	host_current_tid = (k_tid_t)1;
+
+	nvram_config_init(NULL);
+}
+
+/* run one step of the pending work, return 0 if none */
+static int run_work(void)
+{
+	struct k_work *work = host_pending_work;
+
+	if (!work)
+		return 0;
+
+	host_pending_work = NULL;
+	work->pending = 0;
+	work->handler(work);
+
+	return 1;
+}
+
+static void nvram_format(void)
+{
+	flash_sim_reset();
+	nvram_reboot();
+	memset(ref_len, 0xff, sizeof(ref_len));
+}
+
+/* model is updated before the set, power may be cut in the middle */
+static int model_set(int key, int len)
+{
+	char name[64];
+	uint8_t data[MAX_DATA_LEN];
+	int old_len, i, ret;
+
+	key_name(name, key);
+	for (i = 0; i < len; i++)
+		data[i] = (uint8_t)rand();
+
+	old_len = ref_len[key];
+	ref_len[key] = len ? len : -1;
+	memcpy(ref_data[key], data, len);
+
+	ret = nvram_config_set(name, len ? data : NULL, len);
+	if (ret)
+		ref_len[key] = old_len;
+
+	return ret;
+}
+
+static void model_check_key(int key)
+{
+	char name[64];
+	uint8_t data[MAX_DATA_LEN];
+	int ret;
+
+	key_name(name, key);
+	ret = nvram_config_get(name, data, sizeof(data));
+	if (ref_len[key] < 0) {
+		CHECK(ret < 0, "%s deleted but get %d", name, ret);
+	} else {
+		CHECK(ret == ref_len[key], "%s len %d expected %d", name, ret, ref_len[key]);
+		if (ret == ref_len[key])
+			CHECK(!memcmp(data, ref_data[key], ret), "%s data mismatch", name);
+	}
+}
+
+static void model_check(void)
+{
+	int key;
+
+	for (key = 0; key < NUM_KEYS; key++)
+		model_check_key(key);
+}
+
+#ifdef CONFIG_NVRAM_HASH_INDEX
+/* index lookup must agree with the linear search for every key */
+static void index_check(struct region_info *region)
+{
+	struct nvram_item item;
+	char name[64];
+	int key, offs_index, offs_linear;
+
+	if (!region_index_valid(region))
+		return;
+
+	for (key = 0; key < NUM_KEYS; key++) {
+		key_name(name, key);
+		offs_index = region_find_item(region, name, &item);
+
+		region->index_overflow = 1;
+		offs_linear = region_find_item(region, name, &item);
+		region->index_overflow = 0;
+
+		CHECK(offs_index == offs_linear, "%s index 0x%x linear 0x%x",
+		      name, offs_index, offs_linear);
+	}
+}
+#else
+static void index_check(struct region_info *region)
+{
+}
+#endif
+
+static void test_basic(void)
+{
+	uint8_t data[16];
+	int ret;
+
+	nvram_format();
+
+	ret = nvram_config_get("NOT_EXIST", data, sizeof(data));
+	CHECK(ret == -ENOENT, "get missing config %d", ret);
+
+	CHECK(!nvram_config_set("BT_NAME", "earphone", 9), "set");
+	ret = nvram_config_get("BT_NAME", data, sizeof(data));
+	CHECK(ret == 9 && !memcmp(data, "earphone", 9), "get %d", ret);
+
+	/* shorter buffer gets the head of data */
+	ret = nvram_config_get("BT_NAME", data, 4);
+	CHECK(ret == 4 && !memcmp(data, "earp", 4), "get short %d", ret);
+
+	/* same data is not written again */
+	flash_sim_stat.write_cnt = 0;
+	CHECK(!nvram_config_set("BT_NAME", "earphone", 9), "set same");
+	CHECK(flash_sim_stat.write_cnt == 0, "same data written %u times",
+	      flash_sim_stat.write_cnt);
+
+	CHECK(!nvram_config_set("BT_NAME", "speaker", 8), "overwrite");
+	ret = nvram_config_get("BT_NAME", data, sizeof(data));
+	CHECK(ret == 8 && !memcmp(data, "speaker", 8), "get overwritten %d", ret);
+
+	CHECK(!nvram_config_set("BT_NAME", NULL, 0), "delete");
+	ret = nvram_config_get("BT_NAME", data, sizeof(data));
+	CHECK(ret == -ENOENT, "get deleted %d", ret);
+
+	CHECK(nvram_config_set(NULL, data, 1) == -EINVAL, "null name");
+	CHECK(nvram_config_set("BT_NAME", NULL, 1) == -EINVAL, "null data");
+
+	CHECK(!nvram_config_set("BT_NAME", "after_reboot", 13), "set");
+	nvram_reboot();
+	ret = nvram_config_get("BT_NAME", data, sizeof(data));
+	CHECK(ret == 13 && !memcmp(data, "after_reboot", 13), "get after reboot %d", ret);
+}
+
+/* names with the same 8 bit additive hash */
+static void test_hash_collision(void)
+{
+	static const char *names[] = { "AB_KEY", "BA_KEY", "KEY_AB", "KEY_BA", "YEK_AB", "_KEYAB" };
+	char data[8];
+	int i, ret;
+
+	nvram_format();
+
+	for (i = 0; i < ARRAY_SIZE(names); i++) {
+		CHECK(calc_hash((const uint8_t *)names[i], 7) == calc_hash((const uint8_t *)names[0], 7), "not colliding %s", names[i]);
+		data[0] = i;
+		CHECK(!nvram_config_set(names[i], data, 1), "set %s", names[i]);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(names); i++) {
+		ret = nvram_config_get(names[i], data, sizeof(data));
+		CHECK(ret == 1 && data[0] == i, "get %s %d %d", names[i], ret, data[0]);
+	}
+
+	CHECK(!nvram_config_set(names[2], NULL, 0), "delete");
+	for (i = 0; i < ARRAY_SIZE(names); i++) {
+		ret = nvram_config_get(names[i], data, sizeof(data));
+		if (i == 2)
+			CHECK(ret == -ENOENT, "get deleted %s %d", names[i], ret);
+		else
+			CHECK(ret == 1 && data[0] == i, "get %s %d %d", names[i], ret, data[0]);
+	}
+}
+
+/* random sets and deletes, through many segment purges and reboots */
+static void test_random(void)
+{
+	int i, key, len;
+	int seg_changes = 0;
+	uint32_t seg_offset;
+
+	nvram_format();
+	srand(1);
+
+	seg_offset = user_nvram_region.seg_offset;
+	for (i = 0; i < 40000; i++) {
+		key = rand() % NUM_KEYS;
+		len = (rand() % 8) ? 1 + rand() % MAX_DATA_LEN : 0;
+
+		CHECK(!model_set(key, len), "set key %d len %d", key, len);
+		model_check_key(key);
+
+		if (user_nvram_region.seg_offset != seg_offset) {
+			seg_offset = user_nvram_region.seg_offset;
+			seg_changes++;
+		}
+
+		if (i % 1000 == 999) {
+			index_check(&user_nvram_region);
+			model_check();
+			nvram_reboot();
+			model_check();
+			index_check(&user_nvram_region);
+		}
+
+		if (failures)
+			break;
+	}
+
+	CHECK(seg_changes > 10, "only %d segment purges", seg_changes);
+	printf("random: %d ops, %d segment purges\n", i, seg_changes);
+}
+
+/* flash reads of a lookup with all keys set */
+static void bench_lookup(void)
+{
+	char name[64];
+	uint8_t data[MAX_DATA_LEN];
+	uint32_t read_cnt, read_bytes;
+	int key, round, gets;
+
+	nvram_format();
+	srand(2);
+
+	for (key = 0; key < NUM_KEYS; key++)
+		model_set(key, 1 + rand() % MAX_DATA_LEN);
+
+	nvram_reboot();
+
+	/* a missing key scans to the end without index */
+	memset(&flash_sim_stat, 0, sizeof(flash_sim_stat));
+	gets = 0;
+	for (round = 0; round < 10; round++) {
+		for (key = 0; key < NUM_KEYS; key++) {
+			key_name(name, key);
+			nvram_config_get(name, data, sizeof(data));
+			gets++;
+		}
+	}
+	read_cnt = flash_sim_stat.read_cnt;
+	read_bytes = flash_sim_stat.read_bytes;
+
+	memset(&flash_sim_stat, 0, sizeof(flash_sim_stat));
+	nvram_config_get("MISSING_KEY", data, sizeof(data));
+
+	printf("lookup %s: %d keys, %.1f reads %.0f bytes per get, %u reads for missing key\n",
+#ifdef CONFIG_NVRAM_HASH_INDEX
+	       "index",
+#else
+	       "linear",
+#endif
+	       NUM_KEYS, (double)read_cnt / gets, (double)read_bytes / gets,
+	       flash_sim_stat.read_cnt);
+
+	model_check();
+}
+
+#ifdef CONFIG_NVRAM_WRITE_JOURNAL
+static void test_batch(void)
+{
+	uint8_t data[16];
+	uint32_t write_cnt;
+	int ret;
+
+	nvram_format();
+	CHECK(!nvram_config_set("C", "c", 2), "set");
+
+	CHECK(!nvram_config_batch_begin(), "begin");
+	write_cnt = flash_sim_stat.write_cnt;
+	CHECK(!nvram_config_set("A", "a1", 3), "set");
+	CHECK(!nvram_config_set("B", "b1", 3), "set");
+	CHECK(!nvram_config_set("A", "a2", 3), "set");
+	CHECK(!nvram_config_set("C", NULL, 0), "delete");
+	CHECK(flash_sim_stat.write_cnt == write_cnt, "batch written before commit");
+
+	ret = nvram_config_get("A", data, sizeof(data));
+	CHECK(ret == 3 && !memcmp(data, "a2", 3), "get journaled %d", ret);
+	ret = nvram_config_get("C", data, sizeof(data));
+	CHECK(ret == -ENOENT, "get deleted in journal %d", ret);
+
+	/* other thread sees committed configs only, and writes directly */
+	host_current_tid = (k_tid_t)2;
+	ret = nvram_config_get("A", data, sizeof(data));
+	CHECK(ret == -ENOENT, "other thread get not committed %d", ret);
+	ret = nvram_config_get("C", data, sizeof(data));
+	CHECK(ret == 2, "other thread get committed %d", ret);
+	CHECK(!nvram_config_set("B", "b2", 3), "other thread set");
+	CHECK(flash_sim_stat.write_cnt > write_cnt, "other thread set journaled");
+	CHECK(nvram_config_batch_commit() == -EPERM, "other thread commit");
+	host_current_tid = (k_tid_t)1;
+
+	/* set of other thread replaced the journaled one */
+	ret = nvram_config_get("B", data, sizeof(data));
+	CHECK(ret == 3 && !memcmp(data, "b2", 3), "get %d", ret);
+
+	/* nested batch commits at the outermost commit */
+	CHECK(!nvram_config_batch_begin(), "nested begin");
+	CHECK(!nvram_config_set("D", "d", 2), "set");
+	write_cnt = flash_sim_stat.write_cnt;
+	CHECK(!nvram_config_batch_commit(), "nested commit");
+	CHECK(flash_sim_stat.write_cnt == write_cnt, "nested commit written");
+
+	CHECK(!nvram_config_batch_commit(), "commit");
+	CHECK(nvram_config_batch_commit() == -EPERM, "commit without batch");
+
+	nvram_reboot();
+	ret = nvram_config_get("A", data, sizeof(data));
+	CHECK(ret == 3 && !memcmp(data, "a2", 3), "A after reboot %d", ret);
+	ret = nvram_config_get("B", data, sizeof(data));
+	CHECK(ret == 3 && !memcmp(data, "b2", 3), "B after reboot %d", ret);
+	ret = nvram_config_get("C", data, sizeof(data));
+	CHECK(ret == -ENOENT, "C after reboot %d", ret);
+	ret = nvram_config_get("D", data, sizeof(data));
+	CHECK(ret == 2, "D after reboot %d", ret);
+}
+
+static void test_write_error(void)
+{
+	static uint8_t big[400];
+	uint8_t data[16];
+	char name[16];
+	int i, ret;
+
+	nvram_format();
+	CHECK(!nvram_config_set("A", "a1", 3), "set");
+
+	/* failed write keeps the old config */
+	flash_sim_write_error(1);
+	ret = nvram_config_set("A", "a2", 3);
+	CHECK(ret == -EIO, "set with write error %d", ret);
+	ret = nvram_config_get("A", data, sizeof(data));
+	CHECK(ret == 3 && !memcmp(data, "a1", 3), "get after write error %d", ret);
+
+	/* commit reports the failed config and writes the others */
+	CHECK(!nvram_config_batch_begin(), "begin");
+	CHECK(!nvram_config_set("A", "a3", 3), "set");
+	CHECK(!nvram_config_set("B", "b1", 3), "set");
+	flash_sim_write_error(1);
+	ret = nvram_config_batch_commit();
+	CHECK(ret == -EIO, "commit with write error %d", ret);
+	ret = nvram_config_get("A", data, sizeof(data));
+	CHECK(ret == 3 && !memcmp(data, "a1", 3), "get after commit error %d", ret);
+	ret = nvram_config_get("B", data, sizeof(data));
+	CHECK(ret == 3 && !memcmp(data, "b1", 3), "get after commit error %d", ret);
+
+	/* valid configs fill the whole segment */
+	for (i = 0; i < 16; i++) {
+		sprintf(name, "BIG%d", i);
+		memset(big, i, sizeof(big));
+		ret = nvram_config_set(name, big, sizeof(big));
+		if (ret)
+			break;
+	}
+	CHECK(ret == -ENOSPC, "set to full segment %d", ret);
+
+	nvram_reboot();
+	for (i--; i >= 0; i--) {
+		sprintf(name, "BIG%d", i);
+		ret = nvram_config_get(name, big, sizeof(big));
+		CHECK(ret == sizeof(big) && big[0] == i && big[sizeof(big) - 1] == i,
+		      "%s after full %d", name, ret);
+	}
+}
+#endif
+
+#ifdef CONFIG_NVRAM_DEFERRED_COMPACT
+static void test_deferred_compact(void)
+{
+	struct region_info *region = &user_nvram_region;
+	uint32_t seg_offset, erase_cnt;
+	int steps = 0, i;
+
+	nvram_format();
+	srand(3);
+
+	/* fill the segment until compaction is queued */
+	seg_offset = region->seg_offset;
+	for (i = 0; !host_pending_work && i < 1000; i++)
+		CHECK(!model_set(rand() % NUM_KEYS, MAX_DATA_LEN), "set");
+
+	CHECK(host_pending_work, "no compaction queued");
+	CHECK(region->seg_offset == seg_offset, "purged inline");
+
+	/* dirty the next segment, so that it is erased by the work */
+	nvram_storage_write(region->storage, region->base_addr + region_next_seg_offset(region),
+			    "dirty", 5);
+
+	/* erase one sector per step */
+	erase_cnt = flash_sim_stat.erase_cnt;
+	while (run_work()) {
+		CHECK(flash_sim_stat.erase_cnt - erase_cnt <= 1, "step erased %u sectors",
+		      flash_sim_stat.erase_cnt - erase_cnt);
+		erase_cnt = flash_sim_stat.erase_cnt;
+		steps++;
+		model_check();
+	}
+
+	CHECK(region->seg_offset != seg_offset, "not compacted");
+	model_check();
+	nvram_reboot();
+	model_check();
+	printf("compact: %d steps\n", steps);
+}
+#endif
+
+#define MAX_BATCH_SETS		8
+
+/* configs set by the interrupted operation */
+static struct {
+	int key;
+	int len;
+	uint8_t data[MAX_DATA_LEN];
+} op_sets[MAX_BATCH_SETS];
+static int op_set_cnt;
+
+static int op_set_match(int key, int len, const uint8_t *data)
+{
+	int i;
+
+	for (i = 0; i < op_set_cnt; i++) {
+		if (op_sets[i].key == key && op_sets[i].len == len &&
+		    (len < 0 || !memcmp(op_sets[i].data, data, len)))
+			return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * Cut power at random flash operations of sets, batch commits and
+ * compaction steps. After reboot each config must have the value before
+ * the interrupted operation or one set by it (a batch is written in
+ * parts if it overflows the journal), committed configs are never lost.
+ */
+static void test_power_fail(void)
+{
+	static int old_len[NUM_KEYS];
+	static uint8_t old_data[NUM_KEYS][MAX_DATA_LEN];
+	static jmp_buf env;
+	char name[64];
+	uint8_t data[MAX_DATA_LEN];
+	volatile int power_fails = 0;
+	volatile int it;
+	int batch, n, j, key, ret;
+
+	nvram_format();
+	srand(4);
+
+	for (it = 0; it < 100000 && !failures; it++) {
+		memcpy(old_len, ref_len, sizeof(ref_len));
+		memcpy(old_data, ref_data, sizeof(ref_data));
+		op_set_cnt = 0;
+
+		if (rand() % 16 == 0)
+			flash_sim_power_fail_after(rand() % 400, &env);
+
+		if (setjmp(env)) {
+			power_fails++;
+			nvram_reboot();
+
+			for (key = 0; key < NUM_KEYS; key++) {
+				key_name(name, key);
+				ret = nvram_config_get(name, data, sizeof(data));
+				if (ret < 0)
+					ret = -1;
+
+				if (ret == ref_len[key] &&
+				    (ret < 0 || !memcmp(data, ref_data[key], ret)))
+					continue;
+
+				CHECK((ret == old_len[key] &&
+				       (ret < 0 || !memcmp(data, old_data[key], ret))) ||
+				      op_set_match(key, ret, data),
+				      "it %d: %s lost, len %d before %d after %d",
+				      (int)it, name, ret, old_len[key], ref_len[key]);
+
+				ref_len[key] = ret;
+				if (ret > 0)
+					memcpy(ref_data[key], data, ret);
+			}
+			continue;
+		}
+
+		if (rand() % 3 == 0)
+			run_work();
+
+		batch = 0;
+#ifdef CONFIG_NVRAM_WRITE_JOURNAL
+		batch = (rand() % 4 == 0);
+#endif
+		n = batch ? 1 + rand() % MAX_BATCH_SETS : 1;
+
+		if (batch)
+			nvram_config_batch_begin();
+
+		for (j = 0; j < n; j++) {
+			key = rand() % NUM_KEYS;
+			model_set(key, (rand() % 8) ? 1 + rand() % MAX_DATA_LEN : 0);
+
+			op_sets[op_set_cnt].key = key;
+			op_sets[op_set_cnt].len = ref_len[key];
+			memcpy(op_sets[op_set_cnt].data, ref_data[key], MAX_DATA_LEN);
+			op_set_cnt++;
+		}
+
+		if (batch)
+			CHECK(!nvram_config_batch_commit(), "commit");
+
+		flash_sim_power_fail_cancel();
+		model_check();
+	}
+
+	printf("power fail: %d ops, %d power failures\n", (int)it, power_fails);
+}
+
+int main(void)
+{
+	test_basic();
+	test_hash_collision();
+	test_random();
+	bench_lookup();
+#ifdef CONFIG_NVRAM_WRITE_JOURNAL
+	test_batch();
+	test_write_error();
+#endif
+#ifdef CONFIG_NVRAM_DEFERRED_COMPACT
+	test_deferred_compact();
+#endif
+	test_power_fail();
+
+	if (failures) {
+		printf("nvram: %d failures\n", failures);
+		return 1;
+	}
+
+	printf("nvram: OK\n");
+	return 0;
+}
@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the spp/ble stream of the bt manager */
+
+#ifndef __HOST_BT_MANAGER_H__
+#define __HOST_BT_MANAGER_H__
+
+#include <stream.h>
+
+struct sppble_stream_init_param {
+	uint8_t *spp_uuid;
+	void *gatt_attr;
+	uint8_t attr_size;
+	void *tx_chrc_attr;
+	void *tx_attr;
+	void *tx_ccc_attr;
+	void *rx_attr;
+	void *connect_cb;
+	s32_t read_timeout;
+	s32_t write_timeout;
+};
+
+io_stream_t sppble_stream_create(void *param);
+
+#endif
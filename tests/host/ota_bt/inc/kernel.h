@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the kernel and OS API used by the bluetooth OTA backend */
+
+#ifndef __HOST_KERNEL_H__
+#define __HOST_KERNEL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+typedef uint8_t u8_t;
+typedef uint16_t u16_t;
+typedef uint32_t u32_t;
+typedef int32_t s32_t;
+
+#define __aligned(x)		__attribute__((aligned(x)))
+#define ARRAY_SIZE(a)		(sizeof(a) / sizeof((a)[0]))
+#define CONTAINER_OF(ptr, type, field) \
+	((type *)(((char *)(ptr)) - offsetof(type, field)))
+#define Z_THREAD_MIN_STACK_ALIGN	8
+#define __ASSERT_NO_MSG(test)		do { } while (0)
+
+#ifdef HOST_LOG
+#define SYS_LOG_ERR(fmt, ...)	printf("E %s: " fmt "\n", __func__, ##__VA_ARGS__)
+#define SYS_LOG_WRN(fmt, ...)	printf("W %s: " fmt "\n", __func__, ##__VA_ARGS__)
+#define SYS_LOG_INF(fmt, ...)	printf("I %s: " fmt "\n", __func__, ##__VA_ARGS__)
+#else
+#define SYS_LOG_ERR(...)	do { } while (0)
+#define SYS_LOG_WRN(...)	do { } while (0)
+#define SYS_LOG_INF(...)	do { } while (0)
+#endif
+#define SYS_LOG_DBG(...)	do { } while (0)
+
+#define OS_FOREVER		(-1)
+#define OS_NO_WAIT		0
+
+typedef pthread_mutex_t os_mutex;
+typedef void *os_tid_t;
+
+typedef struct {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	unsigned int count;
+	unsigned int limit;
+} os_sem;
+
+static inline void os_mutex_init(os_mutex *mutex)
+{
+	pthread_mutex_init(mutex, NULL);
+}
+
+static inline int os_mutex_lock(os_mutex *mutex, int timeout)
+{
+	return pthread_mutex_lock(mutex);
+}
+
+static inline int os_mutex_unlock(os_mutex *mutex)
+{
+	return pthread_mutex_unlock(mutex);
+}
+
+static inline void os_sem_init(os_sem *sem, unsigned int count, unsigned int limit)
+{
+	pthread_mutex_init(&sem->mutex, NULL);
+	pthread_cond_init(&sem->cond, NULL);
+	sem->count = count;
+	sem->limit = limit;
+}
+
+static inline int os_sem_take(os_sem *sem, int timeout)
+{
+	pthread_mutex_lock(&sem->mutex);
+	while (!sem->count)
+		pthread_cond_wait(&sem->cond, &sem->mutex);
+	sem->count--;
+	pthread_mutex_unlock(&sem->mutex);
+	return 0;
+}
+
+static inline void os_sem_give(os_sem *sem)
+{
+	pthread_mutex_lock(&sem->mutex);
+	if (sem->count < sem->limit)
+		sem->count++;
+	pthread_cond_signal(&sem->cond);
+	pthread_mutex_unlock(&sem->mutex);
+}
+
+/* threads are implemented by the test */
+int os_thread_create(char *stack, size_t stack_size,
+		void (*entry)(void *, void *, void *),
+		void *p1, void *p2, void *p3, int prio, uint32_t options, int delay);
+void os_sleep(int ms);
+
+#define os_thread_name_set(tid, name)	do { } while (0)
+
+#endif
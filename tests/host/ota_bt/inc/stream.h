@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the stream API, the spp/ble stream is the test's link */
+
+#ifndef __HOST_STREAM_H__
+#define __HOST_STREAM_H__
+
+#include <kernel.h>
+
+typedef struct __stream *io_stream_t;
+
+#define MODE_IN_OUT		3
+
+int stream_open(io_stream_t handle, int mode);
+int stream_read(io_stream_t handle, void *buf, int num);
+int stream_write(io_stream_t handle, const void *buf, int num);
+int stream_tell(io_stream_t handle);
+int stream_close(io_stream_t handle);
+int stream_destroy(io_stream_t handle);
+
+#endif
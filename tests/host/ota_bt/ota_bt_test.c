@@ -0,0 +1,478 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief loopback test of the bluetooth OTA backend
+ *
+ * The spp/ble stream is a simulated link to a simulated host: the air
+ * time of each 256 byte unit and the latency of each image data request
+ * are waited in real time, and units are corrupted at a given rate. The
+ * test reads the image as the upgrade core does, the head first and then
+ * 4KB regions, with a simulated flash program time between the regions.
+ *
+ * Each case runs in its own process, since the backend keeps its state
+ * and window thread in statics. The sequential transfer (host with unit
+ * crc) and the windowed transfer (host with unit crc and window) must
+ * rebuild the image byte exact without corruption and at 0.5% corrupted
+ * units, the windowed one also at 5% by re-requesting the holes. The
+ * total OTA times are reported.
+ *
+ * Usage: ota_bt_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <kernel.h>
+#include <stream.h>
+#include <bt_manager.h>
+#include <crc.h>
+#include <ota_backend.h>
+#include <ota_backend_bt.h>
+
+#define HOST_FEATURE_UNIT_CRC	(1 << 0)
+#define HOST_FEATURE_WINDOW	(1 << 1)
+
+#define UNIT_SIZE		256
+#define UNIT_US			2000	/* air time of one unit */
+#define REQUEST_US		5000	/* device to host request latency */
+#define FLASH_US		15000	/* erase and program of 4KB */
+#define IMAGE_SIZE		(128 * 1024)
+#define REGION_SIZE		4096
+
+#define OTA_CMD_H2D_REQUEST_UPGRADE		0x01
+#define OTA_CMD_H2D_CONNECT_NEGOTIATION		0x02
+#define OTA_CMD_D2H_REQUIRE_IMAGE_DATA		0x03
+#define OTA_CMD_D2H_VALIDATE_IMAGE		0x06
+#define OTA_CMD_H2D_NEGOTIATION_RESULT		0x09
+#define OTA_CMD_H2D_SEND_IMAGE_DATA_WITH_CRC	0x0B
+
+#define SERVICE_ID_OTA		0x9
+#define TLV_TYPE_MAIN		0x80
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) \
+	do { \
+		if (!(cond)) { \
+			printf("FAIL %s:%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__); \
+			failures++; \
+		} \
+	} while (0)
+
+struct ota_case {
+	uint8_t features;
+	/* corrupted units per million */
+	int corrupt_ppm;
+	/* the sequential transfer gives up on the first bad unit */
+	bool may_fail;
+};
+
+/* result of a case, passed from the child process in its pipe */
+struct ota_result {
+	int err;
+	unsigned int time_ms;
+	int requests;
+	int max_outstanding;
+	int corrupted;
+};
+
+static const struct ota_case cases[] = {
+	{ HOST_FEATURE_UNIT_CRC, 0, false },
+	{ HOST_FEATURE_UNIT_CRC | HOST_FEATURE_WINDOW, 0, false },
+	{ HOST_FEATURE_UNIT_CRC, 5000, false },
+	{ HOST_FEATURE_UNIT_CRC | HOST_FEATURE_WINDOW, 5000, false },
+	{ HOST_FEATURE_UNIT_CRC, 50000, true },
+	{ HOST_FEATURE_UNIT_CRC | HOST_FEATURE_WINDOW, 50000, false },
+};
+
+static const struct ota_case *cur_case;
+static struct ota_result result;
+static uint8_t image[IMAGE_SIZE];
+
+static uint64_t now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+static void sleep_until(uint64_t t)
+{
+	uint64_t now = now_us();
+
+	if (t > now)
+		usleep(t - now);
+}
+
+struct thread_entry {
+	void (*entry)(void *, void *, void *);
+	void *p1, *p2, *p3;
+};
+
+static void *thread_main(void *arg)
+{
+	struct thread_entry *t = arg;
+
+	t->entry(t->p1, t->p2, t->p3);
+	return NULL;
+}
+
+int os_thread_create(char *stack, size_t stack_size,
+		void (*entry)(void *, void *, void *),
+		void *p1, void *p2, void *p3, int prio, uint32_t options, int delay)
+{
+	struct thread_entry *t = malloc(sizeof(*t));
+	pthread_t thread;
+
+	t->entry = entry;
+	t->p1 = p1;
+	t->p2 = p2;
+	t->p3 = p3;
+	if (pthread_create(&thread, NULL, thread_main, t))
+		return 0;
+
+	return 1;
+}
+
+void os_sleep(int ms)
+{
+	usleep(ms * 1000);
+}
+
+uint32_t utils_crc32(uint32_t crc, const uint8_t *ptr, int buf_len)
+{
+	int k;
+
+	crc = ~crc;
+	while (buf_len--) {
+		crc ^= *ptr++;
+		for (k = 0; k < 8; k++)
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+	}
+
+	return ~crc;
+}
+
+/* host to device direction of the link, read by the backend */
+static struct {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	uint8_t buf[1 << 20];
+	int rptr;
+	int wptr;
+} rx = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER };
+
+/* image data requests of the device, answered in order by the host */
+struct host_request {
+	uint32_t offset;
+	uint32_t len;
+	uint64_t due;
+};
+
+static struct {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	struct host_request reqs[1024];
+	int rptr;
+	int wptr;
+	int state;
+	bool done;
+} host = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER };
+
+io_stream_t sppble_stream_create(void *param)
+{
+	return (io_stream_t)&rx;
+}
+
+int stream_open(io_stream_t handle, int mode)
+{
+	return 0;
+}
+
+int stream_close(io_stream_t handle)
+{
+	return 0;
+}
+
+int stream_destroy(io_stream_t handle)
+{
+	return 0;
+}
+
+int stream_tell(io_stream_t handle)
+{
+	int len;
+
+	pthread_mutex_lock(&rx.mutex);
+	len = rx.wptr - rx.rptr;
+	pthread_mutex_unlock(&rx.mutex);
+
+	return len;
+}
+
+/* returns 0 after 2s without data, as the stream read timeout */
+int stream_read(io_stream_t handle, void *buf, int num)
+{
+	struct timespec ts;
+	int len;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	ts.tv_sec += 2;
+
+	pthread_mutex_lock(&rx.mutex);
+	while (rx.wptr == rx.rptr) {
+		if (pthread_cond_timedwait(&rx.cond, &rx.mutex, &ts)) {
+			pthread_mutex_unlock(&rx.mutex);
+			return 0;
+		}
+	}
+
+	len = rx.wptr - rx.rptr;
+	if (len > num)
+		len = num;
+	memcpy(buf, rx.buf + rx.rptr, len);
+	rx.rptr += len;
+	pthread_mutex_unlock(&rx.mutex);
+
+	return len;
+}
+
+/* commands of the device to the host */
+int stream_write(io_stream_t handle, const void *buf, int num)
+{
+	const uint8_t *p = buf;
+	struct host_request *req;
+
+	pthread_mutex_lock(&host.mutex);
+
+	switch (p[1]) {
+	case OTA_CMD_D2H_REQUIRE_IMAGE_DATA:
+		/* offset and len tlvs: type, 16 bit len, 32 bit value */
+		req = &host.reqs[host.wptr++ % ARRAY_SIZE(host.reqs)];
+		memcpy(&req->offset, p + 5 + 3, 4);
+		memcpy(&req->len, p + 5 + 7 + 3, 4);
+		req->due = now_us() + REQUEST_US;
+
+		result.requests++;
+		if (host.wptr - host.rptr > result.max_outstanding)
+			result.max_outstanding = host.wptr - host.rptr;
+		break;
+	case OTA_CMD_H2D_REQUEST_UPGRADE:
+	case OTA_CMD_H2D_CONNECT_NEGOTIATION:
+		host.state = p[1];
+		break;
+	case OTA_CMD_D2H_VALIDATE_IMAGE:
+		host.done = true;
+		break;
+	}
+
+	pthread_cond_broadcast(&host.cond);
+	pthread_mutex_unlock(&host.mutex);
+
+	return num;
+}
+
+static void host_send_cmd(uint8_t cmd, const uint8_t *param, int len)
+{
+	uint8_t head[5] = { SERVICE_ID_OTA, cmd, TLV_TYPE_MAIN, len & 0xff, len >> 8 };
+
+	pthread_mutex_lock(&rx.mutex);
+	memcpy(rx.buf + rx.wptr, head, sizeof(head));
+	memcpy(rx.buf + rx.wptr + sizeof(head), param, len);
+	rx.wptr += sizeof(head) + len;
+	pthread_cond_broadcast(&rx.cond);
+	pthread_mutex_unlock(&rx.mutex);
+}
+
+/* an empty unit marks a request past the end of the image */
+static void host_send_unit(uint8_t psn, const uint8_t *data, int len)
+{
+	uint8_t param[5 + UNIT_SIZE];
+	uint32_t crc = utils_crc32(0, data, len);
+
+	param[0] = psn;
+	memcpy(param + 1, &crc, 4);
+	memcpy(param + 5, data, len);
+
+	if (len && cur_case->corrupt_ppm && (rand() % 1000000) < cur_case->corrupt_ppm) {
+		param[5 + rand() % len] ^= 0x5a;
+		result.corrupted++;
+	}
+
+	host_send_cmd(OTA_CMD_H2D_SEND_IMAGE_DATA_WITH_CRC, param, 5 + len);
+}
+
+static void host_wait_state(int state)
+{
+	pthread_mutex_lock(&host.mutex);
+	while (host.state != state)
+		pthread_cond_wait(&host.cond, &host.mutex);
+	pthread_mutex_unlock(&host.mutex);
+}
+
+static void *host_thread(void *arg)
+{
+	/* features tlv: type 0x09, len 1 */
+	uint8_t features[4] = { 0x09, 1, 0, cur_case->features };
+	/* negotiation result tlv: type 1, len 1, success */
+	uint8_t result_tlv[4] = { 1, 1, 0, 1 };
+	struct host_request req;
+	uint32_t offset, end;
+	uint64_t t;
+	uint8_t psn;
+	int len;
+
+	host_send_cmd(OTA_CMD_H2D_REQUEST_UPGRADE, features, sizeof(features));
+	host_wait_state(OTA_CMD_H2D_REQUEST_UPGRADE);
+	host_send_cmd(OTA_CMD_H2D_CONNECT_NEGOTIATION, NULL, 0);
+	host_wait_state(OTA_CMD_H2D_CONNECT_NEGOTIATION);
+	host_send_cmd(OTA_CMD_H2D_NEGOTIATION_RESULT, result_tlv, sizeof(result_tlv));
+
+	while (1) {
+		pthread_mutex_lock(&host.mutex);
+		while (host.rptr == host.wptr && !host.done)
+			pthread_cond_wait(&host.cond, &host.mutex);
+		if (host.rptr == host.wptr) {
+			pthread_mutex_unlock(&host.mutex);
+			break;
+		}
+		req = host.reqs[host.rptr % ARRAY_SIZE(host.reqs)];
+		pthread_mutex_unlock(&host.mutex);
+
+		sleep_until(req.due);
+
+		offset = req.offset;
+		end = req.offset + req.len;
+		if (end > IMAGE_SIZE)
+			end = IMAGE_SIZE;
+
+		t = now_us();
+		for (psn = 0; offset < end; psn++, offset += len) {
+			len = end - offset > UNIT_SIZE ? UNIT_SIZE : end - offset;
+			t += UNIT_US;
+			sleep_until(t);
+			host_send_unit(psn, image + offset, len);
+		}
+
+		if (req.offset + req.len > end)
+			host_send_unit(psn, NULL, 0);
+
+		pthread_mutex_lock(&host.mutex);
+		host.rptr++;
+		pthread_mutex_unlock(&host.mutex);
+	}
+
+	return NULL;
+}
+
+static void backend_notify(struct ota_backend *backend, int cmd, int state)
+{
+}
+
+/* one OTA transfer, as the upgrade core reads the image */
+static void run_case(void)
+{
+	static uint8_t buf[REGION_SIZE];
+	struct ota_backend_bt_init_param param = { 0 };
+	struct ota_backend *backend;
+	pthread_t thread;
+	uint64_t start;
+	int offset;
+
+	srand(1);
+	for (offset = 0; offset < IMAGE_SIZE; offset++)
+		image[offset] = rand();
+
+	backend = ota_backend_bt_init(backend_notify, &param);
+	pthread_create(&thread, NULL, host_thread, NULL);
+
+	start = now_us();
+	ota_backend_open(backend);
+
+	result.err = ota_backend_read(backend, 0, buf, 512);
+	if (!result.err && memcmp(buf, image, 512))
+		result.err = -EIO;
+
+	for (offset = 0; offset < IMAGE_SIZE && !result.err; offset += REGION_SIZE) {
+		result.err = ota_backend_read(backend, offset, buf, REGION_SIZE);
+		if (!result.err && memcmp(buf, image + offset, REGION_SIZE))
+			result.err = -EIO;
+
+		usleep(FLASH_US);
+	}
+
+	if (!result.err) {
+		ota_backend_ioctl(backend, OTA_BACKEND_IOCTL_REPORT_IMAGE_VALID, 1);
+		ota_backend_close(backend);
+		pthread_join(thread, NULL);
+	}
+
+	result.time_ms = (now_us() - start) / 1000;
+}
+
+static void test_case(const struct ota_case *c, struct ota_result *res)
+{
+	int fds[2], status;
+	pid_t pid;
+
+	memset(res, 0, sizeof(*res));
+	res->err = -ECHILD;
+
+	if (pipe(fds)) {
+		CHECK(0, "pipe");
+		return;
+	}
+
+	fflush(stdout);
+	pid = fork();
+	if (pid == 0) {
+		cur_case = c;
+		run_case();
+		write(fds[1], &result, sizeof(result));
+		_exit(0);
+	}
+
+	close(fds[1]);
+	read(fds[0], res, sizeof(*res));
+	close(fds[0]);
+	waitpid(pid, &status, 0);
+
+	printf("%-10s %5d ppm corrupted: %s in %4u ms, %3d requests, %d outstanding, %d bad units\n",
+	       (c->features & HOST_FEATURE_WINDOW) ? "windowed" : "sequential", c->corrupt_ppm,
+	       res->err ? "failed" : "ok", res->time_ms, res->requests,
+	       res->max_outstanding, res->corrupted);
+
+	CHECK(!res->err || c->may_fail, "features 0x%x, %d ppm: err %d",
+	      c->features, c->corrupt_ppm, res->err);
+}
+
+int main(void)
+{
+	struct ota_result res[ARRAY_SIZE(cases)];
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(cases); i++)
+		test_case(&cases[i], &res[i]);
+
+	/* the window overlaps the receive of a region with the flash program */
+	CHECK(res[1].max_outstanding > 1, "%d outstanding requests", res[1].max_outstanding);
+	CHECK(res[1].time_ms < res[0].time_ms, "windowed %u ms, sequential %u ms",
+	      res[1].time_ms, res[0].time_ms);
+
+	if (failures) {
+		printf("ota_bt: %d failures\n", failures);
+		return 1;
+	}
+
+	printf("ota_bt: OK\n");
+	return 0;
+}
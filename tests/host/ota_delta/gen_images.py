@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+#
+# Generate the test images of ota_delta_test
+#
+# Copyright (c) 2019 Actions Semiconductor Co., Ltd
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+# An old and a new firmware are made of a synthetic app (file_id 1, the
+# delta source) and resource file (file_id 2). The new app has inserted
+# code at 40%, the pointers past the insertion moved, patched words and
+# appended code, the new resource file has changed strings and a new
+# bitmap. The ota images and delta images are made by the repo tools.
+#
+# Output, in the given directory:
+#   app.bin          old app, the content of the source partition
+#   new.ota          new ota image, the reference of the rebuilt image
+#   delta.ota        delta image with LZ4 literal runs
+#   delta_v1.ota     delta image made with --no-lz4
+#
+# Usage: gen_images.py <out_dir>
+
+import os
+import sys
+import random
+import shutil
+import subprocess
+
+script_path = os.path.split(os.path.realpath(__file__))[0]
+tools_path = os.path.join(script_path, '..', '..', '..', 'zephyr', 'tools')
+
+APP_BASE = 0x10000000
+APP_SIZE = 64 * 1024
+RES_SIZE = 16 * 1024
+
+OTA_XML = '''<?xml version="1.0" encoding="UTF-8"?>
+<ota_firmware>
+<firmware_version><version_name>v%d</version_name><version_code>%d</version_code><version_res>0</version_res><board_name>host</board_name></firmware_version>
+<partitions><partitionsNum>2</partitionsNum>
+<partition><type>SYSTEM</type><name>app</name><file_id>1</file_id><storage_id>0</storage_id><file_name>app.bin</file_name><file_size>0x0</file_size><checksum>0x0</checksum></partition>
+<partition><type>DATA</type><name>res</name><file_id>2</file_id><storage_id>0</storage_id><file_name>res.bin</file_name><file_size>0x0</file_size><checksum>0x0</checksum></partition>
+</partitions>
+</ota_firmware>
+'''
+
+# code is made of a small set of instruction sequences with varying
+# immediates and of pointers into the app, as compiled code mostly is
+code_seqs = [bytes(random.Random(i).getrandbits(8) for _ in range(4 + (i % 6) * 4)) \
+             for i in range(96)]
+
+def gen_code(rnd, size):
+    words = []
+    while len(words) * 4 < size:
+        r = rnd.random()
+        if r < 0.2:
+            words.append((APP_BASE + rnd.randrange(APP_SIZE)) & ~3)
+        else:
+            seq = bytearray(rnd.choice(code_seqs))
+            pos = rnd.randrange(len(seq) // 2) * 2
+            seq[pos] = rnd.getrandbits(8)
+            words += [int.from_bytes(seq[i : i + 4], 'little') for i in range(0, len(seq), 4)]
+    return words[0 : size // 4]
+
+def pack_words(words):
+    return b''.join(w.to_bytes(4, 'little') for w in words)
+
+def gen_strings(rnd, size):
+    names = ['volume', 'battery', 'connected', 'disconnected', 'pairing', 'music', \
+             'call', 'incoming', 'low power', 'firmware', 'upgrade', 'language']
+    out = bytearray(0)
+    while len(out) < size:
+        out += ('%s %s %d\0' %(rnd.choice(names), rnd.choice(names), rnd.randrange(100))).encode()
+    return out[0 : size]
+
+def gen_bitmap(rnd, size):
+    out = bytearray(0)
+    while len(out) < size:
+        out += bytes([rnd.getrandbits(8), rnd.getrandbits(8)]) * rnd.randrange(1, 24)
+    return out[0 : size]
+
+def write_fw(out_dir, version, app, res):
+    os.makedirs(out_dir, exist_ok = True)
+    with open(os.path.join(out_dir, 'app.bin'), 'wb') as f:
+        f.write(app)
+    with open(os.path.join(out_dir, 'res.bin'), 'wb') as f:
+        f.write(res)
+    with open(os.path.join(out_dir, 'ota.xml'), 'w') as f:
+        f.write(OTA_XML %(version, version))
+
+    subprocess.check_call(['python3', os.path.join(tools_path, 'build_ota_image.py'), \
+        '-o', out_dir + '.ota', os.path.join(out_dir, 'ota.xml'), \
+        os.path.join(out_dir, 'app.bin'), os.path.join(out_dir, 'res.bin')], \
+        stdout = subprocess.DEVNULL)
+
+def main(argv):
+    if len(argv) != 1:
+        print('usage: gen_images.py <out_dir>')
+        sys.exit(1)
+
+    out_dir = argv[0]
+    temp_dir = os.path.join(out_dir, 'gen_images')
+    rnd = random.Random(7)
+
+    old_app = gen_code(rnd, APP_SIZE)
+    old_res = gen_strings(rnd, RES_SIZE // 2) + gen_bitmap(rnd, RES_SIZE // 2)
+
+    # insert code, move the pointers past it, patch some words
+    ins = len(old_app) * 2 // 5
+    ins_words = gen_code(rnd, 1536)
+    shift = len(ins_words) * 4
+    new_app = []
+    for i, w in enumerate(old_app):
+        if i == ins:
+            new_app += ins_words
+        if APP_BASE + ins * 4 <= w < APP_BASE + APP_SIZE:
+            w += shift
+        new_app.append(w)
+    for i in range(40):
+        new_app[rnd.randrange(len(new_app))] = rnd.getrandbits(32)
+    new_app += gen_code(rnd, 4096)
+
+    new_res = old_res[0 : 3000] + gen_strings(rnd, 600) + old_res[3600 : 12000] + \
+              gen_bitmap(rnd, 2048) + old_res[14048 : ]
+
+    write_fw(os.path.join(temp_dir, 'old'), 1, pack_words(old_app), old_res)
+    write_fw(os.path.join(temp_dir, 'new'), 2, pack_words(new_app), new_res)
+
+    shutil.copy(os.path.join(temp_dir, 'old', 'app.bin'), os.path.join(out_dir, 'app.bin'))
+    shutil.copy(os.path.join(temp_dir, 'new.ota'), os.path.join(out_dir, 'new.ota'))
+
+    for (name, opts) in (('delta.ota', []), ('delta_v1.ota', ['--no-lz4'])):
+        subprocess.check_call(['python3', os.path.join(tools_path, 'build_ota_delta.py'), \
+            '-o', os.path.join(temp_dir, 'old.ota'), '-n', os.path.join(temp_dir, 'new.ota'), \
+            '-d', os.path.join(out_dir, name)] + opts)
+
+    shutil.rmtree(temp_dir)
+
+if __name__ == '__main__':
+    main(sys.argv[1:])
@@ -0,0 +1,16 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the crc utils */
+
+#ifndef __HOST_CRC_H__
+#define __HOST_CRC_H__
+
+#include <stdint.h>
+
+uint32_t utils_crc32(uint32_t crc, const uint8_t *ptr, int buf_len);
+
+#endif
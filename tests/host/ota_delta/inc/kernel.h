@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the kernel API used by the delta OTA backend */
+
+#ifndef __HOST_KERNEL_H__
+#define __HOST_KERNEL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+typedef uint8_t u8_t;
+typedef uint16_t u16_t;
+typedef uint32_t u32_t;
+typedef int32_t s32_t;
+
+#define CONTAINER_OF(ptr, type, field) \
+	((type *)(((char *)(ptr)) - offsetof(type, field)))
+#define __ASSERT_NO_MSG(test)	do { } while (0)
+
+#ifdef HOST_LOG
+#define SYS_LOG_ERR(fmt, ...)	printf("E %s: " fmt "\n", __func__, ##__VA_ARGS__)
+#define SYS_LOG_INF(fmt, ...)	printf("I %s: " fmt "\n", __func__, ##__VA_ARGS__)
+#else
+#define SYS_LOG_ERR(...)	do { } while (0)
+#define SYS_LOG_INF(...)	do { } while (0)
+#endif
+#define SYS_LOG_DBG(...)	do { } while (0)
+
+#endif
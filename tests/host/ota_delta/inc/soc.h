@@ -0,0 +1,17 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the temp XIP mapping, implemented by the test */
+
+#ifndef __HOST_SOC_H__
+#define __HOST_SOC_H__
+
+#include <kernel.h>
+
+void *soc_memctrl_create_temp_mapping(u32_t nor_phy_addr, int enable_crc, int enable_rand);
+void soc_memctrl_clear_temp_mapping(void *cpu_addr);
+
+#endif
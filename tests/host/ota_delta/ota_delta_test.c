@@ -0,0 +1,352 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief round trip test of the delta OTA backend
+ *
+ * The delta images of traces/ (see gen_images.py) are served by a RAM
+ * transport backend, the old app is the source partition mapped from a
+ * RAM nor. The rebuilt image must match new.ota when read in order, after
+ * a breakpoint resume and at random offsets. A wrong source is refused at
+ * open with the transport closed again, a corrupted byte rejects one
+ * block, and a wrong image crc fails the read of the image end and is
+ * reported to the transport as an invalid image.
+ *
+ * Built with and without CONFIG_OTA_BACKEND_DELTA_LZ4, version 2 images
+ * are refused without it.
+ *
+ * Usage: ota_delta_test <traces dir>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <kernel.h>
+#include <soc.h>
+#include <partition/partition.h>
+#include <ota_backend.h>
+#include <ota_backend_delta.h>
+
+#define SRC_FILE_ID		1
+#define SRC_NOR_OFFS		0x1000
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) \
+	do { \
+		if (!(cond)) { \
+			printf("FAIL %s:%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__); \
+			failures++; \
+		} \
+	} while (0)
+
+struct image {
+	uint8_t *data;
+	int size;
+};
+
+static struct image src_image, new_image, delta_image, delta_v1_image;
+
+/* RAM nor, the old app is the source partition */
+static const struct partition_entry src_part = {
+	.file_id = SRC_FILE_ID,
+	.flag = PARTITION_FLAG_ENABLE_CRC,
+	.size = 0x20000,
+	.file_offset = SRC_NOR_OFFS,
+};
+
+static int mappings;
+
+const struct partition_entry *partition_get_part(u8_t file_id)
+{
+	return (file_id == SRC_FILE_ID) ? &src_part : NULL;
+}
+
+const struct partition_entry *partition_get_mirror_part(u8_t file_id)
+{
+	return (file_id == SRC_FILE_ID) ? &src_part : NULL;
+}
+
+void *soc_memctrl_create_temp_mapping(u32_t nor_phy_addr, int enable_crc, int enable_rand)
+{
+	if (nor_phy_addr != SRC_NOR_OFFS)
+		return NULL;
+
+	mappings++;
+	return src_image.data;
+}
+
+void soc_memctrl_clear_temp_mapping(void *cpu_addr)
+{
+	mappings--;
+}
+
+uint32_t utils_crc32(uint32_t crc, const uint8_t *ptr, int buf_len)
+{
+	int k;
+
+	crc = ~crc;
+	while (buf_len--) {
+		crc ^= *ptr++;
+		for (k = 0; k < 8; k++)
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+	}
+
+	return ~crc;
+}
+
+/* transport backend serving an image from RAM */
+static struct {
+	const struct image *image;
+	int opened;
+	int read_bytes;
+	int valid_reports;
+	int invalid_reports;
+} transport;
+
+static int transport_open(struct ota_backend *backend)
+{
+	transport.opened++;
+	return 0;
+}
+
+static int transport_close(struct ota_backend *backend)
+{
+	transport.opened--;
+	return 0;
+}
+
+static int transport_read(struct ota_backend *backend, int offset, unsigned char *buf, int size)
+{
+	if (offset < 0 || offset + size > transport.image->size)
+		return -EIO;
+
+	memcpy(buf, transport.image->data + offset, size);
+	transport.read_bytes += size;
+
+	return 0;
+}
+
+static int transport_ioctl(struct ota_backend *backend, int cmd, unsigned int param)
+{
+	if (cmd == OTA_BACKEND_IOCTL_REPORT_IMAGE_VALID) {
+		if (param)
+			transport.valid_reports++;
+		else
+			transport.invalid_reports++;
+	}
+
+	return 0;
+}
+
+static void transport_exit(struct ota_backend *backend)
+{
+}
+
+static struct ota_backend_api transport_api = {
+	.exit = transport_exit,
+	.open = transport_open,
+	.close = transport_close,
+	.read = transport_read,
+	.ioctl = transport_ioctl,
+};
+
+static struct ota_backend transport_backend;
+static struct ota_backend *notified;
+
+static void app_notify(struct ota_backend *backend, int cmd, int state)
+{
+	notified = backend;
+}
+
+static int load_image(struct image *image, const char *dir, const char *name)
+{
+	char path[256];
+	FILE *fp;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	fp = fopen(path, "rb");
+	if (!fp) {
+		printf("FAIL: can not open %s\n", path);
+		return -1;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	image->size = ftell(fp);
+	rewind(fp);
+	image->data = malloc(image->size);
+	fread(image->data, 1, image->size, fp);
+	fclose(fp);
+
+	return 0;
+}
+
+/*
+ * read from offset to the end as the upgrade core, mostly 512 byte reads,
+ * returns -EIO if a read fails and -EBADMSG on a data mismatch at *offset
+ */
+static int read_image(struct ota_backend *backend, int *offset)
+{
+	static uint8_t buf[8192];
+	int size;
+
+	while (*offset < new_image.size) {
+		size = (rand() % 7 == 0) ? rand() % 4096 + 1 : 512;
+		if (size > new_image.size - *offset)
+			size = new_image.size - *offset;
+
+		if (ota_backend_read(backend, *offset, buf, size))
+			return -EIO;
+
+		if (memcmp(buf, new_image.data + *offset, size))
+			return -EBADMSG;
+
+		*offset += size;
+	}
+
+	return 0;
+}
+
+static void test_delta(struct ota_backend *backend, const char *name, struct image *delta)
+{
+	uint8_t buf[600];
+	int i, offset, err, resume_bytes;
+
+	transport.image = delta;
+	transport.read_bytes = 0;
+	transport.valid_reports = 0;
+
+	CHECK(!ota_backend_open(backend), "%s: open", name);
+	offset = 0;
+	err = read_image(backend, &offset);
+	CHECK(!err, "%s: read 0x%x: %d", name, offset, err);
+	CHECK(!ota_backend_ioctl(backend, OTA_BACKEND_IOCTL_REPORT_IMAGE_VALID, 1),
+	      "%s: valid report", name);
+	CHECK(transport.valid_reports == 1, "%s: %d valid reports", name, transport.valid_reports);
+	ota_backend_close(backend);
+
+	printf("%s: %d bytes for a %d byte image, %d bytes read in order",
+	       name, delta->size, new_image.size, transport.read_bytes);
+
+	/* breakpoint resume in a new session, the image crc decodes the skipped blocks */
+	transport.read_bytes = 0;
+	CHECK(!ota_backend_open(backend), "%s: open", name);
+	offset = new_image.size * 3 / 5 + 123;
+	err = read_image(backend, &offset);
+	CHECK(!err, "%s: resumed read 0x%x: %d", name, offset, err);
+	resume_bytes = transport.read_bytes;
+
+	for (i = 0; i < 2000; i++) {
+		offset = rand() % (new_image.size - sizeof(buf));
+		CHECK(!ota_backend_read(backend, offset, buf, sizeof(buf)) &&
+		      !memcmp(buf, new_image.data + offset, sizeof(buf)),
+		      "%s: random read 0x%x", name, offset);
+	}
+
+	ota_backend_close(backend);
+	printf(", %d after resume at 60%%\n", resume_bytes);
+
+	CHECK(transport.opened == 0, "%s: transport opened %d", name, transport.opened);
+}
+
+static void test_bad_delta(struct ota_backend *backend)
+{
+	static uint8_t buf[4096];
+	struct ota_delta_head *head = (struct ota_delta_head *)delta_image.data;
+	uint32_t new_crc = head->new_crc;
+	int offset, err, bad = 0;
+
+	transport.image = &delta_image;
+
+	/* wrong source, the transport must be closed again */
+	src_image.data[100] ^= 1;
+	CHECK(ota_backend_open(backend) == -EINVAL, "wrong source accepted");
+	CHECK(transport.opened == 0, "transport opened %d", transport.opened);
+	src_image.data[100] ^= 1;
+
+	/* corrupted block data */
+	CHECK(!ota_backend_open(backend), "open");
+	delta_image.data[delta_image.size / 2] ^= 0x5a;
+	for (offset = 0; offset + sizeof(buf) < new_image.size; offset += sizeof(buf)) {
+		if (ota_backend_read(backend, offset, buf, sizeof(buf)))
+			bad++;
+	}
+	delta_image.data[delta_image.size / 2] ^= 0x5a;
+	ota_backend_close(backend);
+	CHECK(bad == 1, "%d blocks rejected", bad);
+
+	/* all blocks are good, but the image is not the one of the head */
+	head->new_crc ^= 1;
+	transport.invalid_reports = 0;
+	CHECK(!ota_backend_open(backend), "open");
+	offset = 0;
+	err = read_image(backend, &offset);
+	CHECK(err == -EIO && offset + 4096 >= new_image.size, "image end 0x%x: %d", offset, err);
+	CHECK(ota_backend_ioctl(backend, OTA_BACKEND_IOCTL_REPORT_IMAGE_VALID, 1) == -EIO,
+	      "bad crc reported valid");
+	CHECK(transport.invalid_reports == 1, "%d invalid reports", transport.invalid_reports);
+	ota_backend_close(backend);
+	head->new_crc = new_crc;
+}
+
+int main(int argc, char *argv[])
+{
+	struct ota_backend *backend;
+	int offset, err;
+
+	if (argc != 2) {
+		printf("usage: ota_delta_test <traces dir>\n");
+		return 1;
+	}
+
+	if (load_image(&src_image, argv[1], "app.bin") ||
+	    load_image(&new_image, argv[1], "new.ota") ||
+	    load_image(&delta_image, argv[1], "delta.ota") ||
+	    load_image(&delta_v1_image, argv[1], "delta_v1.ota"))
+		return 1;
+
+	srand(1);
+
+	ota_backend_init(&transport_backend, OTA_BACKEND_TYPE_BLUETOOTH, &transport_api, app_notify);
+	backend = ota_backend_delta_init(&transport_backend);
+	CHECK(backend && backend == ota_backend_delta_init(&transport_backend), "init again");
+
+	/* the app attaches the delta backend from the transport notify */
+	transport_backend.cb(&transport_backend, OTA_BACKEND_UPGRADE_STATE, 1);
+	CHECK(notified == backend, "notify not forwarded");
+
+	test_delta(backend, "delta_v1.ota", &delta_v1_image);
+
+#ifdef CONFIG_OTA_BACKEND_DELTA_LZ4
+	test_delta(backend, "delta.ota", &delta_image);
+	test_bad_delta(backend);
+#else
+	transport.image = &delta_image;
+	CHECK(ota_backend_open(backend) == -EINVAL, "LZ4 image accepted");
+	CHECK(transport.opened == 0, "transport opened %d", transport.opened);
+#endif
+
+	/* full images pass through */
+	transport.image = &new_image;
+	CHECK(!ota_backend_open(backend), "open full image");
+	offset = 0;
+	err = read_image(backend, &offset);
+	CHECK(!err, "full image read 0x%x: %d", offset, err);
+	ota_backend_close(backend);
+
+	ota_backend_delta_exit(backend);
+	CHECK(transport_backend.cb == app_notify, "notify not restored");
+	CHECK(mappings == 0, "%d mappings left", mappings);
+
+	if (failures) {
+		printf("ota_delta: %d failures\n", failures);
+		return 1;
+	}
+
+	printf("ota_delta: OK\n");
+	return 0;
+}
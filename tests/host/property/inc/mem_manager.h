@@ -0,0 +1 @@
+/* host stub, the property cache does not allocate */
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2017 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the OS API used by the property cache */
+
+#ifndef __HOST_OS_COMMON_API_H__
+#define __HOST_OS_COMMON_API_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define __aligned(x)		__attribute__((aligned(x)))
+#define BUILD_ASSERT(e, m)	_Static_assert(e, m)
+#define MIN(a, b)		((a) < (b) ? (a) : (b))
+#define printk			printf
+
+#ifdef HOST_LOG
+#define SYS_LOG_DBG(...)	printf(__VA_ARGS__)
+#define SYS_LOG_INF(...)	printf(__VA_ARGS__)
+#define SYS_LOG_ERR(...)	printf(__VA_ARGS__)
+#define LOG_INF(...)		printf(__VA_ARGS__)
+#else
+#define SYS_LOG_DBG(...)
+#define SYS_LOG_INF(...)
+#define SYS_LOG_ERR(...)
+#define LOG_INF(...)
+#endif
+
+#define OS_FOREVER		(-1)
+
+#define k_cycle_get_32()	0
+#define k_cyc_to_us_floor32(c)	(c)
+
+/* recursive like the k_mutex behind it, depth is checked by the test */
+typedef struct {
+	int depth;
+} os_mutex;
+
+#define OS_MUTEX_DEFINE(name)	os_mutex name
+
+static inline int os_mutex_lock(os_mutex *mutex, int timeout)
+{
+	mutex->depth++;
+	return 0;
+}
+
+static inline int os_mutex_unlock(os_mutex *mutex)
+{
+	mutex->depth--;
+	return 0;
+}
+
+#endif
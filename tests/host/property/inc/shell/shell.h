@@ -0,0 +1 @@
+struct shell;
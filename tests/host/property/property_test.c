@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2018 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Host test of the property cache
+ *
+ * The cache is built against a RAM model of the nvram configs, which
+ * also plays the other users writing nvram directly. Sets inside a batch
+ * are journaled until the commit, which can be made to fail. Every read
+ * through the cache is checked against a reference model of the configs,
+ * and no batch may be begun under the cache lock.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <os_common_api.h>
+#include <property_inner.h>
+
+#define NUM_KEYS		30
+#define MAX_DATA_LEN		100
+
+extern os_mutex nvram_cache_mutex;
+
+/* nvram model: data length of each key, -1 if not set */
+static int nv_len[NUM_KEYS];
+static uint8_t nv_data[NUM_KEYS][MAX_DATA_LEN];
+static nvram_config_set_cb_t nv_set_cb;
+static int nv_sets;
+
+/* batch model: journaled sets, applied or dropped by the commit */
+static bool nv_in_batch, nv_fail_commit;
+static int nv_journal_num;
+static int nv_journal_key[NUM_KEYS];
+static int nv_journal_len[NUM_KEYS];
+static uint8_t nv_journal_data[NUM_KEYS][MAX_DATA_LEN];
+
+/* reference model of the configs as seen by property users */
+static int ref_len[NUM_KEYS];
+static uint8_t ref_data[NUM_KEYS][MAX_DATA_LEN];
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) \
+	do { \
+		if (!(cond)) { \
+			printf("FAIL %s:%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__); \
+			failures++; \
+		} \
+	} while (0)
+
+static int key_of(const char *name)
+{
+	return atoi(strchr(name, '_') + 1);
+}
+
+static void key_name(char *name, int key)
+{
+	/* every third name is too long to be cached */
+	if (key % 3 == 0)
+		sprintf(name, "K_%d_WITH_A_NAME_TOO_LONG_FOR_CACHE", key);
+	else
+		sprintf(name, "K_%d", key);
+}
+
+int nvram_config_get(const char *name, void *data, int max_len)
+{
+	int key = key_of(name);
+	int len;
+
+	if (nv_len[key] <= 0)
+		return -ENOENT;
+
+	len = MIN(nv_len[key], max_len);
+	memcpy(data, nv_data[key], len);
+
+	return len;
+}
+
+static void nv_write(int key, const void *data, int len)
+{
+	if (len)
+		memcpy(nv_data[key], data, len);
+	nv_len[key] = len ? len : -1;
+}
+
+int nvram_config_set(const char *name, const void *data, int len)
+{
+	int key = key_of(name);
+
+	nv_sets++;
+	if (nv_in_batch) {
+		nv_journal_key[nv_journal_num] = key;
+		nv_journal_len[nv_journal_num] = len;
+		memcpy(nv_journal_data[nv_journal_num], data, len);
+		nv_journal_num++;
+	} else {
+		nv_write(key, data, len);
+	}
+
+	if (nv_set_cb)
+		nv_set_cb(name);
+
+	return 0;
+}
+
+int nvram_config_batch_begin(void)
+{
+	/* a set callback of another batch owner takes the cache lock */
+	CHECK(nvram_cache_mutex.depth == 0, "batch begun under the cache lock");
+	CHECK(!nv_in_batch, "nested batch");
+
+	nv_in_batch = true;
+	nv_journal_num = 0;
+	return 0;
+}
+
+int nvram_config_batch_commit(void)
+{
+	int i;
+
+	nv_in_batch = false;
+	if (nv_fail_commit)
+		return -EIO;
+
+	for (i = 0; i < nv_journal_num; i++)
+		nv_write(nv_journal_key[i], nv_journal_data[i], nv_journal_len[i]);
+
+	return 0;
+}
+
+void nvram_config_set_callback(nvram_config_set_cb_t cb)
+{
+	nv_set_cb = cb;
+}
+
+static void nvram_clear_all(void)
+{
+	memset(nv_len, 0xff, sizeof(nv_len));
+	if (nv_set_cb)
+		nv_set_cb(NULL);
+}
+
+static void check_get(int key, int want)
+{
+	char name[40];
+	uint8_t buf[MAX_DATA_LEN];
+	int ret;
+
+	key_name(name, key);
+	ret = property_cache_get(name, buf, want);
+
+	if (ref_len[key] < 0) {
+		CHECK(ret == -ENOENT, "%s deleted, ret %d", name, ret);
+		return;
+	}
+
+	CHECK(ret == MIN(ref_len[key], want) && !memcmp(buf, ref_data[key], ret),
+	      "%s ret %d expect %d", name, ret, MIN(ref_len[key], want));
+}
+
+static void reset(void)
+{
+	nv_fail_commit = false;
+	memset(nv_len, 0xff, sizeof(nv_len));
+	memset(ref_len, 0xff, sizeof(ref_len));
+	nv_sets = 0;
+	property_cache_init();
+}
+
+/* deleted configs read back as -ENOENT from the cache and from nvram */
+static void test_delete(void)
+{
+	uint8_t val = 0x5a;
+
+	reset();
+
+	property_cache_set("K_1", &val, 1);
+	property_cache_set("K_1", NULL, 0);
+	check_get(1, 16);
+
+	property_cache_flush(NULL);
+	CHECK(nv_len[1] < 0, "K_1 not deleted in nvram");
+	check_get(1, 16);
+
+	/* miss fills the cache, then a hit */
+	nvram_config_set("K_2", &val, 1);
+	ref_len[2] = 1;
+	ref_data[2][0] = val;
+	check_get(2, 16);
+	check_get(2, 16);
+}
+
+/* writes straight to nvram are not hidden by the cached copy */
+static void test_direct_write(void)
+{
+	uint8_t a[6] = "left", b[6] = "right";
+	uint8_t buf[8];
+	struct property_cache_stat stat;
+
+	reset();
+
+	nvram_config_set("K_4", a, sizeof(a));
+	CHECK(property_cache_get("K_4", buf, sizeof(buf)) == sizeof(a), "K_4 fill");
+
+	/* like the binding address written by the app and read by bt manager */
+	nvram_config_set("K_4", b, sizeof(b));
+	CHECK(property_cache_get("K_4", buf, sizeof(buf)) == sizeof(b) &&
+	      !memcmp(buf, b, sizeof(b)), "K_4 stale %s", buf);
+
+	/* a direct write also wins over a dirty cached value */
+	property_cache_set("K_5", a, sizeof(a));
+	nvram_config_set("K_5", b, sizeof(b));
+	property_cache_flush(NULL);
+	CHECK(nv_len[5] == sizeof(b) && !memcmp(nv_data[5], b, sizeof(b)),
+	      "K_5 overwritten by flush");
+
+	/* own write back does not drop the item */
+	property_cache_set("K_7", a, sizeof(a));
+	property_cache_flush(NULL);
+	property_cache_get_stat(&stat);
+	CHECK(stat.used >= 1, "K_7 dropped by write back");
+
+	nvram_clear_all();
+	property_cache_get_stat(&stat);
+	CHECK(stat.used == 0, "%d items left after clear all", stat.used);
+	CHECK(property_cache_get("K_4", buf, sizeof(buf)) == -ENOENT, "K_4 after clear all");
+
+	CHECK(nvram_cache_mutex.depth == 0, "mutex depth %d", nvram_cache_mutex.depth);
+}
+
+/* a failed commit keeps the items dirty and reports the error */
+static void test_commit_error(void)
+{
+	uint8_t a[6] = "left", b[6] = "right";
+	struct property_cache_stat stat;
+	int ret;
+
+	reset();
+
+	property_cache_set("K_1", a, sizeof(a));
+	nv_fail_commit = true;
+	ret = property_cache_flush(NULL);
+	CHECK(ret == -EIO, "flush ret %d", ret);
+	CHECK(nv_len[1] < 0, "K_1 written by a failed commit");
+	property_cache_get_stat(&stat);
+	CHECK(stat.dirty == 1 && stat.write_backs == 0, "dirty %d write backs %u after failed commit",
+	      stat.dirty, stat.write_backs);
+
+	nv_fail_commit = false;
+	CHECK(property_cache_flush("K_1") == 0, "flush K_1");
+	CHECK(nv_len[1] == sizeof(a) && !memcmp(nv_data[1], a, sizeof(a)), "K_1 lost");
+	property_cache_get_stat(&stat);
+	CHECK(stat.dirty == 0 && stat.write_backs == 1, "dirty %d write backs %u after commit",
+	      stat.dirty, stat.write_backs);
+
+	/* a failed flush request is dealt again */
+	property_cache_set("K_2", b, sizeof(b));
+	property_cache_flush_req("K_2");
+	nv_fail_commit = true;
+	CHECK(property_cache_flush_req_deal() == -EIO, "deal did not fail");
+	nv_fail_commit = false;
+	CHECK(property_cache_flush_req_deal() == 0, "deal retry");
+	CHECK(nv_len[2] == sizeof(b) && !memcmp(nv_data[2], b, sizeof(b)), "K_2 lost");
+
+	CHECK(nvram_cache_mutex.depth == 0, "mutex depth %d", nvram_cache_mutex.depth);
+}
+
+/* random property and direct nvram access against the reference model */
+static void test_random(void)
+{
+	struct property_cache_stat stat;
+	uint8_t buf[MAX_DATA_LEN];
+	char name[40];
+	int i, n, key, op, len;
+
+	reset();
+	srand(3);
+
+	for (n = 0; n < 200000; n++) {
+		key = rand() % NUM_KEYS;
+		key_name(name, key);
+		op = rand() % 20;
+
+		if (op < 8) {
+			len = rand() % 90;
+			for (i = 0; i < len; i++)
+				buf[i] = rand();
+			property_cache_set(name, buf, len);
+		} else if (op < 10) {
+			len = rand() % 90;
+			for (i = 0; i < len; i++)
+				buf[i] = rand();
+			nvram_config_set(name, buf, len);
+		} else if (op < 17) {
+			check_get(key, 1 + rand() % (MAX_DATA_LEN - 1));
+			continue;
+		} else if (op < 18) {
+			/* every tenth commit fails */
+			nv_fail_commit = !(rand() % 10);
+			property_cache_flush_req(rand() % 2 ? NULL : name);
+			continue;
+		} else if (op < 19) {
+			property_cache_flush_req_deal();
+			continue;
+		} else {
+			property_cache_flush(NULL);
+			continue;
+		}
+
+		memcpy(ref_data[key], buf, len);
+		ref_len[key] = len ? len : -1;
+	}
+
+	nv_fail_commit = false;
+	property_cache_flush(NULL);
+	for (key = 0; key < NUM_KEYS; key++) {
+		CHECK(nv_len[key] == ref_len[key] &&
+		      (ref_len[key] < 0 || !memcmp(nv_data[key], ref_data[key], ref_len[key])),
+		      "key %d not flushed", key);
+	}
+
+	CHECK(nvram_cache_mutex.depth == 0, "mutex depth %d", nvram_cache_mutex.depth);
+
+	property_cache_get_stat(&stat);
+	printf("random: hits %u misses %u evictions %u write backs %u, nvram sets %d\n",
+	       stat.hits, stat.misses, stat.evictions, stat.write_backs, nv_sets);
+}
+
+int main(void)
+{
+	test_delete();
+	test_direct_write();
+	test_commit_error();
+	test_random();
+
+	if (failures) {
+		printf("property: %d failures\n", failures);
+		return 1;
+	}
+
+	printf("property: OK\n");
+	return 0;
+}
@@ -0,0 +1,31 @@
+/* host stub of the file system API used by the res manager */
+
+#ifndef __HOST_FS_H__
+#define __HOST_FS_H__
+
+#include <stdint.h>
+#include <sys/types.h>
+
+struct fs_file_t {
+	uint32_t pos;
+};
+
+/* as res_mempool.h defines them for the target */
+#ifndef off_t
+#define off_t	uint32_t
+#define ssize_t	int32_t
+#endif
+
+#define FS_O_READ	0x01
+#define FS_SEEK_SET	0
+#define FS_SEEK_CUR	1
+#define FS_SEEK_END	2
+
+/* provided by the test, a nor flash of bitmaps */
+int fs_open(struct fs_file_t *zfp, const char *file_name, int flags);
+int fs_close(struct fs_file_t *zfp);
+int fs_seek(struct fs_file_t *zfp, off_t offset, int whence);
+off_t fs_tell(struct fs_file_t *zfp);
+ssize_t fs_read(struct fs_file_t *zfp, void *ptr, size_t size);
+
+#endif
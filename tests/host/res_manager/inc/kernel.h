@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the kernel API used by the res manager */
+
+#ifndef __HOST_KERNEL_H__
+#define __HOST_KERNEL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+typedef uint8_t u8_t;
+typedef uint16_t u16_t;
+typedef uint32_t u32_t;
+typedef int32_t s32_t;
+
+#define __aligned(x)			__attribute__((__aligned__(x)))
+#define __in_section_unique(seg)
+#define STRUCT_SECTION_ITERABLE(struct_type, name)	struct struct_type name
+
+#define K_NO_WAIT	0
+
+struct k_heap {
+	struct {
+		void *init_mem;
+		size_t init_bytes;
+	} heap;
+};
+
+/* provided by the test, thread safe as on the target */
+void *k_heap_alloc(struct k_heap *h, size_t bytes, int timeout);
+void k_heap_free(struct k_heap *h, void *mem);
+
+#endif
@@ -0,0 +1 @@
+/* host stub of the memory manager API, nothing is used by the res manager */
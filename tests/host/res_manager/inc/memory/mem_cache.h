@@ -0,0 +1,8 @@
+/* host stub of the cache API used by the res manager */
+
+#ifndef __HOST_MEM_CACHE_H__
+#define __HOST_MEM_CACHE_H__
+
+#define mem_dcache_clean(addr, size)	do { } while (0)
+
+#endif
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the OS API used by the res manager */
+
+#ifndef __HOST_OS_COMMON_API_H__
+#define __HOST_OS_COMMON_API_H__
+
+#include <kernel.h>
+#include <pthread.h>
+
+#define OS_FOREVER	(-1)
+
+/* the owner is tracked, the test checks which locks are held by a caller */
+typedef struct {
+	pthread_mutex_t mutex;
+	pthread_t owner;
+	int count;
+} os_mutex;
+
+typedef pthread_cond_t os_condvar;
+
+static inline void os_mutex_init(os_mutex *m)
+{
+	pthread_mutexattr_t attr;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&m->mutex, &attr);
+	m->count = 0;
+}
+
+static inline int os_mutex_lock(os_mutex *m, int timeout)
+{
+	pthread_mutex_lock(&m->mutex);
+	m->owner = pthread_self();
+	m->count++;
+	return 0;
+}
+
+static inline int os_mutex_unlock(os_mutex *m)
+{
+	m->count--;
+	pthread_mutex_unlock(&m->mutex);
+	return 0;
+}
+
+static inline bool os_mutex_held(os_mutex *m)
+{
+	return m->count > 0 && pthread_equal(m->owner, pthread_self());
+}
+
+static inline void os_condvar_init(os_condvar *c)
+{
+	pthread_cond_init(c, NULL);
+}
+
+static inline int os_condvar_wait(os_condvar *c, os_mutex *m, int timeout)
+{
+	int count = m->count;
+
+	m->count = 0;
+	pthread_cond_wait(c, &m->mutex);
+	m->owner = pthread_self();
+	m->count = count;
+	return 0;
+}
+
+static inline void os_condvar_broadcast(os_condvar *c)
+{
+	pthread_cond_broadcast(c);
+}
+
+/* errors are counted, a clean run logs none */
+extern int host_log_errors;
+
+#ifdef HOST_LOG
+#define SYS_LOG_ERR(fmt, ...)	do { host_log_errors++; printf("E %s: " fmt "\n", __func__, ##__VA_ARGS__); } while (0)
+#define SYS_LOG_INF(fmt, ...)	printf("I %s: " fmt "\n", __func__, ##__VA_ARGS__)
+#else
+#define SYS_LOG_ERR(...)	do { host_log_errors++; } while (0)
+#define SYS_LOG_INF(...)	do { } while (0)
+#endif
+#define SYS_LOG_WRN(...)	do { } while (0)
+#define SYS_LOG_DBG(...)	do { } while (0)
+#define os_printk(...)		do { } while (0)
+
+#define os_strace_u32(id, val)			do { } while (0)
+#define os_strace_end_call_u32(id, val)		do { } while (0)
+
+#define mem_malloc(size)	calloc(1, size)
+#define mem_free(ptr)		free(ptr)
+
+#endif
@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the sdfs API used by the res manager */
+
+#ifndef __HOST_SDFS_H__
+#define __HOST_SDFS_H__
+
+#include <fs/fs.h>
+
+/* provided by the test, a nor flash of bitmaps with one read ahead buffer per file */
+struct sd_file;
+
+struct sd_file *sd_fopen(const char *filename);
+void sd_fclose(struct sd_file *sd_file);
+int sd_fread(struct sd_file *sd_file, void *buffer, int len);
+int sd_fread_hint(struct sd_file *sd_file, int len);
+int sd_ftell(struct sd_file *sd_file);
+int sd_fseek(struct sd_file *sd_file, int offset, unsigned char whence);
+
+#endif
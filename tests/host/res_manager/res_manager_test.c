@@ -0,0 +1,471 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief concurrent bitmap load benchmark of the res manager
+ *
+ * LZ4 compressed bitmaps are loaded by several preload threads through
+ * sdfs from a simulated nor flash (command overhead and 40MB/s, the
+ * transfer does not keep the cpu busy) while a UI thread keeps loading
+ * and freeing a cached bitmap. The res manager and res mempool sources are
+ * the real ones, the heap of the bitmap pool is a thread safe malloc as
+ * k_heap is. As in sdfs, a file has one read ahead buffer, filled by a
+ * background transfer which holds the flash like any other transfer.
+ *
+ * First one loader loads all bitmaps without and with the read ahead
+ * hint: every chunk but the first of a bitmap must then come from the
+ * read ahead buffer. Reported is the time the loader waits for the flash.
+ *
+ * Every bitmap must be decoded right and no error be logged. As the res
+ * mempool bookkeeping is not thread safe, every bitmap pool allocation
+ * and free made while the loaders run must hold the bitmap cache lock,
+ * and all of the pool but the res array memory must be back after the
+ * cache is cleared. Reported are the load time, the cache hit latency
+ * seen by the UI thread, the peak staging memory of the loaders and the
+ * share of the bytes served by the read ahead.
+ *
+ * Usage: res_manager_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <os_common_api.h>
+#include <res_manager_api.h>
+#include <res_mempool.h>
+#include <sdfs.h>
+#include <lz4.h>
+
+#define BITMAP_NUM		96
+#define BITMAP_W		120
+#define BITMAP_H		120
+#define BITMAP_SIZE		(BITMAP_W * BITMAP_H * 2)
+#define LOADER_NUM		4
+
+/* nor flash read timing */
+#define NOR_CMD_NS		5000
+#define NOR_BYTE_NS		25
+
+/* chunk size of the compressed bitmap load */
+#define LOAD_CHUNK_SIZE		1024
+
+int host_log_errors;
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) \
+	do { \
+		if (!(cond)) { \
+			printf("FAIL %s:%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__); \
+			failures++; \
+		} \
+	} while (0)
+
+extern os_mutex bitmap_cache_mutex;
+extern struct k_heap res_mem_pool;
+
+/* not in the header, the load behind the scene and group child getters */
+int32_t res_manager_load_bitmap(resource_info_t *res_info, resource_bitmap_t *bitmap);
+
+static uint8_t *nor_data;
+static uint32_t nor_size;
+
+static uint8_t *bitmaps[BITMAP_NUM];
+static uint32_t bitmap_offs[BITMAP_NUM];
+static sty_picture_t sty[BITMAP_NUM];
+static pic_search_param_t search_param;
+static resource_info_t info;
+
+static double now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* heap of the bitmap pool, allocations are checked while the loaders run */
+static pthread_mutex_t heap_lock = PTHREAD_MUTEX_INITIALIZER;
+static volatile int loaders_running;
+static int unlocked_allocs;
+static long heap_blocks, heap_bytes, heap_peak;
+
+void *k_heap_alloc(struct k_heap *h, size_t bytes, int timeout)
+{
+	size_t *ptr = malloc(bytes + 2 * sizeof(size_t));
+
+	ptr[0] = bytes;
+	pthread_mutex_lock(&heap_lock);
+	if (h == &res_mem_pool) {
+		if (loaders_running && !os_mutex_held(&bitmap_cache_mutex))
+			unlocked_allocs++;
+		heap_blocks++;
+		heap_bytes += bytes;
+		if (heap_bytes > heap_peak)
+			heap_peak = heap_bytes;
+	}
+	pthread_mutex_unlock(&heap_lock);
+
+	return ptr + 2;
+}
+
+void k_heap_free(struct k_heap *h, void *mem)
+{
+	size_t *ptr = (size_t *)mem - 2;
+
+	pthread_mutex_lock(&heap_lock);
+	if (h == &res_mem_pool) {
+		if (loaders_running && !os_mutex_held(&bitmap_cache_mutex))
+			unlocked_allocs++;
+		heap_blocks--;
+		heap_bytes -= ptr[0];
+	}
+	pthread_mutex_unlock(&heap_lock);
+
+	free(ptr);
+}
+
+/* ui memory, big bitmaps are not loaded by the test */
+void *ui_memory_alloc(uint32_t size)
+{
+	return malloc(size);
+}
+
+void ui_memory_free(void *ptr)
+{
+	free(ptr);
+}
+
+/*
+ * nor flash behind sdfs, the transfer sleeps as a dma transfer would.
+ * Transfers are queued on the flash one after another, a read ahead
+ * transfer runs in background and a read of its data waits for its end.
+ */
+struct sd_file {
+	uint32_t pos;
+	uint32_t ra_offset;
+	uint32_t ra_len;
+	double ra_done_ms;
+};
+
+static struct sd_file nor_file;
+static pthread_mutex_t flash_lock = PTHREAD_MUTEX_INITIALIZER;
+static double flash_free_ms;
+static int read_ahead_on;
+static long read_bytes, ra_hit_bytes;
+static double flash_wait_ms;
+
+/* queue a transfer of len bytes, returns its end */
+static double nor_transfer(uint32_t len)
+{
+	double start = now_ms();
+
+	if (start < flash_free_ms)
+		start = flash_free_ms;
+
+	flash_free_ms = start + (NOR_CMD_NS + len * NOR_BYTE_NS) / 1e6;
+	return flash_free_ms;
+}
+
+static void wait_until_ms(double t)
+{
+	struct timespec ts;
+
+	ts.tv_sec = (time_t)(t / 1e3);
+	ts.tv_nsec = (long)((t - ts.tv_sec * 1e3) * 1e6);
+	clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+}
+
+struct sd_file *sd_fopen(const char *filename)
+{
+	memset(&nor_file, 0, sizeof(nor_file));
+	return &nor_file;
+}
+
+void sd_fclose(struct sd_file *sd_file)
+{
+}
+
+int sd_fseek(struct sd_file *sd_file, int offset, unsigned char whence)
+{
+	if (whence == FS_SEEK_CUR)
+		offset += sd_file->pos;
+	else if (whence == FS_SEEK_END)
+		offset += nor_size;
+
+	if (offset < 0 || offset > nor_size)
+		return -1;
+
+	sd_file->pos = offset;
+	return 0;
+}
+
+int sd_ftell(struct sd_file *sd_file)
+{
+	return sd_file->pos;
+}
+
+int sd_fread(struct sd_file *sd_file, void *buffer, int len)
+{
+	double end, now;
+	int hit = 0;
+
+	if (sd_file->pos + len > nor_size)
+		len = nor_size - sd_file->pos;
+	if (len <= 0)
+		return 0;
+
+	pthread_mutex_lock(&flash_lock);
+	now = end = now_ms();
+	if (sd_file->pos >= sd_file->ra_offset &&
+	    sd_file->pos < sd_file->ra_offset + sd_file->ra_len) {
+		hit = sd_file->ra_offset + sd_file->ra_len - sd_file->pos;
+		if (hit > len)
+			hit = len;
+		end = sd_file->ra_done_ms;
+	}
+	if (len > hit)
+		end = nor_transfer(len - hit);
+
+	read_bytes += len;
+	ra_hit_bytes += hit;
+	if (end > now)
+		flash_wait_ms += end - now;
+	pthread_mutex_unlock(&flash_lock);
+
+	wait_until_ms(end);
+
+	memcpy(buffer, nor_data + sd_file->pos, len);
+	sd_file->pos += len;
+	return len;
+}
+
+int sd_fread_hint(struct sd_file *sd_file, int len)
+{
+	if (!read_ahead_on)
+		return 0;
+
+	if (sd_file->pos + len > nor_size)
+		len = nor_size - sd_file->pos;
+	if (len <= 0)
+		return 0;
+
+	pthread_mutex_lock(&flash_lock);
+
+	/* one read ahead transfer in flight per file */
+	if (now_ms() < sd_file->ra_done_ms) {
+		pthread_mutex_unlock(&flash_lock);
+		return -EBUSY;
+	}
+
+	sd_file->ra_offset = sd_file->pos;
+	sd_file->ra_len = len;
+	sd_file->ra_done_ms = nor_transfer(len);
+
+	pthread_mutex_unlock(&flash_lock);
+	return len;
+}
+
+/* RGB565 gradients with a noisy disc, LZ4 packs them to about 60% */
+static void gen_bitmaps(void)
+{
+	int bound = LZ4_compressBound(BITMAP_SIZE);
+	char *tmp = malloc(bound);
+	uint16_t *pixels;
+	int i, x, y, r, g, b, len;
+
+	nor_data = malloc(BITMAP_NUM * bound);
+	nor_size = 0;
+	srand(1);
+
+	for (i = 0; i < BITMAP_NUM; i++) {
+		pixels = malloc(BITMAP_SIZE);
+		for (y = 0; y < BITMAP_H; y++) {
+			for (x = 0; x < BITMAP_W; x++) {
+				r = (x * 31 / BITMAP_W + i) & 31;
+				g = (y * 63 / BITMAP_H) & 63;
+				b = ((x + y) / 8 + i) & 31;
+				if ((x - 60) * (x - 60) + (y - 60) * (y - 60) < 900)
+					r ^= rand() & 3;
+				pixels[y * BITMAP_W + x] = (r << 11) | (g << 5) | b;
+			}
+		}
+		bitmaps[i] = (uint8_t *)pixels;
+
+		len = LZ4_compress_default((char *)pixels, tmp, BITMAP_SIZE, bound);
+		bitmap_offs[i] = nor_size;
+		memcpy(nor_data + nor_size, tmp, len);
+		nor_size += len;
+
+		sty[i].id = i + 1;
+		sty[i].width = BITMAP_W;
+		sty[i].height = BITMAP_H;
+		sty[i].bytes_per_pixel = 2;
+		sty[i].compress_size = len;
+	}
+
+	free(tmp);
+
+	search_param.id_start = 1;
+	search_param.id_end = BITMAP_NUM;
+	search_param.pic_offsets = bitmap_offs;
+	info.pic_search_param = &search_param;
+	info.pic_search_max_volume = 1;
+	info.pic_fp = sd_fopen("bitmaps");
+}
+
+/* one loader, returns the flash wait per bitmap in us */
+static double load_all(int read_ahead)
+{
+	resource_bitmap_t bitmap;
+	long first_bytes = 0;
+	int i;
+
+	read_ahead_on = read_ahead;
+	read_bytes = ra_hit_bytes = 0;
+	flash_wait_ms = 0;
+	memset(&nor_file, 0, sizeof(nor_file));
+
+	for (i = 0; i < BITMAP_NUM; i++) {
+		memset(&bitmap, 0, sizeof(bitmap));
+		bitmap.sty_data = &sty[i];
+		CHECK(!res_manager_preload_bitmap(&info, &bitmap) &&
+		      !memcmp(bitmap.buffer, bitmaps[i], BITMAP_SIZE), "bitmap %d", i);
+		first_bytes += (sty[i].compress_size < LOAD_CHUNK_SIZE) ?
+				sty[i].compress_size : LOAD_CHUNK_SIZE;
+	}
+
+	res_manager_clear_cache(1);
+
+	if (read_ahead)
+		CHECK(ra_hit_bytes == read_bytes - first_bytes,
+		      "%ld of %ld bytes read ahead", ra_hit_bytes, read_bytes - first_bytes);
+	else
+		CHECK(ra_hit_bytes == 0, "%ld bytes read ahead", ra_hit_bytes);
+
+	return flash_wait_ms * 1e3 / BITMAP_NUM;
+}
+
+static void test_read_ahead(void)
+{
+	double plain, ahead;
+
+	plain = load_all(0);
+	ahead = load_all(1);
+
+	printf("1 loader, chunks of %d bytes: flash wait per bitmap %.0f us, "
+	       "with read ahead %.0f us, %ld of %ld bytes read ahead\n",
+	       LOAD_CHUNK_SIZE, plain, ahead, ra_hit_bytes, read_bytes);
+}
+
+static void *loader_thread(void *arg)
+{
+	resource_bitmap_t bitmap;
+	long i;
+
+	for (i = (long)arg; i < BITMAP_NUM; i += LOADER_NUM) {
+		memset(&bitmap, 0, sizeof(bitmap));
+		bitmap.sty_data = &sty[i];
+		CHECK(!res_manager_preload_bitmap(&info, &bitmap) &&
+		      !memcmp(bitmap.buffer, bitmaps[i], BITMAP_SIZE), "bitmap %ld", i);
+	}
+
+	return NULL;
+}
+
+static double hit_max, hit_sum;
+static int hits;
+
+/* cached bitmap of the UI, loaded and freed again each frame */
+static void *ui_thread(void *arg)
+{
+	resource_bitmap_t bitmap;
+	double t;
+
+	while (loaders_running) {
+		memset(&bitmap, 0, sizeof(bitmap));
+		bitmap.sty_data = &sty[0];
+		t = now_ms();
+		res_manager_load_bitmap(&info, &bitmap);
+		t = now_ms() - t;
+		CHECK(bitmap.load_result == RES_BITMAP_LOAD_CACHED, "load result %d", bitmap.load_result);
+		res_manager_free_bitmap_data(bitmap.buffer);
+
+		hit_sum += t;
+		if (t > hit_max)
+			hit_max = t;
+		hits++;
+		usleep(200);
+	}
+
+	return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+	pthread_t loaders[LOADER_NUM], ui;
+	resource_bitmap_t bitmap;
+	long base_bytes, array_blocks;
+	double t;
+	long i;
+
+	gen_bitmaps();
+
+	res_mem_init();
+	res_manager_init();
+	res_manager_set_screen_size(454, 454);
+
+	test_read_ahead();
+	read_bytes = ra_hit_bytes = 0;
+
+	/* bitmap 0 stays cached for the UI thread */
+	memset(&bitmap, 0, sizeof(bitmap));
+	bitmap.sty_data = &sty[0];
+	CHECK(!res_manager_load_bitmap(&info, &bitmap) &&
+	      !memcmp(bitmap.buffer, bitmaps[0], BITMAP_SIZE), "bitmap 0");
+	base_bytes = heap_bytes;
+	heap_peak = heap_bytes;
+
+	t = now_ms();
+	loaders_running = 1;
+	pthread_create(&ui, NULL, ui_thread, NULL);
+	for (i = 0; i < LOADER_NUM; i++)
+		pthread_create(&loaders[i], NULL, loader_thread, (void *)i);
+	for (i = 0; i < LOADER_NUM; i++)
+		pthread_join(loaders[i], NULL);
+	t = now_ms() - t;
+	loaders_running = 0;
+	pthread_join(ui, NULL);
+
+	printf("%d loaders, %d bitmaps %dx%d, %u bytes compressed: %.1f ms, "
+	       "cache hit avg %.3f ms max %.2f ms (%d hits), peak staging %ld bytes\n",
+	       LOADER_NUM, BITMAP_NUM, BITMAP_W, BITMAP_H, nor_size, t,
+	       hits ? hit_sum / hits : 0, hit_max, hits,
+	       heap_peak - base_bytes - (BITMAP_NUM - 1) *
+	       (long)(BITMAP_SIZE + res_manager_get_bitmap_buf_block_unit_size()));
+
+	printf("%d loaders: %ld of %ld bytes read ahead\n",
+	       LOADER_NUM, ra_hit_bytes, read_bytes);
+
+	CHECK(unlocked_allocs == 0, "%d bitmap pool calls without the cache lock", unlocked_allocs);
+
+	/* the res array memory and its bitmap stay allocated */
+	res_manager_clear_cache(1);
+	array_blocks = 2;
+	CHECK(heap_blocks == array_blocks, "%ld bitmap pool blocks left", heap_blocks);
+	CHECK(host_log_errors == 0, "%d errors logged", host_log_errors);
+
+	if (failures) {
+		printf("res_manager: %d failures\n", failures);
+		return 1;
+	}
+
+	printf("res_manager: OK\n");
+	return 0;
+}
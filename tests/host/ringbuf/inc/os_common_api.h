@@ -0,0 +1,10 @@
+/* host stub of the OS API used by the ring buffer */
+
+#ifndef __HOST_OS_COMMON_API_H__
+#define __HOST_OS_COMMON_API_H__
+
+#include <stdio.h>
+
+#define os_printk		printf
+
+#endif
@@ -0,0 +1,17 @@
+/* host stub of the zephyr utilities used by the ring buffer */
+
+#ifndef __HOST_SYS_UTIL_H__
+#define __HOST_SYS_UTIL_H__
+
+#include <stdint.h>
+
+#define __aligned(x)		__attribute__((aligned(x)))
+#define min(a, b)		((a) < (b) ? (a) : (b))
+#define MIN(a, b)		((a) < (b) ? (a) : (b))
+
+static inline int is_power_of_two(unsigned int x)
+{
+	return x && !(x & (x - 1));
+}
+
+#endif
@@ -0,0 +1,453 @@
+/*
+ * Copyright (c) 2020 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Host test of the acts ring buffer
+ *
+ * The claim/finish calls of both ring buffer kinds are checked against a
+ * byte sequence across the wrap. The SPSC ring buffer is then stressed by
+ * a producer and a consumer thread, which check that every byte arrives
+ * in order, and its throughput is compared with the plain ring buffer
+ * guarded by a mutex, which is how the audio paths share it today.
+ *
+ * The frame benchmark moves sbc and aac packets and decoded pcm frames
+ * through the ring buffer, once copied in and out by put/get and once
+ * produced and consumed in place by claim/finish, and reports bytes/sec
+ * and the memcpy calls per frame, counted by wrapping memcpy at link time.
+ *
+ * Usage: ringbuf_test [megabytes of the stress test]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <acts_ringbuf.h>
+
+#define RING_SIZE		1000
+#define STRESS_MB		64
+#define ARRAY_SIZE(a)		(sizeof(a) / sizeof((a)[0]))
+#define FRAME_RING_SIZE		10000
+#define FRAME_BYTES		(32 << 20)
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) \
+	do { \
+		if (!(cond)) { \
+			printf("FAIL %s:%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__); \
+			failures++; \
+		} \
+	} while (0)
+
+static uint32_t memcpy_calls;
+
+void *__real_memcpy(void *dest, const void *src, size_t n);
+
+void *__wrap_memcpy(void *dest, const void *src, size_t n)
+{
+	memcpy_calls++;
+	return __real_memcpy(dest, src, n);
+}
+
+void *mem_malloc(int size)
+{
+	return malloc(size);
+}
+
+void mem_free(void *ptr)
+{
+	free(ptr);
+}
+
+/* put/get/claim of the plain ring buffer against a byte sequence */
+static void test_claim(void)
+{
+	static uint8_t data[37];
+	struct acts_ringbuf rb;
+	struct acts_ringbuf_iovec iov[2];
+	uint8_t tmp[40], wr = 0, rd = 0;
+	uint32_t n, cnt, space, k;
+	int i, j;
+
+	acts_ringbuf_init(&rb, data, sizeof(data));
+	srand(1);
+
+	for (i = 0; i < 200000; i++) {
+		n = rand() % 40;
+
+		if (rand() & 1) {
+			space = acts_ringbuf_space(&rb);
+			cnt = acts_ringbuf_put_claim_iov(&rb, iov, n);
+			CHECK(cnt == MIN(n, space), "put claim %u of %u", cnt, n);
+			CHECK(iov[0].len + iov[1].len == cnt, "put iov");
+			for (j = 0; j < 2; j++)
+				for (k = 0; k < iov[j].len; k++)
+					((uint8_t *)iov[j].base)[k] = wr++;
+			CHECK(!acts_ringbuf_put_finish(&rb, cnt), "put finish");
+		} else if (rand() & 1) {
+			cnt = acts_ringbuf_get_claim_iov(&rb, iov, n);
+			for (j = 0; j < 2; j++)
+				for (k = 0; k < iov[j].len; k++)
+					CHECK(((uint8_t *)iov[j].base)[k] == rd++, "get claim data");
+			CHECK(!acts_ringbuf_get_finish(&rb, cnt), "get finish");
+		} else {
+			cnt = acts_ringbuf_get(&rb, tmp, n);
+			for (k = 0; k < cnt; k++)
+				CHECK(tmp[k] == rd++, "get data");
+		}
+
+		if (failures)
+			return;
+	}
+
+	CHECK(acts_ringbuf_put_finish(&rb, acts_ringbuf_space(&rb) + 1) == -EINVAL,
+	      "put finish beyond space");
+}
+
+/* same for the SPSC ring buffer, whose put/get are all or nothing */
+static void test_spsc_claim(void)
+{
+	static uint8_t data[37];
+	struct acts_ringbuf_spsc rb;
+	struct acts_ringbuf_iovec iov[2];
+	uint8_t tmp[40], wr = 0, rd = 0;
+	uint32_t n, cnt, len, k;
+	int i, j;
+
+	acts_ringbuf_spsc_init(&rb, data, sizeof(data));
+	srand(2);
+
+	for (i = 0; i < 200000; i++) {
+		n = rand() % 40;
+		len = acts_ringbuf_spsc_length(&rb);
+
+		switch (rand() % 4) {
+		case 0:
+			cnt = acts_ringbuf_spsc_put_claim_iov(&rb, iov, n);
+			CHECK(cnt == MIN(n, sizeof(data) - len), "put claim %u of %u", cnt, n);
+			for (j = 0; j < 2; j++)
+				for (k = 0; k < iov[j].len; k++)
+					((uint8_t *)iov[j].base)[k] = wr++;
+			CHECK(!acts_ringbuf_spsc_put_finish(&rb, cnt), "put finish");
+			break;
+		case 1:
+			for (k = 0; k < n; k++)
+				tmp[k] = wr + k;
+			cnt = acts_ringbuf_spsc_put(&rb, tmp, n);
+			CHECK(cnt == (n <= sizeof(data) - len ? n : 0), "put %u of %u", cnt, n);
+			wr += cnt;
+			break;
+		case 2:
+			cnt = acts_ringbuf_spsc_get_claim_iov(&rb, iov, n);
+			CHECK(cnt == MIN(n, len), "get claim %u of %u", cnt, n);
+			for (j = 0; j < 2; j++)
+				for (k = 0; k < iov[j].len; k++)
+					CHECK(((uint8_t *)iov[j].base)[k] == rd++, "get claim data");
+			CHECK(!acts_ringbuf_spsc_get_finish(&rb, cnt), "get finish");
+			break;
+		default:
+			cnt = acts_ringbuf_spsc_get(&rb, tmp, n);
+			CHECK(cnt == (n <= len ? n : 0), "get %u of %u", cnt, n);
+			for (k = 0; k < cnt; k++)
+				CHECK(tmp[k] == rd++, "get data");
+			break;
+		}
+
+		if (failures)
+			return;
+	}
+
+	CHECK(acts_ringbuf_spsc_get_finish(&rb, acts_ringbuf_spsc_length(&rb) + 1) == -EINVAL,
+	      "get finish beyond length");
+}
+
+/*
+ * stress test: the producer writes the byte sequence with a mix of put and
+ * claim calls of odd sizes, the consumer checks it.
+ */
+static uint8_t stress_data[RING_SIZE];
+static struct acts_ringbuf_spsc stress_spsc;
+static struct acts_ringbuf stress_rb;
+static pthread_mutex_t stress_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t stress_total;
+static int stress_locked;
+
+static uint32_t stress_put(uint32_t pos)
+{
+	struct acts_ringbuf_iovec iov[2];
+	uint8_t tmp[64];
+	uint32_t cnt, k, n = 0;
+	int j;
+
+	if (stress_locked)
+		pthread_mutex_lock(&stress_lock);
+
+	if (pos & 1024) {
+		if (stress_locked)
+			cnt = acts_ringbuf_put_claim_iov(&stress_rb, iov, 97);
+		else
+			cnt = acts_ringbuf_spsc_put_claim_iov(&stress_spsc, iov, 97);
+
+		for (j = 0; j < 2; j++)
+			for (k = 0; k < iov[j].len; k++)
+				((uint8_t *)iov[j].base)[k] = pos + n++;
+
+		if (stress_locked)
+			acts_ringbuf_put_finish(&stress_rb, cnt);
+		else
+			acts_ringbuf_spsc_put_finish(&stress_spsc, cnt);
+	} else {
+		n = 1 + pos % 63;
+		for (k = 0; k < n; k++)
+			tmp[k] = pos + k;
+
+		if (stress_locked)
+			cnt = acts_ringbuf_put(&stress_rb, tmp, n);
+		else
+			cnt = acts_ringbuf_spsc_put(&stress_spsc, tmp, n);
+	}
+
+	if (stress_locked)
+		pthread_mutex_unlock(&stress_lock);
+
+	return cnt;
+}
+
+static void *stress_producer(void *arg)
+{
+	uint32_t pos = 0, cnt;
+
+	while (pos < stress_total) {
+		cnt = stress_put(pos);
+		if (!cnt)
+			sched_yield();
+		pos += cnt;
+	}
+
+	return NULL;
+}
+
+/* returns bytes consumed, or -1 if out of order */
+static int stress_get(uint32_t pos)
+{
+	struct acts_ringbuf_iovec iov[2];
+	uint8_t tmp[64];
+	uint32_t cnt, k, n;
+	int j, ret = 0;
+
+	if (stress_locked)
+		pthread_mutex_lock(&stress_lock);
+
+	if (pos & 2048) {
+		if (stress_locked)
+			cnt = acts_ringbuf_get_claim_iov(&stress_rb, iov, 113);
+		else
+			cnt = acts_ringbuf_spsc_get_claim_iov(&stress_spsc, iov, 113);
+
+		for (j = 0; j < 2 && ret >= 0; j++)
+			for (k = 0; k < iov[j].len; k++, ret++)
+				if (((uint8_t *)iov[j].base)[k] != (uint8_t)(pos + ret)) {
+					ret = -1;
+					break;
+				}
+
+		if (stress_locked)
+			acts_ringbuf_get_finish(&stress_rb, cnt);
+		else
+			acts_ringbuf_spsc_get_finish(&stress_spsc, cnt);
+	} else {
+		n = MIN(1 + pos % 50, stress_total - pos);
+
+		if (stress_locked)
+			cnt = acts_ringbuf_get(&stress_rb, tmp, n);
+		else
+			cnt = acts_ringbuf_spsc_get(&stress_spsc, tmp, n);
+
+		for (k = 0; k < cnt; k++, ret++)
+			if (tmp[k] != (uint8_t)(pos + k)) {
+				ret = -1;
+				break;
+			}
+	}
+
+	if (stress_locked)
+		pthread_mutex_unlock(&stress_lock);
+
+	return ret;
+}
+
+static double stress_run(int locked)
+{
+	struct timespec start, end;
+	pthread_t producer;
+	uint32_t pos = 0;
+	int cnt;
+
+	stress_locked = locked;
+	acts_ringbuf_init(&stress_rb, stress_data, sizeof(stress_data));
+	acts_ringbuf_spsc_init(&stress_spsc, stress_data, sizeof(stress_data));
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	pthread_create(&producer, NULL, stress_producer, NULL);
+
+	while (pos < stress_total) {
+		cnt = stress_get(pos);
+		if (cnt < 0) {
+			CHECK(0, "%s: out of order at %u", locked ? "locked" : "spsc", pos);
+			exit(1);
+		}
+		if (!cnt)
+			sched_yield();
+		pos += cnt;
+	}
+
+	pthread_join(producer, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	return stress_total / ((end.tv_sec - start.tv_sec) +
+			(end.tv_nsec - start.tv_nsec) / 1e9) / 1e6;
+}
+
+static void test_stress(int mbytes)
+{
+	double spsc, locked;
+
+	stress_total = (uint32_t)mbytes << 20;
+
+	spsc = stress_run(0);
+	locked = stress_run(1);
+
+	printf("stress: %d MB in order, spsc %.1f MB/s, mutex %.1f MB/s\n",
+	       mbytes, spsc, locked);
+}
+
+/*
+ * frame benchmark: the producer generates a frame, the consumer sums it,
+ * the way a decoder feeds the audio track. Frames are in bytes: sbc
+ * packets of bitpool 53 and 7 frames, aac packets of 256 kbps, and the
+ * 16 bit stereo pcm of one sbc packet (7 * 128 samples) and one aac frame
+ * (1024 samples).
+ */
+static const struct {
+	const char *name;
+	uint32_t size;
+} bench_frames[] = {
+	{ "sbc packet", 595 },
+	{ "aac packet", 744 },
+	{ "sbc pcm", 7 * 128 * 4 },
+	{ "aac pcm", 1024 * 4 },
+};
+
+static uint8_t bench_data[FRAME_RING_SIZE];
+static uint8_t bench_frame[4096];
+
+static void bench_fill(uint8_t *buf, uint32_t len, uint32_t pos)
+{
+	uint32_t k;
+
+	for (k = 0; k < len; k++)
+		buf[k] = pos + k;
+}
+
+static uint32_t bench_sum(const uint8_t *buf, uint32_t len)
+{
+	uint32_t k, sum = 0;
+
+	for (k = 0; k < len; k++)
+		sum += buf[k];
+
+	return sum;
+}
+
+/* returns sum of the consumed data, counts time and memcpy calls */
+static uint32_t bench_run(uint32_t size, uint32_t frames, int claim,
+		double *secs, uint32_t *copies)
+{
+	struct acts_ringbuf rb;
+	struct acts_ringbuf_iovec iov[2];
+	struct timespec start, end;
+	uint32_t i, pos = 0, sum = 0, cnt;
+	int j;
+
+	acts_ringbuf_init(&rb, bench_data, sizeof(bench_data));
+	memcpy_calls = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for (i = 0; i < frames; i++) {
+		if (claim) {
+			cnt = acts_ringbuf_put_claim_iov(&rb, iov, size);
+			for (j = 0; j < 2; j++) {
+				bench_fill(iov[j].base, iov[j].len, pos);
+				pos += iov[j].len;
+			}
+			acts_ringbuf_put_finish(&rb, cnt);
+
+			cnt = acts_ringbuf_get_claim_iov(&rb, iov, size);
+			for (j = 0; j < 2; j++)
+				sum += bench_sum(iov[j].base, iov[j].len);
+			acts_ringbuf_get_finish(&rb, cnt);
+		} else {
+			bench_fill(bench_frame, size, pos);
+			pos += size;
+			acts_ringbuf_put(&rb, bench_frame, size);
+
+			acts_ringbuf_get(&rb, bench_frame, size);
+			sum += bench_sum(bench_frame, size);
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	*secs = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	*copies = memcpy_calls;
+
+	return sum;
+}
+
+static void test_frames(void)
+{
+	uint32_t frames, copy_sum, claim_sum, copy_calls, claim_calls;
+	double copy_secs, claim_secs;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bench_frames); i++) {
+		frames = FRAME_BYTES / bench_frames[i].size;
+
+		copy_sum = bench_run(bench_frames[i].size, frames, 0, &copy_secs, &copy_calls);
+		claim_sum = bench_run(bench_frames[i].size, frames, 1, &claim_secs, &claim_calls);
+
+		CHECK(copy_sum == claim_sum, "%s: data differs", bench_frames[i].name);
+		CHECK(copy_calls >= 2 * frames, "%s: %u memcpy for %u copied frames",
+		      bench_frames[i].name, copy_calls, frames);
+		CHECK(claim_calls == 0, "%s: %u memcpy in place",
+		      bench_frames[i].name, claim_calls);
+
+		printf("frames: %-10s %4u bytes, put/get %.2f memcpy/frame %.0f MB/s, "
+		       "claim %.2f memcpy/frame %.0f MB/s\n",
+		       bench_frames[i].name, bench_frames[i].size,
+		       (double)copy_calls / frames, frames * bench_frames[i].size / copy_secs / 1e6,
+		       (double)claim_calls / frames, frames * bench_frames[i].size / claim_secs / 1e6);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	test_claim();
+	test_spsc_claim();
+	test_frames();
+	test_stress(argc > 1 ? atoi(argv[1]) : STRESS_MB);
+
+	if (failures) {
+		printf("ringbuf: %d failures\n", failures);
+		return 1;
+	}
+
+	printf("ringbuf: OK\n");
+	return 0;
+}
@@ -0,0 +1,13 @@
+/*
+ * Copyright (c) 2020 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* the nor of the test is mapped at its RAM array, below 4G */
+
+#include <kernel.h>
+
+extern uint8_t host_nor[];
+
+#define CONFIG_FLASH_BASE_ADDRESS	((uint32_t)(uintptr_t)host_nor)
@@ -0,0 +1,20 @@
+/*
+ * Copyright (c) 2020 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the flash driver API, backed by the RAM nor of the test */
+
+#ifndef __HOST_DRIVERS_FLASH_H__
+#define __HOST_DRIVERS_FLASH_H__
+
+#include <kernel.h>
+#include <sys/types.h>
+
+int flash_read(const struct device *dev, off_t offset, void *data, size_t len);
+int flash_write(const struct device *dev, off_t offset, const void *data, size_t len);
+int flash_erase(const struct device *dev, off_t offset, size_t size);
+int flash_flush(const struct device *dev, bool efficient);
+
+#endif
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2020 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the kernel API used by sdfs and the OTA storage */
+
+#ifndef __HOST_KERNEL_H__
+#define __HOST_KERNEL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+
+typedef uint8_t u8_t;
+typedef uint16_t u16_t;
+typedef uint32_t u32_t;
+typedef int32_t s32_t;
+
+#ifdef HOST_LOG
+#define printk			printf
+#else
+#define printk(...)		do { } while (0)
+#endif
+
+#define __aligned(x)		__attribute__((aligned(x)))
+#define MIN(a, b)		((a) < (b) ? (a) : (b))
+#define CONTAINER_OF(ptr, type, field) \
+	((type *)(((char *)(ptr)) - offsetof(type, field)))
+
+#define K_FOREVER		(-1)
+
+/* irq lock is a mutex of the test, threads run in parallel */
+extern pthread_mutex_t host_irq_mutex;
+
+static inline unsigned int irq_lock(void)
+{
+	pthread_mutex_lock(&host_irq_mutex);
+	return 0;
+}
+
+static inline void irq_unlock(unsigned int key)
+{
+	pthread_mutex_unlock(&host_irq_mutex);
+}
+
+typedef void *k_tid_t;
+
+static inline k_tid_t k_current_get(void)
+{
+	return (k_tid_t)pthread_self();
+}
+
+#define k_malloc		malloc
+#define k_free			free
+
+struct k_mutex {
+	pthread_mutex_t mutex;
+};
+
+#define K_MUTEX_DEFINE(name) \
+	struct k_mutex name = { PTHREAD_MUTEX_INITIALIZER }
+
+static inline int k_mutex_lock(struct k_mutex *mutex, int timeout)
+{
+	return pthread_mutex_lock(&mutex->mutex);
+}
+
+static inline int k_mutex_unlock(struct k_mutex *mutex)
+{
+	return pthread_mutex_unlock(&mutex->mutex);
+}
+
+/* set by the test to run the lookups as before the kernel starts */
+extern bool host_pre_kernel;
+
+static inline bool k_is_pre_kernel(void)
+{
+	return host_pre_kernel;
+}
+
+struct k_sem {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	unsigned int count;
+	unsigned int limit;
+};
+
+static inline void k_sem_init(struct k_sem *sem, unsigned int count, unsigned int limit)
+{
+	pthread_mutex_init(&sem->mutex, NULL);
+	pthread_cond_init(&sem->cond, NULL);
+	sem->count = count;
+	sem->limit = limit;
+}
+
+static inline int k_sem_take(struct k_sem *sem, int timeout)
+{
+	pthread_mutex_lock(&sem->mutex);
+	while (!sem->count)
+		pthread_cond_wait(&sem->cond, &sem->mutex);
+	sem->count--;
+	pthread_mutex_unlock(&sem->mutex);
+	return 0;
+}
+
+static inline void k_sem_give(struct k_sem *sem)
+{
+	pthread_mutex_lock(&sem->mutex);
+	if (sem->count < sem->limit)
+		sem->count++;
+	pthread_cond_signal(&sem->cond);
+	pthread_mutex_unlock(&sem->mutex);
+}
+
+static inline void k_sem_reset(struct k_sem *sem)
+{
+	pthread_mutex_lock(&sem->mutex);
+	sem->count = 0;
+	pthread_mutex_unlock(&sem->mutex);
+}
+
+/* work queue of one thread, implemented by the test */
+struct k_work;
+typedef void (*k_work_handler_t)(struct k_work *work);
+
+struct k_work {
+	k_work_handler_t handler;
+	struct k_work *next;
+	bool pending;
+};
+
+struct k_work_q {
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	struct k_work *head;
+};
+
+static inline void k_work_init(struct k_work *work, k_work_handler_t handler)
+{
+	work->handler = handler;
+	work->next = NULL;
+	work->pending = false;
+}
+
+void k_work_queue_start(struct k_work_q *work_q, void *stack, size_t stack_size,
+		int prio, const void *cfg);
+int k_work_submit_to_queue(struct k_work_q *work_q, struct k_work *work);
+
+#define K_KERNEL_STACK_DEFINE(name, size)	char name[1]
+#define K_KERNEL_STACK_SIZEOF(name)		sizeof(name)
+#define k_thread_name_set(thread, name)		do { } while (0)
+
+struct device {
+	const char *name;
+};
+
+const struct device *device_get_binding(const char *name);
+
+/* init functions are called by the test through host_init_<fn>() */
+#define SYS_INIT(fn, level, prio) \
+	int host_init_##fn(void) { return fn(NULL); }
+
+#endif
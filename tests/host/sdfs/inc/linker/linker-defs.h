@@ -0,0 +1,14 @@
+/*
+ * Copyright (c) 2020 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* the ksdfs padded after the kernel image is a RAM array of the test */
+
+#include <kernel.h>
+
+extern uint8_t host_ksdfs[];
+
+#define __rom_region_start	host_ksdfs
+#define _flash_used		0
@@ -0,0 +1,17 @@
+/*
+ * Copyright (c) 2020 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the mem manager */
+
+#ifndef __HOST_MEM_MANAGER_H__
+#define __HOST_MEM_MANAGER_H__
+
+#include <stdlib.h>
+
+#define mem_malloc		malloc
+#define mem_free		free
+
+#endif
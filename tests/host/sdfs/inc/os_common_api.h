@@ -0,0 +1,22 @@
+/*
+ * Copyright (c) 2020 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the OS API used by the OTA storage */
+
+#ifndef __HOST_OS_COMMON_API_H__
+#define __HOST_OS_COMMON_API_H__
+
+#include <kernel.h>
+
+#ifdef HOST_LOG
+#define SYS_LOG_ERR(...)	printf(__VA_ARGS__)
+#define SYS_LOG_INF(...)	printf(__VA_ARGS__)
+#else
+#define SYS_LOG_ERR(...)	do { } while (0)
+#define SYS_LOG_INF(...)	do { } while (0)
+#endif
+
+#endif
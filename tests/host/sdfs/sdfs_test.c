@@ -0,0 +1,690 @@
+/*
+ * Copyright (c) 2020 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief Host test of the sdfs directory index and asynchronous reads
+ *
+ * sdfs images are built in a RAM nor: the ksdfs after the kernel, the
+ * memory mapped system sdfs, and sdfs partitions A and B read through the
+ * flash driver. Every lookup through the index must give the same entry as
+ * the linear search, which sdfs uses before the kernel starts. The images
+ * of partition A are then rewritten through the OTA storage, with a lookup
+ * in the middle of the write as another thread would do, and lookups after
+ * the write must find the new image.
+ *
+ * The big file of partition B is read by the sdfs read thread: callbacks
+ * which are slow or queue the next read themselves must complete before
+ * sd_fclose() returns. The benchmark reads it from a nor which takes 20us
+ * per command and 25ns per byte, as the 512 byte reads sdfs did before and
+ * as large, read ahead and asynchronous reads.
+ *
+ * Usage: sdfs_test
+ */
+
+#include <kernel.h>
+#include <sdfs.h>
+#include <ctype.h>
+#include <time.h>
+#include <unistd.h>
+#include <drivers/flash.h>
+#include <partition/partition.h>
+#include <ota_storage.h>
+
+#define NOR_SIZE		(4 << 20)
+#define SYSTEM_OFFSET		0x0
+#define SDFS_OFFSET		0x10000
+#define PART_A_OFFSET		0x100000
+#define PART_A_SIZE		0x80000
+#define PART_B_OFFSET		0x200000
+#define PART_B_SIZE		0x180000
+
+#define BIG_SIZE		(1 << 20)
+#define CHUNK			4096
+#define ASYNC_CHUNK		(16 * CHUNK)
+/* nor of the benchmark, the driver splits transfers at 32KB */
+#define NOR_CMD_US		20
+#define NOR_BYTES_PER_US	40
+#define NOR_MAX_XFER		0x8000
+
+#define SYSTEM_FILES		400
+#define PART_A_FILES		200
+#define KSDFS_FILES		8
+#define BENCH_LOOPS		100000
+
+#define ARRAY_SIZE(a)		((int)(sizeof(a) / sizeof((a)[0])))
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) \
+	do { \
+		if (!(cond)) { \
+			printf("FAIL %s:%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__); \
+			failures++; \
+		} \
+	} while (0)
+
+uint8_t host_nor[NOR_SIZE] __aligned(32);
+uint8_t host_ksdfs[0x10000] __aligned(32);
+bool host_pre_kernel;
+pthread_mutex_t host_irq_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+int host_init_sd_fs_init(void);
+int host_init_sd_read_async_init(void);
+
+static const struct device host_nor_dev = { "spi_flash" };
+static long nor_reads;
+static long nor_cmds;
+static bool nor_timing;
+
+/* called once by flash_write() after the given bytes are written */
+static void (*write_hook)(void);
+static int write_hook_at;
+
+static const struct partition_entry parts[] = {
+	{ .file_id = PARTITION_FILE_ID_SYSTEM, .offset = SYSTEM_OFFSET, .size = SDFS_OFFSET },
+	{ .file_id = PARTITION_FILE_ID_SDFS, .offset = SDFS_OFFSET, .size = 0x80000 },
+	{ .file_id = PARTITION_FILE_ID_SDFS_PART0, .offset = PART_A_OFFSET, .size = PART_A_SIZE },
+	{ .file_id = PARTITION_FILE_ID_SDFS_PART1, .offset = PART_B_OFFSET, .size = PART_B_SIZE },
+};
+
+const struct partition_entry *partition_get_part(u8_t file_id)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(parts); i++) {
+		if (parts[i].file_id == file_id)
+			return &parts[i];
+	}
+
+	return NULL;
+}
+
+const struct partition_entry *partition_get_stf_part(u8_t stor_id, u8_t file_id)
+{
+	return (stor_id == STORAGE_ID_NOR) ? partition_get_part(file_id) : NULL;
+}
+
+const struct device *device_get_binding(const char *name)
+{
+	return strcmp(name, host_nor_dev.name) ? NULL : &host_nor_dev;
+}
+
+int flash_read(const struct device *dev, off_t offset, void *data, size_t len)
+{
+	struct timespec ts;
+	size_t xfer;
+
+	if (offset < 0 || offset + len > NOR_SIZE)
+		return -EINVAL;
+
+	__atomic_add_fetch(&nor_reads, 1, __ATOMIC_RELAXED);
+
+	for (; len > 0; len -= xfer) {
+		xfer = MIN(len, NOR_MAX_XFER);
+		__atomic_add_fetch(&nor_cmds, 1, __ATOMIC_RELAXED);
+
+		/* the cpu is free while the dma transfers */
+		if (nor_timing) {
+			ts.tv_sec = 0;
+			ts.tv_nsec = (NOR_CMD_US + xfer / NOR_BYTES_PER_US) * 1000;
+			nanosleep(&ts, NULL);
+		}
+
+		memcpy(data, host_nor + offset, xfer);
+		data = (uint8_t *)data + xfer;
+		offset += xfer;
+	}
+
+	return 0;
+}
+
+/* nor programming only clears bits */
+int flash_write(const struct device *dev, off_t offset, const void *data, size_t len)
+{
+	size_t i;
+
+	if (offset < 0 || offset + len > NOR_SIZE)
+		return -EINVAL;
+
+	for (i = 0; i < len; i++)
+		host_nor[offset + i] &= ((const uint8_t *)data)[i];
+
+	if (write_hook && (write_hook_at -= len) <= 0) {
+		void (*hook)(void) = write_hook;
+
+		write_hook = NULL;
+		hook();
+	}
+
+	return 0;
+}
+
+int flash_erase(const struct device *dev, off_t offset, size_t size)
+{
+	if (offset < 0 || offset + size > NOR_SIZE || (offset | size) & 0xfff)
+		return -EINVAL;
+
+	memset(host_nor + offset, 0xff, size);
+	return 0;
+}
+
+int flash_flush(const struct device *dev, bool efficient)
+{
+	return 0;
+}
+
+static void *work_q_thread(void *arg)
+{
+	struct k_work_q *work_q = arg;
+	struct k_work *work;
+
+	for (;;) {
+		pthread_mutex_lock(&work_q->mutex);
+		while (!work_q->head)
+			pthread_cond_wait(&work_q->cond, &work_q->mutex);
+
+		work = work_q->head;
+		work_q->head = work->next;
+		work->pending = false;
+		pthread_mutex_unlock(&work_q->mutex);
+
+		work->handler(work);
+	}
+
+	return NULL;
+}
+
+void k_work_queue_start(struct k_work_q *work_q, void *stack, size_t stack_size,
+		int prio, const void *cfg)
+{
+	pthread_mutex_init(&work_q->mutex, NULL);
+	pthread_cond_init(&work_q->cond, NULL);
+	work_q->head = NULL;
+	pthread_create(&work_q->thread, NULL, work_q_thread, work_q);
+}
+
+/* as the kernel, work may be submitted again while its handler runs */
+int k_work_submit_to_queue(struct k_work_q *work_q, struct k_work *work)
+{
+	struct k_work **tail;
+
+	pthread_mutex_lock(&work_q->mutex);
+
+	if (!work->pending) {
+		for (tail = &work_q->head; *tail; tail = &(*tail)->next)
+			;
+		work->next = NULL;
+		work->pending = true;
+		*tail = work;
+		pthread_cond_signal(&work_q->cond);
+	}
+
+	pthread_mutex_unlock(&work_q->mutex);
+	return 0;
+}
+
+struct image {
+	int num;
+	char names[SYSTEM_FILES][13];
+	int sizes[SYSTEM_FILES];
+};
+
+static struct image ksdfs_img, system_img, part_a_img, part_a_new_img, part_b_img;
+
+static void make_names(struct image *img, int num, unsigned int seed)
+{
+	static const char *const exts[] = { ".PCM", ".ACT", ".RES", "" };
+	int i, k, len;
+
+	srand(seed);
+	img->num = num;
+
+	for (i = 0; i < num; i++) {
+		len = 3 + rand() % 6;
+		for (k = 0; k < len; k++)
+			img->names[i][k] = 'A' + rand() % 26;
+		img->names[i][k] = 0;
+		strcat(img->names[i], exts[i % 4]);
+		img->sizes[i] = 16 + rand() % 200;
+	}
+
+	/* names of 12 chars have no terminator, duplicates are found first */
+	strcpy(img->names[num - 1], "LONGNAME.BIN");
+	strcpy(img->names[num - 2], img->names[1]);
+}
+
+/* file data is made of the entry number and the offset in the file */
+static uint8_t file_byte(int num, int offs)
+{
+	return num * 7 + offs + (offs >> 8) * 3 + (offs >> 16);
+}
+
+/* returns the image size */
+static int build_image(uint8_t *buf, const struct image *img)
+{
+	struct sd_dir *dir = (struct sd_dir *)buf;
+	int offs = (img->num + 1) * sizeof(*dir);
+	int i, k;
+
+	memset(buf, 0, offs);
+	memcpy((void *)dir->fname, "sdfs.bin", 8);
+	dir->offset = img->num;
+
+	for (i = 0; i < img->num; i++) {
+		dir = (struct sd_dir *)buf + i + 1;
+		memcpy((void *)dir->fname, img->names[i], strnlen(img->names[i], 12));
+		dir->offset = offs;
+		dir->size = img->sizes[i];
+
+		for (k = 0; k < dir->size; k++)
+			buf[offs + k] = file_byte(i, k);
+		offs += (dir->size + 3) & ~3;
+	}
+
+	return offs;
+}
+
+static int find_name(const struct image *img, const char *name)
+{
+	int i;
+
+	for (i = 0; i < img->num; i++) {
+		if (!strcmp(img->names[i], name))
+			return i;
+	}
+
+	return -1;
+}
+
+static void lower(char *dst, const char *src)
+{
+	while ((*dst++ = tolower((unsigned char)*src++)))
+		;
+}
+
+/* open the file through the index and the linear search, they must agree */
+static struct sd_file *check_open(const char *path)
+{
+	struct sd_file *f, *ref;
+
+	host_pre_kernel = true;
+	ref = sd_fopen(path);
+	host_pre_kernel = false;
+
+	f = sd_fopen(path);
+	CHECK(!f == !ref, "%s: found %d, linear %d", path, !!f, !!ref);
+
+	if (f && ref) {
+		CHECK(f->start == ref->start && f->size == ref->size,
+		      "%s: %x/%d, linear %x/%d", path, f->start, f->size, ref->start, ref->size);
+	}
+
+	if (ref)
+		sd_fclose(ref);
+
+	return f;
+}
+
+/* the file is found with the first entry of its name, check its data */
+static void check_file(const char *prefix, const struct image *img, int num)
+{
+	char path[32], name[13];
+	uint8_t data[8];
+	struct sd_file *f;
+	int first, k, len;
+
+	first = find_name(img, img->names[num]);
+
+	lower(name, img->names[num]);
+	snprintf(path, sizeof(path), "%s%s", prefix, name);
+
+	f = check_open(path);
+	CHECK(f, "%s not found", path);
+	if (!f)
+		return;
+
+	CHECK(f->size == img->sizes[first], "%s size %d", path, f->size);
+
+	len = sd_fread(f, data, sizeof(data));
+	for (k = 0; k < len; k++)
+		CHECK(data[k] == file_byte(first, k), "%s data", path);
+
+	sd_fclose(f);
+}
+
+static void test_lookup(void)
+{
+	static const char *const misses[] = {
+		"nofile.xyz", "/NOR:A/nofile.xyz", "/NOR:B/longname.bin", "/NOR:A/",
+	};
+	struct sd_file *f;
+	char path[40];
+	int i;
+
+	for (i = 0; i < ksdfs_img.num; i++)
+		check_file("", &ksdfs_img, i);
+
+	/* names of ksdfs are found there first */
+	for (i = 0; i < system_img.num; i++) {
+		if (find_name(&ksdfs_img, system_img.names[i]) < 0)
+			check_file("", &system_img, i);
+		else
+			check_file("", &ksdfs_img, find_name(&ksdfs_img, system_img.names[i]));
+	}
+
+	for (i = 0; i < part_a_img.num; i++)
+		check_file("/NOR:A/", &part_a_img, i);
+
+	for (i = 0; i < ARRAY_SIZE(misses); i++) {
+		f = check_open(misses[i]);
+		CHECK(!f, "%s found", misses[i]);
+		if (f)
+			sd_fclose(f);
+	}
+
+	/* only the first 12 chars are compared */
+	f = check_open("/NOR:A/longname.binextra");
+	CHECK(f, "12 chars prefix not found");
+	if (f)
+		sd_fclose(f);
+
+	snprintf(path, sizeof(path), "/NOR:A/%s", part_a_img.names[3]);
+	CHECK(sd_fsize(path) == part_a_img.sizes[3], "sd_fsize %s", path);
+}
+
+static double now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static void bench_lookup(const char *prefix, const struct image *img)
+{
+	char path[SYSTEM_FILES][32];
+	double t[2];
+	long reads[2];
+	int i, linear;
+
+	for (i = 0; i < img->num; i++)
+		snprintf(path[i], sizeof(path[i]), "%s%s", prefix, img->names[i]);
+
+	for (linear = 0; linear < 2; linear++) {
+		host_pre_kernel = linear;
+		reads[linear] = nor_reads;
+		t[linear] = now_ns();
+
+		for (i = 0; i < BENCH_LOOPS; i++)
+			sd_fsize(path[i % img->num]);
+
+		t[linear] = (now_ns() - t[linear]) / BENCH_LOOPS;
+		reads[linear] = nor_reads - reads[linear];
+	}
+
+	host_pre_kernel = false;
+
+	printf("%-8s %d files: index %.0f ns, %.2f nor reads; linear %.0f ns, %.2f nor reads\n",
+	       prefix[0] ? prefix : "system", img->num, t[0], (double)reads[0] / BENCH_LOOPS,
+	       t[1], (double)reads[1] / BENCH_LOOPS);
+}
+
+static void lookup_during_write(void)
+{
+	char path[32];
+
+	/* builds the index of partition A from the half written image */
+	snprintf(path, sizeof(path), "/NOR:A/%s", part_a_new_img.names[0]);
+	sd_fsize(path);
+}
+
+static void test_ota_rewrite(void)
+{
+	static uint8_t buf[PART_A_SIZE];
+	struct ota_storage *storage;
+	char path[32];
+	int i, len;
+
+	storage = ota_storage_init("spi_flash");
+	CHECK(storage, "ota storage init");
+	if (!storage)
+		return;
+
+	/* index of the old image */
+	check_file("/NOR:A/", &part_a_img, 0);
+
+	make_names(&part_a_new_img, PART_A_FILES - 50, 11);
+	len = build_image(buf, &part_a_new_img);
+
+	CHECK(!ota_storage_erase(storage, PART_A_OFFSET, PART_A_SIZE), "erase");
+
+	write_hook = lookup_during_write;
+	write_hook_at = (part_a_new_img.num / 2) * sizeof(struct sd_dir);
+	CHECK(!ota_storage_write(storage, PART_A_OFFSET, buf, len), "write");
+	CHECK(!write_hook, "no lookup during the write");
+
+	for (i = 0; i < part_a_new_img.num; i++)
+		check_file("/NOR:A/", &part_a_new_img, i);
+
+	for (i = 0; i < part_a_img.num; i++) {
+		if (find_name(&part_a_new_img, part_a_img.names[i]) < 0) {
+			snprintf(path, sizeof(path), "/NOR:A/%s", part_a_img.names[i]);
+			CHECK(sd_fsize(path) < 0, "old file %s found", path);
+		}
+	}
+
+	ota_storage_exit(storage);
+}
+
+static uint8_t big_buf[BIG_SIZE];
+
+static bool check_big(const char *what)
+{
+	int k;
+
+	for (k = 0; k < BIG_SIZE; k++) {
+		if (big_buf[k] != file_byte(0, k)) {
+			CHECK(0, "%s: data at %d", what, k);
+			return false;
+		}
+	}
+
+	memset(big_buf, 0, sizeof(big_buf));
+	return true;
+}
+
+struct async_ctx {
+	int done;
+	int len;
+	int pos;
+	int delay_us;
+	bool chain;
+};
+
+static void async_cb(struct sd_file *sd_file, void *buffer, int len, void *user_data)
+{
+	struct async_ctx *ctx = user_data;
+
+	if (ctx->delay_us)
+		usleep(ctx->delay_us);
+
+	ctx->len += len;
+	ctx->pos += (len > 0) ? len : 0;
+
+	/* queue the next read from the read thread */
+	if (ctx->chain && len > 0 && ctx->pos < BIG_SIZE)
+		sd_fread_async(sd_file, big_buf + ctx->pos, ASYNC_CHUNK, async_cb, ctx);
+
+	ctx->done++;
+}
+
+static void test_async(void)
+{
+	struct async_ctx ctx;
+	struct sd_file *f;
+	long reads;
+	int i, pos, len;
+
+	/* requests of one file are served in order */
+	f = sd_fopen("/NOR:B/res.bin");
+	CHECK(f && f->size == BIG_SIZE, "open big file");
+	if (!f)
+		return;
+
+	memset(&ctx, 0, sizeof(ctx));
+	for (pos = 0; pos < BIG_SIZE; pos += ASYNC_CHUNK)
+		sd_fread_async(f, big_buf + pos, ASYNC_CHUNK, async_cb, &ctx);
+	CHECK(sd_fread_async(f, big_buf, ASYNC_CHUNK, async_cb, &ctx) == 0, "read at end");
+	sd_fclose(f);
+	CHECK(ctx.done == BIG_SIZE / ASYNC_CHUNK && ctx.len == BIG_SIZE,
+	      "%d callbacks, %d bytes", ctx.done, ctx.len);
+	check_big("async");
+
+	/* the slow callback of the last request returns before close */
+	for (i = 0; i < 100; i++) {
+		f = sd_fopen("/NOR:B/res.bin");
+		memset(&ctx, 0, sizeof(ctx));
+		ctx.delay_us = 200;
+		sd_fread_async(f, big_buf, CHUNK, async_cb, &ctx);
+		sd_fclose(f);
+		CHECK(ctx.done == 1, "closed in callback");
+		if (failures)
+			return;
+	}
+
+	/* callbacks which queue the next read, close waits the whole chain */
+	for (i = 0; i < 20; i++) {
+		f = sd_fopen("/NOR:B/res.bin");
+		memset(&ctx, 0, sizeof(ctx));
+		ctx.chain = true;
+		ctx.delay_us = i & 1;
+		sd_fread_async(f, big_buf, ASYNC_CHUNK, async_cb, &ctx);
+		sd_fclose(f);
+		CHECK(ctx.done == BIG_SIZE / ASYNC_CHUNK && ctx.pos == BIG_SIZE,
+		      "chain closed after %d callbacks", ctx.done);
+		if (!check_big("chain"))
+			return;
+	}
+
+	/* reads are served from the read ahead buffer */
+	f = sd_fopen("/NOR:B/res.bin");
+	reads = nor_reads;
+	CHECK(sd_fread_hint(f, CHUNK) == CHUNK, "hint");
+	for (pos = 0; pos < BIG_SIZE; pos += len) {
+		len = sd_fread(f, big_buf + pos, CHUNK);
+		CHECK(len == CHUNK, "read %d", len);
+		if (len != CHUNK)
+			break;
+		sd_fread_hint(f, CHUNK);
+	}
+	sd_fclose(f);
+	CHECK(nor_reads - reads == BIG_SIZE / CHUNK, "%ld nor reads", nor_reads - reads);
+	check_big("read ahead");
+}
+
+/* decoding a chunk takes the cpu */
+static void spin_us(int us)
+{
+	double end = now_ns() + us * 1000.0;
+
+	while (now_ns() < end)
+		;
+}
+
+static void bench_read(void)
+{
+	struct sd_file *f;
+	double t;
+	long cmds;
+	int pos, k, len;
+
+	nor_timing = true;
+	f = sd_fopen("/NOR:B/res.bin");
+
+	/* sdfs read partitions 512 bytes at a time before */
+	cmds = nor_cmds;
+	t = now_ns();
+	for (pos = 0; pos < BIG_SIZE; pos += 512)
+		flash_read(&host_nor_dev, f->start + pos, big_buf + pos, 512);
+	t = now_ns() - t;
+	check_big("512B reads");
+	printf("512B reads: %.1f MB/s, %ld nor commands\n", BIG_SIZE * 1e3 / t, nor_cmds - cmds);
+
+	sd_fseek(f, 0, FS_SEEK_SET);
+	cmds = nor_cmds;
+	t = now_ns();
+	for (pos = 0; pos < BIG_SIZE; pos += CHUNK)
+		sd_fread(f, big_buf + pos, CHUNK);
+	t = now_ns() - t;
+	check_big("4KB reads");
+	printf("4KB reads: %.1f MB/s, %ld nor commands\n", BIG_SIZE * 1e3 / t, nor_cmds - cmds);
+
+	for (k = 0; k < 2; k++) {
+		sd_fseek(f, 0, FS_SEEK_SET);
+		t = now_ns();
+		if (k)
+			sd_fread_hint(f, CHUNK);
+		for (pos = 0; pos < BIG_SIZE; pos += CHUNK) {
+			sd_fread(f, big_buf + pos, CHUNK);
+			if (k)
+				sd_fread_hint(f, CHUNK);
+			spin_us(100);
+		}
+		t = now_ns() - t;
+		check_big("read and decode");
+		printf("4KB read and 100us decode%s: %.1f ms\n", k ? " with read ahead" : "", t / 1e6);
+	}
+
+	sd_fseek(f, 0, FS_SEEK_SET);
+	t = now_ns();
+	for (pos = 0; pos < BIG_SIZE; pos += len)
+		len = sd_fread_async(f, big_buf + pos, ASYNC_CHUNK, NULL, NULL);
+	sd_fclose(f);
+	t = now_ns() - t;
+	check_big("async");
+	printf("64KB async reads: %.1f MB/s\n", BIG_SIZE * 1e3 / t);
+
+	nor_timing = false;
+}
+
+int main(void)
+{
+	memset(host_nor, 0xff, sizeof(host_nor));
+
+	make_names(&ksdfs_img, KSDFS_FILES, 1);
+	make_names(&system_img, SYSTEM_FILES, 2);
+	make_names(&part_a_img, PART_A_FILES, 3);
+	/* a ksdfs file shadows the system one */
+	strcpy(ksdfs_img.names[2], system_img.names[4]);
+
+	build_image(host_ksdfs, &ksdfs_img);
+	build_image(host_nor + SDFS_OFFSET, &system_img);
+	build_image(host_nor + PART_A_OFFSET, &part_a_img);
+
+	part_b_img.num = 1;
+	strcpy(part_b_img.names[0], "RES.BIN");
+	part_b_img.sizes[0] = BIG_SIZE;
+	build_image(host_nor + PART_B_OFFSET, &part_b_img);
+
+	CHECK(!host_init_sd_fs_init(), "sdfs init");
+	CHECK(!host_init_sd_read_async_init(), "sdfs read thread init");
+
+	test_lookup();
+	bench_lookup("", &system_img);
+	bench_lookup("/NOR:A/", &part_a_img);
+	test_ota_rewrite();
+	test_async();
+	bench_read();
+
+	if (failures) {
+		printf("sdfs: %d failures\n", failures);
+		return 1;
+	}
+
+	printf("sdfs: OK\n");
+	return 0;
+}
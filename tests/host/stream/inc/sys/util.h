@@ -0,0 +1,14 @@
+/* host stub of the zephyr utilities used by the streams */
+
+#ifndef __HOST_SYS_UTIL_H__
+#define __HOST_SYS_UTIL_H__
+
+#include <stdint.h>
+
+#define __aligned(x)		__attribute__((aligned(x)))
+#define BIT(n)			(1UL << (n))
+#define ARRAY_SIZE(array)	(sizeof(array) / sizeof((array)[0]))
+#define MIN(a, b)		((a) < (b) ? (a) : (b))
+#define MAX(a, b)		((a) > (b) ? (a) : (b))
+
+#endif
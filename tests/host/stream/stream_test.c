@@ -0,0 +1,812 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief test and benchmark of the blocked readers and writers of streams
+ *
+ * stream.c is built with an in memory ring stream whose length and space
+ * come from its own ops, os_sem_take() counts its returns per thread.
+ *
+ * A writer thread writes chunks at a fixed period while a reader thread
+ * blocks in stream_read() for a larger length. This is run through the
+ * stream API, and again through the blocking read of stream.c before the
+ * wakeup on threshold, which is rebuilt in the test: it polled sync_sem
+ * every 50 ms and every read and write gave the sem. Reported are the sem
+ * takes per read and the latency from the write which completes a read to
+ * the return of the read. Each read must take the sem at most once and be
+ * no slower than with the old poll. Data put in the ring directly, past
+ * the stream API, must be seen within CONFIG_STREAM_BLOCK_RECHECK_MS.
+ *
+ * Then a writer blocked for space must be woken once by a reader of small
+ * chunks, MODE_BLOCK_TIMEOUT must give up at the 1 s deadline for a reader
+ * without writer, for a reader of a writer which trickles (the old loop
+ * counted 20 wakeups instead) and for a writer without reader,
+ * stream_wait_length() must wait for a length without reading it, and
+ * stream_close() must wake a blocked reader and writer alike.
+ *
+ * Usage: stream_test [reads per run, default 100]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <os_common_api.h>
+#include <stream.h>
+
+#define RING_SIZE	8192
+#define MAX_READS	1000
+#define OLD_POLL_MS	50
+#define TIMEOUT_MS	1000
+/* the deadline is kept on the ms uptime */
+#define UPTIME_SLACK_MS	2
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) \
+	do { \
+		if (!(cond)) { \
+			if (failures++ < 20) \
+				printf("FAIL %s:%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__); \
+		} \
+	} while (0)
+
+/* returns of os_sem_take() of the calling thread */
+static __thread unsigned int sem_takes;
+
+/* OS and memory stubs */
+void os_sem_init(os_sem *sem, int count, int limit)
+{
+	pthread_mutex_init(&sem->mutex, NULL);
+	pthread_cond_init(&sem->cond, NULL);
+	sem->count = count;
+	sem->limit = limit;
+}
+
+int os_sem_take(os_sem *sem, int timeout)
+{
+	struct timespec ts;
+	int res = 0;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	if (timeout > 0) {
+		ts.tv_sec += timeout / 1000;
+		ts.tv_nsec += (timeout % 1000) * 1000000L;
+		if (ts.tv_nsec >= 1000000000L) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000L;
+		}
+	}
+
+	pthread_mutex_lock(&sem->mutex);
+	while (sem->count == 0 && !res) {
+		if (timeout == OS_FOREVER)
+			pthread_cond_wait(&sem->cond, &sem->mutex);
+		else if (timeout == OS_NO_WAIT || pthread_cond_timedwait(&sem->cond, &sem->mutex, &ts))
+			res = -EAGAIN;
+	}
+	if (!res)
+		sem->count--;
+	pthread_mutex_unlock(&sem->mutex);
+
+	sem_takes++;
+	return res;
+}
+
+void os_sem_give(os_sem *sem)
+{
+	pthread_mutex_lock(&sem->mutex);
+	if (sem->count < sem->limit)
+		sem->count++;
+	pthread_cond_signal(&sem->cond);
+	pthread_mutex_unlock(&sem->mutex);
+}
+
+void os_sem_reset(os_sem *sem)
+{
+	pthread_mutex_lock(&sem->mutex);
+	sem->count = 0;
+	pthread_mutex_unlock(&sem->mutex);
+}
+
+uint32_t os_uptime_get_32(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+void *mem_malloc(int size)
+{
+	return calloc(1, size);
+}
+
+void mem_free(void *ptr)
+{
+	free(ptr);
+}
+
+static uint64_t now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000ull + ts.tv_nsec / 1000;
+}
+
+static void sleep_until(uint64_t due_us)
+{
+	uint64_t now = now_us();
+
+	if (due_us > now)
+		usleep(due_us - now);
+}
+
+/* in memory ring stream, one reader and one writer thread */
+struct mem_ring {
+	uint8_t buf[RING_SIZE];
+	uint32_t size;
+	uint32_t wofs;
+	uint32_t rofs;
+};
+
+static uint32_t mem_ring_length(struct mem_ring *ring)
+{
+	return __atomic_load_n(&ring->wofs, __ATOMIC_ACQUIRE) -
+		__atomic_load_n(&ring->rofs, __ATOMIC_ACQUIRE);
+}
+
+/* write to the ring past the stream API, nobody is woken */
+static void mem_ring_put(struct mem_ring *ring, const uint8_t *buf, uint32_t num)
+{
+	uint32_t i;
+
+	for (i = 0; i < num; i++)
+		ring->buf[(ring->wofs + i) % ring->size] = buf[i];
+	__atomic_store_n(&ring->wofs, ring->wofs + num, __ATOMIC_RELEASE);
+}
+
+static int mem_init(io_stream_t handle, void *param)
+{
+	struct mem_ring *ring = param;
+
+	handle->data = ring;
+	handle->total_size = ring->size;
+	return 0;
+}
+
+static int mem_open(io_stream_t handle, stream_mode mode)
+{
+	return 0;
+}
+
+static int mem_read(io_stream_t handle, unsigned char *buf, int num)
+{
+	struct mem_ring *ring = handle->data;
+	uint32_t len = mem_ring_length(ring), i;
+
+	if (num > len)
+		num = len;
+
+	for (i = 0; i < num; i++)
+		buf[i] = ring->buf[(ring->rofs + i) % ring->size];
+	__atomic_store_n(&ring->rofs, ring->rofs + num, __ATOMIC_RELEASE);
+
+	return num;
+}
+
+static int mem_write(io_stream_t handle, unsigned char *buf, int num)
+{
+	struct mem_ring *ring = handle->data;
+
+	if (num > ring->size - mem_ring_length(ring))
+		return 0;
+
+	mem_ring_put(ring, buf, num);
+	return num;
+}
+
+static int mem_get_length(io_stream_t handle)
+{
+	return mem_ring_length(handle->data);
+}
+
+static int mem_get_space(io_stream_t handle)
+{
+	struct mem_ring *ring = handle->data;
+
+	return ring->size - mem_ring_length(ring);
+}
+
+static int mem_close(io_stream_t handle)
+{
+	return 0;
+}
+
+static const stream_ops_t mem_ops = {
+	.init = mem_init,
+	.open = mem_open,
+	.read = mem_read,
+	.write = mem_write,
+	.get_length = mem_get_length,
+	.get_space = mem_get_space,
+	.close = mem_close,
+};
+
+static io_stream_t mem_stream(struct mem_ring *ring, uint32_t size, int mode)
+{
+	io_stream_t handle;
+
+	ring->size = size;
+	ring->wofs = 0;
+	ring->rofs = 0;
+
+	handle = stream_create(&mem_ops, ring);
+	CHECK(handle && !stream_open(handle, mode), "mem stream not opened");
+	return handle;
+}
+
+static uint8_t seq_byte(uint32_t ofs)
+{
+	return ofs * 7 + (ofs >> 8);
+}
+
+static void fill_seq(uint8_t *buf, uint32_t ofs, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+		buf[i] = seq_byte(ofs + i);
+}
+
+static int check_seq(const uint8_t *buf, uint32_t ofs, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++) {
+		if (buf[i] != seq_byte(ofs + i))
+			return 0;
+	}
+
+	return 1;
+}
+
+/*
+ * Blocking read and write of stream.c before the wakeup on threshold:
+ * the reader polls sync_sem every 50 ms, gives up after 20 polls with
+ * MODE_BLOCK_TIMEOUT, and every read and write gives sync_sem.
+ */
+static int old_stream_read(io_stream_t handle, void *buf, int num)
+{
+	int try_cnt = 0;
+	int brw;
+
+	while (stream_get_length(handle) < num) {
+		if ((handle->mode & MODE_BLOCK_TIMEOUT)) {
+			if (try_cnt++ > 20) {
+				handle->write_finished = 1;
+				return 0;
+			}
+		}
+		os_sem_take(handle->sync_sem, OLD_POLL_MS);
+		if (handle->state != STATE_OPEN)
+			return -ENOSYS;
+		if (handle->write_finished)
+			break;
+	}
+
+	brw = handle->ops->read(handle, buf, num);
+	os_sem_give(handle->sync_sem);
+	return brw;
+}
+
+static int old_stream_write(io_stream_t handle, const void *buf, int num)
+{
+	int brw = stream_write(handle, buf, num);
+
+	os_sem_give(handle->sync_sem);
+	return brw;
+}
+
+/* reader and writer threads of a run */
+struct run {
+	io_stream_t handle;
+	bool old;
+	int chunk;
+	int period_us;
+	int want;
+	int reads;
+	/* time the write which completes each read is started */
+	uint64_t ready_us[MAX_READS];
+	unsigned int takes;
+	uint64_t latency_us;
+	uint64_t max_latency_us;
+};
+
+static void *run_writer(void *arg)
+{
+	struct run *run = arg;
+	uint32_t total = run->want * run->reads, written = 0, k;
+	uint64_t due_us = now_us();
+	uint8_t buf[RING_SIZE];
+	int len, ret;
+
+	while (written < total) {
+		due_us += run->period_us;
+		sleep_until(due_us);
+
+		len = run->chunk;
+		if (len > total - written)
+			len = total - written;
+		fill_seq(buf, written, len);
+
+		for (k = written / run->want; k < run->reads && (k + 1) * run->want <= written + len; k++) {
+			if ((k + 1) * run->want > written)
+				run->ready_us[k] = now_us();
+		}
+
+		if (run->old)
+			ret = old_stream_write(run->handle, buf, len);
+		else
+			ret = stream_write(run->handle, buf, len);
+		CHECK(ret == len, "write of %d returned %d", len, ret);
+		written += len;
+	}
+
+	return NULL;
+}
+
+static void *run_reader(void *arg)
+{
+	struct run *run = arg;
+	uint8_t buf[RING_SIZE];
+	uint64_t latency;
+	int k, ret;
+
+	sem_takes = 0;
+
+	for (k = 0; k < run->reads; k++) {
+		if (run->old)
+			ret = old_stream_read(run->handle, buf, run->want);
+		else
+			ret = stream_read(run->handle, buf, run->want);
+		latency = now_us() - run->ready_us[k];
+
+		CHECK(ret == run->want, "read %d of %d returned %d", k, run->want, ret);
+		CHECK(check_seq(buf, k * run->want, run->want), "read %d data differs", k);
+
+		run->latency_us += latency;
+		if (latency > run->max_latency_us)
+			run->max_latency_us = latency;
+	}
+
+	run->takes = sem_takes;
+	return NULL;
+}
+
+static void run_stream(struct run *run)
+{
+	static struct mem_ring ring;
+	pthread_t reader, writer;
+
+	run->handle = mem_stream(&ring, RING_SIZE, MODE_IN_OUT | MODE_READ_BLOCK);
+	run->takes = 0;
+	run->latency_us = 0;
+	run->max_latency_us = 0;
+	memset(run->ready_us, 0, sizeof(run->ready_us));
+
+	pthread_create(&reader, NULL, run_reader, run);
+	pthread_create(&writer, NULL, run_writer, run);
+	pthread_join(writer, NULL);
+	pthread_join(reader, NULL);
+
+	stream_close(run->handle);
+	stream_destroy(run->handle);
+}
+
+static void test_reader_wakeup(int reads)
+{
+	static const struct {
+		int chunk;
+		int period_us;
+		int want;
+	} cases[] = {
+		{ 64, 1000, 512 },
+		{ 16, 200, 1024 },
+		{ 512, 2000, 512 },
+	};
+	static struct run old_run, new_run;
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(cases); i++) {
+		old_run.chunk = new_run.chunk = cases[i].chunk;
+		old_run.period_us = new_run.period_us = cases[i].period_us;
+		old_run.want = new_run.want = cases[i].want;
+		old_run.reads = new_run.reads = reads;
+		old_run.old = true;
+		new_run.old = false;
+
+		run_stream(&old_run);
+		run_stream(&new_run);
+
+		printf("%d B every %d us, read %d B: sem takes/read old %.2f new %.2f, "
+		       "latency mean/max old %llu/%llu us new %llu/%llu us\n",
+		       cases[i].chunk, cases[i].period_us, cases[i].want,
+		       (double)old_run.takes / reads, (double)new_run.takes / reads,
+		       (unsigned long long)(old_run.latency_us / reads),
+		       (unsigned long long)old_run.max_latency_us,
+		       (unsigned long long)(new_run.latency_us / reads),
+		       (unsigned long long)new_run.max_latency_us);
+
+		CHECK(new_run.takes <= reads, "%u sem takes for %d reads", new_run.takes, reads);
+		CHECK(new_run.latency_us / reads <= old_run.latency_us / reads + 1000,
+		      "mean latency %llu us, old poll %llu us",
+		      (unsigned long long)(new_run.latency_us / reads),
+		      (unsigned long long)(old_run.latency_us / reads));
+		CHECK(new_run.max_latency_us < OLD_POLL_MS * 1000, "max latency %llu us",
+		      (unsigned long long)new_run.max_latency_us);
+	}
+}
+
+/* blocked call of a helper thread */
+struct blocked {
+	io_stream_t handle;
+	int len;
+	/* 1 for stream_write, 2 for stream_wait_length, else stream_read */
+	int op;
+	int timeout;
+	int ret;
+	unsigned int takes;
+	uint64_t done_us;
+	int done;
+};
+
+static void *blocked_thread(void *arg)
+{
+	struct blocked *call = arg;
+	uint8_t buf[RING_SIZE];
+
+	sem_takes = 0;
+	fill_seq(buf, 0, call->len);
+
+	if (call->op == 1)
+		call->ret = stream_write(call->handle, buf, call->len);
+	else if (call->op == 2)
+		call->ret = stream_wait_length(call->handle, call->len, call->timeout);
+	else
+		call->ret = stream_read(call->handle, buf, call->len);
+
+	call->takes = sem_takes;
+	call->done_us = now_us();
+	__atomic_store_n(&call->done, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+static void blocked_start(struct blocked *call, pthread_t *thread, io_stream_t handle,
+			  int op, int len)
+{
+	memset(call, 0, sizeof(*call));
+	call->handle = handle;
+	call->op = op;
+	call->len = len;
+	call->timeout = OS_FOREVER;
+	pthread_create(thread, NULL, blocked_thread, call);
+}
+
+static int blocked_done(struct blocked *call)
+{
+	return __atomic_load_n(&call->done, __ATOMIC_ACQUIRE);
+}
+
+static void test_direct_ring(void)
+{
+	static struct mem_ring ring;
+	struct blocked call;
+	pthread_t thread;
+	uint8_t buf[256];
+	uint64_t put_us;
+	io_stream_t handle;
+
+	handle = mem_stream(&ring, RING_SIZE, MODE_IN_OUT | MODE_READ_BLOCK);
+	blocked_start(&call, &thread, handle, 0, sizeof(buf));
+
+	usleep(20000);
+	fill_seq(buf, 0, sizeof(buf));
+	put_us = now_us();
+	mem_ring_put(&ring, buf, sizeof(buf));
+	pthread_join(thread, NULL);
+
+	printf("data put in the ring directly: read after %llu ms, %u sem takes\n",
+	       (unsigned long long)(call.done_us - put_us) / 1000, call.takes);
+
+	CHECK(call.ret == sizeof(buf), "read returned %d", call.ret);
+	CHECK(call.done_us - put_us <= (CONFIG_STREAM_BLOCK_RECHECK_MS + 30) * 1000,
+	      "read after %llu us", (unsigned long long)(call.done_us - put_us));
+
+	stream_close(handle);
+	stream_destroy(handle);
+}
+
+static void test_writer_wakeup(void)
+{
+	static struct mem_ring ring;
+	uint8_t buf[4000];
+	struct blocked call;
+	pthread_t thread;
+	uint64_t freed_us = 0;
+	io_stream_t handle;
+	int reads = 0, ret;
+
+	handle = mem_stream(&ring, 4096, MODE_IN_OUT | MODE_READ_BLOCK | MODE_WRITE_BLOCK);
+	fill_seq(buf, 0, sizeof(buf));
+	stream_write(handle, buf, sizeof(buf));
+
+	/* 96 bytes are free, the writer needs 3000 */
+	blocked_start(&call, &thread, handle, 1, 3000);
+	usleep(10000);
+	CHECK(!blocked_done(&call), "writer not blocked");
+
+	while (!blocked_done(&call) && reads < 40) {
+		if (stream_get_space(handle) + 100 >= 3000)
+			freed_us = now_us();
+		ret = stream_read(handle, buf, 100);
+		CHECK(ret == 100 && check_seq(buf, reads * 100, 100), "read %d returned %d",
+		      reads, ret);
+		reads++;
+		usleep(1000);
+	}
+	pthread_join(thread, NULL);
+
+	printf("writer blocked for 3000 B of space: woken after %d reads of 100 B, "
+	       "%u sem takes, latency %llu us\n", reads, call.takes,
+	       (unsigned long long)(call.done_us - freed_us));
+
+	CHECK(call.ret == 3000, "write returned %d", call.ret);
+	CHECK(reads == 30, "writer done after %d reads", reads);
+	CHECK(call.takes == 1, "writer took the sem %u times", call.takes);
+
+	stream_close(handle);
+	stream_destroy(handle);
+}
+
+static bool trickle_old;
+
+static void *trickle_writer(void *arg)
+{
+	io_stream_t handle = arg;
+	uint8_t byte = 0;
+	int i;
+
+	for (i = 0; i < TIMEOUT_MS / 20 + 10; i++) {
+		usleep(20000);
+		if (handle->write_finished)
+			break;
+		if (trickle_old)
+			old_stream_write(handle, &byte, 1);
+		else
+			stream_write(handle, &byte, 1);
+	}
+
+	return NULL;
+}
+
+static void test_timeout(void)
+{
+	static struct mem_ring ring;
+	uint8_t buf[1000];
+	unsigned int takes;
+	pthread_t thread;
+	uint64_t start_us, elapsed_ms;
+	io_stream_t handle;
+	int ret, old;
+
+	/* reader without writer */
+	handle = mem_stream(&ring, RING_SIZE, MODE_IN_OUT | MODE_READ_BLOCK | MODE_BLOCK_TIMEOUT);
+	sem_takes = 0;
+	start_us = now_us();
+	ret = stream_read(handle, buf, 100);
+	elapsed_ms = (now_us() - start_us) / 1000;
+	takes = sem_takes;
+	stream_close(handle);
+	stream_destroy(handle);
+
+	printf("timeout of a reader without writer: %llu ms, %u sem takes\n",
+	       (unsigned long long)elapsed_ms, takes);
+
+	CHECK(ret == 0, "read returned %d", ret);
+	CHECK(elapsed_ms + UPTIME_SLACK_MS >= TIMEOUT_MS && elapsed_ms < TIMEOUT_MS + 200, "timeout after %llu ms",
+	      (unsigned long long)elapsed_ms);
+	CHECK(takes <= TIMEOUT_MS / CONFIG_STREAM_BLOCK_RECHECK_MS + 1, "%u sem takes", takes);
+
+	/* reader of a writer which trickles 1 byte every 20 ms */
+	for (old = 1; old >= 0; old--) {
+		handle = mem_stream(&ring, RING_SIZE,
+				    MODE_IN_OUT | MODE_READ_BLOCK | MODE_BLOCK_TIMEOUT);
+		trickle_old = old;
+		pthread_create(&thread, NULL, trickle_writer, handle);
+
+		sem_takes = 0;
+		start_us = now_us();
+		if (old)
+			ret = old_stream_read(handle, buf, sizeof(buf));
+		else
+			ret = stream_read(handle, buf, sizeof(buf));
+		elapsed_ms = (now_us() - start_us) / 1000;
+		takes = sem_takes;
+
+		pthread_join(thread, NULL);
+		stream_close(handle);
+		stream_destroy(handle);
+
+		printf("timeout of a reader of 1 B every 20 ms: %s %llu ms, %u sem takes\n",
+		       old ? "old" : "new", (unsigned long long)elapsed_ms, takes);
+
+		CHECK(ret == 0, "read returned %d", ret);
+		if (!old) {
+			CHECK(elapsed_ms + UPTIME_SLACK_MS >= TIMEOUT_MS && elapsed_ms < TIMEOUT_MS + 200,
+			      "timeout after %llu ms", (unsigned long long)elapsed_ms);
+			CHECK(takes <= TIMEOUT_MS / CONFIG_STREAM_BLOCK_RECHECK_MS + 1,
+			      "%u sem takes", takes);
+		}
+	}
+
+	/* writer without reader */
+	handle = mem_stream(&ring, 1024, MODE_IN_OUT | MODE_WRITE_BLOCK | MODE_BLOCK_TIMEOUT);
+	stream_write(handle, buf, 1000);
+	sem_takes = 0;
+	start_us = now_us();
+	ret = stream_write(handle, buf, 100);
+	elapsed_ms = (now_us() - start_us) / 1000;
+	takes = sem_takes;
+	stream_close(handle);
+	stream_destroy(handle);
+
+	printf("timeout of a writer without reader: %llu ms, %u sem takes\n",
+	       (unsigned long long)elapsed_ms, takes);
+
+	CHECK(ret == 0, "write returned %d", ret);
+	CHECK(elapsed_ms + UPTIME_SLACK_MS >= TIMEOUT_MS && elapsed_ms < TIMEOUT_MS + 200, "timeout after %llu ms",
+	      (unsigned long long)elapsed_ms);
+}
+
+static void *wait_length_writer(void *arg)
+{
+	io_stream_t handle = arg;
+	uint8_t buf[64];
+	int i;
+
+	for (i = 0; i < 32; i++) {
+		usleep(1000);
+		fill_seq(buf, i * sizeof(buf), sizeof(buf));
+		stream_write(handle, buf, sizeof(buf));
+	}
+
+	return NULL;
+}
+
+static void test_wait_length(void)
+{
+	static struct mem_ring ring;
+	uint8_t buf[1024];
+	unsigned int takes;
+	pthread_t thread;
+	uint64_t start_us, elapsed_ms;
+	io_stream_t handle;
+	int ret;
+
+	/* waits for the length without reading it */
+	handle = mem_stream(&ring, RING_SIZE, MODE_IN_OUT | MODE_READ_BLOCK);
+	pthread_create(&thread, NULL, wait_length_writer, handle);
+	sem_takes = 0;
+	ret = stream_wait_length(handle, 1024, OS_FOREVER);
+	takes = sem_takes;
+
+	CHECK(ret >= 1024, "wait returned %d", ret);
+	CHECK(takes <= 1, "%u sem takes", takes);
+	CHECK(ring.rofs == 0, "%u bytes read by the wait", ring.rofs);
+
+	sem_takes = 0;
+	ret = stream_read(handle, buf, sizeof(buf));
+	CHECK(ret == sizeof(buf) && check_seq(buf, 0, sizeof(buf)), "read returned %d", ret);
+	CHECK(sem_takes == 0, "read after the wait took the sem %u times", sem_takes);
+	pthread_join(thread, NULL);
+	ret = stream_read(handle, buf, sizeof(buf));
+	CHECK(ret == sizeof(buf) && check_seq(buf, sizeof(buf), sizeof(buf)), "read returned %d", ret);
+
+	/* timeout */
+	start_us = now_us();
+	ret = stream_wait_length(handle, 10, 100);
+	elapsed_ms = (now_us() - start_us) / 1000;
+	CHECK(ret == -ETIMEDOUT, "wait returned %d", ret);
+	CHECK(elapsed_ms + UPTIME_SLACK_MS >= 100 && elapsed_ms < 200, "timeout after %llu ms",
+	      (unsigned long long)elapsed_ms);
+
+	printf("stream_wait_length: 1024 B after %u sem takes, timeout of 100 ms after %llu ms\n",
+	       takes, (unsigned long long)elapsed_ms);
+
+	/* the write side finishes short of the length */
+	fill_seq(buf, 0, 10);
+	stream_write(handle, buf, 10);
+	stream_write(handle, NULL, 0);
+	ret = stream_wait_length(handle, 1024, OS_FOREVER);
+	CHECK(ret == 10, "wait after write finished returned %d", ret);
+
+	stream_close(handle);
+	stream_destroy(handle);
+
+	/* not a blocking stream */
+	handle = mem_stream(&ring, RING_SIZE, MODE_IN_OUT);
+	ret = stream_wait_length(handle, 10, 100);
+	CHECK(ret == -EPERM, "wait on a non blocking stream returned %d", ret);
+	stream_close(handle);
+	stream_destroy(handle);
+}
+
+static void test_close(void)
+{
+	static struct mem_ring ring;
+	struct blocked reader, writer;
+	pthread_t reader_thread, writer_thread;
+	uint8_t buf[600];
+	uint64_t close_us;
+	io_stream_t handle;
+
+	/* 600 of 1024 bytes used: a read of 800 and a write of 500 both block */
+	handle = mem_stream(&ring, 1024, MODE_IN_OUT | MODE_READ_BLOCK | MODE_WRITE_BLOCK);
+	fill_seq(buf, 0, sizeof(buf));
+	stream_write(handle, buf, sizeof(buf));
+
+	blocked_start(&reader, &reader_thread, handle, 0, 800);
+	blocked_start(&writer, &writer_thread, handle, 1, 500);
+	usleep(50000);
+	CHECK(!blocked_done(&reader) && !blocked_done(&writer), "reader or writer not blocked");
+
+	close_us = now_us();
+	stream_close(handle);
+	pthread_join(reader_thread, NULL);
+	pthread_join(writer_thread, NULL);
+
+	printf("stream_close: reader woken after %llu us, writer after %llu us\n",
+	       (unsigned long long)(reader.done_us - close_us),
+	       (unsigned long long)(writer.done_us - close_us));
+
+	CHECK(reader.ret == -ENOSYS && writer.ret == -ENOSYS, "read returned %d, write %d",
+	      reader.ret, writer.ret);
+	CHECK(reader.takes == 1 && writer.takes == 1, "sem takes: reader %u, writer %u",
+	      reader.takes, writer.takes);
+	CHECK(reader.done_us - close_us < 20000 && writer.done_us - close_us < 20000,
+	      "woken after %llu and %llu us",
+	      (unsigned long long)(reader.done_us - close_us),
+	      (unsigned long long)(writer.done_us - close_us));
+
+	stream_destroy(handle);
+}
+
+int main(int argc, char *argv[])
+{
+	int reads = argc > 1 ? atoi(argv[1]) : 100;
+
+	if (reads <= 0 || reads > MAX_READS)
+		reads = MAX_READS;
+
+	test_reader_wakeup(reads);
+	test_direct_ring();
+	test_writer_wakeup();
+	test_timeout();
+	test_wait_length();
+	test_close();
+
+	if (failures) {
+		printf("stream: %d failures\n", failures);
+		return 1;
+	}
+
+	printf("stream: OK\n");
+	return 0;
+}
@@ -0,0 +1,18 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the device API, only the display headers refer to it */
+
+#ifndef __HOST_DEVICE_H__
+#define __HOST_DEVICE_H__
+
+struct device {
+	const char *name;
+	const void *api;
+	void *data;
+};
+
+#endif
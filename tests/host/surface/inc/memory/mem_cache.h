@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the cache API, host memory is coherent */
+
+#ifndef __HOST_MEM_CACHE_H__
+#define __HOST_MEM_CACHE_H__
+
+#include <stdbool.h>
+
+static inline void mem_dcache_invalidate(const void *addr, unsigned int size) { }
+static inline void mem_dcache_clean(const void *addr, unsigned int size) { }
+
+static inline bool mem_is_cacheable(const void *addr)
+{
+	return false;
+}
+
+#define mem_addr_to_uncache(addr)	(addr)
+#define mem_writebuf_clean_all()	do { } while (0)
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the OS API used by the surface, the test is single threaded */
+
+#ifndef __HOST_OS_COMMON_API_H__
+#define __HOST_OS_COMMON_API_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <sys/atomic.h>
+#include <sys/util.h>
+
+#define OS_FOREVER	(-1)
+
+typedef struct {
+	int count;
+} os_sem;
+
+static inline void os_sem_init(os_sem *sem, int count, int limit)
+{
+	sem->count = count;
+}
+
+static inline int os_sem_take(os_sem *sem, int timeout)
+{
+	if (sem->count > 0)
+		sem->count--;
+	return 0;
+}
+
+static inline void os_sem_give(os_sem *sem)
+{
+	sem->count = 1;
+}
+
+static inline void os_sched_lock(void) { }
+static inline void os_sched_unlock(void) { }
+static inline void os_sleep(int ms) { }
+
+#ifdef HOST_LOG
+#define SYS_LOG_ERR(fmt, ...)	printf("E %s: " fmt "\n", __func__, ##__VA_ARGS__)
+#define SYS_LOG_WRN(fmt, ...)	printf("W %s: " fmt "\n", __func__, ##__VA_ARGS__)
+#else
+#define SYS_LOG_ERR(...)	do { } while (0)
+#define SYS_LOG_WRN(...)	do { } while (0)
+#endif
+#define SYS_LOG_INF(...)	do { } while (0)
+#define SYS_LOG_DBG(...)	do { } while (0)
+
+#define os_strace_u32(id, val)			do { } while (0)
+#define os_strace_end_call_u32(id, val)		do { } while (0)
+
+#endif
@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the atomic API, the test is single threaded */
+
+#ifndef __HOST_SYS_ATOMIC_H__
+#define __HOST_SYS_ATOMIC_H__
+
+typedef long atomic_t;
+
+static inline long atomic_get(const atomic_t *target)
+{
+	return *target;
+}
+
+static inline long atomic_set(atomic_t *target, long value)
+{
+	long old = *target;
+
+	*target = value;
+	return old;
+}
+
+static inline long atomic_inc(atomic_t *target)
+{
+	return (*target)++;
+}
+
+static inline long atomic_dec(atomic_t *target)
+{
+	return (*target)--;
+}
+
+#endif
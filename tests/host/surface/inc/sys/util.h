@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the zephyr util macros used by the surface */
+
+#ifndef __HOST_SYS_UTIL_H__
+#define __HOST_SYS_UTIL_H__
+
+#define BIT(n)			(1UL << (n))
+#define ARRAY_SIZE(array)	(sizeof(array) / sizeof((array)[0]))
+
+#endif
@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the ui memory API used by the graphic buffers */
+
+#ifndef __HOST_UI_MEM_H__
+#define __HOST_UI_MEM_H__
+
+#include <stdlib.h>
+
+#define MEM_FB	0
+
+#define ui_mem_alloc(type, size, caller)			malloc(size)
+#define ui_mem_aligned_alloc(type, align, size, caller)	malloc(size)
+#define ui_mem_free(type, ptr)					free(ptr)
+
+#define ui_memory_alloc(size)		calloc(1, size)
+#define ui_memory_free(ptr)		free(ptr)
+#define ui_memory_dump_info(index)	do { } while (0)
+
+#endif
@@ -0,0 +1,16 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host stub of the zephyr types */
+
+#ifndef __HOST_ZEPHYR_TYPES_H__
+#define __HOST_ZEPHYR_TYPES_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#endif
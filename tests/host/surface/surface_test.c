@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief dirty rect test and copy benchmark of the double buffered surface
+ *
+ * Frames of the scenarios below are drawn into a 454x454 rgb565 double
+ * buffered surface, each area with its own pixel value, and the posts
+ * complete at once. The draw callback answers the cover check with the
+ * areas of the coming frame, as the LVGL display does.
+ *
+ * After each frame the dirty rects must be disjoint, at most
+ * CONFIG_SURFACE_DIRTY_AREA_NUM and cover every drawn pixel, and the front
+ * buffer must match the reference screen, that is the swap copies kept
+ * the areas of the previous frames. The bytes copied by the swaps are
+ * compared with the copy of the bounding box of the previous frame, which
+ * the surface did before the dirty rects.
+ *
+ * Usage: surface_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <os_common_api.h>
+#include <ui_surface.h>
+
+#define SCREEN_W	454
+#define SCREEN_H	454
+#define MAX_AREAS	20
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) \
+	do { \
+		if (!(cond)) { \
+			if (failures++ < 10) \
+				printf("FAIL %s:%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__); \
+		} \
+	} while (0)
+
+static uint16_t ref_screen[SCREEN_H][SCREEN_W];
+static uint8_t cover_map[SCREEN_H][SCREEN_W];
+
+/* areas of the frame being drawn */
+static ui_region_t plan[MAX_AREAS];
+static int plan_num;
+
+/* bounding box of the previous frame, the copy before the dirty rects */
+static ui_region_t prev_box;
+
+static struct {
+	uint32_t frames;
+	uint64_t bytes;
+	uint64_t jobs;
+	uint64_t bbox_bytes;
+} stats;
+
+static uint32_t seed = 1;
+
+static uint32_t rnd(void)
+{
+	seed = seed * 1103515245 + 12345;
+	return seed >> 8;
+}
+
+uint8_t display_format_get_bits_per_pixel(uint32_t pixel_format)
+{
+	return 16;
+}
+
+static void post_callback(uint32_t event, void *data, void *user_data)
+{
+	surface_complete_one_post(user_data);
+}
+
+static void draw_callback(uint32_t event, void *data, void *user_data)
+{
+	surface_cover_check_data_t *cover_check = data;
+	int i;
+
+	if (event != SURFACE_EVT_DRAW_COVER_CHECK)
+		return;
+
+	for (i = 0; i < plan_num; i++) {
+		if (ui_region_is_in(cover_check->area, &plan[i]))
+			cover_check->covered = true;
+	}
+}
+
+static void plan_area(int x, int y, int w, int h)
+{
+	if (x + w > SCREEN_W)
+		w = SCREEN_W - x;
+	if (y + h > SCREEN_H)
+		h = SCREEN_H - y;
+
+	ui_region_set(&plan[plan_num++], x, y, x + w - 1, y + h - 1);
+}
+
+static void plan_random_area(int max_w, int max_h)
+{
+	int w = 1 + rnd() % max_w, h = 1 + rnd() % max_h;
+
+	plan_area(rnd() % (SCREEN_W - w + 1), rnd() % (SCREEN_H - h + 1), w, h);
+}
+
+static void check_dirty_rects(surface_t *surface)
+{
+	const ui_region_t *rect;
+	int i, x, y, overlap = 0, missed = 0;
+
+	CHECK(surface->dirty_cnt <= CONFIG_SURFACE_DIRTY_AREA_NUM, "%d dirty rects", surface->dirty_cnt);
+
+	memset(cover_map, 0, sizeof(cover_map));
+	for (i = 0; i < surface->dirty_cnt; i++) {
+		rect = &surface->dirty_rects[i];
+		for (y = rect->y1; y <= rect->y2; y++) {
+			for (x = rect->x1; x <= rect->x2; x++)
+				overlap += cover_map[y][x]++;
+		}
+	}
+
+	for (i = 0; i < plan_num; i++) {
+		for (y = plan[i].y1; y <= plan[i].y2; y++) {
+			for (x = plan[i].x1; x <= plan[i].x2; x++)
+				missed += !cover_map[y][x];
+		}
+	}
+
+	CHECK(!overlap, "frame %u: %d pixels in more than one rect", stats.frames, overlap);
+	CHECK(!missed, "frame %u: %d pixels not in the rects", stats.frames, missed);
+}
+
+static void draw_frame(surface_t *surface)
+{
+	graphic_buffer_t *buf;
+	uint16_t value;
+	bool covered = false;
+	int i, x, y, mismatch = 0;
+
+	/* the former copy unless an only area redraws it */
+	if (plan_num == 1 && ui_region_is_in(&prev_box, &plan[0]))
+		covered = true;
+	if (!covered && !ui_region_is_empty(&prev_box))
+		stats.bbox_bytes += ui_region_get_size(&prev_box) * 2;
+
+	ui_region_set(&prev_box, SCREEN_W, SCREEN_H, 0, 0);
+	for (i = 0; i < plan_num; i++)
+		ui_region_merge(&prev_box, &prev_box, &plan[i]);
+
+	surface_begin_frame(surface);
+	stats.bytes += surface->swap_bytes;
+	stats.jobs += surface->swap_jobs;
+	surface->swap_bytes = 0;
+	surface->swap_jobs = 0;
+	stats.frames++;
+
+	for (i = 0; i < plan_num; i++) {
+		surface_begin_draw(surface, (i == 0 ? SURFACE_FIRST_DRAW : 0) |
+				(i == plan_num - 1 ? SURFACE_LAST_DRAW : 0), &buf);
+
+		value = (uint16_t)(stats.frames * 32 + i);
+		for (y = plan[i].y1; y <= plan[i].y2; y++) {
+			for (x = plan[i].x1; x <= plan[i].x2; x++) {
+				*(uint16_t *)graphic_buffer_get_bufptr(buf, x, y) = value;
+				ref_screen[y][x] = value;
+			}
+		}
+
+		surface_end_draw(surface, &plan[i], NULL);
+	}
+
+	check_dirty_rects(surface);
+
+	buf = surface_get_frontbuffer(surface);
+	for (y = 0; y < SCREEN_H; y++) {
+		for (x = 0; x < SCREEN_W; x++)
+			mismatch += *(uint16_t *)graphic_buffer_get_bufptr(buf, x, y) != ref_screen[y][x];
+	}
+
+	CHECK(!mismatch, "frame %u: %d pixels differ from the reference", stats.frames, mismatch);
+}
+
+static void report(const char *name)
+{
+	printf("%-22s %5u frames: %8.1f KB per frame, %5.2f jobs, bounding box %8.1f KB, x%.2f\n",
+	       name, stats.frames, stats.bytes / 1024.0 / stats.frames,
+	       (double)stats.jobs / stats.frames, stats.bbox_bytes / 1024.0 / stats.frames,
+	       stats.bbox_bytes ? (double)stats.bytes / stats.bbox_bytes : 0);
+
+	memset(&stats, 0, sizeof(stats));
+}
+
+enum {
+	SCENE_RANDOM,
+	SCENE_STATUS_BOTTOM,
+	SCENE_CORNERS,
+	SCENE_STRIPES,
+	SCENE_FULL_SCREEN,
+	SCENE_SCATTERED,
+	SCENE_OVERLAPPING,
+	NUM_SCENES,
+};
+
+static const char *scene_names[NUM_SCENES] = {
+	"random", "status bar and bottom", "opposite corners", "flush stripes",
+	"full screen", "12 small scattered", "overlapping pair",
+};
+
+/*
+ * the areas of a scene, the frames of the fixed scenes alternate with a
+ * 24x24 tick somewhere else, so their areas must be copied back
+ */
+static void plan_scene(int scene, int frame)
+{
+	int i, x, y;
+
+	plan_num = 0;
+
+	if (scene != SCENE_RANDOM && (frame & 1)) {
+		plan_random_area(24, 24);
+		return;
+	}
+
+	switch (scene) {
+	case SCENE_RANDOM:
+		for (i = 1 + rnd() % MAX_AREAS; i > 0; i--)
+			plan_random_area((frame & 1) ? 40 : 200, (frame & 2) ? 40 : 200);
+		break;
+	case SCENE_STATUS_BOTTOM:
+		plan_area(0, 0, SCREEN_W, 40);
+		plan_area(150, 400, 151, 54);
+		break;
+	case SCENE_CORNERS:
+		plan_area(10, 10, 71, 71);
+		plan_area(370, 370, 71, 71);
+		break;
+	case SCENE_STRIPES:
+		for (y = 0; y < SCREEN_H; y += 40)
+			plan_area(0, y, SCREEN_W, 40);
+		break;
+	case SCENE_FULL_SCREEN:
+		plan_area(0, 0, SCREEN_W, SCREEN_H);
+		break;
+	case SCENE_SCATTERED:
+		for (i = 0; i < 12; i++)
+			plan_area(rnd() % (SCREEN_W - 30), rnd() % (SCREEN_H - 20), 30, 20);
+		break;
+	case SCENE_OVERLAPPING:
+		x = rnd() % (SCREEN_W - 60);
+		y = rnd() % (SCREEN_H - 60);
+		plan_area(x, y, 60, 60);
+		plan_area(x + 10, y + 5, 61, 46);
+		break;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	surface_t *surface;
+	int scene, frame;
+
+	surface = surface_create(SCREEN_W, SCREEN_H, PIXEL_FORMAT_RGB_565, 2, SURFACE_SWAP_DEFAULT, 0);
+	CHECK(surface != NULL, "no surface");
+	if (surface == NULL)
+		return 1;
+
+	surface_register_callback(surface, SURFACE_CB_POST, post_callback, surface);
+	surface_register_callback(surface, SURFACE_CB_DRAW, draw_callback, surface);
+	ui_region_set(&prev_box, 0, 0, SCREEN_W - 1, SCREEN_H - 1);
+
+	for (scene = 0; scene < NUM_SCENES; scene++) {
+		for (frame = 0; frame < (scene == SCENE_RANDOM ? 1000 : 100); frame++) {
+			plan_scene(scene, frame);
+			draw_frame(surface);
+		}
+
+		report(scene_names[scene]);
+	}
+
+	surface_destroy(surface);
+
+	if (failures) {
+		printf("surface: %d failures\n", failures);
+		return 1;
+	}
+
+	printf("surface: OK\n");
+	return 0;
+}
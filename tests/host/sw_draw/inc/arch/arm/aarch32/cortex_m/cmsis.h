@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/* host emulation of the Cortex-M DSP intrinsics used by the row kernels */
+
+#ifndef __HOST_CMSIS_H__
+#define __HOST_CMSIS_H__
+
+#include <stdint.h>
+#include <string.h>
+
+static inline uint32_t __PKHBT(uint32_t a, uint32_t b, int shift)
+{
+	return (a & 0xffff) | ((b << shift) & 0xffff0000);
+}
+
+static inline uint32_t __SMUAD(uint32_t a, uint32_t b)
+{
+	return (int32_t)(int16_t)a * (int16_t)b +
+		(int32_t)(int16_t)(a >> 16) * (int16_t)(b >> 16);
+}
+
+static inline uint32_t __SMLAD(uint32_t a, uint32_t b, uint32_t acc)
+{
+	return __SMUAD(a, b) + acc;
+}
+
+static inline uint32_t __UNALIGNED_UINT32_READ(const void *ptr)
+{
+	uint32_t val;
+
+	memcpy(&val, ptr, 4);
+	return val;
+}
+
+#define __UNALIGNED_UINT32_WRITE(ptr, val) \
+	do { uint32_t _val = (val); memcpy((ptr), &_val, 4); } while (0)
+
+#endif
@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Reference of the row kernels: sw_blend.c and sw_rotate.c of this
+ * directory are the scalar versions of zephyr/framework/display before
+ * the row kernels, built with a ref_ prefix.
+ */
+
+#define sw_blend_argb8565_over_rgb565		ref_sw_blend_argb8565_over_rgb565
+#define sw_blend_argb6666_over_rgb565		ref_sw_blend_argb6666_over_rgb565
+#define sw_blend_argb8888_over_rgb565		ref_sw_blend_argb8888_over_rgb565
+#define sw_blend_argb8888_over_argb8888		ref_sw_blend_argb8888_over_argb8888
+#define sw_rotate_configure			ref_sw_rotate_configure
+#define sw_rotate_rgb565_over_rgb565		ref_sw_rotate_rgb565_over_rgb565
+#define sw_rotate_argb8565_over_rgb565		ref_sw_rotate_argb8565_over_rgb565
+#define sw_rotate_argb8888_over_rgb565		ref_sw_rotate_argb8888_over_rgb565
+#define sw_rotate_argb8888_over_argb8888	ref_sw_rotate_argb8888_over_argb8888
+
+#include "sw_blend.c"
+#include "sw_rotate.c"
@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2019 Actions Semiconductor Co., Ltd
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/**
+ * @file
+ * @brief bit exactness test and benchmark of the sw blend and rotate kernels
+ *
+ * Every format pair of sw_blend and sw_rotate is run on random sizes,
+ * strides, destination offsets and angles against the scalar kernels of
+ * ref/, with random, opaque, transparent, run length and mixed alpha
+ * sources, and the whole destination must be the same. The benchmark then
+ * times both on a 454x454 screen, taking the best of the given number of
+ * repeats.
+ *
+ * Usage: sw_draw_test [repeats]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <display/sw_draw.h>
+#include <display/sw_rotate.h>
+
+#define SCREEN_W	454
+#define SCREEN_H	454
+
+#ifndef ARRAY_SIZE
+#define ARRAY_SIZE(array)	((int)(sizeof(array) / sizeof((array)[0])))
+#endif
+
+typedef void (*blend_fn_t)(void *dst, const void *src,
+		uint16_t dst_stride, uint16_t src_stride, uint16_t w, uint16_t h);
+typedef void (*rotate_fn_t)(void *dst, const void *src,
+		uint16_t dst_stride, uint16_t src_w, uint16_t src_h,
+		int16_t x, int16_t y, uint16_t w, uint16_t h, const sw_rotate_config_t *cfg);
+
+#define REF_BLEND(name) \
+	void ref_##name(void *dst, const void *src, \
+		uint16_t dst_stride, uint16_t src_stride, uint16_t w, uint16_t h)
+#define REF_ROTATE(name) \
+	void ref_##name(void *dst, const void *src, \
+		uint16_t dst_stride, uint16_t src_w, uint16_t src_h, \
+		int16_t x, int16_t y, uint16_t w, uint16_t h, const sw_rotate_config_t *cfg)
+
+REF_BLEND(sw_blend_argb8565_over_rgb565);
+REF_BLEND(sw_blend_argb6666_over_rgb565);
+REF_BLEND(sw_blend_argb8888_over_rgb565);
+REF_BLEND(sw_blend_argb8888_over_argb8888);
+REF_ROTATE(sw_rotate_rgb565_over_rgb565);
+REF_ROTATE(sw_rotate_argb8565_over_rgb565);
+REF_ROTATE(sw_rotate_argb8888_over_rgb565);
+REF_ROTATE(sw_rotate_argb8888_over_argb8888);
+
+static const struct {
+	const char *name;
+	blend_fn_t fn;
+	blend_fn_t ref;
+	int src_bpp;
+	int dst_bpp;
+} blends[] = {
+	{ "blend 8565>565", sw_blend_argb8565_over_rgb565, ref_sw_blend_argb8565_over_rgb565, 3, 2 },
+	{ "blend 6666>565", sw_blend_argb6666_over_rgb565, ref_sw_blend_argb6666_over_rgb565, 3, 2 },
+	{ "blend 8888>565", sw_blend_argb8888_over_rgb565, ref_sw_blend_argb8888_over_rgb565, 4, 2 },
+	{ "blend 8888>8888", sw_blend_argb8888_over_argb8888, ref_sw_blend_argb8888_over_argb8888, 4, 4 },
+};
+
+static const struct {
+	const char *name;
+	rotate_fn_t fn;
+	rotate_fn_t ref;
+	int src_bpp;
+	int dst_bpp;
+} rotates[] = {
+	{ "rotate 565>565", sw_rotate_rgb565_over_rgb565, ref_sw_rotate_rgb565_over_rgb565, 2, 2 },
+	{ "rotate 8565>565", sw_rotate_argb8565_over_rgb565, ref_sw_rotate_argb8565_over_rgb565, 3, 2 },
+	{ "rotate 8888>565", sw_rotate_argb8888_over_rgb565, ref_sw_rotate_argb8888_over_rgb565, 4, 2 },
+	{ "rotate 8888>8888", sw_rotate_argb8888_over_argb8888, ref_sw_rotate_argb8888_over_argb8888, 4, 4 },
+};
+
+enum {
+	ALPHA_RANDOM,
+	ALPHA_OPAQUE,
+	ALPHA_TRANSPARENT,
+	ALPHA_RUNS,	/* runs of opaque, transparent or random alpha */
+	ALPHA_MIXED,	/* never opaque nor transparent */
+	ALPHA_MODES,
+};
+
+static const char *alpha_names[ALPHA_MODES] = {
+	"random", "opaque", "transparent", "runs", "mixed",
+};
+
+static int failures;
+
+#define CHECK(cond, fmt, ...) \
+	do { \
+		if (!(cond)) { \
+			if (failures++ < 10) \
+				printf("FAIL %s:%d: " fmt "\n", __func__, __LINE__, ##__VA_ARGS__); \
+		} \
+	} while (0)
+
+/*
+ * random pixels with the alpha of the mode, the alpha is the last byte,
+ * for argb6666 its high 6 bits (argb6666 is only set for that source)
+ */
+static void fill_src(uint8_t *buf, int n, int bpp, int mode, int argb6666)
+{
+	int run = 0, run_a = 0;
+	int i, k, a;
+
+	for (i = 0; i < n; i++) {
+		uint8_t *p = buf + i * bpp;
+
+		for (k = 0; k < bpp; k++)
+			p[k] = rand();
+
+		if (bpp == 2)
+			continue;
+
+		switch (mode) {
+		case ALPHA_OPAQUE:
+			a = 255;
+			break;
+		case ALPHA_TRANSPARENT:
+			a = 0;
+			break;
+		case ALPHA_RUNS:
+			if (run-- <= 0) {
+				run = rand() % 24;
+				run_a = (rand() % 3 == 0) ? rand() % 256 : (rand() & 1) * 255;
+			}
+			a = run_a;
+			break;
+		case ALPHA_MIXED:
+			a = 1 + rand() % 254;
+			break;
+		default:
+			a = rand() % 256;
+			break;
+		}
+
+		if (argb6666 && mode != ALPHA_RANDOM && mode != ALPHA_MIXED)
+			a = (a & 0xfc) | (rand() & 3);
+
+		p[bpp - 1] = a;
+	}
+}
+
+static void test_blend(int b, int cases)
+{
+	int sb = blends[b].src_bpp, db = blends[b].dst_bpp;
+	int i, k, w, h, off, src_stride, dst_stride, mode, dst_size;
+	uint8_t *src, *dst, *ref;
+
+	for (i = 0; i < cases; i++) {
+		w = 1 + rand() % 67;
+		h = 1 + rand() % 9;
+		off = rand() % 3;
+		src_stride = w + rand() % 5;
+		dst_stride = w + off + rand() % 5;
+		mode = i % ALPHA_MODES;
+		dst_size = dst_stride * h * db + 16;
+
+		src = malloc(src_stride * h * sb);
+		dst = malloc(dst_size);
+		ref = malloc(dst_size);
+		fill_src(src, src_stride * h, sb, mode, b == 1);
+		for (k = 0; k < dst_size; k++)
+			dst[k] = ref[k] = rand();
+
+		blends[b].ref(ref + off * db, src, dst_stride, src_stride, w, h);
+		blends[b].fn(dst + off * db, src, dst_stride, src_stride, w, h);
+		CHECK(!memcmp(dst, ref, dst_size), "%s: w %d h %d offset %d %s",
+		      blends[b].name, w, h, off, alpha_names[mode]);
+
+		free(src);
+		free(dst);
+		free(ref);
+	}
+}
+
+static void test_rotate(int r, int cases)
+{
+	int sb = rotates[r].src_bpp, db = rotates[r].dst_bpp;
+	int dst_w = 80, dst_h = 80, dst_size = dst_w * dst_h * db;
+	int i, k, src_w, src_h, pitch, img_x, img_y, x, y, w, h, mode;
+	uint16_t angle;
+	sw_rotate_config_t cfg;
+	uint8_t *src, *dst, *ref;
+
+	dst = malloc(dst_size);
+	ref = malloc(dst_size);
+
+	for (i = 0; i < cases; i++) {
+		src_w = 2 + rand() % 60;
+		src_h = 2 + rand() % 60;
+		mode = i % ALPHA_MODES;
+		angle = (i % 7 == 0) ? (rand() % 4) * 900 : rand() % 3600;
+		img_x = rand() % 20;
+		img_y = rand() % 20;
+		/* the kernels read the neighbour pixels, src_w is the pitch */
+		pitch = src_w + 2;
+
+		src = malloc(pitch * (src_h + 2) * sb);
+		fill_src(src, pitch * (src_h + 2), sb, mode, 0);
+		for (k = 0; k < dst_size; k++)
+			dst[k] = ref[k] = rand();
+
+		sw_rotate_configure(0, 0, img_x, img_y, img_x + src_w / 2, img_y + src_h / 2, angle, &cfg);
+		x = rand() % 10;
+		y = rand() % 10;
+		w = 1 + rand() % (dst_w - x - 1);
+		h = 1 + rand() % (dst_h - y - 1);
+
+		rotates[r].ref(ref, src, dst_w, pitch, src_h + 1, x, y, w, h, &cfg);
+		rotates[r].fn(dst, src, dst_w, pitch, src_h + 1, x, y, w, h, &cfg);
+		CHECK(!memcmp(dst, ref, dst_size), "%s: %dx%d angle %d %s",
+		      rotates[r].name, src_w, src_h, angle, alpha_names[mode]);
+
+		free(src);
+	}
+
+	free(dst);
+	free(ref);
+}
+
+static double now_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static void bench(int repeats)
+{
+	static uint8_t src[SCREEN_W * SCREEN_H * 4], dst[SCREEN_W * SCREEN_H * 4];
+	sw_rotate_config_t cfg;
+	double t0, t1, t2, t_ref, t_new;
+	int b, r, m, a, i;
+
+	printf("%-17s %-11s %5s %9s %9s\n", "kernel", "alpha", "angle", "ref ms", "new ms");
+
+	for (b = 0; b < ARRAY_SIZE(blends); b++) {
+		for (m = 0; m < ALPHA_MODES; m++) {
+			fill_src(src, SCREEN_W * SCREEN_H, blends[b].src_bpp, m, b == 1);
+			t_ref = t_new = 1e9;
+			for (i = 0; i < repeats; i++) {
+				t0 = now_ms();
+				blends[b].ref(dst, src, SCREEN_W, SCREEN_W, SCREEN_W, SCREEN_H);
+				t1 = now_ms();
+				blends[b].fn(dst, src, SCREEN_W, SCREEN_W, SCREEN_W, SCREEN_H);
+				t2 = now_ms();
+				if (t1 - t0 < t_ref)
+					t_ref = t1 - t0;
+				if (t2 - t1 < t_new)
+					t_new = t2 - t1;
+			}
+
+			printf("%-17s %-11s %5s %9.3f %9.3f x%.2f\n", blends[b].name,
+			       alpha_names[m], "", t_ref, t_new, t_ref / t_new);
+		}
+	}
+
+	/* a 300x300 image rotated around its center over the screen */
+	for (r = 0; r < ARRAY_SIZE(rotates); r++) {
+		for (m = 0; m < ALPHA_MODES; m++) {
+			if (rotates[r].src_bpp == 2 && m != ALPHA_RANDOM)
+				continue;
+
+			fill_src(src, 301 * 301, rotates[r].src_bpp, m, 0);
+			for (a = 0; a < 2; a++) {
+				sw_rotate_configure(0, 0, 77, 77, 227, 227, a ? 300 : 900, &cfg);
+				t_ref = t_new = 1e9;
+				for (i = 0; i < repeats; i++) {
+					t0 = now_ms();
+					rotates[r].ref(dst, src, SCREEN_W, 301, 300, 0, 0, SCREEN_W, SCREEN_H, &cfg);
+					t1 = now_ms();
+					rotates[r].fn(dst, src, SCREEN_W, 301, 300, 0, 0, SCREEN_W, SCREEN_H, &cfg);
+					t2 = now_ms();
+					if (t1 - t0 < t_ref)
+						t_ref = t1 - t0;
+					if (t2 - t1 < t_new)
+						t_new = t2 - t1;
+				}
+
+				printf("%-17s %-11s %5d %9.3f %9.3f x%.2f\n", rotates[r].name,
+				       alpha_names[m], a ? 30 : 90, t_ref, t_new, t_ref / t_new);
+			}
+		}
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	int repeats = (argc > 1) ? atoi(argv[1]) : 10;
+	int i;
+
+	srand(1);
+
+	for (i = 0; i < ARRAY_SIZE(blends); i++)
+		test_blend(i, 2000);
+
+	for (i = 0; i < ARRAY_SIZE(rotates); i++)
+		test_rotate(i, 1500);
+
+	if (repeats > 0)
+		bench(repeats);
+
+	if (failures) {
+		printf("sw_draw: %d failures\n", failures);
+		return 1;
+	}
+
+	printf("sw_draw: OK\n");
+	return 0;
+}
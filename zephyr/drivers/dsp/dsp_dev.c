@@ -254,6 +254,7 @@ static int dsp_acts_kick(struct device *dev, uint32_t owner, uint32_t event, uin
 		.param1 = event,
 		.param2 = params,
 	};
+	int res;
 
 	if (dsp_data->pm_status != DSP_STATUS_POWERON)
 		return -EACCES;
@@ -261,7 +262,10 @@ static int dsp_acts_kick(struct device *dev, uint32_t owner, uint32_t event, uin
 	if (dsp_userinfo->task_state != DSP_TASK_SUSPENDED)
 		return -EINPROGRESS;
 
-	return dsp_acts_send_message(dev, &message);
+	/* doorbell only, do not wait for the ack */
+	res = dsp_acts_send_message_async(dev, &message, NULL, NULL);
+
+	return (res < 0) ? res : 0;
 }
 
 static int dsp_acts_request_mem(struct device *dev, int type)
@@ -625,6 +629,10 @@ static int dsp_acts_power_off(struct device *dev)
 
 	dsp_cfg->dsp_userinfo->task_state = DSP_TASK_DEAD;
 	dsp_data->pm_status = DSP_STATUS_POWEROFF;
+
+	SYS_LOG_INF("dsp msg queued %u, coalesced %u, full %u, timeout %u\n",
+		dsp_data->msg_ring.queued_cnt, dsp_data->msg_ring.coalesce_cnt,
+		dsp_data->msg_ring.full_cnt, dsp_data->msg_ring.timeout_cnt);
 #ifdef CONFIG_DSP_DEBUG_PRINT
 	if (!k_delayed_work_cancel(&print_work))
 	{
@@ -708,7 +716,7 @@ static int dsp_acts_init(const struct device *dev)
 
 	dsp_cfg->dsp_userinfo->task_state = DSP_TASK_DEAD;
 	k_sem_init(&dsp_data->msg_sem, 0, 1);
-	k_mutex_init(&dsp_data->msg_mutex);
+	dsp_acts_msg_ring_init((struct device *)dev);
 
 	dsp_data->pm_status = DSP_STATUS_POWEROFF;
     memset(&dsp_data->images, 0, sizeof(dsp_data->images));
@@ -740,6 +748,7 @@ const struct dsp_driver_api dsp_drv_api = {
 	.request_mem = dsp_acts_request_mem,
 	.release_mem = dsp_acts_release_mem,
 	.send_message = dsp_acts_send_message,
+	.send_message_async = dsp_acts_send_message_async,
 	.request_userinfo = acts_request_userinfo,
 };
 
@@ -71,6 +71,34 @@ struct dsp_protocol_userinfo {
 	volatile uint32_t func_runnable;
 };
 
+struct dsp_msg_desc {
+	struct dsp_message message;
+	dsp_message_callback callback;
+	void *user_data;
+	uint16_t seq;
+	/* written to the mailbox, waiting for ack */
+	uint8_t posted;
+};
+
+/* messages queued to the dsp mailbox, the oldest one is posted */
+struct dsp_msg_ring {
+	struct dsp_msg_desc desc[CONFIG_DSP_MSG_RING_SIZE];
+	uint8_t head;
+	uint8_t count;
+	uint16_t seq;
+	/* cycle the oldest message was posted */
+	uint32_t post_cycle;
+
+	/* statistics */
+	uint32_t queued_cnt;
+	uint32_t coalesce_cnt;
+	uint32_t full_cnt;
+	uint32_t timeout_cnt;
+
+	struct device *dev;
+	struct k_delayed_work work;
+};
+
 struct dsp_acts_data {
 	/* power status */
 	int8_t pm_status;
@@ -79,7 +107,8 @@ struct dsp_acts_data {
 
 	/* message semaphore */
 	struct k_sem msg_sem;
-	struct k_mutex msg_mutex;
+	/* messages to dsp */
+	struct dsp_msg_ring msg_ring;
 
 	/* user-defined message handler */
 	dsp_message_handler msg_handler;
@@ -127,7 +156,10 @@ int dsp_acts_handle_image_pageflush(struct device *dev, uint32_t epc);
 int dsp_acts_register_message_handler(struct device *dev, dsp_message_handler handler);
 int dsp_acts_unregister_message_handler(struct device *dev);
 
+void dsp_acts_msg_ring_init(struct device *dev);
 int dsp_acts_send_message(struct device *dev, struct dsp_message *msg);
+int dsp_acts_send_message_async(struct device *dev, struct dsp_message *msg,
+		dsp_message_callback callback, void *user_data);
 int dsp_acts_recv_message(struct device *dev);
 
 #ifdef __cplusplus
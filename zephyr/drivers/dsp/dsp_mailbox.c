@@ -211,7 +211,10 @@ static int wait_ack_timeout(struct dsp_protocol_mailbox *mailbox, int usec_to_wa
     return usec_to_wait;
 }
 
-int dsp_acts_send_message(struct device *dev, struct dsp_message *message)
+/* ack timeout of a posted message: 1ms */
+#define DSP_MSG_ACK_TIMEOUT_US 1000
+
+static int dsp_acts_post_message(struct device *dev, struct dsp_message *message)
 {
     struct dsp_acts_data *dsp_data = dev->data;
     const struct dsp_acts_config *dsp_cfg = dev->config;
@@ -233,13 +236,6 @@ int dsp_acts_send_message(struct device *dev, struct dsp_message *message)
         return -EBUSY;
     }
 
-    if (k_is_in_isr()) {
-        printk("%s: send msg (%u:%u) in isr\n", __func__,
-               message->owner, message->id);
-    } else {
-        k_mutex_lock(&dsp_data->msg_mutex, K_FOREVER);
-    }
-
     mailbox->msg = MAILBOX_MSG(message->id, MSG_FLAG_BUSY);
     mailbox->owner = message->owner;
     mailbox->param1 = message->param1;
@@ -248,8 +244,15 @@ int dsp_acts_send_message(struct device *dev, struct dsp_message *message)
     /* trigger irq to dsp */
     mcu_trigger_irq_to_dsp();
 
-    /* Wait for the ack bit: 1ms timeout (1us * 1000) */
-    wait_ack_timeout(mailbox, 1000);
+    return 0;
+}
+
+/* get the result of the posted message after acked or timed out */
+static int dsp_acts_finish_message(struct device *dev, struct dsp_message *message)
+{
+    const struct dsp_acts_config *dsp_cfg = dev->config;
+    struct dsp_protocol_mailbox *mailbox = dsp_cfg->dsp_mailbox;
+    uint32_t status;
 
     /* de-trigger irq to dsp */
     mcu_untrigger_irq_to_dsp();
@@ -272,9 +275,231 @@ int dsp_acts_send_message(struct device *dev, struct dsp_message *message)
         message->result = DSP_INPROGRESS;
     }
 
-    if (!k_is_in_isr())
-        k_mutex_unlock(&dsp_data->msg_mutex);
+    return 0;
+}
+
+/* kick is only needed if dsp is waiting, a running dsp finds the new data itself */
+static int dsp_acts_check_kick(struct device *dev, struct dsp_message *message)
+{
+    const struct dsp_acts_config *dsp_cfg = dev->config;
+
+    if (message->id == DSP_MSG_KICK &&
+        dsp_cfg->dsp_userinfo->task_state != DSP_TASK_SUSPENDED)
+        return -EINPROGRESS;
 
     return 0;
 }
 
+static void dsp_msg_ring_complete(struct dsp_msg_ring *ring, int res)
+{
+    struct dsp_msg_desc *desc = &ring->desc[ring->head];
+    struct dsp_message message = desc->message;
+    dsp_message_callback callback = desc->callback;
+    void *user_data = desc->user_data;
+    unsigned int irq_key;
+
+    irq_key = irq_lock();
+    ring->head = (ring->head + 1) % CONFIG_DSP_MSG_RING_SIZE;
+    ring->count--;
+    if (res == -ETIMEDOUT)
+        ring->timeout_cnt++;
+    irq_unlock(irq_key);
+
+    if (callback)
+        callback(&message, res, user_data);
+}
+
+struct dsp_msg_sync {
+    struct k_sem sem;
+    struct dsp_message *message;
+    int res;
+};
+
+static void dsp_msg_sync_callback(struct dsp_message *message, int res, void *user_data)
+{
+    struct dsp_msg_sync *sync = user_data;
+
+    *sync->message = *message;
+    sync->res = res;
+    k_sem_give(&sync->sem);
+}
+
+/*
+ * Post the queued messages one by one. The ack of every message is busy
+ * waited for a short time only, a slow dsp is checked again on the next
+ * tick, so that neither the senders nor the work queue spin for the whole
+ * ack timeout. A sync sender sleeps in k_sem_take meanwhile.
+ */
+static void dsp_msg_ring_work(struct k_work *work)
+{
+    struct dsp_msg_ring *ring = CONTAINER_OF(work, struct dsp_msg_ring, work);
+    struct device *dev = ring->dev;
+    const struct dsp_acts_config *dsp_cfg = dev->config;
+    struct dsp_msg_desc *desc;
+    unsigned int irq_key;
+    int res;
+
+    while (1) {
+        irq_key = irq_lock();
+        desc = ring->count ? &ring->desc[ring->head] : NULL;
+        irq_unlock(irq_key);
+
+        if (!desc)
+            break;
+
+        if (!desc->posted) {
+            res = dsp_acts_check_kick(dev, &desc->message);
+            if (!res)
+                res = dsp_acts_post_message(dev, &desc->message);
+
+            if (res) {
+                dsp_msg_ring_complete(ring, res);
+                continue;
+            }
+
+            irq_key = irq_lock();
+            desc->posted = 1;
+            irq_unlock(irq_key);
+            ring->post_cycle = k_cycle_get_32();
+        }
+
+        wait_ack_timeout(dsp_cfg->dsp_mailbox, CONFIG_DSP_MSG_ACK_POLL_US);
+
+        if (!(MSG_STATUS(dsp_cfg->dsp_mailbox->msg) & MSG_FLAG_ACK) &&
+            k_cyc_to_us_floor32(k_cycle_get_32() - ring->post_cycle) < DSP_MSG_ACK_TIMEOUT_US) {
+            k_delayed_work_submit(&ring->work, K_TICKS(1));
+            break;
+        }
+
+        res = dsp_acts_finish_message(dev, &desc->message);
+        dsp_msg_ring_complete(ring, res);
+    }
+}
+
+void dsp_acts_msg_ring_init(struct device *dev)
+{
+    struct dsp_acts_data *dsp_data = dev->data;
+    struct dsp_msg_ring *ring = &dsp_data->msg_ring;
+
+    memset(ring, 0, sizeof(*ring));
+    ring->dev = dev;
+    k_delayed_work_init(&ring->work, dsp_msg_ring_work);
+}
+
+int dsp_acts_send_message_async(struct device *dev, struct dsp_message *message,
+        dsp_message_callback callback, void *user_data)
+{
+    struct dsp_acts_data *dsp_data = dev->data;
+    struct dsp_msg_ring *ring = &dsp_data->msg_ring;
+    struct dsp_msg_desc *desc;
+    unsigned int irq_key;
+    int i, seq;
+
+    if (dsp_data->pm_status == DSP_STATUS_POWEROFF)
+        return -EFAULT;
+
+    irq_key = irq_lock();
+
+    /* a kick not yet posted also covers this one */
+    if (message->id == DSP_MSG_KICK && !callback) {
+        for (i = 0; i < ring->count; i++) {
+            desc = &ring->desc[(ring->head + i) % CONFIG_DSP_MSG_RING_SIZE];
+            if (!desc->posted && !desc->callback &&
+                desc->message.id == DSP_MSG_KICK &&
+                desc->message.owner == message->owner &&
+                desc->message.param1 == message->param1 &&
+                desc->message.param2 == message->param2) {
+                ring->coalesce_cnt++;
+                seq = desc->seq;
+                irq_unlock(irq_key);
+                return seq;
+            }
+        }
+    }
+
+    if (ring->count >= CONFIG_DSP_MSG_RING_SIZE) {
+        ring->full_cnt++;
+        irq_unlock(irq_key);
+        return -ENOSPC;
+    }
+
+    desc = &ring->desc[(ring->head + ring->count) % CONFIG_DSP_MSG_RING_SIZE];
+    desc->message = *message;
+    desc->callback = callback;
+    desc->user_data = user_data;
+    desc->posted = 0;
+    desc->seq = ring->seq++;
+    seq = desc->seq;
+    ring->count++;
+    ring->queued_cnt++;
+
+    irq_unlock(irq_key);
+
+    k_delayed_work_submit(&ring->work, K_NO_WAIT);
+
+    return seq;
+}
+
+/*
+ * Send one message without the ring, for callers which can not wait on
+ * the work queue. Only possible if no queued message owns the mailbox.
+ */
+static int dsp_acts_send_message_direct(struct device *dev, struct dsp_message *message)
+{
+    struct dsp_acts_data *dsp_data = dev->data;
+    const struct dsp_acts_config *dsp_cfg = dev->config;
+    unsigned int irq_key;
+    int res;
+
+    irq_key = irq_lock();
+    res = dsp_data->msg_ring.count ? -EBUSY : 0;
+    irq_unlock(irq_key);
+
+    if (res)
+        return res;
+
+    res = dsp_acts_post_message(dev, message);
+    if (res)
+        return res;
+
+    /* Wait for the ack bit: 1ms timeout (1us * 1000) */
+    wait_ack_timeout(dsp_cfg->dsp_mailbox, DSP_MSG_ACK_TIMEOUT_US);
+
+    return dsp_acts_finish_message(dev, message);
+}
+
+/*
+ * Sync send. ISRs and the system work queue, which drains the ring, can
+ * not wait for the ring and send directly with the full busy wait; they
+ * get -EBUSY while the ring holds messages. In tree the sync senders are
+ * dsp_acts_suspend and dsp_acts_resume only, kicks are async, and neither
+ * runs from the system work queue or an ISR.
+ */
+int dsp_acts_send_message(struct device *dev, struct dsp_message *message)
+{
+    struct dsp_msg_sync sync;
+    int res;
+
+    if (k_is_in_isr()) {
+        printk("%s: send msg (%u:%u) in isr\n", __func__,
+               message->owner, message->id);
+        return dsp_acts_send_message_direct(dev, message);
+    }
+
+    /* the ring is drained by the system work queue */
+    if (k_current_get() == &k_sys_work_q.thread)
+        return dsp_acts_send_message_direct(dev, message);
+
+    k_sem_init(&sync.sem, 0, 1);
+    sync.message = message;
+    sync.res = 0;
+
+    res = dsp_acts_send_message_async(dev, message, dsp_msg_sync_callback, &sync);
+    if (res < 0)
+        return res;
+
+    /* every queued message completes within the ack timeout and a tick once posted */
+    k_sem_take(&sync.sem, K_FOREVER);
+
+    return sync.res;
+}
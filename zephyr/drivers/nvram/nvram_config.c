@@ -66,6 +66,14 @@ struct __packed nvram_item {
 	char data[0];
 };
 
+#ifdef CONFIG_NVRAM_HASH_INDEX
+struct nvram_index_entry {
+	uint32_t hash;
+	/* item offset in segment, 0 means empty slot, segments are at most 64 KB */
+	uint16_t offs;
+};
+#endif
+
 struct region_info
 {
 	struct device *storage;
@@ -88,6 +96,14 @@ struct region_info
 	uint32_t *seg_item_map;
 	int seg_item_map_size;
 #endif
+
+#ifdef CONFIG_NVRAM_HASH_INDEX
+	/* name hash -> item offset in current segment */
+	struct nvram_index_entry *index;
+	int index_size;
+	int index_count;
+	uint8_t index_overflow;
+#endif
 };
 
 /* region segment magic: 'NVRS' */
@@ -107,6 +123,22 @@ struct region_info
 
 #define NVRAM_SEG_ITEM_START_OFFSET	(ROUND_UP(sizeof(struct region_seg_header), NVRAM_ITEM_ALIGN_SIZE))
 
+#ifdef CONFIG_NVRAM_HASH_INDEX
+BUILD_ASSERT((CONFIG_NVRAM_USER_REGION_INDEX_SIZE & (CONFIG_NVRAM_USER_REGION_INDEX_SIZE - 1)) == 0,
+	     "user region index size must be power of 2");
+BUILD_ASSERT((CONFIG_NVRAM_FACTORY_REGION_INDEX_SIZE & (CONFIG_NVRAM_FACTORY_REGION_INDEX_SIZE - 1)) == 0,
+	     "factory region index size must be power of 2");
+/* index entries keep the item offset in 16 bits */
+BUILD_ASSERT(CONFIG_NVRAM_USER_REGION_SEGMENT_SIZE <= UINT16_MAX + 1,
+	     "user region segment too large for the index");
+BUILD_ASSERT(CONFIG_NVRAM_FACTORY_REGION_SEGMENT_SIZE <= UINT16_MAX + 1,
+	     "factory region segment too large for the index");
+
+static struct nvram_index_entry user_region_index[CONFIG_NVRAM_USER_REGION_INDEX_SIZE];
+#if CONFIG_NVRAM_FACTORY_REGION_INDEX_SIZE > 0
+static struct nvram_index_entry factory_region_index[CONFIG_NVRAM_FACTORY_REGION_INDEX_SIZE];
+#endif
+#endif
 
 #ifdef CONFIG_NVRAM_FAST_SEARCH
 uint32_t user_region_item_map[CONFIG_NVRAM_USER_REGION_SEGMENT_SIZE / NVRAM_ITEM_ALIGN_SIZE / 32];
@@ -123,6 +155,10 @@ struct region_info user_nvram_region = {
 	.seg_item_map = user_region_item_map,
 	.seg_item_map_size = sizeof(user_region_item_map),
 #endif
+#ifdef CONFIG_NVRAM_HASH_INDEX
+	.index = user_region_index,
+	.index_size = ARRAY_SIZE(user_region_index),
+#endif
 };
 
 /* factory config region */
@@ -135,6 +171,10 @@ struct region_info factory_nvram_region = {
 	.seg_item_map = NULL,
 	.seg_item_map_size = 0,
 #endif
+#if defined(CONFIG_NVRAM_HASH_INDEX) && (CONFIG_NVRAM_FACTORY_REGION_INDEX_SIZE > 0)
+	.index = factory_region_index,
+	.index_size = ARRAY_SIZE(factory_region_index),
+#endif
 };
 
 #ifdef CONFIG_NVRAM_STORAGE_FACTORY_RW_REGION
@@ -155,6 +195,7 @@ struct region_info factory_rw_nvram_region = {
 
 static uint8_t __act_s2_notsave nvram_buf[NVRAM_BUFFER_SIZE];
 static K_SEM_DEFINE(nvram_lock, 1, 1);
+static nvram_config_set_cb_t nvram_set_cb;
 
 static int region_read(struct region_info *region, uint32_t offset, uint8_t *buf, int len);
 static int region_write(struct region_info *region, uint32_t offset, const uint8_t *buf, int len);
@@ -551,13 +592,22 @@ static int item_check_validity(struct region_info *region, int item_offs, struct
 
 	if (item->state != NVRAM_ITEM_STATE_VALID) {
 		if (item->state != NVRAM_ITEM_STATE_OBSOLETE) {
-			LOG_ERR("invalid item status 0x%x", item->state);
-			return ITEM_STATUS_INVALID;
+			/* state is only programmed from valid to obsolete, other
+			 * value is left by power failure in the middle of it
+			 */
+			LOG_WRN("item 0x%x status 0x%x, take as obsolete",
+				item_offs, item->state);
 		}
 
 		return ITEM_STATUS_OBSOLETE;
 	}
-	
+
+	/* header may be partially programmed */
+	if (item->name_size > NVRAM_MAX_NAME_SIZE || item->data_size > NVRAM_MAX_DATA_SIZE) {
+		LOG_ERR("invalid item size %d %d", item->name_size, item->data_size);
+		return ITEM_STATUS_INVALID;
+	}
+
 	name_offset = item_offs + sizeof(struct nvram_item);
 	/* check config name */
 	region_read(region, name_offset, nvram_buf, item->name_size);
@@ -577,7 +627,7 @@ static int item_check_validity(struct region_info *region, int item_offs, struct
 			LOG_ERR("item crc error! offset 0x%x, crc 0x%x != item->crc 0x%x",
 				item_offs, crc, item->crc);
 
-			item_update_state(region, item_offs - region->seg_offset, NVRAM_ITEM_STATE_OBSOLETE);
+			item_update_state(region, item_offs, NVRAM_ITEM_STATE_OBSOLETE);
 			return ITEM_STATUS_INVALID;
 		}
 	}
@@ -585,6 +635,191 @@ static int item_check_validity(struct region_info *region, int item_offs, struct
 	return ITEM_STATUS_VALID;
 }
 
+#ifdef CONFIG_NVRAM_HASH_INDEX
+/* keep load factor under 3/4 to bound the probe length */
+#define NVRAM_INDEX_MAX_COUNT(size)	((size) * 3 / 4)
+
+/* FNV-1a, used as strong name hash for RAM index */
+static uint32_t calc_name_hash(const uint8_t *key, int len)
+{
+	uint32_t hash = 2166136261u;
+
+	while (len--) {
+		hash ^= *key++;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static inline int region_index_valid(struct region_info *region)
+{
+	return (region->index && !region->index_overflow);
+}
+
+static void region_index_clear(struct region_info *region)
+{
+	if (!region->index)
+		return;
+
+	memset(region->index, 0, region->index_size * sizeof(struct nvram_index_entry));
+	region->index_count = 0;
+	region->index_overflow = 0;
+}
+
+/*
+ * Lookup item by name, only one flash read for each candidate slot
+ * (header and name are read together).
+ * return item offset in region and slot index, or -ENOENT
+ */
+static int region_index_find(struct region_info *region, const char *name,
+			     struct nvram_item *item, int *slot)
+{
+	struct nvram_index_entry *entry;
+	struct nvram_item *hdr;
+	uint32_t hash, item_offs;
+	int i, n, mask, name_size;
+
+	name_size = strlen(name) + 1;
+	if (name_size > NVRAM_MAX_NAME_SIZE)
+		return -ENOENT;
+
+	hash = calc_name_hash(name, name_size);
+	mask = region->index_size - 1;
+	i = hash & mask;
+
+	for (n = 0; n < region->index_size; n++, i = (i + 1) & mask) {
+		entry = &region->index[i];
+		if (!entry->offs)
+			break;
+
+		if (entry->hash != hash)
+			continue;
+
+		item_offs = region->seg_offset + entry->offs;
+		hdr = (struct nvram_item *)nvram_buf;
+
+		/* read item header and name at once */
+		if (region_read(region, item_offs, nvram_buf, sizeof(struct nvram_item) + name_size))
+			break;
+
+		if (hdr->magic == NVRAM_REGION_ITEM_MAGIC &&
+		    hdr->state == NVRAM_ITEM_STATE_VALID &&
+		    hdr->name_size == name_size &&
+		    !memcmp(name, &hdr->data[0], name_size)) {
+			memcpy(item, hdr, sizeof(struct nvram_item));
+			if (slot)
+				*slot = i;
+			return item_offs;
+		}
+	}
+
+	return -ENOENT;
+}
+
+/* remove slot with backward shift, linear probing needs no tombstone */
+static void region_index_remove(struct region_info *region, int slot)
+{
+	struct nvram_index_entry *index = region->index;
+	int i, j, home, mask;
+
+	mask = region->index_size - 1;
+	i = slot;
+	j = slot;
+
+	index[i].offs = 0;
+
+	while (1) {
+		j = (j + 1) & mask;
+		if (!index[j].offs)
+			break;
+
+		home = index[j].hash & mask;
+
+		/* move entry j back to i if its home slot is not in (i, j] */
+		if ((i <= j) ? ((home <= i) || (home > j)) : ((home <= i) && (home > j))) {
+			index[i] = index[j];
+			index[j].offs = 0;
+			i = j;
+		}
+	}
+
+	region->index_count--;
+}
+
+static void region_index_insert(struct region_info *region, uint32_t hash, uint32_t seg_offs)
+{
+	int i, mask;
+
+	if (region->index_count >= NVRAM_INDEX_MAX_COUNT(region->index_size)) {
+		LOG_WRN("region %s: index full, fallback to linear search", region->name);
+		region->index_overflow = 1;
+		return;
+	}
+
+	mask = region->index_size - 1;
+	i = hash & mask;
+
+	while (region->index[i].offs)
+		i = (i + 1) & mask;
+
+	region->index[i].hash = hash;
+	region->index[i].offs = (uint16_t)seg_offs;
+	region->index_count++;
+}
+
+/*
+ * Add item which is already written in current segment to index.
+ * return the segment offset of the replaced item with the same name, or 0
+ */
+static uint32_t region_index_add_item(struct region_info *region, uint32_t seg_offs,
+				      struct nvram_item *item)
+{
+	struct nvram_index_entry *entry;
+	char name[NVRAM_MAX_NAME_SIZE];
+	uint32_t hash, old_offs;
+	int i, n, mask;
+
+	if (!region_index_valid(region))
+		return 0;
+
+	if (item->name_size > NVRAM_MAX_NAME_SIZE) {
+		region->index_overflow = 1;
+		return 0;
+	}
+
+	region_read(region, region->seg_offset + seg_offs + sizeof(struct nvram_item),
+		    name, item->name_size);
+	hash = calc_name_hash(name, item->name_size);
+
+	mask = region->index_size - 1;
+	i = hash & mask;
+
+	for (n = 0; n < region->index_size; n++, i = (i + 1) & mask) {
+		entry = &region->index[i];
+		if (!entry->offs)
+			break;
+
+		if (entry->hash != hash)
+			continue;
+
+		/* hash hit, compare the name of indexed item */
+		region_read(region, region->seg_offset + entry->offs, nvram_buf,
+			    sizeof(struct nvram_item) + item->name_size);
+		if (((struct nvram_item *)nvram_buf)->name_size == item->name_size &&
+		    !memcmp(name, nvram_buf + sizeof(struct nvram_item), item->name_size)) {
+			old_offs = entry->offs;
+			entry->offs = (uint16_t)seg_offs;
+			return old_offs;
+		}
+	}
+
+	region_index_insert(region, hash, seg_offs);
+
+	return 0;
+}
+#endif
+
 static int region_find_item(struct region_info *region, const char *name,
 				struct nvram_item *item)
 {
@@ -595,6 +830,11 @@ static int region_find_item(struct region_info *region, const char *name,
 	if (!name || !item)
 		return -EINVAL;
 
+#ifdef CONFIG_NVRAM_HASH_INDEX
+	if (region_index_valid(region))
+		return region_index_find(region, name, item, NULL);
+#endif
+
 	hash = calc_hash(name, strlen(name) + 1);
 
 #ifdef CONFIG_NVRAM_FAST_SEARCH
@@ -655,6 +895,7 @@ static int region_write_data(struct region_info *region, uint32_t offset,
 {
 	int32_t size, wsize;
 	uint32_t woffs;
+	int err;
 
 	wsize = NVRAM_BUFFER_SIZE;
 	woffs = 0;
@@ -666,7 +907,9 @@ static int region_write_data(struct region_info *region, uint32_t offset,
 
 		memcpy(nvram_buf, data + woffs, wsize);
 
-		region_write(region, offset + woffs, nvram_buf, wsize);
+		err = region_write(region, offset + woffs, nvram_buf, wsize);
+		if (err)
+			return err;
 
 		woffs += wsize;
 		size -= wsize;
@@ -680,6 +923,7 @@ static int region_write_item(struct region_info *region, uint32_t offset,
 {
 	struct nvram_item *item;
 	uint32_t item_data_offs, item_size;
+	int err;
 
 	item = (struct nvram_item *)nvram_buf;
 
@@ -705,16 +949,20 @@ static int region_write_item(struct region_info *region, uint32_t offset,
 	}
 
 	memcpy(&item->data[0], name, item->name_size);
-	region_write(region, offset, (uint8_t *)item, item_data_offs);
+	err = region_write(region, offset, (uint8_t *)item, item_data_offs);
+	if (err)
+		return err;
 
 	/* write item data */
 #if 0
 	/* use original data buffer to write data */
-	region_write(region, offset + item_data_offs, data, len);
+	err = region_write(region, offset + item_data_offs, data, len);
 #else
 	/* use nvram buffer to write data to avoid cache-miss when access spinor mapping memory */
-	region_write_data(region, offset + item_data_offs, data, len);
+	err = region_write_data(region, offset + item_data_offs, data, len);
 #endif
+	if (err)
+		return err;
 
 	return item_size;
 }
@@ -733,6 +981,10 @@ int region_copy_seg(struct region_info *region, uint32_t new_seg_offset,
 	item_bitmap_clear_all(region->seg_item_map, region->seg_item_map_size);
 #endif
 
+#ifdef CONFIG_NVRAM_HASH_INDEX
+	region_index_clear(region);
+#endif
+
 	item_offs = old_seg_offset + NVRAM_SEG_ITEM_START_OFFSET;
 	new_item_offs = new_seg_offset + NVRAM_SEG_ITEM_START_OFFSET;
 
@@ -762,6 +1014,9 @@ int region_copy_seg(struct region_info *region, uint32_t new_seg_offset,
 #ifdef CONFIG_NVRAM_FAST_SEARCH
 			item_bitmap_update(region->seg_item_map,
 				new_item_offs - new_seg_offset, 1);
+#endif
+#ifdef CONFIG_NVRAM_HASH_INDEX
+			region_index_add_item(region, new_item_offs - new_seg_offset, &item);
 #endif
 			new_item_offs += item_total_size;
 		}
@@ -775,7 +1030,7 @@ int region_copy_seg(struct region_info *region, uint32_t new_seg_offset,
 	return 0;
 }
 
-static int region_init_new_seg(struct region_info *region, uint32_t seg_offset)
+static void region_write_seg_header(struct region_info *region, uint32_t seg_offset)
 {
 	struct region_seg_header seg_hdr;
 
@@ -790,10 +1045,16 @@ static int region_init_new_seg(struct region_info *region, uint32_t seg_offset)
 	seg_hdr.crc = calc_crc8(((uint8_t *)&seg_hdr) + NVRAM_REGION_SEG_HEADER_CRC_OFFSET,
 		sizeof(struct region_seg_header) - NVRAM_REGION_SEG_HEADER_CRC_OFFSET, 0);
 
-	region_erase(region, seg_offset, region->seg_size);
 	region_write(region, seg_offset, (uint8_t *)&seg_hdr, sizeof(struct region_seg_header));
 
 	region->seg_seq_id = seg_hdr.seq_id;
+}
+
+/* segment header is not written here, see region_write_seg_header() */
+static int region_init_new_seg(struct region_info *region, uint32_t seg_offset)
+{
+	region_erase(region, seg_offset, region->seg_size);
+
 	region->seg_offset = seg_offset;
 	region->seg_write_offset = region->seg_offset + NVRAM_SEG_ITEM_START_OFFSET;
 
@@ -801,20 +1062,33 @@ static int region_init_new_seg(struct region_info *region, uint32_t seg_offset)
 	item_bitmap_clear_all(region->seg_item_map, region->seg_item_map_size);
 #endif
 
+#ifdef CONFIG_NVRAM_HASH_INDEX
+	region_index_clear(region);
+#endif
+
 	return 0;
 }
 
+static uint32_t region_next_seg_offset(struct region_info *region)
+{
+	uint32_t seg_offset;
+
+	seg_offset = region->seg_offset + region->seg_size;
+	if (seg_offset >= region->total_size) {
+		/* wrap to begin of region */
+		seg_offset = 0;
+	}
+
+	return seg_offset;
+}
+
 static int region_purge_seg(struct region_info *region, int check_crc)
 {
 	uint32_t new_seg_offset, old_seg_offset, seg_copy_size;
 
 	LOG_DBG("purge seg offset 0x%x\n", region->seg_offset);
 
-	new_seg_offset = region->seg_offset + region->seg_size;
-	if (new_seg_offset >= region->total_size) {
-		/* wrap to begin of region */
-		new_seg_offset = 0;
-	}
+	new_seg_offset = region_next_seg_offset(region);
 
 	/* check new seg */
 	if (!region_is_empy(region, new_seg_offset, region->seg_size)) {
@@ -832,6 +1106,11 @@ static int region_purge_seg(struct region_info *region, int check_crc)
 	/* copy valid data to new seg */
 	region_copy_seg(region, new_seg_offset, old_seg_offset, seg_copy_size, check_crc);
 
+	/* write header after all items are copied, so that a segment which is
+	 * interrupted by power failure is never taken as the latest one
+	 */
+	region_write_seg_header(region, new_seg_offset);
+
 	/* current seg set to obsolete */
 	region_seg_update_state(region, old_seg_offset, NVRAM_REGION_SEG_STATE_OBSOLETE);
 
@@ -842,6 +1121,10 @@ static int region_prepare_write_item(struct region_info *region, int item_size)
 {
 	if ((region->seg_write_offset + item_size) > (region->seg_offset + region->seg_size)) {
 		region_purge_seg(region, 0);
+
+		/* valid configs still fill the segment */
+		if ((region->seg_write_offset + item_size) > (region->seg_offset + region->seg_size))
+			return -ENOSPC;
 	}
 
 	return 0;
@@ -890,7 +1173,8 @@ static int region_set(struct region_info *region, const char *name,
 {
 	struct nvram_item item;
 	int32_t name_len, new_item_size, item_len;
-	int old_item_offs;
+	int old_item_offs, err;
+	int slot = -1;
 
 	if (!name || (!data && len) || len > NVRAM_MAX_DATA_SIZE)
 		return -EINVAL;
@@ -909,11 +1193,26 @@ static int region_set(struct region_info *region, const char *name,
 		/* write new config */
 		new_item_size = item_calc_aligned_size(name_len, len);
 
-		region_prepare_write_item(region, new_item_size);
+		err = region_prepare_write_item(region, new_item_size);
+		if (err)
+			return err;
 
+#ifdef CONFIG_NVRAM_HASH_INDEX
+		if (region_index_valid(region))
+			old_item_offs = region_index_find(region, name, &item, &slot);
+		else
+#endif
 		old_item_offs = region_find_item(region, name, &item);
 
 		item_len = region_write_item(region, region->seg_write_offset, name, data, len);
+		if (item_len < 0) {
+			/* move valid items to a new segment, so that the partly
+			 * written item does not break the item chain, the old
+			 * config stays valid
+			 */
+			region_purge_seg(region, 0);
+			return item_len;
+		}
 		if (item_len > new_item_size) {
 			LOG_ERR("BUG! new_item_size 0x%x, write item_len 0x%x\n",
 				new_item_size, item_len);
@@ -921,10 +1220,27 @@ static int region_set(struct region_info *region, const char *name,
 #ifdef CONFIG_NVRAM_FAST_SEARCH
 		item_bitmap_update(region->seg_item_map,
 			region->seg_write_offset - region->seg_offset, 1);
+#endif
+#ifdef CONFIG_NVRAM_HASH_INDEX
+		if (region_index_valid(region)) {
+			if (slot >= 0) {
+				/* point the existing slot to the new item */
+				region->index[slot].offs = region->seg_write_offset - region->seg_offset;
+				slot = -1;
+			} else {
+				region_index_insert(region, calc_name_hash(name, name_len),
+					region->seg_write_offset - region->seg_offset);
+			}
+		}
 #endif
 		region->seg_write_offset += new_item_size;
 	}
 	else {
+#ifdef CONFIG_NVRAM_HASH_INDEX
+		if (region_index_valid(region))
+			old_item_offs = region_index_find(region, name, &item, &slot);
+		else
+#endif
 		old_item_offs = region_find_item(region, name, &item);
 	}
 
@@ -936,6 +1252,11 @@ static int region_set(struct region_info *region, const char *name,
 
 #ifdef CONFIG_NVRAM_FAST_SEARCH
 		item_bitmap_update(region->seg_item_map, old_item_offs - region->seg_offset, 0);
+#endif
+#ifdef CONFIG_NVRAM_HASH_INDEX
+		/* config is deleted, drop it from index */
+		if (slot >= 0 && region_index_valid(region))
+			region_index_remove(region, slot);
 #endif
 	}
 
@@ -969,6 +1290,264 @@ static int region_get(struct region_info *region, const char *name,
 	return len;
 }
 
+#ifdef CONFIG_NVRAM_WRITE_JOURNAL
+/* journal entry: header + name + data, data_size 0 means deleted config */
+struct __packed nvram_journal_entry {
+	uint8_t name_size;
+	uint8_t reserved;
+	uint16_t data_size;
+	char data[0];
+};
+
+static uint8_t nvram_journal_buf[CONFIG_NVRAM_JOURNAL_SIZE] __aligned(4);
+static int nvram_journal_len;
+static int nvram_batch_depth;
+/* thread which opened the batch, sets of other threads bypass the journal */
+static k_tid_t nvram_batch_owner;
+static K_SEM_DEFINE(nvram_batch_lock, 1, 1);
+
+static int journal_entry_size(struct nvram_journal_entry *entry)
+{
+	return sizeof(struct nvram_journal_entry) + entry->name_size + entry->data_size;
+}
+
+static struct nvram_journal_entry *journal_find(const char *name, int name_size)
+{
+	struct nvram_journal_entry *entry;
+	int offs = 0;
+
+	while (offs < nvram_journal_len) {
+		entry = (struct nvram_journal_entry *)&nvram_journal_buf[offs];
+		if (entry->name_size == name_size &&
+		    !memcmp(entry->data, name, name_size))
+			return entry;
+
+		offs += journal_entry_size(entry);
+	}
+
+	return NULL;
+}
+
+static void journal_remove(struct nvram_journal_entry *entry)
+{
+	uint8_t *start = (uint8_t *)entry;
+	int size = journal_entry_size(entry);
+	int tail = nvram_journal_len - (start - nvram_journal_buf) - size;
+
+	memmove(start, start + size, tail);
+	nvram_journal_len -= size;
+}
+
+static int journal_add(const char *name, int name_size, const void *data, int len)
+{
+	struct nvram_journal_entry *entry;
+	int size;
+
+	/* last writer wins */
+	entry = journal_find(name, name_size);
+	if (entry)
+		journal_remove(entry);
+
+	size = sizeof(struct nvram_journal_entry) + name_size + len;
+	if (nvram_journal_len + size > CONFIG_NVRAM_JOURNAL_SIZE)
+		return -ENOSPC;
+
+	entry = (struct nvram_journal_entry *)&nvram_journal_buf[nvram_journal_len];
+	entry->name_size = name_size;
+	entry->reserved = 0;
+	entry->data_size = len;
+	memcpy(entry->data, name, name_size);
+	if (len > 0)
+		memcpy(entry->data + name_size, data, len);
+
+	nvram_journal_len += size;
+
+	return 0;
+}
+
+static int journal_get(const char *name, void *data, int max_len)
+{
+	struct nvram_journal_entry *entry;
+	int len;
+
+	entry = journal_find(name, strlen(name) + 1);
+	if (!entry)
+		return -EAGAIN;
+
+	if (!entry->data_size)
+		return -ENOENT;
+
+	len = MIN(max_len, entry->data_size);
+	memcpy(data, entry->data + entry->name_size, len);
+
+	return len;
+}
+
+/* config set by another thread during a batch, drop the older journaled one */
+static void journal_drop(const char *name)
+{
+	struct nvram_journal_entry *entry;
+
+	if (!name)
+		return;
+
+	entry = journal_find(name, strlen(name) + 1);
+	if (entry)
+		journal_remove(entry);
+}
+
+/* program all journal entries in one sequential pass */
+static int journal_commit(struct region_info *region)
+{
+	struct nvram_journal_entry *entry;
+	int offs, total_size;
+	int ret, err = 0;
+
+	if (!nvram_journal_len)
+		return 0;
+
+	total_size = 0;
+	for (offs = 0; offs < nvram_journal_len; offs += journal_entry_size(entry)) {
+		entry = (struct nvram_journal_entry *)&nvram_journal_buf[offs];
+		if (entry->data_size)
+			total_size += item_calc_aligned_size(entry->name_size, entry->data_size);
+	}
+
+	LOG_DBG("commit journal len %d, item size 0x%x", nvram_journal_len, total_size);
+
+	/* purge at most once before the pass instead of in the middle, the
+	 * items are written one by one if they do not fit in one segment
+	 */
+	region_prepare_write_item(region, total_size);
+
+	/* replay all entries even if one fails, report the first error */
+	for (offs = 0; offs < nvram_journal_len; offs += journal_entry_size(entry)) {
+		entry = (struct nvram_journal_entry *)&nvram_journal_buf[offs];
+		ret = region_set(region, entry->data, entry->data + entry->name_size,
+				 entry->data_size);
+		if (ret && !err) {
+			LOG_ERR("commit config %s failed %d", entry->data, ret);
+			err = ret;
+		}
+	}
+
+	nvram_journal_len = 0;
+
+	return err;
+}
+
+static int journal_set(struct region_info *region, const char *name,
+		       const void *data, int len)
+{
+	int name_size, ret;
+
+	if (!name || (!data && len) || len > NVRAM_MAX_DATA_SIZE)
+		return -EINVAL;
+
+	name_size = strlen(name) + 1;
+	if (name_size > NVRAM_MAX_NAME_SIZE)
+		return -EINVAL;
+
+	if (!journal_add(name, name_size, data, len))
+		return 0;
+
+	/* journal is full, commit pending configs and retry */
+	ret = journal_commit(region);
+	if (ret)
+		return ret;
+
+	if (!journal_add(name, name_size, data, len))
+		return 0;
+
+	/* too large for journal */
+	return region_set(region, name, data, len);
+}
+#endif
+
+#ifdef CONFIG_NVRAM_DEFERRED_COMPACT
+static struct k_work_q nvram_compact_q;
+static K_THREAD_STACK_DEFINE(nvram_compact_stack, CONFIG_NVRAM_COMPACT_WORKQ_STACK_SIZE);
+static struct k_work nvram_compact_work;
+static uint8_t nvram_compact_ready;
+/* write offset right after last compaction, avoid purging again for nothing */
+static uint32_t nvram_compact_write_offset;
+
+static int nvram_compact_need_purge(struct region_info *region)
+{
+	int free_size;
+
+	free_size = region->seg_offset + region->seg_size - region->seg_write_offset;
+
+	return (free_size < CONFIG_NVRAM_COMPACT_FREE_SIZE &&
+		region->seg_write_offset != nvram_compact_write_offset);
+}
+
+static void nvram_compact_work_handler(struct k_work *work)
+{
+	struct region_info *region = &user_nvram_region;
+	uint32_t next_seg_offset, offs;
+	int done = 0;
+
+	k_sem_take(&nvram_lock, K_FOREVER);
+
+	/* erase at most one sector of the next segment per step */
+	next_seg_offset = region_next_seg_offset(region);
+	for (offs = next_seg_offset; offs < next_seg_offset + region->seg_size;
+	     offs += NVRAM_ERASE_ALIGN_SIZE) {
+		if (!region_is_empy(region, offs, NVRAM_ERASE_ALIGN_SIZE)) {
+			region_erase(region, offs, NVRAM_ERASE_ALIGN_SIZE);
+			break;
+		}
+	}
+
+	if (offs >= next_seg_offset + region->seg_size) {
+		/* next segment is clean now, copy valid items without erasing */
+		if (nvram_compact_need_purge(region)) {
+			LOG_INF("compact seg 0x%x", region->seg_offset);
+			region_purge_seg(region, 0);
+			nvram_compact_write_offset = region->seg_write_offset;
+		}
+		done = 1;
+	}
+
+	nvram_storage_flush(region->storage);
+	k_sem_give(&nvram_lock);
+
+	if (!done) {
+		/* give way to other threads between erase steps */
+		k_work_submit_to_queue(&nvram_compact_q, work);
+	}
+}
+
+/* called with nvram_lock held */
+static void nvram_compact_check(struct region_info *region)
+{
+	/* next segment must not be the current one */
+	if (region->total_size < 2 * region->seg_size)
+		return;
+
+	if (nvram_compact_ready && nvram_compact_need_purge(region))
+		k_work_submit_to_queue(&nvram_compact_q, &nvram_compact_work);
+}
+
+static int nvram_compact_init(const struct device *dev)
+{
+	ARG_UNUSED(dev);
+
+	k_work_init(&nvram_compact_work, nvram_compact_work_handler);
+	k_work_queue_start(&nvram_compact_q, nvram_compact_stack,
+			   K_THREAD_STACK_SIZEOF(nvram_compact_stack),
+			   CONFIG_NVRAM_COMPACT_WORKQ_PRIORITY, NULL);
+	k_thread_name_set(&nvram_compact_q.thread, "nvram_compact");
+
+	nvram_compact_ready = 1;
+
+	return 0;
+}
+
+SYS_INIT(nvram_compact_init, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+#endif
+
 extern void print_buffer(const struct shell *shell,const char *addr, int width, 
 						int count, int linelen, unsigned long disp_addr);
 static void region_dump_data(const struct shell *shell, struct region_info *region, uint32_t offset, int32_t size)
@@ -1007,6 +1586,13 @@ static void region_dump(const struct shell *shell, struct region_info *region, i
 		region->seg_offset, region->seg_size, region->seg_seq_id,
 		region->seg_write_offset);
 
+#ifdef CONFIG_NVRAM_HASH_INDEX
+	if (region->index) {
+		printk("region index %d/%d items%s\n", region->index_count,
+			region->index_size, region->index_overflow ? ", overflow" : "");
+	}
+#endif
+
 	if (!detailed)
 		return;
 
@@ -1074,16 +1660,52 @@ static bool is_valid_region_seg_header(struct region_seg_header *hdr)
 	return true;
 }
 
+/*
+ * Return segment offset of the valid item with the same name as the newly
+ * scanned item at seg_offs, or 0. Without usable index the items scanned
+ * so far are searched linearly.
+ */
+static uint32_t region_scan_find_dup(struct region_info *region, uint32_t seg_offs,
+				     struct nvram_item *item)
+{
+	struct nvram_item old_item;
+	char name[NVRAM_MAX_NAME_SIZE];
+	int old_offs;
+
+#ifdef CONFIG_NVRAM_HASH_INDEX
+	if (region_index_valid(region))
+		return region_index_add_item(region, seg_offs, item);
+#endif
+
+	if (!item->name_size)
+		return 0;
+
+	region_read(region, region->seg_offset + seg_offs + sizeof(struct nvram_item),
+		    name, item->name_size);
+	name[item->name_size - 1] = '\0';
+
+	old_offs = region_find_item(region, name, &old_item);
+	if (old_offs < 0 || (old_offs - region->seg_offset) >= seg_offs)
+		return 0;
+
+	return old_offs - region->seg_offset;
+}
+
 static int region_seg_scan(struct region_info *region)
 {
 	struct nvram_item item;
 	int err, offs, item_offs, status;
 	int need_purge = 0;
+	uint32_t old_offs;
 
 #ifdef CONFIG_NVRAM_FAST_SEARCH
 	item_bitmap_clear_all(region->seg_item_map, region->seg_item_map_size);
 #endif
 
+#ifdef CONFIG_NVRAM_HASH_INDEX
+	region_index_clear(region);
+#endif
+
 	offs = NVRAM_SEG_ITEM_START_OFFSET;
 	item_offs = region->seg_offset + offs;
 	while (offs < region->seg_size) {
@@ -1100,6 +1722,16 @@ static int region_seg_scan(struct region_info *region)
 		LOG_DBG("item_offs 0x%x: status 0x%x", item_offs, status);
 
 		if (status == ITEM_STATUS_VALID) {
+			old_offs = region_scan_find_dup(region, offs, &item);
+			if (old_offs) {
+				/* power lost before the old item was obsoleted, keep the newer one */
+				LOG_WRN("duplicated item 0x%x, obsolete it", region->seg_offset + old_offs);
+				item_update_state(region, region->seg_offset + old_offs,
+					NVRAM_ITEM_STATE_OBSOLETE);
+#ifdef CONFIG_NVRAM_FAST_SEARCH
+				item_bitmap_update(region->seg_item_map, old_offs, 0);
+#endif
+			}
 #ifdef CONFIG_NVRAM_FAST_SEARCH
 			item_bitmap_update(region->seg_item_map, offs, 1);
 #endif
@@ -1172,6 +1804,7 @@ static int region_scan(struct region_info *region)
 	else {
 		LOG_DBG("region %s: first init\n", region->name);
 		region_init_new_seg(region, 0);
+		region_write_seg_header(region, 0);
 	}
 
 	return 0;
@@ -1195,10 +1828,92 @@ int nvram_config_set(const char *name, const void *data, int len)
 	int ret;
 
 	k_sem_take(&nvram_lock, K_FOREVER);
+#ifdef CONFIG_NVRAM_WRITE_JOURNAL
+	if (nvram_batch_depth) {
+		if (nvram_batch_owner == k_current_get()) {
+			ret = journal_set(&user_nvram_region, name, data, len);
+			k_sem_give(&nvram_lock);
+			goto exit;
+		}
+
+		journal_drop(name);
+	}
+#endif
 	ret = region_set(&user_nvram_region, name, data, len);
 	nvram_storage_flush(user_nvram_region.storage);
+#ifdef CONFIG_NVRAM_DEFERRED_COMPACT
+	nvram_compact_check(&user_nvram_region);
+#endif
 	k_sem_give(&nvram_lock);
 
+#ifdef CONFIG_NVRAM_WRITE_JOURNAL
+exit:
+#endif
+	/* called without nvram lock, the callback may take its own lock */
+	if (!ret && nvram_set_cb)
+		nvram_set_cb(name);
+
+	return ret;
+}
+
+void nvram_config_set_callback(nvram_config_set_cb_t cb)
+{
+	nvram_set_cb = cb;
+}
+
+int nvram_config_batch_begin(void)
+{
+#ifdef CONFIG_NVRAM_WRITE_JOURNAL
+	k_tid_t tid = k_current_get();
+
+	k_sem_take(&nvram_lock, K_FOREVER);
+	if (nvram_batch_depth && nvram_batch_owner == tid) {
+		/* nested batch */
+		nvram_batch_depth++;
+		k_sem_give(&nvram_lock);
+		return 0;
+	}
+	k_sem_give(&nvram_lock);
+
+	/* one batch at a time, wait for the batch of other thread */
+	k_sem_take(&nvram_batch_lock, K_FOREVER);
+
+	k_sem_take(&nvram_lock, K_FOREVER);
+	nvram_batch_owner = tid;
+	nvram_batch_depth = 1;
+	k_sem_give(&nvram_lock);
+#endif
+	return 0;
+}
+
+int nvram_config_batch_commit(void)
+{
+	int ret = 0;
+#ifdef CONFIG_NVRAM_WRITE_JOURNAL
+	k_sem_take(&nvram_lock, K_FOREVER);
+
+	if (!nvram_batch_depth || nvram_batch_owner != k_current_get()) {
+		k_sem_give(&nvram_lock);
+		return -EPERM;
+	}
+
+	if (--nvram_batch_depth) {
+		k_sem_give(&nvram_lock);
+		return 0;
+	}
+
+	if (nvram_journal_len) {
+		ret = journal_commit(&user_nvram_region);
+		nvram_storage_flush(user_nvram_region.storage);
+#ifdef CONFIG_NVRAM_DEFERRED_COMPACT
+		nvram_compact_check(&user_nvram_region);
+#endif
+	}
+
+	nvram_batch_owner = NULL;
+	k_sem_give(&nvram_lock);
+	k_sem_give(&nvram_batch_lock);
+#endif
 	return ret;
 }
 
@@ -1220,9 +1935,18 @@ int nvram_config_get(const char *name, void *data, int max_len)
 
 	k_sem_take(&nvram_lock, K_FOREVER);
 
+	ret = -EAGAIN;
+#ifdef CONFIG_NVRAM_WRITE_JOURNAL
+	/* not committed configs of own batch, -ENOENT if deleted in journal */
+	if (nvram_journal_len && name && data &&
+	    nvram_batch_owner == k_current_get())
+		ret = journal_get(name, data, max_len);
+#endif
+
 	/* config priority: user > factory rw >  factory ro */
 	/* search user nvram region */
-	ret = region_get(&user_nvram_region, name, data, max_len);
+	if (ret == -EAGAIN)
+		ret = region_get(&user_nvram_region, name, data, max_len);
 	if (ret >= 0){
 		k_sem_give(&nvram_lock);
 		return ret;
@@ -1268,6 +1992,11 @@ int nvram_config_clear_all(void)
 
 	k_sem_take(&nvram_lock, K_FOREVER);
 
+#ifdef CONFIG_NVRAM_WRITE_JOURNAL
+	/* drop pending configs */
+	nvram_journal_len = 0;
+#endif
+
 	/* erase region */
 	region_erase(region, 0, region->total_size);
 
@@ -1277,6 +2006,9 @@ int nvram_config_clear_all(void)
 	nvram_storage_flush(region->storage);
 	k_sem_give(&nvram_lock);
 
+	if (nvram_set_cb)
+		nvram_set_cb(NULL);
+
 	return 0;
 }
 
@@ -3,6 +3,177 @@
 #include <brom_interface.h>
 #endif
 
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include <arch/arm/aarch32/cortex_m/cmsis.h>
+#define SW_BLEND_SIMD 1
+#endif
+
+/*
+ * Row kernels
+ *
+ * Every row is walked in groups of 2 (32-bit source) or 4 (24-bit source)
+ * pixels. A group whose pixels are all opaque is converted and stored
+ * directly, a group whose pixels are all transparent is skipped, the other
+ * groups are blended pixel by pixel, which gives the same result as the
+ * per pixel blend_xxx() helpers.
+ */
+
+#ifndef CONFIG_GUI_API_BROM
+static inline uint16_t _blend_rgb565_over_rgb565(uint16_t dest_color, uint16_t src_color, uint8_t src_a)
+{
+#ifdef SW_BLEND_SIMD
+	if (src_a <= 0) {
+		return dest_color;
+	} else if (src_a >= 255) {
+		return src_color;
+	} else {
+		/* each channel: dest * (255 - a) + src * a in one dual multiply */
+		uint32_t alpha = __PKHBT(255 - src_a, (uint32_t)src_a, 16);
+		uint32_t dest_r = __SMUAD(__PKHBT(dest_color >> 11, (uint32_t)src_color >> 11, 16), alpha);
+		uint32_t dest_g = __SMUAD(__PKHBT(dest_color & 0x07e0, (uint32_t)(src_color & 0x07e0), 16), alpha);
+		uint32_t dest_b = __SMUAD(__PKHBT(dest_color & 0x001f, (uint32_t)(src_color & 0x001f), 16), alpha);
+
+		return ((dest_r >> 8) << 11) | ((dest_g >> 8) & 0x07e0) | (dest_b >> 8);
+	}
+#else
+	return blend_rgb565_over_rgb565(dest_color, src_color, src_a);
+#endif
+}
+
+static void _blend_argb8565_over_rgb565_row(uint16_t *dst, const uint8_t *src, int w)
+{
+	for (; w >= 4; w -= 4) {
+		uint8_t a_and = src[2] & src[5] & src[8] & src[11];
+		uint8_t a_or = src[2] | src[5] | src[8] | src[11];
+
+		if (a_and == 255) {
+#ifdef SW_BLEND_SIMD
+			uint32_t w0 = __UNALIGNED_UINT32_READ(src);
+			uint32_t w1 = __UNALIGNED_UINT32_READ(src + 4);
+			uint32_t w2 = __UNALIGNED_UINT32_READ(src + 8);
+
+			__UNALIGNED_UINT32_WRITE(dst, __PKHBT(w0, (w0 >> 24) | (w1 << 8), 16));
+			__UNALIGNED_UINT32_WRITE(dst + 2, __PKHBT(w1 >> 16, w2 >> 8, 16));
+#else
+			dst[0] = ((uint16_t)src[1] << 8) | src[0];
+			dst[1] = ((uint16_t)src[4] << 8) | src[3];
+			dst[2] = ((uint16_t)src[7] << 8) | src[6];
+			dst[3] = ((uint16_t)src[10] << 8) | src[9];
+#endif
+		} else if (a_or > 0) {
+			for (int i = 0; i < 4; i++) {
+				const uint8_t *src8 = src + i * 3;
+
+				dst[i] = _blend_rgb565_over_rgb565(dst[i],
+						((uint16_t)src8[1] << 8) | src8[0], src8[2]);
+			}
+		}
+
+		dst += 4;
+		src += 12;
+	}
+
+	for (; w > 0; w--) {
+		*dst = _blend_rgb565_over_rgb565(*dst, ((uint16_t)src[1] << 8) | src[0], src[2]);
+		dst++;
+		src += 3;
+	}
+}
+#endif /* CONFIG_GUI_API_BROM */
+
+static void _blend_argb6666_over_rgb565_row(uint16_t *dst, const uint8_t *src, int w)
+{
+	for (; w >= 4; w -= 4) {
+		/* alpha is the high 6 bits of the 3rd byte */
+		uint8_t a_and = src[2] & src[5] & src[8] & src[11];
+		uint8_t a_or = src[2] | src[5] | src[8] | src[11];
+
+		if (a_and >= 0xfc) {
+			for (int i = 0; i < 4; i++) {
+				const uint8_t *src8 = src + i * 3;
+
+				/* r(5) at bit 11, g(6) at bit 5, b(5) at bit 0 */
+				dst[i] = ((src8[2] & 0x03) << 14) | ((src8[1] & 0xe0) << 6) |
+						((src8[1] & 0x0f) << 7) | ((src8[0] & 0xc0) >> 1) |
+						((src8[0] & 0x3e) >> 1);
+			}
+		} else if (a_or >= 0x04) {
+			for (int i = 0; i < 4; i++)
+				dst[i] = blend_argb6666_over_rgb565(dst[i], src + i * 3);
+		}
+
+		dst += 4;
+		src += 12;
+	}
+
+	for (; w > 0; w--) {
+		*dst = blend_argb6666_over_rgb565(*dst, src);
+		dst++;
+		src += 3;
+	}
+}
+
+#ifndef CONFIG_GUI_API_BROM
+static inline uint16_t _argb8888_to_rgb565(uint32_t color)
+{
+	return ((color & 0xf80000) >> 8) | ((color & 0x00fc00) >> 5) |
+			((color & 0x0000f8) >> 3);
+}
+
+static inline void _store_rgb565x2(uint16_t *dst, uint16_t c0, uint16_t c1)
+{
+#ifdef SW_BLEND_SIMD
+	__UNALIGNED_UINT32_WRITE(dst, __PKHBT(c0, (uint32_t)c1, 16));
+#else
+	dst[0] = c0;
+	dst[1] = c1;
+#endif
+}
+
+static void _blend_argb8888_over_rgb565_row(uint16_t *dst, const uint32_t *src, int w)
+{
+	for (; w >= 2; w -= 2) {
+		uint32_t s0 = src[0];
+		uint32_t s1 = src[1];
+
+		if ((s0 & s1) >= 0xff000000) {
+			_store_rgb565x2(dst, _argb8888_to_rgb565(s0), _argb8888_to_rgb565(s1));
+		} else if ((s0 | s1) >= 0x01000000) {
+			dst[0] = blend_argb8888_over_rgb565(dst[0], s0);
+			dst[1] = blend_argb8888_over_rgb565(dst[1], s1);
+		}
+
+		dst += 2;
+		src += 2;
+	}
+
+	if (w > 0)
+		*dst = blend_argb8888_over_rgb565(*dst, *src);
+}
+
+static void _blend_argb8888_over_argb8888_row(uint32_t *dst, const uint32_t *src, int w)
+{
+	for (; w >= 2; w -= 2) {
+		uint32_t s0 = src[0];
+		uint32_t s1 = src[1];
+
+		if ((s0 & s1) >= 0xff000000) {
+			dst[0] = s0;
+			dst[1] = s1;
+		} else if ((s0 | s1) >= 0x01000000) {
+			dst[0] = blend_argb8888_over_argb8888(dst[0], s0);
+			dst[1] = blend_argb8888_over_argb8888(dst[1], s1);
+		}
+
+		dst += 2;
+		src += 2;
+	}
+
+	if (w > 0)
+		*dst = blend_argb8888_over_argb8888(*dst, *src);
+}
+#endif /* CONFIG_GUI_API_BROM */
+
 void sw_blend_argb8565_over_rgb565(void *dst, const void *src,
 		uint16_t dst_stride, uint16_t src_stride, uint16_t w, uint16_t h)
 {
@@ -13,18 +184,9 @@ void sw_blend_argb8565_over_rgb565(void *dst, const void *src,
 	const uint8_t *src8 = src;
 	uint16_t *dst16 = dst;
 	uint16_t src_y_step = src_stride * 3;
-	uint16_t src_x_step = 3;
 
 	for (int j = h; j > 0; j--) {
-		const uint8_t *tmp_src8 = src8;
-		uint16_t *tmp_dst = dst16;
-
-		for (int i = w; i > 0; i--) {
-			*tmp_dst = blend_rgb565_over_rgb565(*tmp_dst,
-					((uint16_t)tmp_src8[1] << 8) | tmp_src8[0], tmp_src8[2]);
-			tmp_dst++;
-			tmp_src8 += src_x_step;
-		}
+		_blend_argb8565_over_rgb565_row(dst16, src8, w);
 
 		dst16 += dst_stride;
 		src8 += src_y_step;
@@ -38,17 +200,9 @@ void sw_blend_argb6666_over_rgb565(void *dst, const void *src,
 	const uint8_t *src8 = src;
 	uint16_t *dst16 = dst;
 	uint16_t src_y_step = src_stride * 3;
-	uint16_t src_x_step = 3;
 
 	for (int j = h; j > 0; j--) {
-		const uint8_t *tmp_src8 = src8;
-		uint16_t *tmp_dst = dst16;
-
-		for (int i = w; i > 0; i--) {
-			*tmp_dst = blend_argb6666_over_rgb565(*tmp_dst, tmp_src8);
-			tmp_dst++;
-			tmp_src8 += src_x_step;
-		}
+		_blend_argb6666_over_rgb565_row(dst16, src8, w);
 
 		dst16 += dst_stride;
 		src8 += src_y_step;
@@ -66,14 +220,7 @@ void sw_blend_argb8888_over_rgb565(void *dst, const void *src,
 	uint16_t *dst16 = dst;
 
 	for (int j = h; j > 0; j--) {
-		const uint32_t *tmp_src = src32;
-		uint16_t *tmp_dst = dst16;
-
-		for (int i = w; i > 0; i--) {
-			*tmp_dst = blend_argb8888_over_rgb565(*tmp_dst, *tmp_src);
-			tmp_dst++;
-			tmp_src++;
-		}
+		_blend_argb8888_over_rgb565_row(dst16, src32, w);
 
 		src32 += src_stride;
 		dst16 += dst_stride;
@@ -92,14 +239,7 @@ void sw_blend_argb8888_over_argb8888(void *dst, const void *src,
 	uint32_t *dst32 = dst;
 
 	for (int j = h; j > 0; j--) {
-		const uint32_t *tmp_src = src32;
-		uint32_t *tmp_dst = dst32;
-
-		for (int i = w; i > 0; i--) {
-			*tmp_dst = blend_argb8888_over_argb8888(*tmp_dst, *tmp_src);
-			tmp_dst++;
-			tmp_src++;
-		}
+		_blend_argb8888_over_argb8888_row(dst32, src32, w);
 
 		src32 += src_stride;
 		dst32 += dst_stride;
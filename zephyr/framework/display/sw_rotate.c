@@ -4,6 +4,11 @@
 #include <brom_interface.h>
 #endif
 
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include <arch/arm/aarch32/cortex_m/cmsis.h>
+#define SW_ROTATE_SIMD 1
+#endif
+
 #ifndef MAX
 #define MAX(a, b) (((a) > (b)) ? (a) : (b))
 #endif
@@ -78,6 +83,169 @@ static inline void sw_rotate_compoute_x_range(
 	}
 }
 
+/*
+ * Row kernels
+ *
+ * The pixels of a row inside the source image are filtered one after
+ * another, the rgb565 row is stored 2 pixels at a time. Pixels falling on
+ * the source pixel grid skip the filtering, and pixels whose neighbours are
+ * all transparent skip both the filtering and the blending, the result is
+ * the same as the per pixel bilinear_xxx() and blend_xxx() helpers.
+ */
+
+#ifdef SW_ROTATE_SIMD
+/*
+ * rgb565 bilinear filtering of bilinear_rgb565_fast_m6() with tap_bits 6
+ *
+ * @param top c00 in low half-word, c10 in high half-word
+ * @param bottom c01 in low half-word, c11 in high half-word
+ */
+static inline uint16_t _bilinear_rgb565_x2(uint32_t top, uint32_t bottom,
+		int16_t x_tap, int16_t y_tap)
+{
+	uint32_t pm11 = (x_tap * y_tap) >> 6;
+	uint32_t pm10 = x_tap - pm11;
+	uint32_t pm01 = y_tap - pm11;
+	uint32_t pm00 = (1 << 6) - pm01 - pm10 - pm11;
+	uint32_t pm_top = __PKHBT(pm00, pm10, 16);
+	uint32_t pm_bottom = __PKHBT(pm01, pm11, 16);
+
+	/* one channel of the 4 pixels in two dual multiplies */
+	uint32_t r = __SMLAD((bottom >> 11) & 0x001f001f, pm_bottom,
+			__SMUAD((top >> 11) & 0x001f001f, pm_top));
+	uint32_t g = __SMLAD((bottom >> 5) & 0x003f003f, pm_bottom,
+			__SMUAD((top >> 5) & 0x003f003f, pm_top));
+	uint32_t b = __SMLAD(bottom & 0x001f001f, pm_bottom,
+			__SMUAD(top & 0x001f001f, pm_top));
+
+	return ((r >> 6) << 11) | ((g >> 6) << 5) | (b >> 6);
+}
+#endif /* SW_ROTATE_SIMD */
+
+#ifndef CONFIG_GUI_API_BROM
+static inline uint16_t _rotate_rgb565_pixel(const uint8_t *src, uint16_t src_pitch,
+		int32_t p_x, int32_t p_y)
+{
+	int x = FLOOR_FIXEDPOINT16(p_x);
+	int y = FLOOR_FIXEDPOINT16(p_y);
+	int16_t x_tap = (p_x - FIXEDPOINT16(x)) >> 10;
+	int16_t y_tap = (p_y - FIXEDPOINT16(y)) >> 10;
+	const uint8_t *src1 = src + y * src_pitch + x * 2;
+
+	if ((x_tap | y_tap) == 0)
+		return *(const uint16_t *)src1;
+
+#ifdef SW_ROTATE_SIMD
+	return _bilinear_rgb565_x2(__UNALIGNED_UINT32_READ(src1),
+			__UNALIGNED_UINT32_READ(src1 + src_pitch), x_tap, y_tap);
+#else
+	return bilinear_rgb565_fast_m6(*(uint16_t *)src1, *(uint16_t *)(src1 + 2),
+			*(uint16_t *)(src1 + src_pitch), *(uint16_t *)(src1 + src_pitch + 2),
+			x_tap, y_tap, 6);
+#endif
+}
+
+static void _rotate_rgb565_over_rgb565_row(uint16_t *dst, const uint8_t *src,
+		uint16_t src_pitch, int32_t p_x, int32_t p_y, int32_t dx, int32_t dy, int n)
+{
+	for (; n >= 2; n -= 2) {
+		uint16_t c0 = _rotate_rgb565_pixel(src, src_pitch, p_x, p_y);
+		uint16_t c1 = _rotate_rgb565_pixel(src, src_pitch, p_x + dx, p_y + dy);
+
+#ifdef SW_ROTATE_SIMD
+		__UNALIGNED_UINT32_WRITE(dst, __PKHBT(c0, (uint32_t)c1, 16));
+#else
+		dst[0] = c0;
+		dst[1] = c1;
+#endif
+		p_x += dx * 2;
+		p_y += dy * 2;
+		dst += 2;
+	}
+
+	if (n > 0)
+		*dst = _rotate_rgb565_pixel(src, src_pitch, p_x, p_y);
+}
+#endif /* CONFIG_GUI_API_BROM */
+
+static void _rotate_argb8565_over_rgb565_row(uint16_t *dst, const uint8_t *src,
+		uint16_t src_pitch, int32_t p_x, int32_t p_y, int32_t dx, int32_t dy, int n)
+{
+	for (; n > 0; n--, p_x += dx, p_y += dy, dst++) {
+		int x = FLOOR_FIXEDPOINT16(p_x);
+		int y = FLOOR_FIXEDPOINT16(p_y);
+		int16_t x_tap = (p_x - FIXEDPOINT16(x)) >> 10;
+		int16_t y_tap = (p_y - FIXEDPOINT16(y)) >> 10;
+		const uint8_t *src1 = src + y * src_pitch + x * 3;
+		const uint8_t *src3 = src1 + src_pitch;
+		uint8_t src_a = src1[2];
+		uint16_t color;
+
+		/* only the alpha of the top left pixel is used */
+		if (src_a == 0)
+			continue;
+
+		if ((x_tap | y_tap) == 0) {
+			color = ((uint16_t)src1[1] << 8) | src1[0];
+		} else {
+#ifdef SW_ROTATE_SIMD
+			color = _bilinear_rgb565_x2(
+					__PKHBT(((uint32_t)src1[1] << 8) | src1[0],
+						((uint32_t)src1[4] << 8) | src1[3], 16),
+					__PKHBT(((uint32_t)src3[1] << 8) | src3[0],
+						((uint32_t)src3[4] << 8) | src3[3], 16),
+					x_tap, y_tap);
+#else
+			color = bilinear_rgb565_fast_m6(
+					((uint16_t)src1[1] << 8) | src1[0],
+					((uint16_t)src1[4] << 8) | src1[3],
+					((uint16_t)src3[1] << 8) | src3[0],
+					((uint16_t)src3[4] << 8) | src3[3],
+					x_tap, y_tap, 6);
+#endif
+		}
+
+		*dst = blend_rgb565_over_rgb565(*dst, color, src_a);
+	}
+}
+
+#ifndef CONFIG_GUI_API_BROM
+static inline uint32_t _rotate_argb8888_pixel(const uint8_t *src, uint16_t src_pitch,
+		int32_t p_x, int32_t p_y)
+{
+	int x = FLOOR_FIXEDPOINT16(p_x);
+	int y = FLOOR_FIXEDPOINT16(p_y);
+	int16_t x_tap = (p_x - FIXEDPOINT16(x)) >> 8;
+	int16_t y_tap = (p_y - FIXEDPOINT16(y)) >> 8;
+	const uint32_t *src1 = (const uint32_t *)(src + y * src_pitch + x * 4);
+	const uint32_t *src3 = (const uint32_t *)((const uint8_t *)src1 + src_pitch);
+
+	if ((x_tap | y_tap) == 0)
+		return src1[0];
+
+	/* filtered alpha is 0 if all the 4 pixels are transparent */
+	if (((src1[0] | src1[1] | src3[0] | src3[1]) >> 24) == 0)
+		return 0;
+
+	return bilinear_argb8888_fast_m8(src1[0], src1[1], src3[0], src3[1],
+			x_tap, y_tap, 8);
+}
+
+static void _rotate_argb8888_over_rgb565_row(uint16_t *dst, const uint8_t *src,
+		uint16_t src_pitch, int32_t p_x, int32_t p_y, int32_t dx, int32_t dy, int n)
+{
+	for (; n > 0; n--, p_x += dx, p_y += dy, dst++)
+		*dst = blend_argb8888_over_rgb565(*dst, _rotate_argb8888_pixel(src, src_pitch, p_x, p_y));
+}
+
+static void _rotate_argb8888_over_argb8888_row(uint32_t *dst, const uint8_t *src,
+		uint16_t src_pitch, int32_t p_x, int32_t p_y, int32_t dx, int32_t dy, int n)
+{
+	for (; n > 0; n--, p_x += dx, p_y += dy, dst++)
+		*dst = blend_argb8888_over_argb8888(*dst, _rotate_argb8888_pixel(src, src_pitch, p_x, p_y));
+}
+#endif /* CONFIG_GUI_API_BROM */
+
 void sw_rotate_configure(int16_t draw_x, int16_t draw_y, int16_t img_x, int16_t img_y,
 		int16_t pivot_x, int16_t pivot_y, uint16_t angle, sw_rotate_config_t *cfg)
 {
@@ -121,7 +289,6 @@ void sw_rotate_rgb565_over_rgb565(void *dst, const void *src,
 #else
 	uint16_t * dst16 = dst;
 	uint16_t src_pitch = src_w * 2;
-	uint16_t src_bytes_per_pixel = 2;
 	int32_t src_coord_x = cfg->src_coord_x0 +
 			y * cfg->src_coord_dx_ay + x * cfg->src_coord_dx_ax;
 	int32_t src_coord_y = cfg->src_coord_y0 +
@@ -144,24 +311,8 @@ void sw_rotate_rgb565_over_rgb565(void *dst, const void *src,
 			tmp_dst += x1;
 		}
 
-		for (int i = x2 - x1; i >= 0; i--) {
-			int x = FLOOR_FIXEDPOINT16(p_x);
-			int y = FLOOR_FIXEDPOINT16(p_y);
-			int x_frac = p_x - FIXEDPOINT16(x);
-			int y_frac = p_y - FIXEDPOINT16(y);
-			uint8_t *src1 = (uint8_t *)src + y * src_pitch + x * src_bytes_per_pixel;
-			uint8_t *src2 = src1 + src_bytes_per_pixel;
-			uint8_t *src3 = src1 + src_pitch;
-			uint8_t *src4 = src2 + src_pitch;
-
-			*tmp_dst = bilinear_rgb565_fast_m6(*(uint16_t*)src1,
-					*(uint16_t*)src2, *(uint16_t*)src3, *(uint16_t*)src4,
-					x_frac >> 10, y_frac >> 10, 6);
-
-			p_x += cfg->src_coord_dx_ax;
-			p_y += cfg->src_coord_dy_ax;
-			tmp_dst += 1;
-		}
+		_rotate_rgb565_over_rgb565_row(tmp_dst, src, src_pitch, p_x, p_y,
+				cfg->src_coord_dx_ax, cfg->src_coord_dy_ax, x2 - x1 + 1);
 
 next_line:
 		src_coord_x += cfg->src_coord_dx_ay;
@@ -178,7 +329,6 @@ void sw_rotate_argb8565_over_rgb565(void *dst, const void *src,
 {
 	uint16_t * dst16 = dst;
 	uint16_t src_pitch = src_w * 3;
-	uint16_t src_bytes_per_pixel = 3;
 	int32_t src_coord_x = cfg->src_coord_x0 +
 			y * cfg->src_coord_dx_ay + x * cfg->src_coord_dx_ax;
 	int32_t src_coord_y = cfg->src_coord_y0 +
@@ -201,29 +351,8 @@ void sw_rotate_argb8565_over_rgb565(void *dst, const void *src,
 			tmp_dst += x1;
 		}
 
-		for (int i = x2 - x1; i >= 0; i--) {
-			int x = FLOOR_FIXEDPOINT16(p_x);
-			int y = FLOOR_FIXEDPOINT16(p_y);
-			int x_frac = p_x - FIXEDPOINT16(x);
-			int y_frac = p_y - FIXEDPOINT16(y);
-			uint8_t *src1 = (uint8_t *)src + y * src_pitch + x * src_bytes_per_pixel;
-			uint8_t *src2 = src1 + src_bytes_per_pixel;
-			uint8_t *src3 = src1 + src_pitch;
-			uint8_t *src4 = src2 + src_pitch;
-
-			uint16_t color = bilinear_rgb565_fast_m6(
-					((uint16_t)src1[1] << 8) | src1[0],
-					((uint16_t)src2[1] << 8) | src2[0],
-					((uint16_t)src3[1] << 8) | src3[0],
-					((uint16_t)src4[1] << 8) | src4[0],
-					x_frac >> 10, y_frac >> 10, 6);
-
-			*tmp_dst = blend_rgb565_over_rgb565(*tmp_dst, color, src1[2]);
-
-			p_x += cfg->src_coord_dx_ax;
-			p_y += cfg->src_coord_dy_ax;
-			tmp_dst += 1;
-		}
+		_rotate_argb8565_over_rgb565_row(tmp_dst, src, src_pitch, p_x, p_y,
+				cfg->src_coord_dx_ax, cfg->src_coord_dy_ax, x2 - x1 + 1);
 
 next_line:
 		src_coord_x += cfg->src_coord_dx_ay;
@@ -243,7 +372,6 @@ void sw_rotate_argb8888_over_rgb565(void *dst, const void *src,
 #else
 	uint16_t * dst16 = dst;
 	uint16_t src_pitch = src_w * 4;
-	uint16_t src_bytes_per_pixel = 4;
 	int32_t src_coord_x = cfg->src_coord_x0 +
 			y * cfg->src_coord_dx_ay + x * cfg->src_coord_dx_ax;
 	int32_t src_coord_y = cfg->src_coord_y0 +
@@ -266,26 +394,8 @@ void sw_rotate_argb8888_over_rgb565(void *dst, const void *src,
 			tmp_dst += x1;
 		}
 
-		for (int i = x2 - x1; i >= 0; i--) {
-			int x = FLOOR_FIXEDPOINT16(p_x);
-			int y = FLOOR_FIXEDPOINT16(p_y);
-			int x_frac = p_x - FIXEDPOINT16(x);
-			int y_frac = p_y - FIXEDPOINT16(y);
-			uint8_t *src1 = (uint8_t *)src + y * src_pitch + x * src_bytes_per_pixel;
-			uint8_t *src2 = src1 + src_bytes_per_pixel;
-			uint8_t *src3 = src1 + src_pitch;
-			uint8_t *src4 = src2 + src_pitch;
-
-			uint32_t color = bilinear_argb8888_fast_m8(*(uint32_t*)src1,
-					*(uint32_t*)src2, *(uint32_t*)src3, *(uint32_t*)src4,
-					x_frac >> 8, y_frac >> 8, 8);
-
-			*tmp_dst = blend_argb8888_over_rgb565(*tmp_dst, color);
-
-			p_x += cfg->src_coord_dx_ax;
-			p_y += cfg->src_coord_dy_ax;
-			tmp_dst += 1;
-		}
+		_rotate_argb8888_over_rgb565_row(tmp_dst, src, src_pitch, p_x, p_y,
+				cfg->src_coord_dx_ax, cfg->src_coord_dy_ax, x2 - x1 + 1);
 
 next_line:
 		src_coord_x += cfg->src_coord_dx_ay;
@@ -306,7 +416,6 @@ void sw_rotate_argb8888_over_argb8888(void *dst, const void *src,
 #else
 	uint32_t * dst32 = dst;
 	uint16_t src_pitch = src_w * 4;
-	uint16_t src_bytes_per_pixel = 4;
 	int32_t src_coord_x = cfg->src_coord_x0 +
 			y * cfg->src_coord_dx_ay + x * cfg->src_coord_dx_ax;
 	int32_t src_coord_y = cfg->src_coord_y0 +
@@ -328,26 +437,8 @@ void sw_rotate_argb8888_over_argb8888(void *dst, const void *src,
 			tmp_dst += x1;
 		}
 
-		for (int i = x2 - x1; i >= 0; i--) {
-			int x = FLOOR_FIXEDPOINT16(p_x);
-			int y = FLOOR_FIXEDPOINT16(p_y);
-			int x_frac = p_x - FIXEDPOINT16(x);
-			int y_frac = p_y - FIXEDPOINT16(y);
-			uint8_t *src1 = (uint8_t *)src + y * src_pitch + x * src_bytes_per_pixel;
-			uint8_t *src2 = src1 + src_bytes_per_pixel;
-			uint8_t *src3 = src1 + src_pitch;
-			uint8_t *src4 = src2 + src_pitch;
-
-			uint32_t color = bilinear_argb8888_fast_m8(*(uint32_t*)src1,
-					*(uint32_t*)src2, *(uint32_t*)src3, *(uint32_t*)src4,
-					x_frac >> 8, y_frac >> 8, 8);
-
-			*tmp_dst = blend_argb8888_over_argb8888(*tmp_dst, color);
-
-			p_x += cfg->src_coord_dx_ax;
-			p_y += cfg->src_coord_dy_ax;
-			tmp_dst += 1;
-		}
+		_rotate_argb8888_over_argb8888_row(tmp_dst, src, src_pitch, p_x, p_y,
+				cfg->src_coord_dx_ax, cfg->src_coord_dy_ax, x2 - x1 + 1);
 
 next_line:
 		src_coord_x += cfg->src_coord_dx_ay;
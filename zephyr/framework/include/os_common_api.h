@@ -48,6 +48,7 @@ LOG_MODULE_DECLARE(os, LOG_LEVEL_INF);
 
 typedef struct k_mutex 			os_mutex;
 typedef struct k_sem 			os_sem;
+typedef struct k_condvar 		os_condvar;
 typedef struct k_timer  		os_timer;
 typedef struct k_delayed_work 	os_delayed_work;
 typedef struct k_work 			os_work;
@@ -228,6 +229,42 @@ int os_sem_take(os_sem *sem, s32_t timeout);
  * @} end defgroup os_sem_apis
  */
 
+/**
+ * @defgroup os_condvar_apis Os Condition Variable APIs
+ * @ingroup os_common_apis
+ * @{
+ */
+#define os_condvar_init(condvar) k_condvar_init(condvar)
+
+/**
+ * @brief Wait for a condition variable.
+ *
+ * This routine atomically releases @a mutex and waits for @a condvar to be
+ * signaled, @a mutex is locked again before it returns.
+ *
+ * @param condvar Address of the condition variable.
+ * @param mutex Address of the mutex locked by the calling thread.
+ * @param timeout Waiting period (in milliseconds), or one of the special
+ *                values OS_NO_WAIT and OS_FOREVER.
+ *
+ * @retval 0 On success.
+ * @retval -EAGAIN Waiting period timed out.
+ */
+int os_condvar_wait(os_condvar *condvar, os_mutex *mutex, s32_t timeout);
+
+/**
+ * @brief Wake one thread waiting on a condition variable.
+ */
+#define os_condvar_signal(condvar) k_condvar_signal(condvar)
+
+/**
+ * @brief Wake all threads waiting on a condition variable.
+ */
+#define os_condvar_broadcast(condvar) k_condvar_broadcast(condvar)
+/**
+ * @} end defgroup os_condvar_apis
+ */
+
 /**
  * @defgroup os_threads_apis Threads APIs
  * @ingroup os_common_apis
@@ -1471,7 +1508,30 @@ void msg_pool_dump(void(*dump_fn)(os_tid_t sender, os_tid_t receiver,
 		const char *content, int max_size));
 int os_send_sync_msg(void *receiver, void *msg, int msg_size);
 int os_send_async_msg(void *receiver, void *msg, int msg_size);
+
+/** message is queued ahead of normal messages of the receiver */
+#define OS_MSG_URGENT	BIT(0)
+
+/**
+ * @brief send async message with options
+ *
+ * Thread context only, like os_send_async_msg: sending from an ISR is
+ * asserted against, ISRs hand their events to a work item which sends
+ * the message.
+ *
+ * @param receiver receiver thread, or OS_ANY
+ * @param msg message to send
+ * @param msg_size size of message
+ * @param flags OS_MSG_URGENT or 0
+ * @param key coalesce key, if not 0 a pending message with the same key
+ *            in the same lane of the receiver is replaced by msg
+ *
+ * @return 0 on success, negative errno code on fail
+ */
+int os_send_async_msg_ext(void *receiver, void *msg, int msg_size,
+		uint32_t flags, uint16_t key);
 int os_receive_msg(void *msg, int msg_size,int timeout);
+int os_get_target_pending_msg_cnt(os_tid_t receiver);
 void os_msg_clean(void);
 void os_msg_init(void);
 
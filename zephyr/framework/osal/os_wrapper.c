@@ -32,6 +32,8 @@ struct thread_terminal_info_t{
 
 static struct thread_terminal_info_t thread_terminal_info[MAX_THREAD_TERMINAL_NUM] = {0};
 
+static void msg_queue_release(os_tid_t owner);
+
 /**thread function */
 int os_thread_create(char *stack, size_t stack_size,
 					 void (*entry)(void *, void *, void*),
@@ -105,6 +107,8 @@ int os_thread_wait_terminal(int tid)
 	if (k_thread_join(terminal_info->wait_terminal_thread, SYS_TIMEOUT_MS(5000))) {
 		SYS_LOG_ERR("timeout \n");
 		ret = -EBUSY;
+	} else {
+		msg_queue_release((os_tid_t)terminal_info->wait_terminal_thread);
 	}
 
 	os_sched_lock();
@@ -138,25 +142,67 @@ const char *os_thread_get_name_by_prio(int prio)
 
 /**message function*/
 
-K_MBOX_DEFINE(global_mailbox);
-
 /** message pool */
 struct msg_info
 {
-	os_sem msg_sem;
+	/* next in free list or receiver queue */
+	struct msg_info *next;
 #ifdef CONFIG_MESSAGE_DEBUG
 	os_tid_t sender;
-	os_tid_t receiver;
 #endif
+	os_tid_t receiver;
+	/* coalesce key, 0 if never replaced by a newer message */
+	uint16_t key;
+	uint8_t busy;
+	uint8_t size;
 	char msg[MSG_MEM_SIZE];
 };
 
 struct msg_pool
 {
 	int pool_size;
+	int free_num;
+	/* sends failed since no free message */
+	uint32_t drop_cnt;
+	struct msg_info *free_list;
 	struct msg_info *pool;
 };
 
+/* lane 0 carries OS_MSG_URGENT messages and is always received first */
+#define MSG_LANE_NUM 2
+
+struct msg_lane
+{
+	struct msg_info *head;
+	struct msg_info *tail;
+};
+
+/*
+ * message queue of one receiver thread
+ *
+ * Queues and pool are guarded by short irq_lock sections, the cheapest
+ * lock on the single core target. This does not make sending from ISRs
+ * safe: senders are threads, os_send_async_msg_ext asserts it.
+ */
+struct msg_queue
+{
+	os_tid_t owner;
+	struct msg_lane lane[MSG_LANE_NUM];
+	uint16_t count;
+	/* high-water mark of count */
+	uint16_t max_count;
+	/* sends failed since queue full */
+	uint32_t full_cnt;
+	/* older messages replaced by a newer one */
+	uint32_t coalesce_cnt;
+	/* receiver blocked with the queue empty */
+	uint8_t waiting;
+	/* receiver in os_receive_msg, the queue can not be freed */
+	uint8_t receiving;
+	/* given once per queued message */
+	os_sem sem;
+};
+
 static struct msg_info msg_pool_buff[CONFIG_NUM_MBOX_ASYNC_MSGS];
 
 static struct msg_pool globle_msg_pool= {
@@ -164,44 +210,237 @@ static struct msg_pool globle_msg_pool= {
 	.pool = (struct msg_info *)&msg_pool_buff,
 };
 
-static struct msg_info *msg_pool_get_free_msg_info(void)
+static struct msg_queue msg_queues[CONFIG_OS_MSG_QUEUE_NUM];
+
+/* messages sent to OS_ANY which no receiver was waiting for */
+static struct msg_queue msg_any_queue;
+
+/* messages sent to threads which have no queue, claimed on their next receive */
+static struct msg_queue msg_unclaimed_queue;
+
+/*
+ * The last CONFIG_OS_MSG_URGENT_RESERVE free messages are kept for urgent
+ * messages, so a flood of normal messages can not block them.
+ * Call with irq locked.
+ */
+static struct msg_info *msg_pool_get_free_msg_info(bool urgent)
 {
 	struct msg_pool *pool = &globle_msg_pool;
-	struct msg_info *result = NULL;
+	struct msg_info *result = pool->free_list;
 
-	for (uint8_t i = 0 ; i < pool->pool_size; i++) {
-		struct msg_info * msg_content = &pool->pool[i];
-		if (k_sem_take(&msg_content->msg_sem, SYS_TIMEOUT_MS(OS_NO_WAIT)) == 0) {
-			memset(&msg_content->msg, 0, MSG_MEM_SIZE);
-			result = msg_content;
-			break;
-		} else 	{
-			//SYS_LOG_WRN("msg %d is busy\n", i);
-		}
+	if (!urgent && pool->free_num <= CONFIG_OS_MSG_URGENT_RESERVE) {
+		result = NULL;
+	}
+
+	if (result) {
+		pool->free_list = result->next;
+		pool->free_num--;
+		result->busy = 1;
 	}
 
 	return result;
 }
 
-int msg_pool_get_free_msg_num(void)
+/* call with irq locked */
+static void msg_pool_put_msg_info(struct msg_info *msg_content)
 {
 	struct msg_pool *pool = &globle_msg_pool;
-	int used_num = 0;
-	unsigned int key = irq_lock();
 
-	for (uint8_t i = 0 ; i < pool->pool_size; i++) {
-		struct msg_info * msg_content = &pool->pool[i];
+	msg_content->busy = 0;
+	msg_content->next = pool->free_list;
+	pool->free_list = msg_content;
+	pool->free_num++;
+}
+
+/* call with irq locked */
+static void msg_lane_push(struct msg_lane *lane, struct msg_info *msg_content)
+{
+	msg_content->next = NULL;
+	if (lane->tail) {
+		lane->tail->next = msg_content;
+	} else {
+		lane->head = msg_content;
+	}
+	lane->tail = msg_content;
+}
+
+/* unlink msg_content which follows prev, call with irq locked */
+static void msg_lane_unlink(struct msg_lane *lane, struct msg_info *prev,
+		struct msg_info *msg_content)
+{
+	if (prev) {
+		prev->next = msg_content->next;
+	} else {
+		lane->head = msg_content->next;
+	}
+
+	if (lane->tail == msg_content) {
+		lane->tail = prev;
+	}
+}
+
+/* call with irq locked */
+static void msg_queue_push(struct msg_queue *queue, struct msg_info *msg_content, int lane)
+{
+	msg_lane_push(&queue->lane[lane], msg_content);
+
+	if (++queue->count > queue->max_count) {
+		queue->max_count = queue->count;
+	}
+}
 
-		if (os_sem_take(&msg_content->msg_sem, OS_NO_WAIT) != 0) {
-			used_num++;
-		} else {
-			os_sem_give(&msg_content->msg_sem);
+/*
+ * Move the unclaimed messages of owner to queue in order, or back to the
+ * pool if queue is NULL. Call with irq locked.
+ */
+static void msg_queue_claim(struct msg_queue *queue, os_tid_t owner)
+{
+	for (int i = 0; i < MSG_LANE_NUM; i++) {
+		struct msg_lane *lane = &msg_unclaimed_queue.lane[i];
+		struct msg_info *prev = NULL;
+		struct msg_info *msg_content = lane->head;
+		struct msg_info *next;
+
+		for (; msg_content; msg_content = next) {
+			next = msg_content->next;
+			if (msg_content->receiver != owner) {
+				prev = msg_content;
+				continue;
+			}
+
+			msg_lane_unlink(lane, prev, msg_content);
+			msg_unclaimed_queue.count--;
+
+			if (queue) {
+				msg_queue_push(queue, msg_content, i);
+				os_sem_give(&queue->sem);
+			} else {
+				msg_pool_put_msg_info(msg_content);
+			}
 		}
 	}
+}
 
-	irq_unlock(key);
+/*
+ * Find the queue of receiver, slots are hashed by thread address and
+ * probed linearly. Freed slots leave holes, so all slots are probed.
+ * A new queue takes a free slot, or else the slot of a thread which has
+ * no pending message and is not receiving, that thread gets a queue again
+ * on its next receive. Call with irq locked.
+ */
+static struct msg_queue *msg_queue_find(os_tid_t receiver, bool create)
+{
+	uint32_t idx = ((uintptr_t)receiver >> 3) % CONFIG_OS_MSG_QUEUE_NUM;
+	struct msg_queue *free_queue = NULL;
+	struct msg_queue *idle_queue = NULL;
+
+	for (int i = 0; i < CONFIG_OS_MSG_QUEUE_NUM; i++) {
+		struct msg_queue *queue = &msg_queues[idx];
+
+		if (queue->owner == receiver) {
+			return queue;
+		}
+
+		if (queue->owner == NULL) {
+			if (!free_queue) {
+				free_queue = queue;
+			}
+		} else if (!idle_queue && !queue->count && !queue->receiving) {
+			idle_queue = queue;
+		}
+
+		if (++idx >= CONFIG_OS_MSG_QUEUE_NUM) {
+			idx = 0;
+		}
+	}
+
+	if (!create) {
+		return NULL;
+	}
+
+	if (!free_queue) {
+		free_queue = idle_queue;
+	}
+
+	if (free_queue) {
+		free_queue->owner = receiver;
+		free_queue->max_count = 0;
+		free_queue->full_cnt = 0;
+		free_queue->coalesce_cnt = 0;
+		free_queue->waiting = 0;
+		os_sem_reset(&free_queue->sem);
+		msg_queue_claim(free_queue, receiver);
+	}
+
+	return free_queue;
+}
+
+/* unlink the message of receiver with key from lane, call with irq locked */
+static struct msg_info *msg_lane_remove(struct msg_lane *lane, os_tid_t receiver, uint16_t key)
+{
+	struct msg_info *prev = NULL;
+	struct msg_info *msg_content;
+
+	for (msg_content = lane->head; msg_content; msg_content = msg_content->next) {
+		if (msg_content->key == key && msg_content->receiver == receiver) {
+			msg_lane_unlink(lane, prev, msg_content);
+			break;
+		}
+
+		prev = msg_content;
+	}
+
+	return msg_content;
+}
+
+/* urgent lane first, call with irq locked */
+static struct msg_info *msg_queue_pop(struct msg_queue *queue)
+{
+	for (int i = 0; i < MSG_LANE_NUM; i++) {
+		struct msg_lane *lane = &queue->lane[i];
+		struct msg_info *msg_content = lane->head;
+
+		if (msg_content) {
+			lane->head = msg_content->next;
+			if (!lane->head) {
+				lane->tail = NULL;
+			}
+			queue->count--;
+			return msg_content;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Replace the pending message with the same key by msg, the message is
+ * moved to the tail of the lane so the receiver sees the newest state
+ * after all messages sent before it. Call with irq locked.
+ */
+static bool msg_queue_coalesce(struct msg_queue *queue, int lane,
+		os_tid_t receiver, uint16_t key, void *msg, int msg_size)
+{
+	struct msg_info *msg_content = msg_lane_remove(&queue->lane[lane], receiver, key);
+
+	if (!msg_content) {
+		return false;
+	}
 
-	return pool->pool_size - used_num;
+	memcpy(&msg_content->msg, msg, msg_size);
+	msg_content->size = msg_size;
+#ifdef CONFIG_MESSAGE_DEBUG
+	msg_content->sender = os_current_get();
+#endif
+	msg_lane_push(&queue->lane[lane], msg_content);
+	queue->coalesce_cnt++;
+
+	return true;
+}
+
+int msg_pool_get_free_msg_num(void)
+{
+	return globle_msg_pool.free_num;
 }
 
 void msg_pool_dump(void(*dump_fn)(os_tid_t sender, os_tid_t receiver,
@@ -209,20 +448,35 @@ void msg_pool_dump(void(*dump_fn)(os_tid_t sender, os_tid_t receiver,
 {
 	struct msg_pool *pool = &globle_msg_pool;
 
-	printk("free msg cnt %d/%d\n", msg_pool_get_free_msg_num(), pool->pool_size);
+	printk("free msg cnt %d/%d, drop %u\n", msg_pool_get_free_msg_num(),
+			pool->pool_size, pool->drop_cnt);
+
+	for (uint8_t i = 0 ; i < CONFIG_OS_MSG_QUEUE_NUM; i++) {
+		struct msg_queue *queue = &msg_queues[i];
+
+		if (queue->owner) {
+			printk("queue %p: pending %d, max %d, full %u, coalesce %u\n",
+					queue->owner, queue->count, queue->max_count,
+					queue->full_cnt, queue->coalesce_cnt);
+		}
+	}
+
+	printk("queue any: pending %d, max %d, coalesce %u\n", msg_any_queue.count,
+			msg_any_queue.max_count, msg_any_queue.coalesce_cnt);
+	printk("queue unclaimed: pending %d, max %d, full %u, coalesce %u\n",
+			msg_unclaimed_queue.count, msg_unclaimed_queue.max_count,
+			msg_unclaimed_queue.full_cnt, msg_unclaimed_queue.coalesce_cnt);
 
 	for (uint8_t i = 0 ; i < pool->pool_size; i++) {
 		struct msg_info * msg_content = &pool->pool[i];
 
-		if (os_sem_take(&msg_content->msg_sem, OS_NO_WAIT) != 0) {
+		if (msg_content->busy) {
 			printk("busy msg %d:\n", i);
 #ifdef CONFIG_MESSAGE_DEBUG
 			dump_fn(msg_content->sender, msg_content->receiver, msg_content->msg, MSG_MEM_SIZE);
 #else
-			dump_fn(OS_ANY, OS_ANY, msg_content->msg, MSG_MEM_SIZE);
+			dump_fn(OS_ANY, msg_content->receiver, msg_content->msg, MSG_MEM_SIZE);
 #endif
-		} else {
-			os_sem_give(&msg_content->msg_sem);
 		}
 	}
 }
@@ -282,84 +536,250 @@ int os_send_sync_msg(void *receiver, void *msg, int msg_size)
 
 int os_send_async_msg(void *receiver, void *msg, int msg_size)
 {
-	os_mbox_msg send_msg;
+	return os_send_async_msg_ext(receiver, msg, msg_size, 0, 0);
+}
+
+int os_send_async_msg_ext(void *receiver, void *msg, int msg_size,
+		uint32_t flags, uint16_t key)
+{
 	struct msg_info *msg_content;
+	struct msg_queue *queue = NULL;
+	struct msg_queue *target;
+	bool urgent = (flags & OS_MSG_URGENT) != 0;
+	int lane = urgent ? 0 : 1;
+	unsigned int key_irq;
 
 	__ASSERT(!k_is_in_isr(),"send messag in isr");
 
-	msg_content = msg_pool_get_free_msg_info();
+	if (msg_size > MSG_MEM_SIZE) {
+		return -EMSGSIZE;
+	}
+
+	key_irq = irq_lock();
+
+	if (receiver == OS_ANY) {
+		/* hand over to a blocked receiver, or keep for the next one */
+		for (int i = 0; i < CONFIG_OS_MSG_QUEUE_NUM; i++) {
+			if (msg_queues[i].owner && msg_queues[i].waiting) {
+				queue = &msg_queues[i];
+				break;
+			}
+		}
+
+		target = queue ? queue : &msg_any_queue;
+	} else {
+		/* only receivers create queues, the receiver claims the rest */
+		queue = msg_queue_find(receiver, false);
+		target = queue ? queue : &msg_unclaimed_queue;
+	}
+
+	/* a replaced message needs no new slot and no wakeup */
+	if (key && msg_queue_coalesce(target, lane, receiver, key, msg, msg_size)) {
+		irq_unlock(key_irq);
+		return 0;
+	}
+
+	if (target != &msg_any_queue && !urgent &&
+			target->count >= CONFIG_OS_MSG_QUEUE_DEPTH) {
+		target->full_cnt++;
+		irq_unlock(key_irq);
+		SYS_LOG_ERR("msg queue of %p full", receiver);
+		return -EBUSY;
+	}
+
+	msg_content = msg_pool_get_free_msg_info(urgent);
 	if (!msg_content) {
+		globle_msg_pool.drop_cnt++;
+		irq_unlock(key_irq);
 		SYS_LOG_ERR("msg_content is NULL ... ");
 		return -ENOMEM;
 	}
 
 	memcpy(&msg_content->msg, msg, msg_size);
-#ifdef CONFIG_MESSAGE_DEBUG
+	msg_content->size = msg_size;
+	msg_content->key = key;
 	msg_content->receiver = (os_tid_t)receiver;
+#ifdef CONFIG_MESSAGE_DEBUG
 	msg_content->sender = os_current_get();
 #endif
-	/* prepare to send message */
-	send_msg.info = msg_size;
-	send_msg.size = msg_size;
-	send_msg.tx_data = &msg_content->msg;
-	send_msg.tx_target_thread = (os_tid_t)receiver;
 
-	/* send message containing most current data and loop around */
-	os_mbox_async_put(&global_mailbox, &send_msg, &msg_content->msg_sem);
+	msg_queue_push(target, msg_content, lane);
+	if (queue) {
+		queue->waiting = 0;
+		os_sem_give(&queue->sem);
+	}
+
+	irq_unlock(key_irq);
 
 	return 0;
 }
 
 int os_receive_msg(void *msg, int msg_size,int timeout)
 {
-	os_mbox_msg recv_msg;
-    char buffer[MSG_MEM_SIZE];
+	struct msg_info *msg_content;
+	struct msg_queue *queue;
+	unsigned int key;
+	int res = 0;
+
+	key = irq_lock();
 
-	memset(buffer, 0, msg_size);
+	queue = msg_queue_find(os_current_get(), true);
+	if (!queue) {
+		irq_unlock(key);
+		SYS_LOG_ERR("no msg queue for %p", os_current_get());
+		return -ENOMEM;
+	}
+
+	queue->receiving = 1;
+
+	for (;;) {
+		/* the sem counts the queued messages */
+		if (queue->count) {
+			os_sem_take(&queue->sem, OS_NO_WAIT);
+			msg_content = msg_queue_pop(queue);
+			break;
+		}
 
-	/* prepare to receive message */
-	recv_msg.info =  msg_size;
-	recv_msg.size =  msg_size;
-	recv_msg.rx_source_thread = OS_ANY;
+		msg_content = msg_queue_pop(&msg_any_queue);
+		if (msg_content) {
+			break;
+		}
+
+		queue->waiting = 1;
+		irq_unlock(key);
+
+		if (os_sem_take(&queue->sem, timeout)) {
+			key = irq_lock();
+			queue->waiting = 0;
+			if (!queue->count) {
+				queue->receiving = 0;
+				irq_unlock(key);
+				//SYS_LOG_INF("no message");
+				return -ETIMEDOUT;
+			}
+			/* message queued just after timeout */
+			continue;
+		}
 
-    /* get a data item, waiting as long as needed */
-	if (os_mbox_get(&global_mailbox, &recv_msg, buffer, SYS_TIMEOUT_MS(timeout))) {
-		//SYS_LOG_INF("no message");
-		return -ETIMEDOUT;
+		key = irq_lock();
+		queue->waiting = 0;
+		msg_content = msg_queue_pop(queue);
+		if (msg_content) {
+			break;
+		}
+		/* dropped by os_msg_clean(), wait again */
 	}
 
+	queue->receiving = 0;
+	irq_unlock(key);
+
 	/* verify that message data was fully received */
-	if (recv_msg.info != recv_msg.size) {
+	if (msg_content->size != msg_size) {
 	    SYS_LOG_ERR("some message data dropped during transfer! \n ");
 	    SYS_LOG_ERR("sender tried to send %d bytes"
-					"only received %zu bytes receiver %p \n",
-					recv_msg.info ,recv_msg.size,os_current_get());
-	    return -EMSGSIZE;
+					"only received %d bytes receiver %p \n",
+					msg_content->size, msg_size, os_current_get());
+	    res = -EMSGSIZE;
+	} else {
+		/* copy msg directly to receiver */
+		memcpy(msg, msg_content->msg, msg_size);
 	}
 
-	/* copy msg from recvied buffer */
-	memcpy(msg, buffer, msg_size);
+	key = irq_lock();
+	msg_pool_put_msg_info(msg_content);
+	irq_unlock(key);
 
-	return 0;
+	return res;
 }
 
 void os_msg_clean(void)
 {
-	os_mbox_clear_msg(&global_mailbox);
+	struct msg_info *msg_content;
+	unsigned int key = irq_lock();
+
+	for (int i = 0; i < CONFIG_OS_MSG_QUEUE_NUM; i++) {
+		while ((msg_content = msg_queue_pop(&msg_queues[i])) != NULL) {
+			msg_pool_put_msg_info(msg_content);
+		}
+
+		os_sem_reset(&msg_queues[i].sem);
+	}
+
+	while ((msg_content = msg_queue_pop(&msg_any_queue)) != NULL) {
+		msg_pool_put_msg_info(msg_content);
+	}
+
+	while ((msg_content = msg_queue_pop(&msg_unclaimed_queue)) != NULL) {
+		msg_pool_put_msg_info(msg_content);
+	}
+
+	irq_unlock(key);
+}
+
+/* free the queue of a terminated thread, its pending messages are dropped */
+static void msg_queue_release(os_tid_t owner)
+{
+	struct msg_info *msg_content;
+	struct msg_queue *queue;
+	unsigned int key = irq_lock();
+
+	queue = msg_queue_find(owner, false);
+	if (queue) {
+		while ((msg_content = msg_queue_pop(queue)) != NULL) {
+			msg_pool_put_msg_info(msg_content);
+		}
+
+		queue->owner = NULL;
+	}
+
+	msg_queue_claim(NULL, owner);
+
+	irq_unlock(key);
 }
 
 int os_get_pending_msg_cnt(void)
 {
-	return k_mbox_get_pending_msg_cnt(&global_mailbox, os_current_get());
+	return os_get_target_pending_msg_cnt(os_current_get());
+}
+
+int os_get_target_pending_msg_cnt(os_tid_t receiver)
+{
+	struct msg_queue *queue;
+	int result = 0;
+	unsigned int key = irq_lock();
+
+	queue = msg_queue_find(receiver, false);
+	if (queue) {
+		result = queue->count;
+	} else {
+		for (int i = 0; i < MSG_LANE_NUM; i++) {
+			struct msg_info *msg_content = msg_unclaimed_queue.lane[i].head;
+
+			for (; msg_content; msg_content = msg_content->next) {
+				if (msg_content->receiver == receiver) {
+					result++;
+				}
+			}
+		}
+	}
+
+	irq_unlock(key);
+	return result;
 }
 
 void os_msg_init(void)
 {
 	struct msg_pool *pool = &globle_msg_pool;
 
-	for (uint8_t i = 0 ; i < pool->pool_size; i++) {
-		struct msg_info *msg_content = &pool->pool[i];
-		os_sem_init(&msg_content->msg_sem, 1, 1);
+	pool->free_list = NULL;
+	pool->free_num = 0;
+
+	for (int i = pool->pool_size - 1; i >= 0; i--) {
+		msg_pool_put_msg_info(&pool->pool[i]);
+	}
+
+	for (int i = 0; i < CONFIG_OS_MSG_QUEUE_NUM; i++) {
+		os_sem_init(&msg_queues[i].sem, 0, CONFIG_OS_MSG_QUEUE_DEPTH);
 	}
 }
 
@@ -394,6 +814,11 @@ int os_mutex_lock(os_mutex * mutex, s32_t timeout)
 	return k_mutex_lock(mutex, SYS_TIMEOUT_MS(timeout));
 }
 
+int os_condvar_wait(os_condvar *condvar, os_mutex *mutex, s32_t timeout)
+{
+	return k_condvar_wait(condvar, mutex, SYS_TIMEOUT_MS(timeout));
+}
+
 int os_delayed_work_submit(os_delayed_work *work, s32_t delay)
 {
 	return k_delayed_work_submit(work, SYS_TIMEOUT_MS(delay));
@@ -330,6 +330,16 @@ typedef int (*dsp_api_release_mem)(struct device *dev, int type);
  */
 typedef int (*dsp_message_handler)(struct dsp_message *msg);
 
+/**
+ * @typedef dsp_message_callback
+ * @brief Callback of async message completion
+ *
+ * @param msg      message with result filled.
+ * @param res      0 if acked by dsp, negative errno code if failure.
+ * @param user_data user data passed to dsp_send_message_async().
+ */
+typedef void (*dsp_message_callback)(struct dsp_message *msg, int res, void *user_data);
+
 /**
  * @typedef dsp_api_register_message_handler
  * @brief Callback API for registering message handler
@@ -348,6 +358,13 @@ typedef int (*dsp_api_unregister_message_handler)(struct device *dev);
  */
 typedef int (*dsp_api_send_message)(struct device *dev, struct dsp_message *msg);
 
+/**
+ * @typedef dsp_api_send_message_async
+ * @brief Callback API for queueing message
+ */
+typedef int (*dsp_api_send_message_async)(struct device *dev, struct dsp_message *msg,
+		dsp_message_callback callback, void *user_data);
+
 /**
  * @typedef dsp_acts_request_userinfo
  * @brief Callback API for requesting user interested information
@@ -367,6 +384,7 @@ struct dsp_driver_api {
 	dsp_api_request_mem request_mem;
 	dsp_api_release_mem release_mem;
 	dsp_api_send_message send_message;
+	dsp_api_send_message_async send_message_async;
 	dsp_acts_request_userinfo request_userinfo;
 };
 
@@ -554,10 +572,16 @@ static inline int dsp_unregister_message_handler(struct device *dev)
 /**
  * @brief send message to dsp
  *
+ * The message is queued behind the messages of dsp_send_message_async and
+ * the caller sleeps until it is acked. From an ISR or the system work
+ * queue the message is sent directly instead, which fails with -EBUSY
+ * while queued messages are pending.
+ *
  * @param dev     Pointer to the device structure for the driver instance.
  * @param msg    message to send
  *
  * @retval 0 if successful.
+ * @retval -EBUSY mailbox busy, or queued messages pending on a direct send.
  * @retval Negative errno code if failure.
  */
 static inline int dsp_send_message(struct device *dev, struct dsp_message *msg)
@@ -567,6 +591,31 @@ static inline int dsp_send_message(struct device *dev, struct dsp_message *msg)
 	return api->send_message(dev, msg);
 }
 
+/**
+ * @brief queue message to dsp without waiting for the ack
+ *
+ * Messages are posted to the dsp mailbox one by one in queued order,
+ * callback is called from the system work queue once the message is
+ * acked, failed or timed out. A DSP_MSG_KICK without callback is merged
+ * into an identical kick still waiting in the queue.
+ *
+ * @param dev       Pointer to the device structure for the driver instance.
+ * @param msg       message to send, copied into the queue
+ * @param callback  completion callback, may be NULL
+ * @param user_data user data passed to callback
+ *
+ * @retval sequence number of the queued message, >= 0.
+ * @retval -ENOSPC if the queue is full.
+ * @retval Negative errno code if other failure.
+ */
+static inline int dsp_send_message_async(struct device *dev, struct dsp_message *msg,
+		dsp_message_callback callback, void *user_data)
+{
+	const struct dsp_driver_api *api = dev->api;
+
+	return api->send_message_async(dev, msg, callback, user_data);
+}
+
 /**
  * @brief request user information writing by dsp
  *
@@ -24,6 +24,53 @@ int nvram_config_clear(int len);
 int nvram_config_clear_all(void);
 void nvram_config_dump(const struct shell *shell);
 
+/**
+ * @brief Start batched write of user configs
+ *
+ * Until the matching nvram_config_batch_commit(), nvram_config_set() of
+ * the calling thread only records configs in a RAM journal (last writer
+ * wins for the same name), and its nvram_config_get() returns the
+ * journaled value. Batches can be nested in the same thread, a batch of
+ * another thread waits until the open batch is committed. Configs set by
+ * other threads meanwhile are written immediately and replace the
+ * journaled ones. Without CONFIG_NVRAM_WRITE_JOURNAL configs are written
+ * immediately.
+ *
+ * @return 0 on success
+ */
+int nvram_config_batch_begin(void);
+
+/**
+ * @brief Program journaled configs to flash in one pass
+ *
+ * Only the outermost commit writes flash. Configs are persistent once
+ * this function returns 0.
+ *
+ * @return 0 on success
+ * @return -EPERM no batch opened by the calling thread
+ * @return other negative errno of the first config failed to write
+ */
+int nvram_config_batch_commit(void);
+
+/**
+ * @brief callback of user config set
+ *
+ * @param name name of the config set or deleted, NULL if all user
+ * configs are cleared
+ */
+typedef void (*nvram_config_set_cb_t)(const char *name);
+
+/**
+ * @brief Set the callback of user config set
+ *
+ * The callback is called after each successful nvram_config_set() and
+ * nvram_config_clear_all(), in the context of the caller and without
+ * nvram lock held, so that a cache of configs can drop its stale copy.
+ *
+ * @param cb callback, NULL to remove it
+ */
+void nvram_config_set_callback(nvram_config_set_cb_t cb);
+
 int nvram_config_get_factory(const char *name, void *data, int max_len);
 int nvram_config_set_factory(const char *name, const void *data, int len);
 
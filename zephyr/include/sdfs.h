@@ -40,6 +40,9 @@ struct sd_file
 	int readptr;
 	unsigned char storage_id;
 	unsigned char file_id;
+#ifdef CONFIG_SDFS_READ_ASYNC
+	void *async;
+#endif
 };
 
 struct sd_dir
@@ -89,6 +92,55 @@ void sd_fclose(struct sd_file *sd_file);
  */
 int sd_fread(struct sd_file *sd_file, void *buffer, int len);
 
+/**
+ * @brief Callback of asynchronous file read
+ *
+ * @param sd_file Pointer to the file object
+ * @param buffer Pointer to the data buffer
+ * @param len Number of bytes read, or negative errno code if error
+ * @param user_data User data passed to sd_fread_async
+ */
+typedef void (*sd_fread_cb_t)(struct sd_file *sd_file, void *buffer, int len, void *user_data);
+
+/**
+ * @brief Asynchronous file read
+ *
+ * Queues a read of len bytes at current file position, which is advanced
+ * immediately. The callback is called in the sdfs read thread when the
+ * data is ready. Only one request is in flight per file, a new request
+ * waits the previous one and its callback. The callback may queue the
+ * next read of the file, sd_fclose() waits until it returns. If
+ * asynchronous read is not supported by the storage (memory mapped or
+ * nand/sd), the data is read before return and the callback is called in
+ * caller context.
+ *
+ * @param sd_file Pointer to the file object
+ * @param buffer Pointer to the data buffer, valid until callback called
+ * @param len Number of bytes to be read
+ * @param cb Callback when read finished, may be NULL
+ * @param user_data User data passed to callback
+ *
+ * @return Number of bytes queued, 0 if end of file.
+ */
+int sd_fread_async(struct sd_file *sd_file, void *buffer, int len,
+		sd_fread_cb_t cb, void *user_data);
+
+/**
+ * @brief File read ahead hint
+ *
+ * Tells sdfs that the next len bytes at current file position will be
+ * read soon, so they can be loaded in background while the caller is
+ * busy, such as decoding the previous chunk. The following sd_fread
+ * is served from the read ahead buffer.
+ *
+ * @param sd_file Pointer to the file object
+ * @param len Number of bytes will be read
+ *
+ * @return Number of bytes to read ahead, 0 if not needed or not supported,
+ * or negative errno code if error.
+ */
+int sd_fread_hint(struct sd_file *sd_file, int len);
+
 /**
  * @brief Get current file position.
  *
@@ -154,4 +206,13 @@ int sd_fmap(const char *filename, void** addr, int *len);
  */
 void sdfs_available(unsigned char enable);
 
+/**
+ * @brief invalidate sdfs directory index
+ *
+ * Drop the cached directory index, which is rebuilt at the next lookup.
+ * Must be called after sdfs images in flash are rewritten, such as OTA,
+ * since a lookup during the rewrite may build the index from the old image.
+ */
+void sdfs_index_invalidate(void);
+
 #endif
\ No newline at end of file
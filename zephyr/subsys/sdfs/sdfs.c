@@ -1,6 +1,7 @@
 
 #include <zephyr/types.h>
 #include <strings.h>
+#include <ctype.h>
 #include <stddef.h>
 #include <sys/types.h>
 #include <device.h>
@@ -27,6 +28,37 @@ static uint32_t g_k_sdfs_system_addr;
 static const struct device *global_nor_dev;
 #endif
 
+#ifdef CONFIG_SDFS_READ_ASYNC
+struct sd_file_async
+{
+	struct k_work work;
+	struct k_sem done;
+	struct sd_file *sd_file;
+
+	/* request in flight */
+	uint32_t offset;
+	void *buffer;
+	int len;
+	sd_fread_cb_t cb;
+	void *user_data;
+
+	/* requests submitted and completed, the file is busy if they differ */
+	uint32_t seq;
+	uint32_t done_seq;
+	/* read thread while it calls the callback, which may queue next read */
+	k_tid_t cb_thread;
+
+	/* read ahead buffer, ra_len bytes from flash offset ra_offset are valid */
+	uint8_t *ra_buf;
+	int ra_size;
+	uint32_t ra_offset;
+	int ra_len;
+};
+
+static K_KERNEL_STACK_DEFINE(sd_read_stack, CONFIG_SDFS_READ_ASYNC_STACK_SIZE);
+static struct k_work_q sd_read_q;
+#endif
+
 #define SDFS_INVALID_PART_ID (0xFF)
 #define SDFS_INVALID_PART(x) ((x) == SDFS_INVALID_PART_ID)
 
@@ -65,13 +97,226 @@ void sd_free(struct sd_file * sd_file)
 //#define CONFIG_SD_FS_VADDR_START g_vaddr_start
 //static unsigned int g_vaddr_start = 0x0;
 
+#ifdef CONFIG_SDFS_INDEX
+/*
+ * Directory index of one sdfs image, a open addressing hash table of
+ * directory entry numbers keyed by the case folded file name. The entry
+ * is read back to compare the name only when the hash tag matches.
+ */
+struct sd_index_slot
+{
+	uint16_t tag;
+	uint16_t num;	/* entry number + 1, 0 means empty slot */
+};
+
+struct sd_index
+{
+	uint32_t base;
+	uint8_t part;
+	uint16_t mask;
+	struct sd_index_slot *slots;
+};
+
+/* entries read in a batch when building index */
+#define SD_INDEX_BUILD_BATCH	(8)
+
+static struct sd_index sd_index_tbl[CONFIG_SDFS_INDEX_MAX];
+static bool sd_index_valid;
+static K_MUTEX_DEFINE(sd_index_mutex);
+
+static uint32_t sd_name_hash(const char *name)
+{
+	uint32_t hash = 2166136261u;
+	int i;
+
+	/* same as strncasecmp(name, fname, 12) */
+	for (i = 0; i < 12 && name[i]; i++) {
+		hash ^= (uint8_t)tolower((unsigned char)name[i]);
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static int sd_index_read_dir(struct sd_index *index, int num, void *buf, int count)
+{
+	uint32_t addr = index->base + (num + 1) * sizeof(struct sd_dir);
+	int size = count * sizeof(struct sd_dir);
+
+#ifdef CONFIG_SDFS_NOR_NOT_XIP
+	if (!SDFS_INVALID_PART(index->part)) {
+		int ret = flash_read(global_nor_dev, addr, buf, size);
+		if (ret < 0) {
+			printk("nor read offset:0x%x size:%d error:%d\n", addr, size, ret);
+		}
+		return ret;
+	}
+#endif
+
+	memcpy_flash_data(buf, (void *)addr, size);
+	return 0;
+}
+
+static int sd_index_build(struct sd_index *index, uint32_t base, uint8_t part)
+{
+	struct sd_dir dirs[SD_INDEX_BUILD_BATCH];
+	struct sd_index_slot *slots;
+	uint32_t hash, pos;
+	int total, size, num, i, count;
+
+	index->base = base;
+	index->part = part;
+
+	if (sd_index_read_dir(index, -1, dirs, 1) < 0)
+		return -EIO;
+
+	if (memcmp(dirs[0].fname, "sdfs.bin", 8) != 0) {
+		printk("sdfs.bin invalid, offset=0x%x\n", base);
+		return -EINVAL;
+	}
+
+	total = dirs[0].offset;
+	if (total < 0 || total >= UINT16_MAX)
+		return -EINVAL;
+
+	/* keep load factor under 1/2 */
+	for (size = 8; size < total * 2; size <<= 1)
+		;
+
+	slots = k_malloc(size * sizeof(*slots));
+	if (!slots) {
+		printk("failed to malloc size:%d\n", size * sizeof(*slots));
+		return -ENOMEM;
+	}
+
+	memset(slots, 0, size * sizeof(*slots));
+
+	for (num = 0; num < total; num += count) {
+		count = MIN(total - num, SD_INDEX_BUILD_BATCH);
+		if (sd_index_read_dir(index, num, dirs, count) < 0) {
+			k_free(slots);
+			return -EIO;
+		}
+
+		for (i = 0; i < count; i++) {
+			hash = sd_name_hash((const char *)dirs[i].fname);
+			for (pos = hash & (size - 1); slots[pos].num; pos = (pos + 1) & (size - 1))
+				;
+
+			/* duplicated names are found in directory order as linear search */
+			slots[pos].tag = hash >> 16;
+			slots[pos].num = num + i + 1;
+		}
+	}
+
+	index->mask = size - 1;
+	index->slots = slots;
+	return 0;
+}
+
+static struct sd_index *sd_index_get(uint32_t base, uint8_t part)
+{
+	struct sd_index *index = NULL;
+	int i;
+
+	for (i = 0; i < CONFIG_SDFS_INDEX_MAX; i++) {
+		if (sd_index_tbl[i].slots && sd_index_tbl[i].base == base
+			&& sd_index_tbl[i].part == part) {
+			return &sd_index_tbl[i];
+		}
+
+		if (!index && !sd_index_tbl[i].slots)
+			index = &sd_index_tbl[i];
+	}
+
+	if (!index || sd_index_build(index, base, part))
+		return NULL;
+
+	sd_index_valid = true;
+	return index;
+}
+
+/*
+ * Find file by directory index.
+ *
+ * Return 0 if found, -ENOENT if not found, or other errors if the index
+ * cannot be used, then the caller should fall back to linear search.
+ */
+static int sd_index_find(const char *filename, void *buf_size_32, uint32_t base, uint8_t part)
+{
+	struct sd_dir *sd_dir = buf_size_32;
+	struct sd_index *index;
+	uint32_t hash, pos;
+	int ret = -ENOENT;
+
+	/* index is built lazily and protected by mutex, not usable before kernel */
+	if (k_is_pre_kernel())
+		return -EAGAIN;
+
+	k_mutex_lock(&sd_index_mutex, K_FOREVER);
+
+	index = sd_index_get(base, part);
+	if (!index) {
+		ret = -EAGAIN;
+		goto out;
+	}
+
+	hash = sd_name_hash(filename);
+	for (pos = hash & index->mask; index->slots[pos].num; pos = (pos + 1) & index->mask) {
+		if (index->slots[pos].tag != (uint16_t)(hash >> 16))
+			continue;
+
+		if (sd_index_read_dir(index, index->slots[pos].num - 1, sd_dir, 1) < 0) {
+			ret = -EIO;
+			break;
+		}
+
+		if (strncasecmp(filename, sd_dir->fname, 12) == 0) {
+			ret = 0;
+			break;
+		}
+	}
+
+out:
+	k_mutex_unlock(&sd_index_mutex);
+	return ret;
+}
+
+void sdfs_index_invalidate(void)
+{
+	int i;
+
+	if (!sd_index_valid || k_is_pre_kernel())
+		return;
+
+	k_mutex_lock(&sd_index_mutex, K_FOREVER);
+
+	for (i = 0; i < CONFIG_SDFS_INDEX_MAX; i++) {
+		if (sd_index_tbl[i].slots) {
+			k_free(sd_index_tbl[i].slots);
+			sd_index_tbl[i].slots = NULL;
+		}
+	}
 
+	sd_index_valid = false;
+	k_mutex_unlock(&sd_index_mutex);
+}
+#endif
 
 static struct sd_dir * sd_find_dir_by_addr(const char *filename, void *buf_size_32, uint32_t adfs_addr)
 {
 	int num, total, offset;
 	struct sd_dir *sd_dir = buf_size_32;
 
+#ifdef CONFIG_SDFS_INDEX
+	int ret = sd_index_find(filename, buf_size_32, adfs_addr, SDFS_INVALID_PART_ID);
+
+	if (ret == 0)
+		return sd_dir;
+	else if (ret == -ENOENT)
+		return NULL;
+#endif
+
 	memcpy_flash_data(buf_size_32, (void *)adfs_addr, sizeof(*sd_dir));
 
 	//printk("sd_dir->fname %s CONFIG_SD_FS_START 0x%x \n",sd_dir->fname,CONFIG_SD_FS_VADDR_START);
@@ -109,6 +354,17 @@ static struct sd_dir *sd_find_dir_by_part(const char *filename, void *buf_size_3
 	if (!part_entry)
 		return NULL;
 
+#ifdef CONFIG_SDFS_INDEX
+	ret = sd_index_find(filename, buf_size_32, part_entry->offset, part);
+	if (ret == 0) {
+		/* add partition offset */
+		sd_dir->offset += part_entry->offset;
+		return sd_dir;
+	} else if (ret == -ENOENT) {
+		return NULL;
+	}
+#endif
+
 	ret = flash_read(global_nor_dev, part_entry->offset, buf_size_32, sizeof(struct sd_dir));
 	if (ret < 0) {
 		printk("nor read offset:0x%x size:%d error:%d\n",
@@ -231,6 +487,152 @@ static const char *sd_get_part_type(const char *filename, uint8_t *stor_id, uint
 	return ret_ptr;
 }
 
+#ifdef CONFIG_SDFS_READ_ASYNC
+/* must be called with irq locked, the read thread may queue reads in callback */
+static bool _sd_file_busy_async(struct sd_file_async *async)
+{
+	return async->seq != async->done_seq && async->cb_thread != k_current_get();
+}
+
+static void sd_read_work_handler(struct k_work *work)
+{
+	struct sd_file_async *async = CONTAINER_OF(work, struct sd_file_async, work);
+	uint32_t seq = async->seq;
+	unsigned int key;
+	int ret;
+
+	ret = flash_read(global_nor_dev, async->offset, async->buffer, async->len);
+	if (ret < 0) {
+		printk("failed to read offset:0x%x size:%d\n", async->offset, async->len);
+	} else {
+		ret = async->len;
+	}
+
+	if (async->buffer == async->ra_buf)
+		async->ra_len = (ret > 0) ? ret : 0;
+
+	if (async->cb) {
+		async->cb_thread = k_current_get();
+		async->cb(async->sd_file, async->buffer, ret, async->user_data);
+		async->cb_thread = NULL;
+	}
+
+	/*
+	 * complete after the callback and touch nothing afterwards, the file
+	 * may be closed as soon as the waiter sees it. If the callback queued
+	 * the next read, the file stays busy until that one completes.
+	 */
+	key = irq_lock();
+	async->done_seq = seq;
+	k_sem_give(&async->done);
+	irq_unlock(key);
+}
+
+static struct sd_file_async *sd_file_get_async(struct sd_file *sd_file)
+{
+	struct sd_file_async *async = sd_file->async;
+
+	if (async)
+		return async;
+
+	async = k_malloc(sizeof(*async));
+	if (!async) {
+		printk("failed to malloc size:%d\n", sizeof(*async));
+		return NULL;
+	}
+
+	memset(async, 0, sizeof(*async));
+	k_work_init(&async->work, sd_read_work_handler);
+	k_sem_init(&async->done, 0, 1);
+	async->sd_file = sd_file;
+
+	sd_file->async = async;
+	return async;
+}
+
+/* gives of earlier requests may be left in done, so check again after take */
+static void sd_file_wait_async(struct sd_file_async *async)
+{
+	unsigned int key = irq_lock();
+
+	while (_sd_file_busy_async(async)) {
+		irq_unlock(key);
+		k_sem_take(&async->done, K_FOREVER);
+		key = irq_lock();
+	}
+
+	irq_unlock(key);
+}
+
+static bool sd_file_busy_async(struct sd_file_async *async)
+{
+	unsigned int key = irq_lock();
+	bool busy = _sd_file_busy_async(async);
+
+	irq_unlock(key);
+	return busy;
+}
+
+static void sd_file_submit_async(struct sd_file_async *async, uint32_t offset,
+				void *buffer, int len, sd_fread_cb_t cb, void *user_data)
+{
+	unsigned int key;
+
+	async->offset = offset;
+	async->buffer = buffer;
+	async->len = len;
+	async->cb = cb;
+	async->user_data = user_data;
+
+	key = irq_lock();
+	async->seq++;
+	irq_unlock(key);
+
+	k_work_submit_to_queue(&sd_read_q, &async->work);
+}
+
+static void sd_file_free_async(struct sd_file *sd_file)
+{
+	struct sd_file_async *async = sd_file->async;
+
+	if (!async)
+		return;
+
+	sd_file_wait_async(async);
+
+	if (async->ra_buf)
+		k_free(async->ra_buf);
+
+	k_free(async);
+	sd_file->async = NULL;
+}
+
+/* copy data at readptr from read ahead buffer, return bytes copied */
+static int sd_file_read_ahead_copy(struct sd_file *sd_file, void *buffer, int len)
+{
+	struct sd_file_async *async = sd_file->async;
+	uint32_t readptr = sd_file->readptr;
+	int offs;
+
+	if (!async || !async->ra_buf || readptr < async->ra_offset)
+		return 0;
+
+	/* wait read ahead in flight which covers readptr */
+	if (sd_file_busy_async(async) && async->buffer == async->ra_buf
+		&& readptr < async->ra_offset + async->len) {
+		sd_file_wait_async(async);
+	}
+
+	offs = readptr - async->ra_offset;
+	if (sd_file_busy_async(async) || offs >= async->ra_len)
+		return 0;
+
+	len = MIN(len, async->ra_len - offs);
+	memcpy(buffer, async->ra_buf + offs, len);
+	return len;
+}
+#endif
+
 struct sd_file * sd_fopen (const char *filename)
 {
 	struct sd_dir *sd_dir;
@@ -272,13 +674,45 @@ struct sd_file * sd_fopen (const char *filename)
 
 void sd_fclose(struct sd_file *sd_file)
 {
+#ifdef CONFIG_SDFS_READ_ASYNC
+	sd_file_free_async(sd_file);
+#endif
 	sd_free(sd_file);
 }
 
-int sd_fread(struct sd_file *sd_file, void *buffer, int len)
+static int sd_fread_nor(struct sd_file *sd_file, void *buffer, int len)
 {
-	unsigned int size_in_512, read_size;
+#ifdef CONFIG_SDFS_NOR_NOT_XIP
+	if (!SDFS_INVALID_PART(sd_file->file_id)) {
+#ifdef CONFIG_SDFS_READ_ASYNC
+		int copied = sd_file_read_ahead_copy(sd_file, buffer, len);
+
+		sd_file->readptr += copied;
+		buffer = (uint8_t *)buffer + copied;
+		len -= copied;
+		if (len == 0)
+			return 0;
+#endif
+
+		/* the flash driver splits into the largest transfers it allows */
+		if (flash_read(global_nor_dev, (uint32_t)sd_file->readptr, buffer, len) < 0) {
+			printk("failed to read offset:0x%x size:%d\n",
+					(uint32_t)sd_file->readptr, len);
+			return -EIO;
+		}
+
+		sd_file->readptr += len;
+		return 0;
+	}
+#endif
+
+	memcpy_flash_data(buffer, (void *)sd_file->readptr, len);
+	sd_file->readptr += len;
+	return 0;
+}
 
+int sd_fread(struct sd_file *sd_file, void *buffer, int len)
+{
 	if ((sd_file->readptr - sd_file->start + len) > sd_file->size)
 	{
 		len = sd_file->size - (sd_file->readptr - sd_file->start);
@@ -286,53 +720,101 @@ int sd_fread(struct sd_file *sd_file, void *buffer, int len)
 	if(len <= 0)
 		return 0;
 
-	read_size = len;
-
 	if(sd_file->storage_id != STORAGE_ID_NOR)
-		return nand_sd_sd_fread(sd_file->storage_id, sd_file, buffer, read_size);
+		return nand_sd_sd_fread(sd_file->storage_id, sd_file, buffer, len);
 
-	size_in_512 = 512 - (sd_file->readptr % 512);
-	size_in_512 = size_in_512 > len ? len : size_in_512;
-	if(size_in_512 > 0)
-	{
-#ifdef CONFIG_SDFS_NOR_NOT_XIP
-		if (SDFS_INVALID_PART(sd_file->file_id)) {
-			memcpy_flash_data(buffer, (void *)sd_file->readptr, size_in_512);
-		} else {
-			if (flash_read(global_nor_dev, (uint32_t)sd_file->readptr, buffer, size_in_512) < 0) {
-				printk("failed to read offset:0x%x size:%d\n",
-						(uint32_t)sd_file->readptr, size_in_512);
-				return 0;
-			}
-		}
-#else
-		memcpy_flash_data(buffer, (void *)sd_file->readptr, size_in_512);
+	if (sd_fread_nor(sd_file, buffer, len))
+		return 0;
+
+	return len;
+}
+
+int sd_fread_async(struct sd_file *sd_file, void *buffer, int len,
+		sd_fread_cb_t cb, void *user_data)
+{
+#ifdef CONFIG_SDFS_READ_ASYNC
+	struct sd_file_async *async;
+	uint32_t offset;
 #endif
 
-		buffer = (uint8_t *)buffer + size_in_512;
-		sd_file->readptr += size_in_512;
-		len -= size_in_512;
+	if ((sd_file->readptr - sd_file->start + len) > sd_file->size)
+	{
+		len = sd_file->size - (sd_file->readptr - sd_file->start);
 	}
+	if(len <= 0)
+		return 0;
 
-	for(; len > 0; buffer = (uint8_t *)buffer + size_in_512, sd_file->readptr += size_in_512, len -= size_in_512)
-	{
-		size_in_512 = len > 512 ? 512 : len;
-#ifdef CONFIG_SDFS_NOR_NOT_XIP
-		if (SDFS_INVALID_PART(sd_file->file_id)) {
-			memcpy_flash_data(buffer, (void *)sd_file->readptr, size_in_512);
-		} else {
-			if (flash_read(global_nor_dev, (uint32_t)sd_file->readptr, buffer, size_in_512) < 0) {
-				printk("failed to read offset:0x%x size:%d\n",
-						(uint32_t)sd_file->readptr, size_in_512);
-				return 0;
-			}
+#ifdef CONFIG_SDFS_READ_ASYNC
+	if (sd_file->storage_id == STORAGE_ID_NOR && !SDFS_INVALID_PART(sd_file->file_id)) {
+		async = sd_file_get_async(sd_file);
+		if (async) {
+			/* one request in flight per file */
+			sd_file_wait_async(async);
+
+			/* advance first, the callback may queue the next read */
+			offset = sd_file->readptr;
+			sd_file->readptr += len;
+			sd_file_submit_async(async, offset, buffer, len, cb, user_data);
+			return len;
 		}
-#else
-		memcpy_flash_data(buffer, (void *)sd_file->readptr, size_in_512);
+	}
 #endif
+
+	/* memory mapped or no async support, read in caller context */
+	len = sd_fread(sd_file, buffer, len);
+	if (cb)
+		cb(sd_file, buffer, len, user_data);
+
+	return len;
+}
+
+int sd_fread_hint(struct sd_file *sd_file, int len)
+{
+#ifdef CONFIG_SDFS_READ_ASYNC
+	struct sd_file_async *async;
+
+	if (sd_file->storage_id != STORAGE_ID_NOR || SDFS_INVALID_PART(sd_file->file_id))
+		return 0;
+
+	if ((sd_file->readptr - sd_file->start + len) > sd_file->size)
+	{
+		len = sd_file->size - (sd_file->readptr - sd_file->start);
 	}
+	len = MIN(len, CONFIG_SDFS_READ_AHEAD_MAX_SIZE);
+	if (len <= 0)
+		return 0;
 
-	return read_size;
+	async = sd_file_get_async(sd_file);
+	if (!async)
+		return -ENOMEM;
+
+	if (sd_file_busy_async(async))
+		return -EBUSY;
+
+	/* already in read ahead buffer */
+	if (async->ra_buf && sd_file->readptr >= async->ra_offset
+		&& sd_file->readptr + len <= async->ra_offset + async->ra_len)
+		return 0;
+
+	if (async->ra_size < len) {
+		if (async->ra_buf)
+			k_free(async->ra_buf);
+
+		async->ra_size = 0;
+		async->ra_buf = k_malloc(len);
+		if (!async->ra_buf)
+			return -ENOMEM;
+
+		async->ra_size = len;
+	}
+
+	async->ra_offset = sd_file->readptr;
+	async->ra_len = 0;
+	sd_file_submit_async(async, sd_file->readptr, async->ra_buf, len, NULL, NULL);
+	return len;
+#else
+	return 0;
+#endif
 }
 
 int sd_ftell(struct sd_file *sd_file)
@@ -473,6 +955,19 @@ static int sd_fs_init(const struct device *dev)
 /* CFG_DRV：depend on ksdfs, so define sdfs init proi:80, cfg_drv prio: 81, uart drv prio 82  */
 SYS_INIT(sd_fs_init, PRE_KERNEL_1, 80);
 
+#ifdef CONFIG_SDFS_READ_ASYNC
+static int sd_read_async_init(const struct device *dev)
+{
+	k_work_queue_start(&sd_read_q, sd_read_stack,
+			K_KERNEL_STACK_SIZEOF(sd_read_stack),
+			CONFIG_SDFS_READ_ASYNC_PRIORITY, NULL);
+	k_thread_name_set(&sd_read_q.thread, "sdfs_read");
+	return 0;
+}
+
+SYS_INIT(sd_read_async_init, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEFAULT);
+#endif
+
 
 #ifdef CONFIG_FILE_SYSTEM
 
@@ -0,0 +1,397 @@
+#!/usr/bin/env python3
+#
+# Build Actions SoC OTA delta image
+#
+# Copyright (c) 2019 Actions Semiconductor Co., Ltd
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+
+import os
+import sys
+import struct
+import argparse
+import subprocess
+import shutil
+import xml.etree.ElementTree as ET
+import zlib
+
+script_path = os.path.split(os.path.realpath(__file__))[0]
+
+# keep the same with framework/ota/include/ota_backend_delta.h
+OTA_DELTA_MAGIC = 0x544c4444
+OTA_DELTA_VERSION = 2
+OTA_DELTA_VERSION_NO_LZ4 = 1
+OTA_DELTA_HEAD_SIZE = 64
+OTA_DELTA_MAX_SRC = 4
+
+OTA_DELTA_OP_LIT = 1
+OTA_DELTA_OP_COPY = 2
+OTA_DELTA_OP_ADD = 3
+OTA_DELTA_OP_LZ4 = 4
+
+# old files are indexed by the key at each aligned offset
+DELTA_KEY_SIZE = 12
+DELTA_KEY_ALIGN = 4
+# shorter matches are cheaper as literal
+DELTA_MIN_MATCH = 16
+# zero runs shorter than this are kept in the diff of ADD op
+DELTA_MIN_ZERO_RUN = 4
+# shorter literal runs are not worth an LZ4 block
+DELTA_MIN_LZ4 = 32
+
+# LZ4 block format, matches start at least LZ4_MF_LIMIT bytes before the
+# end and the last LZ4_LAST_LITERALS bytes are literals
+LZ4_MIN_MATCH = 4
+LZ4_MF_LIMIT = 12
+LZ4_LAST_LITERALS = 5
+LZ4_MAX_OFFSET = 0xffff
+
+def run_cmd(cmd):
+    """Echo and run the given command.
+
+    Args:
+    cmd: the command represented as a list of strings.
+    Returns:
+    A tuple of the output and the exit code.
+    """
+#    print("Running: ", " ".join(cmd))
+    p = subprocess.Popen(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    output, _ = p.communicate()
+#    print("%s" % (output.rstrip()))
+    return (output, p.returncode)
+
+def panic(err_msg):
+    print('\033[1;31;40m')
+    print('FW: Error: %s\n' %err_msg)
+    print('\033[0m')
+    sys.exit(1)
+
+def extract_ota_bin(ota_image_file, out_dir):
+    script_ota_path = os.path.join(script_path, 'build_ota_image.py')
+
+    cmd = ['python3', script_ota_path,  '-i', ota_image_file,  '-x', out_dir]
+    (outmsg, exit_code) = run_cmd(cmd)
+    if exit_code !=0:
+        print('extract ota image error')
+        print(outmsg)
+        sys.exit(1)
+
+def get_ota_partitions(xml_file):
+    tree = ET.ElementTree(file=xml_file)
+    root = tree.getroot()
+    if (root.tag != 'ota_firmware'):
+        panic('invalid OTA xml file')
+
+    partitions = []
+    for part in root.find('partitions').findall('partition'):
+        part_prop = {}
+        for prop in part:
+            part_prop[prop.tag] = prop.text.strip()
+        partitions.append(part_prop)
+
+    return partitions
+
+def put_varint(out, value):
+    while value >= 0x80:
+        out.append((value & 0x7f) | 0x80)
+        value >>= 7
+    out.append(value)
+
+def zigzag(value):
+    return (value << 1) if value >= 0 else ((-value << 1) - 1)
+
+def lz4_put_len(out, value):
+    while value >= 255:
+        out.append(255)
+        value -= 255
+    out.append(value)
+
+def lz4_put_seq(out, lit, offs, match_len):
+    """put one sequence, the last one of a block has no match"""
+    lit_len = len(lit)
+    token = min(lit_len, 15) << 4
+    if match_len:
+        token |= min(match_len - LZ4_MIN_MATCH, 15)
+    out.append(token)
+    if lit_len >= 15:
+        lz4_put_len(out, lit_len - 15)
+    out += lit
+
+    if match_len:
+        out += struct.pack('<H', offs)
+        if match_len - LZ4_MIN_MATCH >= 15:
+            lz4_put_len(out, match_len - LZ4_MIN_MATCH - 15)
+
+def lz4_compress_block(data):
+    """greedy LZ4 block compressor, the last match of each 4 bytes key is used"""
+    out = bytearray(0)
+    table = {}
+    anchor = 0
+    pos = 0
+
+    while pos <= len(data) - LZ4_MF_LIMIT:
+        key = bytes(data[pos : pos + LZ4_MIN_MATCH])
+        cand = table.get(key)
+        table[key] = pos
+        if cand == None or pos - cand > LZ4_MAX_OFFSET:
+            pos += 1
+            continue
+
+        length = LZ4_MIN_MATCH
+        max_len = len(data) - LZ4_LAST_LITERALS - pos
+        while length < max_len and data[cand + length] == data[pos + length]:
+            length += 1
+
+        while pos > anchor and cand > 0 and data[pos - 1] == data[cand - 1]:
+            pos -= 1
+            cand -= 1
+            length += 1
+
+        lz4_put_seq(out, data[anchor : pos], pos - cand, length)
+        pos += length
+        anchor = pos
+
+    lz4_put_seq(out, data[anchor : ], 0, 0)
+
+    return out
+
+class delta_src(object):
+    def __init__(self, file_id, data):
+        self.file_id = file_id
+        self.data = data
+        self.crc = zlib.crc32(data, 0) & 0xffffffff
+
+class delta_encoder(object):
+    def __init__(self, srcs, lz4):
+        self.srcs = srcs
+        self.lz4 = lz4
+        self.index = {}
+
+        for i, src in enumerate(srcs):
+            data = src.data
+            for offs in range(0, len(data) - DELTA_KEY_SIZE + 1, DELTA_KEY_ALIGN):
+                key = data[offs : offs + DELTA_KEY_SIZE]
+                if key not in self.index:
+                    self.index[key] = (i, offs)
+
+    def find_match(self, new, pos, start, end, last):
+        """find the source data of new[pos:], prefer the alignment of last match"""
+        cands = []
+        if last != None:
+            cands.append((last[0], pos + last[1]))
+        if end - pos >= DELTA_KEY_SIZE:
+            cand = self.index.get(bytes(new[pos : pos + DELTA_KEY_SIZE]))
+            if cand != None:
+                cands.append(cand)
+
+        best = None
+        for (src, offs) in cands:
+            old = self.srcs[src].data
+            if offs < 0 or offs >= len(old):
+                continue
+
+            # approximate forward extension, code moved by address changes
+            # only differs in a few bytes
+            score = 0
+            best_score = 0
+            length = 0
+            n = min(end - pos, len(old) - offs)
+            for i in range(n):
+                if old[offs + i] == new[pos + i]:
+                    score += 1
+                if score * 2 - (i + 1) > best_score * 2 - length:
+                    best_score = score
+                    length = i + 1
+
+            # exact backward extension over pending literal
+            back = 0
+            while pos - back > start and offs - back > 0 and \
+                  old[offs - back - 1] == new[pos - back - 1]:
+                back += 1
+
+            if best_score + back >= DELTA_MIN_MATCH and \
+               (best == None or best_score + back > best[3]):
+                best = (src, offs - back, pos - back, best_score + back, length + back)
+
+        return best
+
+    def put_lit(self, out, data):
+        if len(data) == 0:
+            return
+
+        if self.lz4 and len(data) >= DELTA_MIN_LZ4:
+            comp = lz4_compress_block(data)
+            clen = bytearray(0)
+            put_varint(clen, len(comp))
+            if len(clen) + len(comp) < len(data):
+                out.append(OTA_DELTA_OP_LZ4)
+                put_varint(out, len(data))
+                out += clen
+                out += comp
+                return
+
+        out.append(OTA_DELTA_OP_LIT)
+        put_varint(out, len(data))
+        out += data
+
+    def put_src(self, out, op, src, offs, length, src_end):
+        out.append(op)
+        put_varint(out, length)
+        put_varint(out, src)
+        put_varint(out, zigzag(offs - src_end[src]))
+        src_end[src] = offs + length
+
+    def put_add(self, out, diff):
+        pos = 0
+        while pos < len(diff):
+            zero_run = 0
+            while pos + zero_run < len(diff) and diff[pos + zero_run] == 0:
+                zero_run += 1
+
+            lit_run = 0
+            zeros = 0
+            while pos + zero_run + lit_run + zeros < len(diff):
+                if diff[pos + zero_run + lit_run + zeros] == 0:
+                    zeros += 1
+                    if zeros >= DELTA_MIN_ZERO_RUN:
+                        break
+                else:
+                    lit_run += zeros + 1
+                    zeros = 0
+
+            put_varint(out, zero_run)
+            put_varint(out, lit_run)
+            out += diff[pos + zero_run : pos + zero_run + lit_run]
+            pos += zero_run + lit_run
+
+    def encode_block(self, new, start, end):
+        out = bytearray(0)
+        src_end = [0] * len(self.srcs)
+        lit_start = start
+        last = None
+        pos = start
+
+        while pos < end:
+            match = self.find_match(new, pos, lit_start, end, last)
+            if match == None:
+                pos += 1
+                continue
+
+            (src, offs, new_offs, score, length) = match
+            self.put_lit(out, new[lit_start : new_offs])
+
+            old = self.srcs[src].data
+            diff = bytearray((new[new_offs + i] - old[offs + i]) & 0xff for i in range(length))
+            if diff.count(0) == length:
+                self.put_src(out, OTA_DELTA_OP_COPY, src, offs, length, src_end)
+            else:
+                self.put_src(out, OTA_DELTA_OP_ADD, src, offs, length, src_end)
+                self.put_add(out, diff)
+
+            last = (src, offs - new_offs)
+            pos = new_offs + length
+            lit_start = pos
+
+        self.put_lit(out, new[lit_start : end])
+
+        # fall back to literal if diff is useless
+        lit = bytearray(0)
+        self.put_lit(lit, new[start : end])
+        if len(out) > len(lit):
+            out = lit
+
+        return out
+
+def generate_ota_delta_image(delta_file, old_ota_file, new_ota_file, src_names, block_size,
+                             lz4, temp_dir):
+    temp_old_ota_dir = os.path.join(temp_dir, 'old_ota_delta')
+
+    extract_ota_bin(old_ota_file, temp_old_ota_dir)
+    partitions = get_ota_partitions(os.path.join(temp_old_ota_dir, 'ota.xml'))
+
+    # old application files are mirrored, they are intact during upgrade
+    if src_names == None or len(src_names) == 0:
+        src_names = [part['file_name'] for part in partitions \
+                     if 'file_name' in part.keys() and part['type'] == 'SYSTEM']
+
+    srcs = []
+    for name in src_names:
+        parts = [part for part in partitions if part.get('file_name') == name]
+        if len(parts) == 0:
+            panic('cannot found source file ' + name)
+
+        with open(os.path.join(temp_old_ota_dir, name), 'rb') as f:
+            srcs.append(delta_src(int(parts[0]['file_id'], 0), f.read()))
+        print('OTA: delta source %s, file_id %d, size 0x%x' \
+              %(name, srcs[-1].file_id, len(srcs[-1].data)))
+
+    if len(srcs) > OTA_DELTA_MAX_SRC:
+        panic('too much delta source files')
+
+    shutil.rmtree(temp_old_ota_dir)
+
+    with open(new_ota_file, 'rb') as f:
+        new = bytearray(f.read())
+
+    encoder = delta_encoder(srcs, lz4)
+
+    block_num = (len(new) + block_size - 1) // block_size
+    index_offs = OTA_DELTA_HEAD_SIZE + len(srcs) * 16
+    data_offs = index_offs + block_num * 8
+
+    index_data = bytearray(0)
+    block_data = bytearray(0)
+    for i in range(block_num):
+        start = i * block_size
+        end = min(start + block_size, len(new))
+        block_data += encoder.encode_block(new, start, end)
+        index_data += struct.pack('<II', data_offs + len(block_data), \
+                                  zlib.crc32(new[start : end], 0) & 0xffffffff)
+
+    src_data = bytearray(0)
+    for src in srcs:
+        src_data += struct.pack('<B3xII4x', src.file_id, len(src.data), src.crc)
+
+    delta_size = data_offs + len(block_data)
+    version = OTA_DELTA_VERSION if lz4 else OTA_DELTA_VERSION_NO_LZ4
+    head_data = struct.pack('<IHHIIIIIB35x', OTA_DELTA_MAGIC, version, \
+                            OTA_DELTA_HEAD_SIZE, len(new), zlib.crc32(new, 0) & 0xffffffff, \
+                            delta_size, block_size, block_num, len(srcs))
+
+    with open(delta_file, 'wb') as f:
+        f.write(head_data)
+        f.write(src_data)
+        f.write(index_data)
+        f.write(block_data)
+
+    print('OTA: delta image 0x%x bytes, full image 0x%x bytes' %(delta_size, len(new)))
+
+def main(argv):
+    parser = argparse.ArgumentParser(
+        description='Build OTA delta firmware',
+    )
+    parser.add_argument('-o', dest = 'old_ota_file', required=True)
+    parser.add_argument('-n', dest = 'new_ota_file', required=True)
+    parser.add_argument('-d', dest = 'delta_ota_file', required=True)
+    parser.add_argument('-s', dest = 'src_files', nargs = '*')
+    parser.add_argument('-b', dest = 'block_size', type = int, default = 4096)
+    # for devices without CONFIG_OTA_BACKEND_DELTA_LZ4
+    parser.add_argument('--no-lz4', dest = 'lz4', action = 'store_false')
+    args = parser.parse_args();
+
+    if (not os.path.isfile(args.old_ota_file)):
+        panic('cannot found file' + args.old_ota_file)
+
+    if (not os.path.isfile(args.new_ota_file)):
+        panic('cannot found file' + args.new_ota_file)
+
+    if args.block_size <= 0 or args.block_size % 512:
+        panic('invalid block size')
+
+    temp_dir = os.path.dirname(os.path.abspath(args.delta_ota_file))
+    generate_ota_delta_image(args.delta_ota_file, args.old_ota_file, args.new_ota_file, \
+                             args.src_files, args.block_size, args.lz4, temp_dir)
+
+if __name__ == '__main__':
+    main(sys.argv[1:])